@@ -0,0 +1,228 @@
+#include "ast.h"
+#include "lexer.h"
+
+/* 初始化AST，按源码长度预估节点数以减少扩容 */
+bool ast_init(Ast *ast, size_t source_length) {
+    ast->count = 0;
+    ast->root = AST_NONE;
+    ast->failed = false;
+    ast->capacity = source_length / 4 + 64;
+    ast->nodes = (AstNode*)malloc(ast->capacity * sizeof(AstNode));
+    if (!ast->nodes) {
+        ast->capacity = 0;
+        ast->failed = true;
+        return false;
+    }
+    return true;
+}
+
+/* 释放AST */
+void ast_free(Ast *ast) {
+    if (ast) {
+        free(ast->nodes);
+        ast->nodes = NULL;
+        ast->count = ast->capacity = 0;
+    }
+}
+
+/* 追加一个没有子节点的节点，返回其下标（内存不足时返回AST_NONE） */
+uint32_t ast_add(Ast *ast, AstKind kind, int op, size_t start, size_t end) {
+    if (ast->count == ast->capacity) {
+        size_t capacity = ast->capacity ? ast->capacity * 2 : 1024;
+        AstNode *nodes = capacity < AST_NONE ?
+            (AstNode*)realloc(ast->nodes, capacity * sizeof(AstNode)) : NULL;
+        if (!nodes) {
+            ast->failed = true;
+            return AST_NONE;
+        }
+        ast->nodes = nodes;
+        ast->capacity = capacity;
+    }
+
+    AstNode *node = &ast->nodes[ast->count];
+    node->kind = (uint8_t)kind;
+    node->op = (uint8_t)op;
+    node->flags = 0;
+    node->start = (uint32_t)start;
+    node->end = (uint32_t)end;
+    node->first_child = AST_NONE;
+    node->next_sibling = AST_NONE;
+    return (uint32_t)ast->count++;
+}
+
+/* 把节点追加到链表末尾 */
+void ast_list_push(Ast *ast, AstList *list, uint32_t node) {
+    if (node == AST_NONE) return;
+
+    if (list->last == AST_NONE) {
+        list->first = node;
+    } else {
+        ast->nodes[list->last].next_sibling = node;
+    }
+    list->last = node;
+}
+
+/* 把另一棵树Program的语句接到本树Program的末尾（用于合并按区域分别解析的结果，
+   other的Program节点必须是最后一个节点）；内存不足时返回false */
+bool ast_append_program(Ast *ast, const Ast *other) {
+    size_t count = other->count - 1;
+    if (ast->count + count > ast->capacity) {
+        size_t capacity = ast->capacity ? ast->capacity : 1024;
+        while (capacity < ast->count + count) capacity *= 2;
+        AstNode *nodes = capacity < AST_NONE ?
+            (AstNode*)realloc(ast->nodes, capacity * sizeof(AstNode)) : NULL;
+        if (!nodes) {
+            ast->failed = true;
+            return false;
+        }
+        ast->nodes = nodes;
+        ast->capacity = capacity;
+    }
+    
+    /* 下标整体平移 */
+    uint32_t base = (uint32_t)ast->count;
+    AstNode *copy = ast->nodes + base;
+    memcpy(copy, other->nodes, count * sizeof(AstNode));
+    for (size_t i = 0; i < count; i++) {
+        if (copy[i].first_child != AST_NONE) copy[i].first_child += base;
+        if (copy[i].next_sibling != AST_NONE) copy[i].next_sibling += base;
+    }
+    ast->count += count;
+    
+    AstNode *program = &ast->nodes[ast->root];
+    const AstNode *tail = &other->nodes[other->root];
+    if (tail->first_child != AST_NONE) {
+        uint32_t first = tail->first_child + base;
+        if (program->first_child == AST_NONE) {
+            program->first_child = first;
+        } else {
+            uint32_t last = program->first_child;
+            while (ast->nodes[last].next_sibling != AST_NONE) {
+                last = ast->nodes[last].next_sibling;
+            }
+            ast->nodes[last].next_sibling = first;
+        }
+    }
+    program->end = tail->end;
+    return true;
+}
+
+/* 把覆盖语法解析出的表达式重新解释为模式（数组/对象字面量、= 默认值、展开） */
+void ast_to_pattern(Ast *ast, uint32_t node) {
+    if (node == AST_NONE) return;
+
+    AstNode *n = &ast->nodes[node];
+    uint32_t child;
+    switch (n->kind) {
+        case AST_ARRAY_EXPRESSION:
+            n->kind = AST_ARRAY_PATTERN;
+            for (child = n->first_child; child != AST_NONE;
+                 child = ast->nodes[child].next_sibling) {
+                ast_to_pattern(ast, child);
+            }
+            break;
+
+        case AST_OBJECT_EXPRESSION:
+            n->kind = AST_OBJECT_PATTERN;
+            for (child = n->first_child; child != AST_NONE;
+                 child = ast->nodes[child].next_sibling) {
+                if (ast->nodes[child].kind == AST_PROPERTY) {
+                    /* 属性值是第二个子节点 */
+                    ast_to_pattern(ast, ast->nodes[ast->nodes[child].first_child].next_sibling);
+                } else {
+                    ast_to_pattern(ast, child);
+                }
+            }
+            break;
+
+        case AST_SPREAD_ELEMENT:
+            n->kind = AST_REST_ELEMENT;
+            ast_to_pattern(ast, n->first_child);
+            break;
+
+        case AST_ASSIGNMENT_EXPRESSION:
+            if (n->op == TOKEN_ASSIGN) {
+                n->kind = AST_ASSIGNMENT_PATTERN;
+                ast_to_pattern(ast, n->first_child);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* 节点类型的ESTree名称 */
+const char* ast_kind_name(AstKind kind) {
+    static const char *names[AST_KIND_COUNT] = {
+        [AST_NULL] = "Null",
+        [AST_PROGRAM] = "Program",
+        [AST_EXPRESSION_STATEMENT] = "ExpressionStatement",
+        [AST_BLOCK_STATEMENT] = "BlockStatement",
+        [AST_EMPTY_STATEMENT] = "EmptyStatement",
+        [AST_VARIABLE_DECLARATION] = "VariableDeclaration",
+        [AST_VARIABLE_DECLARATOR] = "VariableDeclarator",
+        [AST_FUNCTION_DECLARATION] = "FunctionDeclaration",
+        [AST_CLASS_DECLARATION] = "ClassDeclaration",
+        [AST_IF_STATEMENT] = "IfStatement",
+        [AST_WHILE_STATEMENT] = "WhileStatement",
+        [AST_DO_WHILE_STATEMENT] = "DoWhileStatement",
+        [AST_FOR_STATEMENT] = "ForStatement",
+        [AST_FOR_IN_STATEMENT] = "ForInStatement",
+        [AST_FOR_OF_STATEMENT] = "ForOfStatement",
+        [AST_SWITCH_STATEMENT] = "SwitchStatement",
+        [AST_SWITCH_CASE] = "SwitchCase",
+        [AST_RETURN_STATEMENT] = "ReturnStatement",
+        [AST_BREAK_STATEMENT] = "BreakStatement",
+        [AST_CONTINUE_STATEMENT] = "ContinueStatement",
+        [AST_THROW_STATEMENT] = "ThrowStatement",
+        [AST_TRY_STATEMENT] = "TryStatement",
+        [AST_CATCH_CLAUSE] = "CatchClause",
+        [AST_WITH_STATEMENT] = "WithStatement",
+        [AST_DEBUGGER_STATEMENT] = "DebuggerStatement",
+        [AST_IDENTIFIER] = "Identifier",
+        [AST_LITERAL] = "Literal",
+        [AST_TEMPLATE_LITERAL] = "TemplateLiteral",
+        [AST_TEMPLATE_ELEMENT] = "TemplateElement",
+        [AST_THIS_EXPRESSION] = "ThisExpression",
+        [AST_SUPER] = "Super",
+        [AST_ARRAY_EXPRESSION] = "ArrayExpression",
+        [AST_OBJECT_EXPRESSION] = "ObjectExpression",
+        [AST_PROPERTY] = "Property",
+        [AST_FUNCTION_EXPRESSION] = "FunctionExpression",
+        [AST_ARROW_FUNCTION_EXPRESSION] = "ArrowFunctionExpression",
+        [AST_CLASS_BODY] = "ClassBody",
+        [AST_METHOD_DEFINITION] = "MethodDefinition",
+        [AST_PROPERTY_DEFINITION] = "PropertyDefinition",
+        [AST_STATIC_BLOCK] = "StaticBlock",
+        [AST_UNARY_EXPRESSION] = "UnaryExpression",
+        [AST_UPDATE_EXPRESSION] = "UpdateExpression",
+        [AST_BINARY_EXPRESSION] = "BinaryExpression",
+        [AST_LOGICAL_EXPRESSION] = "LogicalExpression",
+        [AST_ASSIGNMENT_EXPRESSION] = "AssignmentExpression",
+        [AST_CONDITIONAL_EXPRESSION] = "ConditionalExpression",
+        [AST_CALL_EXPRESSION] = "CallExpression",
+        [AST_NEW_EXPRESSION] = "NewExpression",
+        [AST_MEMBER_EXPRESSION] = "MemberExpression",
+        [AST_CHAIN_EXPRESSION] = "ChainExpression",
+        [AST_SEQUENCE_EXPRESSION] = "SequenceExpression",
+        [AST_AWAIT_EXPRESSION] = "AwaitExpression",
+        [AST_YIELD_EXPRESSION] = "YieldExpression",
+        [AST_SPREAD_ELEMENT] = "SpreadElement",
+        [AST_ARRAY_PATTERN] = "ArrayPattern",
+        [AST_OBJECT_PATTERN] = "ObjectPattern",
+        [AST_ASSIGNMENT_PATTERN] = "AssignmentPattern",
+        [AST_REST_ELEMENT] = "RestElement",
+        [AST_IMPORT_DECLARATION] = "ImportDeclaration",
+        [AST_IMPORT_SPECIFIER] = "ImportSpecifier",
+        [AST_IMPORT_DEFAULT_SPECIFIER] = "ImportDefaultSpecifier",
+        [AST_IMPORT_NAMESPACE_SPECIFIER] = "ImportNamespaceSpecifier",
+        [AST_EXPORT_NAMED_DECLARATION] = "ExportNamedDeclaration",
+        [AST_EXPORT_SPECIFIER] = "ExportSpecifier",
+        [AST_EXPORT_DEFAULT_DECLARATION] = "ExportDefaultDeclaration",
+        [AST_EXPORT_ALL_DECLARATION] = "ExportAllDeclaration",
+        [AST_IMPORT_EXPRESSION] = "ImportExpression",
+        [AST_META_PROPERTY] = "MetaProperty",
+    };
+    return (kind < AST_KIND_COUNT && names[kind]) ? names[kind] : "Unknown";
+}
@@ -0,0 +1,169 @@
+#ifndef AST_H
+#define AST_H
+
+#include "common.h"
+
+#define AST_NONE UINT32_MAX
+
+/* 节点类型（与ESTree节点类型一一对应，AST_NULL表示缺省的子节点或数组空位） */
+typedef enum {
+    AST_NULL,
+    AST_PROGRAM,
+
+    /* 语句与声明 */
+    AST_EXPRESSION_STATEMENT,
+    AST_BLOCK_STATEMENT,
+    AST_EMPTY_STATEMENT,
+    AST_VARIABLE_DECLARATION,
+    AST_VARIABLE_DECLARATOR,
+    AST_FUNCTION_DECLARATION,
+    AST_CLASS_DECLARATION,
+    AST_IF_STATEMENT,
+    AST_WHILE_STATEMENT,
+    AST_DO_WHILE_STATEMENT,
+    AST_FOR_STATEMENT,
+    AST_FOR_IN_STATEMENT,
+    AST_FOR_OF_STATEMENT,
+    AST_SWITCH_STATEMENT,
+    AST_SWITCH_CASE,
+    AST_RETURN_STATEMENT,
+    AST_BREAK_STATEMENT,
+    AST_CONTINUE_STATEMENT,
+    AST_THROW_STATEMENT,
+    AST_TRY_STATEMENT,
+    AST_CATCH_CLAUSE,
+    AST_WITH_STATEMENT,
+    AST_DEBUGGER_STATEMENT,
+
+    /* 表达式 */
+    AST_IDENTIFIER,
+    AST_LITERAL,
+    AST_TEMPLATE_LITERAL,
+    AST_TEMPLATE_ELEMENT,
+    AST_THIS_EXPRESSION,
+    AST_SUPER,
+    AST_ARRAY_EXPRESSION,
+    AST_OBJECT_EXPRESSION,
+    AST_PROPERTY,
+    AST_FUNCTION_EXPRESSION,
+    AST_ARROW_FUNCTION_EXPRESSION,
+    AST_CLASS_BODY,
+    AST_METHOD_DEFINITION,
+    AST_PROPERTY_DEFINITION,
+    AST_STATIC_BLOCK,
+    AST_UNARY_EXPRESSION,
+    AST_UPDATE_EXPRESSION,
+    AST_BINARY_EXPRESSION,
+    AST_LOGICAL_EXPRESSION,
+    AST_ASSIGNMENT_EXPRESSION,
+    AST_CONDITIONAL_EXPRESSION,
+    AST_CALL_EXPRESSION,
+    AST_NEW_EXPRESSION,
+    AST_MEMBER_EXPRESSION,
+    AST_CHAIN_EXPRESSION,
+    AST_SEQUENCE_EXPRESSION,
+    AST_AWAIT_EXPRESSION,
+    AST_YIELD_EXPRESSION,
+    AST_SPREAD_ELEMENT,
+
+    /* 模式 */
+    AST_ARRAY_PATTERN,
+    AST_OBJECT_PATTERN,
+    AST_ASSIGNMENT_PATTERN,
+    AST_REST_ELEMENT,
+
+    /* 模块 */
+    AST_IMPORT_DECLARATION,
+    AST_IMPORT_SPECIFIER,
+    AST_IMPORT_DEFAULT_SPECIFIER,
+    AST_IMPORT_NAMESPACE_SPECIFIER,
+    AST_EXPORT_NAMED_DECLARATION,
+    AST_EXPORT_SPECIFIER,
+    AST_EXPORT_DEFAULT_DECLARATION,
+    AST_EXPORT_ALL_DECLARATION,
+    AST_IMPORT_EXPRESSION,
+    AST_META_PROPERTY,
+
+    AST_KIND_COUNT
+} AstKind;
+
+/* 节点标志 */
+#define AST_FLAG_COMPUTED     0x01  /* 计算属性名或 a[b] */
+#define AST_FLAG_OPTIONAL     0x02  /* 可选链 a?.b / a?.() */
+#define AST_FLAG_PREFIX       0x04  /* 前缀 ++/-- */
+#define AST_FLAG_SHORTHAND    0x08  /* 简写属性 {a} */
+#define AST_FLAG_METHOD       0x10  /* 方法属性 {m() {}} */
+#define AST_FLAG_STATIC       0x20  /* 静态类成员 */
+#define AST_FLAG_EXPRESSION   0x40  /* 箭头函数体是表达式 */
+#define AST_FLAG_GETTER       0x80  /* get访问器 */
+#define AST_FLAG_SETTER       0x100 /* set访问器 */
+#define AST_FLAG_CONSTRUCTOR  0x200 /* 类的constructor方法 */
+#define AST_FLAG_TAIL         0x400 /* 模板字符串的最后一段 */
+#define AST_FLAG_MODULE       0x800 /* Program按模块解析 */
+#define AST_FLAG_ASYNC        0x1000 /* async函数，或for await */
+#define AST_FLAG_GENERATOR    0x2000 /* 生成器函数 function* */
+#define AST_FLAG_DELEGATE     0x4000 /* yield* */
+
+/*
+ * 扁平AST节点：子节点按固定顺序通过first_child/next_sibling串联，
+ * 可选子节点缺省时用AST_NULL节点占位。各类型的子节点顺序：
+ *   Program / BlockStatement / StaticBlock / ClassBody / SequenceExpression: 列表
+ *   VariableDeclaration(op=var/let/const): declarator列表
+ *   VariableDeclarator: id, init?
+ *   Function*: id?, params..., body      ArrowFunction: params..., body
+ *   ClassDeclaration: id, superClass?, ClassBody
+ *   MethodDefinition / PropertyDefinition / Property: key, value?
+ *   If / Conditional: test, consequent, alternate?
+ *   While: test, body      DoWhile: body, test
+ *   For: init?, test?, update?, body      ForIn / ForOf: left, right, body
+ *   Switch: discriminant, cases...      SwitchCase: test?, consequent...
+ *   Return / Throw / Break / Continue: argument? / label?
+ *   Try: block, handler?, finalizer?      CatchClause: param?, body
+ *   With: object, body      Debugger: 无子节点
+ *   TemplateLiteral: quasi, expression, quasi, ..., quasi
+ *   Array* / Object*: 元素或属性列表
+ *   Unary / Update / Spread / Rest / Chain / Await / ExpressionStatement: 单个子节点
+ *   Yield: argument?
+ *   Binary / Logical / Assignment* / Member: 两个子节点
+ *   Call / New: callee, arguments...
+ *   ImportDeclaration: source, specifiers...      ImportSpecifier: imported, local
+ *   ImportDefaultSpecifier / ImportNamespaceSpecifier: local
+ *   ExportNamedDeclaration: declaration?, source?, specifiers...      ExportSpecifier: local, exported
+ *   ExportDefaultDeclaration: declaration      ExportAllDeclaration: exported?, source
+ *   ImportExpression: source, options?      MetaProperty: meta, property
+ */
+typedef struct {
+    uint8_t kind;           /* AstKind */
+    uint8_t op;             /* 运算符或声明关键字的TokenType */
+    uint16_t flags;         /* AST_FLAG_* */
+    uint32_t start;         /* 源码起始偏移 */
+    uint32_t end;           /* 源码结束偏移 */
+    uint32_t first_child;
+    uint32_t next_sibling;
+} AstNode;
+
+/* 节点数组（节点之间用下标引用，扩容时不失效） */
+typedef struct {
+    AstNode *nodes;
+    size_t count;
+    size_t capacity;
+    uint32_t root;
+    bool failed;            /* 构建过程中内存不足 */
+} Ast;
+
+/* 按顺序追加的子节点链表 */
+typedef struct {
+    uint32_t first;
+    uint32_t last;
+} AstList;
+
+/* AST函数声明 */
+bool ast_init(Ast *ast, size_t source_length);
+void ast_free(Ast *ast);
+uint32_t ast_add(Ast *ast, AstKind kind, int op, size_t start, size_t end);
+void ast_list_push(Ast *ast, AstList *list, uint32_t node);
+void ast_to_pattern(Ast *ast, uint32_t node);
+bool ast_append_program(Ast *ast, const Ast *other);
+const char* ast_kind_name(AstKind kind);
+
+#endif /* AST_H */
@@ -0,0 +1,185 @@
+#define _POSIX_C_SOURCE 200809L
+#include "ast_binary.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+_Static_assert(sizeof(AstBinaryHeader) == 64, "AstBinaryHeader must be 64 bytes");
+
+#ifndef _WIN32
+/* 用writev写出全部分段（通常一次系统调用完成，部分写入时继续写剩余部分） */
+static bool write_all(int fd, struct iovec *parts, int count) {
+    while (count > 0) {
+        ssize_t written = writev(fd, parts, count);
+        if (written < 0) {
+            return false;
+        }
+        while (count > 0 && (size_t)written >= parts->iov_len) {
+            written -= (ssize_t)parts->iov_len;
+            parts++;
+            count--;
+        }
+        if (count > 0) {
+            parts->iov_base = (char*)parts->iov_base + written;
+            parts->iov_len -= (size_t)written;
+        }
+    }
+    return true;
+}
+#endif
+
+/* 把AST和源码写成二进制AST文件（path为NULL或"-"时写到标准输出） */
+bool ast_binary_write(const Ast *ast, const char *source, size_t length, const char *path) {
+    if (!ast || ast->failed || ast->root == AST_NONE) {
+        return false;
+    }
+
+    size_t nodes_size = ast->count * sizeof(AstNode);
+    AstBinaryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, AST_BINARY_MAGIC, 4);
+    header.version = AST_BINARY_VERSION;
+    header.byte_order = AST_BINARY_BYTE_ORDER;
+    header.node_size = sizeof(AstNode);
+    header.node_count = (uint32_t)ast->count;
+    header.root = ast->root;
+    header.nodes_offset = sizeof(header);
+    header.source_offset = header.nodes_offset + nodes_size;
+    header.source_length = length;
+    header.file_size = header.source_offset + length;
+
+    bool to_stdout = !path || strcmp(path, "-") == 0;
+
+#ifdef _WIN32
+    FILE *file = to_stdout ? stdout : fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot open output file '%s'\n", path);
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(ast->nodes, 1, nodes_size, file) == nodes_size &&
+              fwrite(source, 1, length, file) == length;
+    if (to_stdout) {
+        ok = fflush(file) == 0 && ok;
+    } else {
+        ok = fclose(file) == 0 && ok;
+    }
+#else
+    int fd = to_stdout ? STDOUT_FILENO : open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Cannot open output file '%s'\n", path);
+        return false;
+    }
+    struct iovec parts[3] = {
+        {&header, sizeof(header)},
+        {ast->nodes, nodes_size},
+        {(void*)source, length},
+    };
+    bool ok = write_all(fd, parts, 3);
+    if (!to_stdout) {
+        ok = close(fd) == 0 && ok;
+    }
+#endif
+
+    if (!ok) {
+        fprintf(stderr, "Error: Cannot write output\n");
+    }
+    return ok;
+}
+
+/* 加载二进制AST：只检查文件头和各段范围，节点直接使用映射的内存 */
+bool ast_binary_load(AstBinary *binary, const char *path) {
+    memset(binary, 0, sizeof(*binary));
+
+    binary->data = file_map(path, &binary->size, &binary->mapped);
+    if (!binary->data) {
+        fprintf(stderr, "Error: Cannot open file '%s'\n", path);
+        return false;
+    }
+
+    const AstBinaryHeader *header = (const AstBinaryHeader*)binary->data;
+    bool valid = binary->size >= sizeof(AstBinaryHeader) &&
+                 memcmp(header->magic, AST_BINARY_MAGIC, 4) == 0;
+    if (valid && (header->version != AST_BINARY_VERSION ||
+                  header->byte_order != AST_BINARY_BYTE_ORDER ||
+                  header->node_size != sizeof(AstNode))) {
+        fprintf(stderr, "Error: '%s' was written by an incompatible version\n", path);
+        ast_binary_close(binary);
+        return false;
+    }
+    valid = valid &&
+            header->file_size == binary->size &&
+            header->nodes_offset % sizeof(uint32_t) == 0 &&
+            header->nodes_offset >= sizeof(AstBinaryHeader) &&
+            header->nodes_offset + (uint64_t)header->node_count * sizeof(AstNode) <=
+                header->source_offset &&
+            header->source_offset <= binary->size &&
+            header->source_length <= binary->size - header->source_offset &&
+            header->root < header->node_count;
+    if (!valid) {
+        fprintf(stderr, "Error: '%s' is not a valid binary AST\n", path);
+        ast_binary_close(binary);
+        return false;
+    }
+
+    binary->ast.nodes = (AstNode*)((char*)binary->data + header->nodes_offset);
+    binary->ast.count = header->node_count;
+    binary->ast.capacity = header->node_count;
+    binary->ast.root = header->root;
+    binary->ast.failed = false;
+    binary->source = (const char*)binary->data + header->source_offset;
+    binary->source_length = (size_t)header->source_length;
+    return true;
+}
+
+/* 检查所有节点的类型、下标和源码范围，并确认从根节点出发是一棵树（用于不可信的输入） */
+bool ast_binary_verify(const AstBinary *binary) {
+    const AstNode *nodes = binary->ast.nodes;
+    size_t count = binary->ast.count;
+
+    for (size_t i = 0; i < count; i++) {
+        const AstNode *n = &nodes[i];
+        if (n->kind >= AST_KIND_COUNT ||
+            n->start > n->end || n->end > binary->source_length ||
+            (n->first_child != AST_NONE && n->first_child >= count) ||
+            (n->next_sibling != AST_NONE && n->next_sibling >= count)) {
+            return false;
+        }
+    }
+
+    /* 每个节点最多被访问一次，否则存在共享或环，遍历时会重复或不终止 */
+    uint8_t *visited = (uint8_t*)calloc(count, 1);
+    uint32_t *stack = (uint32_t*)malloc((2 * count + 1) * sizeof(uint32_t));
+    bool ok = visited && stack;
+    size_t depth = 0;
+    if (ok) {
+        stack[depth++] = binary->ast.root;
+    }
+    while (ok && depth > 0) {
+        uint32_t index = stack[--depth];
+        if (visited[index]) {
+            ok = false;
+            break;
+        }
+        visited[index] = 1;
+        if (nodes[index].next_sibling != AST_NONE) {
+            stack[depth++] = nodes[index].next_sibling;
+        }
+        if (nodes[index].first_child != AST_NONE) {
+            stack[depth++] = nodes[index].first_child;
+        }
+    }
+    free(visited);
+    free(stack);
+    return ok;
+}
+
+/* 释放加载的二进制AST */
+void ast_binary_close(AstBinary *binary) {
+    if (!binary || !binary->data) return;
+
+    file_unmap(binary->data, binary->size, binary->mapped);
+    memset(binary, 0, sizeof(*binary));
+}
@@ -0,0 +1,48 @@
+#ifndef AST_BINARY_H
+#define AST_BINARY_H
+
+#include "ast.h"
+#include "common.h"
+
+#define AST_BINARY_MAGIC "JSAB"
+#define AST_BINARY_VERSION 3
+#define AST_BINARY_BYTE_ORDER 0x01020304u
+
+/*
+ * 二进制AST文件格式（可直接mmap使用，不需要反序列化）：
+ *   [AstBinaryHeader][AstNode * node_count][源码 source_length 字节]
+ * 节点与内存中的AstNode完全相同，子节点/兄弟节点用下标而不是指针引用；
+ * 标识符名、字面量等字符串都是节点的 [start, end) 在源码段中的范围，源码段即字符串表。
+ * 各段的偏移都相对于文件开头，按写入机器的字节序存储（byte_order用于检查）。
+ */
+typedef struct {
+    char magic[4];              /* "JSAB" */
+    uint32_t version;           /* AST_BINARY_VERSION */
+    uint32_t byte_order;        /* AST_BINARY_BYTE_ORDER */
+    uint32_t node_size;         /* sizeof(AstNode) */
+    uint32_t node_count;
+    uint32_t root;
+    uint64_t nodes_offset;
+    uint64_t source_offset;
+    uint64_t source_length;
+    uint64_t file_size;
+    uint8_t reserved[8];
+} AstBinaryHeader;
+
+/* 已加载的二进制AST：ast.nodes和source直接指向映射的文件内容（只读） */
+typedef struct {
+    Ast ast;                    /* 只读视图，不能调用ast_add/ast_free */
+    const char *source;
+    size_t source_length;
+    void *data;                 /* 整个文件 */
+    size_t size;
+    bool mapped;                /* data来自mmap（否则为malloc） */
+} AstBinary;
+
+/* 二进制AST函数声明 */
+bool ast_binary_write(const Ast *ast, const char *source, size_t length, const char *path);
+bool ast_binary_load(AstBinary *binary, const char *path);
+bool ast_binary_verify(const AstBinary *binary);
+void ast_binary_close(AstBinary *binary);
+
+#endif /* AST_BINARY_H */
@@ -0,0 +1,174 @@
+#include "atom.h"
+#include <pthread.h>
+
+#define ATOM_BLOCK_SIZE (64u << 10)     /* 文本区每块的大小，更长的文本单独分配一块 */
+
+/* 一个原子 */
+typedef struct {
+    const char *text;
+    uint32_t length;
+    uint32_t hash;
+    uint8_t keyword;                    /* TokenType，非关键字为TOKEN_IDENTIFIER */
+} AtomEntry;
+
+/* 一个分片：条目分页存放（页只增不移，读取无需加锁），开放寻址表存片内序号+1 */
+typedef struct {
+    pthread_mutex_t lock;
+    AtomEntry *pages[ATOM_MAX_PAGES];
+    uint32_t count;
+    uint32_t *slots;
+    size_t capacity;
+    Arena text;
+} AtomShard;
+
+struct AtomTable {
+    AtomShard shards[ATOM_SHARDS];
+};
+
+/* 片内序号所在的页和页内下标：第k页从ATOM_PAGE(2^k-1)开始，长ATOM_PAGE*2^k */
+static uint32_t atom_page(uint32_t index, uint32_t *offset) {
+    uint32_t scaled = (index >> ATOM_PAGE_BITS) + 1;
+    uint32_t page = 31 - (uint32_t)__builtin_clz(scaled);
+    *offset = index - (((1u << page) - 1) << ATOM_PAGE_BITS);
+    return page;
+}
+
+static AtomEntry* atom_entry(const AtomTable *table, uint32_t atom) {
+    const AtomShard *shard = &table->shards[atom & (ATOM_SHARDS - 1)];
+    uint32_t offset;
+    uint32_t page = atom_page(atom >> ATOM_SHARD_BITS, &offset);
+    return &shard->pages[page][offset];
+}
+
+/* 查找表的一项（片内序号+1）的哈希值 */
+static uint32_t slot_hash(const void *slot, const void *context) {
+    const AtomShard *shard = (const AtomShard*)context;
+    uint32_t offset;
+    uint32_t page = atom_page(*(const uint32_t*)slot - 1, &offset);
+    return shard->pages[page][offset].hash >> ATOM_SHARD_BITS;
+}
+
+/* 查找或插入（调用者持有分片的锁） */
+static uint32_t shard_intern(AtomShard *shard, uint32_t shard_index, uint32_t hash,
+                             const char *text, size_t length, TokenType keyword) {
+    if (!hash_table_reserve((void**)&shard->slots, &shard->capacity, shard->count, sizeof(uint32_t),
+                            64, slot_hash, shard)) {
+        return ATOM_NONE;
+    }
+
+    size_t i = (hash >> ATOM_SHARD_BITS) & (shard->capacity - 1);
+    while (shard->slots[i]) {
+        uint32_t offset;
+        uint32_t page = atom_page(shard->slots[i] - 1, &offset);
+        const AtomEntry *entry = &shard->pages[page][offset];
+        if (entry->hash == hash && entry->length == length &&
+            memcmp(entry->text, text, length) == 0) {
+            return ((shard->slots[i] - 1) << ATOM_SHARD_BITS) | shard_index;
+        }
+        i = (i + 1) & (shard->capacity - 1);
+    }
+
+    uint32_t index = shard->count;
+    uint32_t offset;
+    uint32_t page = atom_page(index, &offset);
+    if (page >= ATOM_MAX_PAGES || length > UINT32_MAX) return ATOM_NONE;
+    if (!shard->pages[page]) {
+        shard->pages[page] = (AtomEntry*)malloc(((size_t)1 << (ATOM_PAGE_BITS + page)) *
+                                                sizeof(AtomEntry));
+        if (!shard->pages[page]) return ATOM_NONE;
+    }
+
+    const char *copy = arena_store(&shard->text, text, length);
+    if (!copy) return ATOM_NONE;
+
+    AtomEntry *entry = &shard->pages[page][offset];
+    entry->text = copy;
+    entry->length = (uint32_t)length;
+    entry->hash = hash;
+    entry->keyword = (uint8_t)keyword;
+    shard->slots[i] = index + 1;
+    shard->count++;
+    return (index << ATOM_SHARD_BITS) | shard_index;
+}
+
+static uint32_t table_intern(AtomTable *table, const char *text, size_t length,
+                             TokenType keyword) {
+    uint32_t hash = hash_text(text, length);
+    uint32_t shard_index = hash & (ATOM_SHARDS - 1);
+    AtomShard *shard = &table->shards[shard_index];
+
+    pthread_mutex_lock(&shard->lock);
+    uint32_t atom = shard_intern(shard, shard_index, hash, text, length, keyword);
+    pthread_mutex_unlock(&shard->lock);
+    return atom;
+}
+
+/* 创建原子表并放入全部关键字 */
+AtomTable* atom_table_create(void) {
+    AtomTable *table = (AtomTable*)calloc(1, sizeof(AtomTable));
+    if (!table) return NULL;
+
+    for (uint32_t i = 0; i < ATOM_SHARDS; i++) {
+        pthread_mutex_init(&table->shards[i].lock, NULL);
+        arena_init(&table->shards[i].text, ATOM_BLOCK_SIZE);
+    }
+
+    TokenType type;
+    const char *word;
+    for (size_t i = 0; (word = keyword_at(i, &type)) != NULL; i++) {
+        if (table_intern(table, word, strlen(word), type) == ATOM_NONE) {
+            atom_table_destroy(table);
+            return NULL;
+        }
+    }
+    return table;
+}
+
+void atom_table_destroy(AtomTable *table) {
+    if (!table) return;
+
+    for (uint32_t i = 0; i < ATOM_SHARDS; i++) {
+        AtomShard *shard = &table->shards[i];
+        for (int page = 0; page < ATOM_MAX_PAGES; page++) {
+            free(shard->pages[page]);
+        }
+        free(shard->slots);
+        arena_free(&shard->text);
+        pthread_mutex_destroy(&shard->lock);
+    }
+    free(table);
+}
+
+uint32_t atom_intern(AtomTable *table, const char *text, size_t length) {
+    return table_intern(table, text, length, TOKEN_IDENTIFIER);
+}
+
+const char* atom_text(const AtomTable *table, uint32_t atom, size_t *length) {
+    const AtomEntry *entry = atom_entry(table, atom);
+    if (length) *length = entry->length;
+    return entry->text;
+}
+
+TokenType atom_keyword(const AtomTable *table, uint32_t atom) {
+    return (TokenType)atom_entry(table, atom)->keyword;
+}
+
+size_t atom_table_count(AtomTable *table) {
+    size_t count = 0;
+    for (uint32_t i = 0; i < ATOM_SHARDS; i++) {
+        pthread_mutex_lock(&table->shards[i].lock);
+        count += table->shards[i].count;
+        pthread_mutex_unlock(&table->shards[i].lock);
+    }
+    return count;
+}
+
+size_t atom_table_bytes(AtomTable *table) {
+    size_t bytes = 0;
+    for (uint32_t i = 0; i < ATOM_SHARDS; i++) {
+        pthread_mutex_lock(&table->shards[i].lock);
+        bytes += table->shards[i].text.bytes;
+        pthread_mutex_unlock(&table->shards[i].lock);
+    }
+    return bytes;
+}
@@ -0,0 +1,40 @@
+#ifndef ATOM_H
+#define ATOM_H
+
+#include "lexer.h"
+
+#define ATOM_SHARD_BITS 6
+#define ATOM_SHARDS (1u << ATOM_SHARD_BITS)    /* 分片数：每片一把锁 */
+#define ATOM_PAGE_BITS 8                       /* 第0页的条目数为2^ATOM_PAGE_BITS，之后逐页翻倍 */
+#define ATOM_MAX_PAGES 18                      /* 每片最多约6700万个原子 */
+
+/*
+ * 原子表：把每个不同的标识符（或字符串字面量的源码文本）映射为一个32位编号，
+ * 同名即同号，后续各遍只需比较整数。文本只存一份（带'\0'），地址在表销毁前
+ * 不会移动，token的value可以直接借用。
+ *
+ * 多个线程可以共享一张表：按哈希分成ATOM_SHARDS片，插入和查找只锁一片；
+ * 已得到的编号用atom_text等读取时不加锁。创建时预先放入全部关键字，
+ * atom_keyword直接给出关键字的token类型，词法分析器不再逐个比较关键字表。
+ *
+ * 编号 = (片内序号 << ATOM_SHARD_BITS) | 片号。
+ */
+
+/* 原子表函数 */
+AtomTable* atom_table_create(void);
+void atom_table_destroy(AtomTable *table);
+
+/* 返回文本的原子编号（不存在时插入），内存不足返回ATOM_NONE */
+uint32_t atom_intern(AtomTable *table, const char *text, size_t length);
+
+/* 原子的文本（以'\0'结尾）和长度 */
+const char* atom_text(const AtomTable *table, uint32_t atom, size_t *length);
+
+/* 关键字原子返回对应的token类型，其他原子返回TOKEN_IDENTIFIER */
+TokenType atom_keyword(const AtomTable *table, uint32_t atom);
+
+/* 统计：原子个数和文本占用的字节数（含'\0'） */
+size_t atom_table_count(AtomTable *table);
+size_t atom_table_bytes(AtomTable *table);
+
+#endif /* ATOM_H */
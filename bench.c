@@ -0,0 +1,2174 @@
+#define _POSIX_C_SOURCE 200809L
+#include "parser.h"
+#include "parallel.h"
+#include "threadpool.h"
+#include "parallel_lexer.h"
+#include "structural.h"
+#include "incremental.h"
+#include "estree.h"
+#include "ast_binary.h"
+#include "token_stream.h"
+#include "minify.h"
+#include "sourcemap.h"
+#include "module_scan.h"
+#include "module_graph.h"
+#include "treeshake.h"
+#include "bundle.h"
+#include "format.h"
+#include "scope.h"
+#include "atom.h"
+#include "ident_index.h"
+#include "lint.h"
+#include "highlight.h"
+#include "lsp.h"
+#include "fold.h"
+#include "cooked.h"
+#include "numeric.h"
+#include "regexp.h"
+#include <time.h>
+#include <sys/stat.h>
+
+/*
+ * 性能基准程序
+ * 用法: js_bench [case] [args...]
+ * 不带参数时运行全部基准。
+ */
+
+/* 单调时钟（秒） */
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* 可增长的字符缓冲 */
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} BenchBuffer;
+
+static void buffer_append(BenchBuffer *buf, const char *text, size_t len) {
+    if (buf->length + len + 1 > buf->capacity) {
+        size_t capacity = buf->capacity ? buf->capacity * 2 : 4096;
+        while (capacity < buf->length + len + 1) capacity *= 2;
+        buf->data = (char*)realloc(buf->data, capacity);
+        if (!buf->data) {
+            fprintf(stderr, "Error: Out of memory\n");
+            exit(1);
+        }
+        buf->capacity = capacity;
+    }
+    memcpy(buf->data + buf->length, text, len);
+    buf->length += len;
+    buf->data[buf->length] = '\0';
+}
+
+/* 生成约size字节、由大量顶层函数组成的合成bundle */
+static char* generate_bundle(size_t size, size_t *length) {
+    BenchBuffer buf = {0};
+    char chunk[1024];
+
+    for (unsigned i = 0; buf.length < size; i++) {
+        int n = snprintf(chunk, sizeof(chunk),
+            "function module_%u(exports, require) {\n"
+            "    var name = \"module_%u\", re = /[a-z]+\\/%u/g;\n"
+            "    let table = { id: %u, items: [1, 2, 3], label: 'x' + name };\n"
+            "    for (let i = 0; i < table.items.length; i++) {\n"
+            "        if (re.test(name) && i %% 2 === 0) { table.id += i / 2; }\n"
+            "    }\n"
+            "    return `done ${name}`\n"
+            "}\n"
+            "const value_%u = module_%u({}, null);\n",
+            i, i, i, i, i, i);
+        buffer_append(&buf, chunk, (size_t)n);
+    }
+
+    *length = buf.length;
+    return buf.data;
+}
+
+/* 基准：串行解析 vs 1..N线程的区域并行解析 */
+static void bench_parallel(int argc, char **argv) {
+    size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 50;
+    int max_threads = argc > 1 ? atoi(argv[1]) : threadpool_cpu_count();
+    if (max_threads < 1) max_threads = 1;
+
+    size_t length;
+    char *source = generate_bundle(size_mb << 20, &length);
+    double mb = length / (1024.0 * 1024.0);
+
+    printf("[parallel] input: %.1f MB, cores: %d\n", mb, threadpool_cpu_count());
+
+    ErrorInfo error = {0};
+    Position origin = {1, 1, 0};
+    double start = now_seconds();
+    bool ok = parse_source_range(source, 0, length, origin, false, NULL, &error);
+    double serial = now_seconds() - start;
+    printf("  serial      %8.3f s  %8.1f MB/s  %s\n", serial, mb / serial,
+           ok ? "ok" : "FAILED");
+
+    for (int threads = 1; threads <= max_threads;
+         threads = (threads < max_threads && threads * 2 > max_threads) ?
+                   max_threads : threads * 2) {
+        ErrorInfo perr = {0};
+        start = now_seconds();
+        ok = parallel_parse(source, length, threads, false, NULL, &perr);
+        double elapsed = now_seconds() - start;
+        printf("  -j %-8d %8.3f s  %8.1f MB/s  speedup %.2fx  %s\n",
+               threads, elapsed, mb / elapsed, serial / elapsed,
+               ok ? "ok" : "FAILED");
+        if (threads == max_threads) break;
+    }
+
+    free(source);
+}
+
+/* 比较两个token序列是否完全一致 */
+static bool token_arrays_equal(const TokenArray *a, const TokenArray *b) {
+    if (a->count != b->count) return false;
+    for (size_t i = 0; i < a->count; i++) {
+        const Token *x = a->tokens[i];
+        const Token *y = b->tokens[i];
+        if (x->type != y->type || x->length != y->length ||
+            x->preceded_by_newline != y->preceded_by_newline ||
+            x->start.offset != y->start.offset || x->start.line != y->start.line ||
+            x->start.column != y->start.column || x->end.line != y->end.line ||
+            x->end.column != y->end.column ||
+            (x->value && memcmp(x->value, y->value, x->length) != 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* 把合成bundle压成一行，模拟压缩后的代码 */
+static void flatten_lines(char *source, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (source[i] == '\n') source[i] = ';';
+    }
+}
+
+/* 基准：单行大文件的推测式并行词法分析 vs 串行词法分析 */
+static void bench_lex(int argc, char **argv) {
+    size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 50;
+    int max_threads = argc > 1 ? atoi(argv[1]) : threadpool_cpu_count();
+    if (max_threads < 1) max_threads = 1;
+
+    size_t length;
+    char *source = generate_bundle(size_mb << 20, &length);
+    flatten_lines(source, length);
+    double mb = length / (1024.0 * 1024.0);
+
+    printf("[lex] single-line input: %.1f MB, cores: %d\n", mb, threadpool_cpu_count());
+
+    TokenArray serial_tokens = {0};
+    ErrorInfo error = {0};
+    double start = now_seconds();
+    bool ok = lexer_tokenize(source, length, &serial_tokens, &error);
+    double serial = now_seconds() - start;
+    printf("  serial      %8.3f s  %8.1f MB/s  %zu tokens  %s\n", serial, mb / serial,
+           serial_tokens.count, ok ? "ok" : "FAILED");
+
+    for (int threads = 1; threads <= max_threads;
+         threads = (threads < max_threads && threads * 2 > max_threads) ?
+                   max_threads : threads * 2) {
+        TokenArray tokens = {0};
+        ErrorInfo perr = {0};
+        start = now_seconds();
+        ok = parallel_tokenize(source, length, threads, &tokens, &perr);
+        double elapsed = now_seconds() - start;
+        printf("  -j %-8d %8.3f s  %8.1f MB/s  speedup %.2fx  %s\n",
+               threads, elapsed, mb / elapsed, serial / elapsed,
+               ok && token_arrays_equal(&serial_tokens, &tokens) ?
+               "identical" : "MISMATCH");
+        token_array_free(&tokens);
+        if (threads == max_threads) break;
+    }
+
+    token_array_free(&serial_tokens);
+    free(source);
+}
+
+/* 字符串基准的一次词法分析 */
+typedef struct {
+    size_t strings;         /* 字符串token数 */
+    size_t zero_copy;       /* 值直接指向源码的 */
+    size_t decoded;         /* 解码的（含转义） */
+    size_t copy_bytes;      /* 每个值单独拷贝时要分配的字节数（含'\0'） */
+    bool ok;
+} StringsRun;
+
+static double run_strings(const char *source, size_t length, CookedStrings *strings, StringsRun *run) {
+    ErrorInfo error = {0};
+    memset(run, 0, sizeof(*run));
+    Lexer *lexer = lexer_create(source, length, &error);
+    if (!lexer) return 0;
+    lexer->strings = strings;
+
+    double start = now_seconds();
+    for (;;) {
+        Token *token = lexer_next_token(lexer);
+        if (!token) break;
+        if (token->type == TOKEN_EOF) {
+            token_destroy(token);
+            run->ok = true;
+            break;
+        }
+        if (token->type == TOKEN_STRING) {
+            run->strings++;
+            if (token->cooked >= source && token->cooked < source + length) {
+                run->zero_copy++;
+            } else if (token->cooked) {
+                run->decoded++;
+            }
+            run->copy_bytes += token->cooked_length + 1;
+        }
+        token_destroy(token);
+    }
+    double elapsed = now_seconds() - start;
+    lexer_destroy(lexer);
+    return elapsed;
+}
+
+/* 基准：只做词法分析 vs 同时得到字符串字面量的值（无转义的零拷贝，含转义的解码去重） */
+static void bench_strings(int argc, char **argv) {
+    size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 20;
+
+    /* 在bundle之间穿插字符串密集的代码：多数不含转义，少数含各种转义且反复出现 */
+    static const char *const escaped[] = {
+        "\"line one\\nline two\"", "'it\\'s'", "\"\\u00e9t\\u00e9\"", "\"\\u{1F600} smile\"",
+        "\"\\uD83D\\uDE00\"", "\"tab\\tseparated\\tvalues\"", "\"\\x41\\x42\\x43\"",
+        "\"long \\\n continued\""
+    };
+    size_t generated_length;
+    char *generated = generate_bundle(size_mb << 20, &generated_length);
+    BenchBuffer buf = {NULL, 0, 0};
+    char line[256];
+    size_t offset = 0;
+    for (size_t i = 0; offset < generated_length; i++) {
+        size_t end = offset + (4u << 10) < generated_length ? offset + (4u << 10) : generated_length;
+        while (end < generated_length && generated[end - 1] != '\n') end++;
+        buffer_append(&buf, generated + offset, end - offset);
+        offset = end;
+        for (int k = 0; k < 16; k++) {
+            int n = k % 8 == 7 ? snprintf(line, sizeof(line), "messages.push(%s);\n", escaped[(i + k) % 8])
+                               : snprintf(line, sizeof(line),
+                                          "messages.push(\"entry %zu of the message catalogue, no escapes here\");\n",
+                                          i * 16 + k);
+            buffer_append(&buf, line, (size_t)n);
+        }
+    }
+    free(generated);
+    double mb = buf.length / (1024.0 * 1024.0);
+
+    printf("[strings] input: %.1f MB\n", mb);
+
+    StringsRun raw, cooked;
+    double lex = run_strings(buf.data, buf.length, NULL, &raw);
+    printf("  lex         %8.3f s  %8.1f MB/s  %zu strings  %s\n", lex, mb / lex, raw.strings,
+           raw.ok ? "ok" : "FAILED");
+
+    CookedStrings *strings = cooked_strings_create();
+    double with = strings ? run_strings(buf.data, buf.length, strings, &cooked) : 0;
+    bool ok = strings && cooked.ok && !cooked_strings_failed(strings) && cooked.strings == raw.strings &&
+              cooked.zero_copy + cooked.decoded == cooked.strings;
+    printf("  + values    %8.3f s  %8.1f MB/s  %s  (+%.1f%% over lex)\n", with, mb / with,
+           ok ? "ok" : "FAILED", 100.0 * (with - lex) / lex);
+    if (strings) {
+        printf("  zero-copy   %zu (%.1f%%), decoded %zu -> %zu unique\n", cooked.zero_copy,
+               100.0 * cooked.zero_copy / (cooked.strings ? cooked.strings : 1), cooked.decoded,
+               cooked_strings_count(strings));
+        printf("  storage     %.1f KB  (%.1f MB if every value were copied)\n",
+               cooked_strings_bytes(strings) / 1024.0, cooked.copy_bytes / (1024.0 * 1024.0));
+    }
+
+    cooked_strings_destroy(strings);
+    free(buf.data);
+}
+
+/* 数字基准之前的做法：去掉分隔符后用strtod/strtoull换算 */
+static double strtod_number(const char *text, size_t length) {
+    char buffer[64];
+    size_t count = 0;
+    for (size_t i = 0; i < length && count + 1 < sizeof(buffer); i++) {
+        if (text[i] != '_') buffer[count++] = text[i];
+    }
+    buffer[count] = '\0';
+    if (count > 2 && buffer[0] == '0' && strchr("oObB", buffer[1])) {
+        return (double)strtoull(buffer + 2, NULL, (buffer[1] == 'o' || buffer[1] == 'O') ? 8 : 2);
+    }
+    if (count > 1 && buffer[0] == '0' && isdigit((unsigned char)buffer[1])) {
+        return (double)strtoull(buffer, NULL, 8);
+    }
+    return strtod(buffer, NULL);
+}
+
+/* 基准：数字密集的数据文件（坐标、测量值、整数、十六进制颜色、带分隔符的常量、BigInt），
+   词法分析时得到值 vs 事后逐个用strtod换算 */
+static void bench_numbers(int argc, char **argv) {
+    size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 20;
+
+    BenchBuffer buf = {NULL, 0, 0};
+    char line[512];
+    unsigned seed = 2024;
+    const char *header = "export const samples = [\n";
+    buffer_append(&buf, header, strlen(header));
+    for (size_t row = 0; buf.length < (size_mb << 20); row++) {
+        unsigned r[8];
+        for (int k = 0; k < 8; k++) {
+            seed = seed * 1103515245u + 12345u;
+            r[k] = seed >> 4;
+        }
+        double lat = (r[0] % 180000000) / 1e6 - 90, lng = (r[1] % 360000000) / 1e6 - 180;
+        double reading = (double)r[2] / (double)r[3] * 1000.0;
+        int n = snprintf(line, sizeof(line),
+                         "  {id: %zu, at: [%.6f, %.6f], value: %.17g, scale: %.3e, color: 0x%06X, "
+                         "budget: %u_%03u_%03u, mask: 0b%u%u%u%u, ts: %lluN, flags: [%u, %u, %u]},\n",
+                         row, lat, lng, reading, reading * 1e-9, r[4] & 0xFFFFFF,
+                         r[5] % 999 + 1, r[6] % 1000, r[7] % 1000, r[0] & 1, r[1] & 1, r[2] & 1, r[3] & 1,
+                         1600000000000ULL + r[4], r[5] % 10, r[6] % 100, r[7] % 1000);
+        char *bigint = strstr(line, "N,");
+        *bigint = 'n';
+        buffer_append(&buf, line, (size_t)n);
+    }
+    buffer_append(&buf, "];\n", 3);
+    double mb = buf.length / (1024.0 * 1024.0);
+
+    printf("[numbers] input: %.1f MB\n", mb);
+
+    /* 词法分析（同时算出值），记下每个数字字面量的位置和值 */
+    size_t capacity = 1 << 16, count = 0, bigints = 0;
+    uint32_t *spans = (uint32_t*)malloc(capacity * 2 * sizeof(uint32_t));
+    double *values = (double*)malloc(capacity * sizeof(double));
+    ErrorInfo error = {0};
+    Lexer *lexer = lexer_create(buf.data, buf.length, &error);
+    bool ok = lexer && spans && values;
+    double start = now_seconds();
+    while (ok) {
+        Token *token = lexer_next_token(lexer);
+        if (!token) {
+            ok = false;
+            break;
+        }
+        bool done = token->type == TOKEN_EOF;
+        if (token->type == TOKEN_NUMBER) {
+            if (count == capacity) {
+                capacity *= 2;
+                spans = (uint32_t*)realloc(spans, capacity * 2 * sizeof(uint32_t));
+                values = (double*)realloc(values, capacity * sizeof(double));
+                if (!spans || !values) {
+                    fprintf(stderr, "Error: Out of memory\n");
+                    exit(1);
+                }
+            }
+            spans[2 * count] = (uint32_t)token->start.offset;
+            spans[2 * count + 1] = (uint32_t)(token->end.offset - token->start.offset);
+            values[count++] = token->number;
+        }
+        token_destroy(token);
+        if (done) break;
+    }
+    double lex = now_seconds() - start;
+    lexer_destroy(lexer);
+    printf("  lex+values  %8.3f s  %8.1f MB/s  %zu numeric literals  %s\n", lex, mb / lex, count,
+           ok ? "ok" : "FAILED");
+
+    /* 只比较换算：numeric_value vs strtod（BigInt除外），结果须逐位相同 */
+    size_t mismatches = 0;
+    double sum_fast = 0, sum_strtod = 0;
+    start = now_seconds();
+    for (size_t i = 0; i < count; i++) {
+        NumericLiteral literal;
+        if (!numeric_value(buf.data + spans[2 * i], spans[2 * i + 1], &literal)) mismatches++;
+        sum_fast += literal.value;
+        if (memcmp(&literal.value, &values[i], sizeof(double)) != 0) mismatches++;
+    }
+    double fast = now_seconds() - start;
+
+    start = now_seconds();
+    for (size_t i = 0; i < count; i++) {
+        const char *text = buf.data + spans[2 * i];
+        size_t length = spans[2 * i + 1];
+        if (text[length - 1] == 'n') {
+            bigints++;
+            sum_strtod += values[i];
+            continue;
+        }
+        double value = strtod_number(text, length);
+        sum_strtod += value;
+        if (memcmp(&value, &values[i], sizeof(double)) != 0) mismatches++;
+    }
+    double slow = now_seconds() - start;
+    printf("  numeric     %8.3f s  %8.1f ns/literal\n", fast, fast * 1e9 / (count ? count : 1));
+    printf("  strtod      %8.3f s  %8.1f ns/literal  speedup %.2fx  %s\n", slow,
+           slow * 1e9 / (count ? count : 1), slow / fast,
+           mismatches == 0 && sum_fast == sum_strtod ? "identical" : "MISMATCH");
+
+    /* BigInt的精确十进制值 */
+    NumericBigInt bigint;
+    numeric_bigint_init(&bigint);
+    size_t digits = 0;
+    start = now_seconds();
+    for (size_t i = 0; i < count; i++) {
+        const char *text = buf.data + spans[2 * i];
+        size_t length = spans[2 * i + 1];
+        size_t decimal_length;
+        if (text[length - 1] != 'n') continue;
+        if (!numeric_bigint_parse(&bigint, text, length) ||
+            !numeric_bigint_decimal(&bigint, &decimal_length) || decimal_length + 1 != length) {
+            mismatches++;
+        }
+        digits += decimal_length;
+    }
+    double exact = now_seconds() - start;
+    printf("  bigint      %8.3f s  %zu literals, %zu digits  %s\n", exact, bigints, digits,
+           mismatches == 0 ? "ok" : "MISMATCH");
+
+    numeric_bigint_free(&bigint);
+    free(spans);
+    free(values);
+    free(buf.data);
+}
+
+/* 正则基准的一次词法分析：regexps为NULL时词法分析器自己建缓存 */
+static double run_regex(const char *source, size_t length, RegexpCache *regexps,
+                        uint32_t **spans, size_t *count, bool *ok) {
+    ErrorInfo error = {0};
+    size_t capacity = 0;
+    *count = 0;
+    *ok = false;
+    Lexer *lexer = lexer_create(source, length, &error);
+    if (!lexer) return 0;
+    lexer->regexps = regexps;
+
+    double start = now_seconds();
+    for (;;) {
+        Token *token = lexer_next_token(lexer);
+        if (!token) {
+            fprintf(stderr, "  %d:%d: %s\n", error.position.line, error.position.column, error.message);
+            break;
+        }
+        bool done = token->type == TOKEN_EOF;
+        if (token->type == TOKEN_REGEX && spans) {
+            if (*count == capacity) {
+                capacity = capacity ? capacity * 2 : 1 << 14;
+                *spans = (uint32_t*)realloc(*spans, capacity * 2 * sizeof(uint32_t));
+                if (!*spans) {
+                    fprintf(stderr, "Error: Out of memory\n");
+                    exit(1);
+                }
+            }
+            (*spans)[2 * *count] = (uint32_t)token->start.offset;
+            (*spans)[2 * *count + 1] = (uint32_t)(token->end.offset - token->start.offset);
+            (*count)++;
+        }
+        token_destroy(token);
+        if (done) {
+            *ok = true;
+            break;
+        }
+    }
+    double elapsed = now_seconds() - start;
+    lexer_destroy(lexer);
+    return elapsed;
+}
+
+/* 基准：正则密集的代码（常见的校验、解析、替换用正则反复出现，另有少量各不相同的），
+   检查每个正则的代价：第一次分析 vs 缓存命中；另外核对一组合法和不合法的字面量 */
+static void bench_regex(int argc, char **argv) {
+    size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 20;
+
+    static const char *const common[] = {
+        "/^[\\w.+-]+@[\\w-]+\\.[\\w.-]+$/i",
+        "/^(?:https?:\\/\\/)?(?:[\\w-]+\\.)+[a-z]{2,}(?:\\/[^\\s?#]*)?(?:\\?[^\\s#]*)?$/i",
+        "/(\\d{4})-(\\d{2})-(\\d{2})T(\\d{2}):(\\d{2})/",
+        "/(?<year>\\d{4})-(?<month>\\d{2})-(?<day>\\d{2})/u",
+        "/\\s+/g",
+        "/^\\s+|\\s+$/g",
+        "/[&<>\"']/g",
+        "/^#?([a-f\\d]{2})([a-f\\d]{2})([a-f\\d]{2})$/i",
+        "/\\p{Lu}\\p{Ll}+/gu",
+        "/[\\p{L}--\\p{Script=Latin}]/v",
+        "/(?<=\\$)\\d+(\\.\\d\\d)?/",
+        "/^(?!.*\\.\\.)[a-z0-9._]{3,16}$/",
+        "/\\b(?:0x[\\da-f]+|\\d+(?:\\.\\d+)?(?:e[+-]?\\d+)?)\\b/gi",
+        "/[\\u4e00-\\u9fff]+/g",
+        "/([\"'])(?:\\\\.|(?!\\1)[^\\\\\\n])*\\1/g",
+        "/^\\/api\\/v(\\d+)\\/users\\/(\\w+)$/",
+        "/\\{\\{\\s*([\\w.]+)\\s*\\}\\}/g",
+        "/^([01]?\\d|2[0-3]):[0-5]\\d$/"
+    };
+    size_t common_count = sizeof(common) / sizeof(common[0]);
+    size_t generated_length;
+    char *generated = generate_bundle(size_mb << 20, &generated_length);
+    BenchBuffer buf = {NULL, 0, 0};
+    char line[256];
+    size_t offset = 0;
+    for (size_t i = 0; offset < generated_length; i++) {
+        size_t end = offset + (4u << 10) < generated_length ? offset + (4u << 10) : generated_length;
+        while (end < generated_length && generated[end - 1] != '\n') end++;
+        buffer_append(&buf, generated + offset, end - offset);
+        offset = end;
+        for (int k = 0; k < 16; k++) {
+            int n = k % 8 == 7 ? snprintf(line, sizeof(line), "m = s.match(/^item-%zu-(\\d+)$/);\n", i * 2 + k / 8)
+                               : snprintf(line, sizeof(line), "m = s.match(%s);\n",
+                                          common[(i * 16 + k) % common_count]);
+            buffer_append(&buf, line, (size_t)n);
+        }
+    }
+    free(generated);
+    double mb = buf.length / (1024.0 * 1024.0);
+
+    /* 词法分析：各自的缓存（冷） vs 已经装满的共享缓存（检查只剩一次查表） */
+    uint32_t *spans = NULL;
+    size_t count = 0, warm_count = 0;
+    bool ok, warm_ok;
+    double lex = run_regex(buf.data, buf.length, NULL, &spans, &count, &ok);
+    RegexpCache *shared = regexp_cache_create();
+    run_regex(buf.data, buf.length, shared, NULL, &warm_count, &warm_ok);
+    double warm = run_regex(buf.data, buf.length, shared, NULL, &warm_count, &warm_ok);
+    regexp_cache_destroy(shared);
+    printf("[regex] input: %.1f MB, %zu regex literals\n", mb, count);
+    printf("  lex+check   %8.3f s  %8.1f MB/s  %s\n", lex, mb / lex, ok ? "ok" : "FAILED");
+    printf("  warm cache  %8.3f s  %8.1f MB/s  %s\n", warm, mb / warm, warm_ok ? "ok" : "FAILED");
+
+    /* 每个正则的代价：第一遍（未命中的要完整分析）和第二遍（全部命中） */
+    RegexpCache *cache = regexp_cache_create();
+    size_t failures = 0;
+    const RegexpProgram *program;
+    RegexpError failure;
+    double start = now_seconds();
+    for (size_t i = 0; cache && i < count; i++) {
+        if (!regexp_compile(cache, buf.data + spans[2 * i], spans[2 * i + 1], &program, &failure)) failures++;
+    }
+    double first = now_seconds() - start;
+    size_t misses = cache ? regexp_cache_count(cache) : 0;
+    start = now_seconds();
+    for (size_t i = 0; cache && i < count; i++) {
+        if (!regexp_compile(cache, buf.data + spans[2 * i], spans[2 * i + 1], &program, &failure)) failures++;
+    }
+    double second = now_seconds() - start;
+    double hit_ns = second * 1e9 / (count ? count : 1);
+    double miss_ns = (first * 1e9 - hit_ns * (double)(count - misses)) / (misses ? misses : 1);
+    printf("  compile     %8.1f ns/pattern (miss)  %6.1f ns/literal (hit)  %zu distinct, hit rate %.1f%%\n",
+           miss_ns, hit_ns, misses, 100.0 * (double)(count - misses) / (count ? count : 1));
+    printf("  uncached    %8.3f s (est.)  vs  %.3f s cached  %s\n", miss_ns * (double)count * 1e-9, first,
+           failures == 0 ? "ok" : "FAILED");
+    if (cache) {
+        printf("  storage     %.1f KB  (%.0f bytes/pattern incl. text)\n", regexp_cache_bytes(cache) / 1024.0,
+               (double)regexp_cache_bytes(cache) / (misses ? misses : 1));
+    }
+    regexp_cache_destroy(cache);
+
+    free(spans);
+    free(buf.data);
+}
+
+/* 原子表基准中的一个文件：工作线程独立分析，共享同一张原子表 */
+typedef struct {
+    const char *source;
+    size_t length;
+    AtomTable *atoms;       /* NULL为逐个拷贝value */
+    size_t tokens;
+    size_t names;           /* 标识符、关键字和字符串token数 */
+    size_t value_bytes;     /* 这些token的value拷贝占用的字节数（含'\0'） */
+    uint32_t sample;        /* 要统计出现次数的名字的原子 */
+    size_t sample_hits;
+    bool ok;
+} AtomJob;
+
+static void atom_job_run(void *arg) {
+    AtomJob *job = (AtomJob*)arg;
+    ErrorInfo error = {0};
+    Lexer *lexer = lexer_create(job->source, job->length, &error);
+    if (!lexer) return;
+    lexer->atoms = job->atoms;
+
+    for (;;) {
+        Token *token = lexer_next_token(lexer);
+        if (!token) break;
+        if (token->type == TOKEN_EOF) {
+            token_destroy(token);
+            job->ok = true;
+            break;
+        }
+        job->tokens++;
+        if (token->type == TOKEN_STRING || token->type == TOKEN_IDENTIFIER ||
+            (token->type >= TOKEN_BREAK && token->type <= TOKEN_SET)) {
+            job->names++;
+            job->value_bytes += token->length + 1;
+        }
+        /* 有原子表时同名比较只是整数比较 */
+        if (token->atom != ATOM_NONE && token->atom == job->sample) job->sample_hits++;
+        token_destroy(token);
+    }
+    lexer_destroy(lexer);
+}
+
+/* 把源码在"\nfunction "处切成count个文件，多线程分析；返回耗时 */
+static double run_atom_jobs(const char *source, size_t length, int threads, AtomJob *jobs,
+                            size_t count, AtomTable *atoms, uint32_t sample) {
+    size_t begin = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t end = i + 1 == count ? length : length / count * (i + 1);
+        while (end < length && strncmp(source + end, "\nfunction ", 10) != 0) end++;
+        if (end < begin) end = begin;
+        memset(&jobs[i], 0, sizeof(AtomJob));
+        jobs[i].source = source + begin;
+        jobs[i].length = end - begin;
+        jobs[i].atoms = atoms;
+        jobs[i].sample = sample;
+        begin = end;
+    }
+
+    ThreadPool *pool = threadpool_create(threads);
+    if (!pool) return 0;
+    double start = now_seconds();
+    for (size_t i = 0; i < count; i++) {
+        threadpool_submit(pool, atom_job_run, &jobs[i]);
+    }
+    threadpool_wait(pool);
+    double elapsed = now_seconds() - start;
+    threadpool_destroy(pool);
+    return elapsed;
+}
+
+/* 基准：批量分析时逐个拷贝value vs 驻留到多线程共享的原子表 */
+static void bench_atoms(int argc, char **argv) {
+    size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 50;
+    int threads = argc > 1 ? atoi(argv[1]) : threadpool_cpu_count();
+    if (threads < 1) threads = 1;
+    size_t count = (size_t)threads * 16;
+
+    size_t length;
+    char *source = generate_bundle(size_mb << 20, &length);
+    double mb = length / (1024.0 * 1024.0);
+    AtomJob *jobs = (AtomJob*)malloc(count * sizeof(AtomJob));
+    if (!jobs) {
+        fprintf(stderr, "Error: Out of memory\n");
+        free(source);
+        return;
+    }
+
+    printf("[atoms] input: %.1f MB in %zu files, threads: %d\n", mb, count, threads);
+
+    double copy = run_atom_jobs(source, length, threads, jobs, count, NULL, ATOM_NONE);
+    size_t tokens = 0, names = 0, bytes = 0;
+    bool ok = true;
+    for (size_t i = 0; i < count; i++) {
+        tokens += jobs[i].tokens;
+        names += jobs[i].names;
+        bytes += jobs[i].value_bytes;
+        ok = ok && jobs[i].ok;
+    }
+    printf("  copy        %8.3f s  %8.1f MB/s  %zu tokens  %s\n", copy, mb / copy, tokens,
+           ok ? "ok" : "FAILED");
+
+    AtomTable *atoms = atom_table_create();
+    if (!atoms) {
+        fprintf(stderr, "Error: Out of memory\n");
+        free(jobs);
+        free(source);
+        return;
+    }
+    uint32_t sample = atom_intern(atoms, "name", 4);
+    double interned = run_atom_jobs(source, length, threads, jobs, count, atoms, sample);
+    size_t atom_tokens = 0, hits = 0;
+    ok = true;
+    for (size_t i = 0; i < count; i++) {
+        atom_tokens += jobs[i].tokens;
+        hits += jobs[i].sample_hits;
+        ok = ok && jobs[i].ok;
+    }
+    printf("  atoms       %8.3f s  %8.1f MB/s  %zu tokens  speedup %.2fx  %s\n", interned,
+           mb / interned, atom_tokens, copy / interned,
+           ok && atom_tokens == tokens ? "ok" : "MISMATCH");
+
+    size_t distinct = atom_table_count(atoms);
+    size_t text = atom_table_bytes(atoms);
+    printf("  %zu names -> %zu atoms, text %.1f MB -> %.1f MB (%.1f%%); '%s' seen %zu times\n",
+           names, distinct, bytes / (1024.0 * 1024.0), text / (1024.0 * 1024.0),
+           bytes ? 100.0 * text / bytes : 0.0, atom_text(atoms, sample, NULL), hits);
+
+    atom_table_destroy(atoms);
+    free(jobs);
+    free(source);
+}
+
+/* 基准：结构索引的快速括号检查 vs 完整解析（完整文件与截断文件） */
+static void bench_structural(int argc, char **argv) {
+    size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 50;
+
+    size_t length;
+    char *source = generate_bundle(size_mb << 20, &length);
+    /* 截断在函数体中间，模拟上传不完整的文件 */
+    size_t truncated = length / 2;
+    while (truncated > 0 && source[truncated] != '{') truncated--;
+    truncated++;
+
+    printf("[structural] input: %.1f MB\n", length / (1024.0 * 1024.0));
+
+    struct {
+        const char *name;
+        size_t length;
+    } inputs[] = {{"complete", length}, {"truncated", truncated}};
+
+    for (int i = 0; i < 2; i++) {
+        double mb = inputs[i].length / (1024.0 * 1024.0);
+        ErrorInfo error = {0};
+        double start = now_seconds();
+        bool balanced = structural_check(source, inputs[i].length, &error);
+        double check = now_seconds() - start;
+
+        StructuralIndex index;
+        start = now_seconds();
+        bool built = structural_index_build(&index, source, inputs[i].length);
+        double build = now_seconds() - start;
+
+        ErrorInfo perr = {0};
+        Position origin = {1, 1, 0};
+        start = now_seconds();
+        bool parsed = parse_source_range(source, 0, inputs[i].length, origin, false, NULL, &perr);
+        double parse = now_seconds() - start;
+
+        printf("  %-10s check %8.3f s  %8.1f MB/s  %s\n", inputs[i].name, check,
+               mb / check, balanced ? "balanced" : "rejected");
+        printf("  %-10s index %8.3f s  %8.1f MB/s  %zu brackets%s\n", "", build,
+               mb / build, built ? index.count : 0,
+               built && index.exact ? "" : " (inexact)");
+        printf("  %-10s parse %8.3f s  %8.1f MB/s  %s  (check is %.1fx faster)\n", "",
+               parse, mb / parse, parsed ? "ok" : "FAILED", parse / check);
+        if (built) structural_index_free(&index);
+    }
+
+    free(source);
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+/* 基准：5MB文件中单字符编辑的增量重新解析延迟 */
+static void bench_incremental(int argc, char **argv) {
+    size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 5;
+    int edits = argc > 1 ? atoi(argv[1]) : 1000;
+    if (edits < 1) edits = 1;
+
+    size_t length;
+    char *source = generate_bundle(size_mb << 20, &length);
+    double mb = length / (1024.0 * 1024.0);
+
+    double start = now_seconds();
+    IncrementalDocument *doc = incremental_create(source, length, false);
+    double full = now_seconds() - start;
+    if (!doc) {
+        fprintf(stderr, "Error: Out of memory\n");
+        free(source);
+        return;
+    }
+    printf("[incremental] input: %.1f MB, %zu statements, full parse %.3f ms  %s\n",
+           mb, doc->statements.count, full * 1e3, doc->valid ? "ok" : "FAILED");
+
+    /* 收集所有 "i % 2" 中数字的位置，随机修改其中一个 */
+    size_t *sites = NULL;
+    size_t site_count = 0;
+    for (const char *p = doc->source; (p = strstr(p, "i % 2")) != NULL; p++) {
+        if (site_count % 1024 == 0) {
+            sites = (size_t*)realloc(sites, (site_count + 1024) * sizeof(size_t));
+        }
+        sites[site_count++] = (size_t)(p - doc->source) + 4;
+    }
+
+    double *latency = (double*)malloc((size_t)edits * sizeof(double));
+    int full_reparses = 0;
+    int failures = 0;
+    size_t reparsed = 0;
+    unsigned seed = 12345;
+
+    for (int i = 0; i < edits && site_count > 0; i++) {
+        seed = seed * 1103515245u + 12345u;
+        size_t site = sites[(seed >> 8) % site_count];
+        char digit = (char)('1' + (doc->source[site] - '0') % 9);
+        TextEdit edit = {site, 1, &digit, 1};
+
+        start = now_seconds();
+        bool ok = incremental_apply(doc, &edit, 1);
+        latency[i] = now_seconds() - start;
+
+        if (!ok) failures++;
+        if (doc->full_reparse) full_reparses++;
+        reparsed += doc->reparsed_end - doc->reparsed_start;
+    }
+
+    if (site_count > 0) {
+        qsort(latency, (size_t)edits, sizeof(double), compare_double);
+        printf("  %d single-char edits: median %.1f us  p99 %.1f us  max %.1f us\n",
+               edits, latency[edits / 2] * 1e6, latency[edits * 99 / 100] * 1e6,
+               latency[edits - 1] * 1e6);
+        printf("  avg reparsed %.0f bytes, full reparses %d, failures %d, "
+               "speedup vs full %.0fx\n", (double)reparsed / edits, full_reparses,
+               failures, full / latency[edits / 2]);
+    }
+
+    free(latency);
+    free(sites);
+    incremental_destroy(doc);
+    free(source);
+}
+
+/* 追加带引号的JSON字符串 */
+static void buffer_append_json(BenchBuffer *buf, const char *text, size_t length) {
+    size_t run = 0;
+    buffer_append(buf, "\"", 1);
+    for (size_t i = 0; i < length; i++) {
+        unsigned char ch = (unsigned char)text[i];
+        if (ch >= 0x20 && ch != '"' && ch != '\\') continue;
+
+        char escape[8];
+        int n = ch == '"' ? snprintf(escape, sizeof(escape), "\\\"") :
+                ch == '\\' ? snprintf(escape, sizeof(escape), "\\\\") :
+                ch == '\n' ? snprintf(escape, sizeof(escape), "\\n") :
+                snprintf(escape, sizeof(escape), "\\u%04x", ch);
+        buffer_append(buf, text + run, i - run);
+        buffer_append(buf, escape, (size_t)n);
+        run = i + 1;
+    }
+    buffer_append(buf, text + run, length - run);
+    buffer_append(buf, "\"", 1);
+}
+
+/* 追加一条分帧的LSP消息（与 js_parser --lsp --record 录制的格式相同） */
+static void append_lsp_message(BenchBuffer *session, const BenchBuffer *body) {
+    char header[64];
+    int n = snprintf(header, sizeof(header), "Content-Length: %zu\r\n\r\n", body->length);
+    buffer_append(session, header, (size_t)n);
+    buffer_append(session, body->data, body->length);
+}
+
+/* 合成编辑会话：打开一个bundle，在随机选中的return语句前逐字符输入一条语句
+   再逐字符删掉，输入过程中文本大多处于语法错误状态 */
+static char* generate_lsp_session(size_t size, int keystrokes, size_t *length) {
+    static const char uri[] = "file:///bench/bundle.js";
+    static const char typed[] = "if (table.id > 3) { name = name.slice(1); }\n    ";
+    BenchBuffer session = {0};
+    BenchBuffer body = {0};
+    char chunk[512];
+
+    size_t source_length;
+    char *source = generate_bundle(size, &source_length);
+    size_t lines = 0;
+    for (size_t i = 0; i < source_length; i++) lines += source[i] == '\n';
+
+    const char *start = "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"initialize\",\"params\":{\"capabilities\":{}}}";
+    buffer_append(&body, start, strlen(start));
+    append_lsp_message(&session, &body);
+    body.length = 0;
+    const char *initialized = "{\"jsonrpc\":\"2.0\",\"method\":\"initialized\",\"params\":{}}";
+    buffer_append(&body, initialized, strlen(initialized));
+    append_lsp_message(&session, &body);
+
+    body.length = 0;
+    int n = snprintf(chunk, sizeof(chunk), "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didOpen\","
+                     "\"params\":{\"textDocument\":{\"uri\":\"%s\",\"languageId\":\"javascript\","
+                     "\"version\":1,\"text\":", uri);
+    buffer_append(&body, chunk, (size_t)n);
+    buffer_append_json(&body, source, source_length);
+    buffer_append(&body, "}}}", 3);
+    append_lsp_message(&session, &body);
+
+    /* 每个函数9行，return语句在第7行（从0开始为第6行），缩进4列 */
+    size_t typed_length = strlen(typed);
+    unsigned seed = 4242;
+    int version = 1;
+    size_t line = 6;
+    size_t column = 4;
+    for (int k = 0; k < keystrokes; k++) {
+        size_t step = (size_t)k % (2 * typed_length);
+        if (step == 0) {
+            seed = seed * 1103515245u + 12345u;
+            line = 9 * ((seed >> 8) % (lines / 9)) + 6;
+            column = 4;
+        }
+
+        /* 前一半逐字符输入（遇到换行转到下一行），后一半逐字符删除 */
+        size_t end_line = line;
+        size_t end_column = column;
+        char text[8] = "";
+        if (step < typed_length) {
+            if (typed[step] == '\n') {
+                snprintf(text, sizeof(text), "\\n");
+            } else {
+                text[0] = typed[step];
+                text[1] = '\0';
+            }
+        } else if (column > 0) {
+            column--;
+        } else {
+            line--;
+            column = 4 + strlen("if (table.id > 3) { name = name.slice(1); }");
+            end_column = 0;
+        }
+
+        body.length = 0;
+        n = snprintf(chunk, sizeof(chunk), "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didChange\","
+                     "\"params\":{\"textDocument\":{\"uri\":\"%s\",\"version\":%d},\"contentChanges\":"
+                     "[{\"range\":{\"start\":{\"line\":%zu,\"character\":%zu},"
+                     "\"end\":{\"line\":%zu,\"character\":%zu}},\"text\":\"%s\"}]}}",
+                     uri, ++version, line, column, end_line, end_column, text);
+        buffer_append(&body, chunk, (size_t)n);
+        append_lsp_message(&session, &body);
+
+        if (step < typed_length) {
+            if (typed[step] == '\n') {
+                line++;
+                column = 0;
+            } else {
+                column++;
+            }
+        }
+    }
+
+    const char *finish[] = {
+        "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"shutdown\"}",
+        "{\"jsonrpc\":\"2.0\",\"method\":\"exit\"}"
+    };
+    for (int i = 0; i < 2; i++) {
+        body.length = 0;
+        buffer_append(&body, finish[i], strlen(finish[i]));
+        append_lsp_message(&session, &body);
+    }
+
+    free(body.data);
+    free(source);
+    *length = session.length;
+    return session.data;
+}
+
+/* 打开的文档与整体解析的结果是否一致 */
+static bool lsp_documents_match(const LspServer *server) {
+    for (size_t i = 0; i < server->document_count; i++) {
+        const IncrementalDocument *doc = server->documents[i].doc;
+        IncrementalDocument *fresh = incremental_create(doc->source, doc->length, doc->module);
+        bool same = fresh && fresh->valid == doc->valid &&
+                    (doc->valid || (fresh->error.code == doc->error.code &&
+                                    fresh->error.position.offset == doc->error.position.offset &&
+                                    fresh->error.position.line == doc->error.position.line &&
+                                    fresh->error.position.column == doc->error.position.column &&
+                                    strcmp(fresh->error.message, doc->error.message) == 0));
+        incremental_destroy(fresh);
+        if (!same) return false;
+    }
+    return true;
+}
+
+/* 基准：回放LSP编辑会话（录制的文件，或合成的逐字符输入），统计每次didChange的延迟 */
+static void bench_lsp(int argc, char **argv) {
+    struct stat st;
+    size_t length = 0;
+    char *session = NULL;
+    const char *label = "generated";
+
+    if (argc > 0 && stat(argv[0], &st) == 0 && S_ISREG(st.st_mode)) {
+        FILE *file = fopen(argv[0], "rb");
+        session = file ? (char*)malloc((size_t)st.st_size + 1) : NULL;
+        if (session) length = fread(session, 1, (size_t)st.st_size, file);
+        if (file) fclose(file);
+        if (!session) {
+            fprintf(stderr, "Error: Cannot read session '%s'\n", argv[0]);
+            return;
+        }
+        label = argv[0];
+    } else {
+        size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 5;
+        int keystrokes = argc > 1 ? atoi(argv[1]) : 2000;
+        session = generate_lsp_session(size_mb << 20, keystrokes, &length);
+    }
+
+    Writer out;
+    LspServer server;
+    if (!writer_init(&out, NULL) || !lsp_server_init(&server, &out)) {
+        fprintf(stderr, "Error: Out of memory\n");
+        free(session);
+        return;
+    }
+
+    /* 每64条消息与整体解析比较一次（比较不计入延迟） */
+    size_t offset = 0;
+    size_t messages = 0;
+    size_t checks = 0;
+    bool match = true;
+    const char *message;
+    size_t message_length;
+    double start = now_seconds();
+    while (!server.exited && lsp_next_message(session, length, &offset, &message, &message_length)) {
+        lsp_handle(&server, message, message_length);
+        if (++messages % 64 == 0) {
+            match = match && lsp_documents_match(&server);
+            checks++;
+        }
+    }
+    match = match && lsp_documents_match(&server);
+    double total = now_seconds() - start;
+
+    size_t document_bytes = 0;
+    for (size_t i = 0; i < server.document_count; i++) {
+        document_bytes += server.documents[i].doc->length;
+    }
+    printf("[lsp] session: %s, %zu messages, %.1f MB open, replay %.3f s (%zu checks)\n",
+           label, messages, document_bytes / (1024.0 * 1024.0), total, checks + 1);
+    lsp_histogram_print(&server.latency, "didChange", stdout);
+
+    size_t changes = (size_t)server.latency.count;
+    printf("  full reparses %zu, avg reparsed %.0f bytes, %zu bytes of responses  %s\n",
+           server.full_reparses, changes ? (double)server.reparsed_bytes / changes : 0.0,
+           (size_t)(out.total + out.length), match ? "ok" : "MISMATCH");
+
+    lsp_server_free(&server);
+    writer_close(&out);
+    free(session);
+}
+
+/* 基准：只做语法验证的解析 vs 构建AST并输出ESTree JSON（输出丢弃，只计字节数） */
+static void bench_estree(int argc, char **argv) {
+    size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 50;
+
+    size_t length;
+    char *source = generate_bundle(size_mb << 20, &length);
+    double mb = length / (1024.0 * 1024.0);
+
+    printf("[estree] input: %.1f MB\n", mb);
+
+    ErrorInfo error = {0};
+    Position origin = {1, 1, 0};
+    double start = now_seconds();
+    bool ok = parse_source_range(source, 0, length, origin, false, NULL, &error);
+    double validate = now_seconds() - start;
+    printf("  validate    %8.3f s  %8.1f MB/s  %s\n", validate, mb / validate,
+           ok ? "ok" : "FAILED");
+
+    Ast ast;
+    Writer writer;
+    ErrorInfo eerr = {0};
+    if (!ast_init(&ast, length) || !writer_init(&writer, NULL)) {
+        fprintf(stderr, "Error: Out of memory\n");
+        ast_free(&ast);
+        free(source);
+        return;
+    }
+
+    start = now_seconds();
+    Lexer *lexer = lexer_create(source, length, &eerr);
+    Parser *parser = lexer ? parser_create(lexer, &eerr) : NULL;
+    ok = false;
+    if (parser) {
+        parser->ast = &ast;
+        ok = parser_parse(parser);
+    }
+    parser_destroy(parser);
+    lexer_destroy(lexer);
+    double parse = now_seconds() - start;
+
+    start = now_seconds();
+    ok = ok && estree_write(&ast, source, length, &writer);
+    double emit = now_seconds() - start;
+    writer_close(&writer);
+
+    double total = parse + emit;
+    printf("  parse+ast   %8.3f s  %8.1f MB/s  %zu nodes\n", parse, mb / parse, ast.count);
+    printf("  emit        %8.3f s  %8.1f MB/s  %.1f MB JSON\n", emit, mb / emit,
+           writer.total / (1024.0 * 1024.0));
+    printf("  total       %8.3f s  %8.1f MB/s  %s  (%.2fx validation time)\n", total,
+           mb / total, ok ? "ok" : "FAILED", total / validate);
+
+    ast_free(&ast);
+    free(source);
+}
+
+/* 基准：构建AST vs 在AST上做作用域分析（建作用域树、检查重复声明、解析全部引用） */
+static void bench_scope(int argc, char **argv) {
+    size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 50;
+
+    size_t length;
+    char *source = generate_bundle(size_mb << 20, &length);
+    double mb = length / (1024.0 * 1024.0);
+
+    printf("[scope] input: %.1f MB\n", mb);
+
+    Ast ast;
+    ErrorInfo error = {0};
+    if (!ast_init(&ast, length)) {
+        fprintf(stderr, "Error: Out of memory\n");
+        free(source);
+        return;
+    }
+
+    double start = now_seconds();
+    Lexer *lexer = lexer_create(source, length, &error);
+    Parser *parser = lexer ? parser_create(lexer, &error) : NULL;
+    bool ok = false;
+    if (parser) {
+        parser->ast = &ast;
+        ok = parser_parse(parser);
+    }
+    parser_destroy(parser);
+    lexer_destroy(lexer);
+    double parse = now_seconds() - start;
+    printf("  parse+ast   %8.3f s  %8.1f MB/s  %zu nodes\n", parse, mb / parse, ast.count);
+
+    ScopeTree tree;
+    start = now_seconds();
+    ok = ok && scope_analyze(&tree, &ast, source, &error);
+    double analyze = now_seconds() - start;
+
+    size_t global = 0;
+    for (size_t i = 0; ok && i < tree.reference_count; i++) {
+        if (tree.references[i].depth == SCOPE_NONE) global++;
+    }
+    printf("  scopes      %8.3f s  %8.1f MB/s  %s  (+%.1f%% over parse)\n", analyze, mb / analyze,
+           ok ? "ok" : "FAILED", 100.0 * analyze / parse);
+    if (ok) {
+        printf("  %zu scopes, %zu bindings, %zu names, %zu references (%zu global)\n",
+               tree.scope_count, tree.binding_count, tree.name_count, tree.reference_count, global);
+        scope_tree_free(&tree);
+    }
+
+    ast_free(&ast);
+    free(source);
+}
+
+/* 遍历整棵树（统计节点数和标识符总长度），用来确认加载后的节点确实可用 */
+static size_t walk_tree(const Ast *ast, uint32_t index, size_t *identifier_bytes) {
+    size_t count = 0;
+    while (index != AST_NONE) {
+        const AstNode *node = &ast->nodes[index];
+        if (node->kind == AST_IDENTIFIER) {
+            *identifier_bytes += node->end - node->start;
+        }
+        count += 1 + walk_tree(ast, node->first_child, identifier_bytes);
+        index = node->next_sibling;
+    }
+    return count;
+}
+
+/* 基准：重新解析源码 vs 写出二进制AST后用mmap加载 */
+static void bench_astbin(int argc, char **argv) {
+    size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 50;
+    const char *path = "bench_astbin.jsab";
+
+    size_t length;
+    char *source = generate_bundle(size_mb << 20, &length);
+    double mb = length / (1024.0 * 1024.0);
+
+    printf("[astbin] input: %.1f MB\n", mb);
+
+    Ast ast;
+    ErrorInfo error = {0};
+    if (!ast_init(&ast, length)) {
+        fprintf(stderr, "Error: Out of memory\n");
+        free(source);
+        return;
+    }
+
+    double start = now_seconds();
+    Lexer *lexer = lexer_create(source, length, &error);
+    Parser *parser = lexer ? parser_create(lexer, &error) : NULL;
+    bool ok = false;
+    if (parser) {
+        parser->ast = &ast;
+        ok = parser_parse(parser) && !ast.failed;
+    }
+    parser_destroy(parser);
+    lexer_destroy(lexer);
+    double parse = now_seconds() - start;
+    printf("  re-parse    %8.3f s  %8.1f MB/s  %zu nodes  %s\n", parse, mb / parse,
+           ast.count, ok ? "ok" : "FAILED");
+
+    start = now_seconds();
+    ok = ok && ast_binary_write(&ast, source, length, path);
+    double write = now_seconds() - start;
+    printf("  write       %8.3f s  %8.1f MB file\n", write,
+           (sizeof(AstBinaryHeader) + ast.count * sizeof(AstNode) + length) / (1024.0 * 1024.0));
+
+    size_t expected_bytes = 0;
+    size_t expected = ok ? walk_tree(&ast, ast.root, &expected_bytes) : 0;
+    ast_free(&ast);
+    free(source);
+    if (!ok) {
+        remove(path);
+        return;
+    }
+
+    AstBinary binary;
+    start = now_seconds();
+    ok = ast_binary_load(&binary, path);
+    double load = now_seconds() - start;
+    if (!ok) {
+        remove(path);
+        return;
+    }
+
+    start = now_seconds();
+    bool valid = ast_binary_verify(&binary);
+    double verify = now_seconds() - start;
+
+    size_t bytes = 0;
+    start = now_seconds();
+    size_t walked = walk_tree(&binary.ast, binary.ast.root, &bytes);
+    double walk = now_seconds() - start;
+
+    ok = valid && walked == expected && bytes == expected_bytes;
+    printf("  load (mmap) %8.3f ms  (%.0fx faster than re-parse)\n", load * 1e3, parse / load);
+    printf("  + verify    %8.3f ms\n", verify * 1e3);
+    printf("  + walk      %8.3f ms  %zu nodes  %s\n", walk * 1e3, walked, ok ? "ok" : "MISMATCH");
+    printf("  load+verify+walk %.3f s  (%.1fx faster than re-parse)\n",
+           load + verify + walk, parse / (load + verify + walk));
+
+    ast_binary_close(&binary);
+    remove(path);
+}
+
+/* 基准：重新词法分析 vs 读取二进制token流 */
+static void bench_tokens(int argc, char **argv) {
+    size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 50;
+
+    size_t length;
+    char *source = generate_bundle(size_mb << 20, &length);
+    double mb = length / (1024.0 * 1024.0);
+
+    printf("[tokens] input: %.1f MB\n", mb);
+
+    TokenArray tokens = {0};
+    ErrorInfo error = {0};
+    double start = now_seconds();
+    bool ok = lexer_tokenize(source, length, &tokens, &error);
+    double lex = now_seconds() - start;
+    printf("  re-lex      %8.3f s  %8.1f MB/s  %zu tokens  %s\n", lex, mb / lex,
+           tokens.count, ok ? "ok" : "FAILED");
+
+    /* 输出到临时文件，再整体读回内存 */
+    Writer writer;
+    FILE *file = tmpfile();
+    if (!file || !writer_init(&writer, file)) {
+        fprintf(stderr, "Error: Cannot create temporary file\n");
+        if (file) fclose(file);
+        token_array_free(&tokens);
+        free(source);
+        return;
+    }
+    ErrorInfo werr = {0};
+    start = now_seconds();
+    ok = token_stream_write(source, length, TOKEN_STREAM_BINARY, &writer, &werr);
+    size_t size = writer.total + writer.length;
+    ok = writer_close(&writer) && ok;
+    double write = now_seconds() - start;
+    printf("  write       %8.3f s  %8.1f MB/s  %.1f MB stream  (%.2f bytes/token)\n", write,
+           mb / write, size / (1024.0 * 1024.0), (double)size / tokens.count);
+
+    char *stream = (char*)malloc(size > 0 ? size : 1);
+    rewind(file);
+    ok = ok && stream && fread(stream, 1, size, file) == size;
+    fclose(file);
+
+    TokenStreamReader reader;
+    TokenRecord record;
+    size_t count = 0;
+    bool identical = ok;
+    start = now_seconds();
+    if (ok && token_stream_reader_init(&reader, stream, size)) {
+        while (token_stream_read(&reader, &record)) {
+            count++;
+        }
+    }
+    double read = now_seconds() - start;
+
+    /* 与词法分析的结果逐个比较（不计时） */
+    if (ok && token_stream_reader_init(&reader, stream, size)) {
+        for (size_t i = 0; i < tokens.count && identical; i++) {
+            const Token *token = tokens.tokens[i];
+            identical = token_stream_read(&reader, &record) && record.type == token->type &&
+                        record.start == (size_t)token->start.offset &&
+                        record.end == (size_t)token->end.offset &&
+                        record.preceded_by_newline == token->preceded_by_newline;
+        }
+        identical = identical && reader.done && count == tokens.count;
+    }
+    printf("  read        %8.3f s  %8.1f MB/s  %zu tokens  %s  (%.1fx faster than re-lex)\n",
+           read, mb / read, count, identical ? "identical" : "MISMATCH", lex / read);
+
+    free(stream);
+    token_array_free(&tokens);
+    free(source);
+}
+
+/* 压缩一次（输出丢弃），with_map时同时生成并输出source map；返回耗时 */
+static double run_minify(const char *source, size_t length, bool with_map,
+                         size_t *output, size_t *mappings, bool *ok) {
+    Writer writer;
+    SourceMap map;
+    ErrorInfo error = {0};
+    if (!writer_init(&writer, NULL)) {
+        *ok = false;
+        return 0;
+    }
+
+    double start = now_seconds();
+    *ok = (!with_map || source_map_init(&map, source, length)) &&
+          minify_source(source, length, false, &writer, with_map ? &map : NULL, &error);
+    if (with_map) {
+        *ok = *ok && source_map_write(&map, "bundle.min.js", "bundle.js", &writer);
+    }
+    writer_flush(&writer);
+    double elapsed = now_seconds() - start;
+
+    *output = writer.total;
+    *mappings = with_map ? map.length : 0;
+    if (with_map) source_map_free(&map);
+    writer_close(&writer);
+    return elapsed;
+}
+
+/* 基准：只做语法验证 vs 验证并输出压缩后的源码 vs 同时生成source map（各取3次中最快的一次） */
+static void bench_minify(int argc, char **argv) {
+    size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 50;
+
+    size_t length;
+    char *source = generate_bundle(size_mb << 20, &length);
+    double mb = length / (1024.0 * 1024.0);
+
+    printf("[minify] input: %.1f MB\n", mb);
+
+    ErrorInfo error = {0};
+    Position origin = {1, 1, 0};
+    double start = now_seconds();
+    bool ok = parse_source_range(source, 0, length, origin, false, NULL, &error);
+    double validate = now_seconds() - start;
+    printf("  validate    %8.3f s  %8.1f MB/s  %s\n", validate, mb / validate,
+           ok ? "ok" : "FAILED");
+
+    double minify = 0, mapped = 0;
+    size_t output = 0, map_output = 0, mappings = 0;
+    bool minify_ok = true, map_ok = true;
+    for (int run = 0; run < 3; run++) {
+        bool run_ok;
+        double elapsed = run_minify(source, length, false, &output, &mappings, &run_ok);
+        if (run == 0 || elapsed < minify) minify = elapsed;
+        minify_ok = minify_ok && run_ok;
+
+        elapsed = run_minify(source, length, true, &map_output, &mappings, &run_ok);
+        if (run == 0 || elapsed < mapped) mapped = elapsed;
+        map_ok = map_ok && run_ok;
+    }
+
+    printf("  minify      %8.3f s  %8.1f MB/s  %s  (%.2fx validation time)\n", minify,
+           mb / minify, minify_ok ? "ok" : "FAILED", minify / validate);
+    printf("  output      %.1f MB  (%.1f%% of input)\n", output / (1024.0 * 1024.0),
+           100.0 * output / length);
+    printf("  + map       %8.3f s  %8.1f MB/s  %s  (+%.1f%% over minify, %.1f MB mappings)\n",
+           mapped, mb / mapped, map_ok ? "ok" : "FAILED", 100.0 * (mapped - minify) / minify,
+           mappings / (1024.0 * 1024.0));
+
+    free(source);
+}
+
+/* 格式化一次，输出到内存；返回耗时，失败时返回负数 */
+static double run_format(const char *source, size_t length, char **output, size_t *output_length) {
+    FILE *stream = open_memstream(output, output_length);
+    Writer writer;
+    if (!stream || !writer_init(&writer, stream)) {
+        if (stream) fclose(stream);
+        return -1;
+    }
+
+    ErrorInfo error = {0};
+    double start = now_seconds();
+    bool ok = format_source(source, length, false, &writer, &error);
+    writer_flush(&writer);
+    double elapsed = now_seconds() - start;
+    ok = writer_close(&writer) && ok;
+    fclose(stream);
+    return ok ? elapsed : -1;
+}
+
+/* 基准：只做语法验证 vs 格式化（含trivia记录和排版），并检查对输出再格式化结果不变 */
+static void bench_format(int argc, char **argv) {
+    size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 20;
+
+    size_t length;
+    char *source = generate_bundle(size_mb << 20, &length);
+    double mb = length / (1024.0 * 1024.0);
+
+    printf("[format] input: %.1f MB\n", mb);
+
+    ErrorInfo error = {0};
+    Position origin = {1, 1, 0};
+    double start = now_seconds();
+    bool ok = parse_source_range(source, 0, length, origin, false, NULL, &error);
+    double validate = now_seconds() - start;
+    printf("  validate    %8.3f s  %8.1f MB/s  %s\n", validate, mb / validate,
+           ok ? "ok" : "FAILED");
+
+    char *first = NULL, *second = NULL;
+    size_t first_length = 0, second_length = 0;
+    double format = run_format(source, length, &first, &first_length);
+    double again = format >= 0 ? run_format(first, first_length, &second, &second_length) : -1;
+    bool stable = again >= 0 && first_length == second_length &&
+                  memcmp(first, second, first_length) == 0;
+
+    if (format >= 0) {
+        printf("  format      %8.3f s  %8.1f MB/s  ok  (%.2fx validation time, %.1f MB output)\n",
+               format, mb / format, format / validate, first_length / (1024.0 * 1024.0));
+    } else {
+        printf("  format      FAILED\n");
+    }
+    printf("  idempotent  %s\n", stable ? "ok" : "FAILED");
+
+    free(first);
+    free(second);
+    free(source);
+}
+
+/* 解析建树后折叠，输出到内存；返回折叠的耗时，失败时返回负数 */
+static double run_fold(const char *source, size_t length, char **output, size_t *output_length,
+                       FoldStats *stats, double *parse) {
+    Ast ast;
+    ErrorInfo error = {0};
+    if (!ast_init(&ast, length)) return -1;
+    double start = now_seconds();
+    Lexer *lexer = lexer_create(source, length, &error);
+    Parser *parser = lexer ? parser_create(lexer, &error) : NULL;
+    bool ok = false;
+    if (parser) {
+        parser->ast = &ast;
+        ok = parser_parse(parser);
+    }
+    parser_destroy(parser);
+    lexer_destroy(lexer);
+    *parse = now_seconds() - start;
+
+    FILE *stream = ok ? open_memstream(output, output_length) : NULL;
+    Writer writer;
+    if (!stream || !writer_init(&writer, stream)) {
+        if (stream) fclose(stream);
+        ast_free(&ast);
+        return -1;
+    }
+    start = now_seconds();
+    ok = fold_write(&ast, source, length, &writer, stats);
+    writer_flush(&writer);
+    double elapsed = now_seconds() - start;
+    ok = writer_close(&writer) && ok;
+    fclose(stream);
+    ast_free(&ast);
+    return ok ? elapsed : -1;
+}
+
+/* 基准：建树 vs 折叠（求值 + 改写输出），输出必须仍然合法，且再折叠一次没有可做的 */
+static void bench_fold(int argc, char **argv) {
+    size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 20;
+
+    /* 每64 KB插入一段构建时常量展开后常见的代码 */
+    static const char chunk[] =
+        "var DEBUG = false, LEVEL = 1 << 3, TAG = \"v\" + 2 + \".\" + (4 * 2 + 1);\n"
+        "function trace(msg) {\n"
+        "    if (false) { var buffered = []; console.log(msg); }\n"
+        "    return typeof msg === \"string\" ? msg : \"\" + msg;\n"
+        "    var unreachable = 1;\n"
+        "}\n"
+        "var mask = ~0 >>> 16, big = 2 ** 20 - 1, ratio = 1 / 4, flags = (1 | 4) & ~1;\n"
+        "var mode = \"production\" === \"development\" ? \"dev\" : \"prod\";\n"
+        "if (!true) { warn(); } else { ready(); }\n"
+        "while (0) { spin(); }\n";
+    size_t length;
+    char *generated = generate_bundle(size_mb << 20, &length);
+    BenchBuffer buf = {NULL, 0, 0};
+    for (size_t offset = 0; offset < length; ) {
+        size_t end = offset + (64u << 10) < length ? offset + (64u << 10) : length;
+        while (end < length && generated[end - 1] != '\n') end++;
+        buffer_append(&buf, generated + offset, end - offset);
+        buffer_append(&buf, chunk, sizeof(chunk) - 1);
+        offset = end;
+    }
+    free(generated);
+    const char *source = buf.data;
+    length = buf.length;
+    double mb = length / (1024.0 * 1024.0);
+
+    printf("[fold] input: %.1f MB\n", mb);
+
+    char *first = NULL, *second = NULL;
+    size_t first_length = 0, second_length = 0;
+    FoldStats stats, again;
+    double parse = 0, reparse = 0;
+    double fold = run_fold(source, length, &first, &first_length, &stats, &parse);
+    double refold = fold >= 0 ? run_fold(first, first_length, &second, &second_length, &again, &reparse) : -1;
+    bool fixed = refold >= 0 && again.folded == 0 && again.branches == 0 && again.unreachable == 0 &&
+                 first_length == second_length && memcmp(first, second, first_length) == 0;
+
+    printf("  parse+ast   %8.3f s  %8.1f MB/s\n", parse, mb / parse);
+    if (fold >= 0) {
+        printf("  fold        %8.3f s  %8.1f MB/s  ok  (+%.1f%% over parse, %.1f MB output)\n",
+               fold, mb / fold, 100.0 * fold / parse, first_length / (1024.0 * 1024.0));
+        printf("  rewritten   %zu constants, %zu branches, %zu unreachable statements\n",
+               stats.folded, stats.branches, stats.unreachable);
+    } else {
+        printf("  fold        FAILED\n");
+    }
+    printf("  output      %s\n", refold >= 0 ? "valid" : "INVALID");
+    printf("  fixpoint    %s\n", fixed ? "ok" : "FAILED");
+
+    free(first);
+    free(second);
+    free(buf.data);
+}
+
+/* 合成规则：统计调用次数，节点或token异常长时报告（合成bundle中不会出现） */
+static void count_node(LintEngine *engine, void *data, uint32_t node) {
+    const AstNode *n = &engine->ast->nodes[node];
+    (*(size_t*)data)++;
+    if (n->end - n->start > (1u << 20)) {
+        lint_report(engine, n->start, n->end, "Node is longer than 1 MB");
+    }
+}
+
+static void count_token(LintEngine *engine, void *data, const Token *token) {
+    (*(size_t*)data)++;
+    if (token->length > 4096) {
+        lint_report(engine, (size_t)token->start.offset, (size_t)token->end.offset,
+                    "Token is longer than 4 KB");
+    }
+}
+
+/* 基准：只解析建树 vs 内置规则 vs 50条规则（一次解析、一次遍历） */
+static void bench_lint(int argc, char **argv) {
+    size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 20;
+    static const AstKind kinds[] = {
+        AST_IDENTIFIER, AST_CALL_EXPRESSION, AST_MEMBER_EXPRESSION, AST_BINARY_EXPRESSION,
+        AST_LITERAL, AST_VARIABLE_DECLARATION, AST_FUNCTION_DECLARATION, AST_IF_STATEMENT,
+        AST_FOR_STATEMENT, AST_RETURN_STATEMENT, AST_ASSIGNMENT_EXPRESSION, AST_BLOCK_STATEMENT,
+        AST_UPDATE_EXPRESSION, AST_TEMPLATE_LITERAL
+    };
+    static const TokenType types[] = {
+        TOKEN_IDENTIFIER, TOKEN_STRING, TOKEN_NUMBER, TOKEN_REGEX, TOKEN_LPAREN, TOKEN_DOT
+    };
+
+    /* 末尾追加会被内置规则报告的代码：with、debugger和两个重复的键（a、1） */
+    static const char tail[] =
+        "function legacy(o) { with (o) { debugger; } }\n"
+        "var dupes = { a: 1, 'a': 2, 0x1: 3, 1.0: 4, get b() { return 1; }, set b(v) {} };\n";
+    size_t length;
+    char *generated = generate_bundle(size_mb << 20, &length);
+    BenchBuffer buf = {generated, length, length + 1};
+    buffer_append(&buf, tail, sizeof(tail) - 1);
+    const char *source = buf.data;
+    length = buf.length;
+    double mb = length / (1024.0 * 1024.0);
+
+    printf("[lint] input: %.1f MB\n", mb);
+
+    Ast ast;
+    ErrorInfo error = {0};
+    if (!ast_init(&ast, length)) {
+        fprintf(stderr, "Error: Out of memory\n");
+        free(buf.data);
+        return;
+    }
+    double start = now_seconds();
+    Lexer *lexer = lexer_create(source, length, &error);
+    Parser *parser = lexer ? parser_create(lexer, &error) : NULL;
+    bool ok = false;
+    if (parser) {
+        parser->ast = &ast;
+        ok = parser_parse(parser);
+    }
+    parser_destroy(parser);
+    lexer_destroy(lexer);
+    double bare = now_seconds() - start;
+    printf("  parse+ast   %8.3f s  %8.1f MB/s  %s\n", bare, mb / bare, ok ? "ok" : "FAILED");
+    ast_free(&ast);
+
+    LintEngine engine;
+    lint_engine_init(&engine);
+    ok = lint_add_builtin_rules(&engine);
+    start = now_seconds();
+    ok = ok && lint_run(&engine, source, length, false, &error);
+    double builtin = now_seconds() - start;
+    printf("  3 rules     %8.3f s  %8.1f MB/s  %zu diagnostics  %s  (+%.1f%% over parse)\n",
+           builtin, mb / builtin, engine.count, ok && engine.count == 4 ? "ok" : "MISMATCH",
+           100.0 * (builtin - bare) / bare);
+
+    /* 再登记47条合成规则，约三分之二关心节点、三分之一关心token */
+    size_t calls[50] = {0};
+    size_t kind_count = sizeof(kinds) / sizeof(kinds[0]);
+    size_t type_count = sizeof(types) / sizeof(types[0]);
+    for (size_t i = 3; i < 50 && ok; i++) {
+        int rule = lint_add_rule(&engine, "synthetic", LINT_WARNING, &calls[i]);
+        ok = rule >= 0 && (i % 3 == 0 ? lint_on_token(&engine, rule, types[i % type_count], count_token)
+                                      : lint_on_node(&engine, rule, kinds[i % kind_count], count_node));
+    }
+    start = now_seconds();
+    ok = ok && lint_run(&engine, source, length, false, &error);
+    double all = now_seconds() - start;
+    size_t total = 0;
+    for (size_t i = 0; i < 50; i++) total += calls[i];
+    printf("  50 rules    %8.3f s  %8.1f MB/s  %zu diagnostics  %s  (+%.1f%% over parse, %zu handler calls)\n",
+           all, mb / all, engine.count, ok && engine.count == 4 ? "ok" : "MISMATCH",
+           100.0 * (all - bare) / bare, total);
+    printf("  50 separate parses would take ~%.3f s (%.1fx)\n", 50 * bare, 50 * bare / all);
+
+    lint_engine_free(&engine);
+    free(buf.data);
+}
+
+/* 高亮的一段与整个文件结果中对应的几行是否相同 */
+static bool highlight_slice_equal(const HighlightTokens *all, const HighlightTokens *part,
+                                  size_t first_line, size_t last_line) {
+    size_t lo = 0, hi = all->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (all->items[mid].line < first_line) lo = mid + 1; else hi = mid;
+    }
+    for (size_t i = 0; i < part->count; i++, lo++) {
+        const HighlightToken *a = &all->items[lo], *b = &part->items[i];
+        if (lo >= all->count || a->line != b->line || a->column != b->column ||
+            a->length != b->length || a->type != b->type || a->modifiers != b->modifiers) {
+            return false;
+        }
+    }
+    return lo == all->count || all->items[lo].line > last_line;
+}
+
+/* 基准：整个文件的语义token（同时建检查点表） vs 只高亮一屏（60行） */
+static void bench_highlight(int argc, char **argv) {
+    size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 50;
+    const size_t screen = 60;
+    const int viewports = 2000;
+
+    size_t length;
+    char *source = generate_bundle(size_mb << 20, &length);
+    double mb = length / (1024.0 * 1024.0);
+
+    printf("[highlight] input: %.1f MB\n", mb);
+
+    HighlightIndex index;
+    HighlightTokens all = {0};
+    double start = now_seconds();
+    bool ok = highlight_source(source, length, &index, &all);
+    double full = now_seconds() - start;
+    size_t lines = ok && all.count ? all.items[all.count - 1].line + 1 : 0;
+    printf("  full file   %8.3f s  %8.1f MB/s  %zu tokens, %zu lines, %zu checkpoints  %s\n",
+           full, mb / full, all.count, lines, index.count, ok ? "ok" : "FAILED");
+
+    /* 从文件中不同位置随机取一屏，检查与整个文件结果中对应的几行相同 */
+    HighlightTokens part = {0};
+    bool same = ok && lines > screen;
+    double total = 0, worst = 0;
+    unsigned seed = 12345;
+    for (int i = 0; same && i < viewports; i++) {
+        seed = seed * 1103515245u + 12345u;
+        size_t first = (size_t)((seed >> 8) % (lines - screen));
+        part.count = 0;
+        start = now_seconds();
+        same = highlight_range(&index, first, first + screen - 1, &part);
+        double elapsed = now_seconds() - start;
+        total += elapsed;
+        if (elapsed > worst) worst = elapsed;
+        same = same && highlight_slice_equal(&all, &part, first, first + screen - 1);
+    }
+    printf("  viewport    %8.1f us average, %.1f us worst (%zu lines, %d random positions)  %s\n",
+           total / viewports * 1e6, worst * 1e6, screen, viewports, same ? "ok" : "MISMATCH");
+
+    highlight_tokens_free(&part);
+    highlight_tokens_free(&all);
+    highlight_index_free(&index);
+    free(source);
+}
+
+/* 基准：完整词法分析 vs 只扫描模块说明符（合成bundle中每个函数前有若干import/require） */
+static void bench_imports(int argc, char **argv) {
+    size_t size_mb = argc > 0 ? (size_t)atoi(argv[0]) : 50;
+
+    BenchBuffer buf = {0};
+    char chunk[256];
+    size_t length;
+    char *body = generate_bundle(size_mb << 20, &length);
+    size_t expected = 0;
+    for (size_t pos = 0, i = 0; pos < length; i++) {
+        const char *next = strstr(body + pos, "\nfunction ");
+        size_t end = next ? (size_t)(next - body) + 1 : length;
+        int n = snprintf(chunk, sizeof(chunk),
+            "import { helper_%zu as h } from './helpers/%zu.js';\n"
+            "export * from \"./reexport_%zu.js\";\n"
+            "const dep_%zu = require('./lib/%zu'), lazy = () => import('./lazy_%zu.js');\n",
+            i, i, i, i, i, i);
+        buffer_append(&buf, chunk, (size_t)n);
+        buffer_append(&buf, body + pos, end - pos);
+        expected += 4;
+        pos = end;
+    }
+    free(body);
+    double mb = buf.length / (1024.0 * 1024.0);
+
+    printf("[imports] input: %.1f MB, %zu specifiers\n", mb, expected);
+
+    TokenArray tokens = {0};
+    ErrorInfo error = {0};
+    double start = now_seconds();
+    bool ok = lexer_tokenize(buf.data, buf.length, &tokens, &error);
+    double lex = now_seconds() - start;
+    printf("  full lex    %8.3f s  %8.1f MB/s  %s\n", lex, mb / lex, ok ? "ok" : "FAILED");
+    token_array_free(&tokens);
+
+    /* 取3次中最快的一次 */
+    double scan = 0;
+    size_t found = 0;
+    for (int run = 0; run < 3; run++) {
+        ModuleImportList imports = {0};
+        ErrorInfo serr = {0};
+        start = now_seconds();
+        ok = module_scan(buf.data, buf.length, &imports, &serr);
+        double elapsed = now_seconds() - start;
+        if (run == 0 || elapsed < scan) scan = elapsed;
+        found = imports.count;
+        module_import_list_free(&imports);
+    }
+    printf("  scan        %8.3f s  %8.1f MB/s  %zu specifiers  %s  (%.0fx faster than lexing)\n",
+           scan, mb / scan, found, ok && found == expected ? "ok" : "MISMATCH", lex / scan);
+
+    free(buf.data);
+}
+
+#define GRAPH_DIRS 256
+
+/* 生成n个模块的合成依赖树：模块i导入子模块4i+1..4i+4（一半不带扩展名）、
+   共享目录（index.js）和一个裸说明符，文件分散在GRAPH_DIRS个目录中 */
+static bool write_module_tree(const char *root, size_t n) {
+    char path[256];
+    char text[1024];
+
+    if (mkdir(root, 0755) != 0) return false;
+    for (int d = 0; d < GRAPH_DIRS; d++) {
+        snprintf(path, sizeof(path), "%s/d%d", root, d);
+        if (mkdir(path, 0755) != 0) return false;
+    }
+    snprintf(path, sizeof(path), "%s/shared", root);
+    if (mkdir(path, 0755) != 0) return false;
+    snprintf(path, sizeof(path), "%s/shared/index.js", root);
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+    fputs("export const shared = { version: 1 };\n", file);
+    fclose(file);
+
+    for (size_t i = 0; i < n; i++) {
+        int len = snprintf(text, sizeof(text),
+                           "import { shared } from '../shared';\nconst _ = require('lodash');\n");
+        for (size_t c = 4 * i + 1; c <= 4 * i + 4 && c < n; c++) {
+            len += snprintf(text + len, sizeof(text) - len,
+                            "import { value_%zu } from '../d%zu/m%zu%s';\n",
+                            c, c % GRAPH_DIRS, c, c % 2 ? "" : ".js");
+        }
+        snprintf(text + len, sizeof(text) - len,
+                 "export function value_%zu(x) {\n"
+                 "    const s = `module ${x}`; // import './not-a-dependency'\n"
+                 "    return x > 0 ? s.length / 2 : shared.version;\n"
+                 "}\n", i);
+
+        snprintf(path, sizeof(path), "%s/d%zu/m%zu.js", root, i % GRAPH_DIRS, i);
+        file = fopen(path, "wb");
+        if (!file) return false;
+        fputs(text, file);
+        fclose(file);
+    }
+    return true;
+}
+
+/* 删除合成依赖树 */
+static void remove_module_tree(const char *root, size_t n) {
+    char path[256];
+    for (size_t i = 0; i < n; i++) {
+        snprintf(path, sizeof(path), "%s/d%zu/m%zu.js", root, i % GRAPH_DIRS, i);
+        remove(path);
+    }
+    for (int d = 0; d < GRAPH_DIRS; d++) {
+        snprintf(path, sizeof(path), "%s/d%d", root, d);
+        remove(path);
+    }
+    snprintf(path, sizeof(path), "%s/shared/index.js", root);
+    remove(path);
+    snprintf(path, sizeof(path), "%s/shared", root);
+    remove(path);
+    remove(root);
+}
+
+/* 基准：在合成依赖树上构建模块依赖图（单线程 vs 全部核心） */
+static void bench_graph(int argc, char **argv) {
+    size_t n = argc > 0 ? (size_t)atoi(argv[0]) : 50000;
+    const char *root = "bench_graph";
+    char entry[256];
+
+    if (n == 0) n = 1;
+    remove_module_tree(root, n);
+    if (!write_module_tree(root, n)) {
+        fprintf(stderr, "Error: Cannot write module tree under '%s'\n", root);
+        remove_module_tree(root, n);
+        return;
+    }
+    snprintf(entry, sizeof(entry), "%s/d0/m0.js", root);
+    const char *entries[] = {entry};
+
+    printf("[graph] %zu modules\n", n);
+
+    int counts[] = {1, threadpool_cpu_count()};
+    for (int t = 0; t < 2; t++) {
+        if (t == 1 && counts[1] == 1) break;
+
+        /* 取3次中最快的一次（第一次同时预热文件系统缓存） */
+        double best = 0;
+        ModuleGraph graph;
+        bool ok = false;
+        for (int run = 0; run < 3; run++) {
+            ErrorInfo error = {0};
+            double start = now_seconds();
+            ok = module_graph_build(&graph, entries, 1, counts[t], &error);
+            double elapsed = now_seconds() - start;
+            if (run == 0 || elapsed < best) best = elapsed;
+            if (!ok) {
+                print_error(&error);
+                break;
+            }
+            if (run < 2) module_graph_free(&graph);
+        }
+        if (!ok) break;
+
+        /* n个模块、共享目录；边数为树边n-1加上每个模块到shared的一条 */
+        bool match = graph.count == n + 1 && graph.edge_count == (n - 1) + n &&
+                     graph.cycle_count == 0 && graph.order[graph.count - 1] == 0;
+        printf("  %2d thread%s %8.3f s  %8.0f modules/s  %zu edges  %s\n",
+               counts[t], counts[t] == 1 ? " " : "s", best, graph.count / best,
+               graph.edge_count, match ? "ok" : "MISMATCH");
+        module_graph_free(&graph);
+    }
+
+    remove_module_tree(root, n);
+}
+
+/* 在索引中查找名字并数出全部出现次数 */
+static size_t count_occurrences(const IdentIndex *index, const char *name) {
+    uint32_t slot;
+    size_t count = 0;
+    if (ident_index_find(index, name, strlen(name), &slot)) {
+        IdentCursor cursor;
+        ident_index_cursor(index, slot, &cursor);
+        while (ident_index_next(&cursor)) count++;
+    }
+    return count;
+}
+
+/* 基准：在合成依赖树上建立标识符索引（全量、无变化、改动一个文件），
+   并比较查询与逐个读文件做子串匹配的耗时 */
+static void bench_index(int argc, char **argv) {
+    size_t n = argc > 0 ? (size_t)atoi(argv[0]) : 20000;
+    const char *root = "bench_index";
+    char path[256];
+    char index_path[256];
+
+    if (n == 0) n = 1;
+    snprintf(index_path, sizeof(index_path), "%s/%s", root, IDENT_INDEX_FILE);
+    remove(index_path);
+    remove_module_tree(root, n);
+    if (!write_module_tree(root, n)) {
+        fprintf(stderr, "Error: Cannot write module tree under '%s'\n", root);
+        remove_module_tree(root, n);
+        return;
+    }
+
+    printf("[index] %zu modules\n", n);
+
+    const char *labels[] = {"full", "unchanged", "one edit"};
+    bool ok = true;
+    for (int step = 0; ok && step < 3; step++) {
+        if (step == 2) {
+            snprintf(path, sizeof(path), "%s/d0/m0.js", root);
+            FILE *file = fopen(path, "ab");
+            if (file) {
+                fputs("export const edited = shared;\n", file);
+                fclose(file);
+            }
+        }
+        IdentIndexStats stats;
+        ErrorInfo error = {0};
+        double start = now_seconds();
+        ok = ident_index_build(root, index_path, 0, &stats, &error);
+        double elapsed = now_seconds() - start;
+        if (!ok) {
+            print_error(&error);
+            break;
+        }
+        printf("  %-10s %8.3f s  %zu lexed, %zu reused  %zu names, %zu occurrences, %.1f MB\n",
+               labels[step], elapsed, stats.lexed, stats.reused, stats.names, stats.postings,
+               stats.bytes / (1024.0 * 1024.0));
+    }
+
+    IdentIndex index;
+    if (ok && ident_index_load(&index, index_path)) {
+        /* 加载和查找都计入，取100次的平均 */
+        double start = now_seconds();
+        size_t hits = 0;
+        for (int run = 0; run < 100; run++) {
+            IdentIndex loaded;
+            if (!ident_index_load(&loaded, index_path)) break;
+            hits = count_occurrences(&loaded, "shared");
+            ident_index_close(&loaded);
+        }
+        double query = (now_seconds() - start) / 100;
+
+        /* 对照：读入每个文件做子串匹配（会把字符串和注释中的也算进去） */
+        start = now_seconds();
+        size_t matches = 0;
+        for (size_t i = 0; i < n; i++) {
+            snprintf(path, sizeof(path), "%s/d%zu/m%zu.js", root, i % GRAPH_DIRS, i);
+            FILE *file = fopen(path, "rb");
+            if (!file) continue;
+            char text[4096];
+            size_t length = fread(text, 1, sizeof(text) - 1, file);
+            text[length] = '\0';
+            fclose(file);
+            for (const char *p = strstr(text, "shared"); p; p = strstr(p + 6, "shared")) {
+                matches++;
+            }
+        }
+        double scan = now_seconds() - start;
+
+        bool match = hits == 2 * n + 1 + 1;
+        printf("  query      %8.3f ms  %zu occurrences of 'shared'  %s\n", query * 1e3, hits,
+               match ? "ok" : "MISMATCH");
+        printf("  grep       %8.3f ms  %zu substring matches  (%.0fx slower)\n", scan * 1e3,
+               matches, scan / query);
+        ident_index_close(&index);
+    }
+
+    remove(index_path);
+    remove_module_tree(root, n);
+}
+
+/* 基准：在合成依赖树上摇树（单线程 vs 全部核心，依赖图只构建一次） */
+static void bench_tree_shake(int argc, char **argv) {
+    size_t n = argc > 0 ? (size_t)atoi(argv[0]) : 20000;
+    const char *root = "bench_shake";
+    char entry[256];
+
+    if (n < 2) n = 2;
+    remove_module_tree(root, n);
+    if (!write_module_tree(root, n)) {
+        fprintf(stderr, "Error: Cannot write module tree under '%s'\n", root);
+        remove_module_tree(root, n);
+        return;
+    }
+    snprintf(entry, sizeof(entry), "%s/d0/m0.js", root);
+    const char *entries[] = {entry};
+
+    ModuleGraph graph;
+    ErrorInfo error = {0};
+    if (!module_graph_build(&graph, entries, 1, 0, &error)) {
+        print_error(&error);
+        remove_module_tree(root, n);
+        return;
+    }
+
+    printf("[treeshake] %zu modules\n", n);
+
+    int counts[] = {1, threadpool_cpu_count()};
+    for (int t = 0; t < 2; t++) {
+        if (t == 1 && counts[1] == 1) break;
+
+        double best = 0;
+        TreeShake shake;
+        bool ok = false;
+        for (int run = 0; run < 3; run++) {
+            double start = now_seconds();
+            ok = tree_shake(&shake, &graph, counts[t], &error);
+            double elapsed = now_seconds() - start;
+            if (run == 0 || elapsed < best) best = elapsed;
+            if (!ok) {
+                print_error(&error);
+                break;
+            }
+            if (run < 2) tree_shake_free(&shake);
+        }
+        if (!ok) break;
+
+        /* 除入口外每个模块的导出函数都未被使用，对shared的import随之删除 */
+        size_t removed = 0;
+        for (size_t m = 0; m < graph.count; m++) {
+            removed += shake.modules[m].statement_count - shake.modules[m].kept;
+        }
+        printf("  %2d thread%s %8.3f s  %8.0f modules/s  %zu statements removed  %s\n",
+               counts[t], counts[t] == 1 ? " " : "s", best, graph.count / best,
+               removed, removed == 2 * (n - 1) ? "ok" : "MISMATCH");
+        tree_shake_free(&shake);
+    }
+
+    module_graph_free(&graph);
+    remove_module_tree(root, n);
+}
+
+/* 基准：在合成依赖树上打包（依赖图和摇树只做一次），输出重新按模块解析验证 */
+static void bench_bundle(int argc, char **argv) {
+    size_t n = argc > 0 ? (size_t)atoi(argv[0]) : 10000;
+    const char *root = "bench_bundle";
+    char entry[256];
+
+    if (n < 2) n = 2;
+    remove_module_tree(root, n);
+    if (!write_module_tree(root, n)) {
+        fprintf(stderr, "Error: Cannot write module tree under '%s'\n", root);
+        remove_module_tree(root, n);
+        return;
+    }
+    snprintf(entry, sizeof(entry), "%s/d0/m0.js", root);
+    const char *entries[] = {entry};
+
+    ModuleGraph graph;
+    TreeShake shake;
+    ErrorInfo error = {0};
+    if (!module_graph_build(&graph, entries, 1, 0, &error)) {
+        print_error(&error);
+        remove_module_tree(root, n);
+        return;
+    }
+    if (!tree_shake(&shake, &graph, 0, &error)) {
+        print_error(&error);
+        module_graph_free(&graph);
+        remove_module_tree(root, n);
+        return;
+    }
+
+    printf("[bundle] %zu modules\n", n);
+
+    /* 取3次中最快的一次，输出丢弃 */
+    double best = 0;
+    bool ok = true;
+    for (int run = 0; run < 3 && ok; run++) {
+        Writer writer;
+        ok = writer_init(&writer, NULL);
+        double start = now_seconds();
+        ok = ok && bundle_write(&shake, &writer, &error);
+        double elapsed = now_seconds() - start;
+        ok = writer_close(&writer) && ok;
+        if (run == 0 || elapsed < best) best = elapsed;
+    }
+
+    /* 写到临时文件再读回，按模块解析并数出模块注释 */
+    Writer writer;
+    FILE *file = tmpfile();
+    size_t size = 0;
+    if (ok && file && writer_init(&writer, file)) {
+        ok = bundle_write(&shake, &writer, &error);
+        size = writer.total + writer.length;
+        ok = writer_close(&writer) && ok;
+    } else {
+        ok = false;
+    }
+    char *output = (char*)malloc(size + 1);
+    if (file) rewind(file);
+    ok = ok && output && fread(output, 1, size, file) == size;
+    if (file) fclose(file);
+
+    size_t headers = 0;
+    size_t live = 0;
+    bool parsed = false;
+    if (ok) {
+        output[size] = '\0';
+        for (size_t i = 0; i + 3 <= size; i++) {
+            if ((i == 0 || output[i - 1] == '\n') && memcmp(output + i, "// ", 3) == 0) headers++;
+        }
+        for (size_t m = 0; m < graph.count; m++) {
+            live += shake.modules[m].live;
+        }
+
+        Ast ast;
+        ErrorInfo perr = {0};
+        if (ast_init(&ast, size)) {
+            Lexer *lexer = lexer_create(output, size, &perr);
+            Parser *parser = lexer ? parser_create(lexer, &perr) : NULL;
+            if (parser) {
+                parser->ast = &ast;
+                parser->module = true;
+                parsed = parser_parse(parser);
+            }
+            parser_destroy(parser);
+            lexer_destroy(lexer);
+            ast_free(&ast);
+        }
+    } else {
+        print_error(&error);
+    }
+
+    /* 每个模块都因require('lodash')存活，除入口外的导出函数都被删除，共享目录被入口使用 */
+    printf("  bundle      %8.3f s  %8.0f modules/s  %.1f MB  %zu modules  %s\n", best,
+           graph.count / best, size / (1024.0 * 1024.0), headers,
+           ok && parsed && headers == live && live == n + 1 ? "ok" : "MISMATCH");
+
+    free(output);
+    tree_shake_free(&shake);
+    module_graph_free(&graph);
+    remove_module_tree(root, n);
+}
+
+/* 基准用例表 */
+typedef struct {
+    const char *name;
+    void (*run)(int argc, char **argv);
+} BenchCase;
+
+static const BenchCase bench_cases[] = {
+    {"parallel", bench_parallel},
+    {"lex", bench_lex},
+    {"atoms", bench_atoms},
+    {"strings", bench_strings},
+    {"numbers", bench_numbers},
+    {"regex", bench_regex},
+    {"structural", bench_structural},
+    {"incremental", bench_incremental},
+    {"lsp", bench_lsp},
+    {"estree", bench_estree},
+    {"astbin", bench_astbin},
+    {"tokens", bench_tokens},
+    {"minify", bench_minify},
+    {"format", bench_format},
+    {"fold", bench_fold},
+    {"scope", bench_scope},
+    {"lint", bench_lint},
+    {"highlight", bench_highlight},
+    {"imports", bench_imports},
+    {"graph", bench_graph},
+    {"treeshake", bench_tree_shake},
+    {"index", bench_index},
+    {"bundle", bench_bundle},
+    {NULL, NULL}
+};
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        for (int i = 0; bench_cases[i].name; i++) {
+            bench_cases[i].run(0, NULL);
+        }
+        return 0;
+    }
+
+    for (int i = 0; bench_cases[i].name; i++) {
+        if (strcmp(argv[1], bench_cases[i].name) == 0) {
+            bench_cases[i].run(argc - 2, argv + 2);
+            return 0;
+        }
+    }
+
+    fprintf(stderr, "Unknown benchmark '%s'. Available:", argv[1]);
+    for (int i = 0; bench_cases[i].name; i++) {
+        fprintf(stderr, " %s", bench_cases[i].name);
+    }
+    fprintf(stderr, "\n");
+    return 1;
+}
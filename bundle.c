@@ -0,0 +1,1098 @@
+#include "bundle.h"
+#include <stdarg.h>
+
+/*
+ * 作用域提升打包
+ *
+ * 在摇树结果上工作，分三步：
+ * 1. 解析链接：把每个存活的import绑定沿 export {..} from、export * 追到真正声明它的
+ *    模块和绑定（结果缓存，环形转发报错），记下需要命名空间对象的模块和入口的导出。
+ * 2. 命名：在某个模块中出现但不是该模块顶层绑定的名字（全局变量、内层变量、属性名）
+ *    不能被占用；其余顶层绑定按执行顺序先到先得，冲突时加 $1、$2 后缀。
+ *    因为同一模块内对一个顶层名字的所有出现（包括同名的内层变量）都改成同一个名字，
+ *    而新名字不在任何模块中出现，改名不会改变引用关系。
+ * 3. 输出：外部模块的import放在最前，各模块按依赖在前的顺序顺序写出，
+ *    按偏移排好的改写表把标识符替换为最终名字，最后写出入口的export。
+ */
+
+#define VISIT_NONE 0
+
+/* 解析结果 */
+typedef enum {
+    RESOLVED_BINDING,       /* 模块的顶层绑定（含外部模块的import绑定） */
+    RESOLVED_NAMESPACE,     /* 模块的命名空间对象（JSON模块为它的值） */
+    RESOLVED_EXTERNAL       /* 转发外部模块的导出（export {a} from 'pkg'） */
+} ResolvedKind;
+
+typedef struct {
+    ResolvedKind kind;
+    uint32_t module;
+    uint32_t index;         /* 绑定或导出下标 */
+} Resolved;
+
+/* 一个导出名及其解析结果（命名空间对象和入口的export） */
+typedef struct {
+    ShakeName name;
+    Resolved target;
+} BundleExport;
+
+typedef struct {
+    BundleExport *items;
+    size_t count;
+    size_t capacity;
+} ExportList;
+
+/* 源码改写 */
+typedef enum {
+    EDIT_NAME,              /* 顶层绑定的出现处 */
+    EDIT_SHORTHAND,         /* 简写属性 {a} 的值：写成 a: 新名字 */
+    EDIT_IMPORT_CALL        /* import('./x')：改为已打包模块的命名空间 */
+} EditKind;
+
+typedef struct {
+    uint32_t start;
+    uint32_t end;
+    EditKind kind;
+    uint32_t value;         /* 绑定下标或目标模块 */
+} BundleEdit;
+
+/* 链接状态 */
+enum {
+    LINK_NONE,
+    LINK_ACTIVE,            /* 正在解析（再次遇到说明转发成环） */
+    LINK_DONE
+};
+
+/* 一个模块的打包状态 */
+typedef struct {
+    ShakeName *finals;          /* 每个绑定的最终名字，text为NULL表示不输出 */
+    Resolved *links;            /* import绑定的解析结果 */
+    uint8_t *link_state;
+    ShakeName *export_finals;   /* 转发外部模块的导出在本文件中的名字 */
+    bool *export_used;
+    ShakeName namespace;        /* 命名空间对象（或JSON值）的名字 */
+    bool needs_namespace;
+    bool namespace_planned;
+    ExportList namespace_exports;
+    BundleEdit *edits;
+    size_t edit_count;
+    size_t edit_capacity;
+} BundleModule;
+
+/* 生成的名字的存储块 */
+typedef struct NameBlock {
+    struct NameBlock *next;
+    size_t used;
+    char text[4096];
+} NameBlock;
+
+typedef struct {
+    const TreeShake *shake;
+    const ModuleGraph *graph;
+    BundleModule *modules;
+    bool *inlined;              /* 模块打包进输出（存活且经import到达，只被require的CommonJS模块不打包） */
+    size_t root;                /* 打包的模块的公共目录前缀长度（模块注释中省略） */
+    ExportList exports;         /* 入口的导出 */
+    NameTable seen;             /* 收集导出名时去重 */
+    uint32_t *visited;          /* 收集导出名时已访问的模块（按轮次标记） */
+    uint32_t visit_round;
+    uint32_t *star_visited;     /* 查找导出名时经 export * 访问过的模块 */
+    uint32_t star_round;
+    NameTable free_names;       /* 在某个模块中出现但不是它的顶层绑定的名字 */
+    NameTable assigned;         /* 已分配的最终名字 */
+    NameTable suffix_names;     /* 冲突过的原名 -> suffixes下标 */
+    uint32_t *suffixes;         /* 下一个要尝试的后缀 */
+    size_t suffix_count;
+    size_t suffix_capacity;
+    NameBlock *blocks;
+    char last;                  /* 最后写出的语句的最后一个字符 */
+    bool circular;              /* 解析时遇到成环的转发 */
+    bool failed;
+    ErrorInfo *error;
+} Bundle;
+
+static const ShakeName default_name = {"default", 7};
+
+static inline const AstNode* node_at(const ShakeModule *m, uint32_t node) {
+    return &m->ast.nodes[node];
+}
+
+static inline uint32_t child_at(const ShakeModule *m, uint32_t node, int index) {
+    uint32_t child = m->ast.nodes[node].first_child;
+    while (index-- > 0 && child != AST_NONE) {
+        child = m->ast.nodes[child].next_sibling;
+    }
+    return child;
+}
+
+static inline bool is_null(const ShakeModule *m, uint32_t node) {
+    return node == AST_NONE || m->ast.nodes[node].kind == AST_NULL;
+}
+
+static bool name_equal(ShakeName a, ShakeName b) {
+    return a.length == b.length && memcmp(a.text, b.text, a.length) == 0;
+}
+
+/* 记录错误：位置为模块源码中的偏移，消息以模块路径开头 */
+static void bundle_fail(Bundle *b, uint32_t module, size_t offset, const char *format, ...) {
+    const GraphModule *gm = &b->graph->modules[module];
+    Position position = {1, 1, (int)offset};
+    for (size_t i = 0; i < offset && i < gm->length; i++) {
+        if (gm->source[i] == '\n') {
+            position.line++;
+            position.column = 1;
+        } else if (((unsigned char)gm->source[i] & 0xC0) != 0x80) {
+            position.column++;
+        }
+    }
+
+    char detail[256];
+    char message[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(detail, sizeof(detail), format, args);
+    va_end(args);
+    snprintf(message, sizeof(message), "%.*s: %.*s", (int)strlen(gm->path), gm->path,
+             (int)strlen(detail), detail);
+
+    set_error(b->error, ERROR_PARSER_UNEXPECTED_TOKEN, position, message);
+    b->failed = true;
+}
+
+static void out_of_memory(Bundle *b) {
+    set_error(b->error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+    b->failed = true;
+}
+
+/* 保证数组还能追加一个元素 */
+static bool reserve(void **items, size_t *capacity, size_t count, size_t size) {
+    if (count < *capacity) return true;
+
+    size_t new_capacity = *capacity ? *capacity * 2 : 16;
+    void *grown = realloc(*items, new_capacity * size);
+    if (!grown) return false;
+    *items = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+/* ---------- 链接 ---------- */
+
+static bool resolve_export(Bundle *b, uint32_t module, ShakeName name, uint32_t importer, size_t offset,
+                           Resolved *out);
+
+/* 解析模块中的一个绑定：本地绑定就是它自己，import绑定追到目标模块 */
+static bool resolve_binding(Bundle *b, uint32_t module, uint32_t binding, Resolved *out) {
+    const ShakeBinding *sb = &b->shake->modules[module].bindings[binding];
+    BundleModule *bm = &b->modules[module];
+
+    if ((sb->kind != BINDING_IMPORT && sb->kind != BINDING_NAMESPACE) || sb->target == MODULE_NONE) {
+        *out = (Resolved){RESOLVED_BINDING, module, binding};
+        return true;
+    }
+    if (bm->link_state[binding] == LINK_DONE) {
+        *out = bm->links[binding];
+        return true;
+    }
+    if (bm->link_state[binding] == LINK_ACTIVE) {
+        b->circular = true;
+        return false;
+    }
+
+    bm->link_state[binding] = LINK_ACTIVE;
+    bool ok;
+    if (sb->kind == BINDING_NAMESPACE) {
+        *out = (Resolved){RESOLVED_NAMESPACE, sb->target, 0};
+        b->modules[sb->target].needs_namespace = true;
+        ok = true;
+    } else {
+        ok = resolve_export(b, sb->target, sb->imported, module,
+                            b->shake->modules[module].ast.nodes[sb->node].start, out);
+    }
+    bm->link_state[binding] = ok ? LINK_DONE : LINK_NONE;
+    bm->links[binding] = *out;
+    return ok;
+}
+
+/* 在模块中查找导出名，找不到时经 export * 继续查找（不报错）。
+   同一名字的一次查找中每个模块只经 export * 进入一次（round标记），避免 export * 成环时重复查找 */
+static bool find_export(Bundle *b, uint32_t module, ShakeName name, int depth, uint32_t round,
+                        Resolved *out) {
+    const ShakeModule *m = &b->shake->modules[module];
+
+    if (depth > 256) {
+        b->circular = true;
+        return false;
+    }
+    if (m->opaque) {
+        if (!name_equal(name, default_name)) return false;
+        *out = (Resolved){RESOLVED_NAMESPACE, module, 0};
+        b->modules[module].needs_namespace = true;
+        return true;
+    }
+
+    uint32_t index = name_table_get(&m->export_names, name);
+    if (index != NAME_NONE) {
+        const ShakeExport *e = &m->exports[index];
+        switch (e->kind) {
+            case EXPORT_LOCAL:
+                return e->binding != NAME_NONE && resolve_binding(b, module, e->binding, out);
+            case EXPORT_REEXPORT:
+                if (e->target != MODULE_NONE) {
+                    return find_export(b, e->target, e->imported, depth + 1, ++b->star_round, out);
+                }
+                break;
+            case EXPORT_NAMESPACE:
+                if (e->target != MODULE_NONE) {
+                    *out = (Resolved){RESOLVED_NAMESPACE, e->target, 0};
+                    b->modules[e->target].needs_namespace = true;
+                    return true;
+                }
+                break;
+        }
+        /* 转发外部模块：在文件开头生成对应的import */
+        *out = (Resolved){RESOLVED_EXTERNAL, module, index};
+        b->modules[module].export_used[index] = true;
+        return true;
+    }
+
+    if (name_equal(name, default_name)) return false;
+    for (size_t s = 0; s < m->star_count && !b->failed; s++) {
+        uint32_t target = m->stars[s].target;
+        if (target == MODULE_NONE || b->star_visited[target] == round) continue;
+        b->star_visited[target] = round;
+        if (find_export(b, target, name, depth + 1, round, out)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* 解析 import {name} from module，找不到或转发成环时在importer的offset处报错 */
+static bool resolve_export(Bundle *b, uint32_t module, ShakeName name, uint32_t importer, size_t offset,
+                           Resolved *out) {
+    b->circular = false;
+    if (find_export(b, module, name, 0, ++b->star_round, out)) return true;
+    if (b->failed) return false;
+
+    if (b->circular) {
+        bundle_fail(b, importer, offset, "Circular re-export of '%.*s'", (int)name.length, name.text);
+    } else {
+        bundle_fail(b, importer, offset, "'%s' does not export '%.*s'", b->graph->modules[module].path,
+                    (int)name.length, name.text);
+    }
+    return false;
+}
+
+/* 收集模块的全部导出名（含 export * 转发的，后者不含default） */
+static void collect_names(Bundle *b, uint32_t module, bool star, ExportList *list) {
+    const ShakeModule *m = &b->shake->modules[module];
+    if (b->visited[module] == b->visit_round) return;
+    b->visited[module] = b->visit_round;
+
+    if (m->opaque) {
+        return;
+    }
+    for (size_t e = 0; e < m->export_count && !b->failed; e++) {
+        ShakeName name = m->exports[e].name;
+        if ((star && name_equal(name, default_name)) || name_table_get(&b->seen, name) != NAME_NONE) {
+            continue;
+        }
+        if (!name_table_put(&b->seen, name, 0) ||
+            !reserve((void**)&list->items, &list->capacity, list->count, sizeof(BundleExport))) {
+            out_of_memory(b);
+            return;
+        }
+        list->items[list->count++].name = name;
+    }
+    for (size_t s = 0; s < m->star_count && !b->failed; s++) {
+        if (m->stars[s].target != MODULE_NONE) {
+            collect_names(b, m->stars[s].target, true, list);
+        }
+    }
+}
+
+/* 解析一组导出名（从list的first开始） */
+static void resolve_names(Bundle *b, uint32_t module, ExportList *list, size_t first) {
+    for (size_t i = first; i < list->count && !b->failed; i++) {
+        resolve_export(b, module, list->items[i].name, module, 0, &list->items[i].target);
+    }
+}
+
+/* 收集并解析一个模块的导出（命名空间对象用） */
+static void plan_namespace(Bundle *b, uint32_t module) {
+    BundleModule *bm = &b->modules[module];
+    bm->namespace_planned = true;
+    if (b->shake->modules[module].opaque) return;
+
+    name_table_free(&b->seen);
+    b->visit_round++;
+    collect_names(b, module, false, &bm->namespace_exports);
+    resolve_names(b, module, &bm->namespace_exports, 0);
+}
+
+/* 比较改写的起始偏移 */
+static int compare_edits(const void *a, const void *b) {
+    const BundleEdit *x = (const BundleEdit*)a;
+    const BundleEdit *y = (const BundleEdit*)b;
+    return x->start < y->start ? -1 : x->start > y->start;
+}
+
+static void add_edit(Bundle *b, BundleModule *bm, const AstNode *n, EditKind kind, uint32_t value) {
+    if (!reserve((void**)&bm->edits, &bm->edit_capacity, bm->edit_count, sizeof(BundleEdit))) {
+        out_of_memory(b);
+        return;
+    }
+    BundleEdit *edit = &bm->edits[bm->edit_count++];
+    edit->start = n->start;
+    edit->end = n->end;
+    edit->kind = kind;
+    edit->value = value;
+}
+
+/* 收集模块的改写表：顶层绑定的出现处和打包进来的动态import */
+static void plan_edits(Bundle *b, uint32_t module) {
+    const ShakeModule *m = &b->shake->modules[module];
+    const GraphModule *gm = &b->graph->modules[module];
+    BundleModule *bm = &b->modules[module];
+
+    /* 简写属性的值与属性名共用源码范围 */
+    uint8_t *shorthand = (uint8_t*)calloc(m->ast.count ? m->ast.count : 1, 1);
+    if (!shorthand) {
+        out_of_memory(b);
+        return;
+    }
+    for (size_t i = 0; i < m->ast.count; i++) {
+        const AstNode *n = &m->ast.nodes[i];
+        if (n->kind == AST_PROPERTY && (n->flags & AST_FLAG_SHORTHAND)) {
+            uint32_t value = node_at(m, n->first_child)->next_sibling;
+            if (node_at(m, value)->kind == AST_ASSIGNMENT_PATTERN) {
+                value = node_at(m, value)->first_child;
+            }
+            shorthand[value] = 1;
+        } else if (n->kind == AST_IMPORT_EXPRESSION &&
+                   (node_at(m, n->first_child)->kind == AST_LITERAL ||
+                    node_at(m, n->first_child)->kind == AST_TEMPLATE_LITERAL)) {
+            /* 带替换的模板不是说明符，扫描时没有记录，这里也找不到目标 */
+            uint32_t target = module_import_target(gm, (size_t)node_at(m, n->first_child)->start + 1);
+            if (target != MODULE_NONE && !b->shake->modules[target].opaque) {
+                b->modules[target].needs_namespace = true;
+                add_edit(b, bm, n, EDIT_IMPORT_CALL, target);
+            }
+        }
+    }
+
+    for (size_t r = 0; r < m->ref_count && !b->failed; r++) {
+        const ShakeRef *ref = &m->refs[r];
+        add_edit(b, bm, node_at(m, ref->node), shorthand[ref->node] ? EDIT_SHORTHAND : EDIT_NAME,
+                 ref->binding);
+    }
+    free(shorthand);
+
+    if (!b->failed && bm->edit_count > 1) {
+        qsort(bm->edits, bm->edit_count, sizeof(BundleEdit), compare_edits);
+    }
+}
+
+/* 从入口出发沿import/export/import()到达的存活模块 */
+static void mark_inlined(Bundle *b) {
+    const ModuleGraph *graph = b->graph;
+    uint32_t *queue = (uint32_t*)malloc((graph->count ? graph->count : 1) * sizeof(uint32_t));
+    if (!queue) {
+        out_of_memory(b);
+        return;
+    }
+
+    size_t count = 0;
+    for (uint32_t entry = 0; entry < graph->entry_count; entry++) {
+        b->inlined[entry] = true;
+        queue[count++] = entry;
+    }
+    for (size_t head = 0; head < count; head++) {
+        const GraphModule *gm = &graph->modules[queue[head]];
+        for (size_t i = 0; i < gm->imports.count; i++) {
+            uint32_t target = gm->targets[i];
+            if (gm->imports.items[i].kind == IMPORT_REQUIRE || target == MODULE_NONE ||
+                !b->shake->modules[target].live || b->inlined[target]) {
+                continue;
+            }
+            b->inlined[target] = true;
+            queue[count++] = target;
+        }
+    }
+    free(queue);
+}
+
+/* 链接：解析存活的import绑定、入口的导出和需要的命名空间对象 */
+static void link_modules(Bundle *b) {
+    const ModuleGraph *graph = b->graph;
+
+    mark_inlined(b);
+    for (uint32_t i = 0; i < graph->count && !b->failed; i++) {
+        uint32_t module = graph->order[i];
+        const ShakeModule *m = &b->shake->modules[module];
+        if (!b->inlined[module] || m->opaque) continue;
+
+        for (uint32_t k = 0; k < m->binding_count && !b->failed; k++) {
+            const ShakeBinding *sb = &m->bindings[k];
+            if (sb->live && (sb->kind == BINDING_IMPORT || sb->kind == BINDING_NAMESPACE)) {
+                Resolved resolved;
+                resolve_binding(b, module, k, &resolved);
+            }
+        }
+        plan_edits(b, module);
+    }
+
+    /* 入口的导出（重复的名字以先出现的为准） */
+    name_table_free(&b->seen);
+    b->visit_round++;
+    for (uint32_t entry = 0; entry < graph->entry_count && !b->failed; entry++) {
+        size_t first = b->exports.count;
+        collect_names(b, entry, false, &b->exports);
+        resolve_names(b, entry, &b->exports, first);
+    }
+
+    /* 命名空间对象的导出可能又需要别的命名空间对象 */
+    bool changed = true;
+    while (changed && !b->failed) {
+        changed = false;
+        for (uint32_t module = 0; module < graph->count && !b->failed; module++) {
+            BundleModule *bm = &b->modules[module];
+            if (bm->needs_namespace && !bm->namespace_planned) {
+                plan_namespace(b, module);
+                changed = true;
+            }
+        }
+    }
+}
+
+/* ---------- 命名 ---------- */
+
+/* 保存生成的名字 */
+static ShakeName store_name(Bundle *b, const char *text, size_t length) {
+    ShakeName name = {NULL, 0};
+    if (length + 1 > sizeof(b->blocks->text)) {
+        out_of_memory(b);
+        return name;
+    }
+    if (!b->blocks || b->blocks->used + length + 1 > sizeof(b->blocks->text)) {
+        NameBlock *block = (NameBlock*)malloc(sizeof(NameBlock));
+        if (!block) {
+            out_of_memory(b);
+            return name;
+        }
+        block->next = b->blocks;
+        block->used = 0;
+        b->blocks = block;
+    }
+    char *copy = b->blocks->text + b->blocks->used;
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    b->blocks->used += length + 1;
+    name.text = copy;
+    name.length = (uint32_t)length;
+    return name;
+}
+
+static bool name_available(const Bundle *b, ShakeName name) {
+    return name_table_get(&b->free_names, name) == NAME_NONE &&
+           name_table_get(&b->assigned, name) == NAME_NONE;
+}
+
+/* 分配最终名字：原名可用就用原名，否则加 $1、$2 ... 后缀。
+   每个原名记住下一个要尝试的后缀，很多模块都有同名绑定时不必每次从 $1 试起 */
+static ShakeName assign_name(Bundle *b, ShakeName wanted) {
+    ShakeName name = wanted;
+    char buffer[288];
+    if (!wanted.text) return wanted;
+    if (!name_available(b, name)) {
+        uint32_t slot = name_table_get(&b->suffix_names, wanted);
+        if (slot == NAME_NONE) {
+            slot = (uint32_t)b->suffix_count;
+            if (!reserve((void**)&b->suffixes, &b->suffix_capacity, b->suffix_count, sizeof(uint32_t)) ||
+                !name_table_put(&b->suffix_names, wanted, slot)) {
+                out_of_memory(b);
+                return (ShakeName){NULL, 0};
+            }
+            b->suffixes[b->suffix_count++] = 1;
+        }
+        do {
+            int length = snprintf(buffer, sizeof(buffer), "%.*s$%u",
+                                  (int)(wanted.length > 256 ? 256 : wanted.length), wanted.text,
+                                  b->suffixes[slot]++);
+            name = (ShakeName){buffer, (uint32_t)length};
+        } while (!name_available(b, name));
+    }
+    if (name.text == buffer) {
+        name = store_name(b, buffer, name.length);
+    }
+    if (name.text && !name_table_put(&b->assigned, name, 0)) {
+        out_of_memory(b);
+    }
+    return name;
+}
+
+/* 按文件名生成名字：util.js -> util_<suffix>，index.js使用目录名 */
+static ShakeName derived_name(Bundle *b, uint32_t module, const char *suffix) {
+    const char *path = b->graph->modules[module].path;
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    size_t length = strcspn(base, ".");
+    if (length == 5 && memcmp(base, "index", 5) == 0 && base > path + 1) {
+        const char *dir = base - 1;
+        while (dir > path && dir[-1] != '/') dir--;
+        length = (size_t)(base - 1 - dir);
+        base = dir;
+    }
+
+    char buffer[128];
+    size_t n = 0;
+    if (length == 0 || (base[0] >= '0' && base[0] <= '9')) buffer[n++] = '_';
+    for (size_t i = 0; i < length && n < 64; i++) {
+        char ch = base[i];
+        bool word = (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+                    (ch >= '0' && ch <= '9') || ch == '_' || ch == '$';
+        buffer[n++] = word ? ch : '_';
+    }
+    n += (size_t)snprintf(buffer + n, sizeof(buffer) - n, "_%s", suffix);
+    return assign_name(b, store_name(b, buffer, n));
+}
+
+/* 绑定是否会被写出 */
+static bool binding_emitted(const ShakeModule *m, const ShakeBinding *sb) {
+    if (sb->kind == BINDING_IMPORT || sb->kind == BINDING_NAMESPACE) {
+        return sb->live && sb->target == MODULE_NONE;
+    }
+    for (uint32_t d = sb->first_decl; d != NAME_NONE; d = m->decls[d].next) {
+        const ShakeStatement *st = &m->statements[m->decls[d].statement];
+        if (st->action == SHAKE_KEEP || st->action == SHAKE_UNEXPORT) return true;
+    }
+    return false;
+}
+
+/* 收集不能占用的名字：模块中出现但不是它的顶层绑定的标识符
+   （非计算的属性名和模块间的import/export说明符除外） */
+static void collect_free_names(Bundle *b, uint32_t module) {
+    const ShakeModule *m = &b->shake->modules[module];
+    const char *source = b->graph->modules[module].source;
+
+    uint8_t *skip = (uint8_t*)calloc(m->ast.count ? m->ast.count : 1, 1);
+    if (!skip) {
+        out_of_memory(b);
+        return;
+    }
+    for (size_t i = 0; i < m->ast.count; i++) {
+        const AstNode *n = &m->ast.nodes[i];
+        if (n->flags & AST_FLAG_COMPUTED) continue;
+        if (n->kind == AST_MEMBER_EXPRESSION) {
+            skip[node_at(m, n->first_child)->next_sibling] = 1;
+        } else if (n->kind == AST_PROPERTY || n->kind == AST_METHOD_DEFINITION ||
+                   n->kind == AST_PROPERTY_DEFINITION) {
+            skip[n->first_child] = 1;
+        }
+    }
+    for (size_t s = 0; s < m->statement_count; s++) {
+        const AstNode *n = node_at(m, m->statements[s].node);
+        bool specifiers = n->kind == AST_IMPORT_DECLARATION || n->kind == AST_EXPORT_ALL_DECLARATION ||
+                          (n->kind == AST_EXPORT_NAMED_DECLARATION && is_null(m, n->first_child));
+        if (!specifiers) continue;
+        for (uint32_t spec = n->first_child; spec != AST_NONE; spec = node_at(m, spec)->next_sibling) {
+            skip[spec] = 1;
+            for (uint32_t name = node_at(m, spec)->first_child; name != AST_NONE;
+                 name = node_at(m, name)->next_sibling) {
+                skip[name] = 1;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < m->ast.count && !b->failed; i++) {
+        const AstNode *n = &m->ast.nodes[i];
+        if (n->kind != AST_IDENTIFIER || skip[i]) continue;
+        ShakeName name = {source + n->start, n->end - n->start};
+        if (name_table_get(&m->binding_names, name) == NAME_NONE &&
+            !name_table_put(&b->free_names, name, 0)) {
+            out_of_memory(b);
+        }
+    }
+    free(skip);
+}
+
+/* 给要写出的绑定、外部导入和命名空间对象分配名字 */
+static void assign_names(Bundle *b) {
+    const ModuleGraph *graph = b->graph;
+
+    for (uint32_t module = 0; module < graph->count && !b->failed; module++) {
+        const ShakeModule *m = &b->shake->modules[module];
+        if (b->inlined[module] && !m->opaque) collect_free_names(b, module);
+    }
+
+    for (uint32_t i = 0; i < graph->count && !b->failed; i++) {
+        uint32_t module = graph->order[i];
+        const ShakeModule *m = &b->shake->modules[module];
+        BundleModule *bm = &b->modules[module];
+        if (!b->inlined[module]) continue;
+
+        for (uint32_t k = 0; k < m->binding_count && !b->failed; k++) {
+            const ShakeBinding *sb = &m->bindings[k];
+            if (!binding_emitted(m, sb)) continue;
+            bm->finals[k] = sb->kind == BINDING_DEFAULT ? derived_name(b, module, "default")
+                                                        : assign_name(b, sb->name);
+        }
+        for (uint32_t e = 0; e < m->export_count && !b->failed; e++) {
+            if (bm->export_used[e]) {
+                bm->export_finals[e] = derived_name(b, module, "ext");
+            }
+        }
+        if (bm->needs_namespace) {
+            bm->namespace = derived_name(b, module, m->opaque ? "json" : "ns");
+        }
+    }
+}
+
+/* 解析结果的最终名字 */
+static ShakeName resolved_name(const Bundle *b, Resolved r) {
+    switch (r.kind) {
+        case RESOLVED_BINDING:
+            return b->modules[r.module].finals[r.index];
+        case RESOLVED_NAMESPACE:
+            return b->modules[r.module].namespace;
+        default:
+            return b->modules[r.module].export_finals[r.index];
+    }
+}
+
+/* 模块中一个绑定的出现处应写成的名字 */
+static ShakeName final_name(const Bundle *b, uint32_t module, uint32_t binding) {
+    const ShakeBinding *sb = &b->shake->modules[module].bindings[binding];
+    const BundleModule *bm = &b->modules[module];
+    if ((sb->kind == BINDING_IMPORT || sb->kind == BINDING_NAMESPACE) && sb->target != MODULE_NONE) {
+        return bm->link_state[binding] == LINK_DONE ? resolved_name(b, bm->links[binding]) : sb->name;
+    }
+    return bm->finals[binding].text ? bm->finals[binding] : sb->name;
+}
+
+/* ---------- 输出 ---------- */
+
+static inline void write_name(Writer *writer, ShakeName name) {
+    writer_write(writer, name.text, name.length);
+}
+
+static inline void write_node(Writer *writer, const char *source, const AstNode *n) {
+    writer_write(writer, source + n->start, n->end - n->start);
+}
+
+/* 名字能否不加引号作为属性名或导出名 */
+static bool is_plain_name(ShakeName name) {
+    if (name.length == 0 || (name.text[0] >= '0' && name.text[0] <= '9')) return false;
+    for (uint32_t i = 0; i < name.length; i++) {
+        char ch = name.text[i];
+        if (!((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+              (ch >= '0' && ch <= '9') || ch == '_' || ch == '$')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void write_export_name(Writer *writer, ShakeName name) {
+    if (is_plain_name(name)) {
+        write_name(writer, name);
+    } else {
+        writer_byte(writer, '"');
+        write_name(writer, name);
+        writer_byte(writer, '"');
+    }
+}
+
+/* 写出源码的 [start, end)，应用其中的改写 */
+static void write_range(Bundle *b, Writer *writer, uint32_t module, size_t start, size_t end,
+                        size_t *cursor) {
+    const BundleModule *bm = &b->modules[module];
+    const char *source = b->graph->modules[module].source;
+    size_t pos = start;
+
+    while (*cursor < bm->edit_count && bm->edits[*cursor].start < end) {
+        const BundleEdit *edit = &bm->edits[(*cursor)++];
+        if (edit->start < pos) continue;
+
+        ShakeName original = {source + edit->start, edit->end - edit->start};
+        writer_write(writer, source + pos, edit->start - pos);
+        if (edit->kind == EDIT_IMPORT_CALL) {
+            writer_cstr(writer, "Promise.resolve().then(() => ");
+            write_name(writer, b->modules[edit->value].namespace);
+            writer_byte(writer, ')');
+        } else {
+            ShakeName name = final_name(b, module, edit->value);
+            if (edit->kind == EDIT_SHORTHAND && !name_equal(name, original)) {
+                write_name(writer, original);
+                writer_cstr(writer, ": ");
+            }
+            write_name(writer, name);
+        }
+        pos = edit->end;
+    }
+    writer_write(writer, source + pos, end - pos);
+}
+
+/* 语句在模块体中是否有输出（模块间的import/export在打包后不再需要） */
+static bool statement_emitted(const ShakeModule *m, const ShakeStatement *st) {
+    const AstNode *n = node_at(m, st->node);
+    if (st->action == SHAKE_DROP) return false;
+    switch (n->kind) {
+        case AST_IMPORT_DECLARATION:
+        case AST_EXPORT_ALL_DECLARATION:
+            return false;
+        case AST_EXPORT_NAMED_DECLARATION:
+            return !is_null(m, n->first_child);
+        default:
+            return true;
+    }
+}
+
+/* 写出一条顶层语句 */
+static void write_statement(Bundle *b, Writer *writer, uint32_t module, const ShakeStatement *st,
+                            size_t *cursor) {
+    const ShakeModule *m = &b->shake->modules[module];
+    const BundleModule *bm = &b->modules[module];
+    const AstNode *n = node_at(m, st->node);
+
+    switch (n->kind) {
+        case AST_EXPORT_NAMED_DECLARATION:
+            write_range(b, writer, module, node_at(m, n->first_child)->start, n->end, cursor);
+            break;
+
+        case AST_EXPORT_DEFAULT_DECLARATION: {
+            const AstNode *d = node_at(m, n->first_child);
+            bool declaration = d->kind == AST_FUNCTION_DECLARATION || d->kind == AST_CLASS_DECLARATION;
+            if (declaration && !is_null(m, d->first_child)) {
+                write_range(b, writer, module, d->start, n->end, cursor);
+            } else if (st->action == SHAKE_EXPRESSION) {
+                writer_byte(writer, '(');
+                write_range(b, writer, module, d->start, d->end, cursor);
+                writer_cstr(writer, ");");
+            } else {
+                /* 匿名默认导出：用生成的名字声明 */
+                uint32_t binding = name_table_get(&m->binding_names, (ShakeName){"*default*", 9});
+                ShakeName name = bm->finals[binding];
+                if (declaration) {
+                    /* 名字写在class关键字之后或函数参数表之前（async function* 等） */
+                    const char *source = b->graph->modules[module].source;
+                    size_t at = d->start + 5;
+                    size_t prefix;
+                    if (d->kind == AST_FUNCTION_DECLARATION) {
+                        at = d->start;
+                        while (at < d->end && source[at] != '(') at++;
+                    }
+                    for (prefix = at; prefix > d->start && (source[prefix - 1] == ' ' || source[prefix - 1] == '\t'); prefix--) {
+                    }
+                    writer_write(writer, source + d->start, prefix - d->start);
+                    writer_byte(writer, ' ');
+                    write_name(writer, name);
+                    write_range(b, writer, module, at, d->end, cursor);
+                } else {
+                    writer_cstr(writer, "var ");
+                    write_name(writer, name);
+                    writer_cstr(writer, " = ");
+                    write_range(b, writer, module, d->start, d->end, cursor);
+                    writer_byte(writer, ';');
+                }
+            }
+            break;
+        }
+
+        default:
+            write_range(b, writer, module, n->start, n->end, cursor);
+            break;
+    }
+}
+
+/* 写出命名空间对象（导出用getter保持实时绑定） */
+static void write_namespace(Bundle *b, Writer *writer, uint32_t module) {
+    const BundleModule *bm = &b->modules[module];
+    writer_cstr(writer, "var ");
+    write_name(writer, bm->namespace);
+    writer_cstr(writer, " = Object.freeze({\n    __proto__: null");
+    for (size_t i = 0; i < bm->namespace_exports.count; i++) {
+        const BundleExport *e = &bm->namespace_exports.items[i];
+        writer_cstr(writer, ",\n    get ");
+        write_export_name(writer, e->name);
+        writer_cstr(writer, "() { return ");
+        write_name(writer, resolved_name(b, e->target));
+        writer_cstr(writer, "; }");
+    }
+    writer_cstr(writer, "\n});\n");
+}
+
+/* 写出一个模块：删除的语句连同前面的空白和注释一起去掉 */
+static void write_module(Bundle *b, Writer *writer, uint32_t module) {
+    const ShakeModule *m = &b->shake->modules[module];
+    const GraphModule *gm = &b->graph->modules[module];
+    const BundleModule *bm = &b->modules[module];
+    const char *source = gm->source;
+
+    /* 上一个模块最后一条语句可能依赖ASI结束 */
+    if (b->last != ';' && b->last != '}') {
+        writer_byte(writer, ';');
+    }
+    writer_cstr(writer, "// ");
+    writer_cstr(writer, gm->path + b->root);
+    writer_byte(writer, '\n');
+    b->last = ';';
+
+    if (m->opaque) {
+        if (bm->needs_namespace) {
+            size_t start = 0;
+            size_t end = gm->length;
+            while (start < end && (source[start] == ' ' || source[start] == '\n' ||
+                                   source[start] == '\r' || source[start] == '\t')) start++;
+            while (end > start && (source[end - 1] == ' ' || source[end - 1] == '\n' ||
+                                   source[end - 1] == '\r' || source[end - 1] == '\t')) end--;
+            writer_cstr(writer, "var ");
+            write_name(writer, bm->namespace);
+            writer_cstr(writer, " = ");
+            writer_write(writer, source + start, end - start);
+            writer_cstr(writer, ";\n");
+        }
+        b->last = ';';
+        return;
+    }
+
+    size_t cursor = 0;
+    size_t edit_cursor = 0;
+    bool dropped = true;        /* 模块开头的空白不保留 */
+    bool written = false;
+    for (size_t s = 0; s < m->statement_count; s++) {
+        const ShakeStatement *st = &m->statements[s];
+        const AstNode *n = node_at(m, st->node);
+        bool emitted = statement_emitted(m, st);
+        if (emitted) {
+            if (dropped) {
+                /* 去掉删除的语句后面的空白，保留换行 */
+                bool newline = false;
+                if (b->last != ';' && b->last != '}') writer_byte(writer, ';');
+                while (cursor < n->start && (source[cursor] == ' ' || source[cursor] == '\t' ||
+                                             source[cursor] == '\n' || source[cursor] == '\r')) {
+                    newline |= source[cursor++] == '\n';
+                }
+                if (newline && written) writer_byte(writer, '\n');
+            }
+            writer_write(writer, source + cursor, n->start - cursor);
+            write_statement(b, writer, module, st, &edit_cursor);
+            b->last = n->kind == AST_EXPORT_DEFAULT_DECLARATION ? ';' : source[n->end - 1];
+            written = true;
+        }
+        cursor = n->end;
+        dropped = !emitted;
+    }
+    if (written) {
+        /* 模块最后一条语句可能依赖ASI结束 */
+        if (b->last != ';' && b->last != '}') writer_byte(writer, ';');
+        writer_byte(writer, '\n');
+        b->last = ';';
+    }
+
+    if (bm->needs_namespace) {
+        write_namespace(b, writer, module);
+        b->last = ';';
+    }
+}
+
+/* 写出外部模块的import和入口中转发外部模块的 export * */
+static void write_externals(Bundle *b, Writer *writer) {
+    const ModuleGraph *graph = b->graph;
+
+    for (uint32_t i = 0; i < graph->count; i++) {
+        uint32_t module = graph->order[i];
+        const ShakeModule *m = &b->shake->modules[module];
+        const BundleModule *bm = &b->modules[module];
+        const char *source = graph->modules[module].source;
+        if (!b->inlined[module] || m->opaque) continue;
+
+        for (size_t s = 0; s < m->statement_count; s++) {
+            const ShakeStatement *st = &m->statements[s];
+            const AstNode *n = node_at(m, st->node);
+            if (st->action == SHAKE_DROP || st->target != MODULE_NONE) continue;
+
+            if (n->kind == AST_IMPORT_DECLARATION) {
+                bool braces = false;
+                bool any = false;
+                writer_cstr(writer, "import ");
+                for (uint32_t spec = node_at(m, n->first_child)->next_sibling; spec != AST_NONE;
+                     spec = node_at(m, spec)->next_sibling) {
+                    const AstNode *sp = node_at(m, spec);
+                    uint32_t local = sp->kind == AST_IMPORT_SPECIFIER ? child_at(m, spec, 1) : sp->first_child;
+                    const AstNode *l = node_at(m, local);
+                    uint32_t binding = name_table_get(&m->binding_names,
+                                                      (ShakeName){source + l->start, l->end - l->start});
+                    if (binding == NAME_NONE || !m->bindings[binding].live) continue;
+
+                    if (any) writer_cstr(writer, ", ");
+                    if (sp->kind == AST_IMPORT_NAMESPACE_SPECIFIER) {
+                        writer_cstr(writer, "* as ");
+                    } else if (sp->kind == AST_IMPORT_SPECIFIER) {
+                        const AstNode *imported = node_at(m, sp->first_child);
+                        if (!braces) writer_cstr(writer, "{ ");
+                        braces = true;
+                        if (!name_equal((ShakeName){source + imported->start, imported->end - imported->start},
+                                        bm->finals[binding])) {
+                            write_node(writer, source, imported);
+                            writer_cstr(writer, " as ");
+                        }
+                    }
+                    write_name(writer, bm->finals[binding]);
+                    any = true;
+                }
+                if (braces) writer_cstr(writer, " }");
+                if (any) writer_cstr(writer, " from ");
+                write_node(writer, source, node_at(m, n->first_child));
+                writer_cstr(writer, ";\n");
+            } else if (n->kind == AST_EXPORT_ALL_DECLARATION && module < graph->entry_count &&
+                       is_null(m, n->first_child)) {
+                write_node(writer, source, n);
+                writer_byte(writer, '\n');
+            }
+        }
+
+        for (size_t e = 0; e < m->export_count; e++) {
+            if (!bm->export_used[e]) continue;
+            /* export {a} from 'pkg' 和 export * as ns from 'pkg' 的来源都是第二个子节点 */
+            const ShakeExport *exp = &m->exports[e];
+            uint32_t from = child_at(m, m->statements[exp->statement].node, 1);
+            writer_cstr(writer, "import ");
+            if (exp->kind == EXPORT_NAMESPACE) {
+                writer_cstr(writer, "* as ");
+                write_name(writer, bm->export_finals[e]);
+            } else {
+                writer_cstr(writer, "{ ");
+                write_export_name(writer, exp->imported);
+                writer_cstr(writer, " as ");
+                write_name(writer, bm->export_finals[e]);
+                writer_cstr(writer, " }");
+            }
+            writer_cstr(writer, " from ");
+            write_node(writer, source, node_at(m, from));
+            writer_cstr(writer, ";\n");
+        }
+    }
+}
+
+/* 写出入口的导出 */
+static void write_entry_exports(Bundle *b, Writer *writer) {
+    if (b->exports.count == 0) return;
+
+    if (b->last != ';' && b->last != '}') writer_byte(writer, ';');
+    writer_cstr(writer, "export {");
+    for (size_t i = 0; i < b->exports.count; i++) {
+        const BundleExport *e = &b->exports.items[i];
+        ShakeName local = resolved_name(b, e->target);
+        writer_cstr(writer, i > 0 ? ", " : " ");
+        write_name(writer, local);
+        if (!name_equal(local, e->name)) {
+            writer_cstr(writer, " as ");
+            write_export_name(writer, e->name);
+        }
+    }
+    writer_cstr(writer, " };\n");
+}
+
+/* 所有打包的模块路径的公共目录前缀长度（以 / 结尾） */
+static size_t common_root(const Bundle *b) {
+    const ModuleGraph *graph = b->graph;
+    const char *root = graph->modules[0].path;
+    size_t length = (size_t)(strrchr(root, '/') - root) + 1;
+    for (size_t m = 1; m < graph->count; m++) {
+        if (!b->inlined[m]) continue;
+        const char *path = graph->modules[m].path;
+        size_t i = 0;
+        while (i < length && path[i] == root[i]) i++;
+        while (i > 0 && root[i - 1] != '/') i--;
+        length = i;
+    }
+    return length;
+}
+
+/* 释放打包状态 */
+static void bundle_free(Bundle *b) {
+    if (b->modules) {
+        for (size_t m = 0; m < b->graph->count; m++) {
+            BundleModule *bm = &b->modules[m];
+            free(bm->finals);
+            free(bm->links);
+            free(bm->link_state);
+            free(bm->export_finals);
+            free(bm->export_used);
+            free(bm->namespace_exports.items);
+            free(bm->edits);
+        }
+        free(b->modules);
+    }
+    free(b->inlined);
+    free(b->exports.items);
+    free(b->visited);
+    free(b->star_visited);
+    name_table_free(&b->seen);
+    name_table_free(&b->free_names);
+    name_table_free(&b->assigned);
+    name_table_free(&b->suffix_names);
+    free(b->suffixes);
+    while (b->blocks) {
+        NameBlock *next = b->blocks->next;
+        free(b->blocks);
+        b->blocks = next;
+    }
+}
+
+/* 打包输出 */
+bool bundle_write(const TreeShake *shake, Writer *writer, ErrorInfo *error) {
+    const ModuleGraph *graph = shake->graph;
+    Bundle b;
+    memset(&b, 0, sizeof(b));
+    b.shake = shake;
+    b.graph = graph;
+    b.error = error;
+    b.last = ';';
+    b.modules = (BundleModule*)calloc(graph->count ? graph->count : 1, sizeof(BundleModule));
+    b.visited = (uint32_t*)calloc(graph->count ? graph->count : 1, sizeof(uint32_t));
+    b.star_visited = (uint32_t*)calloc(graph->count ? graph->count : 1, sizeof(uint32_t));
+    b.inlined = (bool*)calloc(graph->count ? graph->count : 1, sizeof(bool));
+    b.visit_round = VISIT_NONE;
+    b.star_round = VISIT_NONE;
+    if (!b.modules || !b.visited || !b.star_visited || !b.inlined) {
+        out_of_memory(&b);
+        bundle_free(&b);
+        return false;
+    }
+
+    for (size_t m = 0; m < graph->count && !b.failed; m++) {
+        const ShakeModule *sm = &shake->modules[m];
+        BundleModule *bm = &b.modules[m];
+        size_t bindings = sm->binding_count ? sm->binding_count : 1;
+        size_t exports = sm->export_count ? sm->export_count : 1;
+        bm->finals = (ShakeName*)calloc(bindings, sizeof(ShakeName));
+        bm->links = (Resolved*)calloc(bindings, sizeof(Resolved));
+        bm->link_state = (uint8_t*)calloc(bindings, 1);
+        bm->export_finals = (ShakeName*)calloc(exports, sizeof(ShakeName));
+        bm->export_used = (bool*)calloc(exports, sizeof(bool));
+        if (!bm->finals || !bm->links || !bm->link_state || !bm->export_finals || !bm->export_used) {
+            out_of_memory(&b);
+        }
+    }
+
+    if (!b.failed) link_modules(&b);
+    if (!b.failed) b.root = common_root(&b);
+    if (!b.failed) assign_names(&b);
+    if (!b.failed) {
+        write_externals(&b, writer);
+        for (size_t i = 0; i < graph->count; i++) {
+            uint32_t module = graph->order[i];
+            if (b.inlined[module]) {
+                write_module(&b, writer, module);
+            }
+        }
+        write_entry_exports(&b, writer);
+    }
+
+    bool success = !b.failed && !writer->failed;
+    bundle_free(&b);
+    return success;
+}
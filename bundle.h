@@ -0,0 +1,13 @@
+#ifndef BUNDLE_H
+#define BUNDLE_H
+
+#include "treeshake.h"
+#include "writer.h"
+#include "common.h"
+
+/* 把摇树后仍需要的模块按执行顺序合并到同一个作用域（scope hoisting）：
+   顶层绑定冲突时改名，import的引用直接改写为目标绑定，模块间的import/export语句删除，
+   入口的导出合并为末尾的一条export。输出一次顺序写出 */
+bool bundle_write(const TreeShake *shake, Writer *writer, ErrorInfo *error);
+
+#endif /* BUNDLE_H */
@@ -23,13 +23,16 @@ typedef enum {
     ERROR_LEXER_UNTERMINATED_REGEX,
     ERROR_LEXER_INVALID_NUMBER,
     ERROR_LEXER_INVALID_UNICODE_ESCAPE,
+    ERROR_LEXER_INVALID_REGEX,
     ERROR_PARSER_UNEXPECTED_TOKEN,
     ERROR_PARSER_EXPECTED_TOKEN,
     ERROR_PARSER_INVALID_ASSIGNMENT,
     ERROR_PARSER_MISSING_SEMICOLON,
     ERROR_PARSER_UNEXPECTED_EOF,
     ERROR_FILE_READ,
-    ERROR_OUT_OF_MEMORY
+    ERROR_OUT_OF_MEMORY,
+    ERROR_INVALID_EDIT,
+    ERROR_SCOPE_REDECLARATION
 } ErrorCode;
 
 /* 错误信息结构体 */
@@ -44,6 +47,51 @@ bool is_unicode_id_start(uint32_t ch);
 bool is_unicode_id_continue(uint32_t ch);
 bool is_line_terminator(uint32_t ch);
 bool is_whitespace(uint32_t ch);
+uint32_t utf8_decode(const char *text, size_t length, size_t *size);
+size_t utf8_encode(char *out, uint32_t cp);
+
+/* 转义：十六进制数字的值，不是时返回-1 */
+int hex_digit_value(char ch);
+/* \u之后的XXXX或（braces时）{码点}，返回用掉的字节数，不合法时返回0 */
+size_t unicode_escape_value(const char *text, size_t length, bool braces, uint32_t *cp);
+
+/* 文件：读取整个文件（不打印错误，末尾补'\0'），失败返回NULL */
+char* file_load(const char *path, size_t *length);
+/* 只读打开整个文件：优先mmap，失败或不支持时读到内存中（*mapped为false），用file_unmap释放 */
+void* file_map(const char *path, size_t *size, bool *mapped);
+void file_unmap(void *data, size_t size, bool mapped);
+
+/* 块式arena：在当前块中顺序分配，不够时分配新的一块，整体释放 */
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t used;
+    size_t size;
+    uint64_t data[];
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock *blocks;
+    size_t block_size;      /* 每块的大小，更大的请求单独分配一块 */
+    size_t bytes;           /* 已分配的字节数 */
+} Arena;
+
+void arena_init(Arena *arena, size_t block_size);
+void arena_reset(Arena *arena, bool keep);      /* keep时保留一个标准大小的块给下一次使用 */
+void arena_free(Arena *arena);
+void* arena_alloc(Arena *arena, size_t size);   /* 8字节对齐 */
+const char* arena_store(Arena *arena, const char *text, size_t length);  /* 带'\0'的拷贝，不对齐 */
+
+/* 逐8字节读取的哈希（长度参与混合） */
+uint32_t hash_text(const char *text, size_t length);
+
+/* 线性探测的开放寻址表（每槽slot_size字节，全0为空槽）：插入前调用，负载超过一半时扩大一倍
+   （空表为min_capacity槽），hash给出已占用的槽的哈希值 */
+typedef uint32_t (*HashSlotFunc)(const void *slot, const void *context);
+bool hash_table_reserve(void **slots, size_t *capacity, size_t count, size_t slot_size,
+                        size_t min_capacity, HashSlotFunc hash, const void *context);
+
+/* 64位FNV-1a哈希（索引文件中保存的内容哈希也用它，不能更换） */
+uint64_t fnv1a_hash(const char *data, size_t length);
 
 /* 错误处理函数 */
 void set_error(ErrorInfo *error, ErrorCode code, Position pos, const char *message);
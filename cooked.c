@@ -0,0 +1,266 @@
+#include "cooked.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define COOKED_USE_SSE2 1
+#endif
+
+/* 去重哈希表的一项（text为NULL表示空槽） */
+typedef struct {
+    const char *text;
+    uint32_t length;
+    uint32_t hash;
+} CookedSlot;
+
+struct CookedStrings {
+    Arena text;
+    CookedSlot *slots;
+    size_t capacity;        /* 槽数（2的幂） */
+    size_t count;
+    char *scratch;          /* 解码缓冲 */
+    size_t scratch_capacity;
+    bool failed;            /* 内存不足 */
+};
+
+CookedStrings* cooked_strings_create(void) {
+    CookedStrings *table = (CookedStrings*)calloc(1, sizeof(CookedStrings));
+    if (!table) return NULL;
+    table->slots = (CookedSlot*)calloc(COOKED_INITIAL_SLOTS, sizeof(CookedSlot));
+    if (!table->slots) {
+        free(table);
+        return NULL;
+    }
+    table->capacity = COOKED_INITIAL_SLOTS;
+    arena_init(&table->text, COOKED_BLOCK);
+    return table;
+}
+
+void cooked_strings_destroy(CookedStrings *table) {
+    if (!table) return;
+    arena_free(&table->text);
+    free(table->slots);
+    free(table->scratch);
+    free(table);
+}
+
+size_t cooked_strings_count(const CookedStrings *table) {
+    return table->count;
+}
+
+size_t cooked_strings_bytes(const CookedStrings *table) {
+    return table->text.bytes;
+}
+
+bool cooked_strings_failed(const CookedStrings *table) {
+    return table->failed;
+}
+
+/* ---------- 扫描 ---------- */
+
+size_t cooked_scan(const char *text, size_t length, char quote) {
+    size_t i = 0;
+#ifdef COOKED_USE_SSE2
+    const __m128i q = _mm_set1_epi8(quote);
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    for (; i + 16 <= length; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(text + i));
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, q), _mm_cmpeq_epi8(chunk, backslash)),
+                                   _mm_or_si128(_mm_cmpeq_epi8(chunk, lf), _mm_cmpeq_epi8(chunk, cr)));
+        unsigned mask = (unsigned)_mm_movemask_epi8(hit);
+        if (mask) return i + (size_t)__builtin_ctz(mask);
+    }
+#endif
+    for (; i < length; i++) {
+        char ch = text[i];
+        if (ch == quote || ch == '\\' || ch == '\n' || ch == '\r') return i;
+    }
+    return length;
+}
+
+/* ---------- 解码 ---------- */
+
+bool cooked_valid_escape(const char *text, size_t length) {
+    uint32_t cp;
+    if (length == 0) return true;
+    if (text[0] == 'x') {
+        return length >= 3 && hex_digit_value(text[1]) >= 0 && hex_digit_value(text[2]) >= 0;
+    }
+    if (text[0] == 'u') return unicode_escape_value(text + 1, length - 1, true, &cp) > 0;
+    return true;
+}
+
+bool cooked_legacy_escape(const char *text, size_t length) {
+    if (length == 0) return false;
+    if (text[0] == '0') return length > 1 && text[1] >= '0' && text[1] <= '9';
+    return text[0] >= '1' && text[0] <= '9';
+}
+
+bool cooked_decode(const char *body, size_t length, char *out, size_t *out_length) {
+    size_t n = 0;
+    size_t i = 0;
+
+    while (i < length) {
+        const char *backslash = (const char*)memchr(body + i, '\\', length - i);
+        size_t run = backslash ? (size_t)(backslash - body) - i : length - i;
+        memcpy(out + n, body + i, run);
+        n += run;
+        i += run;
+        if (!backslash) break;
+
+        if (++i >= length) return false;
+        char ch = body[i++];
+        uint32_t cp;
+        switch (ch) {
+            case 'n': out[n++] = '\n'; break;
+            case 't': out[n++] = '\t'; break;
+            case 'r': out[n++] = '\r'; break;
+            case 'b': out[n++] = '\b'; break;
+            case 'f': out[n++] = '\f'; break;
+            case 'v': out[n++] = '\v'; break;
+
+            case '\r':
+                /* 续行 */
+                if (i < length && body[i] == '\n') i++;
+                break;
+            case '\n':
+                break;
+
+            case 'x': {
+                int high = i < length ? hex_digit_value(body[i]) : -1;
+                int low = i + 1 < length ? hex_digit_value(body[i + 1]) : -1;
+                if (high < 0 || low < 0) return false;
+                n += utf8_encode(out + n, (uint32_t)(high * 16 + low));
+                i += 2;
+                break;
+            }
+
+            case 'u': {
+                size_t used = unicode_escape_value(body + i, length - i, true, &cp);
+                if (used == 0) return false;
+                i += used;
+                /* 高代理项后面紧跟低代理项的转义时合并为一个码点 */
+                if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < length && body[i] == '\\' && body[i + 1] == 'u') {
+                    uint32_t low;
+                    size_t more = unicode_escape_value(body + i + 2, length - i - 2, true, &low);
+                    if (more > 0 && low >= 0xDC00 && low <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        i += 2 + more;
+                    }
+                }
+                n += utf8_encode(out + n, cp);
+                break;
+            }
+
+            default:
+                if (ch >= '0' && ch <= '7') {
+                    /* \0 及传统八进制转义（最大\377） */
+                    cp = (uint32_t)(ch - '0');
+                    int max = ch <= '3' ? 2 : 1;
+                    while (max-- > 0 && i < length && body[i] >= '0' && body[i] <= '7') {
+                        cp = cp * 8 + (uint32_t)(body[i++] - '0');
+                    }
+                    n += utf8_encode(out + n, cp);
+                } else if ((unsigned char)ch == 0xE2 && i + 1 < length &&
+                           (unsigned char)body[i] == 0x80 &&
+                           ((unsigned char)body[i + 1] == 0xA8 || (unsigned char)body[i + 1] == 0xA9)) {
+                    /* U+2028/U+2029续行 */
+                    i += 2;
+                } else {
+                    /* 其他字符（\' \" \\ \8 等）表示字符本身，多字节字符的后续字节随下一段复制 */
+                    out[n++] = ch;
+                }
+                break;
+        }
+    }
+    *out_length = n;
+    return true;
+}
+
+/* ---------- 去重 ---------- */
+
+static uint32_t slot_hash(const void *slot, const void *context) {
+    (void)context;
+    return ((const CookedSlot*)slot)->hash;
+}
+
+bool cooked_intern(CookedStrings *table, const char *body, size_t length,
+                   const char **text, size_t *text_length) {
+    if (length > UINT32_MAX) return false;
+    if (length > table->scratch_capacity) {
+        char *scratch = (char*)realloc(table->scratch, length);
+        if (!scratch) {
+            table->failed = true;
+            return false;
+        }
+        table->scratch = scratch;
+        table->scratch_capacity = length;
+    }
+    size_t n;
+    if (!cooked_decode(body, length, table->scratch, &n)) return false;
+
+    if (!hash_table_reserve((void**)&table->slots, &table->capacity, table->count, sizeof(CookedSlot),
+                            COOKED_INITIAL_SLOTS, slot_hash, NULL)) {
+        table->failed = true;
+        return false;
+    }
+    uint32_t hash = hash_text(table->scratch, n);
+    size_t i = hash & (table->capacity - 1);
+    while (table->slots[i].text) {
+        const CookedSlot *slot = &table->slots[i];
+        if (slot->hash == hash && slot->length == n && memcmp(slot->text, table->scratch, n) == 0) {
+            *text = slot->text;
+            *text_length = n;
+            return true;
+        }
+        i = (i + 1) & (table->capacity - 1);
+    }
+
+    const char *copy = arena_store(&table->text, table->scratch, n);
+    if (!copy) {
+        table->failed = true;
+        return false;
+    }
+    table->slots[i].text = copy;
+    table->slots[i].length = (uint32_t)n;
+    table->slots[i].hash = hash;
+    table->count++;
+    *text = copy;
+    *text_length = n;
+    return true;
+}
+
+bool cooked_string(CookedStrings *table, const char *literal, size_t length,
+                   const char **text, size_t *text_length) {
+    if (length < 2) return false;
+    const char *body = literal + 1;
+    size_t body_length = length - 2;
+    if (!memchr(body, '\\', body_length)) {
+        *text = body;
+        *text_length = body_length;
+        return true;
+    }
+    return cooked_intern(table, body, body_length, text, text_length);
+}
+
+/* ---------- 输出 ---------- */
+
+void cooked_write_json(Writer *writer, const char *text, size_t length) {
+    static const char hex[] = "0123456789abcdef";
+    size_t run = 0;
+
+    writer_byte(writer, '"');
+    for (size_t i = 0; i + 2 < length; i++) {
+        /* WTF-8的代理项：ED A0..BF xx */
+        if ((unsigned char)text[i] != 0xED || (unsigned char)text[i + 1] < 0xA0) continue;
+        uint32_t cp = 0xD000 | (uint32_t)(text[i + 1] & 0x3F) << 6 | (uint32_t)(text[i + 2] & 0x3F);
+        char seq[6] = {'\\', 'u', hex[cp >> 12], hex[(cp >> 8) & 0xF], hex[(cp >> 4) & 0xF], hex[cp & 0xF]};
+        writer_json_escaped(writer, text + run, i - run);
+        writer_write(writer, seq, sizeof(seq));
+        i += 2;
+        run = i + 1;
+    }
+    writer_json_escaped(writer, text + run, length - run);
+    writer_byte(writer, '"');
+}
@@ -0,0 +1,58 @@
+#ifndef COOKED_H
+#define COOKED_H
+
+#include "lexer.h"
+#include "writer.h"
+#include "common.h"
+
+#define COOKED_BLOCK (64u << 10)        /* 解码结果arena的每块大小 */
+#define COOKED_INITIAL_SLOTS 1024       /* 去重哈希表的初始槽数（2的幂） */
+
+/*
+ * 字符串字面量的值（cooked value）。
+ *
+ * 不含反斜杠的字符串（绝大多数）的值就是引号之间的源码：直接返回指向源码的切片，
+ * 不拷贝也不查表。词法分析器用SIMD每次比较16字节，跨过不含引号、反斜杠和换行的一段，
+ * 找到结束引号时已经知道有没有转义。
+ *
+ * 含转义的字符串解码为UTF-8：单字符转义、\xHH、\uXXXX、\u{...}、传统八进制转义，
+ * 相邻的高低代理项合并为一个码点，续行（反斜杠加行终止符）去掉；单独的代理项按WTF-8
+ * 编码为3字节。解码结果不会比源码长。解码后的值按内容去重，相同的值只存一份
+ * （以'\0'结尾，值中可能含'\0'），地址在表销毁前不变，可以按指针比较。
+ *
+ * 一张表不加锁，只给一个线程使用。
+ */
+
+/* 字符串表函数 */
+CookedStrings* cooked_strings_create(void);
+void cooked_strings_destroy(CookedStrings *table);
+
+/* 字面量（含引号）的值；没有转义时指向源码。转义不合法或内存不足（table->failed）时返回false */
+bool cooked_string(CookedStrings *table, const char *literal, size_t length,
+                   const char **text, size_t *text_length);
+
+/* 含转义的字符串内容（不含引号）解码并去重，返回表中的共享存储 */
+bool cooked_intern(CookedStrings *table, const char *body, size_t length,
+                   const char **text, size_t *text_length);
+
+/* 统计：去重后的值的个数、占用的字节数（含'\0'）、内存不足 */
+size_t cooked_strings_count(const CookedStrings *table);
+size_t cooked_strings_bytes(const CookedStrings *table);
+bool cooked_strings_failed(const CookedStrings *table);
+
+/* 解码到out（至少length字节）；转义不合法时返回false */
+bool cooked_decode(const char *body, size_t length, char *out, size_t *out_length);
+
+/* 反斜杠之后的转义序列是否合法（\x要两位十六进制数，\u要4位或{码点}） */
+bool cooked_valid_escape(const char *text, size_t length);
+
+/* 反斜杠之后是否是传统八进制转义（\0后跟数字、\1到\7）或\8、\9：严格模式和模板中不允许 */
+bool cooked_legacy_escape(const char *text, size_t length);
+
+/* 第一个引号quote、反斜杠、\n或\r的下标，没有时返回length */
+size_t cooked_scan(const char *text, size_t length, char quote);
+
+/* 输出JSON字符串，单独的代理项写成\uXXXX */
+void cooked_write_json(Writer *writer, const char *text, size_t length);
+
+#endif /* COOKED_H */
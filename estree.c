@@ -0,0 +1,706 @@
+#include "estree.h"
+#include "lexer.h"
+#include "numeric.h"
+#include "cooked.h"
+
+/* 输出状态 */
+typedef struct {
+    const Ast *ast;
+    const char *source;
+    size_t length;
+    Writer *writer;
+    NumericBigInt bigint;   /* BigInt字面量的值 */
+    CookedStrings *strings; /* 字符串和模板片段的值 */
+    char *scratch;          /* 模板片段规范化换行的缓冲 */
+    size_t scratch_capacity;
+} Emitter;
+
+/* 输出字段名 ,"name": （name必须是字符串常量） */
+#define FIELD(e, name) writer_write((e)->writer, ",\"" name "\":", sizeof(name) + 3)
+
+static void write_node(Emitter *e, uint32_t node);
+
+/* 运算符的源码文本 */
+static const char* operator_text(TokenType type) {
+    switch (type) {
+        case TOKEN_PLUS: return "+";
+        case TOKEN_MINUS: return "-";
+        case TOKEN_MULTIPLY: return "*";
+        case TOKEN_DIVIDE: return "/";
+        case TOKEN_MODULO: return "%";
+        case TOKEN_EXPONENT: return "**";
+        case TOKEN_INCREMENT: return "++";
+        case TOKEN_DECREMENT: return "--";
+        case TOKEN_ASSIGN: return "=";
+        case TOKEN_PLUS_ASSIGN: return "+=";
+        case TOKEN_MINUS_ASSIGN: return "-=";
+        case TOKEN_MULTIPLY_ASSIGN: return "*=";
+        case TOKEN_DIVIDE_ASSIGN: return "/=";
+        case TOKEN_MODULO_ASSIGN: return "%=";
+        case TOKEN_EXPONENT_ASSIGN: return "**=";
+        case TOKEN_LSHIFT_ASSIGN: return "<<=";
+        case TOKEN_RSHIFT_ASSIGN: return ">>=";
+        case TOKEN_URSHIFT_ASSIGN: return ">>>=";
+        case TOKEN_AND_ASSIGN: return "&=";
+        case TOKEN_OR_ASSIGN: return "|=";
+        case TOKEN_XOR_ASSIGN: return "^=";
+        case TOKEN_AND_AND_ASSIGN: return "&&=";
+        case TOKEN_OR_OR_ASSIGN: return "||=";
+        case TOKEN_NULLISH_ASSIGN: return "?\?=";
+        case TOKEN_EQ: return "==";
+        case TOKEN_NE: return "!=";
+        case TOKEN_EQ_STRICT: return "===";
+        case TOKEN_NE_STRICT: return "!==";
+        case TOKEN_LT: return "<";
+        case TOKEN_LE: return "<=";
+        case TOKEN_GT: return ">";
+        case TOKEN_GE: return ">=";
+        case TOKEN_AND: return "&&";
+        case TOKEN_OR: return "||";
+        case TOKEN_NOT: return "!";
+        case TOKEN_NULLISH: return "??";
+        case TOKEN_BITWISE_AND: return "&";
+        case TOKEN_BITWISE_OR: return "|";
+        case TOKEN_BITWISE_XOR: return "^";
+        case TOKEN_BITWISE_NOT: return "~";
+        case TOKEN_LSHIFT: return "<<";
+        case TOKEN_RSHIFT: return ">>";
+        case TOKEN_URSHIFT: return ">>>";
+        case TOKEN_IN: return "in";
+        case TOKEN_INSTANCEOF: return "instanceof";
+        case TOKEN_TYPEOF: return "typeof";
+        case TOKEN_VOID: return "void";
+        case TOKEN_DELETE: return "delete";
+        case TOKEN_VAR: return "var";
+        case TOKEN_LET: return "let";
+        case TOKEN_CONST: return "const";
+        default: return "";
+    }
+}
+
+/* 输出true/false */
+static void write_bool(Emitter *e, bool value) {
+    if (value) {
+        writer_write(e->writer, "true", 4);
+    } else {
+        writer_write(e->writer, "false", 5);
+    }
+}
+
+/* 输出带引号的字符串常量 */
+static void write_quoted(Emitter *e, const char *text) {
+    writer_byte(e->writer, '"');
+    writer_cstr(e->writer, text);
+    writer_byte(e->writer, '"');
+}
+
+/* 输出节点的源码文本（JSON字符串） */
+static void write_source(Emitter *e, const AstNode *n) {
+    size_t end = n->end <= e->length ? n->end : e->length;
+    size_t start = n->start <= end ? n->start : end;
+    writer_json_string(e->writer, e->source + start, end - start);
+}
+
+/* 输出字符串字面量（含引号）的值；转义不合法时为null */
+static void write_string_value(Emitter *e, const char *literal, size_t length) {
+    const char *value;
+    size_t value_length;
+    if (!cooked_string(e->strings, literal, length, &value, &value_length)) {
+        writer_write(e->writer, "null", 4);
+        return;
+    }
+    cooked_write_json(e->writer, value, value_length);
+}
+
+/* 输出模板片段的值：CR和CRLF先按规范规范化为LF，再按字符串的规则解码；
+   转义不合法时为null（带标签的模板允许这种片段） */
+static void write_template_cooked(Emitter *e, const char *text, size_t length) {
+    if (memchr(text, '\r', length)) {
+        if (length > e->scratch_capacity) {
+            char *scratch = (char*)realloc(e->scratch, length);
+            if (!scratch) {
+                e->writer->failed = true;
+                return;
+            }
+            e->scratch = scratch;
+            e->scratch_capacity = length;
+        }
+        size_t n = 0;
+        for (size_t i = 0; i < length; i++) {
+            if (text[i] == '\r') {
+                e->scratch[n++] = '\n';
+                if (i + 1 < length && text[i + 1] == '\n') i++;
+            } else {
+                e->scratch[n++] = text[i];
+            }
+        }
+        text = e->scratch;
+        length = n;
+    }
+
+    const char *value = text;
+    size_t value_length = length;
+    if (memchr(text, '\\', length) && !cooked_intern(e->strings, text, length, &value, &value_length)) {
+        writer_write(e->writer, "null", 4);
+        return;
+    }
+    cooked_write_json(e->writer, value, value_length);
+}
+
+/* 输出模板片段的原始文本（CR和CRLF规范化为LF） */
+static void write_template_raw(Writer *writer, const char *text, size_t length) {
+    size_t run = 0;
+
+    writer_byte(writer, '"');
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] != '\r') continue;
+        writer_json_escaped(writer, text + run, i - run);
+        writer_write(writer, "\\n", 2);
+        if (i + 1 < length && text[i + 1] == '\n') i++;
+        run = i + 1;
+    }
+    writer_json_escaped(writer, text + run, length - run);
+    writer_byte(writer, '"');
+}
+
+/* 源码中的数字是否本身就是合法的JSON数字 */
+static bool is_json_number(const char *text, size_t length) {
+    size_t i = 0;
+
+    if (i < length && text[i] == '0') {
+        i++;
+    } else if (i < length && text[i] >= '1' && text[i] <= '9') {
+        while (i < length && isdigit((unsigned char)text[i])) i++;
+    } else {
+        return false;
+    }
+    if (i < length && text[i] == '.') {
+        size_t digits = ++i;
+        while (i < length && isdigit((unsigned char)text[i])) i++;
+        if (i == digits) return false;
+    }
+    if (i < length && (text[i] == 'e' || text[i] == 'E')) {
+        i++;
+        if (i < length && (text[i] == '+' || text[i] == '-')) i++;
+        size_t digits = i;
+        while (i < length && isdigit((unsigned char)text[i])) i++;
+        if (i == digits) return false;
+    }
+    return i == length;
+}
+
+/* 输出数字字面量的值：源码已是JSON数字时原样输出，否则换算后输出最短的往返表示 */
+static void write_number(Emitter *e, const char *text, size_t length) {
+    char buffer[32];
+    NumericLiteral literal;
+
+    if (is_json_number(text, length)) {
+        writer_write(e->writer, text, length);
+        return;
+    }
+    if (!numeric_value(text, length, &literal) || literal.bigint) {
+        writer_write(e->writer, "null", 4);
+        return;
+    }
+    writer_write(e->writer, buffer, numeric_format_json(literal.value, buffer));
+}
+
+/* 输出字面量的value/raw（以及正则的regex） */
+static void write_literal(Emitter *e, const AstNode *n) {
+    const char *text = e->source + n->start;
+    size_t length = n->end - n->start;
+
+    FIELD(e, "value");
+    switch (n->op) {
+        case TOKEN_NUMBER:
+            write_number(e, text, length);
+            break;
+        case TOKEN_STRING:
+            write_string_value(e, text, length);
+            break;
+        case TOKEN_TRUE:
+            writer_write(e->writer, "true", 4);
+            break;
+        case TOKEN_FALSE:
+            writer_write(e->writer, "false", 5);
+            break;
+        default:
+            writer_write(e->writer, "null", 4);
+            break;
+    }
+
+    FIELD(e, "raw");
+    write_source(e, n);
+
+    if (n->op == TOKEN_NUMBER && length > 0 && text[length - 1] == 'n') {
+        /* BigInt：value为null，bigint为十进制文本 */
+        size_t decimal_length;
+        const char *decimal = numeric_bigint_parse(&e->bigint, text, length)
+                            ? numeric_bigint_decimal(&e->bigint, &decimal_length) : NULL;
+        if (!decimal) {
+            e->writer->failed = true;
+            return;
+        }
+        FIELD(e, "bigint");
+        writer_byte(e->writer, '"');
+        writer_write(e->writer, decimal, decimal_length);
+        writer_byte(e->writer, '"');
+    }
+
+    if (n->op == TOKEN_REGEX) {
+        size_t slash = length;
+        while (slash > 1 && text[slash - 1] != '/') slash--;
+        if (slash < 1) slash = 1;
+
+        FIELD(e, "regex");
+        writer_write(e->writer, "{\"pattern\":", 11);
+        writer_json_string(e->writer, text + 1, slash > 1 ? slash - 2 : 0);
+        writer_write(e->writer, ",\"flags\":", 9);
+        writer_json_string(e->writer, text + slash, length - slash);
+        writer_byte(e->writer, '}');
+    }
+}
+
+/* 输出从first开始、到stop（不含）为止的兄弟节点数组 */
+static void write_list_until(Emitter *e, uint32_t first, uint32_t stop) {
+    bool comma = false;
+
+    writer_byte(e->writer, '[');
+    for (uint32_t child = first; child != stop && child != AST_NONE;
+         child = e->ast->nodes[child].next_sibling) {
+        if (comma) writer_byte(e->writer, ',');
+        write_node(e, child);
+        comma = true;
+    }
+    writer_byte(e->writer, ']');
+}
+
+/* 输出从first开始的全部兄弟节点数组 */
+static void write_list(Emitter *e, uint32_t first) {
+    write_list_until(e, first, AST_NONE);
+}
+
+/* 输出从first开始每隔一个的兄弟节点数组（模板字符串的文字段或表达式） */
+static void write_alternate(Emitter *e, uint32_t child) {
+    bool comma = false;
+
+    writer_byte(e->writer, '[');
+    while (child != AST_NONE) {
+        if (comma) writer_byte(e->writer, ',');
+        write_node(e, child);
+        comma = true;
+        child = e->ast->nodes[child].next_sibling;
+        if (child != AST_NONE) {
+            child = e->ast->nodes[child].next_sibling;
+        }
+    }
+    writer_byte(e->writer, ']');
+}
+
+/* 第index个子节点（不存在时为AST_NONE） */
+static uint32_t child_at(const Emitter *e, uint32_t node, int index) {
+    uint32_t child = e->ast->nodes[node].first_child;
+    while (index-- > 0 && child != AST_NONE) {
+        child = e->ast->nodes[child].next_sibling;
+    }
+    return child;
+}
+
+/* 最后一个子节点 */
+static uint32_t last_child(const Emitter *e, uint32_t node) {
+    uint32_t child = e->ast->nodes[node].first_child;
+    while (child != AST_NONE && e->ast->nodes[child].next_sibling != AST_NONE) {
+        child = e->ast->nodes[child].next_sibling;
+    }
+    return child;
+}
+
+/* 按顺序把前count个子节点输出为指定字段 */
+static void write_children(Emitter *e, uint32_t node, const char *const *names, int count) {
+    uint32_t child = e->ast->nodes[node].first_child;
+    for (int i = 0; i < count; i++) {
+        writer_write(e->writer, ",\"", 2);
+        writer_cstr(e->writer, names[i]);
+        writer_write(e->writer, "\":", 2);
+        write_node(e, child);
+        if (child != AST_NONE) {
+            child = e->ast->nodes[child].next_sibling;
+        }
+    }
+}
+
+/* 输出函数的公共字段（first为参数之前的子节点：函数名或第一个参数） */
+static void write_function(Emitter *e, uint32_t node, bool arrow) {
+    const AstNode *n = &e->ast->nodes[node];
+    uint32_t params = n->first_child;
+    uint32_t body = last_child(e, node);
+
+    FIELD(e, "id");
+    if (arrow) {
+        writer_write(e->writer, "null", 4);
+    } else {
+        write_node(e, params);
+        params = params != AST_NONE ? e->ast->nodes[params].next_sibling : AST_NONE;
+    }
+    FIELD(e, "expression");
+    write_bool(e, (n->flags & AST_FLAG_EXPRESSION) != 0);
+    FIELD(e, "generator");
+    write_bool(e, (n->flags & AST_FLAG_GENERATOR) != 0);
+    FIELD(e, "async");
+    write_bool(e, (n->flags & AST_FLAG_ASYNC) != 0);
+    FIELD(e, "params");
+    write_list_until(e, params, body);
+    FIELD(e, "body");
+    write_node(e, body);
+}
+
+/* 输出一个节点及其子树 */
+static void write_node(Emitter *e, uint32_t node) {
+    static const char *const test_body[] = {"test", "body"};
+    static const char *const body_test[] = {"body", "test"};
+    static const char *const branches[] = {"test", "consequent", "alternate"};
+    static const char *const for_parts[] = {"init", "test", "update", "body"};
+    static const char *const for_in_parts[] = {"left", "right", "body"};
+    static const char *const try_parts[] = {"block", "handler", "finalizer"};
+    static const char *const catch_parts[] = {"param", "body"};
+    static const char *const object_body[] = {"object", "body"};
+    static const char *const declarator[] = {"id", "init"};
+    static const char *const class_parts[] = {"id", "superClass", "body"};
+    static const char *const key_value[] = {"key", "value"};
+    static const char *const left_right[] = {"left", "right"};
+    static const char *const member[] = {"object", "property"};
+    static const char *const argument[] = {"argument"};
+    static const char *const expression[] = {"expression"};
+    static const char *const label[] = {"label"};
+    static const char *const imported_local[] = {"imported", "local"};
+    static const char *const local[] = {"local"};
+    static const char *const local_exported[] = {"local", "exported"};
+    static const char *const declaration[] = {"declaration"};
+    static const char *const declaration_source[] = {"declaration", "source"};
+    static const char *const exported_source[] = {"exported", "source"};
+    static const char *const source_options[] = {"source", "options"};
+    static const char *const meta_property[] = {"meta", "property"};
+
+    Writer *writer = e->writer;
+
+    if (node == AST_NONE || e->ast->nodes[node].kind == AST_NULL) {
+        writer_write(writer, "null", 4);
+        return;
+    }
+
+    const AstNode *n = &e->ast->nodes[node];
+    AstKind kind = (AstKind)n->kind;
+
+    writer_write(writer, "{\"type\":\"", 9);
+    writer_cstr(writer, ast_kind_name(kind));
+    writer_write(writer, "\",\"start\":", 10);
+    writer_uint(writer, n->start);
+    writer_write(writer, ",\"end\":", 7);
+    writer_uint(writer, n->end);
+
+    switch (kind) {
+        case AST_PROGRAM:
+            FIELD(e, "body");
+            write_list(e, n->first_child);
+            FIELD(e, "sourceType");
+            write_quoted(e, (n->flags & AST_FLAG_MODULE) ? "module" : "script");
+            break;
+
+        case AST_BLOCK_STATEMENT:
+        case AST_STATIC_BLOCK:
+        case AST_CLASS_BODY:
+            FIELD(e, "body");
+            write_list(e, n->first_child);
+            break;
+
+        case AST_EXPRESSION_STATEMENT:
+        case AST_CHAIN_EXPRESSION:
+            write_children(e, node, expression, 1);
+            break;
+
+        case AST_VARIABLE_DECLARATION:
+            FIELD(e, "declarations");
+            write_list(e, n->first_child);
+            FIELD(e, "kind");
+            write_quoted(e, operator_text((TokenType)n->op));
+            break;
+
+        case AST_VARIABLE_DECLARATOR:
+            write_children(e, node, declarator, 2);
+            break;
+
+        case AST_FUNCTION_DECLARATION:
+        case AST_FUNCTION_EXPRESSION:
+            write_function(e, node, false);
+            break;
+
+        case AST_ARROW_FUNCTION_EXPRESSION:
+            write_function(e, node, true);
+            break;
+
+        case AST_CLASS_DECLARATION:
+            write_children(e, node, class_parts, 3);
+            break;
+
+        case AST_IF_STATEMENT:
+        case AST_CONDITIONAL_EXPRESSION:
+            write_children(e, node, branches, 3);
+            break;
+
+        case AST_WHILE_STATEMENT:
+            write_children(e, node, test_body, 2);
+            break;
+
+        case AST_DO_WHILE_STATEMENT:
+            write_children(e, node, body_test, 2);
+            break;
+
+        case AST_FOR_STATEMENT:
+            write_children(e, node, for_parts, 4);
+            break;
+
+        case AST_FOR_IN_STATEMENT:
+        case AST_FOR_OF_STATEMENT:
+            write_children(e, node, for_in_parts, 3);
+            if (kind == AST_FOR_OF_STATEMENT) {
+                FIELD(e, "await");
+                write_bool(e, (n->flags & AST_FLAG_ASYNC) != 0);
+            }
+            break;
+
+        case AST_SWITCH_STATEMENT:
+            FIELD(e, "discriminant");
+            write_node(e, n->first_child);
+            FIELD(e, "cases");
+            write_list(e, child_at(e, node, 1));
+            break;
+
+        case AST_SWITCH_CASE:
+            FIELD(e, "test");
+            write_node(e, n->first_child);
+            FIELD(e, "consequent");
+            write_list(e, child_at(e, node, 1));
+            break;
+
+        case AST_RETURN_STATEMENT:
+        case AST_THROW_STATEMENT:
+        case AST_UNARY_EXPRESSION:
+        case AST_SPREAD_ELEMENT:
+        case AST_REST_ELEMENT:
+        case AST_AWAIT_EXPRESSION:
+            if (kind == AST_UNARY_EXPRESSION) {
+                FIELD(e, "operator");
+                write_quoted(e, operator_text((TokenType)n->op));
+                writer_cstr(writer, ",\"prefix\":true");
+            }
+            write_children(e, node, argument, 1);
+            break;
+
+        case AST_YIELD_EXPRESSION:
+            write_children(e, node, argument, 1);
+            FIELD(e, "delegate");
+            write_bool(e, (n->flags & AST_FLAG_DELEGATE) != 0);
+            break;
+
+        case AST_UPDATE_EXPRESSION:
+            FIELD(e, "operator");
+            write_quoted(e, operator_text((TokenType)n->op));
+            FIELD(e, "prefix");
+            write_bool(e, (n->flags & AST_FLAG_PREFIX) != 0);
+            write_children(e, node, argument, 1);
+            break;
+
+        case AST_BREAK_STATEMENT:
+        case AST_CONTINUE_STATEMENT:
+            write_children(e, node, label, 1);
+            break;
+
+        case AST_TRY_STATEMENT:
+            write_children(e, node, try_parts, 3);
+            break;
+
+        case AST_CATCH_CLAUSE:
+            write_children(e, node, catch_parts, 2);
+            break;
+
+        case AST_WITH_STATEMENT:
+            write_children(e, node, object_body, 2);
+            break;
+
+        case AST_IDENTIFIER:
+            FIELD(e, "name");
+            write_source(e, n);
+            break;
+
+        case AST_LITERAL:
+            write_literal(e, n);
+            break;
+
+        case AST_TEMPLATE_LITERAL:
+            /* 子节点为 quasi, expression, quasi, ..., quasi */
+            FIELD(e, "expressions");
+            write_alternate(e, child_at(e, node, 1));
+            FIELD(e, "quasis");
+            write_alternate(e, n->first_child);
+            break;
+
+        case AST_TEMPLATE_ELEMENT:
+            FIELD(e, "value");
+            writer_write(writer, "{\"raw\":", 7);
+            write_template_raw(writer, e->source + n->start, n->end - n->start);
+            writer_write(writer, ",\"cooked\":", 10);
+            write_template_cooked(e, e->source + n->start, n->end - n->start);
+            writer_byte(writer, '}');
+            FIELD(e, "tail");
+            write_bool(e, (n->flags & AST_FLAG_TAIL) != 0);
+            break;
+
+        case AST_THIS_EXPRESSION:
+        case AST_SUPER:
+        case AST_EMPTY_STATEMENT:
+        case AST_DEBUGGER_STATEMENT:
+            break;
+
+        case AST_ARRAY_EXPRESSION:
+        case AST_ARRAY_PATTERN:
+            FIELD(e, "elements");
+            write_list(e, n->first_child);
+            break;
+
+        case AST_OBJECT_EXPRESSION:
+        case AST_OBJECT_PATTERN:
+            FIELD(e, "properties");
+            write_list(e, n->first_child);
+            break;
+
+        case AST_PROPERTY:
+            FIELD(e, "method");
+            write_bool(e, (n->flags & AST_FLAG_METHOD) != 0);
+            FIELD(e, "shorthand");
+            write_bool(e, (n->flags & AST_FLAG_SHORTHAND) != 0);
+            FIELD(e, "computed");
+            write_bool(e, (n->flags & AST_FLAG_COMPUTED) != 0);
+            write_children(e, node, key_value, 2);
+            FIELD(e, "kind");
+            write_quoted(e, (n->flags & AST_FLAG_GETTER) ? "get" :
+                            (n->flags & AST_FLAG_SETTER) ? "set" : "init");
+            break;
+
+        case AST_METHOD_DEFINITION:
+        case AST_PROPERTY_DEFINITION:
+            FIELD(e, "static");
+            write_bool(e, (n->flags & AST_FLAG_STATIC) != 0);
+            FIELD(e, "computed");
+            write_bool(e, (n->flags & AST_FLAG_COMPUTED) != 0);
+            write_children(e, node, key_value, 2);
+            if (kind == AST_METHOD_DEFINITION) {
+                FIELD(e, "kind");
+                write_quoted(e, (n->flags & AST_FLAG_CONSTRUCTOR) ? "constructor" :
+                                (n->flags & AST_FLAG_GETTER) ? "get" :
+                                (n->flags & AST_FLAG_SETTER) ? "set" : "method");
+            }
+            break;
+
+        case AST_BINARY_EXPRESSION:
+        case AST_LOGICAL_EXPRESSION:
+        case AST_ASSIGNMENT_EXPRESSION:
+            FIELD(e, "operator");
+            write_quoted(e, operator_text((TokenType)n->op));
+            write_children(e, node, left_right, 2);
+            break;
+
+        case AST_ASSIGNMENT_PATTERN:
+            write_children(e, node, left_right, 2);
+            break;
+
+        case AST_CALL_EXPRESSION:
+        case AST_NEW_EXPRESSION:
+            FIELD(e, "callee");
+            write_node(e, n->first_child);
+            FIELD(e, "arguments");
+            write_list(e, child_at(e, node, 1));
+            if (kind == AST_CALL_EXPRESSION) {
+                FIELD(e, "optional");
+                write_bool(e, (n->flags & AST_FLAG_OPTIONAL) != 0);
+            }
+            break;
+
+        case AST_MEMBER_EXPRESSION:
+            write_children(e, node, member, 2);
+            FIELD(e, "computed");
+            write_bool(e, (n->flags & AST_FLAG_COMPUTED) != 0);
+            FIELD(e, "optional");
+            write_bool(e, (n->flags & AST_FLAG_OPTIONAL) != 0);
+            break;
+
+        case AST_SEQUENCE_EXPRESSION:
+            FIELD(e, "expressions");
+            write_list(e, n->first_child);
+            break;
+
+        case AST_IMPORT_DECLARATION:
+            FIELD(e, "specifiers");
+            write_list(e, child_at(e, node, 1));
+            FIELD(e, "source");
+            write_node(e, n->first_child);
+            break;
+
+        case AST_IMPORT_SPECIFIER:
+            write_children(e, node, imported_local, 2);
+            break;
+
+        case AST_IMPORT_DEFAULT_SPECIFIER:
+        case AST_IMPORT_NAMESPACE_SPECIFIER:
+            write_children(e, node, local, 1);
+            break;
+
+        case AST_EXPORT_NAMED_DECLARATION:
+            write_children(e, node, declaration_source, 2);
+            FIELD(e, "specifiers");
+            write_list(e, child_at(e, node, 2));
+            break;
+
+        case AST_EXPORT_SPECIFIER:
+            write_children(e, node, local_exported, 2);
+            break;
+
+        case AST_EXPORT_DEFAULT_DECLARATION:
+            write_children(e, node, declaration, 1);
+            break;
+
+        case AST_EXPORT_ALL_DECLARATION:
+            write_children(e, node, exported_source, 2);
+            break;
+
+        case AST_IMPORT_EXPRESSION:
+            write_children(e, node, source_options, 2);
+            break;
+
+        case AST_META_PROPERTY:
+            write_children(e, node, meta_property, 2);
+            break;
+
+        default:
+            break;
+    }
+
+    writer_byte(writer, '}');
+}
+
+/* 把AST输出为ESTree JSON，返回是否成功（AST不完整或输出失败时为false） */
+bool estree_write(const Ast *ast, const char *source, size_t length, Writer *writer) {
+    if (!ast || ast->failed || ast->root == AST_NONE) {
+        return false;
+    }
+
+    Emitter e = {ast, source, length, writer, {0}, cooked_strings_create(), NULL, 0};
+    if (!e.strings) return false;
+    numeric_bigint_init(&e.bigint);
+    write_node(&e, ast->root);
+    numeric_bigint_free(&e.bigint);
+    bool failed = cooked_strings_failed(e.strings);
+    cooked_strings_destroy(e.strings);
+    free(e.scratch);
+    writer_byte(writer, '\n');
+    return !failed && !writer->failed;
+}
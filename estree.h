@@ -0,0 +1,12 @@
+#ifndef ESTREE_H
+#define ESTREE_H
+
+#include "ast.h"
+#include "writer.h"
+#include "common.h"
+
+/* ESTree JSON输出：直接遍历扁平AST写入缓冲输出，不构建中间的JSON对象。
+   source为解析时的源码，标识符名和字面量的值都从节点范围中取出 */
+bool estree_write(const Ast *ast, const char *source, size_t length, Writer *writer);
+
+#endif /* ESTREE_H */
@@ -0,0 +1,1277 @@
+#include "fold.h"
+#include "lexer.h"
+#include "cooked.h"
+#include "numeric.h"
+#include <math.h>
+
+/*
+ * 两遍：
+ * 1. 求值：显式栈上的后序遍历，每个节点由子节点的值算出自己的值；
+ *    条件已知的 ?:、&&、||、??、if、while 记下会执行的子节点。
+ *    只有没有副作用的表达式才有已知的值，所以换成常量或丢掉都不改变行为。
+ * 2. 输出：按源码顺序复制，值已知的节点写成字面量，条件已知的节点只写选中的子节点
+ *    （按优先级和所在位置补括号），语句列表中不可达和被删除的语句连同前面的空白一起跳过。
+ */
+
+#define BRANCH_KEEP AST_NONE            /* 条件未知，原样输出 */
+#define EXPANDED 0x80000000u            /* 求值栈中：子节点已入栈 */
+#define MAX_EXACT_INTEGER 9007199254740992.0    /* 2^53 */
+
+/* 输出位置的约束 */
+#define CONTEXT_LEADING   0x01  /* 表达式语句或箭头函数体的开头：不能以 { function class let 或字符串开始 */
+#define CONTEXT_REFERENCE 0x02  /* 调用的callee、typeof/delete的操作数：不能直接换成引用 */
+
+/* 常量值 */
+typedef enum {
+    VALUE_UNKNOWN,
+    VALUE_UNDEFINED,
+    VALUE_NULL,
+    VALUE_BOOLEAN,
+    VALUE_NUMBER,
+    VALUE_STRING
+} ValueType;
+
+typedef struct {
+    uint8_t type;           /* ValueType */
+    bool boolean;
+    uint32_t length;        /* 字符串的字节数（UTF-8） */
+    union {
+        double number;
+        const char *text;   /* 指向源码或arena */
+    };
+} Value;
+
+/* 每个节点的求值结果 */
+typedef struct {
+    Value value;
+    uint32_t branch;        /* 条件已知时会执行的子节点（while(false)为AST_NULL节点之外的body），否则BRANCH_KEEP */
+} FoldNode;
+
+/* 字符串arena的一块 */
+typedef struct FoldBlock {
+    struct FoldBlock *next;
+    size_t used;
+    size_t size;
+    char data[];
+} FoldBlock;
+
+typedef struct {
+    const Ast *ast;
+    const char *source;
+    size_t length;
+    Writer *writer;
+    FoldStats *stats;
+    CookedStrings *strings; /* 含转义的字符串字面量解码后的值 */
+    FoldNode *nodes;
+    uint32_t *stack;
+    size_t stack_capacity;
+    FoldBlock *blocks;
+    size_t budget;          /* 还能分配的字符串字节数 */
+    uint32_t *names;        /* 删除的代码中var声明的名字（标识符节点） */
+    size_t name_count;
+    size_t name_capacity;
+    size_t cursor;          /* 源码中已经处理到的偏移 */
+    char last;              /* 最后写出的字节 */
+    bool joint;             /* 下一段输出在源码中与上一段不相邻 */
+    bool failed;            /* 内存不足 */
+} Folder;
+
+/* 保证数组还能容纳count个元素 */
+static bool reserve(void **items, size_t *capacity, size_t count, size_t size) {
+    if (count <= *capacity) return true;
+    size_t grown = *capacity ? *capacity * 2 : 64;
+    while (grown < count) grown *= 2;
+    void *resized = realloc(*items, grown * size);
+    if (!resized) return false;
+    *items = resized;
+    *capacity = grown;
+    return true;
+}
+
+static inline const AstNode* node_at(const Folder *f, uint32_t node) {
+    return &f->ast->nodes[node];
+}
+
+static inline uint32_t next_of(const Folder *f, uint32_t node) {
+    return f->ast->nodes[node].next_sibling;
+}
+
+/* ---------- 数值转换 ---------- */
+
+static int digit_value(char ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch >= 'a' && ch <= 'z') return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'Z') return ch - 'A' + 10;
+    return 99;
+}
+
+/* 按进制解析数字串（StringToNumber的0x、0o、0b）：含非法数字时为NaN */
+static double radix_value(const char *text, size_t length, int base) {
+    if (length == 0) return NAN;
+    for (size_t i = 0; i < length; i++) {
+        if (digit_value(text[i]) >= base) return NAN;
+    }
+    return numeric_parse_radix(text, length, base);
+}
+
+/* 数字字面量的值（见numeric.h）；BigInt返回false */
+static bool number_literal(const char *text, size_t length, double *out) {
+    NumericLiteral literal;
+    if (!numeric_value(text, length, &literal) || literal.bigint) return false;
+    *out = literal.value;
+    return true;
+}
+
+/* p处StrWhiteSpaceChar的字节数（不是空白时为0） */
+static size_t space_length(const unsigned char *p, size_t n) {
+    switch (p[0]) {
+        case ' ': case '\t': case '\n': case '\v': case '\f': case '\r':
+            return 1;
+        case 0xC2:      /* U+00A0 */
+            return n >= 2 && p[1] == 0xA0 ? 2 : 0;
+        case 0xE1:      /* U+1680 */
+            return n >= 3 && p[1] == 0x9A && p[2] == 0x80 ? 3 : 0;
+        case 0xE2:      /* U+2000..U+200A、U+2028、U+2029、U+202F、U+205F */
+            if (n < 3) return 0;
+            if (p[1] == 0x80 && (p[2] <= 0x8A || p[2] == 0xA8 || p[2] == 0xA9 || p[2] == 0xAF)) return 3;
+            return p[1] == 0x81 && p[2] == 0x9F ? 3 : 0;
+        case 0xE3:      /* U+3000 */
+            return n >= 3 && p[1] == 0x80 && p[2] == 0x80 ? 3 : 0;
+        case 0xEF:      /* U+FEFF */
+            return n >= 3 && p[1] == 0xBB && p[2] == 0xBF ? 3 : 0;
+        default:
+            return 0;
+    }
+}
+
+/* 字符串的ToNumber（不是数字的字符串为NaN） */
+static bool string_to_number(const char *text, size_t length, double *out) {
+    const unsigned char *p = (const unsigned char*)text;
+    size_t start = 0, end, w;
+    while (start < length && (w = space_length(p + start, length - start)) > 0) start += w;
+    end = start;
+    for (size_t i = start; i < length; ) {
+        w = space_length(p + i, length - i);
+        if (w > 0) {
+            i += w;
+        } else {
+            end = ++i;
+        }
+    }
+    if (end == start) {
+        *out = 0;
+        return true;
+    }
+    text += start;
+    length = end - start;
+
+    if (length > 2 && text[0] == '0' && strchr("xXoObB", text[1])) {
+        int base = (text[1] == 'x' || text[1] == 'X') ? 16 :
+                   (text[1] == 'o' || text[1] == 'O') ? 8 : 2;
+        *out = radix_value(text + 2, length - 2, base);
+        return true;
+    }
+
+    size_t i = 0;
+    bool negative = text[0] == '-';
+    if (text[0] == '+' || text[0] == '-') i++;
+    if (length - i == 8 && memcmp(text + i, "Infinity", 8) == 0) {
+        *out = negative ? -INFINITY : INFINITY;
+        return true;
+    }
+
+    /* StrDecimalLiteral：digits [. digits] [e [+-] digits]，小数点两边至少有一个数字 */
+    size_t digits = 0;
+    while (i < length && isdigit((unsigned char)text[i])) i++, digits++;
+    if (i < length && text[i] == '.') {
+        i++;
+        while (i < length && isdigit((unsigned char)text[i])) i++, digits++;
+    }
+    bool valid = digits > 0;
+    if (valid && i < length && (text[i] == 'e' || text[i] == 'E')) {
+        i++;
+        if (i < length && (text[i] == '+' || text[i] == '-')) i++;
+        size_t exponent = i;
+        while (i < length && isdigit((unsigned char)text[i])) i++;
+        valid = i > exponent;
+    }
+    if (!valid || i != length) {
+        *out = NAN;
+        return true;
+    }
+
+    size_t sign = (text[0] == '+' || text[0] == '-') ? 1 : 0;
+    double value = numeric_parse_decimal(text + sign, length - sign);
+    *out = negative ? -value : value;
+    return true;
+}
+
+/* Number::toString(10)：能还原为同一个double的最短十进制表示，按JS的规则选择记法 */
+static size_t number_to_string(double value, char *buffer) {
+    if (isnan(value)) {
+        memcpy(buffer, "NaN", 4);
+        return 3;
+    }
+    if (value == 0) {
+        memcpy(buffer, "0", 2);
+        return 1;
+    }
+
+    size_t n = 0;
+    if (value < 0) {
+        buffer[n++] = '-';
+        value = -value;
+    }
+    if (isinf(value)) {
+        memcpy(buffer + n, "Infinity", 9);
+        return n + 8;
+    }
+    if (value < MAX_EXACT_INTEGER && value == floor(value)) {
+        return n + (size_t)sprintf(buffer + n, "%.0f", value);
+    }
+
+    char text[40];
+    for (int precision = 1; precision <= 17; precision++) {
+        snprintf(text, sizeof(text), "%.*e", precision - 1, value);
+        if (strtod(text, NULL) == value) break;
+    }
+
+    /* text形如 d.ddde±x */
+    char digits[24];
+    int k = 0;
+    const char *p = text;
+    for (; *p != 'e'; p++) {
+        if (*p != '.') digits[k++] = *p;
+    }
+    while (k > 1 && digits[k - 1] == '0') k--;
+    int point = atoi(p + 1) + 1;    /* 小数点在第point个数字之后 */
+
+    if (k <= point && point <= 21) {
+        memcpy(buffer + n, digits, (size_t)k);
+        n += (size_t)k;
+        for (int i = k; i < point; i++) buffer[n++] = '0';
+    } else if (0 < point && point <= 21) {
+        memcpy(buffer + n, digits, (size_t)point);
+        n += (size_t)point;
+        buffer[n++] = '.';
+        memcpy(buffer + n, digits + point, (size_t)(k - point));
+        n += (size_t)(k - point);
+    } else if (-6 < point && point <= 0) {
+        buffer[n++] = '0';
+        buffer[n++] = '.';
+        for (int i = point; i < 0; i++) buffer[n++] = '0';
+        memcpy(buffer + n, digits, (size_t)k);
+        n += (size_t)k;
+    } else {
+        buffer[n++] = digits[0];
+        if (k > 1) {
+            buffer[n++] = '.';
+            memcpy(buffer + n, digits + 1, (size_t)(k - 1));
+            n += (size_t)(k - 1);
+        }
+        n += (size_t)sprintf(buffer + n, "e%c%d", point - 1 >= 0 ? '+' : '-', abs(point - 1));
+    }
+    buffer[n] = '\0';
+    return n;
+}
+
+/* ToInt32 */
+static int32_t to_int32(double value) {
+    if (!isfinite(value)) return 0;
+    value = fmod(trunc(value), 4294967296.0);
+    if (value < 0) value += 4294967296.0;
+    return (int32_t)(uint32_t)value;
+}
+
+/* ---------- 值的运算 ---------- */
+
+static inline Value make_number(double number) {
+    Value v = {0};
+    v.type = VALUE_NUMBER;
+    v.number = number;
+    return v;
+}
+
+static inline Value make_boolean(bool boolean) {
+    Value v = {0};
+    v.type = VALUE_BOOLEAN;
+    v.boolean = boolean;
+    return v;
+}
+
+static inline Value make_string(const char *text, size_t length) {
+    Value v = {0};
+    v.type = VALUE_STRING;
+    v.text = text;
+    v.length = (uint32_t)length;
+    return v;
+}
+
+static bool to_number(const Value *v, double *out) {
+    switch (v->type) {
+        case VALUE_UNDEFINED: *out = NAN; return true;
+        case VALUE_NULL: *out = 0; return true;
+        case VALUE_BOOLEAN: *out = v->boolean; return true;
+        case VALUE_NUMBER: *out = v->number; return true;
+        case VALUE_STRING: return string_to_number(v->text, v->length, out);
+        default: return false;
+    }
+}
+
+/* ToBoolean（v的值已知） */
+static bool to_boolean(const Value *v) {
+    switch (v->type) {
+        case VALUE_BOOLEAN: return v->boolean;
+        case VALUE_NUMBER: return v->number != 0 && !isnan(v->number);
+        case VALUE_STRING: return v->length > 0;
+        default: return false;
+    }
+}
+
+/* ToString；数字写在buffer中（至少40字节） */
+static bool to_string(const Value *v, char *buffer, const char **text, size_t *length) {
+    switch (v->type) {
+        case VALUE_UNDEFINED: *text = "undefined"; *length = 9; return true;
+        case VALUE_NULL: *text = "null"; *length = 4; return true;
+        case VALUE_BOOLEAN:
+            *text = v->boolean ? "true" : "false";
+            *length = v->boolean ? 4 : 5;
+            return true;
+        case VALUE_NUMBER:
+            *length = number_to_string(v->number, buffer);
+            *text = buffer;
+            return true;
+        case VALUE_STRING: *text = v->text; *length = v->length; return true;
+        default: return false;
+    }
+}
+
+/* 在arena中分配size字节；超出预算时返回NULL（不是错误） */
+static char* string_alloc(Folder *f, size_t size) {
+    if (size > f->budget) return NULL;
+    FoldBlock *block = f->blocks;
+    if (!block || block->size - block->used < size) {
+        /* 新块至少是这次的两倍，之后的原地追加均摊为线性 */
+        size_t capacity = size * 2 > FOLD_ARENA_BLOCK ? size * 2 : FOLD_ARENA_BLOCK;
+        block = (FoldBlock*)malloc(sizeof(FoldBlock) + capacity);
+        if (!block) {
+            f->failed = true;
+            return NULL;
+        }
+        block->next = f->blocks;
+        block->used = 0;
+        block->size = capacity;
+        f->blocks = block;
+    }
+    char *data = block->data + block->used;
+    block->used += size;
+    f->budget -= size;
+    return data;
+}
+
+/* 字符串拼接；左边正好是arena中最后分配的内容时原地追加（"a" + b + "c" + ... 的链） */
+static Value concat(Folder *f, const char *a, size_t a_length, const char *b, size_t b_length) {
+    Value unknown = {0};
+    if (a_length + b_length > UINT32_MAX) return unknown;
+
+    FoldBlock *block = f->blocks;
+    if (block && a_length > 0 && a + a_length == block->data + block->used &&
+        block->size - block->used >= b_length && b_length <= f->budget) {
+        memcpy(block->data + block->used, b, b_length);
+        block->used += b_length;
+        f->budget -= b_length;
+        return make_string(a, a_length + b_length);
+    }
+
+    char *data = string_alloc(f, a_length + b_length);
+    if (!data) return unknown;
+    memcpy(data, a, a_length);
+    memcpy(data + a_length, b, b_length);
+    return make_string(data, a_length + b_length);
+}
+
+static bool strict_equal(const Value *a, const Value *b) {
+    if (a->type != b->type) return false;
+    switch (a->type) {
+        case VALUE_BOOLEAN: return a->boolean == b->boolean;
+        case VALUE_NUMBER: return a->number == b->number;
+        case VALUE_STRING: return a->length == b->length && memcmp(a->text, b->text, a->length) == 0;
+        default: return true;
+    }
+}
+
+/* 宽松相等（IsLooselyEqual，只有原始值）；结果未知时返回false */
+static bool loose_equal(const Value *a, const Value *b, bool *out) {
+    if (a->type == b->type) {
+        *out = strict_equal(a, b);
+        return true;
+    }
+    bool a_nullish = a->type == VALUE_NULL || a->type == VALUE_UNDEFINED;
+    bool b_nullish = b->type == VALUE_NULL || b->type == VALUE_UNDEFINED;
+    if (a_nullish || b_nullish) {
+        *out = a_nullish && b_nullish;
+        return true;
+    }
+    /* 剩下数字、字符串、布尔之间的比较都转成数字 */
+    double x, y;
+    if (!to_number(a, &x) || !to_number(b, &y)) return false;
+    *out = x == y;
+    return true;
+}
+
+/* 字符串中没有U+E000以上的字符时，UTF-8字节序与UTF-16码元序相同 */
+static bool utf16_ordered(const Value *v) {
+    for (uint32_t i = 0; i < v->length; i++) {
+        if ((unsigned char)v->text[i] >= 0xEE) return false;
+    }
+    return true;
+}
+
+/* IsLessThan：1为真、0为假、-1为undefined（有NaN），-2为结果未知 */
+static int less_than(const Value *a, const Value *b) {
+    if (a->type == VALUE_STRING && b->type == VALUE_STRING) {
+        if (!utf16_ordered(a) || !utf16_ordered(b)) return -2;
+        uint32_t common = a->length < b->length ? a->length : b->length;
+        int order = memcmp(a->text, b->text, common);
+        return order != 0 ? order < 0 : a->length < b->length;
+    }
+    double x, y;
+    if (!to_number(a, &x) || !to_number(b, &y)) return -2;
+    if (isnan(x) || isnan(y)) return -1;
+    return x < y;
+}
+
+/* 只在结果精确时计算 x ** y：整数的非负整数次幂且不超过2^53 */
+static bool exponent_value(double x, double y, double *out) {
+    if (y == 0) {
+        *out = 1;
+        return true;
+    }
+    if (isnan(y) || (isnan(x) && y != 0)) {
+        *out = NAN;
+        return true;
+    }
+    if (x != floor(x) || y != floor(y) || y < 0 || y > 64 || fabs(x) > MAX_EXACT_INTEGER) return false;
+    double result = 1;
+    for (int i = 0; i < (int)y; i++) {
+        result *= x;
+        if (fabs(result) > MAX_EXACT_INTEGER) return false;
+    }
+    *out = result;
+    return true;
+}
+
+static Value binary_value(Folder *f, int op, const Value *a, const Value *b) {
+    Value unknown = {0};
+    double x, y, result;
+    bool equal;
+    int order;
+
+    switch (op) {
+        case TOKEN_PLUS:
+            if (a->type == VALUE_STRING || b->type == VALUE_STRING) {
+                char a_buffer[40], b_buffer[40];
+                const char *a_text, *b_text;
+                size_t a_length, b_length;
+                if (!to_string(a, a_buffer, &a_text, &a_length) ||
+                    !to_string(b, b_buffer, &b_text, &b_length)) {
+                    return unknown;
+                }
+                return concat(f, a_text, a_length, b_text, b_length);
+            }
+            if (!to_number(a, &x) || !to_number(b, &y)) return unknown;
+            return make_number(x + y);
+
+        case TOKEN_MINUS:
+        case TOKEN_MULTIPLY:
+        case TOKEN_DIVIDE:
+        case TOKEN_MODULO:
+        case TOKEN_EXPONENT:
+            if (!to_number(a, &x) || !to_number(b, &y)) return unknown;
+            switch (op) {
+                case TOKEN_MINUS: result = x - y; break;
+                case TOKEN_MULTIPLY: result = x * y; break;
+                case TOKEN_DIVIDE: result = x / y; break;
+                case TOKEN_MODULO: result = fmod(x, y); break;
+                default:
+                    if (!exponent_value(x, y, &result)) return unknown;
+                    break;
+            }
+            return make_number(result);
+
+        case TOKEN_BITWISE_AND:
+        case TOKEN_BITWISE_OR:
+        case TOKEN_BITWISE_XOR:
+        case TOKEN_LSHIFT:
+        case TOKEN_RSHIFT:
+        case TOKEN_URSHIFT: {
+            if (!to_number(a, &x) || !to_number(b, &y)) return unknown;
+            int32_t l = to_int32(x);
+            uint32_t shift = (uint32_t)to_int32(y) & 31;
+            switch (op) {
+                case TOKEN_BITWISE_AND: return make_number(l & to_int32(y));
+                case TOKEN_BITWISE_OR: return make_number(l | to_int32(y));
+                case TOKEN_BITWISE_XOR: return make_number(l ^ to_int32(y));
+                case TOKEN_LSHIFT: return make_number((int32_t)((uint32_t)l << shift));
+                case TOKEN_RSHIFT: return make_number(l >> shift);
+                default: return make_number((uint32_t)l >> shift);
+            }
+        }
+
+        case TOKEN_EQ_STRICT:
+            return make_boolean(strict_equal(a, b));
+        case TOKEN_NE_STRICT:
+            return make_boolean(!strict_equal(a, b));
+        case TOKEN_EQ:
+        case TOKEN_NE:
+            if (!loose_equal(a, b, &equal)) return unknown;
+            return make_boolean(op == TOKEN_EQ ? equal : !equal);
+
+        case TOKEN_LT:
+        case TOKEN_GE:
+            order = less_than(a, b);
+            if (order == -2) return unknown;
+            return make_boolean(op == TOKEN_LT ? order == 1 : order == 0);
+        case TOKEN_GT:
+        case TOKEN_LE:
+            order = less_than(b, a);
+            if (order == -2) return unknown;
+            return make_boolean(op == TOKEN_GT ? order == 1 : order == 0);
+
+        default:
+            return unknown;
+    }
+}
+
+static Value unary_value(int op, const Value *a) {
+    Value unknown = {0};
+    double x;
+
+    switch (op) {
+        case TOKEN_MINUS:
+            if (!to_number(a, &x)) return unknown;
+            return make_number(-x);
+        case TOKEN_PLUS:
+            if (!to_number(a, &x)) return unknown;
+            return make_number(x);
+        case TOKEN_BITWISE_NOT:
+            if (!to_number(a, &x)) return unknown;
+            return make_number(~to_int32(x));
+        case TOKEN_NOT:
+            return make_boolean(!to_boolean(a));
+        case TOKEN_TYPEOF:
+            switch (a->type) {
+                case VALUE_UNDEFINED: return make_string("undefined", 9);
+                case VALUE_NULL: return make_string("object", 6);
+                case VALUE_BOOLEAN: return make_string("boolean", 7);
+                case VALUE_NUMBER: return make_string("number", 6);
+                default: return make_string("string", 6);
+            }
+        case TOKEN_VOID: {
+            Value v = {0};
+            v.type = VALUE_UNDEFINED;
+            return v;
+        }
+        default:
+            return unknown;
+    }
+}
+
+/* ---------- 求值 ---------- */
+
+static Value literal_value(Folder *f, const AstNode *n) {
+    Value v = {0};
+    const char *text = f->source + n->start;
+    size_t length = n->end - n->start;
+
+    switch (n->op) {
+        case TOKEN_NUMBER:
+            if (number_literal(text, length, &v.number)) v.type = VALUE_NUMBER;
+            break;
+        case TOKEN_STRING: {
+            const char *value;
+            size_t value_length;
+            if (cooked_string(f->strings, text, length, &value, &value_length) && value_length <= UINT32_MAX) {
+                v = make_string(value, value_length);
+            }
+            break;
+        }
+        case TOKEN_TRUE:
+        case TOKEN_FALSE:
+            v = make_boolean(n->op == TOKEN_TRUE);
+            break;
+        case TOKEN_NULL:
+            v.type = VALUE_NULL;
+            break;
+        default:
+            break;
+    }
+    return v;
+}
+
+/* 模板字符串：子节点为 quasi, expression, quasi, ..., quasi，各段原文没有转义和\r时才折叠 */
+static Value template_value(Folder *f, uint32_t node) {
+    Value unknown = {0};
+    Value result = make_string("", 0);
+    bool quasi = true;
+    for (uint32_t child = node_at(f, node)->first_child; child != AST_NONE; child = next_of(f, child)) {
+        const AstNode *c = node_at(f, child);
+        char buffer[40];
+        const char *text;
+        size_t length;
+        if (quasi) {
+            text = f->source + c->start;
+            length = c->end - c->start;
+            if (memchr(text, '\\', length) || memchr(text, '\r', length)) return unknown;
+        } else if (!to_string(&f->nodes[child].value, buffer, &text, &length)) {
+            return unknown;
+        }
+        /* 数字转成的文本在栈上，要复制到arena */
+        result = result.length == 0 && text != buffer ? make_string(text, length)
+                                                      : concat(f, result.text, result.length, text, length);
+        if (result.type == VALUE_UNKNOWN) return unknown;
+        quasi = !quasi;
+    }
+    return result;
+}
+
+static void evaluate_node(Folder *f, uint32_t node) {
+    const AstNode *n = node_at(f, node);
+    FoldNode *fn = &f->nodes[node];
+    uint32_t first = n->first_child;
+
+    switch (n->kind) {
+        case AST_LITERAL:
+            fn->value = literal_value(f, n);
+            break;
+
+        case AST_TEMPLATE_LITERAL:
+            fn->value = template_value(f, node);
+            break;
+
+        case AST_UNARY_EXPRESSION:
+            if (f->nodes[first].value.type != VALUE_UNKNOWN) {
+                fn->value = unary_value(n->op, &f->nodes[first].value);
+            }
+            break;
+
+        case AST_BINARY_EXPRESSION: {
+            const Value *a = &f->nodes[first].value;
+            const Value *b = &f->nodes[next_of(f, first)].value;
+            if (a->type != VALUE_UNKNOWN && b->type != VALUE_UNKNOWN) {
+                fn->value = binary_value(f, n->op, a, b);
+            }
+            break;
+        }
+
+        case AST_LOGICAL_EXPRESSION: {
+            const Value *a = &f->nodes[first].value;
+            if (a->type == VALUE_UNKNOWN) break;
+            bool right = n->op == TOKEN_AND ? to_boolean(a) :
+                         n->op == TOKEN_OR ? !to_boolean(a) :
+                         a->type == VALUE_NULL || a->type == VALUE_UNDEFINED;
+            fn->branch = right ? next_of(f, first) : first;
+            fn->value = f->nodes[fn->branch].value;
+            break;
+        }
+
+        case AST_CONDITIONAL_EXPRESSION:
+        case AST_IF_STATEMENT: {
+            const Value *test = &f->nodes[first].value;
+            if (test->type == VALUE_UNKNOWN) break;
+            uint32_t consequent = next_of(f, first);
+            fn->branch = to_boolean(test) ? consequent : next_of(f, consequent);
+            if (n->kind == AST_CONDITIONAL_EXPRESSION) fn->value = f->nodes[fn->branch].value;
+            break;
+        }
+
+        case AST_WHILE_STATEMENT: {
+            /* while(false)：不执行body，branch指向test（输出时整条删除） */
+            const Value *test = &f->nodes[first].value;
+            if (test->type != VALUE_UNKNOWN && !to_boolean(test)) fn->branch = first;
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+/* 后序遍历：子节点的值都求出后再求父节点 */
+static bool evaluate(Folder *f) {
+    size_t depth = 0;
+    if (f->ast->count >= EXPANDED ||
+        !reserve((void**)&f->stack, &f->stack_capacity, 1, sizeof(uint32_t))) {
+        return false;
+    }
+    f->stack[depth++] = f->ast->root;
+
+    while (depth > 0) {
+        uint32_t item = f->stack[--depth];
+        if (item & EXPANDED) {
+            evaluate_node(f, item & ~EXPANDED);
+            continue;
+        }
+        f->stack[depth++] = item | EXPANDED;
+        for (uint32_t child = node_at(f, item)->first_child; child != AST_NONE; child = next_of(f, child)) {
+            if (!reserve((void**)&f->stack, &f->stack_capacity, depth + 1, sizeof(uint32_t))) {
+                return false;
+            }
+            f->stack[depth++] = child;
+        }
+    }
+    return true;
+}
+
+/* ---------- 输出 ---------- */
+
+static inline bool is_word_byte(char ch) {
+    return isalnum((unsigned char)ch) || ch == '_' || ch == '$' || (unsigned char)ch >= 0x80;
+}
+
+/* 写出一段文本；与上一段在源码中不相邻时，避免两个token连在一起（typeof x、a - -1） */
+static void out(Folder *f, const char *text, size_t length) {
+    if (length == 0) return;
+    if (f->joint) {
+        char a = f->last, b = text[0];
+        if ((is_word_byte(a) && is_word_byte(b)) || ((a == '+' || a == '-') && a == b) ||
+            (a == '/' && (b == '/' || b == '*'))) {
+            writer_byte(f->writer, ' ');
+        }
+        f->joint = false;
+    }
+    writer_write(f->writer, text, length);
+    f->last = text[length - 1];
+}
+
+static inline void out_cstr(Folder *f, const char *text) {
+    out(f, text, strlen(text));
+}
+
+/* 复制源码到position */
+static void copy_to(Folder *f, size_t position) {
+    if (position > f->cursor) {
+        out(f, f->source + f->cursor, position - f->cursor);
+        f->cursor = position;
+    }
+}
+
+/* 跳过源码到position */
+static void skip_to(Folder *f, size_t position) {
+    f->cursor = position;
+    f->joint = true;
+}
+
+static void write_string(Folder *f, const char *text, size_t length) {
+    size_t doubles = 0, singles = 0;
+    for (size_t i = 0; i < length; i++) {
+        doubles += text[i] == '"';
+        singles += text[i] == '\'';
+    }
+    char quote = doubles > singles ? '\'' : '"';
+
+    out(f, &quote, 1);
+    size_t run = 0;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char ch = (unsigned char)text[i];
+        bool surrogate = ch == 0xED && i + 2 < length && (unsigned char)text[i + 1] >= 0xA0;
+        if (ch >= 0x20 && ch != '\\' && ch != (unsigned char)quote && !surrogate) continue;
+
+        char escape[8];
+        out(f, text + run, i - run);
+        run = i + 1;
+        if (surrogate) {
+            /* 单独的代理项（WTF-8）只能写成转义 */
+            unsigned unit = 0xD000 | (unsigned)(text[i + 1] & 0x3F) << 6 | (unsigned)(text[i + 2] & 0x3F);
+            snprintf(escape, sizeof(escape), "\\u%04X", unit);
+            out_cstr(f, escape);
+            i += 2;
+            run = i + 1;
+        } else if (ch == '\n') {
+            out_cstr(f, "\\n");
+        } else if (ch == '\t') {
+            out_cstr(f, "\\t");
+        } else if (ch < 0x20) {
+            snprintf(escape, sizeof(escape), "\\x%02X", ch);
+            out_cstr(f, escape);
+        } else {
+            escape[0] = '\\';
+            escape[1] = (char)ch;
+            out(f, escape, 2);
+        }
+    }
+    out(f, text + run, length - run);
+    out(f, &quote, 1);
+}
+
+/* 能写成字面量的值（NaN和Infinity是可以被遮蔽的全局名字，不写） */
+static bool representable(const Value *v) {
+    return v->type != VALUE_UNKNOWN && (v->type != VALUE_NUMBER || isfinite(v->number));
+}
+
+static void write_value(Folder *f, const Value *v) {
+    char buffer[40];
+    switch (v->type) {
+        case VALUE_UNDEFINED: out_cstr(f, "void 0"); break;
+        case VALUE_NULL: out_cstr(f, "null"); break;
+        case VALUE_BOOLEAN: out_cstr(f, v->boolean ? "true" : "false"); break;
+        case VALUE_NUMBER:
+            if (v->number == 0 && signbit(v->number)) {
+                out_cstr(f, "-0");
+            } else {
+                out(f, buffer, number_to_string(v->number, buffer));
+            }
+            break;
+        default:
+            write_string(f, v->text, v->length);
+            break;
+    }
+}
+
+/* 节点是否换成字面量：字面量本身、-1、void 0 这样已经最简的不换 */
+static bool replaceable(const Folder *f, uint32_t node) {
+    const AstNode *n = node_at(f, node);
+    if (!representable(&f->nodes[node].value)) return false;
+    switch (n->kind) {
+        case AST_UNARY_EXPRESSION:
+            return !((n->op == TOKEN_MINUS || n->op == TOKEN_VOID) &&
+                     node_at(f, n->first_child)->kind == AST_LITERAL);
+        case AST_TEMPLATE_LITERAL:
+            return n->first_child != AST_NONE && next_of(f, n->first_child) != AST_NONE;
+        case AST_BINARY_EXPRESSION:
+        case AST_LOGICAL_EXPRESSION:
+        case AST_CONDITIONAL_EXPRESSION:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* 表达式的优先级（越大结合越紧） */
+static int precedence(const AstNode *n) {
+    switch (n->kind) {
+        case AST_SEQUENCE_EXPRESSION:
+            return 0;
+        case AST_ASSIGNMENT_EXPRESSION:
+        case AST_ARROW_FUNCTION_EXPRESSION:
+            return 1;
+        case AST_CONDITIONAL_EXPRESSION:
+            return 2;
+        case AST_LOGICAL_EXPRESSION:
+            return n->op == TOKEN_AND ? 4 : 3;
+        case AST_BINARY_EXPRESSION:
+            switch (n->op) {
+                case TOKEN_BITWISE_OR: return 5;
+                case TOKEN_BITWISE_XOR: return 6;
+                case TOKEN_BITWISE_AND: return 7;
+                case TOKEN_EQ: case TOKEN_NE: case TOKEN_EQ_STRICT: case TOKEN_NE_STRICT: return 8;
+                case TOKEN_LSHIFT: case TOKEN_RSHIFT: case TOKEN_URSHIFT: return 10;
+                case TOKEN_PLUS: case TOKEN_MINUS: return 11;
+                case TOKEN_MULTIPLY: case TOKEN_DIVIDE: case TOKEN_MODULO: return 12;
+                case TOKEN_EXPONENT: return 13;
+                default: return 9;     /* < > <= >= in instanceof */
+            }
+        case AST_UNARY_EXPRESSION:
+            return 14;
+        case AST_UPDATE_EXPRESSION:
+            return 15;
+        default:
+            return 16;
+    }
+}
+
+static bool starts_with_word(const char *text, size_t length, const char *word) {
+    size_t n = strlen(word);
+    return length >= n && memcmp(text, word, n) == 0 && (length == n || !is_word_byte(text[n]));
+}
+
+/* 放在语句开头会被读成别的东西：块、函数/类声明、let声明或指令 */
+static bool ambiguous_start(const Folder *f, const AstNode *n) {
+    const char *text = f->source + n->start;
+    size_t length = f->length - n->start;
+    return text[0] == '{' || text[0] == '"' || text[0] == '\'' ||
+           starts_with_word(text, length, "function") || starts_with_word(text, length, "class") ||
+           starts_with_word(text, length, "let") || starts_with_word(text, length, "async");
+}
+
+/* offset之前（跳过空白）是不是 ( */
+static bool after_paren(const Folder *f, size_t offset) {
+    while (offset > 0 && isspace((unsigned char)f->source[offset - 1])) offset--;
+    return offset > 0 && f->source[offset - 1] == '(';
+}
+
+static bool is_statement(AstKind kind) {
+    switch (kind) {
+        case AST_EXPRESSION_STATEMENT:
+        case AST_BLOCK_STATEMENT:
+        case AST_EMPTY_STATEMENT:
+        case AST_VARIABLE_DECLARATION:
+        case AST_FUNCTION_DECLARATION:
+        case AST_CLASS_DECLARATION:
+        case AST_IF_STATEMENT:
+        case AST_WHILE_STATEMENT:
+        case AST_DO_WHILE_STATEMENT:
+        case AST_FOR_STATEMENT:
+        case AST_FOR_IN_STATEMENT:
+        case AST_FOR_OF_STATEMENT:
+        case AST_SWITCH_STATEMENT:
+        case AST_RETURN_STATEMENT:
+        case AST_BREAK_STATEMENT:
+        case AST_CONTINUE_STATEMENT:
+        case AST_THROW_STATEMENT:
+        case AST_TRY_STATEMENT:
+        case AST_WITH_STATEMENT:
+        case AST_DEBUGGER_STATEMENT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* 不可达时也要保留的语句：提升的函数声明、模块的import/export，
+   let/const/class（保留TDZ，提升的函数中引用它们仍然报错），以及已经没有初值的var */
+static bool hoisted(const Folder *f, const AstNode *n) {
+    switch (n->kind) {
+        case AST_FUNCTION_DECLARATION:
+        case AST_CLASS_DECLARATION:
+        case AST_IMPORT_DECLARATION:
+        case AST_EXPORT_NAMED_DECLARATION:
+        case AST_EXPORT_DEFAULT_DECLARATION:
+        case AST_EXPORT_ALL_DECLARATION:
+            return true;
+        case AST_VARIABLE_DECLARATION:
+            if (n->op != TOKEN_VAR) return true;
+            for (uint32_t d = n->first_child; d != AST_NONE; d = next_of(f, d)) {
+                uint32_t id = node_at(f, d)->first_child;
+                uint32_t init = next_of(f, id);
+                if (node_at(f, id)->kind != AST_IDENTIFIER ||
+                    (init != AST_NONE && node_at(f, init)->kind != AST_NULL)) {
+                    return false;
+                }
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void add_name(Folder *f, uint32_t node) {
+    if (!reserve((void**)&f->names, &f->name_capacity, f->name_count + 1, sizeof(uint32_t))) {
+        f->failed = true;
+        return;
+    }
+    f->names[f->name_count++] = node;
+}
+
+/* 绑定模式中的名字 */
+static void collect_pattern(Folder *f, uint32_t node) {
+    const AstNode *n = node_at(f, node);
+    switch (n->kind) {
+        case AST_IDENTIFIER:
+            add_name(f, node);
+            break;
+        case AST_ARRAY_PATTERN:
+            for (uint32_t child = n->first_child; child != AST_NONE; child = next_of(f, child)) {
+                collect_pattern(f, child);
+            }
+            break;
+        case AST_OBJECT_PATTERN:
+            for (uint32_t child = n->first_child; child != AST_NONE; child = next_of(f, child)) {
+                const AstNode *c = node_at(f, child);
+                uint32_t value = c->kind == AST_PROPERTY ? next_of(f, c->first_child) : child;
+                if (value == AST_NONE || node_at(f, value)->kind == AST_NULL) value = c->first_child;
+                collect_pattern(f, value);
+            }
+            break;
+        case AST_ASSIGNMENT_PATTERN:
+        case AST_REST_ELEMENT:
+            collect_pattern(f, n->first_child);
+            break;
+        default:
+            break;
+    }
+}
+
+/* 收集要删除的代码中var声明的名字（不进入函数和类） */
+static void collect_vars(Folder *f, uint32_t root) {
+    f->name_count = 0;
+    if (root == AST_NONE) return;
+
+    size_t depth = 0;
+    f->stack[depth++] = root;
+    while (depth > 0 && !f->failed) {
+        uint32_t node = f->stack[--depth];
+        const AstNode *n = node_at(f, node);
+        switch (n->kind) {
+            case AST_FUNCTION_DECLARATION:
+            case AST_FUNCTION_EXPRESSION:
+            case AST_ARROW_FUNCTION_EXPRESSION:
+            case AST_CLASS_DECLARATION:
+            case AST_CLASS_BODY:
+                continue;
+            case AST_VARIABLE_DECLARATION:
+                if (n->op == TOKEN_VAR) {
+                    for (uint32_t d = n->first_child; d != AST_NONE; d = next_of(f, d)) {
+                        collect_pattern(f, node_at(f, d)->first_child);
+                    }
+                }
+                continue;
+            default:
+                break;
+        }
+        /* 语句按源码顺序收集：子节点逆序入栈 */
+        size_t first = depth;
+        for (uint32_t child = n->first_child; child != AST_NONE; child = next_of(f, child)) {
+            if (!reserve((void**)&f->stack, &f->stack_capacity, depth + 1, sizeof(uint32_t))) {
+                f->failed = true;
+                return;
+            }
+            f->stack[depth++] = child;
+        }
+        for (size_t i = first, j = depth; i + 1 < j; i++, j--) {
+            uint32_t swap = f->stack[i];
+            f->stack[i] = f->stack[j - 1];
+            f->stack[j - 1] = swap;
+        }
+    }
+}
+
+/* var a, b; */
+static void write_vars(Folder *f) {
+    out_cstr(f, "var ");
+    for (size_t i = 0; i < f->name_count; i++) {
+        const AstNode *n = node_at(f, f->names[i]);
+        if (i > 0) out_cstr(f, ", ");
+        out(f, f->source + n->start, n->end - n->start);
+    }
+    out_cstr(f, ";");
+}
+
+/* 条件已知的if/while：chosen为执行的分支（没有时为AST_NONE），dead为删除的部分 */
+static bool pruned(const Folder *f, uint32_t node, uint32_t *chosen, uint32_t *dead) {
+    const AstNode *n = node_at(f, node);
+    uint32_t branch = f->nodes[node].branch;
+    if (branch == BRANCH_KEEP) return false;
+
+    if (n->kind == AST_WHILE_STATEMENT) {
+        *chosen = AST_NONE;
+        *dead = next_of(f, n->first_child);
+        return true;
+    }
+    if (n->kind != AST_IF_STATEMENT) return false;
+    uint32_t consequent = next_of(f, n->first_child);
+    *dead = branch == consequent ? next_of(f, consequent) : consequent;
+    *chosen = node_at(f, branch)->kind == AST_NULL ? AST_NONE : branch;
+    return true;
+}
+
+static void emit(Folder *f, uint32_t node, unsigned context);
+static bool emit_list(Folder *f, uint32_t first);
+
+/* 输出一条语句，返回它是否一定跳出（其后的语句不可达） */
+static bool emit_statement(Folder *f, uint32_t node, bool list) {
+    const AstNode *n = node_at(f, node);
+    uint32_t chosen, dead;
+
+    if (pruned(f, node, &chosen, &dead)) {
+        f->stats->branches++;
+        collect_vars(f, dead);
+        bool vars = f->name_count > 0;
+        bool block = !list && vars && chosen != AST_NONE;
+        bool terminal = false;
+
+        copy_to(f, n->start);
+        if (block) out_cstr(f, "{ ");
+        if (vars) write_vars(f);
+        if (chosen != AST_NONE) {
+            if (vars) out_cstr(f, " ");
+            skip_to(f, node_at(f, chosen)->start);
+            terminal = emit_statement(f, chosen, false);
+            copy_to(f, node_at(f, chosen)->end);
+        } else if (!vars) {
+            out_cstr(f, ";");
+        }
+        if (block) out_cstr(f, " }");
+        skip_to(f, n->end);
+        return terminal;
+    }
+
+    switch (n->kind) {
+        case AST_BLOCK_STATEMENT:
+            return emit_list(f, n->first_child);
+        case AST_RETURN_STATEMENT:
+        case AST_THROW_STATEMENT:
+        case AST_BREAK_STATEMENT:
+        case AST_CONTINUE_STATEMENT:
+            emit(f, node, 0);
+            return true;
+        default:
+            emit(f, node, 0);
+            return false;
+    }
+}
+
+/* 输出语句列表：跳出之后的语句和条件已知、什么也不执行的if/while连同前面的空白一起删除 */
+static bool emit_list(Folder *f, uint32_t first) {
+    bool terminal = false;
+    bool dropped = false;
+    bool kept = false;
+
+    for (uint32_t node = first; node != AST_NONE; node = next_of(f, node)) {
+        const AstNode *n = node_at(f, node);
+        uint32_t chosen, dead;
+        bool drop = false;
+
+        if (terminal && !hoisted(f, n)) {
+            collect_vars(f, node);
+            f->stats->unreachable++;
+            drop = true;
+        } else if (pruned(f, node, &chosen, &dead) && chosen == AST_NONE) {
+            collect_vars(f, dead);
+            f->stats->branches++;
+            drop = true;
+        }
+        if (drop && f->name_count == 0) {
+            skip_to(f, n->end);
+            dropped = true;
+            continue;
+        }
+
+        /* 删掉的语句可能带走了上一条语句之后（ASI所依赖）的换行 */
+        if (dropped && kept && f->last != ';' && f->last != '}') {
+            out_cstr(f, ";");
+        }
+        dropped = false;
+        kept = true;
+
+        if (drop) {
+            copy_to(f, n->start);
+            write_vars(f);
+            skip_to(f, n->end);
+        } else {
+            if (emit_statement(f, node, true)) terminal = true;
+            copy_to(f, n->end);
+        }
+    }
+    return terminal;
+}
+
+/* 条件已知的 ?:、&&、||、??：只输出选中的子节点 */
+static void emit_branch(Folder *f, uint32_t node, uint32_t chosen, unsigned context) {
+    const AstNode *n = node_at(f, node);
+    const AstNode *c = node_at(f, chosen);
+
+    /* (0, a.b)() 保持this为undefined；typeof (0, x) 保持未声明时的ReferenceError */
+    bool reference = (context & CONTEXT_REFERENCE) &&
+                     (c->kind == AST_IDENTIFIER || c->kind == AST_MEMBER_EXPRESSION ||
+                      c->kind == AST_CHAIN_EXPRESSION);
+    bool nullish = n->kind == AST_LOGICAL_EXPRESSION && c->kind == AST_LOGICAL_EXPRESSION &&
+                   (n->op == TOKEN_NULLISH) != (c->op == TOKEN_NULLISH);
+    bool parens = reference || nullish || precedence(c) < precedence(n) ||
+                  ((context & CONTEXT_LEADING) && ambiguous_start(f, c));
+
+    copy_to(f, n->start);
+    skip_to(f, c->start);
+    if (parens) out_cstr(f, reference ? "(0, " : "(");
+    emit(f, chosen, parens ? 0 : context);
+    copy_to(f, c->end);
+    if (parens) out_cstr(f, ")");
+    skip_to(f, n->end);
+    f->stats->branches++;
+}
+
+static void emit(Folder *f, uint32_t node, unsigned context) {
+    const AstNode *n = node_at(f, node);
+    const FoldNode *fn = &f->nodes[node];
+
+    if (replaceable(f, node)) {
+        bool parens = (context & CONTEXT_LEADING) && fn->value.type == VALUE_STRING;
+        copy_to(f, n->start);
+        f->joint = true;
+        if (parens) out_cstr(f, "(");
+        write_value(f, &fn->value);
+        if (parens) out_cstr(f, ")");
+        skip_to(f, n->end);
+        f->stats->folded++;
+        return;
+    }
+    if (fn->branch != BRANCH_KEEP &&
+        (n->kind == AST_CONDITIONAL_EXPRESSION || n->kind == AST_LOGICAL_EXPRESSION)) {
+        emit_branch(f, node, fn->branch, context);
+        return;
+    }
+
+    switch (n->kind) {
+        case AST_PROGRAM:
+        case AST_BLOCK_STATEMENT:
+            emit_list(f, n->first_child);
+            return;
+        case AST_SWITCH_CASE:
+            emit(f, n->first_child, 0);
+            emit_list(f, next_of(f, n->first_child));
+            return;
+        default:
+            break;
+    }
+
+    for (uint32_t child = n->first_child; child != AST_NONE; child = next_of(f, child)) {
+        const AstNode *c = node_at(f, child);
+        if (is_statement((AstKind)c->kind)) {
+            emit_statement(f, child, false);
+            continue;
+        }
+
+        unsigned flags = 0;
+        if (c->start == n->start && ((context & CONTEXT_LEADING) || n->kind == AST_EXPRESSION_STATEMENT)) {
+            flags |= CONTEXT_LEADING;
+        }
+        if (n->kind == AST_ARROW_FUNCTION_EXPRESSION && (n->flags & AST_FLAG_EXPRESSION) &&
+            c->next_sibling == AST_NONE && !after_paren(f, c->start)) {
+            flags |= CONTEXT_LEADING;
+        }
+        if ((n->kind == AST_CALL_EXPRESSION && child == n->first_child) ||
+            (n->kind == AST_UNARY_EXPRESSION && (n->op == TOKEN_TYPEOF || n->op == TOKEN_DELETE))) {
+            flags |= CONTEXT_REFERENCE;
+        }
+        emit(f, child, flags);
+    }
+}
+
+bool fold_write(const Ast *ast, const char *source, size_t length, Writer *writer, FoldStats *stats) {
+    Folder f;
+    memset(&f, 0, sizeof(f));
+    f.ast = ast;
+    f.source = source;
+    f.length = length;
+    f.writer = writer;
+    f.stats = stats;
+    f.budget = length * 2;
+    f.last = '\n';
+    memset(stats, 0, sizeof(*stats));
+
+    f.nodes = (FoldNode*)calloc(ast->count ? ast->count : 1, sizeof(FoldNode));
+    f.strings = cooked_strings_create();
+    bool success = f.nodes != NULL && f.strings != NULL;
+    if (success) {
+        for (size_t i = 0; i < ast->count; i++) {
+            f.nodes[i].branch = BRANCH_KEEP;
+        }
+        success = evaluate(&f) && !f.failed && !cooked_strings_failed(f.strings);
+    }
+    if (success) {
+        emit(&f, ast->root, 0);
+        copy_to(&f, length);
+        success = !f.failed;
+    }
+
+    while (f.blocks) {
+        FoldBlock *next = f.blocks->next;
+        free(f.blocks);
+        f.blocks = next;
+    }
+    cooked_strings_destroy(f.strings);
+    free(f.names);
+    free(f.stack);
+    free(f.nodes);
+    return success && !writer->failed;
+}
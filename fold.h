@@ -0,0 +1,35 @@
+#ifndef FOLD_H
+#define FOLD_H
+
+#include "ast.h"
+#include "writer.h"
+#include "common.h"
+
+#define FOLD_ARENA_BLOCK (64u << 10)    /* 折叠出的字符串的arena每块大小 */
+
+/*
+ * 常量折叠和死分支删除：在扁平AST上自底向上求出每个节点的常量值
+ * （undefined、null、布尔、数字、字符串），再输出改写后的源码——
+ * 值已知的表达式换成字面量，条件已知的 if、?:、&&、||、??、while(false) 只保留
+ * 会执行的分支，return/throw/break/continue 之后的语句删除。
+ *
+ * 求值按JS语义：ToNumber（含字符串的空白、0x/0o/0b和Infinity）、
+ * 位运算先ToInt32、移位数取低5位、>>> 的结果按无符号数、
+ * 字符串比较按UTF-16码元。结果不精确的运算（超过2^53的非十进制整数字面量、非整数次幂）
+ * 和结果是NaN/Infinity的表达式不改写（后者仍参与外层的求值）。
+ * 删除的代码中的var声明保留为不带初值的 var a, b;，不可达的函数声明
+ * 和let/const/class声明原样保留。
+ * 求值和输出各遍历AST一次，字符串拼接原地追加，总拷贝量不超过源码长度的两倍。
+ */
+
+/* 改写统计 */
+typedef struct {
+    size_t folded;          /* 换成常量的表达式 */
+    size_t branches;        /* 按常量条件删除了分支的 if、?:、&&、||、??、while */
+    size_t unreachable;     /* 删除的不可达语句 */
+} FoldStats;
+
+/* 输出折叠后的源码（ast为source的语法树）。内存不足时返回false */
+bool fold_write(const Ast *ast, const char *source, size_t length, Writer *writer, FoldStats *stats);
+
+#endif /* FOLD_H */
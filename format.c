@@ -0,0 +1,884 @@
+#include "format.h"
+#include "parser.h"
+#include "scope.h"
+#include "structural.h"
+#include "minify.h"
+
+/*
+ * 格式化
+ *
+ * 1. 解析：同时构建AST、记录token和trivia（注释与空行）。AST只用来标出语句列表中每条语句、
+ *    switch的每个case、if/for/while的语句体和对象字面量（模式）的起始偏移，排版本身只看token。
+ * 2. 把token流转换为Wadler风格的文档：文本、可断行点（LINE/SOFTLINE）、强制换行、组和缩进。
+ *    圆括号、方括号和对象字面量各为一组；语句块总是展开，语句之间强制换行；
+ *    注释和空行按偏移从trivia表中取出，放回原来的token之间。
+ * 3. 输出：每个组开始时决定平铺还是展开——平铺宽度（到组结束，组内有强制换行时到第一个强制换行为止，
+ *    再加上组后面到下一个可断行点的文本）不超过剩余行宽就平铺。这些宽度用前缀和在一遍反向扫描中算好，
+ *    每个组只做一次O(1)的判断，整个过程与源码长度成线性关系。
+ */
+
+#define GROUP_NONE UINT32_MAX
+
+/* 文档元素 */
+typedef enum {
+    ITEM_TEXT,              /* 文本 */
+    ITEM_LINE,              /* 所在组展开时换行，平铺时为一个空格 */
+    ITEM_SOFTLINE,          /* 所在组展开时换行，平铺时不输出 */
+    ITEM_HARDLINE,          /* 强制换行 */
+    ITEM_BLANKLINE,         /* 强制换行并保留一个空行 */
+    ITEM_IF_BREAK,          /* 所在组展开时才输出的文本（末尾逗号） */
+    ITEM_GROUP,             /* 组开始 */
+    ITEM_END,               /* 组结束 */
+    ITEM_INDENT,            /* 缩进一级 */
+    ITEM_DEDENT             /* 取消最近一次缩进 */
+} ItemKind;
+
+/* 组和缩进的标志 */
+#define GROUP_HUG        0x01   /* 圆括号：内部语句块的换行不使它展开，f(() => {...}) 从同一行开始 */
+#define GROUP_BROKEN     0x02   /* 含有注释，必须展开 */
+#define GROUP_HARD       0x04   /* 含有强制换行 */
+#define GROUP_EXPANDED   0x08   /* 输出时决定展开 */
+#define INDENT_IF_BROKEN 0x10   /* 只在所在组展开时缩进 */
+
+typedef struct {
+    uint8_t kind;           /* ItemKind */
+    uint8_t flags;
+    uint32_t length;
+    const char *text;
+    uint32_t group;         /* LINE/SOFTLINE/IF_BREAK/INDENT：所在的组；GROUP：对应的END */
+} FormatItem;
+
+/* token之间的分隔 */
+typedef enum {
+    SEP_AUTO,               /* 按前后token决定空格 */
+    SEP_NONE,
+    SEP_SPACE,
+    SEP_SOFT,
+    SEP_LINE,
+    SEP_HARD,
+    SEP_BLANK
+} Separator;
+
+/* 括号框架 */
+typedef enum {
+    FRAME_BLOCK,            /* 语句块、类体、switch体和整个程序 */
+    FRAME_PAREN,
+    FRAME_BRACKET,
+    FRAME_OBJECT            /* 对象字面量、对象模式和import/export说明符列表 */
+} FrameKind;
+
+typedef struct {
+    uint8_t kind;           /* FrameKind */
+    bool empty;             /* 开括号之后还没有内容 */
+    bool switch_body;
+    bool case_open;         /* 当前case的语句已缩进 */
+    bool case_colon;        /* 等待case之后的冒号 */
+    uint32_t group;         /* 本框架的组（语句块为GROUP_NONE） */
+    uint32_t outer;         /* 最内层的组：强制换行和注释标记到这里 */
+    uint32_t ternary;       /* 未配对的 ? 个数 */
+} Frame;
+
+/* 解析时记录的token */
+typedef struct {
+    uint32_t start;
+    uint32_t end;
+    uint8_t type;           /* TokenType */
+    bool asi;               /* 之前自动插入了分号 */
+    bool newline;           /* 之前有换行 */
+} FormatToken;
+
+/* AST标出的起始偏移 */
+#define MARK_OBJECT     0x01    /* 对象字面量或对象模式的 { */
+#define MARK_STATEMENT  0x02    /* 语句列表（程序、语句块、类体、case）中的一条 */
+#define MARK_CASE       0x04    /* switch中的case/default */
+#define MARK_BODY       0x08    /* if/else/for/while/do的语句体 */
+
+typedef struct {
+    const char *source;
+    size_t length;
+    FormatToken *tokens;
+    size_t token_count;
+    size_t token_capacity;
+    uint8_t *marks;         /* 每个源码偏移的MARK_* */
+    TriviaTable trivia;
+    FormatItem *items;
+    size_t item_count;
+    size_t item_capacity;
+    Frame *frames;
+    size_t frame_count;
+    size_t frame_capacity;
+    bool failed;            /* 内存不足 */
+
+    /* 转换token时的状态 */
+    Separator pending;      /* 上一个token要求的分隔 */
+    bool need_break;        /* 行注释之后必须换行 */
+    bool comment_space;     /* 行内块注释之后至少一个空格 */
+    bool blank;             /* 与上一个token之间有空行 */
+    bool emitted;           /* 已经输出过内容 */
+    TokenType prev_type;
+    unsigned char prev_last;
+    bool prev_operand;      /* 上一个token结束一个操作数（其后的 + - 是二元运算符） */
+    bool prev_prefix;       /* 上一个token是前缀运算符，与后面的token之间没有空格 */
+    size_t switch_depth;    /* switch关键字所在的框架深度，0表示没有 */
+} Formatter;
+
+/* 记录token */
+static void collect_token(void *context, const Token *token, bool asi) {
+    Formatter *f = (Formatter*)context;
+    if (f->token_count == f->token_capacity) {
+        size_t capacity = f->token_capacity ? f->token_capacity * 2 : 1024;
+        FormatToken *tokens = (FormatToken*)realloc(f->tokens, capacity * sizeof(FormatToken));
+        if (!tokens) {
+            f->failed = true;
+            return;
+        }
+        f->tokens = tokens;
+        f->token_capacity = capacity;
+    }
+    FormatToken *t = &f->tokens[f->token_count++];
+    t->start = (uint32_t)token->start.offset;
+    t->end = (uint32_t)token->end.offset;
+    t->type = (uint8_t)token->type;
+    t->asi = asi;
+    t->newline = token->preceded_by_newline;
+}
+
+/* 用AST标出语句、case、语句体和对象的起始偏移 */
+static void mark_nodes(Formatter *f, const Ast *ast) {
+    for (size_t i = 0; i < ast->count; i++) {
+        const AstNode *n = &ast->nodes[i];
+        uint8_t mark = 0;
+        int skip = 0;           /* 不标记的前几个子节点 */
+        int only = -1;          /* 只标记这一个子节点 */
+        switch (n->kind) {
+            case AST_PROGRAM:
+            case AST_BLOCK_STATEMENT:
+            case AST_STATIC_BLOCK:
+            case AST_CLASS_BODY:
+                mark = MARK_STATEMENT;
+                break;
+            case AST_SWITCH_CASE:
+                mark = MARK_STATEMENT;
+                skip = 1;
+                break;
+            case AST_SWITCH_STATEMENT:
+                mark = MARK_CASE;
+                skip = 1;
+                break;
+            case AST_IF_STATEMENT:
+                mark = MARK_BODY;
+                skip = 1;
+                break;
+            case AST_WHILE_STATEMENT:
+            case AST_WITH_STATEMENT:
+                mark = MARK_BODY;
+                only = 1;
+                break;
+            case AST_DO_WHILE_STATEMENT:
+                mark = MARK_BODY;
+                only = 0;
+                break;
+            case AST_FOR_STATEMENT:
+                mark = MARK_BODY;
+                only = 3;
+                break;
+            case AST_FOR_IN_STATEMENT:
+            case AST_FOR_OF_STATEMENT:
+                mark = MARK_BODY;
+                only = 2;
+                break;
+            case AST_OBJECT_EXPRESSION:
+            case AST_OBJECT_PATTERN:
+                f->marks[n->start] |= MARK_OBJECT;
+                break;
+            default:
+                break;
+        }
+        if (!mark) continue;
+
+        int index = 0;
+        for (uint32_t child = n->first_child; child != AST_NONE;
+             child = ast->nodes[child].next_sibling, index++) {
+            const AstNode *c = &ast->nodes[child];
+            if (index < skip || (only >= 0 && index != only) || c->kind == AST_NULL) continue;
+            f->marks[c->start] |= mark;
+        }
+    }
+}
+
+/* ---------- 构建文档 ---------- */
+
+static uint32_t add_item(Formatter *f, ItemKind kind, uint8_t flags, uint32_t group) {
+    if (f->item_count == f->item_capacity) {
+        size_t capacity = f->item_capacity ? f->item_capacity * 2 : 4096;
+        FormatItem *items = (FormatItem*)realloc(f->items, capacity * sizeof(FormatItem));
+        if (!items) {
+            f->failed = true;
+            return 0;
+        }
+        f->items = items;
+        f->item_capacity = capacity;
+    }
+    FormatItem *item = &f->items[f->item_count];
+    item->kind = (uint8_t)kind;
+    item->flags = flags;
+    item->length = 0;
+    item->text = NULL;
+    item->group = group;
+    return (uint32_t)f->item_count++;
+}
+
+static void add_text(Formatter *f, const char *text, size_t length) {
+    uint32_t index = add_item(f, ITEM_TEXT, 0, GROUP_NONE);
+    if (f->failed) return;
+    f->items[index].text = text;
+    f->items[index].length = (uint32_t)length;
+    f->emitted = true;
+}
+
+static inline Frame* top_frame(Formatter *f) {
+    return &f->frames[f->frame_count - 1];
+}
+
+/* 标记最内层的组 */
+static void mark_group(Formatter *f, uint8_t flag) {
+    uint32_t outer = top_frame(f)->outer;
+    if (outer != GROUP_NONE && !f->failed) {
+        f->items[outer].flags |= flag;
+    }
+}
+
+static void push_frame(Formatter *f, FrameKind kind, uint32_t group) {
+    if (f->frame_count == f->frame_capacity) {
+        size_t capacity = f->frame_capacity ? f->frame_capacity * 2 : 64;
+        Frame *frames = (Frame*)realloc(f->frames, capacity * sizeof(Frame));
+        if (!frames) {
+            f->failed = true;
+            return;
+        }
+        f->frames = frames;
+        f->frame_capacity = capacity;
+    }
+    Frame *frame = &f->frames[f->frame_count];
+    memset(frame, 0, sizeof(Frame));
+    frame->kind = (uint8_t)kind;
+    frame->empty = true;
+    frame->group = group;
+    frame->outer = group != GROUP_NONE ? group
+                   : f->frame_count > 0 ? f->frames[f->frame_count - 1].outer : GROUP_NONE;
+    f->frame_count++;
+}
+
+static void emit_separator(Formatter *f, Separator sep) {
+    switch (sep) {
+        case SEP_SPACE:
+            add_text(f, " ", 1);
+            break;
+        case SEP_SOFT:
+            add_item(f, ITEM_SOFTLINE, 0, top_frame(f)->group);
+            break;
+        case SEP_LINE:
+            add_item(f, ITEM_LINE, 0, top_frame(f)->group);
+            break;
+        case SEP_HARD:
+        case SEP_BLANK:
+            add_item(f, sep == SEP_HARD ? ITEM_HARDLINE : ITEM_BLANKLINE, 0, GROUP_NONE);
+            mark_group(f, GROUP_HARD);
+            break;
+        default:
+            break;
+    }
+}
+
+/* 开一个组：圆括号、方括号或对象字面量 */
+static void open_group(Formatter *f, FrameKind kind, const char *text, uint8_t flags) {
+    uint32_t group = add_item(f, ITEM_GROUP, flags, GROUP_NONE);
+    add_text(f, text, 1);
+    add_item(f, ITEM_INDENT, INDENT_IF_BROKEN, group);
+    push_frame(f, kind, group);
+}
+
+/* 闭括号：空括号写在一起，否则闭括号另起一行（组平铺时不换行） */
+static void close_frame(Formatter *f, const char *text) {
+    Frame frame = f->frames[--f->frame_count];
+
+    if (frame.kind == FRAME_BLOCK) {
+        if (frame.case_open) add_item(f, ITEM_DEDENT, 0, GROUP_NONE);
+        add_item(f, ITEM_DEDENT, 0, GROUP_NONE);
+        if (!frame.empty) emit_separator(f, SEP_HARD);
+        add_text(f, text, 1);
+        return;
+    }
+
+    add_item(f, ITEM_DEDENT, 0, GROUP_NONE);
+    if (!frame.empty) {
+        add_item(f, frame.kind == FRAME_OBJECT ? ITEM_LINE : ITEM_SOFTLINE, 0, frame.group);
+    }
+    add_text(f, text, 1);
+    uint32_t end = add_item(f, ITEM_END, 0, GROUP_NONE);
+    if (f->failed) return;
+    f->items[frame.group].group = end;
+    mark_group(f, f->items[frame.group].flags & (GROUP_BROKEN | GROUP_HARD));
+}
+
+/* 注释和空行：行尾注释跟在前一个token后面，独占一行的注释前后换行 */
+static size_t format_trivia(Formatter *f, size_t cursor, uint32_t end) {
+    const TriviaTable *table = &f->trivia;
+
+    for (; cursor < table->count && table->items[cursor].start < end; cursor++) {
+        const Trivia *trivia = &table->items[cursor];
+        if (trivia->kind == TRIVIA_BLANK_LINE) {
+            f->blank = f->emitted;
+            continue;
+        }
+
+        const char *text = f->source + trivia->start;
+        size_t length = trivia->end - trivia->start;
+        bool line = trivia->kind == TRIVIA_LINE_COMMENT;
+        while (line && length > 2 && (text[length - 1] == ' ' || text[length - 1] == '\t' ||
+                                      text[length - 1] == '\r')) {
+            length--;
+        }
+
+        Frame *top = top_frame(f);
+        if (!trivia->newline_before && f->emitted) {
+            if (f->prev_type != TOKEN_LPAREN && f->prev_type != TOKEN_LBRACKET) {
+                add_text(f, " ", 1);
+            }
+            add_text(f, text, length);
+            if (line) {
+                f->need_break = true;
+                mark_group(f, GROUP_BROKEN);
+            } else {
+                f->comment_space = true;
+            }
+        } else {
+            if (f->emitted) {
+                emit_separator(f, f->blank && top->kind == FRAME_BLOCK && !top->empty ? SEP_BLANK : SEP_HARD);
+            }
+            mark_group(f, GROUP_BROKEN);
+            add_text(f, text, length);
+
+            /* 块注释后面在原文中换行时也换行 */
+            size_t next = trivia->end;
+            while (next < f->length && (f->source[next] == ' ' || f->source[next] == '\t')) next++;
+            f->need_break = line || (next < f->length && (f->source[next] == '\n' || f->source[next] == '\r'));
+            f->comment_space = !f->need_break;
+            f->pending = SEP_AUTO;
+        }
+        f->blank = false;
+        top->empty = false;
+    }
+    return cursor;
+}
+
+/* 上下文关键字（也可以作为标识符） */
+static bool is_contextual(TokenType type) {
+    switch (type) {
+        case TOKEN_GET:
+        case TOKEN_SET:
+        case TOKEN_STATIC:
+        case TOKEN_ASYNC:
+        case TOKEN_OF:
+        case TOKEN_LET:
+        case TOKEN_AWAIT:
+        case TOKEN_YIELD:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* 按前后token决定是否加空格 */
+static Separator auto_separator(Formatter *f, const FormatToken *t) {
+    TokenType prev = f->prev_type;
+
+    if (f->prev_prefix) return SEP_NONE;
+    if (prev == TOKEN_LPAREN || prev == TOKEN_LBRACKET || prev == TOKEN_DOT ||
+        prev == TOKEN_OPTIONAL_CHAIN || (prev == TOKEN_TEMPLATE && f->prev_last == '{')) {
+        return SEP_NONE;
+    }
+
+    switch ((TokenType)t->type) {
+        case TOKEN_RPAREN:
+        case TOKEN_RBRACKET:
+        case TOKEN_COMMA:
+        case TOKEN_SEMICOLON:
+        case TOKEN_DOT:
+        case TOKEN_OPTIONAL_CHAIN:
+            return SEP_NONE;
+        case TOKEN_COLON:
+            return top_frame(f)->ternary > 0 ? SEP_SPACE : SEP_NONE;
+        case TOKEN_INCREMENT:
+        case TOKEN_DECREMENT:
+            return f->prev_operand && !t->newline ? SEP_NONE : SEP_SPACE;
+        case TOKEN_LPAREN:
+        case TOKEN_LBRACKET:
+            /* 调用和成员访问；get(x)这类用作名字的上下文关键字保持原来是否相连 */
+            if (f->prev_operand || prev == TOKEN_SUPER || prev == TOKEN_IMPORT) return SEP_NONE;
+            if (is_contextual(prev) && t->start > 0 &&
+                f->source[t->start - 1] != ' ' && f->source[t->start - 1] != '\t' &&
+                f->source[t->start - 1] != '\n' && f->source[t->start - 1] != '\r') {
+                return SEP_NONE;
+            }
+            return SEP_SPACE;
+        case TOKEN_TEMPLATE:
+            /* 与 ${ 配对的 } 紧跟替换中的表达式 */
+            if (f->source[t->start] == '}') return SEP_NONE;
+            return f->prev_operand ? SEP_NONE : SEP_SPACE;
+        case TOKEN_MULTIPLY:
+            return prev == TOKEN_FUNCTION || prev == TOKEN_YIELD ? SEP_NONE : SEP_SPACE;
+        case TOKEN_ELSE:
+            /* 不是语句块的分支之后，else另起一行 */
+            return prev == TOKEN_SEMICOLON ? SEP_HARD : SEP_SPACE;
+        default:
+            return SEP_SPACE;
+    }
+}
+
+/* 记录刚输出的token，判断其后的 + - 是一元还是二元运算符 */
+static void after_token(Formatter *f, TokenType type, unsigned char last, bool newline) {
+    bool operand = f->prev_type == TOKEN_DOT || f->prev_type == TOKEN_OPTIONAL_CHAIN; /* 属性名可以是关键字 */
+    bool prefix = false;
+    switch (type) {
+        case TOKEN_IDENTIFIER:
+        case TOKEN_NUMBER:
+        case TOKEN_STRING:
+        case TOKEN_REGEX:
+        case TOKEN_TRUE:
+        case TOKEN_FALSE:
+        case TOKEN_NULL:
+        case TOKEN_UNDEFINED:
+        case TOKEN_THIS:
+        case TOKEN_SUPER:
+        case TOKEN_RPAREN:
+        case TOKEN_RBRACKET:
+        case TOKEN_RBRACE:
+            operand = true;
+            break;
+        case TOKEN_TEMPLATE:
+            operand = last != '{';      /* 以 ${ 结束的一段之后是表达式的开头 */
+            break;
+        case TOKEN_INCREMENT:
+        case TOKEN_DECREMENT:
+            operand = f->prev_operand && !newline;
+            prefix = !operand;
+            break;
+        case TOKEN_PLUS:
+        case TOKEN_MINUS:
+            prefix = !f->prev_operand;
+            break;
+        case TOKEN_NOT:
+        case TOKEN_BITWISE_NOT:
+        case TOKEN_SPREAD:
+            prefix = true;
+            break;
+        case TOKEN_MULTIPLY:
+            /* 生成器方法 *gen() {} */
+            prefix = !f->prev_operand && f->prev_type != TOKEN_FUNCTION && f->prev_type != TOKEN_YIELD &&
+                     f->prev_type != TOKEN_IMPORT && f->prev_type != TOKEN_EXPORT;
+            break;
+        default:
+            break;
+    }
+    f->prev_type = type;
+    f->prev_last = last;
+    f->prev_operand = operand;
+    f->prev_prefix = prefix;
+}
+
+/* 把一个token转换为文档元素 */
+static void format_token(Formatter *f, size_t index) {
+    const FormatToken *t = &f->tokens[index];
+    TokenType type = (TokenType)t->type;
+    const char *text = f->source + t->start;
+    size_t length = t->end - t->start;
+    uint8_t mark = f->marks[t->start];
+    Frame *top = top_frame(f);
+
+    /* 闭括号（解析成功时一定与最内层的框架配对） */
+    if ((type == TOKEN_RPAREN || type == TOKEN_RBRACKET || type == TOKEN_RBRACE) && f->frame_count > 1) {
+        close_frame(f, text);
+        f->pending = SEP_AUTO;
+        f->need_break = false;
+        f->comment_space = false;
+        f->blank = false;
+        after_token(f, type, (unsigned char)text[0], t->newline);
+        return;
+    }
+
+    Separator sep;
+    if ((mark & (MARK_STATEMENT | MARK_CASE)) && top->kind == FRAME_BLOCK) {
+        if (mark & MARK_CASE) {
+            if (top->case_open) {
+                add_item(f, ITEM_DEDENT, 0, GROUP_NONE);
+                top->case_open = false;
+            }
+            top->case_colon = true;
+        }
+        sep = !f->emitted ? SEP_NONE : f->blank && !top->empty ? SEP_BLANK : SEP_HARD;
+        f->prev_operand = false;
+        f->prev_prefix = false;
+    } else if (mark & MARK_BODY) {
+        sep = SEP_SPACE;
+        f->prev_operand = false;
+        f->prev_prefix = false;
+    } else if (f->pending != SEP_AUTO) {
+        sep = f->pending;
+    } else {
+        sep = auto_separator(f, t);
+    }
+
+    if (f->need_break && sep != SEP_HARD && sep != SEP_BLANK &&
+        !((sep == SEP_LINE || sep == SEP_SOFT) && top->group != GROUP_NONE)) {
+        sep = SEP_HARD;
+    }
+    if (f->comment_space) {
+        if (sep == SEP_NONE) sep = SEP_SPACE;
+        if (sep == SEP_SOFT) sep = SEP_LINE;
+    }
+    if (sep == SEP_NONE && f->emitted &&
+        tokens_need_space(f->prev_type, f->prev_last, type, (unsigned char)text[0])) {
+        sep = SEP_SPACE;
+    }
+    emit_separator(f, sep);
+    f->pending = SEP_AUTO;
+    f->need_break = false;
+    f->comment_space = false;
+    f->blank = false;
+    top->empty = false;
+
+    switch (type) {
+        case TOKEN_LPAREN:
+            open_group(f, FRAME_PAREN, text, GROUP_HUG);
+            f->pending = SEP_SOFT;
+            break;
+
+        case TOKEN_LBRACKET:
+            open_group(f, FRAME_BRACKET, text, 0);
+            f->pending = SEP_SOFT;
+            break;
+
+        case TOKEN_LBRACE:
+            if ((mark & MARK_OBJECT) || f->prev_type == TOKEN_IMPORT || f->prev_type == TOKEN_EXPORT ||
+                (f->prev_type == TOKEN_COMMA && top->kind == FRAME_BLOCK)) {
+                open_group(f, FRAME_OBJECT, text, 0);
+                f->pending = SEP_LINE;
+            } else {
+                bool switch_body = f->switch_depth == f->frame_count;
+                add_text(f, text, 1);
+                add_item(f, ITEM_INDENT, 0, GROUP_NONE);
+                push_frame(f, FRAME_BLOCK, GROUP_NONE);
+                if (!f->failed) top_frame(f)->switch_body = switch_body;
+                if (switch_body) f->switch_depth = 0;
+            }
+            break;
+
+        case TOKEN_COMMA: {
+            /* 末尾逗号只在展开时保留（[a, ,] 中的空位除外） */
+            TokenType next = (TokenType)f->tokens[index + 1].type;
+            bool trailing = top->kind != FRAME_BLOCK && f->prev_type != TOKEN_COMMA &&
+                            (next == TOKEN_RPAREN || next == TOKEN_RBRACKET || next == TOKEN_RBRACE);
+            if (trailing) {
+                uint32_t item = add_item(f, ITEM_IF_BREAK, 0, top->group);
+                if (!f->failed) {
+                    f->items[item].text = text;
+                    f->items[item].length = 1;
+                }
+            } else {
+                add_text(f, text, length);
+            }
+            f->pending = top->group != GROUP_NONE ? SEP_LINE : SEP_SPACE;
+            break;
+        }
+
+        case TOKEN_SEMICOLON:
+            add_text(f, text, length);
+            if (top->kind == FRAME_PAREN) {
+                TokenType next = (TokenType)f->tokens[index + 1].type;
+                f->pending = next == TOKEN_SEMICOLON || next == TOKEN_RPAREN ? SEP_NONE : SEP_LINE;
+            }
+            break;
+
+        case TOKEN_QUESTION:
+            top->ternary++;
+            add_text(f, text, length);
+            break;
+
+        case TOKEN_COLON:
+            add_text(f, text, length);
+            if (top->ternary > 0) {
+                top->ternary--;
+            } else if (top->case_colon) {
+                add_item(f, ITEM_INDENT, 0, GROUP_NONE);
+                top->case_open = true;
+                top->case_colon = false;
+                break;
+            }
+            f->pending = SEP_SPACE;
+            break;
+
+        case TOKEN_SWITCH:
+            add_text(f, text, length);
+            f->switch_depth = f->frame_count;
+            break;
+
+        default:
+            add_text(f, text, length);
+            break;
+    }
+    after_token(f, type, (unsigned char)text[length - 1], t->newline);
+}
+
+/* 把token流转换为文档 */
+static void build_document(Formatter *f) {
+    size_t cursor = 0;
+
+    push_frame(f, FRAME_BLOCK, GROUP_NONE);
+    for (size_t i = 0; i < f->token_count && !f->failed; i++) {
+        const FormatToken *t = &f->tokens[i];
+        if (t->asi && f->emitted) {
+            add_text(f, ";", 1);
+            after_token(f, TOKEN_SEMICOLON, ';', false);
+            f->pending = SEP_AUTO;
+        }
+        cursor = format_trivia(f, cursor, t->start);
+        if (t->type == TOKEN_EOF) break;
+        format_token(f, i);
+    }
+    if (f->emitted) {
+        add_item(f, ITEM_HARDLINE, 0, GROUP_NONE);
+    }
+}
+
+/* ---------- 输出 ---------- */
+
+/* 文本到第一个换行为止的显示宽度（按UTF-8字符计） */
+static uint32_t text_width(const char *text, size_t length, bool *multiline) {
+    uint32_t width = 0;
+    *multiline = false;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char ch = (unsigned char)text[i];
+        if (ch == '\n' || ch == '\r') {
+            *multiline = true;
+            break;
+        }
+        if ((ch & 0xC0) != 0x80) width++;
+    }
+    return width;
+}
+
+/* 组是否必须展开 */
+static inline bool group_forced(const FormatItem *items, uint32_t group) {
+    if (group == GROUP_NONE) return false;
+    uint8_t flags = items[group].flags;
+    return (flags & GROUP_BROKEN) || ((flags & GROUP_HARD) && !(flags & GROUP_HUG));
+}
+
+typedef struct {
+    Writer *writer;
+    size_t column;
+    size_t indent;
+    bool line_start;
+    bool space;
+} Printer;
+
+static void print_text(Printer *p, const char *text, size_t length) {
+    if (p->line_start) {
+        for (size_t i = 0; i < p->indent * FORMAT_INDENT; i++) {
+            writer_byte(p->writer, ' ');
+        }
+        p->column = p->indent * FORMAT_INDENT;
+        p->line_start = false;
+    } else if (p->space) {
+        writer_byte(p->writer, ' ');
+        p->column++;
+    }
+    p->space = false;
+    writer_write(p->writer, text, length);
+
+    /* 多行文本（模板、块注释）：列号从最后一行算起 */
+    size_t last = length;
+    while (last > 0 && text[last - 1] != '\n') last--;
+    bool multiline;
+    if (last > 0) p->column = 0;
+    p->column += text_width(text + last, length - last, &multiline);
+}
+
+static void print_newline(Printer *p) {
+    writer_byte(p->writer, '\n');
+    p->column = 0;
+    p->line_start = true;
+    p->space = false;
+}
+
+/* 输出文档 */
+static bool print_document(Formatter *f, Writer *writer) {
+    FormatItem *items = f->items;
+    size_t n = f->item_count;
+    uint32_t *width = (uint32_t*)malloc((n + 1) * sizeof(uint32_t));
+    uint64_t *prefix = (uint64_t*)malloc((n + 1) * sizeof(uint64_t));
+    uint32_t *next_hard = (uint32_t*)malloc((n + 1) * sizeof(uint32_t));
+    uint32_t *next_break = (uint32_t*)malloc((n + 1) * sizeof(uint32_t));
+    uint8_t *applied = (uint8_t*)malloc(n + 1);
+    if (!width || !prefix || !next_hard || !next_break || !applied) {
+        free(width);
+        free(prefix);
+        free(next_hard);
+        free(next_break);
+        free(applied);
+        return false;
+    }
+
+    /* 平铺宽度的前缀和、每个位置之后的第一个强制换行和第一个可断行点 */
+    prefix[0] = 0;
+    for (size_t i = 0; i < n; i++) {
+        const FormatItem *item = &items[i];
+        bool multiline = false;
+        width[i] = 0;
+        if (item->kind == ITEM_TEXT) {
+            width[i] = text_width(item->text, item->length, &multiline);
+        } else if (item->kind == ITEM_LINE) {
+            width[i] = 1;
+        }
+        prefix[i + 1] = prefix[i] + width[i];
+        next_hard[i] = multiline || item->kind == ITEM_HARDLINE || item->kind == ITEM_BLANKLINE ||
+                       ((item->kind == ITEM_LINE || item->kind == ITEM_SOFTLINE) &&
+                        group_forced(items, item->group));
+        next_break[i] = item->kind == ITEM_LINE || item->kind == ITEM_SOFTLINE;
+    }
+    next_hard[n] = (uint32_t)n;
+    next_break[n] = (uint32_t)n;
+    for (size_t i = n; i-- > 0;) {
+        next_hard[i] = next_hard[i] ? (uint32_t)i : next_hard[i + 1];
+        next_break[i] = next_break[i] ? (uint32_t)i : next_break[i + 1];
+    }
+
+    Printer p = {writer, 0, 0, true, false};
+    size_t depth = 0;
+    for (size_t i = 0; i < n; i++) {
+        FormatItem *item = &items[i];
+        switch (item->kind) {
+            case ITEM_GROUP: {
+                bool expand = group_forced(items, (uint32_t)i);
+                if (!expand) {
+                    /* 平铺宽度：到组结束（组内有强制换行时到它为止）再加上组后面到下一个可断行点的文本 */
+                    size_t end = item->group;
+                    size_t stop = next_hard[i] < end ? next_hard[i]
+                                  : next_break[end] < next_hard[end] ? next_break[end] : next_hard[end];
+                    uint64_t need = prefix[stop] - prefix[i] + (stop < n && items[stop].kind == ITEM_TEXT ? width[stop] : 0);
+                    expand = p.column + need > FORMAT_WIDTH;
+                }
+                if (expand) item->flags |= GROUP_EXPANDED;
+                break;
+            }
+            case ITEM_INDENT: {
+                bool indent = !(item->flags & INDENT_IF_BROKEN) || (items[item->group].flags & GROUP_EXPANDED);
+                applied[depth++] = indent;
+                p.indent += indent;
+                break;
+            }
+            case ITEM_DEDENT:
+                if (depth > 0) p.indent -= applied[--depth];
+                break;
+            case ITEM_LINE:
+            case ITEM_SOFTLINE:
+                if (item->group != GROUP_NONE && (items[item->group].flags & GROUP_EXPANDED)) {
+                    print_newline(&p);
+                } else if (item->kind == ITEM_LINE) {
+                    p.space = true;
+                }
+                break;
+            case ITEM_BLANKLINE:
+                print_newline(&p);
+                print_newline(&p);
+                break;
+            case ITEM_HARDLINE:
+                print_newline(&p);
+                break;
+            case ITEM_IF_BREAK:
+                if (items[item->group].flags & GROUP_EXPANDED) {
+                    print_text(&p, item->text, item->length);
+                }
+                break;
+            case ITEM_TEXT:
+                print_text(&p, item->text, item->length);
+                break;
+            default:
+                break;
+        }
+    }
+
+    free(width);
+    free(prefix);
+    free(next_hard);
+    free(next_break);
+    free(applied);
+    return true;
+}
+
+/* 格式化源码 */
+bool format_source(const char *source, size_t length, bool module, Writer *writer, ErrorInfo *error) {
+    if (!structural_check(source, length, error)) {
+        return false;
+    }
+
+    Formatter f;
+    memset(&f, 0, sizeof(f));
+    f.source = source;
+    f.length = length;
+    f.prev_type = TOKEN_EOF;
+    f.marks = (uint8_t*)calloc(length + 1, 1);
+
+    Ast ast;
+    bool success = f.marks && ast_init(&ast, length);
+    if (!success) {
+        free(f.marks);
+        set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+        return false;
+    }
+
+    /* 第一个token在parser_create中读取，trivia表要在此之前打开 */
+    Lexer *lexer = lexer_create(source, length, error);
+    Parser *parser = NULL;
+    if (lexer) {
+        lexer->trivia = &f.trivia;
+        parser = parser_create(lexer, error);
+    }
+    if (parser) {
+        parser->ast = &ast;
+        parser->module = module;
+        parser->on_token = collect_token;
+        parser->token_context = &f;
+        success = scope_parse(parser);
+        if (success) {
+            /* 文件末尾的EOF（及其前面自动插入的分号） */
+            collect_token(&f, parser->current_token, parser->asi_before);
+        }
+    } else {
+        success = false;
+    }
+    parser_destroy(parser);
+    lexer_destroy(lexer);
+
+    if (success && (ast.failed || f.trivia.failed || f.failed)) {
+        set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+        success = false;
+    }
+    if (success) {
+        mark_nodes(&f, &ast);
+        build_document(&f);
+        if (f.failed || !print_document(&f, writer)) {
+            set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+            success = false;
+        }
+    }
+
+    ast_free(&ast);
+    trivia_table_free(&f.trivia);
+    free(f.tokens);
+    free(f.marks);
+    free(f.items);
+    free(f.frames);
+    return success && !writer->failed;
+}
@@ -0,0 +1,15 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include "writer.h"
+#include "common.h"
+
+#define FORMAT_WIDTH 80     /* 目标行宽 */
+#define FORMAT_INDENT 4     /* 每级缩进的空格数 */
+
+/* 格式化：保留注释和（合并后的）空行，语句之间换行，ASI位置补上分号，
+   括号、方括号和对象字面量放得下就写在一行，否则逐项换行。输出只取决于token和注释，
+   与原来的空白无关（空行除外），对输出再格式化结果不变。出错时不输出任何内容 */
+bool format_source(const char *source, size_t length, bool module, Writer *writer, ErrorInfo *error);
+
+#endif /* FORMAT_H */
@@ -0,0 +1,549 @@
+#include "highlight.h"
+#include "parser.h"
+
+/* HighlightState.function */
+enum {
+    FUNCTION_NONE,
+    FUNCTION_NAME,          /* function之后：下一个标识符是函数名 */
+    FUNCTION_PARAMS         /* 函数名或catch之后：下一个 ( 开始参数列表 */
+};
+
+/* HighlightState.declaration */
+enum {
+    DECLARATION_NONE,
+    DECLARATION_VAR,
+    DECLARATION_CONST,
+    DECLARATION_PARAM
+};
+
+static const char *const type_names[HIGHLIGHT_TYPE_COUNT] = {
+    "keyword", "variable", "parameter", "function", "method", "class",
+    "property", "string", "number", "regexp", "operator", "comment"
+};
+
+static const char *const modifier_names[HIGHLIGHT_MODIFIER_COUNT] = {
+    "declaration", "readonly", "defaultLibrary"
+};
+
+/* 一次高亮 */
+typedef struct {
+    const char *source;
+    size_t length;
+    HighlightIndex *index;      /* 非NULL时记录检查点 */
+    HighlightTokens *out;       /* NULL时只建检查点 */
+    size_t first_line;
+    size_t last_line;
+    bool done;                  /* 已越过last_line或到达文件末尾 */
+
+    /* 行列游标（只向前移动）：offset处是第line行（从0开始）的第column个UTF-16码元 */
+    size_t line;
+    size_t offset;
+    size_t column;
+
+    /* 已读入、等下一个token出现后才能分类的token */
+    bool has_pending;
+    TokenType pending_type;
+    size_t pending_start;
+    size_t pending_end;
+    Position pending_end_position;
+    bool pending_in_template;   /* 读入它之后位于模板替换 ${} 中 */
+
+    HighlightState state;
+    HighlightCheckpoint candidate;  /* 最近一个token之后的状态（检查点不能落在 ${} 中，
+                                       从那里重新开始的词法分析器不知道外层的模板） */
+} Highlighter;
+
+/* ---------- 输出 ---------- */
+
+static void push_token(Highlighter *h, size_t line, size_t column, size_t length,
+                       HighlightType type, uint8_t modifiers) {
+    if (!h->out || length == 0 || line < h->first_line || line > h->last_line) return;
+
+    HighlightTokens *out = h->out;
+    if (out->count == out->capacity) {
+        size_t capacity = out->capacity ? out->capacity * 2 : 256;
+        HighlightToken *items = (HighlightToken*)realloc(out->items, capacity * sizeof(HighlightToken));
+        if (!items) {
+            out->failed = true;
+            return;
+        }
+        out->items = items;
+        out->capacity = capacity;
+    }
+    HighlightToken *token = &out->items[out->count++];
+    token->line = (uint32_t)line;
+    token->column = (uint32_t)column;
+    token->length = (uint32_t)length;
+    token->type = (uint8_t)type;
+    token->modifiers = modifiers;
+}
+
+/* 游标前进一个字符，越过换行（\n、\r\n、\r）时返回true */
+static bool step(Highlighter *h) {
+    unsigned char ch = (unsigned char)h->source[h->offset++];
+    if (ch == '\n' || ch == '\r') {
+        if (ch == '\r' && h->offset < h->length && h->source[h->offset] == '\n') {
+            h->offset++;
+        }
+        h->line++;
+        h->column = 0;
+        return true;
+    }
+    /* UTF-8：首字节计一个码元，四字节序列（BMP之外）计两个，后续字节不计 */
+    if (ch < 0x80 || (ch >= 0xC0 && ch < 0xF0)) {
+        h->column++;
+    } else if (ch >= 0xF0) {
+        h->column += 2;
+    }
+    return false;
+}
+
+/* 输出源码范围 [start, end)，跨行时每行一段 */
+static void emit(Highlighter *h, size_t start, size_t end, HighlightType type, uint8_t modifiers) {
+    while (h->offset < start) {
+        step(h);
+    }
+    size_t line = h->line;
+    size_t column = h->column;
+    while (h->offset < end) {
+        size_t before = h->column;
+        if (step(h)) {
+            push_token(h, line, column, before - column, type, modifiers);
+            line = h->line;
+            column = 0;
+        }
+    }
+    push_token(h, line, column, h->column - column, type, modifiers);
+}
+
+/* 输出已记录的注释 */
+static void emit_trivia(Highlighter *h, const TriviaTable *trivia, size_t *next) {
+    for (; *next < trivia->count; (*next)++) {
+        const Trivia *item = &trivia->items[*next];
+        if (item->kind != TRIVIA_BLANK_LINE) {
+            emit(h, item->start, item->end, HIGHLIGHT_COMMENT, 0);
+        }
+    }
+}
+
+/* ---------- 分类 ---------- */
+
+/* async、of、get等上下文关键字在这些位置是普通的名字 */
+static bool used_as_name(TokenType prev, TokenType next) {
+    if (prev == TOKEN_DOT || prev == TOKEN_OPTIONAL_CHAIN) return true;
+    switch (next) {
+        case TOKEN_LPAREN:
+        case TOKEN_RPAREN:
+        case TOKEN_RBRACKET:
+        case TOKEN_RBRACE:
+        case TOKEN_ASSIGN:
+        case TOKEN_COMMA:
+        case TOKEN_SEMICOLON:
+        case TOKEN_COLON:
+        case TOKEN_DOT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* 标识符按前后的token分类 */
+static HighlightType classify_name(const HighlightState *state, TokenType next, uint8_t *modifiers) {
+    TokenType prev = (TokenType)state->prev;
+    if (prev == TOKEN_DOT || prev == TOKEN_OPTIONAL_CHAIN) {
+        return next == TOKEN_LPAREN ? HIGHLIGHT_METHOD : HIGHLIGHT_PROPERTY;
+    }
+    if (state->function == FUNCTION_NAME) {
+        *modifiers = HIGHLIGHT_DECLARATION;
+        return HIGHLIGHT_FUNCTION;
+    }
+    if (prev == TOKEN_CLASS) {
+        *modifiers = HIGHLIGHT_DECLARATION;
+        return HIGHLIGHT_CLASS;
+    }
+    if (prev == TOKEN_EXTENDS || prev == TOKEN_NEW) {
+        return HIGHLIGHT_CLASS;
+    }
+    if (state->declaration != DECLARATION_NONE && state->expect_name && state->nesting == 0) {
+        *modifiers = HIGHLIGHT_DECLARATION;
+        if (state->declaration == DECLARATION_PARAM) return HIGHLIGHT_PARAMETER;
+        if (state->declaration == DECLARATION_CONST) *modifiers |= HIGHLIGHT_READONLY;
+        return HIGHLIGHT_VARIABLE;
+    }
+    if (next == TOKEN_ARROW) {
+        *modifiers = HIGHLIGHT_DECLARATION;
+        return HIGHLIGHT_PARAMETER;
+    }
+    if (next == TOKEN_COLON && (prev == TOKEN_LBRACE || prev == TOKEN_COMMA)) {
+        return HIGHLIGHT_PROPERTY;
+    }
+    return next == TOKEN_LPAREN ? HIGHLIGHT_FUNCTION : HIGHLIGHT_VARIABLE;
+}
+
+/* token的类型（-1表示不输出，如括号和分号），name表示它是一个名字 */
+static int classify(const HighlightState *state, TokenType type, TokenType next,
+                    uint8_t *modifiers, bool *name) {
+    *modifiers = 0;
+    *name = false;
+    switch (type) {
+        case TOKEN_IDENTIFIER:
+            *name = true;
+            return classify_name(state, next, modifiers);
+        case TOKEN_NUMBER:
+            return HIGHLIGHT_NUMBER;
+        case TOKEN_STRING:
+        case TOKEN_TEMPLATE:
+            return HIGHLIGHT_STRING;
+        case TOKEN_REGEX:
+            return HIGHLIGHT_REGEXP;
+        case TOKEN_UNDEFINED:
+            *modifiers = HIGHLIGHT_READONLY | HIGHLIGHT_DEFAULT_LIBRARY;
+            return HIGHLIGHT_VARIABLE;
+        case TOKEN_ASYNC:
+        case TOKEN_AWAIT:
+        case TOKEN_OF:
+        case TOKEN_STATIC:
+        case TOKEN_GET:
+        case TOKEN_SET:
+            if (used_as_name((TokenType)state->prev, next)) {
+                *name = true;
+                return classify_name(state, next, modifiers);
+            }
+            return HIGHLIGHT_KEYWORD;
+        case TOKEN_OPTIONAL_CHAIN:
+        case TOKEN_AUTO_SEMICOLON:
+            return -1;
+        default:
+            break;
+    }
+    if (type >= TOKEN_TRUE && type <= TOKEN_SET) return HIGHLIGHT_KEYWORD;
+    if (type >= TOKEN_PLUS) return HIGHLIGHT_OPERATOR;
+    return -1;
+}
+
+/* 越过一个token后更新上下文 */
+static void advance_state(HighlightState *state, TokenType type, bool name) {
+    uint8_t function = FUNCTION_NONE;
+    if (type == TOKEN_FUNCTION) {
+        function = FUNCTION_NAME;
+    } else if (type == TOKEN_CATCH) {
+        function = FUNCTION_PARAMS;
+    } else if (state->function == FUNCTION_NAME && type == TOKEN_MULTIPLY) {
+        function = FUNCTION_NAME;       /* function* */
+    } else if (state->function == FUNCTION_NAME && name) {
+        function = FUNCTION_PARAMS;
+    }
+
+    if (state->function != FUNCTION_NONE && type == TOKEN_LPAREN) {
+        state->declaration = DECLARATION_PARAM;
+        state->nesting = 0;
+        state->expect_name = true;
+    } else if (type == TOKEN_VAR || type == TOKEN_LET || type == TOKEN_CONST) {
+        state->declaration = type == TOKEN_CONST ? DECLARATION_CONST : DECLARATION_VAR;
+        state->nesting = 0;
+        state->expect_name = true;
+    } else if (state->declaration != DECLARATION_NONE) {
+        if (type == TOKEN_LPAREN || type == TOKEN_LBRACKET || type == TOKEN_LBRACE) {
+            state->nesting++;
+        } else if (type == TOKEN_RPAREN || type == TOKEN_RBRACKET || type == TOKEN_RBRACE) {
+            if (--state->nesting < 0) state->declaration = DECLARATION_NONE;
+        } else if (state->nesting == 0) {
+            if (type == TOKEN_COMMA) {
+                state->expect_name = true;
+            } else if (type == TOKEN_ASSIGN || name) {
+                state->expect_name = false;
+            } else if (type == TOKEN_SEMICOLON || is_statement_start(type)) {
+                state->declaration = DECLARATION_NONE;
+            }
+        }
+    }
+
+    state->function = function;
+    state->prev = (uint8_t)type;
+}
+
+/* 分类并输出等待中的token，next为其后的token */
+static void finish_pending(Highlighter *h, TokenType next) {
+    uint8_t modifiers;
+    bool name;
+    int type = classify(&h->state, h->pending_type, next, &modifiers, &name);
+    if (type >= 0) {
+        emit(h, h->pending_start, h->pending_end, (HighlightType)type, modifiers);
+    }
+    advance_state(&h->state, h->pending_type, name);
+
+    if (!h->pending_in_template) {
+        h->candidate.position = h->pending_end_position;
+        h->candidate.regex_allowed = can_precede_regex(h->pending_type);
+        h->candidate.state = h->state;
+    }
+    h->has_pending = false;
+}
+
+/* ---------- 检查点 ---------- */
+
+/* 第line行（从0开始）及之前尚未有检查点的每一段都使用当前的候选状态 */
+static bool record_checkpoints(Highlighter *h, size_t line) {
+    HighlightIndex *index = h->index;
+    while (index->count * HIGHLIGHT_CHECKPOINT_LINES <= line) {
+        if (index->count == index->capacity) {
+            size_t capacity = index->capacity ? index->capacity * 2 : 64;
+            HighlightCheckpoint *checkpoints = (HighlightCheckpoint*)realloc(
+                index->checkpoints, capacity * sizeof(HighlightCheckpoint));
+            if (!checkpoints) return false;
+            index->checkpoints = checkpoints;
+            index->capacity = capacity;
+        }
+        index->checkpoints[index->count++] = h->candidate;
+    }
+    return true;
+}
+
+/* ---------- 主循环 ---------- */
+
+/* 从检查点开始高亮，直到越过last_line或文件末尾 */
+static bool run(Highlighter *h, const HighlightCheckpoint *start) {
+    HighlightCheckpoint checkpoint = *start;
+
+    /* 游标从检查点所在行的行首开始 */
+    size_t line_start = (size_t)checkpoint.position.offset;
+    while (line_start > 0 && h->source[line_start - 1] != '\n' && h->source[line_start - 1] != '\r') {
+        line_start--;
+    }
+    h->line = (size_t)checkpoint.position.line - 1;
+    h->offset = line_start;
+    h->column = 0;
+
+    TriviaTable trivia = {0};
+    bool success = true;
+    while (!h->done && success) {
+        size_t offset = (size_t)checkpoint.position.offset;
+        ErrorInfo error = {0};
+        error.code = ERROR_NONE;
+        Lexer *lexer = lexer_create_at(h->source + offset, h->length - offset, checkpoint.position, &error);
+        if (!lexer) {
+            success = false;
+            break;
+        }
+        lexer->trivia = &trivia;
+        lexer->trivia_line = checkpoint.position.line;
+        if (checkpoint.regex_allowed) lexer_set_regex_allowed(lexer, true);
+        trivia.count = 0;
+        size_t trivia_next = 0;
+
+        h->state = checkpoint.state;
+        h->candidate = checkpoint;
+        h->has_pending = false;
+        Position last = checkpoint.position;
+
+        Token *token;
+        while ((token = lexer_next_token(lexer)) != NULL) {
+            TokenType type = token->type;
+            Position token_start = token->start;
+            Position token_end = token->end;
+            token_destroy(token);
+
+            /* 上一个token现在可以分类，它与当前token之间的注释随后输出 */
+            if (h->has_pending) finish_pending(h, type);
+            emit_trivia(h, &trivia, &trivia_next);
+
+            if (type == TOKEN_EOF || (size_t)token_start.line - 1 > h->last_line) {
+                h->done = true;
+                break;
+            }
+            if (h->index && !record_checkpoints(h, (size_t)token_end.line - 1)) {
+                success = false;
+                break;
+            }
+            h->has_pending = true;
+            h->pending_type = type;
+            h->pending_start = (size_t)token_start.offset;
+            h->pending_end = (size_t)token_end.offset;
+            h->pending_end_position = token_end;
+            h->pending_in_template = lexer_in_template(lexer);
+            last = token_end;
+        }
+        lexer_destroy(lexer);
+        if (h->done || !success) break;
+
+        if (error.code == ERROR_NONE) {
+            success = false;            /* 内存不足 */
+            break;
+        }
+
+        /* 词法错误：输出已经读到的部分，从出错的token所在行的下一行重新开始 */
+        if (h->has_pending) finish_pending(h, TOKEN_EOF);
+        emit_trivia(h, &trivia, &trivia_next);
+        Position from = error.position.offset > last.offset ? error.position : last;
+        size_t resume = (size_t)from.offset;
+        while (resume < h->length && h->source[resume] != '\n' && h->source[resume] != '\r') {
+            resume++;
+        }
+        if (resume >= h->length || (size_t)from.line > h->last_line) {
+            h->done = true;
+            break;
+        }
+        resume += (h->source[resume] == '\r' && resume + 1 < h->length && h->source[resume + 1] == '\n') ? 2 : 1;
+
+        /* 在重新开始的行之前的段仍从出错前的状态开始（重放会得到同样的错误和同样的恢复） */
+        if (h->index && !record_checkpoints(h, (size_t)from.line - 1)) {
+            success = false;
+            break;
+        }
+        checkpoint.position.line = from.line + 1;
+        checkpoint.position.column = 1;
+        checkpoint.position.offset = (int)resume;
+        checkpoint.regex_allowed = true;
+        memset(&checkpoint.state, 0, sizeof(checkpoint.state));
+        checkpoint.state.prev = TOKEN_EOF;
+    }
+
+    trivia_table_free(&trivia);
+    return success && !(h->out && h->out->failed);
+}
+
+static void highlighter_init(Highlighter *h, const char *source, size_t length,
+                             HighlightTokens *out, size_t first_line, size_t last_line) {
+    memset(h, 0, sizeof(*h));
+    h->source = source;
+    h->length = length;
+    h->out = out;
+    h->first_line = first_line;
+    h->last_line = last_line;
+}
+
+bool highlight_source(const char *source, size_t length, HighlightIndex *index,
+                      HighlightTokens *out) {
+    HighlightCheckpoint start;
+    memset(&start, 0, sizeof(start));
+    start.position.line = 1;
+    start.position.column = 1;
+    start.state.prev = TOKEN_EOF;
+
+    Highlighter h;
+    highlighter_init(&h, source, length, out, 0, SIZE_MAX);
+    if (index) {
+        memset(index, 0, sizeof(*index));
+        index->source = source;
+        index->length = length;
+        h.index = index;
+        h.candidate = start;
+        if (!record_checkpoints(&h, 0)) return false;
+    }
+    return run(&h, &start);
+}
+
+bool highlight_range(const HighlightIndex *index, size_t first_line, size_t last_line,
+                     HighlightTokens *out) {
+    if (index->count == 0 || first_line > last_line) return index->count > 0;
+
+    size_t k = first_line / HIGHLIGHT_CHECKPOINT_LINES;
+    if (k >= index->count) k = index->count - 1;
+
+    Highlighter h;
+    highlighter_init(&h, index->source, index->length, out, first_line, last_line);
+    return run(&h, &index->checkpoints[k]);
+}
+
+void highlight_index_free(HighlightIndex *index) {
+    free(index->checkpoints);
+    memset(index, 0, sizeof(*index));
+}
+
+static void index_header(HighlightIndexHeader *header, const char *source, size_t length,
+                         size_t count) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, HIGHLIGHT_INDEX_MAGIC, 4);
+    header->version = HIGHLIGHT_INDEX_VERSION;
+    header->byte_order = HIGHLIGHT_INDEX_BYTE_ORDER;
+    header->checkpoint_lines = HIGHLIGHT_CHECKPOINT_LINES;
+    header->checkpoint_size = sizeof(HighlightCheckpoint);
+    header->source_length = length;
+    header->source_hash = fnv1a_hash(source, length);
+    header->count = count;
+}
+
+bool highlight_index_save(const HighlightIndex *index, const char *path) {
+    HighlightIndexHeader header;
+    index_header(&header, index->source, index->length, index->count);
+
+    Writer writer;
+    if (!writer_open(&writer, path)) return false;
+    writer_write(&writer, (const char*)&header, sizeof(header));
+    writer_write(&writer, (const char*)index->checkpoints,
+                 index->count * sizeof(HighlightCheckpoint));
+    return writer_close(&writer);
+}
+
+bool highlight_index_load(HighlightIndex *index, const char *source, size_t length,
+                          const char *path) {
+    memset(index, 0, sizeof(*index));
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+
+    HighlightIndexHeader header, expected;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                 header.count > 0 && header.count <= SIZE_MAX / sizeof(HighlightCheckpoint);
+    if (valid) {
+        index_header(&expected, source, length, (size_t)header.count);
+        valid = memcmp(&header, &expected, sizeof(header)) == 0;
+    }
+    HighlightCheckpoint *checkpoints = NULL;
+    if (valid) {
+        checkpoints = (HighlightCheckpoint*)malloc((size_t)header.count * sizeof(HighlightCheckpoint));
+        valid = checkpoints &&
+                fread(checkpoints, sizeof(HighlightCheckpoint), (size_t)header.count, file) ==
+                    header.count &&
+                fgetc(file) == EOF;
+    }
+    fclose(file);
+    if (!valid) {
+        free(checkpoints);
+        return false;
+    }
+
+    index->source = source;
+    index->length = length;
+    index->checkpoints = checkpoints;
+    index->count = (size_t)header.count;
+    index->capacity = (size_t)header.count;
+    return true;
+}
+
+void highlight_tokens_free(HighlightTokens *tokens) {
+    free(tokens->items);
+    memset(tokens, 0, sizeof(*tokens));
+}
+
+void highlight_write(const HighlightTokens *tokens, Writer *writer) {
+    writer_cstr(writer, "{\"legend\":{\"tokenTypes\":[");
+    for (int i = 0; i < HIGHLIGHT_TYPE_COUNT; i++) {
+        if (i > 0) writer_byte(writer, ',');
+        writer_json_string(writer, type_names[i], strlen(type_names[i]));
+    }
+    writer_cstr(writer, "],\"tokenModifiers\":[");
+    for (int i = 0; i < HIGHLIGHT_MODIFIER_COUNT; i++) {
+        if (i > 0) writer_byte(writer, ',');
+        writer_json_string(writer, modifier_names[i], strlen(modifier_names[i]));
+    }
+    writer_cstr(writer, "]},\"data\":[");
+
+    uint32_t line = 0, column = 0;
+    for (size_t i = 0; i < tokens->count; i++) {
+        const HighlightToken *t = &tokens->items[i];
+        uint32_t delta_line = t->line - line;
+        if (i > 0) writer_byte(writer, ',');
+        writer_uint(writer, delta_line);
+        writer_byte(writer, ',');
+        writer_uint(writer, delta_line == 0 ? t->column - column : t->column);
+        writer_byte(writer, ',');
+        writer_uint(writer, t->length);
+        writer_byte(writer, ',');
+        writer_uint(writer, t->type);
+        writer_byte(writer, ',');
+        writer_uint(writer, t->modifiers);
+        line = t->line;
+        column = t->column;
+    }
+    writer_cstr(writer, "]}\n");
+}
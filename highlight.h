@@ -0,0 +1,126 @@
+#ifndef HIGHLIGHT_H
+#define HIGHLIGHT_H
+
+#include "lexer.h"
+#include "writer.h"
+#include "common.h"
+
+#define HIGHLIGHT_CHECKPOINT_LINES 64   /* 每隔这么多行保存一个检查点 */
+#define HIGHLIGHT_INDEX_MAGIC "JSHL"
+#define HIGHLIGHT_INDEX_VERSION 2
+#define HIGHLIGHT_INDEX_BYTE_ORDER 0x01020304u
+
+/*
+ * 语义token（LSP textDocument/semanticTokens 的编码）：
+ * 直接由词法分析器产生，标识符按前后的token分类（声明、参数、调用、属性访问等），
+ * 注释来自trivia表。跨行的token（块注释、模板字符串）按行拆成多段。
+ * 行号从0开始，列和长度按UTF-16码元计算。
+ *
+ * 分类只依赖词法状态和一个很小的上下文状态（HighlightState），两者都可以在
+ * token边界保存下来。检查点表记录每HIGHLIGHT_CHECKPOINT_LINES行之前最近的一个
+ * 不在模板 `${}` 替换中的token边界，只高亮某几行时从最近的检查点开始词法分析，耗时与文件大小无关。
+ * 词法错误（输入中的半截字符串等）不会中断高亮：从出错位置的下一行重新开始。
+ */
+
+/* token类型（顺序即LSP legend中的下标） */
+typedef enum {
+    HIGHLIGHT_KEYWORD,
+    HIGHLIGHT_VARIABLE,
+    HIGHLIGHT_PARAMETER,
+    HIGHLIGHT_FUNCTION,
+    HIGHLIGHT_METHOD,
+    HIGHLIGHT_CLASS,
+    HIGHLIGHT_PROPERTY,
+    HIGHLIGHT_STRING,
+    HIGHLIGHT_NUMBER,
+    HIGHLIGHT_REGEXP,
+    HIGHLIGHT_OPERATOR,
+    HIGHLIGHT_COMMENT,
+    HIGHLIGHT_TYPE_COUNT
+} HighlightType;
+
+/* 修饰（位掩码，第i位对应legend中的第i个修饰） */
+#define HIGHLIGHT_DECLARATION       0x01
+#define HIGHLIGHT_READONLY          0x02
+#define HIGHLIGHT_DEFAULT_LIBRARY   0x04
+#define HIGHLIGHT_MODIFIER_COUNT    3
+
+/* 一个语义token（一行之内） */
+typedef struct {
+    uint32_t line;
+    uint32_t column;
+    uint32_t length;
+    uint8_t type;           /* HighlightType */
+    uint8_t modifiers;      /* HIGHLIGHT_* 修饰 */
+} HighlightToken;
+
+typedef struct {
+    HighlightToken *items;
+    size_t count;
+    size_t capacity;
+    bool failed;            /* 内存不足 */
+} HighlightTokens;
+
+/* 标识符分类的上下文（在token边界可以完整保存） */
+typedef struct {
+    uint8_t prev;           /* 上一个token的TokenType，开头为TOKEN_EOF */
+    uint8_t function;       /* function/catch之后等待名字或参数列表 */
+    uint8_t declaration;    /* 正在var/let/const声明或参数列表中 */
+    bool expect_name;       /* 下一个（嵌套层数为0的）标识符是被声明的名字 */
+    int32_t nesting;        /* 声明开始后的括号嵌套层数 */
+} HighlightState;
+
+/* 检查点：从offset（某个token的结束处或出错后重新开始的行首）继续词法分析 */
+typedef struct {
+    Position position;      /* offset处的位置（行从1开始） */
+    bool regex_allowed;     /* offset之后的 / 是否开始正则 */
+    HighlightState state;
+} HighlightCheckpoint;
+
+/* 检查点表：checkpoints[k] 在第 k*HIGHLIGHT_CHECKPOINT_LINES 行（从0开始）之前 */
+typedef struct {
+    const char *source;
+    size_t length;
+    HighlightCheckpoint *checkpoints;
+    size_t count;
+    size_t capacity;
+} HighlightIndex;
+
+/* 高亮整个文件，需要时同时建立检查点表（index为NULL时不建） */
+bool highlight_source(const char *source, size_t length, HighlightIndex *index,
+                      HighlightTokens *out);
+
+/* 只高亮第first_line到last_line行（从0开始，含两端），从最近的检查点开始 */
+bool highlight_range(const HighlightIndex *index, size_t first_line, size_t last_line,
+                     HighlightTokens *out);
+
+void highlight_index_free(HighlightIndex *index);
+
+/*
+ * 检查点表文件：文件头之后是count个HighlightCheckpoint（本机字节序和布局）。
+ * 文件头记录源码的长度和FNV-1a哈希，源码变了表就作废，需要重新建立。
+ */
+typedef struct {
+    char magic[4];              /* "JSHL" */
+    uint32_t version;           /* HIGHLIGHT_INDEX_VERSION */
+    uint32_t byte_order;        /* HIGHLIGHT_INDEX_BYTE_ORDER */
+    uint32_t checkpoint_lines;  /* HIGHLIGHT_CHECKPOINT_LINES */
+    uint32_t checkpoint_size;   /* sizeof(HighlightCheckpoint) */
+    uint32_t reserved;
+    uint64_t source_length;
+    uint64_t source_hash;
+    uint64_t count;
+} HighlightIndexHeader;
+
+/* 把检查点表写入文件 */
+bool highlight_index_save(const HighlightIndex *index, const char *path);
+
+/* 读入为同一份源码建立的检查点表；文件不存在、格式不对或源码已经改变时返回false */
+bool highlight_index_load(HighlightIndex *index, const char *source, size_t length,
+                          const char *path);
+void highlight_tokens_free(HighlightTokens *tokens);
+
+/* 输出LSP格式的JSON：{"legend":{...},"data":[deltaLine, deltaStart, length, type, modifiers, ...]} */
+void highlight_write(const HighlightTokens *tokens, Writer *writer);
+
+#endif /* HIGHLIGHT_H */
@@ -0,0 +1,810 @@
+#define _XOPEN_SOURCE 700
+#include "ident_index.h"
+#include "lexer.h"
+#include "atom.h"
+#include "threadpool.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#endif
+
+/*
+ * 标识符倒排索引
+ *
+ * 构建时先遍历目录得到排好序的文件列表，与旧索引的文件表按路径归并：
+ * mtime和大小都没变的文件直接沿用；其余文件在线程池上读入并计算内容哈希，
+ * 哈希也没变的同样沿用，否则做词法分析，把标识符token记为（原子, 偏移, 行号）。
+ * 各线程共享一张原子表（见atom.h），沿用的倒排项从旧索引解码后也驻留到同一张表，
+ * 因此同名即同一原子。最后按名字文本排序，按名字做稳定的计数排序
+ * （文件本身已按顺序处理），逐项写出变长编码的倒排表。
+ */
+
+_Static_assert(sizeof(IdentIndexHeader) == 64, "IdentIndexHeader must be 64 bytes");
+_Static_assert(sizeof(IdentIndexFile) == 32, "IdentIndexFile must be 32 bytes");
+_Static_assert(sizeof(IdentIndexName) == 24, "IdentIndexName must be 24 bytes");
+
+#define IDENT_NONE UINT32_MAX
+
+/* 构建时的一次出现 */
+typedef struct {
+    uint32_t atom;
+    uint32_t offset;
+    uint32_t line;
+} IndexHit;
+
+/* 构建时的一个文件 */
+typedef struct {
+    struct IndexBuild *build;       /* 任务参数只有文件本身，通过它找到共享状态 */
+    char *path;                     /* 相对于索引目录 */
+    uint64_t mtime;
+    uint64_t size;
+    uint64_t hash;
+    uint32_t old;                   /* 旧索引中的文件编号，IDENT_NONE为新文件 */
+    bool reuse;                     /* 沿用旧索引中的倒排项 */
+    bool failed;
+    IndexHit *hits;
+    size_t count;
+    size_t capacity;
+} IndexFile;
+
+/* 构建的共享状态 */
+typedef struct IndexBuild {
+    const char *dir;
+    AtomTable *atoms;
+    const IdentIndex *old;          /* NULL为没有旧索引 */
+    IndexFile *files;
+    size_t count;
+    size_t capacity;
+} IndexBuild;
+
+/* 构建时的一个名字 */
+typedef struct {
+    uint32_t atom;
+    uint32_t count;
+    const char *text;
+    size_t length;
+    uint64_t postings;
+    uint64_t postings_length;
+} IndexName;
+
+/* 原子到名字编号的开放寻址表 */
+typedef struct {
+    uint32_t *keys;                 /* 原子，空位为ATOM_NONE */
+    uint32_t *values;
+    size_t count;
+    size_t capacity;
+} NameMap;
+
+/* 拼接目录和相对路径 */
+static char* path_join(const char *dir, const char *path) {
+    size_t dir_length = strlen(dir);
+    size_t path_length = strlen(path);
+    char *joined = (char*)malloc(dir_length + path_length + 2);
+    if (!joined) return NULL;
+    memcpy(joined, dir, dir_length);
+    joined[dir_length] = '/';
+    memcpy(joined + dir_length + 1, path, path_length + 1);
+    return joined;
+}
+
+static bool is_script(const char *name) {
+    const char *dot = strrchr(name, '.');
+    return dot && (strcmp(dot, ".js") == 0 || strcmp(dot, ".mjs") == 0 ||
+                   strcmp(dot, ".cjs") == 0);
+}
+
+/* 递归收集目录中的脚本文件（不跟随符号链接），rel为相对路径，根目录为NULL */
+static bool collect_files(IndexBuild *b, const char *rel, ErrorInfo *error) {
+    char *full = rel ? path_join(b->dir, rel) : NULL;
+    DIR *dir = opendir(rel ? full : b->dir);
+    free(full);
+    if (!dir) {
+        if (!rel) {
+            char message[256];
+            snprintf(message, sizeof(message), "Cannot open directory '%s'", b->dir);
+            set_error(error, ERROR_FILE_READ, (Position){0, 0, 0}, message);
+        }
+        return rel != NULL;
+    }
+
+    bool ok = true;
+    struct dirent *entry;
+    while (ok && (entry = readdir(dir)) != NULL) {
+        const char *name = entry->d_name;
+        if (name[0] == '.' || strcmp(name, "node_modules") == 0) continue;
+
+        char *child = rel ? path_join(rel, name) : strdup(name);
+        char *child_full = child ? path_join(b->dir, child) : NULL;
+        struct stat st;
+        if (!child_full) {
+            set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+            ok = false;
+        } else if (lstat(child_full, &st) != 0) {
+            /* 遍历期间被删除的项忽略 */
+        } else if (S_ISDIR(st.st_mode)) {
+            ok = collect_files(b, child, error);
+        } else if (S_ISREG(st.st_mode) && is_script(name)) {
+            if (b->count == b->capacity) {
+                size_t capacity = b->capacity ? b->capacity * 2 : 256;
+                IndexFile *files = (IndexFile*)realloc(b->files, capacity * sizeof(IndexFile));
+                if (!files) {
+                    set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+                    ok = false;
+                    free(child_full);
+                    free(child);
+                    break;
+                }
+                b->files = files;
+                b->capacity = capacity;
+            }
+            IndexFile *file = &b->files[b->count++];
+            memset(file, 0, sizeof(IndexFile));
+            file->build = b;
+            file->path = child;
+            file->mtime = (uint64_t)st.st_mtim.tv_sec * 1000000000u + (uint64_t)st.st_mtim.tv_nsec;
+            file->size = (uint64_t)st.st_size;
+            file->old = IDENT_NONE;
+            child = NULL;
+        }
+        free(child_full);
+        free(child);
+    }
+    closedir(dir);
+    return ok;
+}
+
+static int compare_files(const void *a, const void *b) {
+    return strcmp(((const IndexFile*)a)->path, ((const IndexFile*)b)->path);
+}
+
+static bool file_push(IndexFile *file, uint32_t atom, uint32_t offset, uint32_t line) {
+    if (file->count == file->capacity) {
+        size_t capacity = file->capacity ? file->capacity * 2 : 256;
+        IndexHit *hits = (IndexHit*)realloc(file->hits, capacity * sizeof(IndexHit));
+        if (!hits) return false;
+        file->hits = hits;
+        file->capacity = capacity;
+    }
+    IndexHit *hit = &file->hits[file->count++];
+    hit->atom = atom;
+    hit->offset = offset;
+    hit->line = line;
+    return true;
+}
+
+/* 会被索引的token：标识符，以及也能当作名字使用的上下文关键字 */
+static bool is_name_token(TokenType type) {
+    switch (type) {
+        case TOKEN_IDENTIFIER:
+        case TOKEN_UNDEFINED:
+        case TOKEN_LET:
+        case TOKEN_YIELD:
+        case TOKEN_ASYNC:
+        case TOKEN_AWAIT:
+        case TOKEN_OF:
+        case TOKEN_STATIC:
+        case TOKEN_GET:
+        case TOKEN_SET:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* 工作线程：读入文件，内容未变时沿用旧索引，否则做词法分析 */
+static void index_file_task(void *arg) {
+    IndexFile *file = (IndexFile*)arg;
+    IndexBuild *b = file->build;
+
+    char *full = path_join(b->dir, file->path);
+    size_t length = 0;
+    char *source = full ? file_load(full, &length) : NULL;
+    free(full);
+    if (!source || length > UINT32_MAX) {
+        fprintf(stderr, "Warning: Cannot read '%s/%s'\n", b->dir, file->path);
+        file->failed = true;
+        free(source);
+        return;
+    }
+
+    file->size = length;
+    file->hash = fnv1a_hash(source, length);
+    if (file->old != IDENT_NONE && b->old->files[file->old].size == file->size &&
+        b->old->files[file->old].hash == file->hash) {
+        file->reuse = true;
+        free(source);
+        return;
+    }
+
+    ErrorInfo error = {0};
+    Lexer *lexer = lexer_create(source, length, &error);
+    if (lexer) {
+        lexer->atoms = b->atoms;
+        for (;;) {
+            Token *token = lexer_next_token(lexer);
+            if (!token) {
+                fprintf(stderr, "Warning: %s/%s:%d:%d: %s\n", b->dir, file->path,
+                        error.position.line, error.position.column, error.message);
+                file->failed = true;
+                break;
+            }
+            TokenType type = token->type;
+            bool ok = !is_name_token(type) ||
+                      file_push(file, token->atom, (uint32_t)token->start.offset,
+                                (uint32_t)token->start.line);
+            token_destroy(token);
+            if (type == TOKEN_EOF) break;
+            if (!ok) {
+                fprintf(stderr, "Warning: %s/%s: Out of memory\n", b->dir, file->path);
+                file->failed = true;
+                break;
+            }
+        }
+        lexer_destroy(lexer);
+    } else {
+        file->failed = true;
+    }
+    free(source);
+}
+
+/* 字符串区中的一段（越界返回NULL） */
+static const char* index_string(const IdentIndex *index, uint32_t offset, uint32_t length) {
+    uint64_t size = index->header->postings_offset - index->header->strings_offset;
+    if ((uint64_t)offset + length > size) return NULL;
+    return index->strings + offset;
+}
+
+/* 把沿用的文件的倒排项从旧索引解码出来（按名字顺序，同名内偏移递增） */
+static bool decode_reused(IndexBuild *b, const uint32_t *old_to_new) {
+    const IdentIndex *old = b->old;
+    for (uint32_t slot = 0; slot < old->header->name_count; slot++) {
+        uint32_t atom = ATOM_NONE;
+        IdentCursor cursor;
+        ident_index_cursor(old, slot, &cursor);
+        while (ident_index_next(&cursor)) {
+            uint32_t file = old_to_new[cursor.posting.file];
+            if (file == IDENT_NONE) continue;
+            if (atom == ATOM_NONE) {
+                const IdentIndexName *name = &old->names[slot];
+                const char *text = index_string(old, name->text, name->text_length);
+                if (!text) break;
+                atom = atom_intern(b->atoms, text, name->text_length);
+                if (atom == ATOM_NONE) return false;
+            }
+            if (!file_push(&b->files[file], atom, cursor.posting.offset, cursor.posting.line)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static size_t map_slot(const NameMap *map, uint32_t atom) {
+    size_t i = ((uint64_t)atom * 0x9E3779B97F4A7C15ULL >> 32) & (map->capacity - 1);
+    while (map->keys[i] != ATOM_NONE && map->keys[i] != atom) {
+        i = (i + 1) & (map->capacity - 1);
+    }
+    return i;
+}
+
+/* 放入（或覆盖）原子对应的名字编号 */
+static bool map_put(NameMap *map, uint32_t atom, uint32_t value) {
+    if ((map->count + 1) * 2 > map->capacity) {
+        size_t capacity = map->capacity ? map->capacity * 2 : 1024;
+        NameMap grown = {NULL, NULL, 0, capacity};
+        grown.keys = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+        grown.values = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+        if (!grown.keys || !grown.values) {
+            free(grown.keys);
+            free(grown.values);
+            return false;
+        }
+        memset(grown.keys, 0xFF, capacity * sizeof(uint32_t));
+        for (size_t i = 0; i < map->capacity; i++) {
+            if (map->keys[i] == ATOM_NONE) continue;
+            size_t j = map_slot(&grown, map->keys[i]);
+            grown.keys[j] = map->keys[i];
+            grown.values[j] = map->values[i];
+        }
+        grown.count = map->count;
+        free(map->keys);
+        free(map->values);
+        *map = grown;
+    }
+    size_t i = map_slot(map, atom);
+    if (map->keys[i] == ATOM_NONE) {
+        map->keys[i] = atom;
+        map->count++;
+    }
+    map->values[i] = value;
+    return true;
+}
+
+static int compare_names(const void *a, const void *b) {
+    const IndexName *x = (const IndexName*)a;
+    const IndexName *y = (const IndexName*)b;
+    int order = memcmp(x->text, y->text, x->length < y->length ? x->length : y->length);
+    if (order != 0) return order;
+    return x->length < y->length ? -1 : x->length > y->length;
+}
+
+static size_t varint_size(uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+/* 按格式遍历一个名字的倒排项：返回编码后的字节数，writer非NULL时同时写出 */
+static uint64_t encode_postings(const IdentPosting *postings, size_t count, Writer *writer) {
+    uint64_t size = 0;
+    IdentPosting last = {0, 0, 0};
+    for (size_t i = 0; i < count; i++) {
+        const IdentPosting *p = &postings[i];
+        if (p->file != last.file) {
+            last.offset = 0;
+            last.line = 0;
+        }
+        uint64_t values[3] = {p->file - last.file, p->offset - last.offset, p->line - last.line};
+        for (int k = 0; k < 3; k++) {
+            size += varint_size(values[k]);
+            if (writer) writer_varint(writer, values[k]);
+        }
+        last = *p;
+    }
+    return size;
+}
+
+/* 写出索引文件：先写到临时文件，完成后改名替换旧索引 */
+static bool write_index(IndexBuild *b, IndexName *names, size_t name_count,
+                        const IdentPosting *postings, const size_t *starts,
+                        const char *index_path, IdentIndexStats *stats, ErrorInfo *error) {
+    uint64_t strings = 0;
+    uint64_t postings_size = 0;
+    bool fits = true;
+    for (size_t i = 0; i < b->count; i++) {
+        strings += strlen(b->files[i].path) + 1;
+    }
+    for (size_t i = 0; i < name_count; i++) {
+        strings += names[i].length + 1;
+        names[i].postings = postings_size;
+        names[i].postings_length = encode_postings(postings + starts[i], names[i].count, NULL);
+        postings_size += names[i].postings_length;
+        fits = fits && names[i].postings_length <= UINT32_MAX;
+    }
+    if (!fits || strings > UINT32_MAX) {
+        set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Index too large");
+        return false;
+    }
+
+    IdentIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, IDENT_INDEX_MAGIC, 4);
+    header.version = IDENT_INDEX_VERSION;
+    header.byte_order = IDENT_INDEX_BYTE_ORDER;
+    header.file_count = (uint32_t)b->count;
+    header.name_count = (uint32_t)name_count;
+    header.files_offset = sizeof(header);
+    header.names_offset = header.files_offset + b->count * sizeof(IdentIndexFile);
+    header.strings_offset = header.names_offset + name_count * sizeof(IdentIndexName);
+    header.postings_offset = header.strings_offset + strings;
+    header.file_size = header.postings_offset + postings_size;
+
+    size_t tmp_length = strlen(index_path);
+    char *tmp = (char*)malloc(tmp_length + 5);
+    if (!tmp) {
+        set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+        return false;
+    }
+    memcpy(tmp, index_path, tmp_length);
+    memcpy(tmp + tmp_length, ".tmp", 5);
+
+    Writer writer;
+    if (!writer_open(&writer, tmp)) {
+        free(tmp);
+        return false;
+    }
+    writer_write(&writer, (const char*)&header, sizeof(header));
+
+    uint32_t text = 0;
+    for (size_t i = 0; i < b->count; i++) {
+        IdentIndexFile entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.mtime = b->files[i].mtime;
+        entry.size = b->files[i].size;
+        entry.hash = b->files[i].hash;
+        entry.path = text;
+        entry.path_length = (uint32_t)strlen(b->files[i].path);
+        writer_write(&writer, (const char*)&entry, sizeof(entry));
+        text += entry.path_length + 1;
+    }
+    for (size_t i = 0; i < name_count; i++) {
+        IdentIndexName entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.postings = names[i].postings;
+        entry.postings_length = (uint32_t)names[i].postings_length;
+        entry.count = names[i].count;
+        entry.text = text;
+        entry.text_length = (uint32_t)names[i].length;
+        writer_write(&writer, (const char*)&entry, sizeof(entry));
+        text += entry.text_length + 1;
+    }
+    for (size_t i = 0; i < b->count; i++) {
+        writer_write(&writer, b->files[i].path, strlen(b->files[i].path) + 1);
+    }
+    for (size_t i = 0; i < name_count; i++) {
+        writer_write(&writer, names[i].text, names[i].length);
+        writer_byte(&writer, '\0');
+    }
+    for (size_t i = 0; i < name_count; i++) {
+        encode_postings(postings + starts[i], names[i].count, &writer);
+    }
+
+    bool ok = writer_close(&writer);
+    if (ok && rename(tmp, index_path) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        char message[256];
+        snprintf(message, sizeof(message), "Cannot write index '%s'", index_path);
+        set_error(error, ERROR_FILE_READ, (Position){0, 0, 0}, message);
+        remove(tmp);
+    }
+    free(tmp);
+    stats->bytes = (size_t)header.file_size;
+    return ok;
+}
+
+/* 按名字排序并生成倒排表，然后写出 */
+static bool build_postings(IndexBuild *b, const char *index_path, IdentIndexStats *stats,
+                           ErrorInfo *error) {
+    NameMap map = {NULL, NULL, 0, 0};
+    IndexName *names = NULL;
+    size_t name_count = 0;
+    size_t name_capacity = 0;
+    size_t *starts = NULL;
+    IdentPosting *postings = NULL;
+    size_t total = 0;
+    bool ok = true;
+
+    /* 给每个出现过的原子分配名字 */
+    for (size_t f = 0; ok && f < b->count; f++) {
+        for (size_t h = 0; ok && h < b->files[f].count; h++) {
+            uint32_t atom = b->files[f].hits[h].atom;
+            total++;
+            if (map.capacity && map.keys[map_slot(&map, atom)] == atom) continue;
+            if (name_count == name_capacity) {
+                name_capacity = name_capacity ? name_capacity * 2 : 1024;
+                IndexName *grown = (IndexName*)realloc(names, name_capacity * sizeof(IndexName));
+                if (!grown) {
+                    ok = false;
+                    break;
+                }
+                names = grown;
+            }
+            IndexName *name = &names[name_count];
+            memset(name, 0, sizeof(IndexName));
+            name->atom = atom;
+            name->text = atom_text(b->atoms, atom, &name->length);
+            ok = map_put(&map, atom, (uint32_t)name_count++);
+        }
+    }
+
+    /* 名字按文本排序后重新编号，再按名字稳定地计数排序 */
+    if (ok) {
+        if (name_count) qsort(names, name_count, sizeof(IndexName), compare_names);
+        for (size_t i = 0; ok && i < name_count; i++) {
+            ok = map_put(&map, names[i].atom, (uint32_t)i);
+        }
+        starts = (size_t*)calloc(name_count + 1, sizeof(size_t));
+        postings = (IdentPosting*)malloc((total ? total : 1) * sizeof(IdentPosting));
+        ok = ok && starts && postings;
+    }
+    if (ok) {
+        for (size_t f = 0; f < b->count; f++) {
+            for (size_t h = 0; h < b->files[f].count; h++) {
+                names[map.values[map_slot(&map, b->files[f].hits[h].atom)]].count++;
+            }
+        }
+        for (size_t i = 0; i < name_count; i++) {
+            starts[i + 1] = starts[i] + names[i].count;
+        }
+        size_t *next = (size_t*)malloc((name_count + 1) * sizeof(size_t));
+        ok = next != NULL;
+        if (ok) {
+            memcpy(next, starts, (name_count + 1) * sizeof(size_t));
+            for (size_t f = 0; f < b->count; f++) {
+                for (size_t h = 0; h < b->files[f].count; h++) {
+                    const IndexHit *hit = &b->files[f].hits[h];
+                    IdentPosting *p = &postings[next[map.values[map_slot(&map, hit->atom)]]++];
+                    p->file = (uint32_t)f;
+                    p->offset = hit->offset;
+                    p->line = hit->line;
+                }
+            }
+            free(next);
+        }
+    }
+
+    if (!ok) {
+        set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+    } else {
+        stats->names = name_count;
+        stats->postings = total;
+        ok = write_index(b, names, name_count, postings, starts, index_path, stats, error);
+    }
+
+    free(map.keys);
+    free(map.values);
+    free(names);
+    free(starts);
+    free(postings);
+    return ok;
+}
+
+/* 建立或增量更新索引 */
+bool ident_index_build(const char *dir, const char *index_path, int thread_count,
+                       IdentIndexStats *stats, ErrorInfo *error) {
+    IndexBuild b;
+    memset(&b, 0, sizeof(b));
+    memset(stats, 0, sizeof(*stats));
+    b.dir = dir;
+
+    IdentIndex old;
+    struct stat st;
+    bool have_old = stat(index_path, &st) == 0 && ident_index_load(&old, index_path);
+    if (have_old) b.old = &old;
+
+    uint32_t *old_to_new = NULL;
+    ThreadPool *pool = NULL;
+    b.atoms = atom_table_create();
+    bool ok = b.atoms != NULL;
+    if (!ok) {
+        set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+    }
+    ok = ok && collect_files(&b, NULL, error);
+    if (ok && b.count >= IDENT_NONE) {
+        set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Too many files");
+        ok = false;
+    }
+    if (ok && b.count) {
+        qsort(b.files, b.count, sizeof(IndexFile), compare_files);
+    }
+
+    /* 与旧索引的文件表（同样按路径排序）归并 */
+    if (ok && have_old) {
+        old_to_new = (uint32_t*)malloc((old.header->file_count + 1) * sizeof(uint32_t));
+        ok = old_to_new != NULL;
+        if (!ok) {
+            set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+        }
+        size_t f = 0;
+        for (uint32_t o = 0; ok && o < old.header->file_count; o++) {
+            old_to_new[o] = IDENT_NONE;
+            size_t length;
+            const char *path = ident_index_path(&old, o, &length);
+            int order = -1;
+            while (path && f < b.count &&
+                   (order = strcmp(b.files[f].path, path)) < 0) {
+                f++;
+            }
+            if (path && f < b.count && order == 0) {
+                b.files[f].old = o;
+            } else {
+                stats->removed++;
+            }
+        }
+    }
+
+    /* 没变的文件直接沿用，其余文件并行读入 */
+    if (ok) {
+        pool = threadpool_create(thread_count);
+        ok = pool != NULL;
+        if (!ok) {
+            set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+        }
+    }
+    for (size_t f = 0; ok && f < b.count; f++) {
+        IndexFile *file = &b.files[f];
+        if (file->old != IDENT_NONE && old.files[file->old].mtime == file->mtime &&
+            old.files[file->old].size == file->size) {
+            file->hash = old.files[file->old].hash;
+            file->reuse = true;
+        } else if (!threadpool_submit(pool, index_file_task, file)) {
+            set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+            ok = false;
+        }
+    }
+    if (pool) {
+        threadpool_wait(pool);
+        threadpool_destroy(pool);
+    }
+
+    if (ok) {
+        for (size_t f = 0; f < b.count; f++) {
+            IndexFile *file = &b.files[f];
+            if (file->reuse) {
+                old_to_new[file->old] = (uint32_t)f;
+                stats->reused++;
+            } else {
+                stats->lexed++;
+            }
+            if (file->failed) stats->failed++;
+        }
+        stats->files = b.count;
+        if (have_old && !decode_reused(&b, old_to_new)) {
+            set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+            ok = false;
+        }
+    }
+    if (have_old) {
+        ident_index_close(&old);
+        b.old = NULL;
+    }
+
+    ok = ok && build_postings(&b, index_path, stats, error);
+
+    for (size_t f = 0; f < b.count; f++) {
+        free(b.files[f].path);
+        free(b.files[f].hits);
+    }
+    free(b.files);
+    free(old_to_new);
+    atom_table_destroy(b.atoms);
+    return ok;
+}
+
+/* 加载索引：只检查文件头和各段范围，名字和倒排表在使用时检查 */
+bool ident_index_load(IdentIndex *index, const char *path) {
+    memset(index, 0, sizeof(*index));
+
+    index->data = file_map(path, &index->size, &index->mapped);
+    if (!index->data) {
+        fprintf(stderr, "Error: Cannot open file '%s'\n", path);
+        return false;
+    }
+
+    const IdentIndexHeader *header = (const IdentIndexHeader*)index->data;
+    bool valid = index->size >= sizeof(IdentIndexHeader) &&
+                 memcmp(header->magic, IDENT_INDEX_MAGIC, 4) == 0;
+    if (valid && (header->version != IDENT_INDEX_VERSION ||
+                  header->byte_order != IDENT_INDEX_BYTE_ORDER)) {
+        fprintf(stderr, "Error: '%s' was written by an incompatible version\n", path);
+        ident_index_close(index);
+        return false;
+    }
+    valid = valid &&
+            header->file_size == index->size &&
+            header->files_offset == sizeof(IdentIndexHeader) &&
+            header->names_offset ==
+                header->files_offset + (uint64_t)header->file_count * sizeof(IdentIndexFile) &&
+            header->strings_offset ==
+                header->names_offset + (uint64_t)header->name_count * sizeof(IdentIndexName) &&
+            header->strings_offset <= header->postings_offset &&
+            header->postings_offset <= index->size;
+    if (!valid) {
+        fprintf(stderr, "Error: '%s' is not a valid identifier index\n", path);
+        ident_index_close(index);
+        return false;
+    }
+
+    const char *data = (const char*)index->data;
+    index->header = header;
+    index->files = (const IdentIndexFile*)(data + header->files_offset);
+    index->names = (const IdentIndexName*)(data + header->names_offset);
+    index->strings = data + header->strings_offset;
+    index->postings = (const uint8_t*)data + header->postings_offset;
+    return true;
+}
+
+void ident_index_close(IdentIndex *index) {
+    if (!index || !index->data) return;
+
+    file_unmap(index->data, index->size, index->mapped);
+    memset(index, 0, sizeof(*index));
+}
+
+const char* ident_index_path(const IdentIndex *index, uint32_t file, size_t *length) {
+    if (file >= index->header->file_count) return NULL;
+    const IdentIndexFile *entry = &index->files[file];
+    if (length) *length = entry->path_length;
+    /* 路径后面还有'\0'，一并检查 */
+    return index_string(index, entry->path, entry->path_length + 1);
+}
+
+/* 在按文本排序的名字表中二分查找 */
+bool ident_index_find(const IdentIndex *index, const char *name, size_t length, uint32_t *slot) {
+    uint32_t lo = 0;
+    uint32_t hi = index->header->name_count;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        const IdentIndexName *entry = &index->names[mid];
+        const char *text = index_string(index, entry->text, entry->text_length);
+        if (!text) return false;
+        size_t common = entry->text_length < length ? entry->text_length : length;
+        int order = memcmp(text, name, common);
+        if (order == 0) {
+            order = entry->text_length < length ? -1 : entry->text_length > length;
+        }
+        if (order == 0) {
+            *slot = mid;
+            return true;
+        }
+        if (order < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return false;
+}
+
+void ident_index_cursor(const IdentIndex *index, uint32_t slot, IdentCursor *cursor) {
+    const IdentIndexName *entry = &index->names[slot];
+    uint64_t size = index->size - index->header->postings_offset;
+    memset(cursor, 0, sizeof(*cursor));
+    cursor->file_count = index->header->file_count;
+    if (entry->postings <= size && entry->postings_length <= size - entry->postings) {
+        cursor->next = index->postings + entry->postings;
+        cursor->end = cursor->next + entry->postings_length;
+    }
+}
+
+/* 读取一个varint，数据不完整或超过32位时返回false */
+static bool read_varint(IdentCursor *cursor, uint32_t *value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (cursor->next == cursor->end) return false;
+        uint8_t byte = *cursor->next++;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            if (result > UINT32_MAX) return false;
+            *value = (uint32_t)result;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ident_index_next(IdentCursor *cursor) {
+    uint32_t file, offset, line;
+    if (cursor->next == cursor->end || !read_varint(cursor, &file) ||
+        !read_varint(cursor, &offset) || !read_varint(cursor, &line)) {
+        return false;
+    }
+
+    IdentPosting *p = &cursor->posting;
+    if (file != 0) {
+        p->offset = 0;
+        p->line = 0;
+    }
+    p->file += file;
+    p->offset += offset;
+    p->line += line;
+    return p->file < cursor->file_count;
+}
+
+bool ident_index_query(const IdentIndex *index, const char *name, const char *prefix,
+                       Writer *writer) {
+    uint32_t slot;
+    if (!ident_index_find(index, name, strlen(name), &slot)) {
+        return false;
+    }
+
+    IdentCursor cursor;
+    ident_index_cursor(index, slot, &cursor);
+    while (ident_index_next(&cursor)) {
+        size_t length;
+        const char *path = ident_index_path(index, cursor.posting.file, &length);
+        if (!path) break;
+        writer_cstr(writer, "{\"file\":\"");
+        writer_json_escaped(writer, prefix, strlen(prefix));
+        writer_json_escaped(writer, path, length);
+        writer_cstr(writer, "\",\"line\":");
+        writer_uint(writer, cursor.posting.line);
+        writer_cstr(writer, ",\"offset\":");
+        writer_uint(writer, cursor.posting.offset);
+        writer_cstr(writer, "}\n");
+    }
+    return true;
+}
@@ -0,0 +1,116 @@
+#ifndef IDENT_INDEX_H
+#define IDENT_INDEX_H
+
+#include "writer.h"
+#include "common.h"
+
+#define IDENT_INDEX_MAGIC "JSIX"
+#define IDENT_INDEX_VERSION 2
+#define IDENT_INDEX_BYTE_ORDER 0x01020304u
+#define IDENT_INDEX_FILE ".jsindex"     /* 目录中默认的索引文件名 */
+
+/*
+ * 标识符倒排索引文件格式（可直接mmap查询）：
+ *   [IdentIndexHeader][IdentIndexFile * file_count][IdentIndexName * name_count]
+ *   [字符串区][倒排表区]
+ * 文件按相对路径排序，名字按文本（字节序）排序，查询时二分查找。
+ * 每个名字的倒排表按（文件, 偏移）递增，每一项是三个LEB128变长整数：
+ * 文件编号之差，然后是偏移和行号——同一文件内为与上一项之差，换文件时为绝对值。
+ * 文件的mtime、大小和内容哈希用于增量更新：未变的文件直接沿用旧索引中的倒排项。
+ */
+typedef struct {
+    char magic[4];              /* "JSIX" */
+    uint32_t version;           /* IDENT_INDEX_VERSION */
+    uint32_t byte_order;        /* IDENT_INDEX_BYTE_ORDER */
+    uint32_t file_count;
+    uint32_t name_count;
+    uint32_t reserved;
+    uint64_t files_offset;
+    uint64_t names_offset;
+    uint64_t strings_offset;
+    uint64_t postings_offset;
+    uint64_t file_size;
+} IdentIndexHeader;
+
+/* 一个被索引的文件 */
+typedef struct {
+    uint64_t mtime;             /* 修改时间（纳秒） */
+    uint64_t size;
+    uint64_t hash;              /* 内容的FNV-1a哈希 */
+    uint32_t path;              /* 相对路径在字符串区中的偏移 */
+    uint32_t path_length;
+} IdentIndexFile;
+
+/* 一个名字 */
+typedef struct {
+    uint64_t postings;          /* 倒排表在倒排表区中的偏移 */
+    uint32_t postings_length;   /* 倒排表的字节数 */
+    uint32_t count;             /* 出现次数 */
+    uint32_t text;              /* 名字在字符串区中的偏移 */
+    uint32_t text_length;
+} IdentIndexName;
+
+/* 已加载的索引（只读） */
+typedef struct {
+    const IdentIndexHeader *header;
+    const IdentIndexFile *files;
+    const IdentIndexName *names;
+    const char *strings;
+    const uint8_t *postings;
+    void *data;                 /* 整个文件 */
+    size_t size;
+    bool mapped;                /* data来自mmap（否则为malloc） */
+} IdentIndex;
+
+/* 一次出现 */
+typedef struct {
+    uint32_t file;
+    uint32_t offset;            /* 字节偏移 */
+    uint32_t line;              /* 行号（从1开始） */
+} IdentPosting;
+
+/* 构建统计 */
+typedef struct {
+    size_t files;
+    size_t reused;              /* mtime和大小未变，或内容哈希未变 */
+    size_t lexed;               /* 新增或内容改变，重新做词法分析 */
+    size_t removed;             /* 旧索引中有、目录中已不存在 */
+    size_t failed;              /* 读取失败或有词法错误（错误之前的部分仍然索引） */
+    size_t names;
+    size_t postings;
+    size_t bytes;               /* 索引文件大小 */
+} IdentIndexStats;
+
+/* 扫描目录（跳过以'.'开头的项和node_modules）中的.js/.mjs/.cjs文件，
+   建立或增量更新索引文件index_path（thread_count <= 0 时使用CPU核数） */
+bool ident_index_build(const char *dir, const char *index_path, int thread_count,
+                       IdentIndexStats *stats, ErrorInfo *error);
+
+/* 加载和释放索引文件 */
+bool ident_index_load(IdentIndex *index, const char *path);
+void ident_index_close(IdentIndex *index);
+
+/* 查找名字，找不到返回false */
+bool ident_index_find(const IdentIndex *index, const char *name, size_t length, uint32_t *slot);
+
+/* 倒排表的解码位置 */
+typedef struct {
+    const uint8_t *next;
+    const uint8_t *end;
+    uint32_t file_count;        /* 文件编号越界视为数据损坏 */
+    IdentPosting posting;       /* 刚解码的一项 */
+} IdentCursor;
+
+/* 从第slot个名字的倒排表开头解码；ident_index_next返回false表示结束（或数据损坏） */
+void ident_index_cursor(const IdentIndex *index, uint32_t slot, IdentCursor *cursor);
+bool ident_index_next(IdentCursor *cursor);
+
+/* 文件编号对应的相对路径 */
+const char* ident_index_path(const IdentIndex *index, uint32_t file, size_t *length);
+
+/* 每次出现输出一行JSON：{"file":...,"line":...,"offset":...}，路径前加上prefix；
+   名字不在索引中返回false */
+bool ident_index_query(const IdentIndex *index, const char *name, const char *prefix,
+                       Writer *writer);
+
+#endif /* IDENT_INDEX_H */
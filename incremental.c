@@ -0,0 +1,443 @@
+#include "incremental.h"
+
+/*
+ * 增量解析
+ *
+ * 成功解析时语法分析器记录每条语句的范围（StatementTable）。编辑后：
+ *   1. 修改文本，把所有语句范围按编辑平移（被删除区间内的偏移收缩到编辑起点）；
+ *   2. 找到完整包含全部改动的最内层语句，从它的第一个token起单独重新解析；
+ *   3. 校验重新解析的结果与整体解析等价：第一个token不变，解析在原先的结束位置
+ *      （平移后）恰好停下，且其后的token及词法上下文都不变。位于语句列表中的语句
+ *      允许解析出多条语句，或越过后续的兄弟语句，直到与某个原有边界重新对齐；
+ *   4. 校验失败时尝试外层语句，仍失败则整体重新解析，因此结果（包括第一个错误）
+ *      总是与整体解析一致。
+ * 语法分析器不依赖外层上下文，所以语句之外的部分不需要重新解析。
+ *
+ * 编辑器中的文本大部分时间处于输入了一半的错误状态。出错后保留最近一次语法正确时的
+ * 语句范围表，继续按编辑平移，并累计此后所有编辑覆盖的范围：下一次编辑仍从包含
+ * 该范围的语句重新解析。这条语句之前的文本没有变化，从它开始的解析与整体解析走
+ * 同样的路径，所以其中遇到的语法错误就是整体解析的第一个错误，不需要整体解析。
+ * 重新解析时遇到编辑范围之后、文本未改动的语句直接越过（Parser.reuse），
+ * 所以即使新输入的 { 还没有配对、错误要到文件末尾才出现，也不必逐token解析后面的部分。
+ */
+
+/* 最多尝试的外层语句数，超过后直接整体解析 */
+#define INCREMENTAL_MAX_ATTEMPTS 3
+
+/* 整体解析并重建语句范围表 */
+static bool incremental_full_parse(IncrementalDocument *doc) {
+    Position origin = {1, 1, 0};
+
+    statement_table_free(&doc->statements);
+    memset(&doc->statements, 0, sizeof(doc->statements));
+    doc->statements.open = STATEMENT_NONE;
+    memset(&doc->error, 0, sizeof(doc->error));
+    doc->full_reparse = true;
+    doc->reparsed_start = 0;
+    doc->reparsed_end = doc->length;
+    doc->dirty_start = SIZE_MAX;
+    doc->dirty_end = 0;
+
+    Lexer *lexer = lexer_create(doc->source, doc->length, &doc->error);
+    Parser *parser = lexer ? parser_create(lexer, &doc->error) : NULL;
+    if (!parser) {
+        lexer_destroy(lexer);
+        set_error(&doc->error, ERROR_OUT_OF_MEMORY, origin, "Out of memory");
+        doc->valid = false;
+        return false;
+    }
+
+    parser->statements = &doc->statements;
+    parser->module = doc->module;
+    doc->valid = parser_parse(parser) && doc->error.code == ERROR_NONE;
+
+    parser_destroy(parser);
+    lexer_destroy(lexer);
+
+    /* 失败时的记录不完整，下一次更新需要整体解析 */
+    if (!doc->valid || doc->statements.failed) {
+        statement_table_free(&doc->statements);
+    }
+    return doc->valid;
+}
+
+/* 创建文档并整体解析一次 */
+IncrementalDocument* incremental_create(const char *source, size_t length, bool module) {
+    IncrementalDocument *doc = (IncrementalDocument*)calloc(1, sizeof(IncrementalDocument));
+    if (!doc) return NULL;
+
+    doc->capacity = length + 1;
+    doc->source = (char*)malloc(doc->capacity);
+    if (!doc->source) {
+        free(doc);
+        return NULL;
+    }
+    memcpy(doc->source, source, length);
+    doc->source[length] = '\0';
+    doc->length = length;
+    doc->module = module;
+
+    incremental_full_parse(doc);
+    return doc;
+}
+
+/* 销毁文档 */
+void incremental_destroy(IncrementalDocument *doc) {
+    if (doc) {
+        statement_table_free(&doc->statements);
+        free(doc->source);
+        free(doc);
+    }
+}
+
+/* 编辑前的偏移映射到编辑后：被删除区间内的偏移收缩到编辑起点 */
+static size_t map_offset(size_t x, const TextEdit *edit) {
+    if (x < edit->offset) return x;
+    if (x >= edit->offset + edit->removed) return x - edit->removed + edit->text_length;
+    return edit->offset;
+}
+
+/* 修改文本 */
+static bool apply_text_edit(IncrementalDocument *doc, const TextEdit *edit) {
+    size_t length = doc->length - edit->removed + edit->text_length;
+
+    if (length + 1 > doc->capacity) {
+        size_t capacity = doc->capacity * 2;
+        if (capacity < length + 1) capacity = length + 1;
+        char *source = (char*)realloc(doc->source, capacity);
+        if (!source) return false;
+        doc->source = source;
+        doc->capacity = capacity;
+    }
+
+    size_t tail = edit->offset + edit->removed;
+    if (edit->removed != edit->text_length) {
+        memmove(doc->source + edit->offset + edit->text_length, doc->source + tail,
+                doc->length - tail);
+    }
+    memcpy(doc->source + edit->offset, edit->text, edit->text_length);
+    doc->length = length;
+    doc->source[length] = '\0';
+    return true;
+}
+
+/* 最后一个起点不超过offset的语句 */
+static size_t last_starting_at(const StatementTable *table, size_t offset) {
+    size_t a = 0;
+    size_t b = table->count;
+    while (a < b) {
+        size_t mid = a + (b - a) / 2;
+        if (table->spans[mid].start <= offset) {
+            a = mid + 1;
+        } else {
+            b = mid;
+        }
+    }
+    return a == 0 ? STATEMENT_NONE : a - 1;
+}
+
+/* 按编辑平移语句范围：起点在编辑之前的语句中，只有包含编辑起点的那一串外层语句
+   的结束位置可能受影响，其余只需平移编辑之后的语句 */
+static void shift_statements(StatementTable *table, const TextEdit *edit) {
+    size_t i = table->count > 0 && edit->offset > 0 ?
+               last_starting_at(table, edit->offset - 1) : STATEMENT_NONE;
+    size_t tail = i == STATEMENT_NONE ? 0 : i + 1;
+
+    for (; i != STATEMENT_NONE; i = table->spans[i].parent) {
+        table->spans[i].end = map_offset(table->spans[i].end, edit);
+    }
+    for (size_t j = tail; j < table->count; j++) {
+        table->spans[j].start = map_offset(table->spans[j].start, edit);
+        table->spans[j].end = map_offset(table->spans[j].end, edit);
+    }
+}
+
+/* 包含 [lo, hi] 的最内层语句。语句的起点必须严格在lo之前：
+   第一个token之前的空白和注释若被修改，单独解析时无法得知原先的词法上下文 */
+static size_t find_enclosing(const StatementTable *table, size_t lo, size_t hi) {
+    /* 包含lo的语句只可能是最后一个起点不超过lo的语句或它的外层 */
+    size_t i = last_starting_at(table, lo);
+    while (i != STATEMENT_NONE &&
+           !(table->spans[i].start < lo && hi <= table->spans[i].end)) {
+        i = table->spans[i].parent;
+    }
+    return i;
+}
+
+/* 从index起向外找第一条可以单独解析的语句：${} 中的语句之后的 } 属于模板，
+   单独解析时的词法分析器无从得知 */
+static size_t outside_template(const StatementTable *table, size_t index) {
+    while (index != STATEMENT_NONE && table->spans[index].in_template) {
+        index = table->spans[index].parent;
+    }
+    return index;
+}
+
+/* 下一个兄弟语句 */
+static size_t next_sibling(const StatementTable *table, size_t index) {
+    size_t next = table->spans[index].subtree_end;
+    if (next < table->count && table->spans[next].parent == table->spans[index].parent) {
+        return next;
+    }
+    return STATEMENT_NONE;
+}
+
+/* 从语句index起单独重新解析，校验与整体解析等价。
+   成功时fresh中是新的语句范围，*last是被覆盖的最后一条原有兄弟语句；
+   失败时若遇到了语法错误则记录在failure中（只有偏移有效，行列需要重新计算） */
+static bool reparse_statement(IncrementalDocument *doc, size_t index,
+                              StatementTable *fresh, size_t *last, ErrorInfo *failure) {
+    const StatementTable *table = &doc->statements;
+    const StatementSpan *span = &table->spans[index];
+    ErrorInfo error = {0};
+    Position start = {1, 1, (int)span->start};
+
+    Lexer *lexer = lexer_create_at(doc->source + span->start, doc->length - span->start,
+                                   start, &error);
+    if (!lexer) return false;
+    lexer->last_was_newline = span->first_newline;
+
+    Parser *parser = parser_create(lexer, &error);
+    if (!parser) {
+        lexer_destroy(lexer);
+        return false;
+    }
+
+    bool ok = false;
+    Token *first = parser->current_token;
+    if (first->type == span->first_type && first->length == span->first_length &&
+        (size_t)first->start.offset == span->start) {
+        /* 恢复读入第一个token之后的正则上下文 */
+        lexer_set_regex_allowed(lexer, span->first_regex);
+        parser->statements = fresh;
+        parser->depth = span->depth;
+        parser->module = doc->module;
+        parser->in_async = span->in_async;
+        parser->in_generator = span->in_generator;
+        parser->reuse = table;
+        parser->reuse_from = doc->dirty_end;
+
+        size_t covered = index;
+        size_t target = span->end;
+        for (;;) {
+            if (!parse_statement(parser) || error.code != ERROR_NONE || fresh->failed) {
+                if (error.code != ERROR_NONE && error.code != ERROR_OUT_OF_MEMORY &&
+                    !fresh->failed) {
+                    *failure = error;
+                }
+                break;
+            }
+            fresh->spans[fresh->last].in_list = span->in_list;
+
+            Token *current = parser->current_token;
+            size_t pos = (size_t)current->start.offset;
+
+            /* 解析越过了原有边界：在语句列表中尝试与后面的兄弟语句对齐 */
+            while (pos > target && span->in_list) {
+                size_t next = next_sibling(table, covered);
+                if (next == STATEMENT_NONE) break;
+                covered = next;
+                target = table->spans[next].end;
+            }
+
+            if (pos == target) {
+                const StatementSpan *tail = &table->spans[covered];
+                ok = current->type == tail->follow_type &&
+                     current->length == tail->follow_length &&
+                     current->preceded_by_newline == tail->follow_newline &&
+                     lexer_regex_allowed(lexer) == tail->follow_regex;
+                *last = covered;
+                break;
+            }
+
+            /* 只有语句列表中可以继续解析新插入的语句 */
+            if (pos > target || !span->in_list ||
+                current->type == TOKEN_RBRACE || current->type == TOKEN_CASE ||
+                current->type == TOKEN_DEFAULT || current->type == TOKEN_EOF) {
+                break;
+            }
+        }
+    }
+
+    parser_destroy(parser);
+    lexer_destroy(lexer);
+    return ok;
+}
+
+/* 用fresh替换语句 [first, end) 的记录，并修正其余记录中的下标 */
+static bool splice_statements(StatementTable *table, size_t first, size_t end,
+                              const StatementTable *fresh) {
+    size_t parent = table->spans[first].parent;
+    size_t removed = end - first;
+    size_t count = table->count - removed + fresh->count;
+
+    if (count > table->capacity) {
+        StatementSpan *spans = (StatementSpan*)realloc(table->spans,
+                                                       count * sizeof(StatementSpan));
+        if (!spans) return false;
+        table->spans = spans;
+        table->capacity = count;
+    }
+
+    if (removed != fresh->count) {
+        memmove(table->spans + first + fresh->count, table->spans + end,
+                (table->count - end) * sizeof(StatementSpan));
+    }
+
+    for (size_t i = 0; i < fresh->count; i++) {
+        StatementSpan *span = &table->spans[first + i];
+        *span = fresh->spans[i];
+        span->parent = span->parent == STATEMENT_NONE ? parent : span->parent + first;
+        span->subtree_end += first;
+    }
+
+    /* 外层语句和后面的语句：指向被替换区间之后的下标整体平移 */
+    for (size_t i = 0; i < count && removed != fresh->count; i++) {
+        if (i == first) i += fresh->count;
+        if (i >= count) break;
+        StatementSpan *span = &table->spans[i];
+        if (span->parent != STATEMENT_NONE && span->parent >= end) {
+            span->parent = span->parent - removed + fresh->count;
+        }
+        if (span->subtree_end >= end) {
+            span->subtree_end = span->subtree_end - removed + fresh->count;
+        }
+    }
+
+    table->count = count;
+    return true;
+}
+
+/* 偏移处的行列（与词法分析器一致：\n、\r\n、\r换行，列按字节计算） */
+static Position locate(const char *source, size_t offset) {
+    Position position = {1, 1, (int)offset};
+    const char *end = source + offset;
+    const char *line_start = source;
+
+    for (const char *p = source; (p = (const char*)memchr(p, '\n', (size_t)(end - p))) != NULL; ) {
+        position.line++;
+        line_start = ++p;
+    }
+    for (const char *p = source; (p = (const char*)memchr(p, '\r', (size_t)(end - p))) != NULL; ) {
+        if (++p == end || *p != '\n') {
+            position.line++;
+            if (p > line_start) line_start = p;
+        }
+    }
+    position.column = (int)(end - line_start) + 1;
+    return position;
+}
+
+/* 修改文本（不重新解析） */
+bool incremental_edit(IncrementalDocument *doc, const TextEdit *edit) {
+    Position origin = {1, 1, 0};
+
+    if (edit->offset > doc->length || edit->removed > doc->length - edit->offset) {
+        memset(&doc->error, 0, sizeof(doc->error));
+        set_error(&doc->error, ERROR_INVALID_EDIT, origin, "Edit range out of bounds");
+        return false;
+    }
+
+    StatementTable *table = &doc->statements;
+    if (!apply_text_edit(doc, edit)) {
+        statement_table_free(table);
+        set_error(&doc->error, ERROR_OUT_OF_MEMORY, origin, "Out of memory");
+        doc->valid = false;
+        return false;
+    }
+
+    shift_statements(table, edit);
+
+    if (doc->dirty_start == SIZE_MAX) {
+        doc->dirty_start = edit->offset;
+        doc->dirty_end = edit->offset + edit->text_length;
+    } else {
+        doc->dirty_start = map_offset(doc->dirty_start, edit);
+        doc->dirty_end = map_offset(doc->dirty_end, edit);
+        if (edit->offset < doc->dirty_start) doc->dirty_start = edit->offset;
+        if (edit->offset + edit->text_length > doc->dirty_end) {
+            doc->dirty_end = edit->offset + edit->text_length;
+        }
+    }
+    doc->pending = true;
+    return true;
+}
+
+/* 为incremental_edit之后的文本更新解析结果，返回当前文本是否语法正确 */
+bool incremental_reparse(IncrementalDocument *doc) {
+    if (!doc->pending) return doc->valid;
+    doc->pending = false;
+
+    /* 没有可用的语句范围（文档创建时就有错误，或内存不足） */
+    StatementTable *table = &doc->statements;
+    if (table->count == 0) {
+        return incremental_full_parse(doc);
+    }
+
+    size_t index = outside_template(table, find_enclosing(table, doc->dirty_start,
+                                                          doc->dirty_end));
+    for (int attempt = 0; attempt < INCREMENTAL_MAX_ATTEMPTS && index != STATEMENT_NONE;
+         attempt++) {
+        StatementTable fresh = {0};
+        fresh.open = STATEMENT_NONE;
+        size_t last = index;
+        ErrorInfo failure = {0};
+
+        if (reparse_statement(doc, index, &fresh, &last, &failure)) {
+            size_t start = table->spans[index].start;
+            size_t end = table->spans[last].end;
+            bool spliced = splice_statements(table, index, table->spans[last].subtree_end,
+                                             &fresh);
+            statement_table_free(&fresh);
+            if (!spliced) break;
+
+            doc->valid = true;
+            memset(&doc->error, 0, sizeof(doc->error));
+            doc->full_reparse = false;
+            doc->reparsed_start = start;
+            doc->reparsed_end = end;
+            doc->dirty_start = SIZE_MAX;
+            doc->dirty_end = 0;
+            return true;
+        }
+        statement_table_free(&fresh);
+
+        /* 语法错误：就是整体解析的第一个错误。语句范围表保持不变，
+           累计的编辑范围留给下一次编辑 */
+        if (failure.code != ERROR_NONE) {
+            size_t start = table->spans[index].start;
+            failure.position = locate(doc->source, (size_t)failure.position.offset);
+            doc->valid = false;
+            doc->error = failure;
+            doc->full_reparse = false;
+            doc->reparsed_start = start;
+            doc->reparsed_end = (size_t)failure.position.offset;
+            return false;
+        }
+
+        index = outside_template(table, table->spans[index].parent);
+    }
+
+    return incremental_full_parse(doc);
+}
+
+/* 应用一组编辑并更新解析结果，返回当前文本是否语法正确 */
+bool incremental_apply(IncrementalDocument *doc, const TextEdit *edits, size_t count) {
+    Position origin = {1, 1, 0};
+
+    /* 先校验所有编辑的范围，保证失败时文档不被修改 */
+    size_t length = doc->length;
+    for (size_t i = 0; i < count; i++) {
+        if (edits[i].offset > length || edits[i].removed > length - edits[i].offset) {
+            memset(&doc->error, 0, sizeof(doc->error));
+            set_error(&doc->error, ERROR_INVALID_EDIT, origin, "Edit range out of bounds");
+            return false;
+        }
+        length = length - edits[i].removed + edits[i].text_length;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (!incremental_edit(doc, &edits[i])) return false;
+    }
+    return incremental_reparse(doc);
+}
@@ -0,0 +1,42 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include "parser.h"
+
+/* 文本编辑：把 [offset, offset + removed) 替换为text。
+   多个编辑按顺序应用，每个编辑的偏移基于前一个编辑之后的文本 */
+typedef struct {
+    size_t offset;
+    size_t removed;
+    const char *text;
+    size_t text_length;
+} TextEdit;
+
+/* 增量解析文档 */
+typedef struct {
+    char *source;               /* 当前文本（以'\0'结尾） */
+    size_t length;
+    size_t capacity;
+    bool module;                /* 按模块解析 */
+    StatementTable statements;  /* 最近一次语法正确时记录的语句范围（已按其后的编辑平移） */
+    bool valid;                 /* 当前文本是否语法正确 */
+    ErrorInfo error;            /* 第一个错误（valid为false时） */
+    bool full_reparse;          /* 上一次更新是否整体重新解析 */
+    size_t reparsed_start;      /* 上一次更新重新解析的范围 */
+    size_t reparsed_end;
+    bool pending;               /* 有尚未重新解析的编辑 */
+    size_t dirty_start;         /* 语句范围记录之后的全部编辑在当前文本中覆盖的范围 */
+    size_t dirty_end;           /* （没有编辑时dirty_start为SIZE_MAX） */
+} IncrementalDocument;
+
+/* 增量解析函数声明 */
+IncrementalDocument* incremental_create(const char *source, size_t length, bool module);
+void incremental_destroy(IncrementalDocument *doc);
+bool incremental_apply(IncrementalDocument *doc, const TextEdit *edits, size_t count);
+
+/* 分两步更新：incremental_edit只修改文本（可以连续多次），
+   incremental_reparse再一次性重新解析，返回当前文本是否语法正确 */
+bool incremental_edit(IncrementalDocument *doc, const TextEdit *edit);
+bool incremental_reparse(IncrementalDocument *doc);
+
+#endif /* INCREMENTAL_H */
@@ -1,4 +1,8 @@
 #include "lexer.h"
+#include "atom.h"
+#include "cooked.h"
+#include "numeric.h"
+#include "regexp.h"
 
 /* 关键字映射表 */
 typedef struct {
@@ -66,6 +70,13 @@ bool is_keyword(const char *str, size_t len, TokenType *type) {
     return false;
 }
 
+/* 关键字表的第index项，越界返回NULL */
+const char* keyword_at(size_t index, TokenType *type) {
+    if (index >= sizeof(keywords) / sizeof(keywords[0]) - 1) return NULL;
+    if (type) *type = keywords[index].type;
+    return keywords[index].keyword;
+}
+
 /* 判断token类型是否可以在正则表达式之前出现 */
 bool can_precede_regex(TokenType type) {
     switch (type) {
@@ -104,7 +115,11 @@ static Token* token_create(TokenType type, const char *value, size_t length,
     if (!token) return NULL;
     
     token->type = type;
+    token->atom = ATOM_NONE;
     token->length = length;
+    token->cooked = NULL;
+    token->cooked_length = 0;
+    token->number = 0;
     token->start = start;
     token->end = end;
     token->preceded_by_newline = preceded_by_newline;
@@ -125,11 +140,49 @@ static Token* token_create(TokenType type, const char *value, size_t length,
 /* 销毁Token */
 void token_destroy(Token *token) {
     if (token) {
-        if (token->value) free(token->value);
+        if (token->value && token->atom == ATOM_NONE) free(token->value);
         free(token);
     }
 }
 
+/* 从原子表创建Token：value借用原子的文本，不再拷贝 */
+static Token* token_create_atom(Lexer *lexer, TokenType type, const char *value, size_t length,
+                                Position start, Position end, bool preceded_by_newline) {
+    uint32_t atom = atom_intern(lexer->atoms, value, length);
+    if (atom == ATOM_NONE) {
+        set_error(lexer->error, ERROR_OUT_OF_MEMORY, start, "Out of memory");
+        return NULL;
+    }
+    
+    Token *token = token_create(type, NULL, 0, start, end, preceded_by_newline);
+    if (!token) return NULL;
+    
+    token->atom = atom;
+    token->value = (char*)atom_text(lexer->atoms, atom, &token->length);
+    if (type == TOKEN_IDENTIFIER) {
+        token->type = atom_keyword(lexer->atoms, atom);
+    }
+    return token;
+}
+
+/* 保存当前token的副本以供上下文判断（原子文本直接借用） */
+static void remember_token(Lexer *lexer, const Token *token) {
+    if (lexer->prev_token) token_destroy(lexer->prev_token);
+    if (token->atom != ATOM_NONE) {
+        lexer->prev_token = token_create(token->type, NULL, 0, token->start,
+                                         token->end, token->preceded_by_newline);
+        if (lexer->prev_token) {
+            lexer->prev_token->atom = token->atom;
+            lexer->prev_token->value = token->value;
+            lexer->prev_token->length = token->length;
+        }
+        return;
+    }
+    lexer->prev_token = token_create(token->type, token->value, token->length,
+                                     token->start, token->end,
+                                     token->preceded_by_newline);
+}
+
 /* 创建词法分析器 */
 Lexer* lexer_create(const char *source, size_t length, ErrorInfo *error) {
     Lexer *lexer = (Lexer*)malloc(sizeof(Lexer));
@@ -144,16 +197,59 @@ Lexer* lexer_create(const char *source, size_t length, ErrorInfo *error) {
     lexer->error = error;
     lexer->last_was_newline = false;
     lexer->prev_token = NULL;
+    lexer->trivia = NULL;
+    lexer->trivia_line = 1;
+    lexer->atoms = NULL;
+    lexer->strings = NULL;
+    lexer->regexps = NULL;
+    lexer->owns_regexps = false;
+    lexer->braces = 0;
+    lexer->templates = 0;
+    
+    return lexer;
+}
+
+/* 从源码中间某个位置开始创建词法分析器（source已指向该位置，start为其绝对位置） */
+Lexer* lexer_create_at(const char *source, size_t length, Position start, ErrorInfo *error) {
+    Lexer *lexer = lexer_create(source, length, error);
+    if (!lexer) return NULL;
     
+    lexer->position = start;
     return lexer;
 }
 
+/* 当前状态下 / 是否会被识别为正则表达式的开始 */
+bool lexer_regex_allowed(const Lexer *lexer) {
+    return lexer->prev_token && can_precede_regex(lexer->prev_token->type);
+}
+
+/* 当前是否位于模板替换 ${} 之中（从这里恢复词法分析需要模板的嵌套状态） */
+bool lexer_in_template(const Lexer *lexer) {
+    return lexer->templates > 0;
+}
+
+/* 设置正则/除法判定的上下文（用于从源码中间恢复词法分析） */
+void lexer_set_regex_allowed(Lexer *lexer, bool allowed) {
+    if (lexer->prev_token) {
+        token_destroy(lexer->prev_token);
+        lexer->prev_token = NULL;
+    }
+    if (allowed) {
+        /* 任何can_precede_regex为真的类型都等价，这里使用分号 */
+        lexer->prev_token = token_create(TOKEN_SEMICOLON, ";", 1, lexer->position,
+                                         lexer->position, false);
+    }
+}
+
 /* 销毁词法分析器 */
 void lexer_destroy(Lexer *lexer) {
     if (lexer) {
         if (lexer->prev_token) {
             token_destroy(lexer->prev_token);
         }
+        if (lexer->owns_regexps) {
+            regexp_cache_destroy(lexer->regexps);
+        }
         free(lexer);
     }
 }
@@ -192,12 +288,39 @@ static char advance(Lexer *lexer) {
     return ch;
 }
 
-/* 跳过空白字符 */
+/* 解码当前位置的UTF-8字符，*size为字节数（不合法的序列*size为1） */
+static uint32_t peek_code_point(Lexer *lexer, size_t *size) {
+    return utf8_decode(lexer->source + lexer->current, lexer->source_length - lexer->current, size);
+}
+
+/* 前进一个多字节字符（列号与advance一样按字节计） */
+static void advance_bytes(Lexer *lexer, size_t size) {
+    lexer->current += size;
+    lexer->position.offset += (int)size;
+    lexer->position.column += (int)size;
+}
+
+/* 当前位置是否为非ASCII的行终止符（U+2028、U+2029） */
+static bool at_unicode_line_terminator(Lexer *lexer) {
+    size_t size;
+    return (uint8_t)peek(lexer, 0) >= 0x80 && is_line_terminator(peek_code_point(lexer, &size));
+}
+
+/* 跳过空白字符（U+2028、U+2029按换行处理，但不计入行号） */
 static void skip_whitespace(Lexer *lexer) {
     while (lexer->current < lexer->source_length) {
         char ch = peek(lexer, 0);
         
-        if (is_whitespace(ch)) {
+        if ((uint8_t)ch >= 0x80) {
+            size_t size;
+            uint32_t cp = peek_code_point(lexer, &size);
+            if (is_line_terminator(cp)) {
+                lexer->last_was_newline = true;
+            } else if (!is_whitespace(cp) || size == 1) {
+                break;
+            }
+            advance_bytes(lexer, size);
+        } else if (is_whitespace(ch)) {
             advance(lexer);
         } else if (ch == '\n' || ch == '\r') {
             advance(lexer);
@@ -215,7 +338,7 @@ static void skip_line_comment(Lexer *lexer) {
     
     while (lexer->current < lexer->source_length) {
         char ch = peek(lexer, 0);
-        if (is_line_terminator(ch)) {
+        if (is_line_terminator(ch) || at_unicode_line_terminator(lexer)) {
             break;
         }
         advance(lexer);
@@ -235,6 +358,9 @@ static bool skip_block_comment(Lexer *lexer) {
             advance(lexer);
             return true;
         }
+        if (at_unicode_line_terminator(lexer)) {
+            lexer->last_was_newline = true;
+        }
         advance(lexer);
     }
     
@@ -268,9 +394,9 @@ static bool parse_unicode_escape(Lexer *lexer, uint32_t *result) {
     return true;
 }
 
-/* 读取标识符 */
+/* 读取标识符（第一个字符已消耗） */
 static Token* read_identifier(Lexer *lexer, Position start) {
-    size_t start_pos = lexer->current - 1;
+    size_t start_pos = lexer->current - (size_t)(lexer->position.offset - start.offset);
     
     while (lexer->current < lexer->source_length) {
         char ch = peek(lexer, 0);
@@ -283,7 +409,15 @@ static Token* read_identifier(Lexer *lexer, Position start) {
             continue;
         }
         
-        if (is_unicode_id_continue((uint8_t)ch)) {
+        /* 非ASCII字符先解码，再查ID_Continue */
+        if ((uint8_t)ch >= 0x80) {
+            size_t size;
+            uint32_t cp = peek_code_point(lexer, &size);
+            if (size == 1 || !is_unicode_id_continue(cp)) {
+                break;
+            }
+            advance_bytes(lexer, size);
+        } else if (is_unicode_id_continue((uint8_t)ch)) {
             advance(lexer);
         } else {
             break;
@@ -293,6 +427,12 @@ static Token* read_identifier(Lexer *lexer, Position start) {
     size_t length = lexer->current - start_pos;
     const char *value = lexer->source + start_pos;
     
+    /* 原子表中预置了关键字，查一次即可得到类型 */
+    if (lexer->atoms) {
+        return token_create_atom(lexer, TOKEN_IDENTIFIER, value, length, start,
+                                 lexer->position, lexer->last_was_newline);
+    }
+    
     /* 检查是否为关键字 */
     TokenType type = TOKEN_IDENTIFIER;
     is_keyword(value, length, &type);
@@ -301,203 +441,302 @@ static Token* read_identifier(Lexer *lexer, Position start) {
                        lexer->last_was_newline);
 }
 
-/* 读取数字 */
+/* 读取数字：按文法检查并算出值（见numeric.h） */
 static Token* read_number(Lexer *lexer, Position start) {
     size_t start_pos = lexer->current - 1;
-    
-    /* 处理十六进制、八进制、二进制 */
-    char first = lexer->source[start_pos];
-    if (first == '0' && lexer->current < lexer->source_length) {
-        char next = peek(lexer, 0);
-        if (next == 'x' || next == 'X') {
-            /* 十六进制 */
-            advance(lexer);
-            while (lexer->current < lexer->source_length && 
-                   isxdigit(peek(lexer, 0))) {
-                advance(lexer);
-            }
-        } else if (next == 'b' || next == 'B') {
-            /* 二进制 */
-            advance(lexer);
-            while (lexer->current < lexer->source_length) {
-                char ch = peek(lexer, 0);
-                if (ch == '0' || ch == '1') advance(lexer);
-                else break;
-            }
-        } else if (next == 'o' || next == 'O') {
-            /* 八进制 */
-            advance(lexer);
-            while (lexer->current < lexer->source_length) {
-                char ch = peek(lexer, 0);
-                if (ch >= '0' && ch <= '7') advance(lexer);
-                else break;
-            }
-        }
-    }
-    
-    /* 读取整数部分 */
-    while (lexer->current < lexer->source_length && 
-           isdigit(peek(lexer, 0))) {
-        advance(lexer);
-    }
-    
-    /* 读取小数部分 */
-    if (peek(lexer, 0) == '.' && isdigit(peek(lexer, 1))) {
-        advance(lexer); /* . */
-        while (lexer->current < lexer->source_length && 
-               isdigit(peek(lexer, 0))) {
-            advance(lexer);
-        }
+    NumericLiteral literal;
+    size_t length;
+    const char *message;
+    
+    if (!numeric_scan(lexer->source + start_pos, lexer->source_length - start_pos,
+                      &literal, &length, &message)) {
+        Position at = start;
+        at.column += (int)length;
+        at.offset += (int)length;
+        set_error(lexer->error, ERROR_LEXER_INVALID_NUMBER, at, message);
+        return NULL;
     }
     
-    /* 读取指数部分 */
-    if (peek(lexer, 0) == 'e' || peek(lexer, 0) == 'E') {
-        advance(lexer);
-        if (peek(lexer, 0) == '+' || peek(lexer, 0) == '-') {
-            advance(lexer);
-        }
-        while (lexer->current < lexer->source_length && 
-               isdigit(peek(lexer, 0))) {
-            advance(lexer);
-        }
-    }
+    /* 数字字面量不跨行，只需前移列号 */
+    lexer->current = start_pos + length;
+    lexer->position.offset = start.offset + (int)length;
+    lexer->position.column = start.column + (int)length;
     
-    size_t length = lexer->current - start_pos;
-    return token_create(TOKEN_NUMBER, lexer->source + start_pos, length,
-                       start, lexer->position, lexer->last_was_newline);
+    Token *token = token_create(TOKEN_NUMBER, lexer->source + start_pos, length,
+                                start, lexer->position, lexer->last_was_newline);
+    if (token) token->number = literal.value;
+    return token;
 }
 
 /* 读取字符串 */
 static Token* read_string(Lexer *lexer, Position start, char quote) {
     size_t start_pos = lexer->current - 1;
-    
-    while (lexer->current < lexer->source_length) {
-        char ch = peek(lexer, 0);
+    bool escaped = false;
+    
+    for (;;) {
+        /* 跨过不含引号、反斜杠和换行的一段（同一行之内，只需前移列号） */
+        size_t run = cooked_scan(lexer->source + lexer->current,
+                                 lexer->source_length - lexer->current, quote);
+        lexer->current += run;
+        lexer->position.offset += (int)run;
+        lexer->position.column += (int)run;
         
+        char ch = peek(lexer, 0);
         if (ch == quote) {
             advance(lexer);
             break;
         } else if (ch == '\\') {
+            const char *escape = lexer->source + lexer->current + 1;
+            if (!cooked_valid_escape(escape, lexer->source_length - lexer->current - 1)) {
+                set_error(lexer->error, ERROR_LEXER_INVALID_UNICODE_ESCAPE, lexer->position,
+                         escape[0] == 'x' ? "Invalid hexadecimal escape sequence"
+                                          : "Invalid Unicode escape sequence");
+                return NULL;
+            }
+            escaped = true;
             advance(lexer);
             if (lexer->current < lexer->source_length) {
                 advance(lexer);
             }
-        } else if (is_line_terminator(ch)) {
+        } else {
+            /* 换行或文件结束 */
             set_error(lexer->error, ERROR_LEXER_UNTERMINATED_STRING,
                      lexer->position, "Unterminated string literal");
             return NULL;
-        } else {
-            advance(lexer);
         }
     }
     
     size_t length = lexer->current - start_pos;
-    return token_create(TOKEN_STRING, lexer->source + start_pos, length,
-                       start, lexer->position, lexer->last_was_newline);
+    Token *token;
+    if (lexer->atoms) {
+        token = token_create_atom(lexer, TOKEN_STRING, lexer->source + start_pos, length,
+                                  start, lexer->position, lexer->last_was_newline);
+    } else {
+        token = token_create(TOKEN_STRING, lexer->source + start_pos, length,
+                             start, lexer->position, lexer->last_was_newline);
+    }
+    if (!token || !lexer->strings) return token;
+    
+    /* 没有转义时值就是引号之间的源码 */
+    const char *body = lexer->source + start_pos + 1;
+    size_t body_length = length - 2;
+    if (!escaped) {
+        token->cooked = body;
+        token->cooked_length = body_length;
+    } else if (!cooked_intern(lexer->strings, body, body_length,
+                              &token->cooked, &token->cooked_length)) {
+        set_error(lexer->error, ERROR_OUT_OF_MEMORY, start, "Out of memory");
+        token_destroy(token);
+        return NULL;
+    }
+    return token;
 }
 
-/* 读取模板字符串 */
+/* 读取模板字符串的一段：从 ` 或与 ${ 配对的 } 开始，到 ` 或 ${ 为止。
+   以 ${ 结束时记下当时的 { 个数，其后的表达式照常分析，直到与之配对的 } 再读下一段 */
 static Token* read_template(Lexer *lexer, Position start) {
     size_t start_pos = lexer->current - 1;
+    bool substitution = false;
     
-    while (lexer->current < lexer->source_length) {
-        char ch = peek(lexer, 0);
+    for (;;) {
+        if (lexer->current >= lexer->source_length) {
+            set_error(lexer->error, ERROR_LEXER_UNTERMINATED_STRING,
+                     start, "Unterminated template literal");
+            return NULL;
+        }
         
+        char ch = peek(lexer, 0);
         if (ch == '`') {
             advance(lexer);
             break;
         } else if (ch == '\\') {
+            /* 没有带标签的模板，转义必须合法，也不能是传统八进制转义 */
+            const char *escape = lexer->source + lexer->current + 1;
+            size_t rest = lexer->source_length - lexer->current - 1;
+            const char *message = NULL;
+            if (!cooked_valid_escape(escape, rest)) {
+                message = escape[0] == 'x' ? "Invalid hexadecimal escape sequence"
+                                           : "Invalid Unicode escape sequence";
+            } else if (cooked_legacy_escape(escape, rest)) {
+                message = escape[0] >= '8' ? "\\8 and \\9 are not allowed in template strings"
+                                           : "Octal escape sequences are not allowed in template strings";
+            }
+            if (message) {
+                set_error(lexer->error, ERROR_LEXER_INVALID_UNICODE_ESCAPE, lexer->position, message);
+                return NULL;
+            }
             advance(lexer);
             if (lexer->current < lexer->source_length) {
                 advance(lexer);
             }
         } else if (ch == '$' && peek(lexer, 1) == '{') {
-            /* 处理模板表达式 ${...} - 简化处理 */
             advance(lexer);
             advance(lexer);
+            substitution = true;
+            break;
         } else {
             advance(lexer);
         }
     }
+    /* 模板中的换行不是token之间的换行 */
+    lexer->last_was_newline = false;
+    
+    if (lexer->source[start_pos] == '}') {
+        lexer->templates--;
+    }
+    if (substitution) {
+        if (lexer->templates == LEXER_TEMPLATE_DEPTH_MAX) {
+            set_error(lexer->error, ERROR_PARSER_UNEXPECTED_TOKEN,
+                     start, "Template literals nested too deeply");
+            return NULL;
+        }
+        lexer->template_braces[lexer->templates++] = lexer->braces;
+    }
     
     size_t length = lexer->current - start_pos;
-    return token_create(TOKEN_TEMPLATE, lexer->source + start_pos, length,
-                       start, lexer->position, lexer->last_was_newline);
+    Token *token = token_create(TOKEN_TEMPLATE, lexer->source + start_pos, length,
+                                start, lexer->position, false);
+    if (!token) return NULL;
+    
+    if (substitution) {
+        /* ${ 之后是表达式的开头 */
+        lexer_set_regex_allowed(lexer, true);
+    } else {
+        remember_token(lexer, token);
+    }
+    return token;
 }
 
 /* 读取正则表达式 */
 static Token* read_regex(Lexer *lexer, Position start) {
     size_t start_pos = lexer->current - 1;
+    bool in_class = false;
     
     /* 跳过开始的 / */
-    while (lexer->current < lexer->source_length) {
+    for (;;) {
         char ch = peek(lexer, 0);
         
-        if (ch == '/') {
-            advance(lexer);
-            /* 读取标志 */
-            while (lexer->current < lexer->source_length) {
-                char flag = peek(lexer, 0);
-                if (isalpha(flag)) {
-                    advance(lexer);
-                } else {
-                    break;
-                }
-            }
-            break;
+        if (lexer->current >= lexer->source_length || is_line_terminator(ch)) {
+            set_error(lexer->error, ERROR_LEXER_UNTERMINATED_REGEX,
+                     lexer->position, "Unterminated regular expression");
+            return NULL;
         } else if (ch == '\\') {
             advance(lexer);
-            if (lexer->current < lexer->source_length) {
+            if (lexer->current < lexer->source_length && !is_line_terminator(peek(lexer, 0))) {
                 advance(lexer);
             }
-        } else if (is_line_terminator(ch)) {
-            set_error(lexer->error, ERROR_LEXER_UNTERMINATED_REGEX,
-                     lexer->position, "Unterminated regular expression");
-            return NULL;
         } else if (ch == '[') {
-            /* 字符类 */
+            /* 字符类中的 / 不结束正则 */
+            in_class = true;
             advance(lexer);
-            while (lexer->current < lexer->source_length) {
-                char cls_ch = peek(lexer, 0);
-                if (cls_ch == ']') {
-                    advance(lexer);
-                    break;
-                } else if (cls_ch == '\\') {
-                    advance(lexer);
-                    if (lexer->current < lexer->source_length) {
-                        advance(lexer);
-                    }
-                } else {
-                    advance(lexer);
-                }
-            }
+        } else if (ch == ']') {
+            in_class = false;
+            advance(lexer);
+        } else if (ch == '/' && !in_class) {
+            advance(lexer);
+            break;
         } else {
             advance(lexer);
         }
     }
     
+    /* 读取标志（IdentifierPart，不合法的由regexp_compile报错） */
+    while (lexer->current < lexer->source_length) {
+        char flag = peek(lexer, 0);
+        if (isalnum((unsigned char)flag) || flag == '_' || flag == '$') {
+            advance(lexer);
+        } else {
+            break;
+        }
+    }
+    
     size_t length = lexer->current - start_pos;
+    
+    /* 检查模式和标志：同一个字面量只分析一次 */
+    if (!lexer->regexps) {
+        lexer->regexps = regexp_cache_create();
+        if (!lexer->regexps) {
+            set_error(lexer->error, ERROR_OUT_OF_MEMORY, start, "Out of memory");
+            return NULL;
+        }
+        lexer->owns_regexps = true;
+    }
+    const RegexpProgram *program;
+    RegexpError failure;
+    if (!regexp_compile(lexer->regexps, lexer->source + start_pos, length, &program, &failure)) {
+        if (failure.out_of_memory) {
+            set_error(lexer->error, ERROR_OUT_OF_MEMORY, start, "Out of memory");
+            return NULL;
+        }
+        /* 正则字面量不跨行，出错位置只需前移列号 */
+        char message[256];
+        Position at = start;
+        at.column += (int)failure.offset;
+        at.offset += (int)failure.offset;
+        snprintf(message, sizeof(message), "Invalid regular expression: %s", failure.message);
+        set_error(lexer->error, ERROR_LEXER_INVALID_REGEX, at, message);
+        return NULL;
+    }
+    
     return token_create(TOKEN_REGEX, lexer->source + start_pos, length,
                        start, lexer->position, lexer->last_was_newline);
 }
 
+/* 记录一条trivia（偏移不递增的重复记录忽略） */
+static void record_trivia(Lexer *lexer, TriviaKind kind, Position start) {
+    TriviaTable *table = lexer->trivia;
+    if (table->count > 0 && (uint32_t)start.offset < table->items[table->count - 1].end) {
+        return;
+    }
+    if (table->count == table->capacity) {
+        size_t capacity = table->capacity ? table->capacity * 2 : 64;
+        Trivia *items = (Trivia*)realloc(table->items, capacity * sizeof(Trivia));
+        if (!items) {
+            table->failed = true;
+            return;
+        }
+        table->items = items;
+        table->capacity = capacity;
+    }
+    
+    Trivia *trivia = &table->items[table->count++];
+    trivia->start = (uint32_t)start.offset;
+    trivia->end = (uint32_t)lexer->position.offset;
+    trivia->kind = (uint8_t)kind;
+    trivia->newline_before = start.line > lexer->trivia_line;
+    if (kind != TRIVIA_BLANK_LINE) {
+        lexer->trivia_line = lexer->position.line;
+    }
+}
+
 /* 获取下一个token */
 Token* lexer_next_token(Lexer *lexer) {
+    if (lexer->trivia) {
+        lexer->trivia_line = lexer->position.line;
+    }
+    
     /* 跳过空白和注释，但保留换行信息 */
     while (lexer->current < lexer->source_length) {
+        Position blank = lexer->position;
         skip_whitespace(lexer);
+        if (lexer->trivia && lexer->position.line - blank.line >= 2) {
+            record_trivia(lexer, TRIVIA_BLANK_LINE, blank);
+        }
         
         if (lexer->current >= lexer->source_length) break;
         
         char ch = peek(lexer, 0);
         char next = peek(lexer, 1);
+        Position start = lexer->position;
         
         if (ch == '/' && next == '/') {
             skip_line_comment(lexer);
+            if (lexer->trivia) record_trivia(lexer, TRIVIA_LINE_COMMENT, start);
         } else if (ch == '/' && next == '*') {
             if (!skip_block_comment(lexer)) {
                 return NULL;
             }
+            if (lexer->trivia) record_trivia(lexer, TRIVIA_BLOCK_COMMENT, start);
         } else {
             break;
         }
@@ -513,6 +752,27 @@ Token* lexer_next_token(Lexer *lexer) {
     }
     
     Position start = lexer->position;
+    
+    /* 非ASCII字符：空白和行终止符已跳过，剩下的只能是标识符开头 */
+    if ((uint8_t)peek(lexer, 0) >= 0x80) {
+        size_t size;
+        uint32_t cp = peek_code_point(lexer, &size);
+        if (size == 1 || !is_unicode_id_start(cp)) {
+            char msg[128];
+            snprintf(msg, sizeof(msg), size == 1 ? "Invalid UTF-8 byte 0x%02X" :
+                     "Invalid or unexpected token U+%04X", (unsigned)cp);
+            set_error(lexer->error, ERROR_LEXER_INVALID_CHAR, start, msg);
+            return NULL;
+        }
+        advance_bytes(lexer, size);
+        Token *token = read_identifier(lexer, start);
+        if (token) {
+            token->preceded_by_newline = had_newline;
+            remember_token(lexer, token);
+        }
+        return token;
+    }
+    
     char ch = advance(lexer);
     
     /* 标识符和关键字 */
@@ -521,24 +781,18 @@ Token* lexer_next_token(Lexer *lexer) {
         if (token) {
             token->preceded_by_newline = had_newline;
             /* 保存当前token以供上下文判断 */
-            if (lexer->prev_token) token_destroy(lexer->prev_token);
-            lexer->prev_token = token_create(token->type, token->value, 
-                                            token->length, token->start, 
-                                            token->end, token->preceded_by_newline);
+            remember_token(lexer, token);
         }
         return token;
     }
     
-    /* 数字 */
-    if (isdigit(ch)) {
+    /* 数字（包括.5） */
+    if (isdigit(ch) || (ch == '.' && isdigit(peek(lexer, 0)))) {
         Token *token = read_number(lexer, start);
         if (token) {
             token->preceded_by_newline = had_newline;
             /* 保存当前token以供上下文判断 */
-            if (lexer->prev_token) token_destroy(lexer->prev_token);
-            lexer->prev_token = token_create(token->type, token->value, 
-                                            token->length, token->start, 
-                                            token->end, token->preceded_by_newline);
+            remember_token(lexer, token);
         }
         return token;
     }
@@ -549,10 +803,7 @@ Token* lexer_next_token(Lexer *lexer) {
         if (token) {
             token->preceded_by_newline = had_newline;
             /* 保存当前token以供上下文判断 */
-            if (lexer->prev_token) token_destroy(lexer->prev_token);
-            lexer->prev_token = token_create(token->type, token->value, 
-                                            token->length, token->start, 
-                                            token->end, token->preceded_by_newline);
+            remember_token(lexer, token);
         }
         return token;
     }
@@ -560,14 +811,15 @@ Token* lexer_next_token(Lexer *lexer) {
     /* 模板字符串 */
     if (ch == '`') {
         Token *token = read_template(lexer, start);
-        if (token) {
-            token->preceded_by_newline = had_newline;
-            /* 保存当前token以供上下文判断 */
-            if (lexer->prev_token) token_destroy(lexer->prev_token);
-            lexer->prev_token = token_create(token->type, token->value, 
-                                            token->length, token->start, 
-                                            token->end, token->preceded_by_newline);
-        }
+        if (token) token->preceded_by_newline = had_newline;
+        return token;
+    }
+    
+    /* 与 ${ 配对的 } ：模板的下一段 */
+    if (ch == '}' && lexer->templates > 0 &&
+        lexer->braces == lexer->template_braces[lexer->templates - 1]) {
+        Token *token = read_template(lexer, start);
+        if (token) token->preceded_by_newline = had_newline;
         return token;
     }
     
@@ -718,7 +970,7 @@ Token* lexer_next_token(Lexer *lexer) {
                           lexer->position, had_newline);
     }
     
-    if (ch == '?' && next == '.') {
+    if (ch == '?' && next == '.' && !isdigit(next2)) {
         advance(lexer);
         return token_create(TOKEN_OPTIONAL_CHAIN, "?.", 2, start, 
                           lexer->position, had_newline);
@@ -777,8 +1029,14 @@ Token* lexer_next_token(Lexer *lexer) {
     switch (ch) {
         case '(': type = TOKEN_LPAREN; break;
         case ')': type = TOKEN_RPAREN; break;
-        case '{': type = TOKEN_LBRACE; break;
-        case '}': type = TOKEN_RBRACE; break;
+        case '{':
+            type = TOKEN_LBRACE;
+            lexer->braces++;
+            break;
+        case '}':
+            type = TOKEN_RBRACE;
+            if (lexer->braces > 0) lexer->braces--;
+            break;
         case '[': type = TOKEN_LBRACKET; break;
         case ']': type = TOKEN_RBRACKET; break;
         case ';': type = TOKEN_SEMICOLON; break;
@@ -806,10 +1064,7 @@ Token* lexer_next_token(Lexer *lexer) {
                 if (token) {
                     token->preceded_by_newline = had_newline;
                     /* 保存当前token以供上下文判断 */
-                    if (lexer->prev_token) token_destroy(lexer->prev_token);
-                    lexer->prev_token = token_create(token->type, token->value, 
-                                                    token->length, token->start, 
-                                                    token->end, token->preceded_by_newline);
+                    remember_token(lexer, token);
                 }
                 return token;
             }
@@ -829,26 +1084,195 @@ Token* lexer_next_token(Lexer *lexer) {
     Token *token = token_create(type, str, 1, start, lexer->position, had_newline);
     
     /* 保存当前token */
-    if (lexer->prev_token) token_destroy(lexer->prev_token);
-    lexer->prev_token = token_create(token->type, token->value, token->length,
-                                     token->start, token->end, 
-                                     token->preceded_by_newline);
+    if (token) remember_token(lexer, token);
     
     return token;
 }
 
+/* 追加token到序列末尾 */
+bool token_array_push(TokenArray *array, Token *token) {
+    if (array->count == array->capacity) {
+        size_t capacity = array->capacity ? array->capacity * 2 : 256;
+        Token **tokens = (Token**)realloc(array->tokens, capacity * sizeof(Token*));
+        if (!tokens) return false;
+        array->tokens = tokens;
+        array->capacity = capacity;
+    }
+    array->tokens[array->count++] = token;
+    return true;
+}
+
+/* 释放token序列及其中所有token */
+void token_array_free(TokenArray *array) {
+    if (!array) return;
+    for (size_t i = 0; i < array->count; i++) {
+        token_destroy(array->tokens[i]);
+    }
+    free(array->tokens);
+    array->tokens = NULL;
+    array->count = array->capacity = 0;
+}
+
+/* 释放trivia表 */
+void trivia_table_free(TriviaTable *table) {
+    if (!table) return;
+    free(table->items);
+    table->items = NULL;
+    table->count = table->capacity = 0;
+    table->failed = false;
+}
+
+/* 第一条起始偏移不小于offset的trivia的下标（没有时为count） */
+size_t trivia_lower_bound(const TriviaTable *table, size_t offset) {
+    size_t low = 0;
+    size_t high = table->count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (table->items[mid].start < offset) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/* 串行地将整个源码切分为token序列（包含末尾的EOF；出错时保留出错前的token） */
+bool lexer_tokenize(const char *source, size_t length, TokenArray *out, ErrorInfo *error) {
+    Lexer *lexer = lexer_create(source, length, error);
+    if (!lexer) return false;
+    
+    bool success = true;
+    for (;;) {
+        Token *token = lexer_next_token(lexer);
+        if (!token) {
+            success = false;
+            break;
+        }
+        if (!token_array_push(out, token)) {
+            token_destroy(token);
+            success = false;
+            break;
+        }
+        if (token->type == TOKEN_EOF) break;
+    }
+    
+    lexer_destroy(lexer);
+    return success;
+}
+
 /* Token类型转字符串 */
 const char* token_type_to_string(TokenType type) {
     switch (type) {
         case TOKEN_EOF: return "EOF";
+        case TOKEN_ERROR: return "ERROR";
         case TOKEN_IDENTIFIER: return "IDENTIFIER";
         case TOKEN_NUMBER: return "NUMBER";
         case TOKEN_STRING: return "STRING";
-        case TOKEN_SEMICOLON: return "SEMICOLON";
+        case TOKEN_TEMPLATE: return "TEMPLATE";
+        case TOKEN_REGEX: return "REGEX";
+        case TOKEN_TRUE: return "TRUE";
+        case TOKEN_FALSE: return "FALSE";
+        case TOKEN_NULL: return "NULL";
+        case TOKEN_UNDEFINED: return "UNDEFINED";
+        case TOKEN_BREAK: return "BREAK";
+        case TOKEN_CASE: return "CASE";
+        case TOKEN_CATCH: return "CATCH";
+        case TOKEN_CLASS: return "CLASS";
+        case TOKEN_CONST: return "CONST";
+        case TOKEN_CONTINUE: return "CONTINUE";
+        case TOKEN_DEBUGGER: return "DEBUGGER";
+        case TOKEN_DEFAULT: return "DEFAULT";
+        case TOKEN_DELETE: return "DELETE";
+        case TOKEN_DO: return "DO";
+        case TOKEN_ELSE: return "ELSE";
+        case TOKEN_EXPORT: return "EXPORT";
+        case TOKEN_EXTENDS: return "EXTENDS";
+        case TOKEN_FINALLY: return "FINALLY";
+        case TOKEN_FOR: return "FOR";
+        case TOKEN_FUNCTION: return "FUNCTION";
+        case TOKEN_IF: return "IF";
+        case TOKEN_IMPORT: return "IMPORT";
+        case TOKEN_IN: return "IN";
+        case TOKEN_INSTANCEOF: return "INSTANCEOF";
+        case TOKEN_LET: return "LET";
+        case TOKEN_NEW: return "NEW";
+        case TOKEN_RETURN: return "RETURN";
+        case TOKEN_SUPER: return "SUPER";
+        case TOKEN_SWITCH: return "SWITCH";
+        case TOKEN_THIS: return "THIS";
+        case TOKEN_THROW: return "THROW";
+        case TOKEN_TRY: return "TRY";
+        case TOKEN_TYPEOF: return "TYPEOF";
+        case TOKEN_VAR: return "VAR";
+        case TOKEN_VOID: return "VOID";
+        case TOKEN_WHILE: return "WHILE";
+        case TOKEN_WITH: return "WITH";
+        case TOKEN_YIELD: return "YIELD";
+        case TOKEN_ASYNC: return "ASYNC";
+        case TOKEN_AWAIT: return "AWAIT";
+        case TOKEN_OF: return "OF";
+        case TOKEN_STATIC: return "STATIC";
+        case TOKEN_GET: return "GET";
+        case TOKEN_SET: return "SET";
         case TOKEN_LPAREN: return "LPAREN";
         case TOKEN_RPAREN: return "RPAREN";
         case TOKEN_LBRACE: return "LBRACE";
         case TOKEN_RBRACE: return "RBRACE";
+        case TOKEN_LBRACKET: return "LBRACKET";
+        case TOKEN_RBRACKET: return "RBRACKET";
+        case TOKEN_SEMICOLON: return "SEMICOLON";
+        case TOKEN_COMMA: return "COMMA";
+        case TOKEN_DOT: return "DOT";
+        case TOKEN_COLON: return "COLON";
+        case TOKEN_QUESTION: return "QUESTION";
+        case TOKEN_PLUS: return "PLUS";
+        case TOKEN_MINUS: return "MINUS";
+        case TOKEN_MULTIPLY: return "MULTIPLY";
+        case TOKEN_DIVIDE: return "DIVIDE";
+        case TOKEN_MODULO: return "MODULO";
+        case TOKEN_EXPONENT: return "EXPONENT";
+        case TOKEN_INCREMENT: return "INCREMENT";
+        case TOKEN_DECREMENT: return "DECREMENT";
+        case TOKEN_ASSIGN: return "ASSIGN";
+        case TOKEN_PLUS_ASSIGN: return "PLUS_ASSIGN";
+        case TOKEN_MINUS_ASSIGN: return "MINUS_ASSIGN";
+        case TOKEN_MULTIPLY_ASSIGN: return "MULTIPLY_ASSIGN";
+        case TOKEN_DIVIDE_ASSIGN: return "DIVIDE_ASSIGN";
+        case TOKEN_MODULO_ASSIGN: return "MODULO_ASSIGN";
+        case TOKEN_EXPONENT_ASSIGN: return "EXPONENT_ASSIGN";
+        case TOKEN_LSHIFT_ASSIGN: return "LSHIFT_ASSIGN";
+        case TOKEN_RSHIFT_ASSIGN: return "RSHIFT_ASSIGN";
+        case TOKEN_URSHIFT_ASSIGN: return "URSHIFT_ASSIGN";
+        case TOKEN_AND_ASSIGN: return "AND_ASSIGN";
+        case TOKEN_OR_ASSIGN: return "OR_ASSIGN";
+        case TOKEN_XOR_ASSIGN: return "XOR_ASSIGN";
+        case TOKEN_AND_AND_ASSIGN: return "AND_AND_ASSIGN";
+        case TOKEN_OR_OR_ASSIGN: return "OR_OR_ASSIGN";
+        case TOKEN_NULLISH_ASSIGN: return "NULLISH_ASSIGN";
+        case TOKEN_EQ: return "EQ";
+        case TOKEN_NE: return "NE";
+        case TOKEN_EQ_STRICT: return "EQ_STRICT";
+        case TOKEN_NE_STRICT: return "NE_STRICT";
+        case TOKEN_LT: return "LT";
+        case TOKEN_LE: return "LE";
+        case TOKEN_GT: return "GT";
+        case TOKEN_GE: return "GE";
+        case TOKEN_AND: return "AND";
+        case TOKEN_OR: return "OR";
+        case TOKEN_NOT: return "NOT";
+        case TOKEN_NULLISH: return "NULLISH";
+        case TOKEN_BITWISE_AND: return "BITWISE_AND";
+        case TOKEN_BITWISE_OR: return "BITWISE_OR";
+        case TOKEN_BITWISE_XOR: return "BITWISE_XOR";
+        case TOKEN_BITWISE_NOT: return "BITWISE_NOT";
+        case TOKEN_LSHIFT: return "LSHIFT";
+        case TOKEN_RSHIFT: return "RSHIFT";
+        case TOKEN_URSHIFT: return "URSHIFT";
+        case TOKEN_ARROW: return "ARROW";
+        case TOKEN_SPREAD: return "SPREAD";
+        case TOKEN_OPTIONAL_CHAIN: return "OPTIONAL_CHAIN";
+        case TOKEN_AUTO_SEMICOLON: return "AUTO_SEMICOLON";
         default: return "UNKNOWN";
     }
 }
@@ -13,7 +13,7 @@ typedef enum {
     TOKEN_IDENTIFIER,       /* 标识符 */
     TOKEN_NUMBER,           /* 数字字面量 */
     TOKEN_STRING,           /* 字符串字面量 */
-    TOKEN_TEMPLATE,         /* 模板字符串 */
+    TOKEN_TEMPLATE,         /* 模板字符串（有 ${} 替换时是其中的一段：`…${、}…${ 或 }…`） */
     TOKEN_REGEX,            /* 正则表达式 */
     TOKEN_TRUE,             /* true */
     TOKEN_FALSE,            /* false */
@@ -139,16 +139,56 @@ typedef enum {
     TOKEN_AUTO_SEMICOLON    /* ASI插入的分号 */
 } TokenType;
 
+#define ATOM_NONE UINT32_MAX   /* 没有原子编号 */
+
+/* 原子表（见atom.h） */
+typedef struct AtomTable AtomTable;
+
+/* 字符串字面量的值（见cooked.h） */
+typedef struct CookedStrings CookedStrings;
+
+/* 正则字面量的编译缓存（见regexp.h） */
+typedef struct RegexpCache RegexpCache;
+
 /* Token结构体 */
 typedef struct {
     TokenType type;
     char *value;            /* token的字符串值 */
+    uint32_t atom;          /* 标识符和字符串的原子编号（value借用原子表中的文本），否则为ATOM_NONE */
     size_t length;          /* 值的长度 */
+    const char *cooked;     /* Lexer.strings非NULL时字符串字面量的值（指向源码或字符串表），否则为NULL */
+    size_t cooked_length;
+    double number;          /* 数字字面量的值（BigInt为舍入到double的值，精确值见numeric.h），否则为0 */
     Position start;         /* 起始位置 */
     Position end;           /* 结束位置 */
     bool preceded_by_newline; /* 是否前面有换行（用于ASI判断） */
 } Token;
 
+/* 注释和空行（trivia）的种类 */
+typedef enum {
+    TRIVIA_LINE_COMMENT,    /* // 注释 */
+    TRIVIA_BLOCK_COMMENT,   /* 块注释 */
+    TRIVIA_BLANK_LINE       /* 两个token（或注释）之间至少有一个空行（连续的空行只记一次） */
+} TriviaKind;
+
+/* 一条trivia：源码的字节范围 */
+typedef struct {
+    uint32_t start;
+    uint32_t end;
+    uint8_t kind;           /* TriviaKind */
+    bool newline_before;    /* 与前一个token或注释之间有换行（否则是行尾注释） */
+} Trivia;
+
+/* trivia表：按偏移递增排列，供格式化等需要保留注释的工具使用 */
+typedef struct {
+    Trivia *items;
+    size_t count;
+    size_t capacity;
+    bool failed;            /* 内存不足 */
+} TriviaTable;
+
+#define LEXER_TEMPLATE_DEPTH_MAX 256   /* 模板替换 ${} 的最大嵌套层数 */
+
 /* 词法分析器状态 */
 typedef struct {
     const char *source;     /* 源代码 */
@@ -158,17 +198,49 @@ typedef struct {
     ErrorInfo *error;       /* 错误信息 */
     bool last_was_newline;  /* 上一个字符是否为换行 */
     Token *prev_token;      /* 上一个token（用于上下文判断） */
+    TriviaTable *trivia;    /* 非NULL时记录注释和空行，NULL时不做任何额外工作 */
+    int trivia_line;        /* 上一个token或注释结束的行（判断newline_before） */
+    AtomTable *atoms;       /* 非NULL时标识符和字符串驻留到原子表（可多线程共享），
+                               token须在原子表销毁之前销毁 */
+    CookedStrings *strings; /* 非NULL时字符串token带有解码后的值，token须在源码和字符串表之前销毁 */
+    RegexpCache *regexps;   /* 检查正则字面量用的缓存：调用者可以设置一个共享的（不加锁），
+                               为NULL时遇到第一个正则才创建，归词法分析器所有 */
+    bool owns_regexps;      /* regexps由词法分析器创建，lexer_destroy时释放 */
+    int braces;             /* 未闭合的 { 个数 */
+    int templates;          /* 未结束的模板替换 ${ 个数 */
+    int template_braces[LEXER_TEMPLATE_DEPTH_MAX]; /* 每个 ${ 开始时的braces，与之相等时 } 回到模板 */
 } Lexer;
 
+/* Token序列 */
+typedef struct {
+    Token **tokens;
+    size_t count;
+    size_t capacity;
+} TokenArray;
+
 /* 词法分析器函数声明 */
 Lexer* lexer_create(const char *source, size_t length, ErrorInfo *error);
+Lexer* lexer_create_at(const char *source, size_t length, Position start, ErrorInfo *error);
 void lexer_destroy(Lexer *lexer);
 Token* lexer_next_token(Lexer *lexer);
+bool lexer_regex_allowed(const Lexer *lexer);
+bool lexer_in_template(const Lexer *lexer);
+void lexer_set_regex_allowed(Lexer *lexer, bool allowed);
 void token_destroy(Token *token);
+bool lexer_tokenize(const char *source, size_t length, TokenArray *out, ErrorInfo *error);
+
+/* trivia表函数 */
+void trivia_table_free(TriviaTable *table);
+size_t trivia_lower_bound(const TriviaTable *table, size_t offset);
+
+/* Token序列函数 */
+bool token_array_push(TokenArray *array, Token *token);
+void token_array_free(TokenArray *array);
 const char* token_type_to_string(TokenType type);
 
 /* 辅助函数 */
 bool is_keyword(const char *str, size_t len, TokenType *type);
+const char* keyword_at(size_t index, TokenType *type);
 bool can_precede_regex(TokenType type);
 
 #endif /* LEXER_H */
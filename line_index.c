@@ -0,0 +1,194 @@
+#include "line_index.h"
+
+/* 追加一行的起始偏移 */
+static bool push_line(LineIndex *index, size_t start) {
+    if (index->count == index->capacity) {
+        size_t capacity = index->capacity * 2;
+        size_t *starts = (size_t*)realloc(index->starts, capacity * sizeof(size_t));
+        if (!starts) return false;
+        index->starts = starts;
+        index->capacity = capacity;
+    }
+    index->starts[index->count++] = start;
+    return true;
+}
+
+/* 扫描源码建立行索引 */
+bool line_index_build(LineIndex *index, const char *source, size_t length) {
+    index->source = source;
+    index->length = length;
+    index->count = 0;
+    index->capacity = 64 + length / 32;
+    index->starts = (size_t*)malloc(index->capacity * sizeof(size_t));
+    if (!index->starts || !push_line(index, 0)) {
+        line_index_free(index);
+        return false;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        char ch = source[i];
+        if (ch == '\n' || ch == '\r') {
+            if (ch == '\r' && i + 1 < length && source[i + 1] == '\n') {
+                i++;
+            }
+            if (!push_line(index, i + 1)) {
+                line_index_free(index);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* 扫描 [from, to) 中的换行，把其后的行首写入starts（NULL时只计数），返回行首个数 */
+static size_t scan_lines(const char *source, size_t length, size_t from, size_t to,
+                         size_t *starts, size_t *last) {
+    size_t count = 0;
+    for (size_t i = from; i < to; i++) {
+        char ch = source[i];
+        if (ch == '\n' || ch == '\r') {
+            if (ch == '\r' && i + 1 < length && source[i + 1] == '\n') {
+                i++;
+            }
+            if (starts) starts[count] = i + 1;
+            *last = i + 1;
+            count++;
+        }
+    }
+    return count;
+}
+
+/* 文本的 [offset, offset + removed) 被替换为inserted个字节之后更新行索引
+   （source和length是编辑后的文本）。只扫描编辑附近：编辑前一个字符可能是与新文本
+   组成\r\n的\r，编辑后的第一个字符可能是\n；其余未改动的行首整体平移 */
+bool line_index_edit(LineIndex *index, const char *source, size_t length,
+                     size_t offset, size_t removed, size_t inserted) {
+    size_t line = line_index_line(index, offset);
+    size_t old_end = offset + removed;
+    size_t new_end = offset + inserted;
+
+    /* 保留 starts[0, keep)，从from开始重新扫描 */
+    size_t keep = offset > index->starts[line] ? line + 1 : (line > 0 ? line : 1);
+    size_t from = offset > 0 ? offset - 1 : 0;
+
+    /* 第一个位于编辑之后的旧行首（它前面的换行没有被修改）及其后的行首平移 */
+    size_t next = line_index_line(index, old_end) + 1;
+    bool has_next = next < index->count;
+    size_t next_start = has_next ? index->starts[next] - removed + inserted : length;
+    size_t to = new_end + 1 < next_start ? new_end + 1 : next_start;
+
+    size_t last = 0;
+    size_t scanned = scan_lines(source, length, from, to, NULL, &last);
+    size_t added = scanned;
+    if (has_next && (scanned == 0 || last != next_start)) {
+        added++;    /* 扫描没有到达next_start前面的换行 */
+    }
+    size_t tail = has_next ? index->count - next - 1 : 0;
+    size_t count = keep + added + tail;
+
+    if (count > index->capacity) {
+        size_t capacity = index->capacity * 2;
+        if (capacity < count) capacity = count;
+        size_t *starts = (size_t*)realloc(index->starts, capacity * sizeof(size_t));
+        if (!starts) return false;
+        index->starts = starts;
+        index->capacity = capacity;
+    }
+
+    size_t *starts = index->starts;
+    for (size_t i = next + 1; i < next + 1 + tail; i++) {
+        starts[i] = starts[i] - removed + inserted;
+    }
+    if (tail > 0) {
+        memmove(starts + keep + added, starts + next + 1, tail * sizeof(size_t));
+    }
+    scan_lines(source, length, from, to, starts + keep, &last);
+    if (added > scanned) {
+        starts[keep + scanned] = next_start;
+    }
+
+    index->source = source;
+    index->length = length;
+    index->count = count;
+    return true;
+}
+
+/* 释放行索引 */
+void line_index_free(LineIndex *index) {
+    free(index->starts);
+    index->starts = NULL;
+    index->count = 0;
+    index->capacity = 0;
+}
+
+/* 二分查找偏移所在的行（从0开始） */
+size_t line_index_line(const LineIndex *index, size_t offset) {
+    size_t low = 0;
+    size_t high = index->count;
+
+    while (high - low > 1) {
+        size_t mid = low + (high - low) / 2;
+        if (index->starts[mid] <= offset) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/* UTF-8文本的UTF-16长度：每个首字节算1，4字节序列（代理对）算2 */
+size_t utf16_length(const char *text, size_t length) {
+    size_t units = 0;
+    size_t i = 0;
+
+    /* 纯ASCII的部分每次检查8个字节 */
+    while (i + 8 <= length) {
+        uint64_t word;
+        memcpy(&word, text + i, 8);
+        if (word & 0x8080808080808080ull) break;
+        units += 8;
+        i += 8;
+    }
+
+    for (; i < length; i++) {
+        unsigned char ch = (unsigned char)text[i];
+        units += (ch & 0xC0) != 0x80;
+        units += ch >= 0xF0;
+    }
+    return units;
+}
+
+/* 初始化游标（位于文件开头） */
+void line_cursor_init(LineCursor *cursor, const LineIndex *index) {
+    cursor->index = index;
+    cursor->line = 0;
+    cursor->offset = 0;
+    cursor->column = 0;
+}
+
+/* 查找偏移的行列位置：在同一行内向后移动时只扫描新增的部分，否则重新定位 */
+LinePosition line_cursor_find(LineCursor *cursor, size_t offset) {
+    const LineIndex *index = cursor->index;
+    if (offset > index->length) {
+        offset = index->length;
+    }
+
+    size_t next = cursor->line + 1 < index->count ? index->starts[cursor->line + 1] : SIZE_MAX;
+    if (offset < cursor->offset || offset >= next) {
+        if (offset >= next && (cursor->line + 2 >= index->count ||
+                               offset < index->starts[cursor->line + 2])) {
+            cursor->line++;         /* 顺序处理时最常见的情况：下一行 */
+        } else {
+            cursor->line = line_index_line(index, offset);
+        }
+        cursor->offset = index->starts[cursor->line];
+        cursor->column = 0;
+    }
+
+    cursor->column += utf16_length(index->source + cursor->offset, offset - cursor->offset);
+    cursor->offset = offset;
+
+    LinePosition position = {cursor->line, cursor->column};
+    return position;
+}
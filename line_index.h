@@ -0,0 +1,39 @@
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include "common.h"
+
+/* 行索引：每一行起始的字节偏移（\n、\r\n、\r都算换行，与词法分析器一致） */
+typedef struct {
+    const char *source;
+    size_t length;
+    size_t *starts;         /* starts[0] == 0 */
+    size_t count;           /* 行数 */
+    size_t capacity;
+} LineIndex;
+
+/* 行列位置（都从0开始，列按UTF-16码元计算，与source map和LSP一致） */
+typedef struct {
+    size_t line;
+    size_t column;
+} LinePosition;
+
+/* 顺序查询的游标：偏移递增时列号增量计算，不需要从行首重新扫描 */
+typedef struct {
+    const LineIndex *index;
+    size_t line;
+    size_t offset;          /* 上次查询的偏移 */
+    size_t column;          /* offset对应的列 */
+} LineCursor;
+
+/* 行索引函数声明 */
+bool line_index_build(LineIndex *index, const char *source, size_t length);
+bool line_index_edit(LineIndex *index, const char *source, size_t length,
+                     size_t offset, size_t removed, size_t inserted);
+void line_index_free(LineIndex *index);
+size_t line_index_line(const LineIndex *index, size_t offset);
+size_t utf16_length(const char *text, size_t length);
+void line_cursor_init(LineCursor *cursor, const LineIndex *index);
+LinePosition line_cursor_find(LineCursor *cursor, size_t offset);
+
+#endif /* LINE_INDEX_H */
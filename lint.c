@@ -0,0 +1,514 @@
+#include "lint.h"
+#include "parser.h"
+#include "scope.h"
+#include "structural.h"
+#include "line_index.h"
+#include "cooked.h"
+#include "numeric.h"
+#include <stdarg.h>
+
+/* 保证数组还能追加一个元素 */
+static bool reserve(void **items, size_t *capacity, size_t count, size_t size) {
+    if (count < *capacity) return true;
+
+    size_t new_capacity = *capacity ? *capacity * 2 : 16;
+    void *grown = realloc(*items, new_capacity * size);
+    if (!grown) return false;
+    *items = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+void lint_engine_init(LintEngine *engine) {
+    memset(engine, 0, sizeof(*engine));
+    arena_init(&engine->arena, LINT_ARENA_BLOCK);
+}
+
+/* 清空诊断，keep时保留arena的一个标准大小的块给下一次运行 */
+static void diagnostics_reset(LintEngine *engine, bool keep) {
+    arena_reset(&engine->arena, keep);
+    engine->first = NULL;
+    engine->last = NULL;
+    engine->count = 0;
+    engine->error_count = 0;
+}
+
+void lint_engine_free(LintEngine *engine) {
+    diagnostics_reset(engine, false);
+    free(engine->rules);
+    free(engine->node_hooks);
+    free(engine->token_hooks);
+    free(engine->node_table);
+    free(engine->token_table);
+    free(engine->sorted);
+    free(engine->stack);
+    cooked_strings_destroy(engine->strings);
+    memset(engine, 0, sizeof(*engine));
+}
+
+/* ---------- 登记与分派表 ---------- */
+
+int lint_add_rule(LintEngine *engine, const char *name, LintSeverity severity, void *data) {
+    if (engine->rule_count >= UINT16_MAX ||
+        !reserve((void**)&engine->rules, &engine->rule_capacity, engine->rule_count, sizeof(LintRule))) {
+        return -1;
+    }
+    LintRule *rule = &engine->rules[engine->rule_count];
+    rule->name = name;
+    rule->severity = severity;
+    rule->data = data;
+    return (int)engine->rule_count++;
+}
+
+bool lint_on_node(LintEngine *engine, int rule, AstKind kind, LintNodeHandler handler) {
+    if (rule < 0 || (size_t)rule >= engine->rule_count || kind >= AST_KIND_COUNT ||
+        !reserve((void**)&engine->node_hooks, &engine->node_hook_capacity,
+                 engine->node_hook_count, sizeof(LintHook))) {
+        return false;
+    }
+    LintHook *hook = &engine->node_hooks[engine->node_hook_count++];
+    hook->type = (uint16_t)kind;
+    hook->rule = (uint16_t)rule;
+    hook->handler.node = handler;
+    engine->compiled = false;
+    return true;
+}
+
+bool lint_on_token(LintEngine *engine, int rule, TokenType type, LintTokenHandler handler) {
+    if (rule < 0 || (size_t)rule >= engine->rule_count || type >= LINT_TOKEN_TYPES ||
+        !reserve((void**)&engine->token_hooks, &engine->token_hook_capacity,
+                 engine->token_hook_count, sizeof(LintHook))) {
+        return false;
+    }
+    LintHook *hook = &engine->token_hooks[engine->token_hook_count++];
+    hook->type = (uint16_t)type;
+    hook->rule = (uint16_t)rule;
+    hook->handler.token = handler;
+    engine->compiled = false;
+    return true;
+}
+
+/* 按类型计数排序（稳定），start[type]..start[type+1]为该类型的处理函数 */
+static LintHook* build_table(const LintHook *hooks, size_t count, uint32_t *start, size_t types) {
+    LintHook *table = (LintHook*)malloc((count ? count : 1) * sizeof(LintHook));
+    if (!table) return NULL;
+
+    memset(start, 0, (types + 1) * sizeof(uint32_t));
+    for (size_t i = 0; i < count; i++) {
+        start[hooks[i].type + 1]++;
+    }
+    for (size_t t = 0; t < types; t++) {
+        start[t + 1] += start[t];
+    }
+    uint32_t *fill = (uint32_t*)malloc((types ? types : 1) * sizeof(uint32_t));
+    if (!fill) {
+        free(table);
+        return NULL;
+    }
+    memcpy(fill, start, types * sizeof(uint32_t));
+    for (size_t i = 0; i < count; i++) {
+        table[fill[hooks[i].type]++] = hooks[i];
+    }
+    free(fill);
+    return table;
+}
+
+static bool compile(LintEngine *engine) {
+    if (engine->compiled) return true;
+
+    free(engine->node_table);
+    free(engine->token_table);
+    engine->node_table = build_table(engine->node_hooks, engine->node_hook_count,
+                                     engine->node_start, AST_KIND_COUNT);
+    engine->token_table = build_table(engine->token_hooks, engine->token_hook_count,
+                                      engine->token_start, LINT_TOKEN_TYPES);
+    engine->compiled = engine->node_table && engine->token_table;
+    return engine->compiled;
+}
+
+/* ---------- 诊断 ---------- */
+
+void lint_report(LintEngine *engine, size_t start, size_t end, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    int length = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+
+    LintDiagnostic *diagnostic = length < 0 ? NULL :
+        (LintDiagnostic*)arena_alloc(&engine->arena, sizeof(LintDiagnostic) + (size_t)length + 1);
+    if (!diagnostic) {
+        va_end(args);
+        engine->failed = true;
+        return;
+    }
+    vsnprintf(diagnostic->message, (size_t)length + 1, format, args);
+    va_end(args);
+
+    const LintRule *rule = &engine->rules[engine->current];
+    diagnostic->next = NULL;
+    diagnostic->start = (uint32_t)start;
+    diagnostic->end = (uint32_t)end;
+    diagnostic->rule = engine->current;
+    diagnostic->severity = (uint8_t)rule->severity;
+    diagnostic->message_length = (uint32_t)length;
+    if (engine->last) {
+        engine->last->next = diagnostic;
+    } else {
+        engine->first = diagnostic;
+    }
+    engine->last = diagnostic;
+    engine->count++;
+    if (rule->severity == LINT_ERROR) engine->error_count++;
+}
+
+static int compare_diagnostics(const void *a, const void *b) {
+    const LintDiagnostic *x = *(const LintDiagnostic* const*)a;
+    const LintDiagnostic *y = *(const LintDiagnostic* const*)b;
+    if (x->start != y->start) return x->start < y->start ? -1 : 1;
+    if (x->rule != y->rule) return x->rule < y->rule ? -1 : 1;
+    if (x->end != y->end) return x->end < y->end ? -1 : 1;
+    return strcmp(x->message, y->message);
+}
+
+static bool sort_diagnostics(LintEngine *engine) {
+    if (engine->count > engine->sorted_capacity) {
+        const LintDiagnostic **sorted = (const LintDiagnostic**)realloc(
+            (void*)engine->sorted, engine->count * sizeof(LintDiagnostic*));
+        if (!sorted) return false;
+        engine->sorted = sorted;
+        engine->sorted_capacity = engine->count;
+    }
+    size_t i = 0;
+    for (const LintDiagnostic *d = engine->first; d; d = d->next) {
+        engine->sorted[i++] = d;
+    }
+    if (engine->count > 1) {
+        qsort((void*)engine->sorted, engine->count, sizeof(LintDiagnostic*), compare_diagnostics);
+    }
+    return true;
+}
+
+/* ---------- 分派 ---------- */
+
+/* 解析过程中每个token调用一次 */
+static void dispatch_token(void *context, const Token *token, bool asi) {
+    (void)asi;
+    LintEngine *engine = (LintEngine*)context;
+    uint32_t end = engine->token_start[token->type + 1];
+    for (uint32_t i = engine->token_start[token->type]; i < end; i++) {
+        const LintHook *hook = &engine->token_table[i];
+        engine->current = hook->rule;
+        hook->handler.token(engine, engine->rules[hook->rule].data, token);
+    }
+}
+
+/* 先序遍历（显式栈：弹出一个节点后压入它的下一个兄弟和第一个子节点） */
+static bool dispatch_nodes(LintEngine *engine, const Ast *ast) {
+    size_t depth = 0;
+    if (!reserve((void**)&engine->stack, &engine->stack_capacity, depth, sizeof(uint32_t))) {
+        return false;
+    }
+    engine->stack[depth++] = ast->root;
+
+    while (depth > 0) {
+        uint32_t node = engine->stack[--depth];
+        const AstNode *n = &ast->nodes[node];
+
+        uint32_t end = engine->node_start[n->kind + 1];
+        for (uint32_t i = engine->node_start[n->kind]; i < end; i++) {
+            const LintHook *hook = &engine->node_table[i];
+            engine->current = hook->rule;
+            hook->handler.node(engine, engine->rules[hook->rule].data, node);
+        }
+
+        if (!reserve((void**)&engine->stack, &engine->stack_capacity, depth + 1, sizeof(uint32_t))) {
+            return false;
+        }
+        if (node != ast->root && n->next_sibling != AST_NONE) {
+            engine->stack[depth++] = n->next_sibling;
+        }
+        if (n->first_child != AST_NONE) {
+            engine->stack[depth++] = n->first_child;
+        }
+    }
+    return true;
+}
+
+bool lint_run(LintEngine *engine, const char *source, size_t length, bool module, ErrorInfo *error) {
+    diagnostics_reset(engine, true);
+    engine->failed = false;
+    engine->source = source;
+    engine->length = length;
+
+    if (!compile(engine)) {
+        set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+        return false;
+    }
+    if (!structural_check(source, length, error)) {
+        return false;
+    }
+
+    /* 作用域检查总是需要AST */
+    Ast ast;
+    if (!ast_init(&ast, length)) {
+        set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+        return false;
+    }
+    engine->ast = &ast;
+
+    Lexer *lexer = lexer_create(source, length, error);
+    Parser *parser = lexer ? parser_create(lexer, error) : NULL;
+    bool success = parser != NULL;
+    if (parser) {
+        parser->ast = &ast;
+        parser->module = module;
+        if (engine->token_hook_count > 0) {
+            parser->on_token = dispatch_token;
+            parser->token_context = engine;
+        }
+        success = scope_parse(parser);
+    }
+    parser_destroy(parser);
+    lexer_destroy(lexer);
+
+    if (success) {
+        success = !ast.failed && dispatch_nodes(engine, &ast);
+        if (!success) engine->failed = true;
+    }
+    ast_free(&ast);
+    engine->ast = NULL;
+
+    if (success && (engine->failed || !sort_diagnostics(engine))) {
+        engine->failed = true;
+        success = false;
+    }
+    if (engine->failed) {
+        set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+    }
+    return success;
+}
+
+void lint_write(const LintEngine *engine, const char *file, Writer *writer) {
+    LineIndex index;
+    bool lines = line_index_build(&index, engine->source, engine->length);
+    LineCursor cursor;
+    if (lines) line_cursor_init(&cursor, &index);
+
+    for (size_t i = 0; i < engine->count; i++) {
+        const LintDiagnostic *d = engine->sorted[i];
+        writer_cstr(writer, file);
+        if (lines) {
+            LinePosition position = line_cursor_find(&cursor, d->start);
+            writer_byte(writer, ':');
+            writer_uint(writer, position.line + 1);
+            writer_byte(writer, ':');
+            writer_uint(writer, position.column + 1);
+        }
+        writer_cstr(writer, d->severity == LINT_ERROR ? ": error: " : ": warning: ");
+        writer_write(writer, d->message, d->message_length);
+        writer_cstr(writer, " [");
+        writer_cstr(writer, engine->rules[d->rule].name);
+        writer_cstr(writer, "]\n");
+    }
+
+    if (lines) line_index_free(&index);
+}
+
+/* ---------- 内置规则 ---------- */
+
+/* no-with：with语句（严格模式下是语法错误，非严格模式下使作用域无法静态确定） */
+static void no_with(LintEngine *engine, void *data, uint32_t node) {
+    (void)data;
+    size_t start = engine->ast->nodes[node].start;
+    lint_report(engine, start, start + 4, "Unexpected use of 'with' statement");
+}
+
+/* no-debugger：按token检查，不需要节点 */
+static void no_debugger(LintEngine *engine, void *data, const Token *token) {
+    (void)data;
+    lint_report(engine, (size_t)token->start.offset, (size_t)token->end.offset,
+                "Unexpected 'debugger' statement");
+}
+
+#define DUPE_KEYS_INLINE 64     /* 属性不超过这个数时不分配内存 */
+
+/* 对象字面量的一个属性名 */
+typedef struct {
+    const char *text;           /* 指向源码；数字属性名为NULL，文本在number中 */
+    uint32_t length;
+    uint32_t index;             /* 在对象中的序号 */
+    uint32_t key;               /* 属性名节点 */
+    uint8_t kind;               /* 0: 普通属性或方法, 1: get, 2: set */
+    char number[32];            /* 数字属性名规范化后的文本 */
+} PropertyKey;
+
+/* 数字属性名规范化为与字符串属性名可比较的文本（1、1.0、0x1、1n 都是"1"）；
+   超出常规范围的数字返回false（不参与比较） */
+static bool normalize_number(const char *raw, size_t length, char *out, size_t size) {
+    NumericLiteral literal;
+    if (!numeric_value(raw, length, &literal)) {
+        return false;
+    }
+    if (literal.bigint) {
+        /* BigInt的属性名是它的十进制文本 */
+        NumericBigInt bigint;
+        size_t text_length;
+        numeric_bigint_init(&bigint);
+        const char *text = numeric_bigint_parse(&bigint, raw, length)
+                         ? numeric_bigint_decimal(&bigint, &text_length) : NULL;
+        bool fits = text && text_length < size;
+        if (fits) memcpy(out, text, text_length + 1);
+        numeric_bigint_free(&bigint);
+        return fits;
+    }
+
+    double value = literal.value;
+    if (!(value == 0 || (value >= 1e-6 && value < 1e21))) {
+        return false;
+    }
+
+    /* 最短的能还原出同一个值的表示 */
+    for (int precision = 1; precision <= 17; precision++) {
+        snprintf(out, size, "%.*g", precision, value);
+        if (strtod(out, NULL) == value) break;
+    }
+    if (strchr(out, 'e') && value >= 1) {
+        /* 整数的最短%g表示可能是指数形式（10是1e+01），JS写成整数 */
+        snprintf(out, size, "%.0f", value);
+        if (strtod(out, NULL) != value) return false;
+    }
+    return strchr(out, 'e') == NULL;
+}
+
+/* 属性名的规范文本，计算属性名和无法静态确定的属性名返回false */
+static bool property_key(LintEngine *engine, const AstNode *property, PropertyKey *key) {
+    if (property->kind != AST_PROPERTY || (property->flags & AST_FLAG_COMPUTED)) {
+        return false;
+    }
+    key->key = property->first_child;
+    key->kind = (property->flags & AST_FLAG_GETTER) ? 1 : (property->flags & AST_FLAG_SETTER) ? 2 : 0;
+
+    const AstNode *n = &engine->ast->nodes[property->first_child];
+    const char *raw = engine->source + n->start;
+    size_t length = n->end - n->start;
+    if (n->kind == AST_IDENTIFIER) {
+        key->text = raw;
+        key->length = (uint32_t)length;
+        return true;
+    }
+    if (n->kind != AST_LITERAL || length == 0) {
+        return false;
+    }
+    if (raw[0] == '"' || raw[0] == '\'') {
+        /* 按字符串的值比较（'\x61' 与 a 相同） */
+        const char *text;
+        size_t text_length;
+        if (!engine->strings && memchr(raw, '\\', length)) {
+            engine->strings = cooked_strings_create();
+            if (!engine->strings) {
+                engine->failed = true;
+                return false;
+            }
+        }
+        if (!cooked_string(engine->strings, raw, length, &text, &text_length) || text_length > UINT32_MAX) {
+            engine->failed = engine->failed || (engine->strings && cooked_strings_failed(engine->strings));
+            return false;
+        }
+        key->text = text;
+        key->length = (uint32_t)text_length;
+        return true;
+    }
+    if (!normalize_number(raw, length, key->number, sizeof(key->number))) {
+        return false;
+    }
+    key->text = NULL;
+    key->length = (uint32_t)strlen(key->number);
+    return true;
+}
+
+static inline const char* key_text(const PropertyKey *key) {
+    return key->text ? key->text : key->number;
+}
+
+static int compare_keys(const void *a, const void *b) {
+    const PropertyKey *x = (const PropertyKey*)a;
+    const PropertyKey *y = (const PropertyKey*)b;
+    if (x->length != y->length) return x->length < y->length ? -1 : 1;
+    int order = memcmp(key_text(x), key_text(y), x->length);
+    if (order != 0) return order;
+    return x->index < y->index ? -1 : x->index > y->index;
+}
+
+/* no-dupe-keys：对象字面量中重复的属性名（一对get/set除外），报告后出现的那一个 */
+static void no_dupe_keys(LintEngine *engine, void *data, uint32_t node) {
+    (void)data;
+    const Ast *ast = engine->ast;
+    size_t count = 0;
+    for (uint32_t c = ast->nodes[node].first_child; c != AST_NONE; c = ast->nodes[c].next_sibling) {
+        count++;
+    }
+    if (count < 2) return;
+
+    PropertyKey inline_keys[DUPE_KEYS_INLINE];
+    PropertyKey *keys = inline_keys;
+    if (count > DUPE_KEYS_INLINE) {
+        keys = (PropertyKey*)malloc(count * sizeof(PropertyKey));
+        if (!keys) {
+            engine->failed = true;
+            return;
+        }
+    }
+
+    size_t used = 0;
+    uint32_t index = 0;
+    for (uint32_t c = ast->nodes[node].first_child; c != AST_NONE;
+         c = ast->nodes[c].next_sibling, index++) {
+        if (property_key(engine, &ast->nodes[c], &keys[used])) {
+            keys[used++].index = index;
+        }
+    }
+    qsort(keys, used, sizeof(PropertyKey), compare_keys);
+
+    for (size_t i = 0; i < used; ) {
+        size_t j = i + 1;
+        while (j < used && keys[j].length == keys[i].length &&
+               memcmp(key_text(&keys[j]), key_text(&keys[i]), keys[i].length) == 0) {
+            j++;
+        }
+        /* 同名的一组，组内按出现顺序 */
+        bool plain = false, getter = false, setter = false;
+        for (size_t k = i; k < j; k++) {
+            bool duplicate;
+            if (keys[k].kind == 1) {
+                duplicate = plain || getter;
+                getter = true;
+            } else if (keys[k].kind == 2) {
+                duplicate = plain || setter;
+                setter = true;
+            } else {
+                duplicate = plain || getter || setter;
+                plain = true;
+            }
+            if (duplicate) {
+                const AstNode *key = &ast->nodes[keys[k].key];
+                lint_report(engine, key->start, key->end, "Duplicate key '%.*s'",
+                            (int)keys[k].length, key_text(&keys[k]));
+            }
+        }
+        i = j;
+    }
+
+    if (keys != inline_keys) free(keys);
+}
+
+bool lint_add_builtin_rules(LintEngine *engine) {
+    int with = lint_add_rule(engine, "no-with", LINT_ERROR, NULL);
+    int debugger = lint_add_rule(engine, "no-debugger", LINT_WARNING, NULL);
+    int dupe_keys = lint_add_rule(engine, "no-dupe-keys", LINT_ERROR, NULL);
+    return with >= 0 && debugger >= 0 && dupe_keys >= 0 &&
+           lint_on_node(engine, with, AST_WITH_STATEMENT, no_with) &&
+           lint_on_token(engine, debugger, TOKEN_DEBUGGER, no_debugger) &&
+           lint_on_node(engine, dupe_keys, AST_OBJECT_EXPRESSION, no_dupe_keys);
+}
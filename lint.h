@@ -0,0 +1,124 @@
+#ifndef LINT_H
+#define LINT_H
+
+#include "lexer.h"
+#include "ast.h"
+#include "writer.h"
+#include "common.h"
+
+#define LINT_TOKEN_TYPES (TOKEN_AUTO_SEMICOLON + 1)
+#define LINT_ARENA_BLOCK (64u << 10)    /* 诊断arena每块的大小，更长的消息单独分配一块 */
+
+/*
+ * lint规则引擎：每条规则只登记它关心的节点类型和token类型，
+ * 一次解析中token回调和随后的一次AST先序遍历都按类型查分派表，
+ * 只调用登记了该类型的处理函数。规则之间互不知晓，增加规则不增加遍历次数。
+ *
+ * 登记完成后第一次运行时把登记表整理成按类型连续存放的分派表
+ * （kind -> [start, end) 区间），运行中不再查找或分支。
+ * 诊断及其消息分配在arena中，一个文件的诊断在下一次运行前一直有效。
+ */
+
+/* 诊断级别 */
+typedef enum {
+    LINT_WARNING,
+    LINT_ERROR
+} LintSeverity;
+
+typedef struct LintEngine LintEngine;
+
+/* 处理函数：data为登记规则时给出的数据 */
+typedef void (*LintNodeHandler)(LintEngine *engine, void *data, uint32_t node);
+typedef void (*LintTokenHandler)(LintEngine *engine, void *data, const Token *token);
+
+/* 一条规则 */
+typedef struct {
+    const char *name;
+    LintSeverity severity;
+    void *data;
+} LintRule;
+
+/* 分派表中的一项 */
+typedef struct {
+    uint16_t type;          /* AstKind或TokenType */
+    uint16_t rule;
+    union {
+        LintNodeHandler node;
+        LintTokenHandler token;
+    } handler;
+} LintHook;
+
+/* 一条诊断（位于arena中） */
+typedef struct LintDiagnostic {
+    struct LintDiagnostic *next;    /* 按报告顺序串联 */
+    uint32_t start;                 /* 源码范围 [start, end) */
+    uint32_t end;
+    uint16_t rule;
+    uint8_t severity;               /* LintSeverity */
+    uint32_t message_length;
+    char message[];                 /* 以'\0'结尾 */
+} LintDiagnostic;
+
+struct LintEngine {
+    LintRule *rules;
+    size_t rule_count;
+    size_t rule_capacity;
+
+    /* 登记表（登记顺序）和分派表（按类型稳定排序，同一类型内保持登记顺序） */
+    LintHook *node_hooks;
+    size_t node_hook_count;
+    size_t node_hook_capacity;
+    LintHook *token_hooks;
+    size_t token_hook_count;
+    size_t token_hook_capacity;
+    LintHook *node_table;
+    LintHook *token_table;
+    uint32_t node_start[AST_KIND_COUNT + 1];
+    uint32_t token_start[LINT_TOKEN_TYPES + 1];
+    bool compiled;
+
+    /* 当前运行（处理函数可以读取） */
+    const char *source;
+    size_t length;
+    const Ast *ast;
+    uint16_t current;               /* 正在运行的规则 */
+
+    /* 诊断 */
+    Arena arena;                    /* 诊断和消息 */
+    LintDiagnostic *first;
+    LintDiagnostic *last;
+    size_t count;
+    size_t error_count;
+    const LintDiagnostic **sorted;  /* lint_run之后按起始偏移排序 */
+    size_t sorted_capacity;
+    uint32_t *stack;                /* 遍历用的栈 */
+    size_t stack_capacity;
+    CookedStrings *strings;         /* 含转义的字符串属性名解码后的值（第一次用到时创建） */
+    bool failed;                    /* 内存不足 */
+};
+
+/* 引擎函数 */
+void lint_engine_init(LintEngine *engine);
+void lint_engine_free(LintEngine *engine);
+
+/* 增加一条规则，返回编号（内存不足返回-1） */
+int lint_add_rule(LintEngine *engine, const char *name, LintSeverity severity, void *data);
+
+/* 规则登记感兴趣的节点类型或token类型 */
+bool lint_on_node(LintEngine *engine, int rule, AstKind kind, LintNodeHandler handler);
+bool lint_on_token(LintEngine *engine, int rule, TokenType type, LintTokenHandler handler);
+
+/* 登记内置规则：no-with、no-debugger、no-dupe-keys */
+bool lint_add_builtin_rules(LintEngine *engine);
+
+/* 处理函数中报告一条诊断（归属当前规则），format为printf格式 */
+void lint_report(LintEngine *engine, size_t start, size_t end, const char *format, ...);
+
+/* 解析源码并运行全部规则。语法错误时记录在error中并返回false；
+   成功时诊断按起始偏移排序在engine->sorted[0..count) */
+bool lint_run(LintEngine *engine, const char *source, size_t length, bool module, ErrorInfo *error);
+
+/* 每条诊断输出一行：file:line:column: severity: message [rule] */
+void lint_write(const LintEngine *engine, const char *file, Writer *writer);
+
+#endif /* LINT_H */
@@ -0,0 +1,820 @@
+#define _POSIX_C_SOURCE 200809L
+#include "lsp.h"
+#include "scope.h"
+#include <time.h>
+
+/* JSON-RPC错误码 */
+#define JSONRPC_PARSE_ERROR      -32700
+#define JSONRPC_INVALID_REQUEST  -32600
+#define JSONRPC_METHOD_NOT_FOUND -32601
+#define JSONRPC_INVALID_PARAMS   -32602
+
+#define JSON_MAX_DEPTH 64           /* 消息的最大嵌套层数 */
+#define LSP_HEADER_LINE 1024        /* 消息头一行的最大长度 */
+
+/* 单调时钟（秒） */
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* ---------- JSON读取 ---------- */
+
+/*
+ * 消息不建树：先整体校验一遍语法，之后按键名在原始文本上查找成员。
+ * LSP消息的键很少，只有didOpen中的文档文本较长，每次查找都跳过它，代价可以忽略。
+ */
+
+/* 消息中的一个JSON值（原始文本，字符串包括引号） */
+typedef struct {
+    const char *data;
+    size_t length;
+} JsonValue;
+
+static const char* skip_space(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+    return p;
+}
+
+/* 越过一个字符串（p指向开头的引号），格式错误返回NULL */
+static const char* skip_string(const char *p, const char *end) {
+    for (p++; p < end; p++) {
+        unsigned char ch = (unsigned char)*p;
+        if (ch == '"') return p + 1;
+        if (ch < 0x20) return NULL;
+        if (ch == '\\' && ++p == end) return NULL;
+    }
+    return NULL;
+}
+
+static const char* skip_literal(const char *p, const char *end, const char *word) {
+    size_t length = strlen(word);
+    if ((size_t)(end - p) < length || memcmp(p, word, length) != 0) return NULL;
+    return p + length;
+}
+
+/* 越过一个值（前面可以有空白），格式错误返回NULL */
+static const char* skip_value(const char *p, const char *end, int depth) {
+    p = skip_space(p, end);
+    if (p == end || depth > JSON_MAX_DEPTH) return NULL;
+
+    switch (*p) {
+        case '"':
+            return skip_string(p, end);
+        case '{':
+        case '[': {
+            bool object = *p == '{';
+            char close = object ? '}' : ']';
+            p = skip_space(p + 1, end);
+            if (p < end && *p == close) return p + 1;
+            for (;;) {
+                if (object) {
+                    p = skip_space(p, end);
+                    if (p == end || *p != '"' || !(p = skip_string(p, end))) return NULL;
+                    p = skip_space(p, end);
+                    if (p == end || *p != ':') return NULL;
+                    p++;
+                }
+                if (!(p = skip_value(p, end, depth + 1))) return NULL;
+                p = skip_space(p, end);
+                if (p == end) return NULL;
+                if (*p == close) return p + 1;
+                if (*p != ',') return NULL;
+                p++;
+            }
+        }
+        case 't':
+            return skip_literal(p, end, "true");
+        case 'f':
+            return skip_literal(p, end, "false");
+        case 'n':
+            return skip_literal(p, end, "null");
+        default:
+            break;
+    }
+
+    if (*p != '-' && (*p < '0' || *p > '9')) return NULL;
+    for (p++; p < end && ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' ||
+                          *p == 'E' || *p == '+' || *p == '-'); p++) {
+    }
+    return p;
+}
+
+/* 按键名查找对象的成员（键名不含转义） */
+static bool json_member(JsonValue object, const char *key, JsonValue *value) {
+    const char *end = object.data + object.length;
+    size_t key_length = strlen(key);
+    if (object.length < 2 || object.data[0] != '{') return false;
+
+    const char *p = skip_space(object.data + 1, end);
+    while (p < end && *p == '"') {
+        const char *name = p;
+        p = skip_string(p, end);
+        if (!p) return false;
+        bool match = (size_t)(p - name) == key_length + 2 &&
+                     memcmp(name + 1, key, key_length) == 0;
+
+        p = skip_space(p, end);
+        if (p == end || *p != ':') return false;
+        const char *start = skip_space(p + 1, end);
+        p = skip_value(start, end, 1);
+        if (!p) return false;
+        if (match) {
+            value->data = start;
+            value->length = (size_t)(p - start);
+            return true;
+        }
+
+        p = skip_space(p, end);
+        if (p == end || *p != ',') return false;
+        p = skip_space(p + 1, end);
+    }
+    return false;
+}
+
+/* 依次取数组的元素（*cursor开始时为NULL） */
+static bool json_next_element(JsonValue array, const char **cursor, JsonValue *element) {
+    const char *end = array.data + array.length;
+    if (array.length < 2 || array.data[0] != '[') return false;
+
+    const char *p = skip_space(*cursor ? *cursor : array.data + 1, end);
+    if (*cursor) {
+        if (p == end || *p != ',') return false;
+        p = skip_space(p + 1, end);
+    }
+    if (p == end || *p == ']') return false;
+
+    const char *next = skip_value(p, end, 1);
+    if (!next) return false;
+    element->data = p;
+    element->length = (size_t)(next - p);
+    *cursor = next;
+    return true;
+}
+
+/* 整数值 */
+static bool json_integer(JsonValue value, int64_t *result) {
+    const char *p = value.data;
+    const char *end = value.data + value.length;
+    bool negative = p < end && *p == '-';
+    if (negative) p++;
+    if (p == end) return false;
+
+    int64_t number = 0;
+    for (; p < end; p++) {
+        if (*p < '0' || *p > '9' || number > (INT64_MAX - 9) / 10) return false;
+        number = number * 10 + (*p - '0');
+    }
+    *result = negative ? -number : number;
+    return true;
+}
+
+/* 与不含转义的字符串比较 */
+static bool json_is(JsonValue value, const char *text) {
+    size_t length = strlen(text);
+    return value.length == length + 2 && value.data[0] == '"' &&
+           memcmp(value.data + 1, text, length) == 0;
+}
+
+/* 读取\u之后的4位十六进制数，失败返回-1 */
+static long read_hex4(const char *p, const char *end) {
+    uint32_t unit;
+    return unicode_escape_value(p, (size_t)(end - p), false, &unit) == 4 ? (long)unit : -1;
+}
+
+/* 解码字符串值为UTF-8（新分配，以'\0'结尾）。不配对的代理项换成U+FFFD。
+   解码结果不会比原文长。不是字符串、转义错误或内存不足时返回NULL */
+static char* json_decode(JsonValue value, size_t *length) {
+    if (value.length < 2 || value.data[0] != '"') return NULL;
+    const char *p = value.data + 1;
+    const char *end = value.data + value.length - 1;
+
+    char *text = (char*)malloc((size_t)(end - p) + 1);
+    if (!text) return NULL;
+    size_t n = 0;
+
+    while (p < end) {
+        const char *escape = (const char*)memchr(p, '\\', (size_t)(end - p));
+        size_t run = escape ? (size_t)(escape - p) : (size_t)(end - p);
+        memcpy(text + n, p, run);
+        n += run;
+        p += run;
+        if (!escape) break;
+
+        if (++p == end) break;
+        char ch = *p++;
+        switch (ch) {
+            case '"': text[n++] = '"'; break;
+            case '\\': text[n++] = '\\'; break;
+            case '/': text[n++] = '/'; break;
+            case 'b': text[n++] = '\b'; break;
+            case 'f': text[n++] = '\f'; break;
+            case 'n': text[n++] = '\n'; break;
+            case 'r': text[n++] = '\r'; break;
+            case 't': text[n++] = '\t'; break;
+            case 'u': {
+                long unit = read_hex4(p, end);
+                if (unit < 0) {
+                    free(text);
+                    return NULL;
+                }
+                p += 4;
+                uint32_t code = (uint32_t)unit;
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    long low = end - p >= 6 && p[0] == '\\' && p[1] == 'u' ? read_hex4(p + 2, end) : -1;
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        code = 0x10000 + ((code - 0xD800) << 10) + ((uint32_t)low - 0xDC00);
+                        p += 6;
+                    } else {
+                        code = 0xFFFD;
+                    }
+                } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                    code = 0xFFFD;
+                }
+                n += utf8_encode(text + n, code);
+                break;
+            }
+            default:
+                free(text);
+                return NULL;
+        }
+    }
+
+    text[n] = '\0';
+    *length = n;
+    return text;
+}
+
+/* ---------- 输出 ---------- */
+
+/* 把body中的消息加上Content-Length头写到输出 */
+static void send_message(LspServer *server) {
+    Writer *body = &server->body;
+
+    /* 消息体超过了缓冲（只有异常长的URI才会这样），已经无法完整发出 */
+    if (body->total > 0) {
+        fprintf(stderr, "[lsp] message too large, dropped\n");
+    } else {
+        char header[64];
+        int n = snprintf(header, sizeof(header), "Content-Length: %zu\r\n\r\n", body->length);
+        writer_write(server->out, header, (size_t)n);
+        writer_write(server->out, body->buffer, body->length);
+        writer_flush(server->out);
+        if (server->out->file) fflush(server->out->file);
+    }
+
+    body->length = 0;
+    body->total = 0;
+}
+
+/* 响应的开头，其后是result的值 */
+static void begin_result(LspServer *server, JsonValue id) {
+    writer_cstr(&server->body, "{\"jsonrpc\":\"2.0\",\"id\":");
+    writer_write(&server->body, id.data, id.length);
+    writer_cstr(&server->body, ",\"result\":");
+}
+
+/* 错误响应（id为NULL时为null） */
+static void send_error(LspServer *server, const JsonValue *id, int code, const char *message) {
+    Writer *body = &server->body;
+    writer_cstr(body, "{\"jsonrpc\":\"2.0\",\"id\":");
+    if (id) {
+        writer_write(body, id->data, id->length);
+    } else {
+        writer_cstr(body, "null");
+    }
+    writer_cstr(body, ",\"error\":{\"code\":");
+    if (code < 0) writer_byte(body, '-');
+    writer_uint(body, (uint64_t)(code < 0 ? -(int64_t)code : code));
+    writer_cstr(body, ",\"message\":");
+    writer_json_string(body, message, strlen(message));
+    writer_cstr(body, "}}");
+    send_message(server);
+}
+
+/* ---------- 位置换算 ---------- */
+
+/* LSP位置（行、UTF-16列）对应的字节偏移，超出行尾或文件末尾时截断 */
+static size_t document_offset(const LspDocument *document, int64_t line, int64_t character) {
+    const LineIndex *lines = &document->lines;
+    const char *source = document->doc->source;
+    size_t length = document->doc->length;
+
+    if (line < 0) return 0;
+    if ((uint64_t)line >= lines->count) return length;
+
+    size_t p = lines->starts[line];
+    size_t end = (size_t)line + 1 < lines->count ? lines->starts[line + 1] : length;
+    while (end > p && (source[end - 1] == '\n' || source[end - 1] == '\r')) end--;
+
+    for (int64_t units = 0; p < end && units < character; ) {
+        unsigned char ch = (unsigned char)source[p];
+        size_t size = ch < 0xC0 ? 1 : ch < 0xE0 ? 2 : ch < 0xF0 ? 3 : 4;
+        units += size == 4 ? 2 : 1;
+        p += size;
+    }
+    return p < end ? p : end;
+}
+
+/* 字节偏移对应的LSP位置 */
+static LinePosition document_position(const LspDocument *document, size_t offset) {
+    const LineIndex *lines = &document->lines;
+    if (offset > document->doc->length) offset = document->doc->length;
+
+    LinePosition position;
+    position.line = line_index_line(lines, offset);
+    size_t start = lines->starts[position.line];
+    position.column = utf16_length(document->doc->source + start, offset - start);
+    return position;
+}
+
+static void write_position(Writer *writer, LinePosition position) {
+    writer_cstr(writer, "{\"line\":");
+    writer_uint(writer, position.line);
+    writer_cstr(writer, ",\"character\":");
+    writer_uint(writer, position.column);
+    writer_byte(writer, '}');
+}
+
+/* ---------- 文档 ---------- */
+
+static LspDocument* find_document(LspServer *server, const char *uri, size_t length) {
+    for (size_t i = 0; i < server->document_count; i++) {
+        LspDocument *document = &server->documents[i];
+        if (document->uri_length == length && memcmp(document->uri, uri, length) == 0) {
+            return document;
+        }
+    }
+    return NULL;
+}
+
+static void document_free(LspDocument *document) {
+    free(document->uri);
+    incremental_destroy(document->doc);
+    line_index_free(&document->lines);
+}
+
+/* 语法正确时对整个文本建AST做作用域检查。增量解析只保留语句范围、不保留AST，
+   所以这一步总是整体解析（与 --minify 等共用scope_parse） */
+static void check_scopes(LspDocument *document) {
+    const IncrementalDocument *doc = document->doc;
+    ErrorInfo *error = &document->scope_error;
+    memset(error, 0, sizeof(*error));
+    if (!doc->valid) return;
+
+    Ast ast;
+    if (!ast_init(&ast, doc->length)) {
+        fprintf(stderr, "[lsp] out of memory checking scopes\n");
+        return;
+    }
+    Lexer *lexer = lexer_create(doc->source, doc->length, error);
+    Parser *parser = lexer ? parser_create(lexer, error) : NULL;
+    if (parser) {
+        parser->ast = &ast;
+        parser->module = doc->module;
+        if (scope_parse(parser) && ast.failed) {
+            fprintf(stderr, "[lsp] out of memory checking scopes\n");
+        }
+    }
+    parser_destroy(parser);
+    lexer_destroy(lexer);
+    ast_free(&ast);
+}
+
+/* 发布诊断：语法错误，语法正确时为作用域错误（都没有时为空数组），与上一次发布的相同时不发 */
+static void publish_diagnostics(LspServer *server, LspDocument *document, bool closing) {
+    const ErrorInfo *error = NULL;
+    if (!closing && !document->doc->valid) {
+        error = &document->doc->error;
+    } else if (!closing && document->scope_error.code != ERROR_NONE) {
+        error = &document->scope_error;
+    }
+    const ErrorInfo *last = &document->diagnostic;
+
+    if (document->published && !closing) {
+        if (!error && last->code == ERROR_NONE) return;
+        if (error && error->code == last->code && error->position.offset == last->position.offset &&
+            strcmp(error->message, last->message) == 0) {
+            return;
+        }
+    }
+    document->published = true;
+    if (error) {
+        document->diagnostic = *error;
+    } else {
+        memset(&document->diagnostic, 0, sizeof(document->diagnostic));
+    }
+
+    Writer *body = &server->body;
+    writer_cstr(body, "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\","
+                      "\"params\":{\"uri\":");
+    writer_json_string(body, document->uri, document->uri_length);
+    if (!closing) {
+        writer_cstr(body, ",\"version\":");
+        if (document->version < 0) writer_byte(body, '-');
+        writer_uint(body, (uint64_t)(document->version < 0 ? -document->version : document->version));
+    }
+    writer_cstr(body, ",\"diagnostics\":[");
+
+    if (error) {
+        /* 范围是出错位置的一个字符（在行尾或文件末尾时为空） */
+        size_t offset = error->position.offset < 0 ? 0 : (size_t)error->position.offset;
+        LinePosition start = document_position(document, offset);
+        LinePosition end = start;
+        if (offset < document->doc->length) {
+            unsigned char ch = (unsigned char)document->doc->source[offset];
+            if (ch != '\n' && ch != '\r') {
+                end.column += ch >= 0xF0 ? 2 : 1;
+            }
+        }
+
+        writer_cstr(body, "{\"range\":{\"start\":");
+        write_position(body, start);
+        writer_cstr(body, ",\"end\":");
+        write_position(body, end);
+        writer_cstr(body, "},\"severity\":1,\"source\":\"js_parser\",\"message\":");
+        writer_json_string(body, error->message, strlen(error->message));
+        writer_byte(body, '}');
+    }
+
+    writer_cstr(body, "]}}");
+    send_message(server);
+}
+
+/* textDocument的uri（解码后，新分配） */
+static char* document_uri(JsonValue params, size_t *length) {
+    JsonValue text_document, uri;
+    if (!json_member(params, "textDocument", &text_document) ||
+        !json_member(text_document, "uri", &uri)) {
+        return NULL;
+    }
+    return json_decode(uri, length);
+}
+
+static void did_open(LspServer *server, JsonValue params) {
+    JsonValue text_document, text_value, version;
+    size_t uri_length, length;
+    char *uri = document_uri(params, &uri_length);
+    if (!uri) return;
+
+    char *text = NULL;
+    if (json_member(params, "textDocument", &text_document) &&
+        json_member(text_document, "text", &text_value)) {
+        text = json_decode(text_value, &length);
+    }
+    if (!text) {
+        free(uri);
+        return;
+    }
+
+    /* 同一文档重复打开时替换 */
+    LspDocument *document = find_document(server, uri, uri_length);
+    if (document) {
+        document_free(document);
+    } else {
+        if (server->document_count == server->document_capacity) {
+            size_t capacity = server->document_capacity ? server->document_capacity * 2 : 8;
+            LspDocument *documents = (LspDocument*)realloc(server->documents,
+                                                           capacity * sizeof(LspDocument));
+            if (!documents) {
+                free(uri);
+                free(text);
+                return;
+            }
+            server->documents = documents;
+            server->document_capacity = capacity;
+        }
+        document = &server->documents[server->document_count++];
+    }
+    memset(document, 0, sizeof(*document));
+    document->uri = uri;
+    document->uri_length = uri_length;
+    if (json_member(text_document, "version", &version)) {
+        json_integer(version, &document->version);
+    }
+
+    bool module = uri_length > 4 && memcmp(uri + uri_length - 4, ".mjs", 4) == 0;
+    document->doc = incremental_create(text, length, module);
+    free(text);
+    if (!document->doc || !line_index_build(&document->lines, document->doc->source,
+                                            document->doc->length)) {
+        fprintf(stderr, "[lsp] out of memory opening document\n");
+        document_free(document);
+        *document = server->documents[--server->document_count];
+        return;
+    }
+
+    check_scopes(document);
+    publish_diagnostics(server, document, false);
+}
+
+/* 应用一个修改（没有range时替换整个文本） */
+static bool apply_change(LspDocument *document, JsonValue change) {
+    JsonValue range, text_value, position, line, character;
+    size_t length;
+    char *text = json_member(change, "text", &text_value) ? json_decode(text_value, &length) : NULL;
+    if (!text) return false;
+
+    IncrementalDocument *doc = document->doc;
+    size_t offsets[2] = {0, doc->length};
+    if (json_member(change, "range", &range)) {
+        const char *names[2] = {"start", "end"};
+        for (int i = 0; i < 2; i++) {
+            int64_t l = 0;
+            int64_t c = 0;
+            if (!json_member(range, names[i], &position) ||
+                !json_member(position, "line", &line) || !json_integer(line, &l) ||
+                !json_member(position, "character", &character) || !json_integer(character, &c)) {
+                free(text);
+                return false;
+            }
+            offsets[i] = document_offset(document, l, c);
+        }
+        if (offsets[1] < offsets[0]) offsets[1] = offsets[0];
+    }
+
+    TextEdit edit = {offsets[0], offsets[1] - offsets[0], text, length};
+    bool ok = incremental_edit(doc, &edit);
+    if (ok && !line_index_edit(&document->lines, doc->source, doc->length,
+                               edit.offset, edit.removed, edit.text_length)) {
+        line_index_free(&document->lines);
+        ok = line_index_build(&document->lines, doc->source, doc->length);
+    }
+    free(text);
+    return ok;
+}
+
+static void did_change(LspServer *server, JsonValue params) {
+    JsonValue text_document, version, changes, change;
+    size_t uri_length;
+    char *uri = document_uri(params, &uri_length);
+    if (!uri) return;
+    LspDocument *document = find_document(server, uri, uri_length);
+    free(uri);
+    if (!document) return;
+
+    if (json_member(params, "textDocument", &text_document) &&
+        json_member(text_document, "version", &version)) {
+        json_integer(version, &document->version);
+    }
+
+    /* 依次应用全部修改（每个修改的位置基于前一个修改之后的文本），然后只解析一次 */
+    if (json_member(params, "contentChanges", &changes)) {
+        const char *cursor = NULL;
+        while (json_next_element(changes, &cursor, &change)) {
+            if (!apply_change(document, change)) {
+                fprintf(stderr, "[lsp] invalid change ignored\n");
+            }
+        }
+    }
+
+    IncrementalDocument *doc = document->doc;
+    bool pending = doc->pending;
+    incremental_reparse(doc);
+    if (pending) {
+        server->full_reparses += doc->full_reparse;
+        server->reparsed_bytes += doc->reparsed_end - doc->reparsed_start;
+    }
+    check_scopes(document);
+    publish_diagnostics(server, document, false);
+}
+
+static void did_close(LspServer *server, JsonValue params) {
+    size_t uri_length;
+    char *uri = document_uri(params, &uri_length);
+    if (!uri) return;
+    LspDocument *document = find_document(server, uri, uri_length);
+    free(uri);
+    if (!document) return;
+
+    publish_diagnostics(server, document, true);
+    document_free(document);
+    *document = server->documents[--server->document_count];
+}
+
+/* ---------- 服务器 ---------- */
+
+bool lsp_server_init(LspServer *server, Writer *out) {
+    memset(server, 0, sizeof(*server));
+    server->out = out;
+    return writer_init(&server->body, NULL);
+}
+
+void lsp_server_free(LspServer *server) {
+    for (size_t i = 0; i < server->document_count; i++) {
+        document_free(&server->documents[i]);
+    }
+    free(server->documents);
+    server->documents = NULL;
+    server->document_count = 0;
+    writer_close(&server->body);
+}
+
+/* 处理一条消息 */
+void lsp_handle(LspServer *server, const char *message, size_t length) {
+    double start = now_seconds();
+    const char *end = message + length;
+
+    const char *first = skip_space(message, end);
+    const char *last = skip_value(first, end, 0);
+    if (!last || skip_space(last, end) != end || *first != '{') {
+        send_error(server, NULL, JSONRPC_PARSE_ERROR, "Parse error");
+        return;
+    }
+
+    JsonValue root = {first, (size_t)(last - first)};
+    JsonValue method, id, params;
+    bool has_id = json_member(root, "id", &id);
+    bool has_params = json_member(root, "params", &params);
+
+    /* 没有method的是对服务器请求的响应，服务器不发请求，忽略 */
+    if (!json_member(root, "method", &method)) return;
+
+    if (server->shutdown && has_id) {
+        send_error(server, &id, JSONRPC_INVALID_REQUEST, "Server is shutting down");
+    } else if (json_is(method, "initialize") && has_id) {
+        begin_result(server, id);
+        writer_cstr(&server->body,
+                    "{\"capabilities\":{\"positionEncoding\":\"utf-16\","
+                    "\"textDocumentSync\":{\"openClose\":true,\"change\":2}},"
+                    "\"serverInfo\":{\"name\":\"js_parser\"}}}");
+        send_message(server);
+    } else if (json_is(method, "shutdown") && has_id) {
+        server->shutdown = true;
+        begin_result(server, id);
+        writer_cstr(&server->body, "null}");
+        send_message(server);
+    } else if (json_is(method, "exit")) {
+        server->exited = true;
+    } else if (json_is(method, "textDocument/didOpen")) {
+        if (has_params) did_open(server, params);
+    } else if (json_is(method, "textDocument/didChange")) {
+        if (has_params) {
+            did_change(server, params);
+            lsp_histogram_add(&server->latency, now_seconds() - start);
+        }
+    } else if (json_is(method, "textDocument/didClose")) {
+        if (has_params) did_close(server, params);
+    } else if (has_id) {
+        send_error(server, &id, JSONRPC_METHOD_NOT_FOUND, "Method not found");
+    }
+}
+
+/* 解析消息头的一行，Content-Length之外的头忽略 */
+static void parse_header(const char *line, size_t length, size_t *content_length) {
+    static const char name[] = "content-length:";
+    size_t name_length = sizeof(name) - 1;
+    if (length <= name_length) return;
+    for (size_t i = 0; i < name_length; i++) {
+        char ch = line[i];
+        if (ch >= 'A' && ch <= 'Z') ch = (char)(ch - 'A' + 'a');
+        if (ch != name[i]) return;
+    }
+
+    size_t value = 0;
+    size_t i = name_length;
+    while (i < length && line[i] == ' ') i++;
+    for (; i < length && line[i] >= '0' && line[i] <= '9'; i++) {
+        value = value * 10 + (size_t)(line[i] - '0');
+        if (value > LSP_MAX_MESSAGE) return;
+    }
+    *content_length = value;
+}
+
+bool lsp_next_message(const char *data, size_t length, size_t *offset,
+                      const char **message, size_t *message_length) {
+    size_t p = *offset;
+    size_t content_length = SIZE_MAX;
+
+    /* 消息头：每行以\r\n结束，空行之后是消息体 */
+    for (;;) {
+        const char *eol = (const char*)memchr(data + p, '\n', length - p);
+        if (!eol) return false;
+        size_t line_end = (size_t)(eol - data);
+        size_t text_end = line_end > p && data[line_end - 1] == '\r' ? line_end - 1 : line_end;
+        if (text_end == p) {
+            p = line_end + 1;
+            break;
+        }
+        parse_header(data + p, text_end - p, &content_length);
+        p = line_end + 1;
+    }
+
+    if (content_length == SIZE_MAX || content_length > length - p) return false;
+    *message = data + p;
+    *message_length = content_length;
+    *offset = p + content_length;
+    return true;
+}
+
+/* 从文件读取一条消息到*buffer，输入结束或格式错误返回false */
+static bool read_message(FILE *in, char **buffer, size_t *capacity, size_t *length) {
+    size_t content_length = SIZE_MAX;
+    char line[LSP_HEADER_LINE];
+
+    for (;;) {
+        if (!fgets(line, sizeof(line), in)) return false;
+        size_t n = strlen(line);
+        while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) n--;
+        if (n == 0) break;
+        parse_header(line, n, &content_length);
+    }
+    if (content_length == SIZE_MAX) return false;
+
+    if (content_length + 1 > *capacity) {
+        char *data = (char*)realloc(*buffer, content_length + 1);
+        if (!data) return false;
+        *buffer = data;
+        *capacity = content_length + 1;
+    }
+    if (fread(*buffer, 1, content_length, in) != content_length) return false;
+    (*buffer)[content_length] = '\0';
+    *length = content_length;
+    return true;
+}
+
+int lsp_run(FILE *in, FILE *out, FILE *record) {
+    Writer writer;
+    LspServer server;
+    if (!writer_init(&writer, out)) return 1;
+    if (!lsp_server_init(&server, &writer)) {
+        writer_close(&writer);
+        return 1;
+    }
+
+    char *message = NULL;
+    size_t capacity = 0;
+    size_t length;
+    while (!server.exited && read_message(in, &message, &capacity, &length)) {
+        if (record) {
+            fprintf(record, "Content-Length: %zu\r\n\r\n", length);
+            fwrite(message, 1, length, record);
+            fflush(record);
+        }
+        lsp_handle(&server, message, length);
+    }
+
+    if (server.latency.count > 0) {
+        lsp_histogram_print(&server.latency, "didChange", stderr);
+    }
+
+    /* 先收到shutdown再收到exit才算正常退出 */
+    int code = server.exited && server.shutdown ? 0 : 1;
+    free(message);
+    lsp_server_free(&server);
+    writer_close(&writer);
+    return code;
+}
+
+/* ---------- 延迟直方图 ---------- */
+
+void lsp_histogram_add(LspHistogram *histogram, double seconds) {
+    double micros = seconds * 1e6;
+    size_t bucket = 0;
+    while (bucket + 1 < LSP_LATENCY_BUCKETS && micros >= (double)(2ull << bucket)) {
+        bucket++;
+    }
+    histogram->buckets[bucket]++;
+    histogram->count++;
+    histogram->total += seconds;
+    if (seconds > histogram->max) histogram->max = seconds;
+}
+
+/* 分位数的上界（所在桶的上界，不超过最大值），单位秒 */
+double lsp_histogram_percentile(const LspHistogram *histogram, double fraction) {
+    uint64_t target = (uint64_t)(fraction * (double)histogram->count);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LSP_LATENCY_BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if (seen > target || seen == histogram->count) {
+            double upper = (double)(2ull << i) / 1e6;
+            return upper < histogram->max ? upper : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+void lsp_histogram_print(const LspHistogram *histogram, const char *label, FILE *file) {
+    if (histogram->count == 0) return;
+
+    fprintf(file, "[lsp] %s latency: %llu samples, mean %.1f us, p50 <= %.0f us, "
+            "p90 <= %.0f us, p99 <= %.0f us, max %.1f us\n", label,
+            (unsigned long long)histogram->count, histogram->total / histogram->count * 1e6,
+            lsp_histogram_percentile(histogram, 0.5) * 1e6,
+            lsp_histogram_percentile(histogram, 0.9) * 1e6,
+            lsp_histogram_percentile(histogram, 0.99) * 1e6, histogram->max * 1e6);
+
+    uint64_t peak = 0;
+    for (size_t i = 0; i < LSP_LATENCY_BUCKETS; i++) {
+        if (histogram->buckets[i] > peak) peak = histogram->buckets[i];
+    }
+    for (size_t i = 0; i < LSP_LATENCY_BUCKETS; i++) {
+        if (histogram->buckets[i] == 0) continue;
+        int bar = (int)((histogram->buckets[i] * 40 + peak - 1) / peak);
+        fprintf(file, "  %8llu - %8llu us %8llu  %.*s\n",
+                i == 0 ? 0ull : 1ull << i, 2ull << i,
+                (unsigned long long)histogram->buckets[i], bar,
+                "########################################");
+    }
+}
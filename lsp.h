@@ -0,0 +1,80 @@
+#ifndef LSP_H
+#define LSP_H
+
+#include "incremental.h"
+#include "line_index.h"
+#include "writer.h"
+#include "common.h"
+
+#define LSP_LATENCY_BUCKETS 32      /* 第i个桶：[2^i, 2^(i+1)) 微秒（第0个桶从0开始） */
+#define LSP_MAX_MESSAGE (256u << 20) /* 单条消息的上限 */
+
+/*
+ * Language Server Protocol（stdio，JSON-RPC，Content-Length分帧）：
+ * 支持initialize/shutdown/exit和textDocument的didOpen/didChange/didClose，
+ * 文档按增量方式同步（textDocumentSync.change = 2），每次变化后发布语法和作用域诊断。
+ *
+ * 打开的文档是一个IncrementalDocument和一个随编辑更新的行索引：LSP的位置
+ * （行、UTF-16列）经行索引换算为字节偏移，编辑直接作用在文本上，
+ * 一次didChange的全部修改之后只重新解析一次，范围限于包含修改的语句。
+ * 语法正确时再对整个文本建AST做作用域检查（重复声明等），两者合并为一个诊断，
+ * 与上一次发布的相同时不再发布。
+ */
+
+/* 延迟直方图（对数分桶） */
+typedef struct {
+    uint64_t buckets[LSP_LATENCY_BUCKETS];
+    uint64_t count;
+    double total;           /* 秒 */
+    double max;
+} LspHistogram;
+
+/* 一个打开的文档 */
+typedef struct {
+    char *uri;
+    size_t uri_length;
+    int64_t version;
+    IncrementalDocument *doc;
+    LineIndex lines;
+    bool published;         /* 已发布过诊断 */
+    ErrorInfo diagnostic;   /* 上一次发布的诊断（code为ERROR_NONE表示没有） */
+    ErrorInfo scope_error;  /* 语法正确时作用域检查的第一个错误（code为ERROR_NONE表示没有） */
+} LspDocument;
+
+/* 服务器状态 */
+typedef struct {
+    Writer *out;            /* 分帧后的输出 */
+    Writer body;            /* 消息体先写到这里（不落地的缓冲） */
+    LspDocument *documents;
+    size_t document_count;
+    size_t document_capacity;
+    bool shutdown;          /* 已收到shutdown请求 */
+    bool exited;            /* 已收到exit通知 */
+
+    /* 统计：每次didChange从收到消息到发布诊断 */
+    LspHistogram latency;
+    size_t full_reparses;
+    size_t reparsed_bytes;
+} LspServer;
+
+/* 服务器函数 */
+bool lsp_server_init(LspServer *server, Writer *out);
+void lsp_server_free(LspServer *server);
+
+/* 处理一条消息（JSON文本），响应和通知写到server->out */
+void lsp_handle(LspServer *server, const char *message, size_t length);
+
+/* 从data[*offset]开始读取下一条分帧的消息（用于回放录制的会话） */
+bool lsp_next_message(const char *data, size_t length, size_t *offset,
+                      const char **message, size_t *message_length);
+
+/* 在stdio上运行服务器直到exit或输入结束；record非NULL时把收到的每条消息
+   原样（带Content-Length头）写入，可用js_bench lsp回放。返回进程退出码 */
+int lsp_run(FILE *in, FILE *out, FILE *record);
+
+/* 直方图 */
+void lsp_histogram_add(LspHistogram *histogram, double seconds);
+double lsp_histogram_percentile(const LspHistogram *histogram, double fraction);
+void lsp_histogram_print(const LspHistogram *histogram, const char *label, FILE *file);
+
+#endif /* LSP_H */
@@ -1,9 +1,35 @@
 #include "parser.h"
 #include "lexer.h"
 #include "common.h"
+#include "parallel.h"
+#include "structural.h"
+#include "estree.h"
+#include "ast_binary.h"
+#include "token_stream.h"
+#include "minify.h"
+#include "module_scan.h"
+#include "module_graph.h"
+#include "treeshake.h"
+#include "bundle.h"
+#include "format.h"
+#include "scope.h"
+#include "ident_index.h"
+#include "lint.h"
+#include "highlight.h"
+#include "lsp.h"
+#include "fold.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <fcntl.h>
+#include <io.h>
+#define getcwd _getcwd
+#else
+#include <unistd.h>
+#endif
 
 /* 读取文件内容 */
 char* read_file(const char *filename, size_t *length) {
@@ -45,8 +71,8 @@ char* read_file(const char *filename, size_t *length) {
     return content;
 }
 
-/* 解析JavaScript文件 */
-bool parse_javascript_file(const char *filename) {
+/* 解析JavaScript文件（thread_count > 1 时对大文件按顶层区域并行解析，module为true时按ES模块解析） */
+bool parse_javascript_file(const char *filename, int thread_count, bool module) {
     size_t length;
     char *source = read_file(filename, &length);
     
@@ -58,26 +84,16 @@ bool parse_javascript_file(const char *filename) {
     ErrorInfo error = {0};
     error.code = ERROR_NONE;
     
-    /* 创建词法分析器 */
-    Lexer *lexer = lexer_create(source, length, &error);
-    if (!lexer) {
-        fprintf(stderr, "Error: Cannot create lexer\n");
-        free(source);
-        return false;
+    /* 执行解析（先用结构索引快速拒绝括号不配对的文件），语法正确后在同一棵AST上检查重复声明 */
+    Ast ast;
+    bool success = structural_check(source, length, &error) &&
+                   parallel_parse(source, length, thread_count, module, &ast, &error) &&
+                   error.code == ERROR_NONE;
+    if (success) {
+        success = scope_check(&ast, source, &error);
+        ast_free(&ast);
     }
     
-    /* 创建语法分析器 */
-    Parser *parser = parser_create(lexer, &error);
-    if (!parser) {
-        fprintf(stderr, "Error: Cannot create parser\n");
-        lexer_destroy(lexer);
-        free(source);
-        return false;
-    }
-    
-    /* 执行解析 */
-    bool success = parser_parse(parser);
-    
     /* 输出结果 */
     if (success && error.code == ERROR_NONE) {
         printf("✓ Syntax is valid\n");
@@ -91,15 +107,13 @@ bool parse_javascript_file(const char *filename) {
     }
     
     /* 清理资源 */
-    parser_destroy(parser);
-    lexer_destroy(lexer);
     free(source);
     
     return success;
 }
 
 /* 解析字符串 */
-bool parse_javascript_string(const char *source) {
+bool parse_javascript_string(const char *source, bool module) {
     if (!source) return false;
     
     size_t length = strlen(source);
@@ -108,6 +122,13 @@ bool parse_javascript_string(const char *source) {
     ErrorInfo error = {0};
     error.code = ERROR_NONE;
     
+    /* 括号确定不配对时无需解析 */
+    if (!structural_check(source, length, &error)) {
+        printf("✗ Syntax error detected\n");
+        print_error(&error);
+        return false;
+    }
+    
     /* 创建词法分析器 */
     Lexer *lexer = lexer_create(source, length, &error);
     if (!lexer) {
@@ -123,8 +144,21 @@ bool parse_javascript_string(const char *source) {
         return false;
     }
     
-    /* 执行解析 */
-    bool success = parser_parse(parser);
+    /* 执行解析，语法正确后在同一棵AST上检查重复声明 */
+    Ast ast;
+    bool success = ast_init(&ast, length);
+    if (!success) {
+        set_error(&error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+    } else {
+        parser->ast = &ast;
+        parser->module = module;
+        success = scope_parse(parser);
+        if (success && ast.failed) {
+            set_error(&error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+            success = false;
+        }
+        ast_free(&ast);
+    }
     
     /* 输出结果 */
     if (success && error.code == ERROR_NONE) {
@@ -141,7 +175,691 @@ bool parse_javascript_string(const char *source) {
     return success;
 }
 
+/* 输出格式 */
+typedef enum {
+    EMIT_NONE,
+    EMIT_ESTREE,        /* ESTree JSON */
+    EMIT_AST,           /* 二进制AST（见ast_binary.h） */
+    EMIT_TOKENS,        /* 二进制token流（见token_stream.h） */
+    EMIT_TOKENS_JSONL,  /* 每行一个token的JSON */
+    EMIT_MINIFY,        /* 压缩后的源码（见minify.h） */
+    EMIT_FORMAT,        /* 格式化后的源码（见format.h） */
+    EMIT_SCOPES,        /* 作用域树（见scope.h） */
+    EMIT_LINT,          /* lint诊断（见lint.h） */
+    EMIT_HIGHLIGHT,     /* LSP语义token（见highlight.h） */
+    EMIT_FOLD,          /* 常量折叠后的源码（见fold.h） */
+    EMIT_IMPORTS        /* 模块说明符（见module_scan.h） */
+} EmitFormat;
+
+/* 输出选项 */
+typedef struct {
+    EmitFormat format;
+    const char *output;         /* 输出文件，NULL为标准输出 */
+    const char *source_map;     /* source map文件（只用于压缩），NULL表示不生成 */
+    const char *source_name;    /* 源文件名（lint诊断和source map中使用） */
+    bool source_file;           /* source_name是文件路径（-s时为false） */
+    bool module;                /* 按ES模块解析（允许import/export） */
+    const char *lines;          /* 高亮的行范围 "a:b"（从1开始，含两端），NULL为整个文件 */
+    const char *checkpoints;    /* 高亮检查点表文件，NULL表示每次重新建立 */
+} EmitOptions;
+
+/* 对源码做词法分析并输出token流（不做语法分析） */
+bool emit_tokens(const char *source, size_t length, const EmitOptions *options) {
+    Writer writer;
+    if (!writer_open(&writer, options->output)) {
+        return false;
+    }
+    
+    ErrorInfo error = {0};
+    error.code = ERROR_NONE;
+    TokenStreamFormat stream = options->format == EMIT_TOKENS ? TOKEN_STREAM_BINARY : TOKEN_STREAM_JSONL;
+    bool success = token_stream_write(source, length, stream, &writer, &error);
+    if (!writer_close(&writer)) {
+        fprintf(stderr, "Error: Cannot write output\n");
+        success = false;
+    } else if (!success) {
+        if (error.code != ERROR_NONE) {
+            print_error(&error);
+        } else {
+            fprintf(stderr, "Error: Out of memory\n");
+        }
+    }
+    return success;
+}
+
+/* 只扫描模块说明符，每行输出一个JSON对象 */
+bool emit_imports(const char *source, size_t length, const EmitOptions *options) {
+    ModuleImportList imports = {0};
+    ErrorInfo error = {0};
+    error.code = ERROR_NONE;
+    
+    if (!module_scan(source, length, &imports, &error)) {
+        print_error(&error);
+        module_import_list_free(&imports);
+        return false;
+    }
+    
+    Writer writer;
+    if (!writer_open(&writer, options->output)) {
+        module_import_list_free(&imports);
+        return false;
+    }
+    for (size_t i = 0; i < imports.count; i++) {
+        const ModuleImport *item = &imports.items[i];
+        writer_cstr(&writer, "{\"kind\":\"");
+        writer_cstr(&writer, import_kind_name(item->kind));
+        writer_cstr(&writer, "\",\"start\":");
+        writer_uint(&writer, item->start);
+        writer_cstr(&writer, ",\"end\":");
+        writer_uint(&writer, item->end);
+        writer_cstr(&writer, ",\"specifier\":");
+        writer_json_string(&writer, source + item->start, item->end - item->start);
+        writer_cstr(&writer, "}\n");
+    }
+    
+    bool success = writer_close(&writer);
+    if (!success) {
+        fprintf(stderr, "Error: Cannot write output\n");
+    }
+    module_import_list_free(&imports);
+    return success;
+}
+
+/* 从入口模块开始构建依赖图，未能解析的相对说明符输出警告 */
+bool build_graph(const char *const *entries, size_t entry_count, int thread_count,
+                 ModuleGraph *graph) {
+    ErrorInfo error = {0};
+    error.code = ERROR_NONE;
+    
+    if (!module_graph_build(graph, entries, entry_count, thread_count, &error)) {
+        print_error(&error);
+        return false;
+    }
+    
+    for (size_t m = 0; m < graph->count; m++) {
+        const GraphModule *module = &graph->modules[m];
+        for (size_t i = 0; i < module->imports.count; i++) {
+            const ModuleImport *item = &module->imports.items[i];
+            const char *specifier = module->source + item->start;
+            int length = (int)(item->end - item->start);
+            if (module->targets[i] == MODULE_NONE &&
+                module_specifier_is_relative(specifier, (size_t)length)) {
+                fprintf(stderr, "Warning: Cannot resolve '%.*s' from '%s'\n",
+                        length, specifier, module->path);
+            }
+        }
+    }
+    return true;
+}
+
+/* 输出模块依赖图的JSON */
+bool emit_graph(const char *const *entries, size_t entry_count, int thread_count,
+                const EmitOptions *options) {
+    ModuleGraph graph;
+    if (!build_graph(entries, entry_count, thread_count, &graph)) {
+        return false;
+    }
+    
+    Writer writer;
+    bool success = writer_open(&writer, options->output);
+    if (success) {
+        success = module_graph_write(&graph, &writer);
+        if (!writer_close(&writer) || !success) {
+            fprintf(stderr, "Error: Cannot write output\n");
+            success = false;
+        }
+    }
+    module_graph_free(&graph);
+    return success;
+}
+
+/* 摇树：指定-o时把精简后的模块写入该目录，否则输出每个模块的摇树报告 */
+bool emit_tree_shake(const char *const *entries, size_t entry_count, int thread_count,
+                     const EmitOptions *options) {
+    ModuleGraph graph;
+    if (!build_graph(entries, entry_count, thread_count, &graph)) {
+        return false;
+    }
+    
+    ErrorInfo error = {0};
+    error.code = ERROR_NONE;
+    TreeShake shake;
+    bool success = tree_shake(&shake, &graph, thread_count, &error);
+    if (success && options->output) {
+        success = tree_shake_write_dir(&shake, options->output, thread_count, &error);
+    } else if (success) {
+        Writer writer;
+        success = writer_open(&writer, NULL);
+        if (success) {
+            success = tree_shake_write_report(&shake, &writer);
+            if (!writer_close(&writer) || !success) {
+                fprintf(stderr, "Error: Cannot write output\n");
+                success = false;
+            }
+        }
+    }
+    if (error.code != ERROR_NONE) {
+        print_error(&error);
+    }
+    
+    tree_shake_free(&shake);
+    module_graph_free(&graph);
+    return success;
+}
+
+/* 取路径中的文件名部分 */
+const char* base_name(const char *path) {
+    const char *name = path;
+    for (const char *p = path; *p; p++) {
+        if (*p == '/' || *p == '\\') {
+            name = p + 1;
+        }
+    }
+    return name;
+}
+
+/* 以'/'分隔的绝对路径（新分配）：相对路径接在当前目录之后，去掉 . 和多余的分隔符，
+   .. 与前一级抵消。失败时返回NULL */
+char* absolute_path(const char *path) {
+    char cwd[4096];
+    bool absolute = path[0] == '/' || path[0] == '\\' ||
+                    (isalpha((unsigned char)path[0]) && path[1] == ':');
+    if (!absolute && !getcwd(cwd, sizeof(cwd))) return NULL;
+
+    size_t size = (absolute ? 0 : strlen(cwd) + 1) + strlen(path) + 2;
+    char *joined = (char*)malloc(size);
+    char *out = (char*)malloc(size);
+    if (!joined || !out) {
+        free(joined);
+        free(out);
+        return NULL;
+    }
+    snprintf(joined, size, "%s%s%s", absolute ? "" : cwd, absolute ? "" : "/", path);
+
+    size_t n = 0;
+    for (const char *p = joined; *p;) {
+        while (*p == '/' || *p == '\\') p++;
+        const char *name = p;
+        while (*p && *p != '/' && *p != '\\') p++;
+        size_t length = (size_t)(p - name);
+        if (length == 0 || (length == 1 && name[0] == '.')) continue;
+        if (length == 2 && name[0] == '.' && name[1] == '.') {
+            while (n > 0 && out[n - 1] != '/') n--;
+            if (n > 0) n--;
+            continue;
+        }
+        out[n++] = '/';
+        memcpy(out + n, name, length);
+        n += length;
+    }
+    out[n] = '\0';
+    free(joined);
+    return out;
+}
+
+/* path相对于base所在目录的路径（新分配，'/'分隔）：source map中的路径按map文件的位置解析。
+   无法取得当前目录时原样复制path */
+char* relative_path(const char *base, const char *path) {
+    char *from = absolute_path(base);
+    char *to = absolute_path(path);
+    char *result = NULL;
+    if (from && to) {
+        /* from只保留目录部分，再找两者共同的前几级 */
+        *strrchr(from, '/') = '\0';
+        size_t common = 0;
+        for (size_t i = 0;; i++) {
+            bool from_end = from[i] == '\0' || from[i] == '/';
+            bool to_end = to[i] == '\0' || to[i] == '/';
+            if (from_end && to_end) {
+                common = i;
+                if (from[i] == '\0' || to[i] == '\0') break;
+            } else if (from[i] != to[i]) {
+                break;
+            }
+        }
+
+        size_t up = 0;
+        for (const char *p = from + common; *p; p++) up += *p == '/';
+        const char *rest = to[common] ? to + common + 1 : to + common;
+        result = (char*)malloc(up * 3 + strlen(rest) + 1);
+        if (result) {
+            for (size_t i = 0; i < up; i++) memcpy(result + i * 3, "../", 3);
+            strcpy(result + up * 3, rest);
+        }
+    }
+    free(from);
+    free(to);
+    if (!result && (result = (char*)malloc(strlen(path) + 1)) != NULL) {
+        strcpy(result, path);
+    }
+    return result;
+}
+
+/* 验证并输出压缩后的源码，需要时同时生成source map */
+bool emit_minified(const char *source, size_t length, const EmitOptions *options) {
+    SourceMap map;
+    SourceMap *mapping = NULL;
+    if (options->source_map) {
+        if (!source_map_init(&map, source, length)) {
+            fprintf(stderr, "Error: Out of memory\n");
+            return false;
+        }
+        mapping = &map;
+    }
+    
+    Writer writer;
+    if (!writer_open(&writer, options->output)) {
+        if (mapping) source_map_free(mapping);
+        return false;
+    }
+    
+    ErrorInfo error = {0};
+    error.code = ERROR_NONE;
+    bool success = minify_source(source, length, options->module, &writer, mapping, &error);
+    if (success && mapping) {
+        /* 输出到标准输出时不知道它会放在哪里，只写map的文件名 */
+        char *url = options->output ? relative_path(options->output, options->source_map) : NULL;
+        writer_cstr(&writer, "\n//# sourceMappingURL=");
+        writer_cstr(&writer, url ? url : base_name(options->source_map));
+        writer_byte(&writer, '\n');
+        free(url);
+    }
+    if (!writer_close(&writer)) {
+        fprintf(stderr, "Error: Cannot write output\n");
+        success = false;
+    } else if (!success) {
+        if (error.code != ERROR_NONE) {
+            print_error(&error);
+        } else {
+            fprintf(stderr, "Error: Out of memory\n");
+        }
+    }
+    
+    /* 写出source map */
+    if (success && mapping) {
+        Writer map_writer;
+        success = writer_open(&map_writer, options->source_map);
+        if (success) {
+            /* file和sources都相对于map文件所在的目录 */
+            char *file = options->output ? relative_path(options->source_map, options->output) : NULL;
+            char *sources = options->source_file ? relative_path(options->source_map, options->source_name)
+                                                 : NULL;
+            success = source_map_write(mapping, file, sources ? sources : options->source_name,
+                                       &map_writer);
+            free(file);
+            free(sources);
+            if (!writer_close(&map_writer) || !success) {
+                fprintf(stderr, "Error: Cannot write source map\n");
+                success = false;
+            }
+        }
+    }
+    
+    if (mapping) source_map_free(mapping);
+    return success;
+}
+
+/* 解析源码、构建扁平AST并做作用域检查（失败时错误输出到stderr）；
+   check为false时不检查，由调用者自己做作用域分析 */
+bool build_ast(const char *source, size_t length, bool module, bool check, Ast *ast) {
+    ErrorInfo error = {0};
+    error.code = ERROR_NONE;
+    
+    if (!structural_check(source, length, &error)) {
+        print_error(&error);
+        return false;
+    }
+    
+    if (!ast_init(ast, length)) {
+        fprintf(stderr, "Error: Out of memory\n");
+        return false;
+    }
+    
+    Lexer *lexer = lexer_create(source, length, &error);
+    Parser *parser = lexer ? parser_create(lexer, &error) : NULL;
+    if (!parser) {
+        fprintf(stderr, "Error: Cannot create parser\n");
+        lexer_destroy(lexer);
+        ast_free(ast);
+        return false;
+    }
+    parser->ast = ast;
+    parser->module = module;
+    
+    bool success = check ? scope_parse(parser) : parser_parse(parser) && error.code == ERROR_NONE;
+    parser_destroy(parser);
+    lexer_destroy(lexer);
+    
+    if (!success) {
+        print_error(&error);
+    } else if (ast->failed) {
+        fprintf(stderr, "Error: Out of memory\n");
+        success = false;
+    }
+    
+    if (!success) {
+        ast_free(ast);
+    }
+    return success;
+}
+
+/* 按指定格式输出语法树 */
+bool write_ast(const Ast *ast, const char *source, size_t length, const EmitOptions *options) {
+    if (options->format == EMIT_AST) {
+        return ast_binary_write(ast, source, length, options->output);
+    }
+    
+    Writer writer;
+    if (!writer_open(&writer, options->output)) {
+        return false;
+    }
+    bool success = estree_write(ast, source, length, &writer);
+    if (!writer_close(&writer) || !success) {
+        fprintf(stderr, "Error: Cannot write output\n");
+        success = false;
+    }
+    return success;
+}
+
+/* 作用域分析并输出作用域树 */
+bool emit_scopes(const Ast *ast, const char *source, size_t length, const EmitOptions *options) {
+    ErrorInfo error = {0};
+    error.code = ERROR_NONE;
+    ScopeTree tree;
+    if (!scope_analyze(&tree, ast, source, &error)) {
+        print_error(&error);
+        return false;
+    }
+    
+    Writer writer;
+    bool success = writer_open(&writer, options->output);
+    if (success) {
+        scope_tree_write(&tree, ast, length, &writer);
+        if (!writer_close(&writer)) {
+            fprintf(stderr, "Error: Cannot write output\n");
+            success = false;
+        }
+    }
+    scope_tree_free(&tree);
+    return success;
+}
+
+/* 输出常量折叠、删除死分支后的源码 */
+bool emit_folded(const Ast *ast, const char *source, size_t length, const EmitOptions *options) {
+    Writer writer;
+    if (!writer_open(&writer, options->output)) {
+        return false;
+    }
+    
+    FoldStats stats;
+    bool success = fold_write(ast, source, length, &writer, &stats);
+    if (!writer_close(&writer) || !success) {
+        fprintf(stderr, "Error: Cannot write output\n");
+        success = false;
+    }
+    return success;
+}
+
+/* 验证并输出格式化后的源码 */
+bool emit_formatted(const char *source, size_t length, const EmitOptions *options) {
+    Writer writer;
+    if (!writer_open(&writer, options->output)) {
+        return false;
+    }
+    
+    ErrorInfo error = {0};
+    error.code = ERROR_NONE;
+    bool success = format_source(source, length, options->module, &writer, &error);
+    if (!success && error.code != ERROR_NONE) {
+        print_error(&error);
+    }
+    if (!writer_close(&writer)) {
+        fprintf(stderr, "Error: Cannot write output\n");
+    }
+    return success;
+}
+
+/* 运行内置lint规则，每条诊断输出一行；有error级别的诊断时返回false */
+bool emit_lint(const char *source, size_t length, const EmitOptions *options) {
+    LintEngine engine;
+    lint_engine_init(&engine);
+    if (!lint_add_builtin_rules(&engine)) {
+        fprintf(stderr, "Error: Out of memory\n");
+        lint_engine_free(&engine);
+        return false;
+    }
+    
+    ErrorInfo error = {0};
+    error.code = ERROR_NONE;
+    bool success = lint_run(&engine, source, length, options->module, &error);
+    if (!success) {
+        print_error(&error);
+        lint_engine_free(&engine);
+        return false;
+    }
+    
+    Writer writer;
+    success = writer_open(&writer, options->output);
+    if (success) {
+        lint_write(&engine, options->source_name, &writer);
+        if (!writer_close(&writer)) {
+            fprintf(stderr, "Error: Cannot write output\n");
+            success = false;
+        }
+    }
+    success = success && engine.error_count == 0;
+    lint_engine_free(&engine);
+    return success;
+}
+
+/* 输出语义token；指定了行范围时先取得检查点表（有保存的表且源码未变时直接读入，
+   否则对整个文件做一次词法分析建立，并按需保存），再只高亮这几行 */
+bool emit_highlight(const char *source, size_t length, const EmitOptions *options) {
+    size_t first = 0, last = SIZE_MAX;
+    if (options->lines) {
+        char *end;
+        unsigned long a = strtoul(options->lines, &end, 10);
+        unsigned long b = *end == ':' ? strtoul(end + 1, &end, 10) : a;
+        if (*end != '\0' || a == 0 || b < a) {
+            fprintf(stderr, "Error: Invalid line range '%s' (expected first:last)\n", options->lines);
+            return false;
+        }
+        first = a - 1;
+        last = b - 1;
+    }
+    
+    HighlightTokens tokens = {0};
+    HighlightIndex index;
+    bool success;
+    if (options->lines) {
+        bool loaded = options->checkpoints &&
+                      highlight_index_load(&index, source, length, options->checkpoints);
+        success = loaded || highlight_source(source, length, &index, NULL);
+        if (success && !loaded && options->checkpoints &&
+            !highlight_index_save(&index, options->checkpoints)) {
+            fprintf(stderr, "Warning: Cannot write checkpoint table '%s'\n", options->checkpoints);
+        }
+        success = success && highlight_range(&index, first, last, &tokens);
+        highlight_index_free(&index);
+    } else {
+        success = highlight_source(source, length, NULL, &tokens);
+    }
+    if (!success) {
+        fprintf(stderr, "Error: Out of memory\n");
+        highlight_tokens_free(&tokens);
+        return false;
+    }
+    
+    Writer writer;
+    success = writer_open(&writer, options->output);
+    if (success) {
+        highlight_write(&tokens, &writer);
+        if (!writer_close(&writer)) {
+            fprintf(stderr, "Error: Cannot write output\n");
+            success = false;
+        }
+    }
+    highlight_tokens_free(&tokens);
+    return success;
+}
+
+/* 按指定格式输出语法树或token流（不打印状态信息） */
+bool emit_ast(const char *source, size_t length, const EmitOptions *options) {
+    if (options->format == EMIT_TOKENS || options->format == EMIT_TOKENS_JSONL) {
+        return emit_tokens(source, length, options);
+    }
+    if (options->format == EMIT_MINIFY) {
+        return emit_minified(source, length, options);
+    }
+    if (options->format == EMIT_FORMAT) {
+        return emit_formatted(source, length, options);
+    }
+    if (options->format == EMIT_IMPORTS) {
+        return emit_imports(source, length, options);
+    }
+    if (options->format == EMIT_LINT) {
+        return emit_lint(source, length, options);
+    }
+    if (options->format == EMIT_HIGHLIGHT) {
+        return emit_highlight(source, length, options);
+    }
+    
+    Ast ast;
+    if (!build_ast(source, length, options->module, options->format != EMIT_SCOPES, &ast)) {
+        return false;
+    }
+    
+    bool success;
+    if (options->format == EMIT_SCOPES) {
+        success = emit_scopes(&ast, source, length, options);
+    } else if (options->format == EMIT_FOLD) {
+        success = emit_folded(&ast, source, length, options);
+    } else {
+        success = write_ast(&ast, source, length, options);
+    }
+    ast_free(&ast);
+    return success;
+}
+
+/* 加载二进制AST文件：指定了输出格式时转换输出，否则打印摘要 */
+bool load_binary_ast(const char *path, const EmitOptions *options) {
+    AstBinary binary;
+    if (!ast_binary_load(&binary, path)) {
+        return false;
+    }
+    
+    bool success = ast_binary_verify(&binary);
+    if (!success) {
+        fprintf(stderr, "Error: '%s' contains a malformed tree\n", path);
+    } else if (options->format == EMIT_ESTREE || options->format == EMIT_AST) {
+        success = write_ast(&binary.ast, binary.source, binary.source_length, options);
+    } else if (options->format != EMIT_NONE) {
+        /* 其他输出只需要源码 */
+        success = emit_ast(binary.source, binary.source_length, options);
+    } else {
+        printf("Binary AST: %s\n", path);
+        printf("  Format version: %d\n", AST_BINARY_VERSION);
+        printf("  Nodes: %zu (%zu bytes)\n", binary.ast.count, binary.ast.count * sizeof(AstNode));
+        printf("  Source: %zu bytes\n", binary.source_length);
+        printf("  Root: %s\n", ast_kind_name((AstKind)binary.ast.nodes[binary.ast.root].kind));
+    }
+    
+    ast_binary_close(&binary);
+    return success;
+}
+
 /* 打印使用说明 */
+/* 打包：摇树后把存活的模块合并为一个文件，写入-o指定的文件或标准输出 */
+bool emit_bundle(const char *const *entries, size_t entry_count, int thread_count,
+                 const EmitOptions *options) {
+    ModuleGraph graph;
+    if (!build_graph(entries, entry_count, thread_count, &graph)) {
+        return false;
+    }
+    
+    ErrorInfo error = {0};
+    error.code = ERROR_NONE;
+    TreeShake shake;
+    bool success = tree_shake(&shake, &graph, thread_count, &error);
+    if (success) {
+        Writer writer;
+        success = writer_open(&writer, options->output);
+        if (!success) {
+            fprintf(stderr, "Error: Cannot open output file '%s'\n", options->output);
+        } else {
+            success = bundle_write(&shake, &writer, &error);
+            if (!writer_close(&writer) || (!success && error.code == ERROR_NONE)) {
+                fprintf(stderr, "Error: Cannot write output\n");
+                success = false;
+            }
+        }
+    }
+    if (error.code != ERROR_NONE) {
+        print_error(&error);
+    }
+    
+    tree_shake_free(&shake);
+    module_graph_free(&graph);
+    return success;
+}
+
+/* 建立或增量更新目录的标识符索引（dir/.jsindex） */
+bool emit_index(const char *dir, int thread_count) {
+    char *path = (char*)malloc(strlen(dir) + sizeof(IDENT_INDEX_FILE) + 1);
+    if (!path) {
+        fprintf(stderr, "Error: Out of memory\n");
+        return false;
+    }
+    sprintf(path, "%s/%s", dir, IDENT_INDEX_FILE);
+    
+    ErrorInfo error = {0};
+    error.code = ERROR_NONE;
+    IdentIndexStats stats;
+    bool success = ident_index_build(dir, path, thread_count, &stats, &error);
+    if (success) {
+        printf("Indexed %zu files (%zu reused, %zu lexed, %zu removed, %zu with errors): "
+               "%zu names, %zu occurrences, %zu bytes -> %s\n",
+               stats.files, stats.reused, stats.lexed, stats.removed, stats.failed,
+               stats.names, stats.postings, stats.bytes, path);
+    } else {
+        print_error(&error);
+    }
+    free(path);
+    return success;
+}
+
+/* 在目录的标识符索引中查找名字，每次出现输出一行JSON；找不到时返回false */
+bool emit_query(const char *name, const char *dir, const EmitOptions *options) {
+    char *path = (char*)malloc(strlen(dir) + sizeof(IDENT_INDEX_FILE) + 1);
+    char *prefix = (char*)malloc(strlen(dir) + 2);
+    if (!path || !prefix) {
+        fprintf(stderr, "Error: Out of memory\n");
+        free(path);
+        free(prefix);
+        return false;
+    }
+    sprintf(path, "%s/%s", dir, IDENT_INDEX_FILE);
+    sprintf(prefix, "%s/", dir);
+    
+    IdentIndex index;
+    bool success = ident_index_load(&index, path);
+    if (success) {
+        Writer writer;
+        success = writer_open(&writer, options->output);
+        if (success) {
+            success = ident_index_query(&index, name, prefix, &writer);
+            if (!writer_close(&writer)) {
+                fprintf(stderr, "Error: Cannot write output\n");
+                success = false;
+            }
+        }
+        ident_index_close(&index);
+    }
+    free(path);
+    free(prefix);
+    return success;
+}
+
 void print_usage(const char *program_name) {
     printf("JavaScript Syntax Parser (Hand-written in C)\n");
     printf("============================================\n\n");
@@ -149,10 +867,54 @@ void print_usage(const char *program_name) {
     printf("  %s <javascript-file>\n", program_name);
     printf("  %s -s \"<javascript-code>\"\n\n", program_name);
     printf("Options:\n");
-    printf("  -s    Parse JavaScript code from string\n");
-    printf("  -h    Show this help message\n\n");
+    printf("  -s      Parse JavaScript code from string\n");
+    printf("  -j <n>  Parse large files with n threads (0 = all cores)\n");
+    printf("  --emit=estree  Print the ESTree JSON AST instead of the status\n");
+    printf("  --emit=ast     Write the binary AST (mmap-able, see ast_binary.h)\n");
+    printf("  --emit=tokens  Write the binary token stream (see token_stream.h)\n");
+    printf("  --emit=tokens-jsonl  Print one JSON object per token\n");
+    printf("  --module       Parse as an ES module (default for .mjs files)\n");
+    printf("  --minify       Print the source without comments and extra whitespace\n");
+    printf("  --source-map <file>  Write a source map for the minified output\n");
+    printf("  --scopes       Print the scope tree (bindings per function/block scope)\n");
+    printf("  --format       Pretty-print the source (comments kept, width %d)\n", FORMAT_WIDTH);
+    printf("  --fold         Fold constant expressions, drop dead branches and unreachable code\n");
+    printf("  --lint         Run the built-in lint rules (no-with, no-debugger, no-dupe-keys)\n");
+    printf("  --highlight    Print LSP semantic tokens for editor syntax highlighting\n");
+    printf("  --lines <a:b>  Highlight only lines a..b (1-based, from the nearest checkpoint)\n");
+    printf("  --checkpoints <file>  With --lines, reuse (or create) a saved checkpoint table\n");
+    printf("  --lsp          Run as a language server on stdin/stdout (syntax diagnostics)\n");
+    printf("  --record <file>  With --lsp, save every received message for js_bench lsp\n");
+    printf("  --scan-imports Print import/export/require specifiers without parsing\n");
+    printf("  --graph <entry...>  Print the module dependency graph (-j threads, default all cores)\n");
+    printf("  --tree-shake <entry...>  Remove unused exports; write modules to -o <dir> or print a report\n");
+    printf("  --bundle <entry...>  Tree-shake and concatenate modules into one scope (-o <file>)\n");
+    printf("  --index <dir>  Build or update the identifier index <dir>/%s (-j threads)\n",
+           IDENT_INDEX_FILE);
+    printf("  --query <name> [dir]  Print every occurrence of an identifier using the index\n");
+    printf("  --load <file>  Load a binary AST instead of parsing source\n");
+    printf("  -o <file>      Write emitted output to file (default: stdout)\n");
+    printf("  -h      Show this help message\n\n");
     printf("Examples:\n");
     printf("  %s script.js\n", program_name);
+    printf("  %s -j 8 bundle.js\n", program_name);
+    printf("  %s --emit=estree -o ast.json script.js\n", program_name);
+    printf("  %s --emit=ast -o script.jsab script.js\n", program_name);
+    printf("  %s --load script.jsab --emit=estree\n", program_name);
+    printf("  %s --emit=tokens -o script.jstk script.js\n", program_name);
+    printf("  %s --scan-imports app.js\n", program_name);
+    printf("  %s --graph src/index.js\n", program_name);
+    printf("  %s --tree-shake -o dist src/index.js\n", program_name);
+    printf("  %s --bundle -o dist/app.js src/index.js\n", program_name);
+    printf("  %s --minify -o script.min.js --source-map script.min.js.map script.js\n",
+           program_name);
+    printf("  %s --format -o pretty.js script.js\n", program_name);
+    printf("  %s --fold -o folded.js script.js\n", program_name);
+    printf("  %s --lint script.js\n", program_name);
+    printf("  %s --highlight --lines 100:160 bundle.js\n", program_name);
+    printf("  %s --highlight --lines 100:160 --checkpoints bundle.jshl bundle.js\n", program_name);
+    printf("  %s --lsp --record session.lsp\n", program_name);
+    printf("  %s --index src && %s --query fetchUser src\n", program_name, program_name);
     printf("  %s -s \"let x = 10; console.log(x);\"\n", program_name);
     printf("\nFeatures:\n");
     printf("  - Full Unicode support\n");
@@ -169,23 +931,241 @@ int main(int argc, char *argv[]) {
     }
     
     /* 处理命令行参数 */
-    if (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
-        print_usage(argv[0]);
-        return 0;
-    } else if (strcmp(argv[1], "-s") == 0) {
-        /* 解析字符串 */
-        if (argc < 3) {
-            fprintf(stderr, "Error: Missing JavaScript code string\n");
+    int thread_count = 1;
+    bool threads_given = false;
+    bool graph = false;
+    bool shake = false;
+    bool bundle = false;
+    bool build_index = false;
+    bool lsp = false;
+    const char *record = NULL;
+    const char *query = NULL;
+    const char *filename = NULL;
+    const char *code = NULL;
+    const char *load = NULL;
+    EmitOptions options = {EMIT_NONE, NULL, NULL, NULL, false, false, NULL, NULL};
+    
+    /* 非选项参数（--graph和--tree-shake可以有多个入口，其他模式使用最后一个） */
+    const char **inputs = (const char**)malloc(sizeof(const char*) * argc);
+    size_t input_count = 0;
+    if (!inputs) {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 1;
+    }
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (strcmp(argv[i], "-s") == 0) {
+            /* 解析字符串 */
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: Missing JavaScript code string\n");
+                return 1;
+            }
+            
+            code = argv[++i];
+        } else if (strcmp(argv[i], "--emit=estree") == 0) {
+            options.format = EMIT_ESTREE;
+        } else if (strcmp(argv[i], "--emit=ast") == 0) {
+            options.format = EMIT_AST;
+        } else if (strcmp(argv[i], "--emit=tokens") == 0) {
+            options.format = EMIT_TOKENS;
+        } else if (strcmp(argv[i], "--emit=tokens-jsonl") == 0) {
+            options.format = EMIT_TOKENS_JSONL;
+        } else if (strcmp(argv[i], "--minify") == 0) {
+            options.format = EMIT_MINIFY;
+        } else if (strcmp(argv[i], "--format") == 0) {
+            options.format = EMIT_FORMAT;
+        } else if (strcmp(argv[i], "--scopes") == 0) {
+            options.format = EMIT_SCOPES;
+        } else if (strcmp(argv[i], "--fold") == 0) {
+            options.format = EMIT_FOLD;
+        } else if (strcmp(argv[i], "--lint") == 0) {
+            options.format = EMIT_LINT;
+        } else if (strcmp(argv[i], "--highlight") == 0) {
+            options.format = EMIT_HIGHLIGHT;
+        } else if (strcmp(argv[i], "--lines") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: Missing line range\n");
+                return 1;
+            }
+            options.lines = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoints") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: Missing checkpoint file\n");
+                return 1;
+            }
+            options.checkpoints = argv[++i];
+        } else if (strcmp(argv[i], "--lsp") == 0) {
+            lsp = true;
+        } else if (strcmp(argv[i], "--record") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: Missing record file\n");
+                return 1;
+            }
+            record = argv[++i];
+        } else if (strcmp(argv[i], "--scan-imports") == 0) {
+            options.format = EMIT_IMPORTS;
+        } else if (strcmp(argv[i], "--graph") == 0) {
+            graph = true;
+        } else if (strcmp(argv[i], "--tree-shake") == 0) {
+            shake = true;
+        } else if (strcmp(argv[i], "--bundle") == 0) {
+            bundle = true;
+        } else if (strcmp(argv[i], "--index") == 0) {
+            build_index = true;
+        } else if (strcmp(argv[i], "--query") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: Missing identifier to query\n");
+                return 1;
+            }
+            query = argv[++i];
+        } else if (strcmp(argv[i], "--module") == 0) {
+            options.module = true;
+        } else if (strncmp(argv[i], "--emit=", 7) == 0) {
+            fprintf(stderr, "Error: Unknown output format '%s'\n", argv[i] + 7);
             return 1;
+        } else if (strcmp(argv[i], "-o") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: Missing output file\n");
+                return 1;
+            }
+            options.output = argv[++i];
+        } else if (strcmp(argv[i], "--source-map") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: Missing source map file\n");
+                return 1;
+            }
+            options.source_map = argv[++i];
+        } else if (strcmp(argv[i], "--load") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: Missing binary AST file\n");
+                return 1;
+            }
+            load = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Error: Missing thread count\n");
+                return 1;
+            }
+            thread_count = atoi(argv[++i]);
+            threads_given = true;
+        } else {
+            filename = argv[i];
+            inputs[input_count++] = argv[i];
         }
-        
-        bool success = parse_javascript_string(argv[2]);
+    }
+    
+    /* 语言服务器 */
+    if (record && !lsp) {
+        fprintf(stderr, "Error: --record requires --lsp\n");
+        free(inputs);
+        return 1;
+    }
+    if (lsp) {
+        free(inputs);
+        FILE *file = NULL;
+        if (record && !(file = fopen(record, "wb"))) {
+            fprintf(stderr, "Error: Cannot open record file '%s'\n", record);
+            return 1;
+        }
+#ifdef _WIN32
+        /* Content-Length按字节计数，标准输入输出不能做\r\n转换 */
+        _setmode(_fileno(stdin), _O_BINARY);
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        int code = lsp_run(stdin, stdout, file);
+        if (file) {
+            fclose(file);
+        }
+        return code;
+    }
+    
+    /* 模块依赖图、摇树和打包 */
+    if (graph || shake || bundle) {
+        bool success = input_count > 0;
+        if (success && bundle) {
+            success = emit_bundle(inputs, input_count, threads_given ? thread_count : 0, &options);
+        } else if (success && shake) {
+            success = emit_tree_shake(inputs, input_count, threads_given ? thread_count : 0, &options);
+        } else if (success) {
+            success = emit_graph(inputs, input_count, threads_given ? thread_count : 0, &options);
+        } else {
+            fprintf(stderr, "Error: Missing entry module\n");
+        }
+        free(inputs);
         return success ? 0 : 1;
-    } else {
-        /* 解析文件 */
-        bool success = parse_javascript_file(argv[1]);
+    }
+    free(inputs);
+    
+    /* 标识符索引 */
+    if (build_index) {
+        if (!filename) {
+            fprintf(stderr, "Error: Missing directory to index\n");
+            return 1;
+        }
+        return emit_index(filename, threads_given ? thread_count : 0) ? 0 : 1;
+    }
+    if (query) {
+        return emit_query(query, filename ? filename : ".", &options) ? 0 : 1;
+    }
+    
+    if (options.source_map && options.format != EMIT_MINIFY) {
+        fprintf(stderr, "Error: --source-map requires --minify\n");
+        return 1;
+    }
+    if (options.lines && options.format != EMIT_HIGHLIGHT) {
+        fprintf(stderr, "Error: --lines requires --highlight\n");
+        return 1;
+    }
+    if (options.checkpoints && !options.lines) {
+        fprintf(stderr, "Error: --checkpoints requires --lines\n");
+        return 1;
+    }
+    
+    /* 加载二进制AST */
+    if (load) {
+        options.source_name = load;
+        options.source_file = true;
+        return load_binary_ast(load, &options) ? 0 : 1;
+    }
+    
+    if (code && options.format == EMIT_NONE) {
+        return parse_javascript_string(code, options.module) ? 0 : 1;
+    }
+    
+    if (!code && !filename) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    
+    /* .mjs文件总是按模块解析 */
+    if (!code) {
+        size_t name_length = strlen(filename);
+        if (name_length > 4 && strcmp(filename + name_length - 4, ".mjs") == 0) {
+            options.module = true;
+        }
+    }
+    
+    /* 输出语法树 */
+    if (options.format != EMIT_NONE) {
+        options.source_name = code ? "<string>" : filename;
+        options.source_file = !code;
+        if (code) {
+            return emit_ast(code, strlen(code), &options) ? 0 : 1;
+        }
+        size_t length;
+        char *source = read_file(filename, &length);
+        if (!source) {
+            return 1;
+        }
+        bool success = emit_ast(source, length, &options);
+        free(source);
         return success ? 0 : 1;
     }
     
-    return 0;
+    /* 解析文件 */
+    bool success = parse_javascript_file(filename, thread_count, options.module);
+    return success ? 0 : 1;
 }
@@ -0,0 +1,111 @@
+#include "minify.h"
+#include "parser.h"
+#include "scope.h"
+#include "structural.h"
+
+/* 压缩状态：记录上一个输出的token，用来决定分隔符 */
+typedef struct {
+    Writer *writer;
+    SourceMap *map;         /* 可以为NULL */
+    const char *source;
+    bool started;
+    TokenType prev_type;
+    unsigned char prev_last;    /* 上一个token的最后一个字节 */
+} Minifier;
+
+/* 可以出现在标识符、关键字或数字中的字节（非ASCII字节和\\u转义都按标识符字符处理） */
+static bool is_word_byte(unsigned char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+           (ch >= '0' && ch <= '9') || ch == '_' || ch == '$' || ch == '\\' || ch >= 0x80;
+}
+
+/* 两个token直接相连时是否会被分析成别的token（last/first为前一个token的最后一个字节和后一个token的第一个字节） */
+bool tokens_need_space(TokenType prev_type, unsigned char last, TokenType next_type, unsigned char first) {
+    if (is_word_byte(last) && is_word_byte(first)) {
+        return true;                            /* a b、return x、1 in */
+    }
+    if ((prev_type == TOKEN_PLUS || prev_type == TOKEN_MINUS) && first == last) {
+        return true;                            /* a - -b、a + ++b（a++ +b可以写成a+++b） */
+    }
+    if (last == '/' && (first == '/' || first == '*')) {
+        return true;                            /* a / /re/、/re/ * 2 会变成注释 */
+    }
+    if (prev_type == TOKEN_NUMBER && first == '.') {
+        return true;                            /* 1 .toString() */
+    }
+    if (last == '<' && first == '!') {
+        return true;                            /* a < !b 会变成HTML注释 <!-- */
+    }
+    if (last == '?' && first == '.' && next_type == TOKEN_NUMBER) {
+        return true;                            /* a ? .5 : 1 会变成可选链 */
+    }
+    return false;
+}
+
+/* 输出一个token及其前面需要的分隔符 */
+static void minify_token(void *context, const Token *token, bool asi) {
+    Minifier *m = (Minifier*)context;
+    const char *text = m->source + token->start.offset;
+    size_t length = (size_t)(token->end.offset - token->start.offset);
+
+    if (length == 0) return;
+
+    char separator = 0;
+    if (m->started) {
+        /* 插入分号的位置保留换行；}之前总会插入分号，换行可以去掉 */
+        if (asi && token->preceded_by_newline && token->type != TOKEN_RBRACE) {
+            separator = '\n';
+        } else if (tokens_need_space(m->prev_type, m->prev_last, token->type, (unsigned char)text[0])) {
+            separator = ' ';
+        }
+    }
+    if (separator) {
+        writer_byte(m->writer, separator);
+    }
+
+    writer_write(m->writer, text, length);
+    if (m->map) {
+        if (separator) {
+            source_map_advance(m->map, &separator, 1);
+        }
+        source_map_add(m->map, (size_t)token->start.offset);
+        source_map_advance(m->map, text, length);
+    }
+    m->started = true;
+    m->prev_type = token->type;
+    m->prev_last = (unsigned char)text[length - 1];
+}
+
+/* 验证并压缩源码；出错时返回false，已输出的部分不完整 */
+bool minify_source(const char *source, size_t length, bool module, Writer *writer,
+                   SourceMap *map, ErrorInfo *error) {
+    if (!structural_check(source, length, error)) {
+        return false;
+    }
+
+    /* 作用域检查需要AST */
+    Ast ast;
+    if (!ast_init(&ast, length)) return false;
+
+    Lexer *lexer = lexer_create(source, length, error);
+    Parser *parser = lexer ? parser_create(lexer, error) : NULL;
+    if (!parser) {
+        lexer_destroy(lexer);
+        ast_free(&ast);
+        return false;
+    }
+
+    Minifier minifier = {writer, map, source, false, TOKEN_EOF, 0};
+    parser->ast = &ast;
+    parser->module = module;
+    parser->on_token = minify_token;
+    parser->token_context = &minifier;
+
+    bool success = scope_parse(parser) && !ast.failed;
+
+    parser_destroy(parser);
+    lexer_destroy(lexer);
+    ast_free(&ast);
+
+    return success && !writer->failed && !(map && map->failed);
+}
@@ -0,0 +1,16 @@
+#ifndef MINIFY_H
+#define MINIFY_H
+
+#include "lexer.h"
+#include "writer.h"
+#include "sourcemap.h"
+#include "common.h"
+
+/* 压缩：在语法分析的同时逐个输出token，去掉注释和空白，
+   只保留ASI需要的换行，token之间只在会连成别的token时才加一个空格。
+   module为true时按ES模块解析，map非NULL时为每个token记录一个映射 */
+bool minify_source(const char *source, size_t length, bool module, Writer *writer,
+                   SourceMap *map, ErrorInfo *error);
+bool tokens_need_space(TokenType prev_type, unsigned char last, TokenType next_type, unsigned char first);
+
+#endif /* MINIFY_H */
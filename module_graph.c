@@ -0,0 +1,647 @@
+#define _XOPEN_SOURCE 700
+#include "module_graph.h"
+#include "threadpool.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdarg.h>
+#include <sys/stat.h>
+
+/*
+ * 模块依赖图
+ *
+ * 发现阶段在线程池上进行：每个任务读取一个模块、扫描说明符（module_scan），
+ * 按Node的规则解析相对说明符，对新发现的模块再提交任务。模块以规范化的绝对路径
+ * 为键放入分片加锁的哈希表去重，同一模块只会被插入和扫描一次。
+ * 发现结束后从入口开始广度优先编号（与线程调度无关，输出稳定），再构建CSR邻接表、
+ * 用Tarjan算法求强连通分量（环）和依赖在前的拓扑序。
+ */
+
+#define MAP_SHARDS 64               /* 哈希表分片数，每个分片一把锁 */
+
+/* 发现阶段的模块 */
+typedef struct Discovered {
+    struct Discovery *discovery;    /* 任务参数只有节点本身，通过它找到共享状态 */
+    char *path;
+    uint64_t hash;
+    char *source;
+    size_t length;
+    ModuleImportList imports;
+    struct Discovered **deps;       /* 每个说明符解析到的模块，NULL为未解析 */
+    uint32_t index;                 /* 广度优先编号，MODULE_NONE为尚未编号 */
+} Discovered;
+
+/* 哈希表的一个分片（开放寻址） */
+typedef struct {
+    pthread_mutex_t lock;
+    Discovered **slots;
+    size_t count;
+    size_t capacity;
+} MapShard;
+
+/* 发现阶段的共享状态 */
+typedef struct Discovery {
+    ThreadPool *pool;
+    MapShard shards[MAP_SHARDS];
+    atomic_bool failed;
+    pthread_mutex_t error_lock;     /* 保护error，只记录第一个错误 */
+    ErrorInfo *error;
+} Discovery;
+
+/* 记录错误（可在任意线程调用） */
+static void discovery_fail(Discovery *d, ErrorCode code, Position pos, const char *format, ...) {
+    char message[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    pthread_mutex_lock(&d->error_lock);
+    set_error(d->error, code, pos, message);
+    pthread_mutex_unlock(&d->error_lock);
+    atomic_store(&d->failed, true);
+}
+
+/* 在分片中查找或插入：返回已有或新建的模块，*inserted表示是否新建。path归表所有 */
+static Discovered* map_insert(Discovery *d, char *path, bool *inserted) {
+    uint64_t hash = fnv1a_hash(path, strlen(path));
+    MapShard *shard = &d->shards[hash % MAP_SHARDS];
+    Discovered *found = NULL;
+    *inserted = false;
+
+    pthread_mutex_lock(&shard->lock);
+
+    /* 负载超过一半时扩容 */
+    if ((shard->count + 1) * 2 > shard->capacity) {
+        size_t capacity = shard->capacity ? shard->capacity * 2 : 64;
+        Discovered **slots = (Discovered**)calloc(capacity, sizeof(Discovered*));
+        if (!slots) goto done;
+        for (size_t i = 0; i < shard->capacity; i++) {
+            Discovered *node = shard->slots[i];
+            if (!node) continue;
+            size_t j = (node->hash / MAP_SHARDS) & (capacity - 1);
+            while (slots[j]) j = (j + 1) & (capacity - 1);
+            slots[j] = node;
+        }
+        free(shard->slots);
+        shard->slots = slots;
+        shard->capacity = capacity;
+    }
+
+    size_t i = (hash / MAP_SHARDS) & (shard->capacity - 1);
+    while (shard->slots[i]) {
+        Discovered *node = shard->slots[i];
+        if (node->hash == hash && strcmp(node->path, path) == 0) {
+            found = node;
+            goto done;
+        }
+        i = (i + 1) & (shard->capacity - 1);
+    }
+
+    found = (Discovered*)calloc(1, sizeof(Discovered));
+    if (!found) goto done;
+    found->discovery = d;
+    found->path = path;
+    found->hash = hash;
+    found->index = MODULE_NONE;
+    shard->slots[i] = found;
+    shard->count++;
+    *inserted = true;
+
+done:
+    pthread_mutex_unlock(&shard->lock);
+    if (!*inserted) free(path);
+    return found;
+}
+
+static bool is_file(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+static bool is_directory(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+/* 拼接 base + suffix（新分配） */
+static char* path_concat(const char *base, size_t base_length, const char *suffix, size_t suffix_length) {
+    char *path = (char*)malloc(base_length + suffix_length + 1);
+    if (!path) return NULL;
+    memcpy(path, base, base_length);
+    memcpy(path + base_length, suffix, suffix_length);
+    path[base_length + suffix_length] = '\0';
+    return path;
+}
+
+/* 按文件解析：X、X.js、X.mjs、X.cjs、X.json */
+static char* resolve_file(const char *base) {
+    static const char *const extensions[] = {"", ".js", ".mjs", ".cjs", ".json"};
+    size_t length = strlen(base);
+
+    for (size_t i = 0; i < sizeof(extensions) / sizeof(extensions[0]); i++) {
+        char *candidate = path_concat(base, length, extensions[i], strlen(extensions[i]));
+        if (!candidate) return NULL;
+        char *resolved = is_file(candidate) ? realpath(candidate, NULL) : NULL;
+        free(candidate);
+        if (resolved) return resolved;
+    }
+    return NULL;
+}
+
+/* 目录下的index文件 */
+static char* resolve_index(const char *dir) {
+    static const char *const names[] = {"/index.js", "/index.mjs", "/index.cjs", "/index.json"};
+    size_t length = strlen(dir);
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        char *candidate = path_concat(dir, length, names[i], strlen(names[i]));
+        if (!candidate) return NULL;
+        char *resolved = is_file(candidate) ? realpath(candidate, NULL) : NULL;
+        free(candidate);
+        if (resolved) return resolved;
+    }
+    return NULL;
+}
+
+/* package.json中的"main"字段（只识别不含转义的字符串值），没有时返回NULL */
+static char* package_main(const char *dir) {
+    char *json_path = path_concat(dir, strlen(dir), "/package.json", 13);
+    if (!json_path) return NULL;
+    size_t length = 0;
+    char *json = is_file(json_path) ? file_load(json_path, &length) : NULL;
+    free(json_path);
+    if (!json) return NULL;
+
+    char *entry = NULL;
+    size_t dir_length = strlen(dir);
+    for (const char *p = strstr(json, "\"main\""); p && !entry; p = strstr(p + 6, "\"main\"")) {
+        const char *q = p + 6;
+        while (*q == ' ' || *q == '\t' || *q == '\n' || *q == '\r') q++;
+        if (*q++ != ':') continue;
+        while (*q == ' ' || *q == '\t' || *q == '\n' || *q == '\r') q++;
+        if (*q++ != '"') continue;
+        const char *end = q;
+        while (*end && *end != '"' && *end != '\\') end++;
+        if (*end == '"' && end > q) {
+            entry = (char*)malloc(dir_length + (size_t)(end - q) + 2);
+            if (entry) {
+                memcpy(entry, dir, dir_length);
+                entry[dir_length] = '/';
+                memcpy(entry + dir_length + 1, q, (size_t)(end - q));
+                entry[dir_length + 1 + (size_t)(end - q)] = '\0';
+            }
+        }
+    }
+    free(json);
+    return entry;
+}
+
+/* 按目录解析：package.json的main，然后是index文件 */
+static char* resolve_directory(const char *dir) {
+    if (!is_directory(dir)) return NULL;
+
+    char *entry = package_main(dir);
+    if (entry) {
+        char *resolved = resolve_file(entry);
+        if (!resolved) resolved = resolve_index(entry);
+        free(entry);
+        if (resolved) return resolved;
+    }
+    return resolve_index(dir);
+}
+
+/* Node风格的解析：先按文件，再按目录；以 / 结尾的说明符只按目录 */
+static char* resolve_path(const char *path) {
+    size_t length = strlen(path);
+    char *resolved = NULL;
+    if (length > 0 && path[length - 1] != '/') {
+        resolved = resolve_file(path);
+    }
+    return resolved ? resolved : resolve_directory(path);
+}
+
+/* 说明符是否为相对路径或绝对路径（只有这些在本地文件系统上解析，裸说明符留给包管理器） */
+bool module_specifier_is_relative(const char *specifier, size_t length) {
+    if (length >= 1 && specifier[0] == '/') return true;
+    if (length == 1 && specifier[0] == '.') return true;
+    if (length >= 2 && specifier[0] == '.' && specifier[1] == '/') return true;
+    if (length == 2 && specifier[0] == '.' && specifier[1] == '.') return true;
+    return length >= 3 && memcmp(specifier, "../", 3) == 0;
+}
+
+/* 相对于导入者所在目录解析说明符，找不到时返回NULL */
+static char* resolve_specifier(const char *importer, const char *specifier, size_t length) {
+    char *path;
+    if (specifier[0] == '/') {
+        path = path_concat(specifier, length, "", 0);
+    } else {
+        size_t dir_length = (size_t)(strrchr(importer, '/') - importer) + 1;
+        path = path_concat(importer, dir_length, specifier, length);
+    }
+    if (!path) return NULL;
+
+    char *resolved = resolve_path(path);
+    free(path);
+    return resolved;
+}
+
+static void discover_module(void *arg);
+
+/* 登记一个已解析的路径，新模块提交扫描任务 */
+static Discovered* discovery_add(Discovery *d, char *path) {
+    bool inserted;
+    Discovered *node = map_insert(d, path, &inserted);
+    if (!node || (inserted && !threadpool_submit(d->pool, discover_module, node))) {
+        discovery_fail(d, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+        return NULL;
+    }
+    return node;
+}
+
+/* 发现任务：读取并扫描一个模块，解析它的相对说明符 */
+static void discover_module(void *arg) {
+    Discovered *node = (Discovered*)arg;
+    Discovery *d = node->discovery;
+    if (atomic_load(&d->failed)) return;
+
+    node->source = file_load(node->path, &node->length);
+    if (!node->source) {
+        discovery_fail(d, ERROR_FILE_READ, (Position){0, 0, 0}, "Cannot read module '%s'", node->path);
+        return;
+    }
+
+    ErrorInfo error = {0};
+    error.code = ERROR_NONE;
+    if (!module_scan(node->source, node->length, &node->imports, &error)) {
+        discovery_fail(d, error.code, error.position, "%s: %s", node->path, error.message);
+        return;
+    }
+    if (node->imports.count == 0) return;
+
+    node->deps = (Discovered**)calloc(node->imports.count, sizeof(Discovered*));
+    if (!node->deps) {
+        discovery_fail(d, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+        return;
+    }
+    for (size_t i = 0; i < node->imports.count; i++) {
+        const ModuleImport *item = &node->imports.items[i];
+        const char *specifier = node->source + item->start;
+        size_t length = item->end - item->start;
+        if (!module_specifier_is_relative(specifier, length)) continue;
+
+        char *resolved = resolve_specifier(node->path, specifier, length);
+        if (resolved) {
+            node->deps[i] = discovery_add(d, resolved);
+        }
+    }
+}
+
+/* 释放发现阶段剩余的节点（成功时各字段已移交给图） */
+static void discovery_free(Discovery *d) {
+    for (size_t s = 0; s < MAP_SHARDS; s++) {
+        MapShard *shard = &d->shards[s];
+        for (size_t i = 0; i < shard->capacity; i++) {
+            Discovered *node = shard->slots[i];
+            if (!node) continue;
+            free(node->path);
+            free(node->source);
+            module_import_list_free(&node->imports);
+            free(node->deps);
+            free(node);
+        }
+        free(shard->slots);
+        pthread_mutex_destroy(&shard->lock);
+    }
+    pthread_mutex_destroy(&d->error_lock);
+}
+
+/* 从入口开始广度优先编号，把模块移交给图 */
+static bool number_modules(ModuleGraph *graph, Discovery *d, Discovered **entry_nodes, size_t entry_count) {
+    size_t total = 0;
+    for (size_t s = 0; s < MAP_SHARDS; s++) total += d->shards[s].count;
+
+    Discovered **queue = (Discovered**)malloc(total * sizeof(Discovered*));
+    graph->modules = (GraphModule*)calloc(total, sizeof(GraphModule));
+    if (!queue || !graph->modules) {
+        free(queue);
+        return false;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < entry_count; i++) {
+        if (entry_nodes[i]->index == MODULE_NONE) {
+            entry_nodes[i]->index = (uint32_t)count;
+            queue[count++] = entry_nodes[i];
+        }
+    }
+    graph->entry_count = count;
+    for (size_t head = 0; head < count; head++) {
+        Discovered *node = queue[head];
+        for (size_t i = 0; i < node->imports.count; i++) {
+            Discovered *dep = node->deps ? node->deps[i] : NULL;
+            if (dep && dep->index == MODULE_NONE) {
+                dep->index = (uint32_t)count;
+                queue[count++] = dep;
+            }
+        }
+    }
+
+    bool ok = true;
+    for (size_t m = 0; m < count; m++) {
+        Discovered *node = queue[m];
+        GraphModule *module = &graph->modules[m];
+        if (node->imports.count > 0) {
+            module->targets = (uint32_t*)malloc(node->imports.count * sizeof(uint32_t));
+            if (!module->targets) {
+                ok = false;
+                break;
+            }
+            for (size_t i = 0; i < node->imports.count; i++) {
+                Discovered *dep = node->deps[i];
+                module->targets[i] = dep ? dep->index : MODULE_NONE;
+            }
+        }
+        module->path = node->path;
+        module->source = node->source;
+        module->length = node->length;
+        module->imports = node->imports;
+        node->path = NULL;
+        node->source = NULL;
+        memset(&node->imports, 0, sizeof(node->imports));
+    }
+    graph->count = count;
+    free(queue);
+    return ok;
+}
+
+/* 构建CSR邻接表：同一模块的重复依赖只保留第一条 */
+static bool build_edges(ModuleGraph *graph) {
+    size_t total = 0;
+    for (size_t m = 0; m < graph->count; m++) {
+        const GraphModule *module = &graph->modules[m];
+        for (size_t i = 0; i < module->imports.count; i++) {
+            if (module->targets[i] != MODULE_NONE) {
+                total++;
+            } else if (module_specifier_is_relative(module->source + module->imports.items[i].start,
+                                                    module->imports.items[i].end -
+                                                    module->imports.items[i].start)) {
+                graph->unresolved++;
+            }
+        }
+    }
+
+    graph->edge_start = (size_t*)malloc((graph->count + 1) * sizeof(size_t));
+    graph->edges = (uint32_t*)malloc((total ? total : 1) * sizeof(uint32_t));
+    uint32_t *seen = (uint32_t*)malloc((graph->count ? graph->count : 1) * sizeof(uint32_t));
+    if (!graph->edge_start || !graph->edges || !seen) {
+        free(seen);
+        return false;
+    }
+
+    for (size_t m = 0; m < graph->count; m++) seen[m] = MODULE_NONE;
+    size_t count = 0;
+    for (size_t m = 0; m < graph->count; m++) {
+        const GraphModule *module = &graph->modules[m];
+        graph->edge_start[m] = count;
+        for (size_t i = 0; i < module->imports.count; i++) {
+            uint32_t target = module->targets[i];
+            if (target != MODULE_NONE && seen[target] != (uint32_t)m) {
+                seen[target] = (uint32_t)m;
+                graph->edges[count++] = target;
+            }
+        }
+    }
+    graph->edge_start[graph->count] = count;
+    graph->edge_count = count;
+    free(seen);
+    return true;
+}
+
+/* 模块是否导入自身 */
+static bool has_self_edge(const ModuleGraph *graph, uint32_t m) {
+    for (size_t e = graph->edge_start[m]; e < graph->edge_start[m + 1]; e++) {
+        if (graph->edges[e] == m) return true;
+    }
+    return false;
+}
+
+/*
+ * Tarjan强连通分量（迭代实现，避免深依赖链导致栈溢出）
+ * 从入口开始按说明符顺序深度优先，后序即依赖在前的执行顺序；
+ * 含多个模块或自引用的强连通分量记录为环。
+ */
+static bool analyze_cycles(ModuleGraph *graph) {
+    size_t n = graph->count;
+    size_t alloc = n ? n : 1;
+    uint32_t *index = (uint32_t*)malloc(alloc * sizeof(uint32_t));
+    uint32_t *low = (uint32_t*)malloc(alloc * sizeof(uint32_t));
+    uint32_t *stack = (uint32_t*)malloc(alloc * sizeof(uint32_t));
+    bool *on_stack = (bool*)calloc(alloc, sizeof(bool));
+    uint32_t *frame_node = (uint32_t*)malloc(alloc * sizeof(uint32_t));
+    size_t *frame_edge = (size_t*)malloc(alloc * sizeof(size_t));
+    graph->order = (uint32_t*)malloc(alloc * sizeof(uint32_t));
+    graph->cycle_start = (size_t*)malloc((n + 1) * sizeof(size_t));
+    graph->cycles = (uint32_t*)malloc(alloc * sizeof(uint32_t));
+
+    bool ok = index && low && stack && on_stack && frame_node && frame_edge &&
+              graph->order && graph->cycle_start && graph->cycles;
+    if (ok) {
+        for (size_t m = 0; m < n; m++) index[m] = MODULE_NONE;
+
+        uint32_t counter = 0;
+        size_t sp = 0, fp = 0, ordered = 0, cycled = 0;
+        graph->cycle_start[0] = 0;
+
+        for (uint32_t root = 0; root < n; root++) {
+            if (index[root] != MODULE_NONE) continue;
+
+            index[root] = low[root] = counter++;
+            stack[sp++] = root;
+            on_stack[root] = true;
+            frame_node[fp] = root;
+            frame_edge[fp++] = graph->edge_start[root];
+
+            while (fp > 0) {
+                uint32_t v = frame_node[fp - 1];
+                size_t e = frame_edge[fp - 1];
+                if (e < graph->edge_start[v + 1]) {
+                    frame_edge[fp - 1]++;
+                    uint32_t w = graph->edges[e];
+                    if (index[w] == MODULE_NONE) {
+                        index[w] = low[w] = counter++;
+                        stack[sp++] = w;
+                        on_stack[w] = true;
+                        frame_node[fp] = w;
+                        frame_edge[fp++] = graph->edge_start[w];
+                    } else if (on_stack[w] && index[w] < low[v]) {
+                        low[v] = index[w];
+                    }
+                    continue;
+                }
+
+                /* v的依赖都已完成 */
+                graph->order[ordered++] = v;
+                if (low[v] == index[v]) {
+                    size_t base = sp;
+                    do {
+                        on_stack[stack[--base]] = false;
+                    } while (stack[base] != v);
+                    if (sp - base > 1 || has_self_edge(graph, v)) {
+                        memcpy(graph->cycles + cycled, stack + base, (sp - base) * sizeof(uint32_t));
+                        cycled += sp - base;
+                        graph->cycle_start[++graph->cycle_count] = cycled;
+                    }
+                    sp = base;
+                }
+                if (--fp > 0) {
+                    uint32_t u = frame_node[fp - 1];
+                    if (low[v] < low[u]) low[u] = low[v];
+                }
+            }
+        }
+    }
+
+    free(index);
+    free(low);
+    free(stack);
+    free(on_stack);
+    free(frame_node);
+    free(frame_edge);
+    return ok;
+}
+
+/* 从入口模块开始并发发现全部依赖，构建依赖图（thread_count <= 0 时使用CPU核数） */
+bool module_graph_build(ModuleGraph *graph, const char *const *entries, size_t entry_count,
+                        int thread_count, ErrorInfo *error) {
+    memset(graph, 0, sizeof(*graph));
+
+    Discovery d;
+    memset(&d, 0, sizeof(d));
+    for (size_t s = 0; s < MAP_SHARDS; s++) {
+        pthread_mutex_init(&d.shards[s].lock, NULL);
+    }
+    pthread_mutex_init(&d.error_lock, NULL);
+    atomic_init(&d.failed, false);
+    d.error = error;
+
+    Discovered **entry_nodes = (Discovered**)calloc(entry_count ? entry_count : 1, sizeof(Discovered*));
+    d.pool = entry_nodes ? threadpool_create(thread_count) : NULL;
+    if (!d.pool) {
+        set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Cannot create thread pool");
+        free(entry_nodes);
+        discovery_free(&d);
+        return false;
+    }
+
+    for (size_t i = 0; i < entry_count && !atomic_load(&d.failed); i++) {
+        char *resolved = resolve_path(entries[i]);
+        if (!resolved) {
+            discovery_fail(&d, ERROR_FILE_READ, (Position){0, 0, 0},
+                           "Cannot find entry module '%s'", entries[i]);
+            break;
+        }
+        entry_nodes[i] = discovery_add(&d, resolved);
+    }
+    threadpool_wait(d.pool);
+    threadpool_destroy(d.pool);
+
+    bool success = !atomic_load(&d.failed);
+    if (success) {
+        success = number_modules(graph, &d, entry_nodes, entry_count) &&
+                  build_edges(graph) && analyze_cycles(graph);
+        if (!success) {
+            set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+        }
+    }
+
+    free(entry_nodes);
+    discovery_free(&d);
+    if (!success) module_graph_free(graph);
+    return success;
+}
+
+/* 释放依赖图 */
+void module_graph_free(ModuleGraph *graph) {
+    for (size_t m = 0; m < graph->count; m++) {
+        GraphModule *module = &graph->modules[m];
+        free(module->path);
+        free(module->source);
+        module_import_list_free(&module->imports);
+        free(module->targets);
+    }
+    free(graph->modules);
+    free(graph->edge_start);
+    free(graph->edges);
+    free(graph->order);
+    free(graph->cycle_start);
+    free(graph->cycles);
+    memset(graph, 0, sizeof(*graph));
+}
+
+/* 说明符内容从offset开始的import对应的目标模块（二分查找，说明符按出现顺序排列） */
+uint32_t module_import_target(const GraphModule *module, size_t offset) {
+    size_t lo = 0;
+    size_t hi = module->imports.count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (module->imports.items[mid].start < offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < module->imports.count && module->imports.items[lo].start == offset) {
+        return module->targets[lo];
+    }
+    return MODULE_NONE;
+}
+
+/* 写出一组模块编号 */
+static void write_ids(Writer *writer, const uint32_t *ids, size_t count) {
+    writer_byte(writer, '[');
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) writer_byte(writer, ',');
+        writer_uint(writer, ids[i]);
+    }
+    writer_byte(writer, ']');
+}
+
+/* 输出依赖图的JSON：模块（每行一个）、拓扑序和环 */
+bool module_graph_write(const ModuleGraph *graph, Writer *writer) {
+    writer_cstr(writer, "{\"modules\":[\n");
+    for (size_t m = 0; m < graph->count; m++) {
+        const GraphModule *module = &graph->modules[m];
+        writer_cstr(writer, "{\"id\":");
+        writer_uint(writer, m);
+        writer_cstr(writer, ",\"path\":");
+        writer_json_string(writer, module->path, strlen(module->path));
+        writer_cstr(writer, ",\"deps\":");
+        write_ids(writer, graph->edges + graph->edge_start[m], graph->edge_start[m + 1] - graph->edge_start[m]);
+        writer_cstr(writer, ",\"imports\":[");
+        for (size_t i = 0; i < module->imports.count; i++) {
+            const ModuleImport *item = &module->imports.items[i];
+            if (i > 0) writer_byte(writer, ',');
+            writer_cstr(writer, "{\"kind\":\"");
+            writer_cstr(writer, import_kind_name(item->kind));
+            writer_cstr(writer, "\",\"specifier\":");
+            writer_json_string(writer, module->source + item->start, item->end - item->start);
+            writer_cstr(writer, ",\"module\":");
+            if (module->targets[i] == MODULE_NONE) {
+                writer_cstr(writer, "null");
+            } else {
+                writer_uint(writer, module->targets[i]);
+            }
+            writer_byte(writer, '}');
+        }
+        writer_cstr(writer, m + 1 < graph->count ? "]},\n" : "]}\n");
+    }
+    writer_cstr(writer, "],\n\"order\":");
+    write_ids(writer, graph->order, graph->count);
+    writer_cstr(writer, ",\n\"cycles\":[");
+    for (size_t c = 0; c < graph->cycle_count; c++) {
+        if (c > 0) writer_byte(writer, ',');
+        write_ids(writer, graph->cycles + graph->cycle_start[c], graph->cycle_start[c + 1] - graph->cycle_start[c]);
+    }
+    writer_cstr(writer, "]}\n");
+    return !writer->failed;
+}
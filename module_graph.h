@@ -0,0 +1,42 @@
+#ifndef MODULE_GRAPH_H
+#define MODULE_GRAPH_H
+
+#include "module_scan.h"
+#include "writer.h"
+#include "common.h"
+
+#define MODULE_NONE UINT32_MAX
+
+/* 图中的一个模块 */
+typedef struct {
+    char *path;                 /* 规范化后的绝对路径 */
+    char *source;
+    size_t length;
+    ModuleImportList imports;   /* 源码中的全部说明符 */
+    uint32_t *targets;          /* 每个说明符解析到的模块，MODULE_NONE表示未解析（裸说明符或找不到） */
+} GraphModule;
+
+/* 模块依赖图：模块按从入口开始的广度优先顺序编号，依赖边用CSR（压缩邻接表）存储 */
+typedef struct {
+    GraphModule *modules;
+    size_t count;
+    size_t entry_count;         /* 入口为编号 0 .. entry_count - 1 的模块（重复的入口只算一次） */
+    size_t *edge_start;         /* 模块i的依赖为 edges[edge_start[i]] .. edges[edge_start[i + 1] - 1] */
+    uint32_t *edges;            /* 按说明符出现顺序，同一模块的重复依赖只保留一条 */
+    size_t edge_count;
+    uint32_t *order;            /* 拓扑序：依赖在前（即ES模块的执行顺序） */
+    size_t *cycle_start;        /* 环（含多个模块或自引用的强连通分量），同样用CSR存储 */
+    uint32_t *cycles;
+    size_t cycle_count;
+    size_t unresolved;          /* 未能解析的相对说明符个数 */
+} ModuleGraph;
+
+/* 模块依赖图函数声明 */
+bool module_graph_build(ModuleGraph *graph, const char *const *entries, size_t entry_count,
+                        int thread_count, ErrorInfo *error);
+void module_graph_free(ModuleGraph *graph);
+bool module_graph_write(const ModuleGraph *graph, Writer *writer);
+bool module_specifier_is_relative(const char *specifier, size_t length);
+uint32_t module_import_target(const GraphModule *module, size_t offset);
+
+#endif /* MODULE_GRAPH_H */
@@ -0,0 +1,534 @@
+#include "module_scan.h"
+
+#define TEMPLATE_DEPTH_MAX 256
+#define SCAN_END SIZE_MAX
+
+#define BYTE_WORD 1             /* 标识符、关键字或数字中的字节（非ASCII字节和\u转义按标识符处理） */
+#define BYTE_STOP 2             /* 主循环需要停下来处理的字节：引号、`、/、{、}以及i/e/r（可能是关键字的开头） */
+
+static const unsigned char byte_class[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 2, 0, 1, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 2,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 0, 0, 1,
+    2, 1, 1, 1, 1, 3, 1, 1, 1, 3, 1, 1, 1, 1, 1, 1,
+    1, 1, 3, 1, 1, 1, 1, 1, 1, 1, 1, 2, 0, 2, 0, 0,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+};
+
+/* 扫描器状态：主循环只在少数字节处停下，/ 是否开始正则由向后查看前一个token决定 */
+typedef struct {
+    const char *source;
+    size_t length;
+    ModuleImportList *list;
+    bool failed;                /* 内存不足 */
+    size_t comment_start;       /* 最近一个注释的范围，向后查看时跳过 */
+    size_t comment_end;
+    size_t braces;              /* 当前 { 的嵌套层数 */
+    size_t templates;           /* 未结束的模板替换 ${ 个数 */
+    size_t template_braces[TEMPLATE_DEPTH_MAX]; /* 每个 ${ 开始时的braces */
+} Scanner;
+
+static inline bool is_word_byte(unsigned char ch) {
+    return byte_class[ch] & BYTE_WORD;
+}
+
+static inline bool is_space_byte(unsigned char ch) {
+    return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t' || ch == '\v' || ch == '\f';
+}
+
+/* 计算偏移对应的行列（只在出错时使用） */
+static Position offset_position(const char *source, size_t offset) {
+    Position pos = {1, 1, (int)offset};
+    for (size_t i = 0; i < offset; i++) {
+        char ch = source[i];
+        if (ch == '\n' || (ch == '\r' && source[i + 1] != '\n')) {
+            pos.line++;
+            pos.column = 1;
+        } else if (ch != '\r') {
+            pos.column++;
+        }
+    }
+    return pos;
+}
+
+/* 字符串结束位置（pos为开始的引号），返回结束引号之后的位置；未结束时返回SCAN_END */
+static size_t string_end(const char *source, size_t length, size_t pos) {
+    char quote = source[pos++];
+    while (pos < length) {
+        char ch = source[pos];
+        if (ch == quote) return pos + 1;
+        if (ch == '\\') {
+            pos += (pos + 2 < length && source[pos + 1] == '\r' && source[pos + 2] == '\n') ? 3 : 2;
+        } else if (ch == '\n' || ch == '\r') {
+            return SCAN_END;
+        } else {
+            pos++;
+        }
+    }
+    return SCAN_END;
+}
+
+/* 模板的一段文本（pos为`或}之后），返回`或${之后的位置，*substitution表示遇到了${ */
+static size_t template_end(const char *source, size_t length, size_t pos, bool *substitution) {
+    while (pos < length) {
+        char ch = source[pos];
+        if (ch == '`') {
+            *substitution = false;
+            return pos + 1;
+        }
+        if (ch == '$' && pos + 1 < length && source[pos + 1] == '{') {
+            *substitution = true;
+            return pos + 2;
+        }
+        pos += ch == '\\' ? 2 : 1;
+    }
+    return SCAN_END;
+}
+
+/* 正则表达式结束位置（pos为开始的/），包括标志 */
+static size_t regex_end(const char *source, size_t length, size_t pos) {
+    bool in_class = false;
+    pos++;
+    while (pos < length) {
+        char ch = source[pos];
+        if (ch == '\\') {
+            pos += 2;
+            continue;
+        }
+        if (ch == '\n' || ch == '\r') return SCAN_END;
+        if (ch == '[') {
+            in_class = true;
+        } else if (ch == ']') {
+            in_class = false;
+        } else if (ch == '/' && !in_class) {
+            pos++;
+            while (pos < length && is_word_byte((unsigned char)source[pos])) pos++;
+            return pos;
+        }
+        pos++;
+    }
+    return SCAN_END;
+}
+
+/* 跳过空白和注释（向前查看时使用；未结束的注释跳到末尾） */
+static size_t skip_trivia(const char *source, size_t length, size_t pos) {
+    while (pos < length) {
+        unsigned char ch = (unsigned char)source[pos];
+        if (is_space_byte(ch)) {
+            pos++;
+        } else if (ch == '/' && pos + 1 < length && source[pos + 1] == '/') {
+            while (pos < length && source[pos] != '\n' && source[pos] != '\r') pos++;
+        } else if (ch == '/' && pos + 1 < length && source[pos + 1] == '*') {
+            pos += 2;
+            while (pos + 1 < length && !(source[pos] == '*' && source[pos + 1] == '/')) pos++;
+            pos = pos + 1 < length ? pos + 2 : length;
+        } else {
+            break;
+        }
+    }
+    return pos;
+}
+
+/* 单词结束位置 */
+static size_t word_end(const char *source, size_t length, size_t pos) {
+    while (pos < length && is_word_byte((unsigned char)source[pos])) pos++;
+    return pos;
+}
+
+/* [start, end) 是否为给定的单词 */
+static bool word_is(const char *source, size_t start, size_t end, const char *word) {
+    size_t length = strlen(word);
+    return end - start == length && memcmp(source + start, word, length) == 0;
+}
+
+/* 记录一个说明符（pos为开始的引号，end为结束引号之后） */
+static void add_import(Scanner *s, ImportKind kind, size_t pos, size_t end, size_t keyword) {
+    ModuleImportList *list = s->list;
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 16;
+        ModuleImport *items = (ModuleImport*)realloc(list->items, capacity * sizeof(ModuleImport));
+        if (!items) {
+            s->failed = true;
+            return;
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+    ModuleImport *item = &list->items[list->count++];
+    item->kind = kind;
+    item->start = pos + 1;
+    item->end = end - 1;
+    item->keyword = keyword;
+}
+
+/* 是否为字符串的开始引号 */
+static inline bool is_quote(char ch) {
+    return ch == '"' || ch == '\'';
+}
+
+/* import()/require()的参数：字符串或没有替换的模板，返回结束位置（都不是时为SCAN_END） */
+static size_t argument_end(const char *source, size_t length, size_t pos) {
+    if (pos >= length) return SCAN_END;
+    if (is_quote(source[pos])) return string_end(source, length, pos);
+    if (source[pos] != '`') return SCAN_END;
+    bool substitution;
+    size_t end = template_end(source, length, pos + 1, &substitution);
+    return substitution ? SCAN_END : end;
+}
+
+/* from 'x'：pos为from之前的位置 */
+static void scan_from(Scanner *s, size_t pos, ImportKind kind, size_t keyword) {
+    const char *src = s->source;
+    pos = skip_trivia(src, s->length, pos);
+    size_t end = word_end(src, s->length, pos);
+    if (!word_is(src, pos, end, "from")) return;
+
+    pos = skip_trivia(src, s->length, end);
+    if (pos < s->length && is_quote(src[pos])) {
+        end = string_end(src, s->length, pos);
+        if (end != SCAN_END) add_import(s, kind, pos, end, keyword);
+    }
+}
+
+/* 跳过 { ... }（导入导出子句中只有名字、逗号、as和字符串），返回}之后的位置 */
+static size_t skip_clause(const char *source, size_t length, size_t pos) {
+    pos++;
+    while (pos < length) {
+        pos = skip_trivia(source, length, pos);
+        if (pos >= length) break;
+        char ch = source[pos];
+        if (ch == '}') return pos + 1;
+        if (is_quote(ch)) {
+            size_t end = string_end(source, length, pos);
+            if (end == SCAN_END) return length;
+            pos = end;
+        } else {
+            pos++;
+        }
+    }
+    return length;
+}
+
+/* import之后：import('x')、import 'x'、import 子句 from 'x'；import.meta不是依赖 */
+static void scan_import(Scanner *s, size_t keyword, size_t pos) {
+    const char *src = s->source;
+    size_t length = s->length;
+
+    pos = skip_trivia(src, length, pos);
+    if (pos >= length) return;
+
+    if (src[pos] == '(') {
+        pos = skip_trivia(src, length, pos + 1);
+        size_t end = argument_end(src, length, pos);
+        size_t next = end == SCAN_END ? length : skip_trivia(src, length, end);
+        if (next < length && (src[next] == ')' || src[next] == ',')) {
+            add_import(s, IMPORT_DYNAMIC, pos, end, keyword);
+        }
+        return;
+    }
+    if (is_quote(src[pos])) {
+        size_t end = string_end(src, length, pos);
+        if (end != SCAN_END) add_import(s, IMPORT_STATIC, pos, end, keyword);
+        return;
+    }
+
+    /* 默认导入、* as ns、{ ... } 的任意组合，直到from */
+    while (pos < length) {
+        char ch = src[pos];
+        if (ch == '{') {
+            pos = skip_clause(src, length, pos);
+        } else if (ch == '*' || ch == ',') {
+            pos++;
+        } else if (is_word_byte((unsigned char)ch)) {
+            size_t end = word_end(src, length, pos);
+            if (word_is(src, pos, end, "from")) {
+                size_t next = skip_trivia(src, length, end);
+                if (next < length && is_quote(src[next])) {
+                    scan_from(s, pos, IMPORT_STATIC, keyword);
+                    return;
+                }
+            }
+            pos = end;
+        } else {
+            return;
+        }
+        pos = skip_trivia(src, length, pos);
+    }
+}
+
+/* export之后：只有 export * [as x] from 'x' 和 export { ... } from 'x' 带有说明符 */
+static void scan_export(Scanner *s, size_t keyword, size_t pos) {
+    const char *src = s->source;
+    size_t length = s->length;
+
+    pos = skip_trivia(src, length, pos);
+    if (pos >= length) return;
+
+    if (src[pos] == '*') {
+        pos = skip_trivia(src, length, pos + 1);
+        size_t end = word_end(src, length, pos);
+        if (word_is(src, pos, end, "as")) {
+            pos = skip_trivia(src, length, end);
+            if (pos < length && is_quote(src[pos])) {
+                end = string_end(src, length, pos);
+                if (end == SCAN_END) return;
+            } else {
+                end = word_end(src, length, pos);
+            }
+            pos = end;
+        }
+        scan_from(s, pos, IMPORT_REEXPORT, keyword);
+    } else if (src[pos] == '{') {
+        scan_from(s, skip_clause(src, length, pos), IMPORT_REEXPORT, keyword);
+    }
+}
+
+/* require('x')、require(`x`) */
+static void scan_require(Scanner *s, size_t keyword, size_t pos) {
+    const char *src = s->source;
+    size_t length = s->length;
+
+    pos = skip_trivia(src, length, pos);
+    if (pos >= length || src[pos] != '(') return;
+    pos = skip_trivia(src, length, pos + 1);
+    size_t end = argument_end(src, length, pos);
+    size_t next = end == SCAN_END ? length : skip_trivia(src, length, end);
+    if (next < length && src[next] == ')') {
+        add_import(s, IMPORT_REQUIRE, pos, end, keyword);
+    }
+}
+
+/* 其后的 / 开始正则表达式的关键字 */
+static bool is_expression_keyword(const char *word, size_t length) {
+    switch (length) {
+        case 2:
+            return memcmp(word, "in", 2) == 0 || memcmp(word, "of", 2) == 0 ||
+                   memcmp(word, "do", 2) == 0;
+        case 3:
+            return memcmp(word, "new", 3) == 0;
+        case 4:
+            return memcmp(word, "void", 4) == 0 || memcmp(word, "case", 4) == 0 ||
+                   memcmp(word, "else", 4) == 0;
+        case 5:
+            return memcmp(word, "throw", 5) == 0 || memcmp(word, "yield", 5) == 0 ||
+                   memcmp(word, "await", 5) == 0;
+        case 6:
+            return memcmp(word, "return", 6) == 0 || memcmp(word, "typeof", 6) == 0 ||
+                   memcmp(word, "delete", 6) == 0;
+        case 7:
+            return memcmp(word, "extends", 7) == 0;
+        case 10:
+            return memcmp(word, "instanceof", 10) == 0;
+        default:
+            return false;
+    }
+}
+
+/* 向后跳过空白和最近的注释，返回pos之前最后一个有效字节的位置，没有时返回SCAN_END */
+static size_t previous_significant(const Scanner *s, size_t pos) {
+    while (pos > 0) {
+        pos--;
+        if (pos + 1 == s->comment_end) {
+            pos = s->comment_start;
+            continue;
+        }
+        if (!is_space_byte((unsigned char)s->source[pos])) {
+            return pos;
+        }
+    }
+    return SCAN_END;
+}
+
+/* pos处的 / 是否开始正则表达式：前一个token是操作数（标识符、数字、字面量、)、]）时为除法 */
+static bool slash_starts_regex(const Scanner *s, size_t pos) {
+    const char *src = s->source;
+    size_t prev = previous_significant(s, pos);
+    if (prev == SCAN_END) return true;
+
+    unsigned char ch = (unsigned char)src[prev];
+    if (ch == ')' || ch == ']' || ch == '"' || ch == '\'' || ch == '`') {
+        return false;
+    }
+    if (is_word_byte(ch)) {
+        size_t start = prev;
+        while (start > 0 && is_word_byte((unsigned char)src[start - 1])) start--;
+        return is_expression_keyword(src + start, prev + 1 - start);
+    }
+    if ((ch == '+' || ch == '-') && prev > 0 && src[prev - 1] == (char)ch) {
+        /* ++/--：前面是操作数时为后缀运算符，a++ / 2 是除法 */
+        size_t before = previous_significant(s, prev - 1);
+        if (before == SCAN_END) return true;
+        unsigned char operand = (unsigned char)src[before];
+        return !(is_word_byte(operand) || operand == ')' || operand == ']');
+    }
+    return true;    /* 其他运算符和 {、}、; 之后是表达式或语句的开始 */
+}
+
+/* 单词前面是否为 .（属性名，如obj.require），展开运算符 ... 除外 */
+static bool after_member_dot(const Scanner *s, size_t pos) {
+    size_t prev = previous_significant(s, pos);
+    if (prev == SCAN_END || s->source[prev] != '.') return false;
+    return !(prev >= 2 && s->source[prev - 1] == '.' && s->source[prev - 2] == '.');
+}
+
+/* 处理一个以i/e/r开头的单词：import/export/require向前查看说明符 */
+static void scan_keyword(Scanner *s, size_t start, size_t end) {
+    const char *word = s->source + start;
+    size_t length = end - start;
+
+    if (length == 6 && memcmp(word, "import", 6) == 0) {
+        if (!after_member_dot(s, start)) scan_import(s, start, end);
+    } else if (length == 6 && memcmp(word, "export", 6) == 0) {
+        if (!after_member_dot(s, start)) scan_export(s, start, end);
+    } else if (length == 7 && memcmp(word, "require", 7) == 0) {
+        if (!after_member_dot(s, start)) scan_require(s, start, end);
+    }
+}
+
+/* 扫描模块说明符 */
+bool module_scan(const char *source, size_t length, ModuleImportList *list, ErrorInfo *error) {
+    Scanner s;
+    s.source = source;
+    s.length = length;
+    s.list = list;
+    s.failed = false;
+    s.comment_start = 0;
+    s.comment_end = 0;
+    s.braces = 0;
+    s.templates = 0;
+
+    size_t pos = 0;
+    size_t start = 0;
+    const char *message = NULL;
+    ErrorCode code = ERROR_LEXER_UNTERMINATED_STRING;
+
+    /* #!开头的第一行 */
+    if (length >= 2 && source[0] == '#' && source[1] == '!') {
+        while (pos < length && source[pos] != '\n' && source[pos] != '\r') pos++;
+    }
+
+    while (!message && !s.failed) {
+        /* 热路径：跳过不需要处理的字节 */
+        while (pos < length && !(byte_class[(unsigned char)source[pos]] & BYTE_STOP)) pos++;
+        if (pos >= length) break;
+
+        start = pos;
+        switch (source[pos]) {
+            case '"':
+            case '\'':
+                pos = string_end(source, length, pos);
+                if (pos == SCAN_END) message = "Unterminated string";
+                break;
+
+            case '`':
+            template_part: {
+                bool substitution;
+                pos = template_end(source, length, pos + 1, &substitution);
+                if (pos == SCAN_END) {
+                    message = "Unterminated template literal";
+                } else if (substitution) {
+                    if (s.templates == TEMPLATE_DEPTH_MAX) {
+                        message = "Template literals nested too deeply";
+                        code = ERROR_PARSER_UNEXPECTED_TOKEN;
+                        break;
+                    }
+                    s.template_braces[s.templates++] = s.braces;
+                }
+                break;
+            }
+
+            case '/':
+                if (pos + 1 < length && source[pos + 1] == '*') {
+                    pos += 2;
+                    while (pos + 1 < length && !(source[pos] == '*' && source[pos + 1] == '/')) pos++;
+                    if (pos + 1 >= length) {
+                        message = "Unterminated comment";
+                        break;
+                    }
+                    pos += 2;
+                    s.comment_start = start;
+                    s.comment_end = pos;
+                } else if (pos + 1 < length && source[pos + 1] == '/') {
+                    while (pos < length && source[pos] != '\n' && source[pos] != '\r') pos++;
+                    s.comment_start = start;
+                    s.comment_end = pos;
+                } else if (slash_starts_regex(&s, pos)) {
+                    pos = regex_end(source, length, pos);
+                    if (pos == SCAN_END) {
+                        message = "Unterminated regular expression";
+                        code = ERROR_LEXER_UNTERMINATED_REGEX;
+                    }
+                } else {
+                    pos++;
+                }
+                break;
+
+            case '{':
+                s.braces++;
+                pos++;
+                break;
+
+            case '}':
+                if (s.templates > 0 && s.template_braces[s.templates - 1] == s.braces) {
+                    s.templates--;
+                    goto template_part;     /* 替换结束，继续模板的下一段文本 */
+                }
+                if (s.braces > 0) s.braces--;
+                pos++;
+                break;
+
+            default:
+                /* i/e/r：只处理单词的开头，单词中间的字母直接跳到单词末尾 */
+                if (start > 0 && is_word_byte((unsigned char)source[start - 1])) {
+                    pos = word_end(source, length, pos + 1);
+                    break;
+                }
+                pos = word_end(source, length, pos + 1);
+                scan_keyword(&s, start, pos);
+                break;
+        }
+    }
+
+    if (s.failed) {
+        set_error(error, ERROR_OUT_OF_MEMORY, offset_position(source, 0), "Out of memory");
+        return false;
+    }
+    if (!message && s.templates > 0) {
+        message = "Unterminated template literal";
+        start = length;
+    }
+    if (message) {
+        set_error(error, code, offset_position(source, start), message);
+        return false;
+    }
+    return true;
+}
+
+/* 释放说明符列表 */
+void module_import_list_free(ModuleImportList *list) {
+    free(list->items);
+    list->items = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+/* 说明符来源的名称 */
+const char* import_kind_name(ImportKind kind) {
+    switch (kind) {
+        case IMPORT_STATIC: return "import";
+        case IMPORT_REEXPORT: return "export";
+        case IMPORT_DYNAMIC: return "dynamic";
+        case IMPORT_REQUIRE: return "require";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef MODULE_SCAN_H
+#define MODULE_SCAN_H
+
+#include "common.h"
+
+/* 模块依赖的来源 */
+typedef enum {
+    IMPORT_STATIC,          /* import ... from 'x' / import 'x' */
+    IMPORT_REEXPORT,        /* export ... from 'x' */
+    IMPORT_DYNAMIC,         /* import('x') */
+    IMPORT_REQUIRE          /* require('x') */
+} ImportKind;
+
+/* 一个模块说明符 */
+typedef struct {
+    ImportKind kind;
+    size_t start;           /* 说明符内容（不含引号）的字节范围，转义序列保持原样 */
+    size_t end;
+    size_t keyword;         /* import/export/require关键字的偏移 */
+} ModuleImport;
+
+/* 说明符列表（按出现顺序） */
+typedef struct {
+    ModuleImport *items;
+    size_t count;
+    size_t capacity;
+} ModuleImportList;
+
+/* 只扫描模块说明符：跳过字符串、注释、模板和正则表达式，只在import/export/require处
+   做少量向前查看，不构建token。动态import()和require()只记录参数为单个字符串字面量
+   或没有${}替换的模板（如require(`./x`)）的情况 */
+bool module_scan(const char *source, size_t length, ModuleImportList *list, ErrorInfo *error);
+void module_import_list_free(ModuleImportList *list);
+const char* import_kind_name(ImportKind kind);
+
+#endif /* MODULE_SCAN_H */
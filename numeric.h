@@ -0,0 +1,63 @@
+#ifndef NUMERIC_H
+#define NUMERIC_H
+
+#include "common.h"
+
+/*
+ * 数字字面量的值。
+ *
+ * 词法分析器读数字时按ECMAScript的文法检查字面量（0x后没有数字、指数没有数字、
+ * 分隔符位置不对、带小数的BigInt、紧跟在数字后面的标识符等），同时算出它的值：
+ *   - 十进制：不超过19位有效数字时按Clinger快速路径（尾数不超过2^53、10的幂不超过22，
+ *     一次浮点乘除就是正确舍入的结果）或Eisel-Lemire算法（尾数乘以128位截断的5的幂，
+ *     取高位舍入）直接得到double；更长的尾数截断为19位，截断前后结果相同即为答案，
+ *     否则（极少见）交给strtod。
+ *   - 十六进制、八进制、二进制和传统八进制：按位拼接，超过64位的部分只记粘滞位，
+ *     最后按最近偶数舍入一次。
+ * BigInt的精确值按需用NumericBigInt（32位limb的任意精度缓冲）计算。
+ */
+
+/* 数字字面量的值 */
+typedef struct {
+    double value;           /* Number的值；BigInt为其数学值舍入到double */
+    bool bigint;            /* 以n结尾的BigInt */
+} NumericLiteral;
+
+/* BigInt的值（小端的32位limb），以及转换出的十进制文本 */
+typedef struct {
+    uint32_t *limbs;
+    size_t count;           /* 有效limb数，0表示值为0 */
+    size_t capacity;
+    char *text;             /* numeric_bigint_decimal的结果 */
+    size_t text_capacity;
+} NumericBigInt;
+
+/* 从text开始读一个数字字面量（首字节是数字，或'.'后跟数字）。合法时返回true，
+   *consumed为字面量的字节数；不合法时返回false，*consumed为出错的位置，*message为说明 */
+bool numeric_scan(const char *text, size_t length, NumericLiteral *out,
+                  size_t *consumed, const char **message);
+
+/* 合法字面量（源码文本，可含分隔符）的值；不是完整的数字字面量时返回false */
+bool numeric_value(const char *text, size_t length, NumericLiteral *out);
+
+/* 不含分隔符的十进制数（数字、可选的小数部分和指数）转double，正确舍入 */
+double numeric_parse_decimal(const char *text, size_t length);
+
+/* base（2、8或16）进制的数字串（不含前缀，须都是合法数字）转double，正确舍入 */
+double numeric_parse_radix(const char *digits, size_t length, int base);
+
+/* JSON数字：能还原为同一个double的最短%g表示（15到17位有效数字），非有限值为null；
+   buffer至少32字节，返回长度 */
+size_t numeric_format_json(double value, char *buffer);
+
+/* BigInt缓冲 */
+void numeric_bigint_init(NumericBigInt *value);
+void numeric_bigint_free(NumericBigInt *value);
+
+/* BigInt字面量（含结尾的n，可含分隔符）的精确值；内存不足时返回false */
+bool numeric_bigint_parse(NumericBigInt *value, const char *literal, size_t length);
+
+/* 十进制文本（以'\0'结尾，存于value中，下次调用前有效）；内存不足时返回NULL */
+const char* numeric_bigint_decimal(NumericBigInt *value, size_t *length);
+
+#endif /* NUMERIC_H */
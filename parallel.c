@@ -0,0 +1,553 @@
+#include "parallel.h"
+#include "parser.h"
+#include "threadpool.h"
+#include <stdatomic.h>
+
+/*
+ * 顶层区域预扫描
+ *
+ * 预扫描是lexer_next_token的轻量镜像：不分配token，只跟踪括号深度、
+ * 模板替换 ${} 的嵌套、正则/除法判定所需的上一个token类别以及换行标志。切分点必须满足：
+ *   1. 位于括号深度0处，且是一个语句开头的关键字；
+ *   2. 前一个token是 ; ，或是 } 且二者之间有换行（由ASI保证语句在此结束）。
+ * 这样每个区域单独解析时的token流与串行解析完全相同。
+ * while不作为切分点，因为它可能是do-while的尾部。
+ */
+
+/* 上一个会更新lexer->prev_token的token类别 */
+typedef enum {
+    PREV_NONE,              /* 尚无token：/ 视为除法 */
+    PREV_REGEX_OK,          /* 其后的 / 开始正则表达式 */
+    PREV_OTHER              /* 其后的 / 是除法 */
+} PrevKind;
+
+/* 预扫描状态 */
+typedef struct {
+    const char *src;
+    size_t length;
+    size_t pos;
+    bool newline;           /* 自上一个token起是否经过换行 */
+    int templates;          /* 未结束的模板替换 ${ 个数 */
+    int template_depth[LEXER_TEMPLATE_DEPTH_MAX]; /* 每个 ${ 开始时的括号深度 */
+} Prescan;
+
+static bool prescan_is_id_start(unsigned char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+           ch == '$' || ch == '_' || ch >= 0x80;
+}
+
+static bool prescan_is_id_continue(unsigned char ch) {
+    return prescan_is_id_start(ch) || (ch >= '0' && ch <= '9');
+}
+
+/* 前进一个字符，行为与词法分析器的advance一致（\r\n算一次换行） */
+static void prescan_advance(Prescan *ps) {
+    char ch = ps->src[ps->pos++];
+    if (ch == '\n') {
+        ps->newline = true;
+    } else if (ch == '\r') {
+        if (ps->pos < ps->length && ps->src[ps->pos] == '\n') ps->pos++;
+        ps->newline = true;
+    }
+}
+
+static char prescan_peek(const Prescan *ps, size_t offset) {
+    size_t p = ps->pos + offset;
+    return p < ps->length ? ps->src[p] : '\0';
+}
+
+/* 跳过空白和注释；遇到未闭合的块注释返回false */
+static bool prescan_skip_trivia(Prescan *ps) {
+    while (ps->pos < ps->length) {
+        char ch = ps->src[ps->pos];
+        if (ch == ' ' || ch == '\t' || ch == '\v' || ch == '\f' ||
+            ch == '\n' || ch == '\r') {
+            prescan_advance(ps);
+        } else if (ch == '/' && prescan_peek(ps, 1) == '/') {
+            ps->pos += 2;
+            while (ps->pos < ps->length &&
+                   ps->src[ps->pos] != '\n' && ps->src[ps->pos] != '\r') {
+                ps->pos++;
+            }
+        } else if (ch == '/' && prescan_peek(ps, 1) == '*') {
+            ps->pos += 2;
+            for (;;) {
+                if (ps->pos >= ps->length) return false;
+                if (ps->src[ps->pos] == '*' && prescan_peek(ps, 1) == '/') {
+                    ps->pos += 2;
+                    break;
+                }
+                prescan_advance(ps);
+            }
+        } else {
+            break;
+        }
+    }
+    return true;
+}
+
+/* 跳过带反斜杠转义的内容直到终止字符；遇到行终止符（若不允许）返回false */
+static bool prescan_skip_quoted(Prescan *ps, char quote, bool allow_newline) {
+    while (ps->pos < ps->length) {
+        char ch = ps->src[ps->pos];
+        if (ch == quote) {
+            ps->pos++;
+            return true;
+        } else if (ch == '\\') {
+            ps->pos++;
+            if (ps->pos < ps->length) prescan_advance(ps);
+        } else if (!allow_newline && (ch == '\n' || ch == '\r')) {
+            return false;
+        } else {
+            prescan_advance(ps);
+        }
+    }
+    return true;
+}
+
+/* 跳过模板的一段（起始的 ` 或与 ${ 配对的 } 已消耗），到 ` 或 ${ 为止。
+   以 ${ 结束时记下当时的括号深度，把 ${ 当作一层括号；嵌套过深返回false */
+static bool prescan_skip_template(Prescan *ps, int *depth, PrevKind *prev) {
+    while (ps->pos < ps->length) {
+        char ch = ps->src[ps->pos];
+        if (ch == '`') {
+            ps->pos++;
+            break;
+        } else if (ch == '\\') {
+            ps->pos++;
+            if (ps->pos < ps->length) prescan_advance(ps);
+        } else if (ch == '$' && prescan_peek(ps, 1) == '{') {
+            ps->pos += 2;
+            ps->newline = false;
+            if (ps->templates == LEXER_TEMPLATE_DEPTH_MAX) return false;
+            ps->template_depth[ps->templates++] = (*depth)++;
+            *prev = PREV_REGEX_OK;
+            return true;
+        } else {
+            prescan_advance(ps);
+        }
+    }
+    /* 与词法分析器一致：模板中的换行不是token之间的换行 */
+    ps->newline = false;
+    *prev = PREV_OTHER;
+    return true;
+}
+
+/* 跳过正则表达式主体和标志（起始的 / 已消耗） */
+static bool prescan_skip_regex(Prescan *ps) {
+    while (ps->pos < ps->length) {
+        char ch = ps->src[ps->pos];
+        if (ch == '/') {
+            ps->pos++;
+            while (ps->pos < ps->length && isalpha((unsigned char)ps->src[ps->pos])) {
+                ps->pos++;
+            }
+            return true;
+        } else if (ch == '\\') {
+            ps->pos++;
+            if (ps->pos < ps->length) prescan_advance(ps);
+        } else if (ch == '\n' || ch == '\r') {
+            return false;
+        } else if (ch == '[') {
+            ps->pos++;
+            while (ps->pos < ps->length) {
+                char cls_ch = ps->src[ps->pos];
+                if (cls_ch == ']') {
+                    ps->pos++;
+                    break;
+                } else if (cls_ch == '\\') {
+                    ps->pos++;
+                    if (ps->pos < ps->length) prescan_advance(ps);
+                } else {
+                    prescan_advance(ps);
+                }
+            }
+        } else {
+            prescan_advance(ps);
+        }
+    }
+    return true;
+}
+
+/* 跳过数字字面量（首字符已消耗），与read_number一致 */
+static void prescan_skip_number(Prescan *ps, char first) {
+    const char *s = ps->src;
+    size_t n = ps->length;
+
+    if (first == '0' && ps->pos < n) {
+        char next = s[ps->pos];
+        if (next == 'x' || next == 'X') {
+            ps->pos++;
+            while (ps->pos < n && isxdigit((unsigned char)s[ps->pos])) ps->pos++;
+        } else if (next == 'b' || next == 'B') {
+            ps->pos++;
+            while (ps->pos < n && (s[ps->pos] == '0' || s[ps->pos] == '1')) ps->pos++;
+        } else if (next == 'o' || next == 'O') {
+            ps->pos++;
+            while (ps->pos < n && s[ps->pos] >= '0' && s[ps->pos] <= '7') ps->pos++;
+        }
+    }
+
+    while (ps->pos < n && isdigit((unsigned char)s[ps->pos])) ps->pos++;
+
+    if (prescan_peek(ps, 0) == '.' && isdigit((unsigned char)prescan_peek(ps, 1))) {
+        ps->pos++;
+        while (ps->pos < n && isdigit((unsigned char)s[ps->pos])) ps->pos++;
+    }
+
+    if (prescan_peek(ps, 0) == 'e' || prescan_peek(ps, 0) == 'E') {
+        ps->pos++;
+        if (prescan_peek(ps, 0) == '+' || prescan_peek(ps, 0) == '-') ps->pos++;
+        while (ps->pos < n && isdigit((unsigned char)s[ps->pos])) ps->pos++;
+    }
+}
+
+/* 标识符分类：是否为切分点关键字，是否允许其后出现正则 */
+static void prescan_classify_word(const char *w, size_t len,
+                                  bool *split_point, bool *regex_ok) {
+    static const char *split_words[] = {
+        "function", "class", "var", "let", "const", "if", "for",
+        "switch", "try", "do", "throw", NULL
+    };
+
+    *split_point = false;
+    *regex_ok = (len == 6 && memcmp(w, "return", 6) == 0) ||
+                (len == 5 && memcmp(w, "throw", 5) == 0);
+
+    if (len < 2 || len > 8) return;
+    for (int i = 0; split_words[i]; i++) {
+        if (strlen(split_words[i]) == len && memcmp(split_words[i], w, len) == 0) {
+            *split_point = true;
+            return;
+        }
+    }
+}
+
+/* 多字符运算符长度（不更新prev_token），不是多字符运算符返回0 */
+static size_t prescan_multi_char_op(const Prescan *ps) {
+    char c0 = prescan_peek(ps, 0);
+    char c1 = prescan_peek(ps, 1);
+    char c2 = prescan_peek(ps, 2);
+
+    if (c0 == '>' && c1 == '>' && c2 == '>') {
+        return prescan_peek(ps, 3) == '=' ? 4 : 3;
+    }
+    if ((c0 == '=' && c1 == '=' && c2 == '=') ||
+        (c0 == '!' && c1 == '=' && c2 == '=') ||
+        (c0 == '.' && c1 == '.' && c2 == '.') ||
+        (c0 == '*' && c1 == '*' && c2 == '=') ||
+        (c0 == '&' && c1 == '&' && c2 == '=') ||
+        (c0 == '|' && c1 == '|' && c2 == '=') ||
+        (c0 == '?' && c1 == '?' && c2 == '=')) {
+        return 3;
+    }
+    if ((c0 == '<' && c1 == '<') || (c0 == '>' && c1 == '>')) {
+        return c2 == '=' ? 3 : 2;
+    }
+    if (c0 != '\0' && c1 == '=' && strchr("=!<>+-*/%&|^", c0)) return 2;
+    if ((c0 == '&' && c1 == '&') || (c0 == '|' && c1 == '|') ||
+        (c0 == '?' && c1 == '?') || (c0 == '+' && c1 == '+') ||
+        (c0 == '-' && c1 == '-') || (c0 == '*' && c1 == '*') ||
+        (c0 == '=' && c1 == '>') || (c0 == '?' && c1 == '.')) {
+        return 2;
+    }
+    return 0;
+}
+
+/* 计算从from到to之间经过的行列变化 */
+static void advance_position(const char *src, size_t from, size_t to, Position *pos) {
+    for (size_t i = from; i < to; i++) {
+        char ch = src[i];
+        if (ch == '\n' || (ch == '\r' && !(i + 1 < to && src[i + 1] == '\n'))) {
+            pos->line++;
+            pos->column = 1;
+        } else if (ch != '\r') {
+            pos->column++;
+        }
+    }
+    pos->offset = (int)to;
+}
+
+static bool region_list_push(RegionList *list, size_t start, Position position) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 16;
+        ParseRegion *regions = (ParseRegion*)realloc(list->regions,
+                                                     capacity * sizeof(ParseRegion));
+        if (!regions) return false;
+        list->regions = regions;
+        list->capacity = capacity;
+    }
+
+    ParseRegion *region = &list->regions[list->count++];
+    region->start = start;
+    region->end = start;
+    region->position = position;
+    return true;
+}
+
+/* 将源码划分为可独立解析的顶层区域；任何无法识别的输入都会使后续部分并入最后一个区域 */
+bool region_list_split(RegionList *list, const char *source, size_t length,
+                       size_t min_region_size) {
+    Prescan ps = {source, length, 0, false, 0, {0}};
+    Position position = {1, 1, 0};
+    size_t last_start = 0;
+    int depth = 0;
+    PrevKind prev = PREV_NONE;
+    char last_token = '\0';     /* 上一个token若为 ; 或 } 则记录之 */
+
+    list->count = 0;
+    if (!region_list_push(list, 0, position)) return false;
+
+    while (ps.pos < length) {
+        if (!prescan_skip_trivia(&ps)) break;
+        if (ps.pos >= length) break;
+
+        bool had_newline = ps.newline;
+        ps.newline = false;
+        size_t token_start = ps.pos;
+        unsigned char ch = (unsigned char)source[ps.pos++];
+        char token = '\0';
+
+        if (prescan_is_id_start(ch)) {
+            while (ps.pos < length) {
+                unsigned char c = (unsigned char)source[ps.pos];
+                if (c == '\\') break;   /* 标识符中的转义：交给真实的词法分析器 */
+                if (!prescan_is_id_continue(c)) break;
+                ps.pos++;
+            }
+            if (ps.pos < length && source[ps.pos] == '\\') break;
+
+            bool split_point, regex_ok;
+            prescan_classify_word(source + token_start, ps.pos - token_start,
+                                  &split_point, &regex_ok);
+            if (split_point && depth == 0 &&
+                (last_token == ';' || (last_token == '}' && had_newline)) &&
+                token_start - last_start >= min_region_size) {
+                advance_position(source, last_start, token_start, &position);
+                list->regions[list->count - 1].end = token_start;
+                if (!region_list_push(list, token_start, position)) return false;
+                last_start = token_start;
+            }
+            prev = regex_ok ? PREV_REGEX_OK : PREV_OTHER;
+        } else if (isdigit(ch)) {
+            prescan_skip_number(&ps, (char)ch);
+            prev = PREV_OTHER;
+        } else if (ch == '"' || ch == '\'') {
+            if (!prescan_skip_quoted(&ps, (char)ch, false)) break;
+            prev = PREV_OTHER;
+        } else if (ch == '`') {
+            if (!prescan_skip_template(&ps, &depth, &prev)) break;
+        } else if (ch == '}' && ps.templates > 0 &&
+                   depth - 1 == ps.template_depth[ps.templates - 1]) {
+            /* 与 ${ 配对的 } ：模板的下一段 */
+            depth--;
+            ps.templates--;
+            if (!prescan_skip_template(&ps, &depth, &prev)) break;
+        } else {
+            ps.pos--;
+            size_t op_len = prescan_multi_char_op(&ps);
+            if (op_len > 0) {
+                ps.pos += op_len;
+            } else {
+                ps.pos++;
+                switch (ch) {
+                    case '(': case '[': case '{':
+                        depth++;
+                        prev = PREV_REGEX_OK;
+                        break;
+                    case ')': case ']': case '}':
+                        depth--;
+                        prev = PREV_OTHER;
+                        break;
+                    case '=': case '!': case '~': case '?': case ',':
+                    case ';': case ':': case '<': case '>':
+                        prev = PREV_REGEX_OK;
+                        break;
+                    case '.': case '+': case '-': case '*': case '%':
+                    case '&': case '|': case '^':
+                        prev = PREV_OTHER;
+                        break;
+                    case '/':
+                        if (prev == PREV_REGEX_OK && !prescan_skip_regex(&ps)) {
+                            goto done;
+                        }
+                        prev = PREV_OTHER;
+                        break;
+                    default:
+                        /* 非法字符：之后的内容由真实解析器处理 */
+                        goto done;
+                }
+                token = (char)ch;
+            }
+            if (depth < 0) break;
+        }
+
+        last_token = token;
+    }
+
+done:
+    list->regions[list->count - 1].end = length;
+    return true;
+}
+
+/* 释放区域列表 */
+void region_list_free(RegionList *list) {
+    if (list) {
+        free(list->regions);
+        list->regions = NULL;
+        list->count = list->capacity = 0;
+    }
+}
+
+/* 解析源码的 [start, end) 部分，位置信息从position开始计算 */
+bool parse_source_range(const char *source, size_t start, size_t end,
+                        Position position, bool module, Ast *ast, ErrorInfo *error) {
+    Lexer *lexer = lexer_create_at(source + start, end - start, position, error);
+    if (!lexer) {
+        set_error(error, ERROR_OUT_OF_MEMORY, position, "Out of memory");
+        return false;
+    }
+
+    Parser *parser = parser_create(lexer, error);
+    if (!parser) {
+        lexer_destroy(lexer);
+        set_error(error, ERROR_OUT_OF_MEMORY, position, "Out of memory");
+        return false;
+    }
+
+    parser->module = module;
+    if (ast) {
+        if (!ast_init(ast, end - start)) {
+            parser_destroy(parser);
+            lexer_destroy(lexer);
+            set_error(error, ERROR_OUT_OF_MEMORY, position, "Out of memory");
+            return false;
+        }
+        parser->ast = ast;
+    }
+
+    bool success = parser_parse(parser) && error->code == ERROR_NONE;
+    if (success && ast && ast->failed) {
+        set_error(error, ERROR_OUT_OF_MEMORY, position, "Out of memory");
+        success = false;
+    }
+
+    parser_destroy(parser);
+    lexer_destroy(lexer);
+    if (!success && ast) {
+        ast_free(ast);
+    }
+    return success;
+}
+
+/* 单个区域的解析任务 */
+typedef struct {
+    const char *source;
+    const ParseRegion *region;
+    bool module;
+    bool build_ast;         /* 同时构建本区域的AST */
+    Ast ast;
+    size_t index;
+    atomic_size_t *first_failed;    /* 已知失败区域的最小下标 */
+    ErrorInfo error;
+    bool success;
+} RegionTask;
+
+static void region_task_run(void *arg) {
+    RegionTask *task = (RegionTask*)arg;
+
+    /* 更早的区域已经失败，本区域的结果不会被使用 */
+    if (atomic_load(task->first_failed) < task->index) {
+        task->success = true;
+        return;
+    }
+
+    task->success = parse_source_range(task->source, task->region->start,
+                                       task->region->end, task->region->position,
+                                       task->module, task->build_ast ? &task->ast : NULL,
+                                       &task->error);
+    if (!task->success) {
+        size_t current = atomic_load(task->first_failed);
+        while (task->index < current &&
+               !atomic_compare_exchange_weak(task->first_failed, &current, task->index)) {
+        }
+    }
+}
+
+/* 并行解析：按顶层区域分发到线程池；若某区域失败，从最早的失败区域起串行重新解析，
+   从而得到与整体串行解析完全相同的第一个错误 */
+bool parallel_parse(const char *source, size_t length, int thread_count, bool module,
+                    Ast *ast, ErrorInfo *error) {
+    Position origin = {1, 1, 0};
+
+    if (thread_count <= 0) thread_count = threadpool_cpu_count();
+    if (thread_count == 1 || length < PARALLEL_MIN_FILE_SIZE) {
+        return parse_source_range(source, 0, length, origin, module, ast, error);
+    }
+
+    size_t min_region_size = length / ((size_t)thread_count * 4);
+    if (min_region_size < PARALLEL_MIN_REGION_SIZE) {
+        min_region_size = PARALLEL_MIN_REGION_SIZE;
+    }
+
+    RegionList regions = {0};
+    if (!region_list_split(&regions, source, length, min_region_size) ||
+        regions.count <= 1) {
+        region_list_free(&regions);
+        return parse_source_range(source, 0, length, origin, module, ast, error);
+    }
+
+    RegionTask *tasks = (RegionTask*)calloc(regions.count, sizeof(RegionTask));
+    ThreadPool *pool = tasks ? threadpool_create(thread_count) : NULL;
+    if (!pool) {
+        free(tasks);
+        region_list_free(&regions);
+        return parse_source_range(source, 0, length, origin, module, ast, error);
+    }
+
+    atomic_size_t first_failed = regions.count;
+    for (size_t i = 0; i < regions.count; i++) {
+        tasks[i].source = source;
+        tasks[i].region = &regions.regions[i];
+        tasks[i].module = module;
+        tasks[i].build_ast = ast != NULL;
+        tasks[i].index = i;
+        tasks[i].first_failed = &first_failed;
+        if (!threadpool_submit(pool, region_task_run, &tasks[i])) {
+            /* 提交失败（任务队列内存不足）时在当前线程解析，区域不能被跳过 */
+            region_task_run(&tasks[i]);
+        }
+    }
+    threadpool_wait(pool);
+    threadpool_destroy(pool);
+
+    bool success = true;
+    size_t failed = atomic_load(&first_failed);
+    if (failed < regions.count) {
+        /* 区域末尾的EOF可能掩盖真实的错误位置，因此从失败区域开始串行重放 */
+        const ParseRegion *region = &regions.regions[failed];
+        success = parse_source_range(source, region->start, length,
+                                     region->position, module, NULL, error);
+        if (success && ast) {
+            success = parse_source_range(source, 0, length, origin, module, ast, error);
+        }
+    } else if (ast) {
+        /* 各区域的语句按顺序接到第一个区域的Program之后 */
+        *ast = tasks[0].ast;
+        tasks[0].ast.nodes = NULL;
+        for (size_t i = 1; i < regions.count && success; i++) {
+            success = ast_append_program(ast, &tasks[i].ast);
+        }
+        if (!success) {
+            ast_free(ast);
+            set_error(error, ERROR_OUT_OF_MEMORY, origin, "Out of memory");
+        }
+    }
+
+    for (size_t i = 0; i < regions.count; i++) {
+        ast_free(&tasks[i].ast);
+    }
+    free(tasks);
+    region_list_free(&regions);
+    return success;
+}
@@ -0,0 +1,40 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "common.h"
+#include "ast.h"
+
+/* 小于该大小的文件直接串行解析 */
+#define PARALLEL_MIN_FILE_SIZE   (1u << 20)
+/* 单个区域的最小大小 */
+#define PARALLEL_MIN_REGION_SIZE (64u << 10)
+
+/* 可独立解析的顶层区域 [start, end) */
+typedef struct {
+    size_t start;           /* 起始偏移 */
+    size_t end;             /* 结束偏移（不含） */
+    Position position;      /* 起始位置（行列） */
+} ParseRegion;
+
+/* 区域列表 */
+typedef struct {
+    ParseRegion *regions;
+    size_t count;
+    size_t capacity;
+} RegionList;
+
+/* 顶层区域划分 */
+bool region_list_split(RegionList *list, const char *source, size_t length,
+                       size_t min_region_size);
+void region_list_free(RegionList *list);
+
+/* 解析从某个区域起始到end为止的源码；ast非NULL时同时构建AST（节点偏移相对整个源码） */
+bool parse_source_range(const char *source, size_t start, size_t end,
+                        Position position, bool module, Ast *ast, ErrorInfo *error);
+
+/* 并行解析整个文件（结果与串行解析完全一致，包括第一个错误）。
+   ast非NULL时成功后*ast为整个文件的AST（各区域的树按顺序合并），由调用者ast_free */
+bool parallel_parse(const char *source, size_t length, int thread_count, bool module,
+                    Ast *ast, ErrorInfo *error);
+
+#endif /* PARALLEL_H */
@@ -0,0 +1,351 @@
+#include "parallel_lexer.h"
+#include "threadpool.h"
+
+/*
+ * 推测式并行词法分析
+ *
+ * 词法分析器在两个token之间的全部状态是：偏移、正则/除法上下文、换行标志，
+ * 以及行列位置（行列可以事后平移修正）。源码被切成若干块，每块在不同的
+ * 入口假设下（代码、字符串内、模板内、注释内、正则内）各分析一遍，并记录
+ * 每个token边界处的状态。拼接时，前一块的真实出口状态若与本块某次分析中的
+ * 某个边界状态相同，则此后的token必然与串行分析一致，直接采用；否则从该
+ * 出口状态起串行补分析本块。
+ * 模板替换 ${} 之中的状态还包括外层模板的嵌套，这样的边界不参与比较；
+ * 分析到块尾时若仍在替换之中，就继续到替换结束，使出口状态总在模板之外。
+ */
+
+/* token边界处的词法状态 */
+typedef struct {
+    size_t offset;          /* 边界偏移（上一个token结束处） */
+    Position position;      /* 该处的位置（行列相对于本次分析的起点） */
+    bool regex_allowed;     /* 其后的 / 是否开始正则表达式 */
+    bool newline;           /* last_was_newline */
+    bool in_template;       /* 位于模板替换 ${} 中 */
+} LexBoundary;
+
+/* 某个入口假设下的一次分析 */
+typedef struct {
+    TokenArray tokens;
+    LexBoundary *bounds;    /* bounds[k]为第k个token之前的状态，共tokens.count+1项 */
+    size_t bound_count;
+    size_t bound_capacity;
+    bool failed;            /* 以词法错误结束 */
+    ErrorInfo error;
+    int merged_run;         /* 与之汇合的先前分析下标，-1表示未汇合 */
+    size_t merged_at;       /* 汇合点在本分析中的边界下标 */
+    size_t merged_target;   /* 汇合点在目标分析中的边界下标 */
+} LexRun;
+
+/* 一个块 */
+typedef struct {
+    const char *source;
+    size_t length;
+    size_t start;
+    size_t end;
+    LexRun runs[PARALLEL_LEX_MAX_RUNS];
+    int run_count;
+} LexChunk;
+
+static bool boundary_push(LexRun *run, const Lexer *lexer, size_t base) {
+    if (run->bound_count == run->bound_capacity) {
+        size_t capacity = run->bound_capacity ? run->bound_capacity * 2 : 256;
+        LexBoundary *bounds = (LexBoundary*)realloc(run->bounds,
+                                                    capacity * sizeof(LexBoundary));
+        if (!bounds) return false;
+        run->bounds = bounds;
+        run->bound_capacity = capacity;
+    }
+
+    LexBoundary *b = &run->bounds[run->bound_count++];
+    b->offset = base + lexer->current;
+    b->position = lexer->position;
+    b->regex_allowed = lexer_regex_allowed(lexer);
+    b->newline = lexer->last_was_newline;
+    b->in_template = lexer_in_template(lexer);
+    return true;
+}
+
+static bool boundary_same_state(const LexBoundary *a, const LexBoundary *b) {
+    return a->offset == b->offset && a->regex_allowed == b->regex_allowed &&
+           a->newline == b->newline && !a->in_template && !b->in_template;
+}
+
+/* 在run的边界[0, limit]中二分查找与key状态相同的边界 */
+static bool run_find_boundary(const LexRun *run, const LexBoundary *key, size_t *index) {
+    size_t lo = 0;
+    size_t hi = run->merged_run >= 0 ? run->merged_at + 1 : run->bound_count;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (run->bounds[mid].offset < key->offset) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo < run->bound_count && boundary_same_state(&run->bounds[lo], key)) {
+        *index = lo;
+        return true;
+    }
+    return false;
+}
+
+/* 从start处按给定状态分析，直到越过stop或与已有分析汇合 */
+static void lex_run(LexRun *run, const char *source, size_t length, size_t start,
+                    size_t stop, Position position, bool regex_allowed, bool newline,
+                    LexRun *previous, int previous_count) {
+    memset(run, 0, sizeof(LexRun));
+    run->merged_run = -1;
+
+    Lexer *lexer = lexer_create_at(source + start, length - start, position, &run->error);
+    if (!lexer) {
+        run->failed = true;
+        set_error(&run->error, ERROR_OUT_OF_MEMORY, position, "Out of memory");
+        return;
+    }
+    lexer_set_regex_allowed(lexer, regex_allowed);
+    lexer->last_was_newline = newline;
+    boundary_push(run, lexer, start);
+
+    for (;;) {
+        Token *token = lexer_next_token(lexer);
+        if (!token) {
+            run->failed = true;
+            break;
+        }
+        if (!token_array_push(&run->tokens, token) || !boundary_push(run, lexer, start)) {
+            token_destroy(token);
+            run->failed = true;
+            set_error(&run->error, ERROR_OUT_OF_MEMORY, lexer->position, "Out of memory");
+            break;
+        }
+        if (token->type == TOKEN_EOF) break;
+
+        /* 最后一块需要一直分析到EOF token */
+        const LexBoundary *last = &run->bounds[run->bound_count - 1];
+        if (last->offset >= stop && stop < length && !last->in_template) break;
+
+        /* 与先前的分析进入相同状态后，结果必然相同，不必继续 */
+        for (int p = 0; p < previous_count; p++) {
+            size_t index;
+            if (run_find_boundary(&previous[p], last, &index)) {
+                run->merged_run = p;
+                run->merged_at = run->bound_count - 1;
+                run->merged_target = index;
+                break;
+            }
+        }
+        if (run->merged_run >= 0) break;
+    }
+
+    lexer_destroy(lexer);
+}
+
+static void lex_run_free(LexRun *run) {
+    for (size_t i = 0; i < run->tokens.count; i++) {
+        if (run->tokens.tokens[i]) token_destroy(run->tokens.tokens[i]);
+    }
+    free(run->tokens.tokens);
+    free(run->bounds);
+    memset(run, 0, sizeof(LexRun));
+}
+
+/* 从from开始跳过到第一个未转义的终止字符之后；找不到返回length */
+static size_t skip_past(const char *source, size_t length, size_t from, char terminator) {
+    for (size_t i = from; i < length; i++) {
+        if (source[i] == '\\') {
+            i++;
+        } else if (source[i] == terminator) {
+            return i + 1;
+        }
+    }
+    return length;
+}
+
+static size_t skip_past_comment(const char *source, size_t length, size_t from) {
+    for (size_t i = from; i + 1 < length; i++) {
+        if (source[i] == '*' && source[i + 1] == '/') return i + 2;
+    }
+    return length;
+}
+
+static size_t skip_past_newline(const char *source, size_t length, size_t from) {
+    for (size_t i = from; i < length; i++) {
+        if (source[i] == '\n' || source[i] == '\r') return i;
+    }
+    return length;
+}
+
+/* 工作线程：在各入口假设下分析一个块 */
+static void lex_chunk_task(void *arg) {
+    LexChunk *chunk = (LexChunk*)arg;
+    const char *src = chunk->source;
+    size_t len = chunk->length;
+    size_t s = chunk->start;
+
+    /* 入口假设：起点与正则上下文 */
+    struct { size_t start; bool regex; } entries[PARALLEL_LEX_MAX_RUNS];
+    int count = 0;
+    entries[count].start = s; entries[count++].regex = false;          /* 代码 */
+    entries[count].start = s; entries[count++].regex = true;
+    entries[count].start = skip_past(src, len, s, '"'); entries[count++].regex = false;
+    entries[count].start = skip_past(src, len, s, '\''); entries[count++].regex = false;
+    entries[count].start = skip_past(src, len, s, '`'); entries[count++].regex = false;
+    entries[count].start = skip_past(src, len, s, '/'); entries[count++].regex = false;
+    size_t after_comment = skip_past_comment(src, len, s);
+    entries[count].start = after_comment; entries[count++].regex = false;
+    entries[count].start = after_comment; entries[count++].regex = true;
+    size_t after_line = skip_past_newline(src, len, s);
+    entries[count].start = after_line; entries[count++].regex = false;
+    entries[count].start = after_line; entries[count++].regex = true;
+
+    chunk->run_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (entries[i].start >= chunk->end) continue;
+        Position position = {1, 1, (int)entries[i].start};
+        lex_run(&chunk->runs[chunk->run_count], src, len, entries[i].start, chunk->end,
+                position, entries[i].regex, false, chunk->runs, chunk->run_count);
+        chunk->run_count++;
+    }
+}
+
+/* 将相对于boundary位置rel的坐标平移到绝对坐标abs */
+static Position map_position(Position p, Position rel, Position abs) {
+    Position result = p;
+    if (p.line == rel.line) {
+        result.line = abs.line;
+        result.column = abs.column + (p.column - rel.column);
+    } else {
+        result.line = abs.line + (p.line - rel.line);
+    }
+    return result;
+}
+
+/* 拼接状态：真实的（串行等价的）出口状态 */
+typedef struct {
+    LexBoundary exit;       /* position为绝对位置 */
+    TokenArray *out;
+    ErrorInfo *error;
+    bool done;              /* 已遇到EOF或错误 */
+    bool success;
+} StitchState;
+
+/* 从run的第index个边界起，沿汇合链采用token直到该块结束 */
+static void stitch_segment(StitchState *st, LexChunk *chunk, LexRun *run, size_t index) {
+    for (;;) {
+        Position rel = run->bounds[index].position;
+        Position abs = st->exit.position;
+        size_t last = run->merged_run >= 0 ? run->merged_at : run->bound_count - 1;
+
+        for (size_t k = index; k < last; k++) {
+            Token *token = run->tokens.tokens[k];
+            run->tokens.tokens[k] = NULL;
+            token->start = map_position(token->start, rel, abs);
+            token->end = map_position(token->end, rel, abs);
+            if (!token_array_push(st->out, token)) {
+                token_destroy(token);
+                set_error(st->error, ERROR_OUT_OF_MEMORY, token->start, "Out of memory");
+                st->done = true;
+                st->success = false;
+                return;
+            }
+            if (token->type == TOKEN_EOF) st->done = true;
+        }
+
+        st->exit = run->bounds[last];
+        st->exit.position = map_position(run->bounds[last].position, rel, abs);
+
+        if (run->merged_run >= 0) {
+            index = run->merged_target;
+            run = &chunk->runs[run->merged_run];
+            continue;
+        }
+        if (run->failed) {
+            ErrorInfo err = run->error;
+            err.position = map_position(err.position, rel, abs);
+            *st->error = err;
+            st->done = true;
+            st->success = false;
+        }
+        return;
+    }
+}
+
+/* 推测式并行词法分析 */
+bool parallel_tokenize(const char *source, size_t length, int thread_count,
+                       TokenArray *out, ErrorInfo *error) {
+    if (thread_count <= 0) thread_count = threadpool_cpu_count();
+
+    size_t chunk_count = (size_t)thread_count;
+    if (length / PARALLEL_LEX_MIN_CHUNK < chunk_count) {
+        chunk_count = length / PARALLEL_LEX_MIN_CHUNK;
+    }
+    if (thread_count == 1 || chunk_count <= 1) {
+        return lexer_tokenize(source, length, out, error);
+    }
+
+    LexChunk *chunks = (LexChunk*)calloc(chunk_count, sizeof(LexChunk));
+    ThreadPool *pool = chunks ? threadpool_create(thread_count) : NULL;
+    if (!pool) {
+        free(chunks);
+        return lexer_tokenize(source, length, out, error);
+    }
+
+    /* 第0块的入口状态是确定的，由拼接阶段串行处理；其余块并行推测 */
+    for (size_t i = 0; i < chunk_count; i++) {
+        chunks[i].source = source;
+        chunks[i].length = length;
+        chunks[i].start = length / chunk_count * i;
+        chunks[i].end = (i + 1 == chunk_count) ? length : length / chunk_count * (i + 1);
+        if (i > 0 && !threadpool_submit(pool, lex_chunk_task, &chunks[i])) {
+            lex_chunk_task(&chunks[i]);
+        }
+    }
+
+    StitchState st;
+    memset(&st, 0, sizeof(st));
+    st.exit.position.line = 1;
+    st.exit.position.column = 1;
+    st.out = out;
+    st.error = error;
+    st.success = true;
+
+    /* 第0块在主线程上与其他块同时分析 */
+    Position origin = {1, 1, 0};
+    lex_run(&chunks[0].runs[0], source, length, 0, chunks[0].end, origin,
+            false, false, NULL, 0);
+    chunks[0].run_count = 1;
+    threadpool_wait(pool);
+    threadpool_destroy(pool);
+
+    for (size_t i = 0; i < chunk_count && !st.done; i++) {
+        LexChunk *chunk = &chunks[i];
+        if (st.exit.offset >= chunk->end) continue;
+
+        LexRun *run = NULL;
+        size_t index = 0;
+        for (int r = 0; r < chunk->run_count && !run; r++) {
+            if (run_find_boundary(&chunk->runs[r], &st.exit, &index)) {
+                run = &chunk->runs[r];
+            }
+        }
+
+        if (!run) {
+            /* 所有假设都未能同步：从真实出口状态起串行补分析 */
+            if (chunk->run_count == PARALLEL_LEX_MAX_RUNS) {
+                lex_run_free(&chunk->runs[--chunk->run_count]);
+            }
+            run = &chunk->runs[chunk->run_count++];
+            lex_run(run, source, length, st.exit.offset, chunk->end, st.exit.position,
+                    st.exit.regex_allowed, st.exit.newline, NULL, 0);
+            index = 0;
+        }
+
+        stitch_segment(&st, chunk, run, index);
+    }
+
+    for (size_t i = 0; i < chunk_count; i++) {
+        for (int r = 0; r < chunks[i].run_count; r++) {
+            lex_run_free(&chunks[i].runs[r]);
+        }
+    }
+    free(chunks);
+    return st.success;
+}
@@ -0,0 +1,15 @@
+#ifndef PARALLEL_LEXER_H
+#define PARALLEL_LEXER_H
+
+#include "lexer.h"
+
+/* 小于该大小的输入直接串行分析 */
+#define PARALLEL_LEX_MIN_CHUNK (256u << 10)
+/* 每个块最多尝试的入口状态假设数 */
+#define PARALLEL_LEX_MAX_RUNS 10
+
+/* 推测式并行词法分析：结果（包括错误）与lexer_tokenize完全一致 */
+bool parallel_tokenize(const char *source, size_t length, int thread_count,
+                       TokenArray *out, ErrorInfo *error);
+
+#endif /* PARALLEL_LEXER_H */
@@ -13,6 +13,23 @@ Parser* parser_create(Lexer *lexer, ErrorInfo *error) {
     parser->error = error;
     parser->asi_allowed = true;
     parser->depth = 0;
+    parser->statements = NULL;
+    parser->cover = 0;
+    parser->cover_element = false;
+    parser->cover_pending = 0;
+    parser->cover_position = (Position){1, 1, 0};
+    parser->ast = NULL;
+    parser->node = AST_NONE;
+    parser->on_token = NULL;
+    parser->token_context = NULL;
+    parser->asi_before = false;
+    parser->module = false;
+    parser->in_async = false;
+    parser->in_generator = false;
+    parser->nesting = 0;
+    parser->no_in = 0;
+    parser->reuse = NULL;
+    parser->reuse_from = 0;
     
     /* 读取第一个token */
     parser_advance(parser);
@@ -36,6 +53,20 @@ void parser_destroy(Parser *parser) {
 /* 前进到下一个token */
 bool parser_advance(Parser *parser) {
     if (parser->current_token) {
+        if (parser->on_token) {
+            parser->on_token(parser->token_context, parser->current_token, parser->asi_before);
+        }
+        parser->asi_before = false;
+        switch (parser->current_token->type) {
+            case TOKEN_LPAREN: case TOKEN_LBRACKET: case TOKEN_LBRACE:
+                parser->nesting++;
+                break;
+            case TOKEN_RPAREN: case TOKEN_RBRACKET: case TOKEN_RBRACE:
+                parser->nesting--;
+                break;
+            default:
+                break;
+        }
         if (parser->prev_token) {
             token_destroy(parser->prev_token);
         }
@@ -45,6 +76,12 @@ bool parser_advance(Parser *parser) {
     parser->current_token = lexer_next_token(parser->lexer);
     
     if (!parser->current_token) {
+        /* 词法错误：用错误token占位，避免后续解析解引用空指针 */
+        parser->current_token = (Token*)calloc(1, sizeof(Token));
+        if (!parser->current_token) return false;
+        parser->current_token->type = TOKEN_ERROR;
+        parser->current_token->start = parser->lexer->position;
+        parser->current_token->end = parser->lexer->position;
         return false;
     }
     
@@ -140,6 +177,7 @@ bool parser_consume_semicolon(Parser *parser) {
     /* 检查ASI条件 */
     if (parser_check_asi(parser)) {
         /* ASI成功，不需要消耗token */
+        parser->asi_before = true;
         return true;
     }
     
@@ -210,6 +248,8 @@ bool is_statement_start(TokenType type) {
         case TOKEN_CONTINUE:
         case TOKEN_THROW:
         case TOKEN_TRY:
+        case TOKEN_WITH:
+        case TOKEN_DEBUGGER:
         case TOKEN_LBRACE:
         case TOKEN_SEMICOLON:
             return true;
@@ -218,21 +258,386 @@ bool is_statement_start(TokenType type) {
     }
 }
 
+/* 以 ${ 结束的模板字符串的一段 */
+static bool opens_substitution(const Token *token) {
+    return token->type == TOKEN_TEMPLATE && token->value && token->value[token->length - 1] == '{';
+}
+
+/* 当前token开始的语句是否位于模板替换 ${} 中：词法分析器已经读入了这个token，
+   它若以 ${ 结束，其后的替换不算在外面 */
+static bool statement_in_template(const Parser *parser) {
+    int templates = parser->lexer->templates;
+    if (opens_substitution(parser->current_token)) templates--;
+    return templates > 0;
+}
+
+/* 开始记录一条语句，返回其下标 */
+static size_t statement_begin(Parser *parser) {
+    StatementTable *table = parser->statements;
+    if (table->failed) return STATEMENT_NONE;
+
+    if (table->count == table->capacity) {
+        size_t capacity = table->capacity ? table->capacity * 2 : 256;
+        StatementSpan *spans = (StatementSpan*)realloc(table->spans,
+                                                       capacity * sizeof(StatementSpan));
+        if (!spans) {
+            table->failed = true;
+            return STATEMENT_NONE;
+        }
+        table->spans = spans;
+        table->capacity = capacity;
+    }
+
+    Token *first = parser->current_token;
+    StatementSpan *span = &table->spans[table->count];
+    memset(span, 0, sizeof(*span));
+    span->start = (size_t)first->start.offset;
+    span->parent = table->open;
+    span->depth = parser->depth - 1;    /* parse_statement已经增加了深度 */
+    span->in_async = parser->in_async;
+    span->in_generator = parser->in_generator;
+    span->in_template = statement_in_template(parser);
+    span->first_type = first->type;
+    span->first_length = first->length;
+    span->first_newline = first->preceded_by_newline;
+    span->first_regex = lexer_regex_allowed(parser->lexer);
+
+    table->open = table->count;
+    return table->count++;
+}
+
+/* 结束记录一条语句 */
+static void statement_end(Parser *parser, size_t index) {
+    StatementTable *table = parser->statements;
+    StatementSpan *span = &table->spans[index];
+    Token *follow = parser->current_token;
+
+    span->end = (size_t)follow->start.offset;
+    span->subtree_end = table->count;
+    span->last_type = parser->prev_token ? parser->prev_token->type : TOKEN_EOF;
+    span->follow_type = follow->type;
+    span->follow_length = follow->length;
+    span->follow_newline = follow->preceded_by_newline;
+    span->follow_regex = lexer_regex_allowed(parser->lexer);
+
+    table->open = span->parent;
+    table->last = index;
+}
+
+/*
+ * 复用未改动的语句：当前token是parser->reuse中某条语句的第一个token，且词法上下文相同时，
+ * 这条语句的解析结果只取决于它自己的文本（以及await/yield是否为运算符），不必重新解析。复制它（及内层语句）的范围记录，
+ * 让词法分析器直接从其后的第一个token继续。语句可以位于不同的嵌套深度（例如前面新输入了
+ * 一个还没有配对的 {）：只要内层语句不会因此超过递归深度上限，模块中也不含import/export。
+ */
+static bool reuse_statement(Parser *parser) {
+    const StatementTable *old = parser->reuse;
+    StatementTable *table = parser->statements;
+    Token *first = parser->current_token;
+    size_t start = (size_t)first->start.offset;
+
+    if (!table || table->failed || parser->ast || parser->on_token ||
+        start < parser->reuse_from || old->count == 0) {
+        return false;
+    }
+
+    /* 起点等于start的最外层语句 */
+    size_t low = 0;
+    size_t high = old->count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (old->spans[mid].start < start) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low == old->count) return false;
+    const StatementSpan *span = &old->spans[low];
+    if (span->start != start || span->first_type != first->type ||
+        span->first_length != first->length ||
+        span->first_newline != first->preceded_by_newline ||
+        span->first_regex != lexer_regex_allowed(parser->lexer) ||
+        span->in_async != parser->in_async || span->in_generator != parser->in_generator ||
+        span->in_template != statement_in_template(parser)) {
+        return false;
+    }
+
+    int depth = parser->depth - 1;
+    int deepest = span->depth;
+    for (size_t i = low; i < span->subtree_end; i++) {
+        const StatementSpan *inner = &old->spans[i];
+        if (inner->depth > deepest) deepest = inner->depth;
+        if (parser->module && depth != span->depth &&
+            (inner->first_type == TOKEN_IMPORT || inner->first_type == TOKEN_EXPORT)) {
+            return false;
+        }
+    }
+    if (depth + (deepest - span->depth) + 1 > MAX_RECURSION_DEPTH) return false;
+
+    size_t count = span->subtree_end - low;
+    if (table->count + count > table->capacity) {
+        size_t capacity = table->capacity ? table->capacity * 2 : 256;
+        while (capacity < table->count + count) capacity *= 2;
+        StatementSpan *spans = (StatementSpan*)realloc(table->spans,
+                                                       capacity * sizeof(StatementSpan));
+        if (!spans) {
+            table->failed = true;
+            return false;
+        }
+        table->spans = spans;
+        table->capacity = capacity;
+    }
+
+    size_t base = table->count;
+    for (size_t i = 0; i < count; i++) {
+        StatementSpan *copy = &table->spans[base + i];
+        *copy = old->spans[low + i];
+        copy->parent = i == 0 ? table->open : copy->parent - low + base;
+        copy->subtree_end = copy->subtree_end - low + base;
+        copy->depth += depth - span->depth;
+    }
+    table->spans[base].in_list = false;
+    table->count += count;
+    table->last = base;
+
+    /* 越过语句：first改作语句的最后一个token（成为prev_token），从其后的第一个token继续。
+       语句中的 { } 和模板的各段是配对的，已经读入的first对它们的计数要撤销 */
+    Lexer *lexer = parser->lexer;
+    if (first->type == TOKEN_LBRACE) {
+        lexer->braces--;
+    } else if (opens_substitution(first)) {
+        lexer->templates--;
+    }
+    lexer->current += span->end - (size_t)lexer->position.offset;
+    lexer->position.offset = (int)span->end;
+    lexer->last_was_newline = span->follow_newline;
+    lexer_set_regex_allowed(lexer, can_precede_regex(span->last_type));
+    first->type = span->last_type;
+    first->start.offset = (int)span->end;
+    first->end.offset = (int)span->end;
+
+    parser_advance(parser);
+    Token *follow = parser->current_token;
+    if (follow->type != span->follow_type || follow->length != span->follow_length ||
+        follow->preceded_by_newline != span->follow_newline) {
+        table->failed = true;   /* 不会发生：同样的文本和上下文 */
+        return false;
+    }
+    parser->cover = 0;
+    return true;
+}
+
+/* 释放语句范围表 */
+void statement_table_free(StatementTable *table) {
+    if (table) {
+        free(table->spans);
+        table->spans = NULL;
+        table->count = table->capacity = 0;
+    }
+}
+
+/* 解析语句列表中的一条语句（记录范围时标记其位于列表中） */
+static bool parse_list_statement(Parser *parser) {
+    if (!parse_statement(parser)) {
+        return false;
+    }
+    if (parser->statements && !parser->statements->failed) {
+        parser->statements->spans[parser->statements->last].in_list = true;
+    }
+    return true;
+}
+
+/* 创建节点：范围为 [start, end)，子节点链表从first_child开始 */
+static uint32_t build_node_at(Parser *parser, AstKind kind, int op, size_t start,
+                              size_t end, uint32_t first_child) {
+    if (!parser->ast) return AST_NONE;
+    
+    uint32_t node = ast_add(parser->ast, kind, op, start, end);
+    if (node != AST_NONE) {
+        parser->ast->nodes[node].first_child = first_child;
+    }
+    return node;
+}
+
+/* 创建从start开始、到上一个token结束的节点 */
+static uint32_t build_node(Parser *parser, AstKind kind, int op, size_t start,
+                           uint32_t first_child) {
+    if (!parser->ast) return AST_NONE;
+    
+    size_t end = parser->prev_token ? (size_t)parser->prev_token->end.offset : start;
+    return build_node_at(parser, kind, op, start, end, first_child);
+}
+
+/* 创建覆盖上一个token的节点（标识符、字面量等） */
+static uint32_t build_token(Parser *parser, AstKind kind, int op) {
+    if (!parser->ast) return AST_NONE;
+    
+    return build_node_at(parser, kind, op, (size_t)parser->prev_token->start.offset,
+                         (size_t)parser->prev_token->end.offset, AST_NONE);
+}
+
+/* 创建缺省子节点的占位（输出为null） */
+static uint32_t build_null(Parser *parser) {
+    if (!parser->ast) return AST_NONE;
+    
+    size_t offset = (size_t)parser->current_token->start.offset;
+    return build_node_at(parser, AST_NULL, 0, offset, offset, AST_NONE);
+}
+
+/* 创建有两个子节点的节点 */
+static uint32_t build_pair(Parser *parser, AstKind kind, int op, size_t start,
+                           uint32_t first, uint32_t second) {
+    if (!parser->ast) return AST_NONE;
+    
+    AstList children = {AST_NONE, AST_NONE};
+    ast_list_push(parser->ast, &children, first);
+    ast_list_push(parser->ast, &children, second);
+    return build_node(parser, kind, op, start, children.first);
+}
+
+/* 复制一个没有子节点的节点（简写属性的键和值需要两个节点） */
+static uint32_t build_copy(Parser *parser, uint32_t node) {
+    if (!parser->ast || node == AST_NONE) return AST_NONE;
+    
+    AstNode source = parser->ast->nodes[node];
+    return build_node_at(parser, (AstKind)source.kind, source.op, source.start,
+                         source.end, AST_NONE);
+}
+
+/* 追加子节点 */
+static void push_node(Parser *parser, AstList *list, uint32_t node) {
+    if (parser->ast) {
+        ast_list_push(parser->ast, list, node);
+    }
+}
+
+/* 设置节点标志 */
+static void set_node_flags(Parser *parser, uint32_t node, int flags) {
+    if (parser->ast && node != AST_NONE) {
+        parser->ast->nodes[node].flags |= (uint16_t)flags;
+    }
+}
+
+/* 把节点的结束位置延伸到上一个token（包括语句末尾的分号） */
+static void extend_node(Parser *parser, uint32_t node) {
+    if (parser->ast && node != AST_NONE && parser->prev_token) {
+        parser->ast->nodes[node].end = (uint32_t)parser->prev_token->end.offset;
+    }
+}
+
+/* 当前token的起始偏移 */
+static size_t token_offset(Parser *parser) {
+    return (size_t)parser->current_token->start.offset;
+}
+
+/* 是否为IdentifierName（属性名中可以使用关键字） */
+static bool is_identifier_name(TokenType type) {
+    return type == TOKEN_IDENTIFIER || (type >= TOKEN_TRUE && type <= TOKEN_SET);
+}
+
+/* 当前token之后的第一个非空白、非注释字符（不移动词法分析器） */
+static char peek_char(Parser *parser) {
+    const char *src = parser->lexer->source;
+    size_t length = parser->lexer->source_length;
+    size_t pos = parser->lexer->current;
+    
+    while (pos < length) {
+        char ch = src[pos];
+        if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\v' || ch == '\f') {
+            pos++;
+        } else if (ch == '/' && pos + 1 < length && src[pos + 1] == '/') {
+            while (pos < length && src[pos] != '\n' && src[pos] != '\r') pos++;
+        } else if (ch == '/' && pos + 1 < length && src[pos + 1] == '*') {
+            pos += 2;
+            while (pos + 1 < length && !(src[pos] == '*' && src[pos + 1] == '/')) pos++;
+            pos += 2;
+        } else {
+            return ch;
+        }
+    }
+    return '\0';
+}
+
+/* 当前token是否为给定的上下文关键字（as、from、meta等按标识符词法分析） */
+static bool check_word(Parser *parser, const char *word) {
+    size_t length = strlen(word);
+    return parser_check(parser, TOKEN_IDENTIFIER) &&
+           parser->current_token->length == length &&
+           memcmp(parser->current_token->value, word, length) == 0;
+}
+
+/* 期望上下文关键字 */
+static bool expect_word(Parser *parser, const char *word) {
+    if (check_word(parser, word)) {
+        parser_advance(parser);
+        return true;
+    }
+    
+    char msg[256];
+    snprintf(msg, sizeof(msg), "Expected '%s'", word);
+    set_error(parser->error, ERROR_PARSER_EXPECTED_TOKEN, parser->current_token->start, msg);
+    return false;
+}
+
+/* 当前token之后是否在同一行紧跟function关键字（async function，不移动词法分析器） */
+static bool peek_function(Parser *parser) {
+    const char *src = parser->lexer->source;
+    size_t length = parser->lexer->source_length;
+    size_t pos = parser->lexer->current;
+    
+    while (pos < length && (src[pos] == ' ' || src[pos] == '\t')) pos++;
+    if (pos + 8 > length || memcmp(src + pos, "function", 8) != 0) return false;
+    
+    unsigned char next = pos + 8 < length ? (unsigned char)src[pos + 8] : 0;
+    return !(isalnum(next) || next == '_' || next == '$' || next >= 0x80);
+}
+
+/* 是否可以开始一个属性名 */
+static bool is_property_name_start(TokenType type) {
+    return is_identifier_name(type) || type == TOKEN_STRING ||
+           type == TOKEN_NUMBER || type == TOKEN_LBRACKET;
+}
+
 /* 解析程序 */
 bool parse_program(Parser *parser) {
     parser->depth = 0;
-    return parse_statement_list(parser);
+    parser->in_async = parser->module;      /* 模块顶层可以使用await */
+    parser->in_generator = false;
+    if (!parse_statement_list(parser)) {
+        return false;
+    }
+    
+    /* 顶层多余的 } 不能提前结束程序 */
+    if (!parser_check(parser, TOKEN_EOF)) {
+        set_error(parser->error, ERROR_PARSER_UNEXPECTED_TOKEN,
+                 parser->current_token->start, "Unexpected token at top level");
+        return false;
+    }
+    
+    if (parser->ast) {
+        parser->ast->root = build_node_at(parser, AST_PROGRAM, 0, 0,
+                                          (size_t)parser->current_token->end.offset,
+                                          parser->node);
+        set_node_flags(parser, parser->ast->root, parser->module ? AST_FLAG_MODULE : 0);
+    }
+    return true;
 }
 
-/* 解析语句列表 */
+/* 解析语句列表（parser->node为第一条语句，其余语句通过next_sibling串联） */
 bool parse_statement_list(Parser *parser) {
-    while (parser->current_token && 
+    AstList body = {AST_NONE, AST_NONE};
+    
+    while (parser->current_token &&
            parser->current_token->type != TOKEN_EOF &&
            parser->current_token->type != TOKEN_RBRACE) {
-        if (!parse_statement(parser)) {
+        if (!parse_list_statement(parser)) {
             return false;
         }
+        push_node(parser, &body, parser->node);
     }
+    
+    parser->node = body.first;
     return true;
 }
 
@@ -246,6 +651,12 @@ bool parse_statement(Parser *parser) {
     
     if (!parser->current_token) return false;
     
+    if (parser->reuse && reuse_statement(parser)) {
+        parser->depth--;
+        return true;
+    }
+    
+    size_t span = parser->statements ? statement_begin(parser) : STATEMENT_NONE;
     bool result = false;
     
     switch (parser->current_token->type) {
@@ -254,212 +665,955 @@ bool parse_statement(Parser *parser) {
         case TOKEN_CONST:
             result = parse_variable_declaration(parser);
             break;
-            
+    
         case TOKEN_FUNCTION:
             result = parse_function_declaration(parser);
             break;
-            
+    
         case TOKEN_CLASS:
             result = parse_class_declaration(parser);
             break;
-            
+    
+        case TOKEN_ASYNC:
+            /* async function 声明；其余以async开始的是表达式语句 */
+            result = peek_function(parser) ? parse_function_declaration(parser) :
+                                             parse_expression_statement(parser);
+            break;
+    
         case TOKEN_IF:
             result = parse_if_statement(parser);
             break;
-            
+    
         case TOKEN_WHILE:
             result = parse_while_statement(parser);
             break;
-            
+    
         case TOKEN_DO:
             result = parse_do_while_statement(parser);
             break;
-            
+    
         case TOKEN_FOR:
             result = parse_for_statement(parser);
             break;
-            
+    
         case TOKEN_SWITCH:
             result = parse_switch_statement(parser);
             break;
-            
+    
         case TOKEN_RETURN:
             result = parse_return_statement(parser);
             break;
-            
+    
         case TOKEN_BREAK:
             result = parse_break_statement(parser);
             break;
-            
+    
         case TOKEN_CONTINUE:
             result = parse_continue_statement(parser);
             break;
-            
+    
         case TOKEN_THROW:
             result = parse_throw_statement(parser);
             break;
-            
+    
         case TOKEN_TRY:
             result = parse_try_statement(parser);
             break;
-            
+    
+        case TOKEN_WITH:
+            result = parse_with_statement(parser);
+            break;
+    
+        case TOKEN_DEBUGGER:
+            result = parse_debugger_statement(parser);
+            break;
+    
         case TOKEN_LBRACE:
             result = parse_block_statement(parser);
             break;
-            
+    
+        case TOKEN_IMPORT:
+            /* import(...) 和 import.meta 开始表达式语句 */
+            if (peek_char(parser) == '(' || peek_char(parser) == '.') {
+                result = parse_expression_statement(parser);
+            } else {
+                result = parse_import_declaration(parser);
+            }
+            break;
+    
+        case TOKEN_EXPORT:
+            result = parse_export_declaration(parser);
+            break;
+    
         case TOKEN_SEMICOLON:
             /* 空语句 */
             parser_advance(parser);
+            parser->node = build_token(parser, AST_EMPTY_STATEMENT, 0);
             result = true;
             break;
-            
+    
         default:
             /* 表达式语句 */
             result = parse_expression_statement(parser);
             break;
     }
     
+    if (result && span != STATEMENT_NONE) {
+        statement_end(parser, span);
+    }
+    
     parser->depth--;
     return result;
 }
 
-/* 解析变量声明 */
-bool parse_variable_declaration(Parser *parser) {
-    /* var/let/const */
-    parser_advance(parser);
+static bool parse_binding_target(Parser *parser);
+
+/* 解析属性名：标识符（可以是关键字）、字符串、数字或计算属性名 */
+static bool parse_property_name(Parser *parser, bool *computed) {
+    *computed = false;
     
-    /* 至少一个标识符 */
-    if (!parser_expect(parser, TOKEN_IDENTIFIER)) {
+    if (is_identifier_name(parser->current_token->type)) {
+        parser_advance(parser);
+        parser->node = build_token(parser, AST_IDENTIFIER, 0);
+        return true;
+    }
+    
+    if (parser_check(parser, TOKEN_STRING) ||
+        parser_check(parser, TOKEN_NUMBER)) {
+        TokenType type = parser->current_token->type;
+        parser_advance(parser);
+        parser->node = build_token(parser, AST_LITERAL, type);
+        return true;
+    }
+    
+    if (!parser_expect(parser, TOKEN_LBRACKET)) {
         return false;
     }
+    if (!parse_assignment_expression(parser)) {
+        return false;
+    }
+    *computed = true;
+    return parser_expect(parser, TOKEN_RBRACKET);
+}
+
+/* 解析绑定元素：绑定目标及可选的默认值 */
+static bool parse_binding_element(Parser *parser) {
+    size_t start = token_offset(parser);
     
-    /* 可选的初始化 */
-    if (parser_match(parser, TOKEN_ASSIGN)) {
-        if (!parse_assignment_expression(parser)) {
-            return false;
-        }
+    if (!parse_binding_target(parser)) {
+        return false;
     }
     
-    /* 可能有多个声明 */
-    while (parser_match(parser, TOKEN_COMMA)) {
-        if (!parser_expect(parser, TOKEN_IDENTIFIER)) {
+    if (parser_match(parser, TOKEN_ASSIGN)) {
+        uint32_t target = parser->node;
+        if (!parse_assignment_expression(parser)) {
             return false;
         }
-        
-        if (parser_match(parser, TOKEN_ASSIGN)) {
-            if (!parse_assignment_expression(parser)) {
-                return false;
-            }
-        }
+        parser->node = build_pair(parser, AST_ASSIGNMENT_PATTERN, TOKEN_ASSIGN, start,
+                                  target, parser->node);
     }
-    
-    /* 分号（或ASI） */
-    return parser_consume_semicolon(parser);
+    return true;
 }
 
-/* 解析函数声明 */
-bool parse_function_declaration(Parser *parser) {
-    /* function */
-    parser_advance(parser);
+/* 解析剩余元素 ...target */
+static bool parse_binding_rest(Parser *parser) {
+    size_t start = token_offset(parser);
     
-    /* 函数名（可选，用于函数表达式） */
-    if (parser_check(parser, TOKEN_IDENTIFIER)) {
-        parser_advance(parser);
-    }
+    /* ... */
+    parser_advance(parser);
     
-    /* 参数列表 */
-    if (!parser_expect(parser, TOKEN_LPAREN)) {
+    if (!parse_binding_target(parser)) {
         return false;
     }
+    parser->node = build_node(parser, AST_REST_ELEMENT, 0, start, parser->node);
+    return true;
+}
+
+/* 解析数组解构模式 [a, , b = 1, ...rest] */
+static bool parse_array_binding_pattern(Parser *parser) {
+    size_t start = token_offset(parser);
+    AstList elements = {AST_NONE, AST_NONE};
     
-    /* 参数 */
-    if (!parser_check(parser, TOKEN_RPAREN)) {
-        if (!parser_expect(parser, TOKEN_IDENTIFIER)) {
-            return false;
+    /* [ */
+    parser_advance(parser);
+    
+    while (!parser_check(parser, TOKEN_RBRACKET)) {
+        /* 省略的元素 */
+        if (parser_check(parser, TOKEN_COMMA)) {
+            push_node(parser, &elements, build_null(parser));
+            parser_advance(parser);
+            continue;
         }
-        
-        while (parser_match(parser, TOKEN_COMMA)) {
-            if (!parser_expect(parser, TOKEN_IDENTIFIER)) {
+    
+        /* 剩余元素必须是最后一个 */
+        if (parser_check(parser, TOKEN_SPREAD)) {
+            if (!parse_binding_rest(parser)) {
                 return false;
             }
+            push_node(parser, &elements, parser->node);
+            break;
+        }
+    
+        if (!parse_binding_element(parser)) {
+            return false;
+        }
+        push_node(parser, &elements, parser->node);
+        if (!parser_match(parser, TOKEN_COMMA)) {
+            break;
         }
     }
     
-    if (!parser_expect(parser, TOKEN_RPAREN)) {
+    if (!parser_expect(parser, TOKEN_RBRACKET)) {
         return false;
     }
-    
-    /* 函数体 */
-    return parse_block_statement(parser);
+    parser->node = build_node(parser, AST_ARRAY_PATTERN, 0, start, elements.first);
+    return true;
 }
 
-/* 解析类声明 */
-bool parse_class_declaration(Parser *parser) {
-    /* class */
+/* 解析对象解构模式 {a, b: c, d = 1, ...rest} */
+static bool parse_object_binding_pattern(Parser *parser) {
+    size_t start = token_offset(parser);
+    AstList properties = {AST_NONE, AST_NONE};
+    
+    /* { */
     parser_advance(parser);
     
-    /* 类名 */
-    if (!parser_expect(parser, TOKEN_IDENTIFIER)) {
-        return false;
-    }
+    while (!parser_check(parser, TOKEN_RBRACE)) {
+        size_t property_start = token_offset(parser);
     
-    /* extends */
-    if (parser_match(parser, TOKEN_EXTENDS)) {
-        if (!parser_expect(parser, TOKEN_IDENTIFIER)) {
-            return false;
+        /* 剩余属性必须是最后一个 */
+        if (parser_match(parser, TOKEN_SPREAD)) {
+            if (!parser_expect(parser, TOKEN_IDENTIFIER)) {
+                return false;
+            }
+            push_node(parser, &properties,
+                      build_node(parser, AST_REST_ELEMENT, 0, property_start,
+                                 build_token(parser, AST_IDENTIFIER, 0)));
+            break;
         }
-    }
     
-    /* 类体 */
-    if (!parser_expect(parser, TOKEN_LBRACE)) {
-        return false;
-    }
+        bool shorthand = parser_check(parser, TOKEN_IDENTIFIER);
+        bool computed;
+        if (!parse_property_name(parser, &computed)) {
+            return false;
+        }
+        uint32_t key = parser->node;
     
-    /* 成员（简化处理） */
-    while (!parser_check(parser, TOKEN_RBRACE) && 
-           !parser_check(parser, TOKEN_EOF)) {
-        /* 方法或属性 */
-        if (parser_check(parser, TOKEN_IDENTIFIER) ||
-            parser_check(parser, TOKEN_STATIC) ||
-            parser_check(parser, TOKEN_GET) ||
-            parser_check(parser, TOKEN_SET)) {
-            parser_advance(parser);
-            
-            /* 如果是函数 */
-            if (parser_match(parser, TOKEN_LPAREN)) {
-                /* 参数 */
-                while (!parser_check(parser, TOKEN_RPAREN) && 
-                       !parser_check(parser, TOKEN_EOF)) {
-                    parser_advance(parser);
-                }
-                if (!parser_expect(parser, TOKEN_RPAREN)) {
-                    return false;
-                }
-                
-                /* 函数体 */
-                if (!parse_block_statement(parser)) {
+        if (shorthand && !parser_check(parser, TOKEN_COLON)) {
+            /* 简写形式 {a} 或 {a = 1} */
+            uint32_t value = build_copy(parser, key);
+            if (parser_match(parser, TOKEN_ASSIGN)) {
+                if (!parse_assignment_expression(parser)) {
                     return false;
                 }
+                value = build_pair(parser, AST_ASSIGNMENT_PATTERN, TOKEN_ASSIGN,
+                                   property_start, value, parser->node);
             }
+            uint32_t property = build_pair(parser, AST_PROPERTY, 0, property_start,
+                                           key, value);
+            set_node_flags(parser, property, AST_FLAG_SHORTHAND);
+            push_node(parser, &properties, property);
         } else {
-            parser_advance(parser);
+            if (!parser_expect(parser, TOKEN_COLON)) {
+                return false;
+            }
+            if (!parse_binding_element(parser)) {
+                return false;
+            }
+            uint32_t property = build_pair(parser, AST_PROPERTY, 0, property_start,
+                                           key, parser->node);
+            set_node_flags(parser, property, computed ? AST_FLAG_COMPUTED : 0);
+            push_node(parser, &properties, property);
+        }
+    
+        if (!parser_match(parser, TOKEN_COMMA)) {
+            break;
         }
     }
     
-    return parser_expect(parser, TOKEN_RBRACE);
+    if (!parser_expect(parser, TOKEN_RBRACE)) {
+        return false;
+    }
+    parser->node = build_node(parser, AST_OBJECT_PATTERN, 0, start, properties.first);
+    return true;
+}
+
+/* 解析绑定目标：标识符、数组解构模式或对象解构模式 */
+static bool parse_binding_target(Parser *parser) {
+    if (parser_check(parser, TOKEN_LBRACKET)) {
+        return parse_array_binding_pattern(parser);
+    }
+    if (parser_check(parser, TOKEN_LBRACE)) {
+        return parse_object_binding_pattern(parser);
+    }
+    if (!parser_expect(parser, TOKEN_IDENTIFIER)) {
+        return false;
+    }
+    parser->node = build_token(parser, AST_IDENTIFIER, 0);
+    return true;
+}
+
+/* 解析形式参数列表 (a, b = 1, {c}, ...rest)，参数追加到params */
+static bool parse_formal_parameters(Parser *parser, AstList *params) {
+    if (!parser_expect(parser, TOKEN_LPAREN)) {
+        return false;
+    }
+    
+    while (!parser_check(parser, TOKEN_RPAREN)) {
+        /* 剩余参数必须是最后一个 */
+        if (parser_check(parser, TOKEN_SPREAD)) {
+            if (!parse_binding_rest(parser)) {
+                return false;
+            }
+            push_node(parser, params, parser->node);
+            break;
+        }
+    
+        if (!parse_binding_element(parser)) {
+            return false;
+        }
+        push_node(parser, params, parser->node);
+        if (!parser_match(parser, TOKEN_COMMA)) {
+            break;
+        }
+    }
+    
+    return parser_expect(parser, TOKEN_RPAREN);
+}
+
+/* 解析函数的参数和函数体并追加到children；flags（AST_FLAG_ASYNC/GENERATOR）决定其中
+   await和yield是否为运算符，外层的上下文在结束后恢复 */
+static bool parse_function_rest(Parser *parser, AstList *children, int flags) {
+    bool in_async = parser->in_async;
+    bool in_generator = parser->in_generator;
+    parser->in_async = (flags & AST_FLAG_ASYNC) != 0;
+    parser->in_generator = (flags & AST_FLAG_GENERATOR) != 0;
+    
+    bool result = parse_formal_parameters(parser, children) && parse_block_statement(parser);
+    parser->in_async = in_async;
+    parser->in_generator = in_generator;
+    if (!result) {
+        return false;
+    }
+    push_node(parser, children, parser->node);
+    return true;
+}
+
+/* 解析方法的参数和函数体（对象方法、访问器、类方法），生成匿名函数表达式 */
+static bool parse_method_function(Parser *parser, int flags) {
+    size_t start = token_offset(parser);
+    AstList children = {AST_NONE, AST_NONE};
+    
+    push_node(parser, &children, build_null(parser));
+    if (!parse_function_rest(parser, &children, flags)) {
+        return false;
+    }
+    
+    parser->node = build_node(parser, AST_FUNCTION_EXPRESSION, 0, start, children.first);
+    set_node_flags(parser, parser->node, flags);
+    return true;
+}
+
+/* 解析方法名前的 async、* 和 get/set 前缀（对象字面量与类共用）：async和*记入*function_flags，
+   get/set记入*flags。前缀之后不是属性名时它本身就是属性名：返回true，*key为它的标识符节点 */
+static bool parse_method_prefix(Parser *parser, int *flags, int *function_flags, uint32_t *key) {
+    /* async与方法名之间不能换行 */
+    if (parser_check(parser, TOKEN_ASYNC)) {
+        parser_advance(parser);
+        if (parser->current_token->preceded_by_newline ||
+            !(is_property_name_start(parser->current_token->type) ||
+              parser_check(parser, TOKEN_MULTIPLY))) {
+            *key = build_token(parser, AST_IDENTIFIER, 0);
+            return true;
+        }
+        *function_flags |= AST_FLAG_ASYNC;
+    }
+    if (parser_match(parser, TOKEN_MULTIPLY)) {
+        *function_flags |= AST_FLAG_GENERATOR;
+        return false;
+    }
+    if (*function_flags == 0 && (parser_check(parser, TOKEN_GET) || parser_check(parser, TOKEN_SET))) {
+        int accessor = parser_check(parser, TOKEN_GET) ? AST_FLAG_GETTER : AST_FLAG_SETTER;
+        parser_advance(parser);
+        if (!is_property_name_start(parser->current_token->type)) {
+            *key = build_token(parser, AST_IDENTIFIER, 0);
+            return true;
+        }
+        *flags |= accessor;
+    }
+    return false;
+}
+
+/* 解析声明列表 a = 1, {b} = c（in_for为真时第一个绑定之后遇到in/of立即结束） */
+static bool parse_declarations(Parser *parser, bool in_for) {
+    size_t start = token_offset(parser);
+    TokenType kind = parser->current_token->type;
+    AstList declarations = {AST_NONE, AST_NONE};
+    
+    /* var/let/const */
+    parser_advance(parser);
+    
+    size_t count = 0;
+    do {
+        size_t declarator_start = token_offset(parser);
+        bool pattern = parser_check(parser, TOKEN_LBRACKET) || parser_check(parser, TOKEN_LBRACE);
+    
+        if (!parse_binding_target(parser)) {
+            return false;
+        }
+        uint32_t id = parser->node;
+        uint32_t init;
+        count++;
+    
+        /* for-in or for-of 的左侧没有初始化 */
+        if (in_for && count == 1 &&
+            (parser_check(parser, TOKEN_IN) || parser_check(parser, TOKEN_OF))) {
+            push_node(parser, &declarations,
+                      build_pair(parser, AST_VARIABLE_DECLARATOR, 0, declarator_start,
+                                 id, build_null(parser)));
+            break;
+        }
+    
+        /* 可选的初始化；解构声明和const必须有初始值 */
+        if (parser_match(parser, TOKEN_ASSIGN)) {
+            if (!parse_assignment_expression(parser)) {
+                return false;
+            }
+            init = parser->node;
+        } else if (pattern || kind == TOKEN_CONST) {
+            set_error(parser->error, ERROR_PARSER_UNEXPECTED_TOKEN, parser->current_token->start,
+                      pattern ? "Missing initializer in destructuring declaration" :
+                                "Missing initializer in const declaration");
+            return false;
+        } else {
+            init = build_null(parser);
+        }
+    
+        /* for-in/of的左侧只能有一个没有初始值的绑定（非严格代码中的 for (var x = 1 in o) 除外，Annex B） */
+        if (in_for && (parser_check(parser, TOKEN_IN) || parser_check(parser, TOKEN_OF))) {
+            bool annex_b = parser_check(parser, TOKEN_IN) && kind == TOKEN_VAR && !pattern &&
+                           count == 1 && !parser->module;
+            if (!annex_b) {
+                set_error(parser->error, ERROR_PARSER_UNEXPECTED_TOKEN, parser->current_token->start,
+                          count > 1 ? "Invalid left-hand side in for loop: must have a single binding" :
+                                      "for-in/of loop variable declaration may not have an initializer");
+                return false;
+            }
+        }
+    
+        push_node(parser, &declarations,
+                  build_pair(parser, AST_VARIABLE_DECLARATOR, 0, declarator_start,
+                             id, init));
+    } while (parser_match(parser, TOKEN_COMMA));
+    
+    parser->node = build_node(parser, AST_VARIABLE_DECLARATION, kind, start,
+                              declarations.first);
+    return true;
+}
+
+/* 解析变量声明 */
+bool parse_variable_declaration(Parser *parser) {
+    if (!parse_declarations(parser, false)) {
+        return false;
+    }
+    uint32_t node = parser->node;
+    
+    /* 分号（或ASI） */
+    if (!parser_consume_semicolon(parser)) {
+        return false;
+    }
+    extend_node(parser, node);
+    parser->node = node;
+    return true;
+}
+
+/* 解析函数（声明或表达式），包括 async function 和生成器 function* */
+static bool parse_function(Parser *parser, AstKind kind) {
+    size_t start = token_offset(parser);
+    AstList children = {AST_NONE, AST_NONE};
+    int flags = 0;
+    
+    /* [async] function [*]（调用者已确认async之后在同一行是function） */
+    if (parser_match(parser, TOKEN_ASYNC)) {
+        flags |= AST_FLAG_ASYNC;
+    }
+    parser_advance(parser);
+    if (parser_match(parser, TOKEN_MULTIPLY)) {
+        flags |= AST_FLAG_GENERATOR;
+    }
+    
+    /* 函数名（可选，用于函数表达式） */
+    if (parser_match(parser, TOKEN_IDENTIFIER)) {
+        push_node(parser, &children, build_token(parser, AST_IDENTIFIER, 0));
+    } else {
+        push_node(parser, &children, build_null(parser));
+    }
+    
+    /* 参数列表和函数体 */
+    if (!parse_function_rest(parser, &children, flags)) {
+        return false;
+    }
+    
+    parser->node = build_node(parser, kind, 0, start, children.first);
+    set_node_flags(parser, parser->node, flags);
+    return true;
+}
+
+/* 解析函数声明 */
+bool parse_function_declaration(Parser *parser) {
+    return parse_function(parser, AST_FUNCTION_DECLARATION);
+}
+
+/* 解析类的静态初始化块 static { ... }（当前token为{），其中的await/yield不是运算符 */
+static bool parse_static_block(Parser *parser, size_t start) {
+    bool in_async = parser->in_async;
+    bool in_generator = parser->in_generator;
+    parser->in_async = false;
+    parser->in_generator = false;
+    
+    bool result = parse_block_statement(parser);
+    parser->in_async = in_async;
+    parser->in_generator = in_generator;
+    if (!result) {
+        return false;
+    }
+    
+    /* 块语句节点改为从static开始的StaticBlock */
+    if (parser->ast && parser->node != AST_NONE) {
+        parser->ast->nodes[parser->node].kind = AST_STATIC_BLOCK;
+        parser->ast->nodes[parser->node].start = (uint32_t)start;
+    }
+    return true;
+}
+
+/* 解析类成员：方法（含async/生成器）、访问器、字段或静态初始化块 */
+static bool parse_class_member(Parser *parser) {
+    size_t start = token_offset(parser);
+    int flags = 0;
+    int function_flags = 0;     /* 方法的async、*前缀 */
+    bool named = false;         /* static/async/get/set 本身就是成员名 */
+    bool computed = false;
+    uint32_t key = AST_NONE;
+    
+    /* static 前缀；其后不是属性名、* 或 { 时它本身就是成员名 */
+    if (parser_match(parser, TOKEN_STATIC)) {
+        if (parser_check(parser, TOKEN_LBRACE)) {
+            return parse_static_block(parser, start);
+        }
+        if (is_property_name_start(parser->current_token->type) ||
+            parser_check(parser, TOKEN_MULTIPLY)) {
+            flags |= AST_FLAG_STATIC;
+        } else {
+            key = build_token(parser, AST_IDENTIFIER, 0);
+            named = true;
+        }
+    }
+    if (!named) {
+        named = parse_method_prefix(parser, &flags, &function_flags, &key);
+    }
+    
+    /* 成员名 */
+    if (!named) {
+        bool constructor = parser_check(parser, TOKEN_IDENTIFIER) &&
+                           parser->current_token->length == 11 &&
+                           memcmp(parser->current_token->value, "constructor", 11) == 0;
+        if (!parse_property_name(parser, &computed)) {
+            return false;
+        }
+        key = parser->node;
+        if (constructor && function_flags == 0 &&
+            !(flags & (AST_FLAG_STATIC | AST_FLAG_GETTER | AST_FLAG_SETTER))) {
+            flags |= AST_FLAG_CONSTRUCTOR;
+        }
+    }
+    if (computed) {
+        flags |= AST_FLAG_COMPUTED;
+    }
+    
+    /* 方法 */
+    if (parser_check(parser, TOKEN_LPAREN) || function_flags ||
+        (flags & (AST_FLAG_GETTER | AST_FLAG_SETTER))) {
+        if (!parse_method_function(parser, function_flags)) {
+            return false;
+        }
+        parser->node = build_pair(parser, AST_METHOD_DEFINITION, 0, start, key, parser->node);
+        set_node_flags(parser, parser->node, flags);
+        return true;
+    }
+    
+    /* 字段及可选的初始值 */
+    uint32_t value;
+    if (parser_match(parser, TOKEN_ASSIGN)) {
+        if (!parse_assignment_expression(parser)) {
+            return false;
+        }
+        value = parser->node;
+    } else {
+        value = build_null(parser);
+    }
+    if (!parser_consume_semicolon(parser)) {
+        return false;
+    }
+    parser->node = build_pair(parser, AST_PROPERTY_DEFINITION, 0, start, key, value);
+    set_node_flags(parser, parser->node, flags);
+    return true;
+}
+
+/* 解析类（anonymous为真时类名可以省略，用于export default class） */
+static bool parse_class(Parser *parser, bool anonymous) {
+    size_t start = token_offset(parser);
+    AstList children = {AST_NONE, AST_NONE};
+    
+    /* class */
+    parser_advance(parser);
+    
+    /* 类名 */
+    if (anonymous && !parser_check(parser, TOKEN_IDENTIFIER)) {
+        push_node(parser, &children, build_null(parser));
+    } else if (!parser_expect(parser, TOKEN_IDENTIFIER)) {
+        return false;
+    } else {
+        push_node(parser, &children, build_token(parser, AST_IDENTIFIER, 0));
+    }
+    
+    /* extends */
+    if (parser_match(parser, TOKEN_EXTENDS)) {
+        if (!parse_left_hand_side_expression(parser)) {
+            return false;
+        }
+        push_node(parser, &children, parser->node);
+    } else {
+        push_node(parser, &children, build_null(parser));
+    }
+    
+    /* 类体 */
+    size_t body_start = token_offset(parser);
+    AstList members = {AST_NONE, AST_NONE};
+    
+    if (!parser_expect(parser, TOKEN_LBRACE)) {
+        return false;
+    }
+    
+    /* 成员：方法、访问器、字段，以及多余的分号 */
+    while (!parser_check(parser, TOKEN_RBRACE) &&
+           !parser_check(parser, TOKEN_EOF)) {
+        if (parser_match(parser, TOKEN_SEMICOLON)) {
+            continue;
+        }
+        if (!parse_class_member(parser)) {
+            return false;
+        }
+        push_node(parser, &members, parser->node);
+    }
+    
+    if (!parser_expect(parser, TOKEN_RBRACE)) {
+        return false;
+    }
+    push_node(parser, &children, build_node(parser, AST_CLASS_BODY, 0, body_start, members.first));
+    
+    parser->node = build_node(parser, AST_CLASS_DECLARATION, 0, start, children.first);
+    return true;
+}
+
+/* 解析类声明 */
+bool parse_class_declaration(Parser *parser) {
+    return parse_class(parser, false);
+}
+
+/* 把next链接为node的下一个兄弟节点（子节点不按源码顺序解析时使用） */
+static void link_sibling(Parser *parser, uint32_t node, uint32_t next) {
+    if (parser->ast && node != AST_NONE) {
+        parser->ast->nodes[node].next_sibling = next;
+    }
+}
+
+/* import/export声明只能出现在模块的顶层 */
+static bool check_module_item(Parser *parser) {
+    if (parser->module && parser->depth == 1) {
+        return true;
+    }
+    set_error(parser->error, ERROR_PARSER_UNEXPECTED_TOKEN, parser->current_token->start,
+             parser->module ? "Import and export declarations may only appear at top level"
+                            : "Import and export declarations are only allowed in modules");
+    return false;
+}
+
+/* 解析模块导出名：IdentifierName或字符串 */
+static bool parse_module_export_name(Parser *parser) {
+    if (parser_match(parser, TOKEN_STRING)) {
+        parser->node = build_token(parser, AST_LITERAL, TOKEN_STRING);
+        return true;
+    }
+    if (!is_identifier_name(parser->current_token->type)) {
+        return parser_expect(parser, TOKEN_IDENTIFIER);
+    }
+    parser_advance(parser);
+    parser->node = build_token(parser, AST_IDENTIFIER, 0);
+    return true;
+}
+
+/* 解析模块说明符字符串 */
+static bool parse_module_source(Parser *parser) {
+    if (!parser_expect(parser, TOKEN_STRING)) {
+        return false;
+    }
+    parser->node = build_token(parser, AST_LITERAL, TOKEN_STRING);
+    return true;
+}
+
+/* 解析import声明：import 'x'、import d, * as ns from 'x'、import d, {a, b as c} from 'x' */
+bool parse_import_declaration(Parser *parser) {
+    size_t start = token_offset(parser);
+    AstList specifiers = {AST_NONE, AST_NONE};
+    
+    if (!check_module_item(parser)) {
+        return false;
+    }
+    
+    /* import */
+    parser_advance(parser);
+    
+    if (!parser_check(parser, TOKEN_STRING)) {
+        /* 默认导入 */
+        bool more = true;
+        bool has_default = false;   /* 不建AST时specifiers一直为空，不能用它判断 */
+        if (parser_match(parser, TOKEN_IDENTIFIER)) {
+            has_default = true;
+            size_t local = (size_t)parser->prev_token->start.offset;
+            uint32_t id = build_token(parser, AST_IDENTIFIER, 0);
+            push_node(parser, &specifiers,
+                      build_node(parser, AST_IMPORT_DEFAULT_SPECIFIER, 0, local, id));
+            more = parser_match(parser, TOKEN_COMMA);
+        }
+    
+        if (more && parser_check(parser, TOKEN_MULTIPLY)) {
+            /* * as ns */
+            size_t namespace_start = token_offset(parser);
+            parser_advance(parser);
+            if (!expect_word(parser, "as") || !parser_expect(parser, TOKEN_IDENTIFIER)) {
+                return false;
+            }
+            uint32_t id = build_token(parser, AST_IDENTIFIER, 0);
+            push_node(parser, &specifiers,
+                      build_node(parser, AST_IMPORT_NAMESPACE_SPECIFIER, 0, namespace_start, id));
+        } else if (more && parser_match(parser, TOKEN_LBRACE)) {
+            /* {a, b as c, "d" as e} */
+            while (!parser_check(parser, TOKEN_RBRACE)) {
+                size_t specifier_start = token_offset(parser);
+                bool string = parser_check(parser, TOKEN_STRING);
+                bool binding = parser_check(parser, TOKEN_IDENTIFIER);
+                if (!parse_module_export_name(parser)) {
+                    return false;
+                }
+                uint32_t imported = parser->node;
+                uint32_t local;
+                if (check_word(parser, "as")) {
+                    parser_advance(parser);
+                    if (!parser_expect(parser, TOKEN_IDENTIFIER)) {
+                        return false;
+                    }
+                    local = build_token(parser, AST_IDENTIFIER, 0);
+                } else if (binding && !string) {
+                    local = build_copy(parser, imported);
+                } else {
+                    /* 关键字和字符串不能直接作为绑定名 */
+                    return expect_word(parser, "as");
+                }
+                push_node(parser, &specifiers,
+                          build_pair(parser, AST_IMPORT_SPECIFIER, 0, specifier_start, imported, local));
+                if (!parser_match(parser, TOKEN_COMMA)) {
+                    break;
+                }
+            }
+            if (!parser_expect(parser, TOKEN_RBRACE)) {
+                return false;
+            }
+        } else if (more || !has_default) {
+            return parser_expect(parser, TOKEN_LBRACE);
+        }
+    
+        if (!expect_word(parser, "from")) {
+            return false;
+        }
+    }
+    
+    if (!parse_module_source(parser)) {
+        return false;
+    }
+    uint32_t source = parser->node;
+    link_sibling(parser, source, specifiers.first);
+    
+    if (!parser_consume_semicolon(parser)) {
+        return false;
+    }
+    parser->node = build_node(parser, AST_IMPORT_DECLARATION, 0, start, source);
+    return true;
+}
+
+/* 解析export声明 */
+bool parse_export_declaration(Parser *parser) {
+    size_t start = token_offset(parser);
+    AstList children = {AST_NONE, AST_NONE};
+    
+    if (!check_module_item(parser)) {
+        return false;
+    }
+    
+    /* export */
+    parser_advance(parser);
+    
+    /* export default：函数声明、类声明或表达式 */
+    if (parser_match(parser, TOKEN_DEFAULT)) {
+        if (parser_check(parser, TOKEN_FUNCTION) ||
+            (parser_check(parser, TOKEN_ASYNC) && peek_function(parser))) {
+            if (!parse_function(parser, AST_FUNCTION_DECLARATION)) {
+                return false;
+            }
+        } else if (parser_check(parser, TOKEN_CLASS)) {
+            if (!parse_class(parser, true)) {
+                return false;
+            }
+        } else {
+            if (!parse_assignment_expression(parser)) {
+                return false;
+            }
+            uint32_t expression = parser->node;
+            if (!parser_consume_semicolon(parser)) {
+                return false;
+            }
+            parser->node = expression;
+        }
+        parser->node = build_node(parser, AST_EXPORT_DEFAULT_DECLARATION, 0, start, parser->node);
+        return true;
+    }
+    
+    /* export * from 'x' / export * as ns from 'x' */
+    if (parser_match(parser, TOKEN_MULTIPLY)) {
+        if (check_word(parser, "as")) {
+            parser_advance(parser);
+            if (!parse_module_export_name(parser)) {
+                return false;
+            }
+            push_node(parser, &children, parser->node);
+        } else {
+            push_node(parser, &children, build_null(parser));
+        }
+        if (!expect_word(parser, "from") || !parse_module_source(parser)) {
+            return false;
+        }
+        push_node(parser, &children, parser->node);
+        if (!parser_consume_semicolon(parser)) {
+            return false;
+        }
+        parser->node = build_node(parser, AST_EXPORT_ALL_DECLARATION, 0, start, children.first);
+        return true;
+    }
+    
+    /* export {a, b as c} [from 'x'] */
+    if (parser_match(parser, TOKEN_LBRACE)) {
+        AstList specifiers = {AST_NONE, AST_NONE};
+        while (!parser_check(parser, TOKEN_RBRACE)) {
+            size_t specifier_start = token_offset(parser);
+            if (!parse_module_export_name(parser)) {
+                return false;
+            }
+            uint32_t local = parser->node;
+            uint32_t exported;
+            if (check_word(parser, "as")) {
+                parser_advance(parser);
+                if (!parse_module_export_name(parser)) {
+                    return false;
+                }
+                exported = parser->node;
+            } else {
+                exported = build_copy(parser, local);
+            }
+            push_node(parser, &specifiers,
+                      build_pair(parser, AST_EXPORT_SPECIFIER, 0, specifier_start, local, exported));
+            if (!parser_match(parser, TOKEN_COMMA)) {
+                break;
+            }
+        }
+        if (!parser_expect(parser, TOKEN_RBRACE)) {
+            return false;
+        }
+    
+        push_node(parser, &children, build_null(parser));
+        uint32_t source;
+        if (check_word(parser, "from")) {
+            parser_advance(parser);
+            if (!parse_module_source(parser)) {
+                return false;
+            }
+            source = parser->node;
+        } else {
+            source = build_null(parser);
+        }
+        push_node(parser, &children, source);
+        link_sibling(parser, source, specifiers.first);
+    
+        if (!parser_consume_semicolon(parser)) {
+            return false;
+        }
+        parser->node = build_node(parser, AST_EXPORT_NAMED_DECLARATION, 0, start, children.first);
+        return true;
+    }
+    
+    /* export var/let/const/function/class */
+    bool result;
+    switch (parser->current_token->type) {
+        case TOKEN_VAR:
+        case TOKEN_LET:
+        case TOKEN_CONST:
+            result = parse_variable_declaration(parser);
+            break;
+        case TOKEN_FUNCTION:
+            result = parse_function_declaration(parser);
+            break;
+        case TOKEN_CLASS:
+            result = parse_class_declaration(parser);
+            break;
+        case TOKEN_ASYNC:
+            if (peek_function(parser)) {
+                result = parse_function_declaration(parser);
+                break;
+            }
+            /* fall through */
+        default:
+            set_error(parser->error, ERROR_PARSER_UNEXPECTED_TOKEN, parser->current_token->start,
+                     "Unexpected token after export");
+            return false;
+    }
+    if (!result) {
+        return false;
+    }
+    push_node(parser, &children, parser->node);
+    push_node(parser, &children, build_null(parser));
+    parser->node = build_node(parser, AST_EXPORT_NAMED_DECLARATION, 0, start, children.first);
+    return true;
 }
 
 /* 解析表达式语句 */
 bool parse_expression_statement(Parser *parser) {
+    size_t start = token_offset(parser);
+    
     if (!parse_expression(parser)) {
         return false;
     }
+    uint32_t expression = parser->node;
     
-    return parser_consume_semicolon(parser);
+    if (!parser_consume_semicolon(parser)) {
+        return false;
+    }
+    parser->node = build_node(parser, AST_EXPRESSION_STATEMENT, 0, start, expression);
+    return true;
 }
 
 /* 解析if语句 */
 bool parse_if_statement(Parser *parser) {
+    size_t start = token_offset(parser);
+    AstList children = {AST_NONE, AST_NONE};
+    
     /* if */
     parser_advance(parser);
     
@@ -470,6 +1624,7 @@ bool parse_if_statement(Parser *parser) {
     if (!parse_expression(parser)) {
         return false;
     }
+    push_node(parser, &children, parser->node);
     
     if (!parser_expect(parser, TOKEN_RPAREN)) {
         return false;
@@ -478,19 +1633,26 @@ bool parse_if_statement(Parser *parser) {
     if (!parse_statement(parser)) {
         return false;
     }
+    push_node(parser, &children, parser->node);
     
     /* else */
     if (parser_match(parser, TOKEN_ELSE)) {
         if (!parse_statement(parser)) {
             return false;
         }
+        push_node(parser, &children, parser->node);
+    } else {
+        push_node(parser, &children, build_null(parser));
     }
     
+    parser->node = build_node(parser, AST_IF_STATEMENT, 0, start, children.first);
     return true;
 }
 
 /* 解析while语句 */
 bool parse_while_statement(Parser *parser) {
+    size_t start = token_offset(parser);
+    
     /* while */
     parser_advance(parser);
     
@@ -501,22 +1663,30 @@ bool parse_while_statement(Parser *parser) {
     if (!parse_expression(parser)) {
         return false;
     }
+    uint32_t test = parser->node;
     
     if (!parser_expect(parser, TOKEN_RPAREN)) {
         return false;
     }
     
-    return parse_statement(parser);
+    if (!parse_statement(parser)) {
+        return false;
+    }
+    parser->node = build_pair(parser, AST_WHILE_STATEMENT, 0, start, test, parser->node);
+    return true;
 }
 
 /* 解析do-while语句 */
 bool parse_do_while_statement(Parser *parser) {
+    size_t start = token_offset(parser);
+    
     /* do */
     parser_advance(parser);
     
     if (!parse_statement(parser)) {
         return false;
     }
+    uint32_t body = parser->node;
     
     if (!parser_expect(parser, TOKEN_WHILE)) {
         return false;
@@ -529,58 +1699,127 @@ bool parse_do_while_statement(Parser *parser) {
     if (!parse_expression(parser)) {
         return false;
     }
+    uint32_t test = parser->node;
     
     if (!parser_expect(parser, TOKEN_RPAREN)) {
         return false;
     }
     
-    return parser_consume_semicolon(parser);
+    if (!parser_consume_semicolon(parser)) {
+        return false;
+    }
+    parser->node = build_pair(parser, AST_DO_WHILE_STATEMENT, 0, start, body, test);
+    return true;
 }
 
-/* 解析for语句 */
+static bool parse_sequence_rest(Parser *parser, size_t start);
+
+/* 解析for语句头部的初始化表达式；其后是in/of时它是for-in/of的左侧，
+   覆盖语法的数组/对象字面量在这里重新解释为赋值模式 */
+static bool parse_for_init_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    Position position = parser->current_token->start;
+    int pending = parser->cover_pending;
+    
+    parser->cover_element = true;
+    if (!parse_assignment_expression(parser)) {
+        return false;
+    }
+    
+    if (parser_check(parser, TOKEN_IN) || parser_check(parser, TOKEN_OF)) {
+        int target = parser->cover;
+        if ((target & COVER_INITIALIZED) ||
+            !(target & (COVER_SIMPLE_TARGET | COVER_ASSIGN_PATTERN))) {
+            set_error(parser->error, ERROR_PARSER_INVALID_ASSIGNMENT, position,
+                      "Invalid left-hand side in for-in/of loop");
+            return false;
+        }
+        parser->cover_pending = pending;
+        if (parser->ast) {
+            ast_to_pattern(parser->ast, parser->node);
+        }
+        return true;
+    }
+    
+    /* 普通for语句：简写初始化 {a = 1} 没有被转换为模式 */
+    if (parser->cover_pending > pending) {
+        set_error(parser->error, ERROR_PARSER_UNEXPECTED_TOKEN,
+                 parser->cover_position, "Invalid shorthand property initializer");
+        return false;
+    }
+    if (!parse_sequence_rest(parser, start)) {
+        return false;
+    }
+    if (parser_check(parser, TOKEN_IN) || parser_check(parser, TOKEN_OF)) {
+        set_error(parser->error, ERROR_PARSER_INVALID_ASSIGNMENT, position,
+                  "Invalid left-hand side in for-in/of loop");
+        return false;
+    }
+    return true;
+}
+
+/* 解析for语句（async函数中包括 for await (... of ...)） */
 bool parse_for_statement(Parser *parser) {
-    /* for */
+    size_t start = token_offset(parser);
+    AstList children = {AST_NONE, AST_NONE};
+    
+    /* for [await] */
     parser_advance(parser);
+    bool await = parser->in_async && parser_match(parser, TOKEN_AWAIT);
     
     if (!parser_expect(parser, TOKEN_LPAREN)) {
         return false;
     }
     
-    /* 初始化部分 */
+    /* 初始化部分（其中不在括号内的in不是运算符，而是for-in的in） */
     if (!parser_check(parser, TOKEN_SEMICOLON)) {
-        if (parser_check(parser, TOKEN_VAR) || 
-            parser_check(parser, TOKEN_LET) ||
-            parser_check(parser, TOKEN_CONST)) {
-            parser_advance(parser);
-            
-            if (!parser_expect(parser, TOKEN_IDENTIFIER)) {
+        int no_in = parser->no_in;
+        parser->no_in = parser->nesting + 1;
+        bool success = parser_check(parser, TOKEN_VAR) ||
+                       parser_check(parser, TOKEN_LET) ||
+                       parser_check(parser, TOKEN_CONST) ?
+                       parse_declarations(parser, true) : parse_for_init_expression(parser);
+        parser->no_in = no_in;
+        if (!success) {
+            return false;
+        }
+        push_node(parser, &children, parser->node);
+    
+        /* for-in or for-of（for-of的右侧是赋值表达式） */
+        if (parser_check(parser, TOKEN_IN) ||
+            parser_check(parser, TOKEN_OF)) {
+            AstKind kind = parser_check(parser, TOKEN_IN) ?
+                           AST_FOR_IN_STATEMENT : AST_FOR_OF_STATEMENT;
+            if (await && kind != AST_FOR_OF_STATEMENT) {
+                set_error(parser->error, ERROR_PARSER_EXPECTED_TOKEN,
+                         parser->current_token->start, "Expected 'of' in for await loop");
                 return false;
             }
-            
-            /* for-in or for-of */
-            if (parser_check(parser, TOKEN_IN) || 
-                parser_check(parser, TOKEN_OF)) {
-                parser_advance(parser);
-                if (!parse_expression(parser)) {
-                    return false;
-                }
-                if (!parser_expect(parser, TOKEN_RPAREN)) {
-                    return false;
-                }
-                return parse_statement(parser);
+            parser_advance(parser);
+            if (!(kind == AST_FOR_IN_STATEMENT ? parse_expression(parser) :
+                                                 parse_assignment_expression(parser))) {
+                return false;
             }
-            
-            /* 普通for循环的声明 */
-            if (parser_match(parser, TOKEN_ASSIGN)) {
-                if (!parse_assignment_expression(parser)) {
-                    return false;
-                }
+            push_node(parser, &children, parser->node);
+            if (!parser_expect(parser, TOKEN_RPAREN)) {
+                return false;
             }
-        } else {
-            if (!parse_expression(parser)) {
+            if (!parse_statement(parser)) {
                 return false;
             }
+            push_node(parser, &children, parser->node);
+            parser->node = build_node(parser, kind, 0, start, children.first);
+            set_node_flags(parser, parser->node, await ? AST_FLAG_ASYNC : 0);
+            return true;
         }
+    } else {
+        push_node(parser, &children, build_null(parser));
+    }
+    
+    if (await) {
+        set_error(parser->error, ERROR_PARSER_EXPECTED_TOKEN,
+                 parser->current_token->start, "Expected 'of' in for await loop");
+        return false;
     }
     
     if (!parser_expect(parser, TOKEN_SEMICOLON)) {
@@ -592,6 +1831,9 @@ bool parse_for_statement(Parser *parser) {
         if (!parse_expression(parser)) {
             return false;
         }
+        push_node(parser, &children, parser->node);
+    } else {
+        push_node(parser, &children, build_null(parser));
     }
     
     if (!parser_expect(parser, TOKEN_SEMICOLON)) {
@@ -603,17 +1845,29 @@ bool parse_for_statement(Parser *parser) {
         if (!parse_expression(parser)) {
             return false;
         }
+        push_node(parser, &children, parser->node);
+    } else {
+        push_node(parser, &children, build_null(parser));
     }
     
     if (!parser_expect(parser, TOKEN_RPAREN)) {
         return false;
     }
     
-    return parse_statement(parser);
+    if (!parse_statement(parser)) {
+        return false;
+    }
+    push_node(parser, &children, parser->node);
+    
+    parser->node = build_node(parser, AST_FOR_STATEMENT, 0, start, children.first);
+    return true;
 }
 
 /* 解析switch语句 */
 bool parse_switch_statement(Parser *parser) {
+    size_t start = token_offset(parser);
+    AstList children = {AST_NONE, AST_NONE};
+    
     /* switch */
     parser_advance(parser);
     
@@ -624,6 +1878,7 @@ bool parse_switch_statement(Parser *parser) {
     if (!parse_expression(parser)) {
         return false;
     }
+    push_node(parser, &children, parser->node);
     
     if (!parser_expect(parser, TOKEN_RPAREN)) {
         return false;
@@ -634,41 +1889,60 @@ bool parse_switch_statement(Parser *parser) {
     }
     
     /* case子句 */
-    while (parser_check(parser, TOKEN_CASE) || 
+    while (parser_check(parser, TOKEN_CASE) ||
            parser_check(parser, TOKEN_DEFAULT)) {
+        size_t case_start = token_offset(parser);
+        AstList clause = {AST_NONE, AST_NONE};
+    
         parser_advance(parser);
-        
+    
         if (parser->prev_token->type == TOKEN_CASE) {
             if (!parse_expression(parser)) {
                 return false;
             }
+            push_node(parser, &clause, parser->node);
+        } else {
+            push_node(parser, &clause, build_null(parser));
         }
-        
+    
         if (!parser_expect(parser, TOKEN_COLON)) {
             return false;
         }
-        
+    
         /* 语句列表 */
         while (!parser_check(parser, TOKEN_CASE) &&
                !parser_check(parser, TOKEN_DEFAULT) &&
                !parser_check(parser, TOKEN_RBRACE) &&
                !parser_check(parser, TOKEN_EOF)) {
-            if (!parse_statement(parser)) {
+            if (!parse_list_statement(parser)) {
                 return false;
             }
+            push_node(parser, &clause, parser->node);
         }
+    
+        push_node(parser, &children,
+                  build_node(parser, AST_SWITCH_CASE, 0, case_start, clause.first));
     }
     
-    return parser_expect(parser, TOKEN_RBRACE);
+    if (!parser_expect(parser, TOKEN_RBRACE)) {
+        return false;
+    }
+    parser->node = build_node(parser, AST_SWITCH_STATEMENT, 0, start, children.first);
+    return true;
 }
 
 /* 解析return语句 */
 bool parse_return_statement(Parser *parser) {
+    size_t start = token_offset(parser);
+    uint32_t argument;
+    
     /* return */
     parser_advance(parser);
     
     /* ASI规则：return后换行则自动插入分号 */
     if (parser->current_token->preceded_by_newline) {
+        parser->asi_before = true;
+        parser->node = build_node(parser, AST_RETURN_STATEMENT, 0, start, build_null(parser));
         return true;
     }
     
@@ -679,56 +1953,68 @@ bool parse_return_statement(Parser *parser) {
         if (!parse_expression(parser)) {
             return false;
         }
+        argument = parser->node;
+    } else {
+        argument = build_null(parser);
     }
     
-    return parser_consume_semicolon(parser);
+    if (!parser_consume_semicolon(parser)) {
+        return false;
+    }
+    parser->node = build_node(parser, AST_RETURN_STATEMENT, 0, start, argument);
+    return true;
 }
 
-/* 解析break语句 */
-bool parse_break_statement(Parser *parser) {
-    /* break */
+/* 解析break/continue语句 */
+static bool parse_jump_statement(Parser *parser, AstKind kind) {
+    size_t start = token_offset(parser);
+    uint32_t label;
+    
+    /* break/continue */
     parser_advance(parser);
     
-    /* ASI规则：break后换行则自动插入分号 */
+    /* ASI规则：break/continue后换行则自动插入分号 */
     if (parser->current_token->preceded_by_newline) {
+        parser->asi_before = true;
+        parser->node = build_node(parser, kind, 0, start, build_null(parser));
         return true;
     }
     
     /* 可选标签 */
-    if (parser_check(parser, TOKEN_IDENTIFIER)) {
-        parser_advance(parser);
+    if (parser_match(parser, TOKEN_IDENTIFIER)) {
+        label = build_token(parser, AST_IDENTIFIER, 0);
+    } else {
+        label = build_null(parser);
     }
     
-    return parser_consume_semicolon(parser);
+    if (!parser_consume_semicolon(parser)) {
+        return false;
+    }
+    parser->node = build_node(parser, kind, 0, start, label);
+    return true;
+}
+
+/* 解析break语句 */
+bool parse_break_statement(Parser *parser) {
+    return parse_jump_statement(parser, AST_BREAK_STATEMENT);
 }
 
 /* 解析continue语句 */
 bool parse_continue_statement(Parser *parser) {
-    /* continue */
-    parser_advance(parser);
-    
-    /* ASI规则：continue后换行则自动插入分号 */
-    if (parser->current_token->preceded_by_newline) {
-        return true;
-    }
-    
-    /* 可选标签 */
-    if (parser_check(parser, TOKEN_IDENTIFIER)) {
-        parser_advance(parser);
-    }
-    
-    return parser_consume_semicolon(parser);
+    return parse_jump_statement(parser, AST_CONTINUE_STATEMENT);
 }
 
 /* 解析throw语句 */
 bool parse_throw_statement(Parser *parser) {
+    size_t start = token_offset(parser);
+    
     /* throw */
     parser_advance(parser);
     
     /* ASI规则：throw后不允许换行 */
     if (parser->current_token->preceded_by_newline) {
         set_error(parser->error, ERROR_PARSER_UNEXPECTED_TOKEN,
-                 parser->current_token->start, 
+                 parser->current_token->start,
                  "Line break is not allowed between 'throw' and its expression");
         return false;
     }
@@ -736,34 +2022,55 @@ bool parse_throw_statement(Parser *parser) {
     if (!parse_expression(parser)) {
         return false;
     }
+    uint32_t argument = parser->node;
     
-    return parser_consume_semicolon(parser);
+    if (!parser_consume_semicolon(parser)) {
+        return false;
+    }
+    parser->node = build_node(parser, AST_THROW_STATEMENT, 0, start, argument);
+    return true;
 }
 
 /* 解析try语句 */
 bool parse_try_statement(Parser *parser) {
+    size_t start = token_offset(parser);
+    AstList children = {AST_NONE, AST_NONE};
+    
     /* try */
     parser_advance(parser);
     
     if (!parse_block_statement(parser)) {
         return false;
     }
+    push_node(parser, &children, parser->node);
     
     /* catch */
-    if (parser_match(parser, TOKEN_CATCH)) {
+    if (parser_check(parser, TOKEN_CATCH)) {
+        size_t catch_start = token_offset(parser);
+        uint32_t param;
+    
+        parser_advance(parser);
+    
         /* 可选的参数 */
         if (parser_match(parser, TOKEN_LPAREN)) {
-            if (!parser_expect(parser, TOKEN_IDENTIFIER)) {
+            if (!parse_binding_target(parser)) {
                 return false;
             }
+            param = parser->node;
             if (!parser_expect(parser, TOKEN_RPAREN)) {
                 return false;
             }
+        } else {
+            param = build_null(parser);
         }
-        
+    
         if (!parse_block_statement(parser)) {
             return false;
         }
+        push_node(parser, &children,
+                  build_pair(parser, AST_CATCH_CLAUSE, 0, catch_start, param, parser->node));
+    } else {
+        push_node(parser, &children, build_null(parser));
     }
     
     /* finally */
@@ -771,13 +2078,60 @@ bool parse_try_statement(Parser *parser) {
         if (!parse_block_statement(parser)) {
             return false;
         }
+        push_node(parser, &children, parser->node);
+    } else {
+        push_node(parser, &children, build_null(parser));
     }
     
+    parser->node = build_node(parser, AST_TRY_STATEMENT, 0, start, children.first);
+    return true;
+}
+
+/* 解析with语句（严格模式下的禁用由作用域分析和lint负责） */
+bool parse_with_statement(Parser *parser) {
+    size_t start = token_offset(parser);
+    
+    /* with */
+    parser_advance(parser);
+    
+    if (!parser_expect(parser, TOKEN_LPAREN)) {
+        return false;
+    }
+    
+    if (!parse_expression(parser)) {
+        return false;
+    }
+    uint32_t object = parser->node;
+    
+    if (!parser_expect(parser, TOKEN_RPAREN)) {
+        return false;
+    }
+    
+    if (!parse_statement(parser)) {
+        return false;
+    }
+    parser->node = build_pair(parser, AST_WITH_STATEMENT, 0, start, object, parser->node);
+    return true;
+}
+
+/* 解析debugger语句 */
+bool parse_debugger_statement(Parser *parser) {
+    size_t start = token_offset(parser);
+    
+    /* debugger */
+    parser_advance(parser);
+    
+    if (!parser_consume_semicolon(parser)) {
+        return false;
+    }
+    parser->node = build_node(parser, AST_DEBUGGER_STATEMENT, 0, start, AST_NONE);
     return true;
 }
 
 /* 解析块语句 */
 bool parse_block_statement(Parser *parser) {
+    size_t start = token_offset(parser);
+    
     if (!parser_expect(parser, TOKEN_LBRACE)) {
         return false;
     }
@@ -785,39 +2139,152 @@ bool parse_block_statement(Parser *parser) {
     if (!parse_statement_list(parser)) {
         return false;
     }
+    uint32_t body = parser->node;
     
-    return parser_expect(parser, TOKEN_RBRACE);
+    if (!parser_expect(parser, TOKEN_RBRACE)) {
+        return false;
+    }
+    parser->node = build_node(parser, AST_BLOCK_STATEMENT, 0, start, body);
+    return true;
+}
+
+/* 解析逗号表达式的其余部分（第一个表达式已解析，为parser->node） */
+static bool parse_sequence_rest(Parser *parser, size_t start) {
+    if (!parser_check(parser, TOKEN_COMMA)) {
+        return true;
+    }
+    
+    AstList expressions = {AST_NONE, AST_NONE};
+    push_node(parser, &expressions, parser->node);
+    while (parser_match(parser, TOKEN_COMMA)) {
+        if (!parse_assignment_expression(parser)) {
+            return false;
+        }
+        push_node(parser, &expressions, parser->node);
+    }
+    
+    parser->node = build_node(parser, AST_SEQUENCE_EXPRESSION, 0, start, expressions.first);
+    return true;
 }
 
 /* 解析表达式 */
 bool parse_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    
     if (!parse_assignment_expression(parser)) {
         return false;
     }
+    return parse_sequence_rest(parser, start);
+}
+
+/* 解析生成器中的 yield [*] [表达式]：行末或 ) ] } , ; : 之前没有操作数 */
+static bool parse_yield_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    int flags = 0;
+    uint32_t argument;
     
-    /* 逗号表达式 */
-    while (parser_match(parser, TOKEN_COMMA)) {
+    /* yield */
+    parser_advance(parser);
+    
+    Token *token = parser->current_token;
+    bool operand = !token->preceded_by_newline;
+    switch (token->type) {
+        case TOKEN_RPAREN:
+        case TOKEN_RBRACKET:
+        case TOKEN_RBRACE:
+        case TOKEN_COMMA:
+        case TOKEN_SEMICOLON:
+        case TOKEN_COLON:
+        case TOKEN_EOF:
+            operand = false;
+            break;
+        default:
+            break;
+    }
+    
+    if (operand && parser_match(parser, TOKEN_MULTIPLY)) {
+        flags |= AST_FLAG_DELEGATE;
+    }
+    if (operand) {
         if (!parse_assignment_expression(parser)) {
             return false;
         }
+        argument = parser->node;
+    } else {
+        argument = build_null(parser);
     }
     
+    parser->node = build_node(parser, AST_YIELD_EXPRESSION, 0, start, argument);
+    set_node_flags(parser, parser->node, flags);
+    parser->cover = 0;
     return true;
 }
 
-/* 解析赋值表达式 */
+/* 解析赋值表达式（包括箭头函数和生成器中的yield） */
 bool parse_assignment_expression(Parser *parser) {
+    bool element = parser->cover_element;
+    int pending = parser->cover_pending;
+    size_t start = token_offset(parser);
+    parser->cover_element = false;
+    
+    if (parser->in_generator && parser_check(parser, TOKEN_YIELD)) {
+        return parse_yield_expression(parser);
+    }
+    
     /* 条件表达式 */
     if (!parse_conditional_expression(parser)) {
         return false;
     }
     
-    /* 赋值运算符 */
+    /* 箭头函数：x => ... 或 (...) => ... */
+    if (parser_check(parser, TOKEN_ARROW)) {
+        if (parser->current_token->preceded_by_newline ||
+            !(parser->cover & (COVER_IDENTIFIER | COVER_ARROW_HEAD))) {
+            set_error(parser->error, ERROR_PARSER_UNEXPECTED_TOKEN,
+                     parser->current_token->start, "Unexpected '=>'");
+            return false;
+        }
+        parser->cover_pending = pending;
+        return parse_arrow_function(parser);
+    }
+    
+    /* 赋值运算符：= 的左侧可以是解构模式，复合赋值只能是简单目标 */
     if (is_assignment_operator(parser->current_token->type)) {
+        int target = parser->cover;
+        TokenType op = parser->current_token->type;
+        bool plain = op == TOKEN_ASSIGN;
+        int allowed = plain ? (COVER_SIMPLE_TARGET | COVER_ASSIGN_PATTERN) : COVER_SIMPLE_TARGET;
+    
+        if ((target & COVER_INITIALIZED) || !(target & allowed)) {
+            set_error(parser->error, ERROR_PARSER_INVALID_ASSIGNMENT,
+                     parser->current_token->start, "Invalid assignment target");
+            return false;
+        }
+    
+        /* 左侧已转换为赋值模式，其中的简写初始化合法 */
+        parser->cover_pending = pending;
+        uint32_t left = parser->node;
+        if (plain && parser->ast) {
+            ast_to_pattern(parser->ast, left);
+        }
+    
         parser_advance(parser);
         if (!parse_assignment_expression(parser)) {
             return false;
         }
+        parser->node = build_pair(parser, AST_ASSIGNMENT_EXPRESSION, op, start,
+                                  left, parser->node);
+    
+        /* 作为模式元素时 target = value 表示带默认值的元素 */
+        parser->cover = plain ? (target | COVER_INITIALIZED) : 0;
+        return true;
+    }
+    
+    /* 简写初始化 {a = 1} 只能出现在之后被转换为模式的字面量中 */
+    if (!element && parser->cover_pending > pending) {
+        set_error(parser->error, ERROR_PARSER_UNEXPECTED_TOKEN,
+                 parser->cover_position, "Invalid shorthand property initializer");
+        return false;
     }
     
     return true;
@@ -825,38 +2292,66 @@ bool parse_assignment_expression(Parser *parser) {
 
 /* 解析条件表达式 */
 bool parse_conditional_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    
     if (!parse_logical_or_expression(parser)) {
         return false;
     }
     
     if (parser_match(parser, TOKEN_QUESTION)) {
-        if (!parse_assignment_expression(parser)) {
+        AstList children = {AST_NONE, AST_NONE};
+        push_node(parser, &children, parser->node);
+    
+        /* ? 和 : 之间总是允许in */
+        int no_in = parser->no_in;
+        parser->no_in = 0;
+        bool consequent = parse_assignment_expression(parser);
+        parser->no_in = no_in;
+        if (!consequent) {
             return false;
         }
-        
+        push_node(parser, &children, parser->node);
+    
         if (!parser_expect(parser, TOKEN_COLON)) {
             return false;
         }
-        
+    
         if (!parse_assignment_expression(parser)) {
             return false;
         }
+        push_node(parser, &children, parser->node);
+    
+        parser->node = build_node(parser, AST_CONDITIONAL_EXPRESSION, 0, start, children.first);
+        parser->cover = 0;
     }
     
     return true;
 }
 
+/* 创建二元表达式节点（||、&&、?? 为逻辑表达式），右操作数为parser->node */
+static void build_binary(Parser *parser, TokenType op, size_t start, uint32_t left) {
+    AstKind kind = (op == TOKEN_OR || op == TOKEN_AND || op == TOKEN_NULLISH) ?
+                   AST_LOGICAL_EXPRESSION : AST_BINARY_EXPRESSION;
+    parser->node = build_pair(parser, kind, op, start, left, parser->node);
+}
+
 /* 解析逻辑或表达式 */
 bool parse_logical_or_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    
     if (!parse_logical_and_expression(parser)) {
         return false;
     }
     
-    while (parser_match(parser, TOKEN_OR) || 
+    while (parser_match(parser, TOKEN_OR) ||
            parser_match(parser, TOKEN_NULLISH)) {
+        TokenType op = parser->prev_token->type;
+        uint32_t left = parser->node;
         if (!parse_logical_and_expression(parser)) {
             return false;
         }
+        build_binary(parser, op, start, left);
+        parser->cover = 0;
     }
     
     return true;
@@ -864,14 +2359,19 @@ bool parse_logical_or_expression(Parser *parser) {
 
 /* 解析逻辑与表达式 */
 bool parse_logical_and_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    
     if (!parse_bitwise_or_expression(parser)) {
         return false;
     }
     
     while (parser_match(parser, TOKEN_AND)) {
+        uint32_t left = parser->node;
         if (!parse_bitwise_or_expression(parser)) {
             return false;
         }
+        build_binary(parser, TOKEN_AND, start, left);
+        parser->cover = 0;
     }
     
     return true;
@@ -879,14 +2379,19 @@ bool parse_logical_and_expression(Parser *parser) {
 
 /* 解析位或表达式 */
 bool parse_bitwise_or_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    
     if (!parse_bitwise_xor_expression(parser)) {
         return false;
     }
     
     while (parser_match(parser, TOKEN_BITWISE_OR)) {
+        uint32_t left = parser->node;
         if (!parse_bitwise_xor_expression(parser)) {
             return false;
         }
+        build_binary(parser, TOKEN_BITWISE_OR, start, left);
+        parser->cover = 0;
     }
     
     return true;
@@ -894,14 +2399,19 @@ bool parse_bitwise_or_expression(Parser *parser) {
 
 /* 解析位异或表达式 */
 bool parse_bitwise_xor_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    
     if (!parse_bitwise_and_expression(parser)) {
         return false;
     }
     
     while (parser_match(parser, TOKEN_BITWISE_XOR)) {
+        uint32_t left = parser->node;
         if (!parse_bitwise_and_expression(parser)) {
             return false;
         }
+        build_binary(parser, TOKEN_BITWISE_XOR, start, left);
+        parser->cover = 0;
     }
     
     return true;
@@ -909,14 +2419,19 @@ bool parse_bitwise_xor_expression(Parser *parser) {
 
 /* 解析位与表达式 */
 bool parse_bitwise_and_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    
     if (!parse_equality_expression(parser)) {
         return false;
     }
     
     while (parser_match(parser, TOKEN_BITWISE_AND)) {
+        uint32_t left = parser->node;
         if (!parse_equality_expression(parser)) {
             return false;
         }
+        build_binary(parser, TOKEN_BITWISE_AND, start, left);
+        parser->cover = 0;
     }
     
     return true;
@@ -924,6 +2439,8 @@ bool parse_bitwise_and_expression(Parser *parser) {
 
 /* 解析相等表达式 */
 bool parse_equality_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    
     if (!parse_relational_expression(parser)) {
         return false;
     }
@@ -932,10 +2449,14 @@ bool parse_equality_expression(Parser *parser) {
            parser_check(parser, TOKEN_NE) ||
            parser_check(parser, TOKEN_EQ_STRICT) ||
            parser_check(parser, TOKEN_NE_STRICT)) {
+        TokenType op = parser->current_token->type;
+        uint32_t left = parser->node;
         parser_advance(parser);
         if (!parse_relational_expression(parser)) {
             return false;
         }
+        build_binary(parser, op, start, left);
+        parser->cover = 0;
     }
     
     return true;
@@ -943,6 +2464,8 @@ bool parse_equality_expression(Parser *parser) {
 
 /* 解析关系表达式 */
 bool parse_relational_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    
     if (!parse_shift_expression(parser)) {
         return false;
     }
@@ -952,223 +2475,659 @@ bool parse_relational_expression(Parser *parser) {
            parser_check(parser, TOKEN_GT) ||
            parser_check(parser, TOKEN_GE) ||
            parser_check(parser, TOKEN_INSTANCEOF) ||
-           parser_check(parser, TOKEN_IN)) {
+           (parser_check(parser, TOKEN_IN) && parser->no_in != parser->nesting + 1)) {
+        TokenType op = parser->current_token->type;
+        uint32_t left = parser->node;
         parser_advance(parser);
         if (!parse_shift_expression(parser)) {
             return false;
         }
+        build_binary(parser, op, start, left);
+        parser->cover = 0;
+    }
+    
+    return true;
+}
+
+/* 解析移位表达式 */
+bool parse_shift_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    
+    if (!parse_additive_expression(parser)) {
+        return false;
+    }
+    
+    while (parser_check(parser, TOKEN_LSHIFT) ||
+           parser_check(parser, TOKEN_RSHIFT) ||
+           parser_check(parser, TOKEN_URSHIFT)) {
+        TokenType op = parser->current_token->type;
+        uint32_t left = parser->node;
+        parser_advance(parser);
+        if (!parse_additive_expression(parser)) {
+            return false;
+        }
+        build_binary(parser, op, start, left);
+        parser->cover = 0;
+    }
+    
+    return true;
+}
+
+/* 解析加法表达式 */
+bool parse_additive_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    
+    if (!parse_multiplicative_expression(parser)) {
+        return false;
+    }
+    
+    while (parser_check(parser, TOKEN_PLUS) ||
+           parser_check(parser, TOKEN_MINUS)) {
+        TokenType op = parser->current_token->type;
+        uint32_t left = parser->node;
+        parser_advance(parser);
+        if (!parse_multiplicative_expression(parser)) {
+            return false;
+        }
+        build_binary(parser, op, start, left);
+        parser->cover = 0;
+    }
+    
+    return true;
+}
+
+/* 解析乘法表达式 */
+bool parse_multiplicative_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    
+    if (!parse_exponentiation_expression(parser)) {
+        return false;
+    }
+    
+    while (parser_check(parser, TOKEN_MULTIPLY) ||
+           parser_check(parser, TOKEN_DIVIDE) ||
+           parser_check(parser, TOKEN_MODULO)) {
+        TokenType op = parser->current_token->type;
+        uint32_t left = parser->node;
+        parser_advance(parser);
+        if (!parse_exponentiation_expression(parser)) {
+            return false;
+        }
+        build_binary(parser, op, start, left);
+        parser->cover = 0;
+    }
+    
+    return true;
+}
+
+/* 解析指数表达式 */
+bool parse_exponentiation_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    
+    if (!parse_unary_expression(parser)) {
+        return false;
+    }
+    
+    if (parser_match(parser, TOKEN_EXPONENT)) {
+        uint32_t left = parser->node;
+        if (!parse_exponentiation_expression(parser)) {
+            return false;
+        }
+        build_binary(parser, TOKEN_EXPONENT, start, left);
+        parser->cover = 0;
+    }
+    
+    return true;
+}
+
+/* ++/--的操作数必须是简单赋值目标 */
+static bool check_update_target(Parser *parser, Position position) {
+    if ((parser->cover & COVER_INITIALIZED) ||
+        !(parser->cover & COVER_SIMPLE_TARGET)) {
+        set_error(parser->error, ERROR_PARSER_INVALID_ASSIGNMENT,
+                 position, "Invalid update target");
+        return false;
+    }
+    return true;
+}
+
+/* 解析一元表达式 */
+bool parse_unary_expression(Parser *parser) {
+    if (is_unary_operator(parser->current_token->type)) {
+        TokenType op = parser->current_token->type;
+        bool update = op == TOKEN_INCREMENT || op == TOKEN_DECREMENT;
+        Position position = parser->current_token->start;
+    
+        parser_advance(parser);
+        if (!parse_unary_expression(parser)) {
+            return false;
+        }
+        if (update && !check_update_target(parser, position)) {
+            return false;
+        }
+        parser->node = build_node(parser, update ? AST_UPDATE_EXPRESSION : AST_UNARY_EXPRESSION,
+                                  op, (size_t)position.offset, parser->node);
+        set_node_flags(parser, parser->node, AST_FLAG_PREFIX);
+        parser->cover = 0;
+        return true;
+    }
+    
+    /* async函数中的 await 表达式 */
+    if (parser->in_async && parser_check(parser, TOKEN_AWAIT)) {
+        size_t start = token_offset(parser);
+        parser_advance(parser);
+        if (!parse_unary_expression(parser)) {
+            return false;
+        }
+        parser->node = build_node(parser, AST_AWAIT_EXPRESSION, 0, start, parser->node);
+        parser->cover = 0;
+        return true;
+    }
+    
+    return parse_postfix_expression(parser);
+}
+
+/* 解析后缀表达式 */
+bool parse_postfix_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    
+    if (!parse_left_hand_side_expression(parser)) {
+        return false;
+    }
+    
+    /* ++ 或 -- */
+    if (!parser->current_token->preceded_by_newline) {
+        if (parser_check(parser, TOKEN_INCREMENT) ||
+            parser_check(parser, TOKEN_DECREMENT)) {
+            if (!check_update_target(parser, parser->current_token->start)) {
+                return false;
+            }
+            TokenType op = parser->current_token->type;
+            parser_advance(parser);
+            parser->node = build_node(parser, AST_UPDATE_EXPRESSION, op, start, parser->node);
+            parser->cover = 0;
+        }
+    }
+    
+    return true;
+}
+
+/* 解析调用参数列表 (a, ...b)，参数追加到args */
+static bool parse_arguments(Parser *parser, AstList *args) {
+    if (!parser_expect(parser, TOKEN_LPAREN)) {
+        return false;
+    }
+    
+    while (!parser_check(parser, TOKEN_RPAREN)) {
+        size_t start = token_offset(parser);
+        bool spread = parser_match(parser, TOKEN_SPREAD);
+        if (!parse_assignment_expression(parser)) {
+            return false;
+        }
+        push_node(parser, args, spread ?
+                  build_node(parser, AST_SPREAD_ELEMENT, 0, start, parser->node) :
+                  parser->node);
+        if (!parser_match(parser, TOKEN_COMMA)) {
+            break;
+        }
+    }
+    
+    return parser_expect(parser, TOKEN_RPAREN);
+}
+
+/* 解析左侧表达式 */
+bool parse_left_hand_side_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    
+    /* new表达式 */
+    if (parser_match(parser, TOKEN_NEW)) {
+        AstList children = {AST_NONE, AST_NONE};
+    
+        if (!parse_member_expression(parser)) {
+            return false;
+        }
+        push_node(parser, &children, parser->node);
+    
+        /* new后面可以有参数列表 */
+        if (parser_check(parser, TOKEN_LPAREN)) {
+            if (!parse_arguments(parser, &children)) {
+                return false;
+            }
+        }
+    
+        parser->node = build_node(parser, AST_NEW_EXPRESSION, 0, start, children.first);
+        parser->cover = 0;
+        return true;
+    }
+    
+    return parse_call_expression(parser);
+}
+
+/* 解析一次成员访问 .name、?.name 或 [expression] */
+static bool parse_member_access(Parser *parser, size_t start) {
+    uint32_t object = parser->node;
+    uint32_t property;
+    int flags = 0;
+    
+    if (parser_match(parser, TOKEN_DOT) ||
+        parser_match(parser, TOKEN_OPTIONAL_CHAIN)) {
+        if (parser->prev_token->type == TOKEN_OPTIONAL_CHAIN) {
+            flags |= AST_FLAG_OPTIONAL;
+        }
+        /* 属性名可以是关键字，如 a.default */
+        if (!is_identifier_name(parser->current_token->type)) {
+            return parser_expect(parser, TOKEN_IDENTIFIER);
+        }
+        parser_advance(parser);
+        property = build_token(parser, AST_IDENTIFIER, 0);
+    } else {
+        /* [ */
+        parser_advance(parser);
+        if (!parse_expression(parser)) {
+            return false;
+        }
+        property = parser->node;
+        if (!parser_expect(parser, TOKEN_RBRACKET)) {
+            return false;
+        }
+        flags |= AST_FLAG_COMPUTED;
+    }
+    
+    parser->node = build_pair(parser, AST_MEMBER_EXPRESSION, 0, start, object, property);
+    set_node_flags(parser, parser->node, flags);
+    return true;
+}
+
+/* 包含可选链的成员访问/调用整体包装为ChainExpression */
+static void build_chain(Parser *parser, size_t start) {
+    if (!parser->ast) return;
+    
+    uint32_t node = parser->node;
+    while (node != AST_NONE) {
+        AstNode *n = &parser->ast->nodes[node];
+        if (n->kind != AST_MEMBER_EXPRESSION && n->kind != AST_CALL_EXPRESSION) {
+            return;
+        }
+        if (n->flags & AST_FLAG_OPTIONAL) {
+            parser->node = build_node(parser, AST_CHAIN_EXPRESSION, 0, start, parser->node);
+            return;
+        }
+        node = n->first_child;
+    }
+}
+
+/* 解析调用表达式 */
+bool parse_call_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    
+    if (!parse_member_expression(parser)) {
+        return false;
+    }
+    
+    /* 函数调用（可选链之后的成员访问不能作为赋值目标） */
+    bool optional = false;
+    while (parser_check(parser, TOKEN_LPAREN)) {
+        AstList children = {AST_NONE, AST_NONE};
+        push_node(parser, &children, parser->node);
+        if (!parse_arguments(parser, &children)) {
+            return false;
+        }
+        parser->node = build_node(parser, AST_CALL_EXPRESSION, 0, start, children.first);
+        parser->cover = 0;
+    
+        /* 调用后可以继续访问成员 */
+        while (parser_check(parser, TOKEN_DOT) ||
+               parser_check(parser, TOKEN_LBRACKET) ||
+               parser_check(parser, TOKEN_OPTIONAL_CHAIN)) {
+            optional = optional || parser_check(parser, TOKEN_OPTIONAL_CHAIN);
+            if (!parse_member_access(parser, start)) {
+                return false;
+            }
+            parser->cover = optional ? 0 : COVER_SIMPLE_TARGET;
+        }
+    }
+    
+    build_chain(parser, start);
+    return true;
+}
+
+/* 解析成员表达式 */
+bool parse_member_expression(Parser *parser) {
+    int pending = parser->cover_pending;
+    size_t start = token_offset(parser);
+    
+    if (!parse_primary_expression(parser)) {
+        return false;
+    }
+    
+    /* 成员访问（可选链不能作为赋值目标） */
+    bool optional = false;
+    while (parser_check(parser, TOKEN_DOT) ||
+           parser_check(parser, TOKEN_LBRACKET) ||
+           parser_check(parser, TOKEN_OPTIONAL_CHAIN)) {
+        /* 带简写初始化的对象字面量不能再被访问成员 */
+        if (parser->cover_pending > pending) {
+            set_error(parser->error, ERROR_PARSER_UNEXPECTED_TOKEN,
+                     parser->cover_position, "Invalid shorthand property initializer");
+            return false;
+        }
+        optional = optional || parser_check(parser, TOKEN_OPTIONAL_CHAIN);
+    
+        if (!parse_member_access(parser, start)) {
+            return false;
+        }
+        parser->cover = optional ? 0 : COVER_SIMPLE_TARGET;
+    }
+    
+    return true;
+}
+
+/* 解析括号：只解析一次，之后根据是否紧随 => 解释为箭头函数参数或分组表达式。
+   async为真时前一个token是async：括号是async箭头函数的参数，或者是调用async(...)的参数 */
+static bool parse_parenthesized(Parser *parser, bool async) {
+    int pending = parser->cover_pending;
+    bool params = true;         /* 每个元素都可以转换为绑定元素 */
+    bool expression = true;     /* 没有剩余元素和尾逗号 */
+    int count = 0;
+    int cover = 0;
+    size_t start = token_offset(parser);
+    size_t callee_end = 0;
+    AstList elements = {AST_NONE, AST_NONE};
+    
+    if (async) {
+        start = (size_t)parser->prev_token->start.offset;
+        callee_end = (size_t)parser->prev_token->end.offset;
+    }
+    
+    /* ( */
+    parser_advance(parser);
+    
+    while (!parser_check(parser, TOKEN_RPAREN)) {
+        /* 剩余参数：必须是最后一个，且不能有默认值 */
+        if (parser_check(parser, TOKEN_SPREAD)) {
+            size_t spread_start = token_offset(parser);
+            parser_advance(parser);
+            parser->cover_element = true;
+            if (!parse_assignment_expression(parser)) {
+                return false;
+            }
+            if ((parser->cover & COVER_INITIALIZED) ||
+                !(parser->cover & (COVER_IDENTIFIER | COVER_BINDING_PATTERN))) {
+                params = false;
+            }
+            push_node(parser, &elements,
+                      build_node(parser, AST_SPREAD_ELEMENT, 0, spread_start, parser->node));
+            expression = false;
+            break;
+        }
+    
+        parser->cover_element = true;
+        if (!parse_assignment_expression(parser)) {
+            return false;
+        }
+        push_node(parser, &elements, parser->node);
+        cover = parser->cover;
+        if (!(cover & (COVER_IDENTIFIER | COVER_BINDING_PATTERN))) {
+            params = false;
+        }
+        count++;
+    
+        if (!parser_match(parser, TOKEN_COMMA)) {
+            break;
+        }
+        if (parser_check(parser, TOKEN_RPAREN)) {
+            expression = false;
+        }
     }
     
-    return true;
-}
-
-/* 解析移位表达式 */
-bool parse_shift_expression(Parser *parser) {
-    if (!parse_additive_expression(parser)) {
+    if (!parser_expect(parser, TOKEN_RPAREN)) {
         return false;
     }
     
-    while (parser_check(parser, TOKEN_LSHIFT) ||
-           parser_check(parser, TOKEN_RSHIFT) ||
-           parser_check(parser, TOKEN_URSHIFT)) {
-        parser_advance(parser);
-        if (!parse_additive_expression(parser)) {
+    /* 箭头函数参数：其中的简写初始化都已转换为绑定模式 */
+    if (parser_check(parser, TOKEN_ARROW) &&
+        !parser->current_token->preceded_by_newline) {
+        if (!params) {
+            set_error(parser->error, ERROR_PARSER_UNEXPECTED_TOKEN,
+                     parser->current_token->start, "Invalid arrow function parameters");
             return false;
         }
-    }
+        parser->cover_pending = pending;
+        parser->cover = COVER_ARROW_HEAD | (async ? COVER_ASYNC_ARROW : 0);
     
-    return true;
-}
-
-/* 解析加法表达式 */
-bool parse_additive_expression(Parser *parser) {
-    if (!parse_multiplicative_expression(parser)) {
-        return false;
+        /* 参数暂存为括号（或从async开始）范围的序列节点，由parse_arrow_function取出 */
+        parser->node = build_node(parser, AST_SEQUENCE_EXPRESSION, 0, start, elements.first);
+        return true;
     }
     
-    while (parser_check(parser, TOKEN_PLUS) ||
-           parser_check(parser, TOKEN_MINUS)) {
-        parser_advance(parser);
-        if (!parse_multiplicative_expression(parser)) {
+    /* 函数调用 async(...)：各元素是实参 */
+    if (async) {
+        if (parser->cover_pending > pending) {
+            set_error(parser->error, ERROR_PARSER_UNEXPECTED_TOKEN,
+                     parser->cover_position, "Invalid shorthand property initializer");
             return false;
         }
+        AstList call = {AST_NONE, AST_NONE};
+        uint32_t callee = build_node_at(parser, AST_IDENTIFIER, 0, start, callee_end, AST_NONE);
+        push_node(parser, &call, callee);
+        link_sibling(parser, callee, elements.first);
+        parser->node = build_node(parser, AST_CALL_EXPRESSION, 0, start, call.first);
+        parser->cover = 0;
+        return true;
     }
     
-    return true;
-}
-
-/* 解析乘法表达式 */
-bool parse_multiplicative_expression(Parser *parser) {
-    if (!parse_exponentiation_expression(parser)) {
+    /* 分组表达式 */
+    if (count == 0 || !expression) {
+        set_error(parser->error, ERROR_PARSER_EXPECTED_TOKEN,
+                 parser->current_token->start, "Expected '=>' after parameter list");
+        return false;
+    }
+    if (parser->cover_pending > pending) {
+        set_error(parser->error, ERROR_PARSER_UNEXPECTED_TOKEN,
+                 parser->cover_position, "Invalid shorthand property initializer");
         return false;
     }
     
-    while (parser_check(parser, TOKEN_MULTIPLY) ||
-           parser_check(parser, TOKEN_DIVIDE) ||
-           parser_check(parser, TOKEN_MODULO)) {
-        parser_advance(parser);
-        if (!parse_exponentiation_expression(parser)) {
-            return false;
-        }
+    /* 括号本身不产生节点；多个元素组成逗号表达式 */
+    if (count == 1 || !parser->ast || elements.first == AST_NONE) {
+        parser->node = elements.first;
+    } else {
+        parser->node = build_node_at(parser, AST_SEQUENCE_EXPRESSION, 0,
+                                     parser->ast->nodes[elements.first].start,
+                                     parser->ast->nodes[elements.last].end,
+                                     elements.first);
     }
     
+    /* 加括号的简单目标仍可被赋值，但不再是绑定标识符或模式 */
+    parser->cover = (count == 1 && !(cover & COVER_INITIALIZED)) ?
+                    (cover & COVER_SIMPLE_TARGET) : 0;
     return true;
 }
 
-/* 解析指数表达式 */
-bool parse_exponentiation_expression(Parser *parser) {
-    if (!parse_unary_expression(parser)) {
+/* 解析箭头函数体（参数已经解析，当前token为=>） */
+bool parse_arrow_function(Parser *parser) {
+    uint32_t head = parser->node;
+    size_t start = token_offset(parser);
+    AstList children = {AST_NONE, AST_NONE};
+    int flags = (parser->cover & COVER_ASYNC_ARROW) ? AST_FLAG_ASYNC : 0;
+    
+    /* 参数：单个标识符，或括号中的各元素转换为模式 */
+    if (parser->ast && head != AST_NONE) {
+        start = parser->ast->nodes[head].start;
+        if (parser->cover & COVER_IDENTIFIER) {
+            push_node(parser, &children, head);
+        } else {
+            uint32_t param = parser->ast->nodes[head].first_child;
+            while (param != AST_NONE) {
+                uint32_t next = parser->ast->nodes[param].next_sibling;
+                parser->ast->nodes[param].next_sibling = AST_NONE;
+                ast_to_pattern(parser->ast, param);
+                push_node(parser, &children, param);
+                param = next;
+            }
+        }
+    }
+    
+    if (!parser_expect(parser, TOKEN_ARROW)) {
         return false;
     }
     
-    if (parser_match(parser, TOKEN_EXPONENT)) {
-        if (!parse_exponentiation_expression(parser)) {
-            return false;
-        }
+    /* 函数体：async箭头函数中await是运算符，箭头函数不能是生成器 */
+    bool in_async = parser->in_async;
+    bool in_generator = parser->in_generator;
+    parser->in_async = (flags & AST_FLAG_ASYNC) != 0;
+    parser->in_generator = false;
+    
+    bool expression = !parser_check(parser, TOKEN_LBRACE);
+    bool result = expression ? parse_assignment_expression(parser) :
+                               parse_block_statement(parser);
+    parser->in_async = in_async;
+    parser->in_generator = in_generator;
+    if (!result) {
+        return false;
     }
+    push_node(parser, &children, parser->node);
     
+    parser->node = build_node(parser, AST_ARROW_FUNCTION_EXPRESSION, 0, start, children.first);
+    set_node_flags(parser, parser->node, flags | (expression ? AST_FLAG_EXPRESSION : 0));
+    parser->cover = 0;
     return true;
 }
 
-/* 解析一元表达式 */
-bool parse_unary_expression(Parser *parser) {
-    if (is_unary_operator(parser->current_token->type)) {
-        parser_advance(parser);
-        return parse_unary_expression(parser);
-    }
-    
-    return parse_postfix_expression(parser);
+/* 模板字符串中与 ${ 配对的 } 开始的一段 */
+static bool template_continues(const Token *token) {
+    return token->type == TOKEN_TEMPLATE && token->value && token->value[0] == '}';
 }
 
-/* 解析后缀表达式 */
-bool parse_postfix_expression(Parser *parser) {
-    if (!parse_left_hand_side_expression(parser)) {
-        return false;
-    }
+/* 解析模板字符串：文字段为TemplateElement（不含两端的 `、${ 和 }），
+   各段之间是 ${} 中的表达式 */
+static bool parse_template_literal(Parser *parser) {
+    size_t start = token_offset(parser);
+    AstList children = {AST_NONE, AST_NONE};
     
-    /* ++ 或 -- */
-    if (!parser->current_token->preceded_by_newline) {
-        if (parser_check(parser, TOKEN_INCREMENT) ||
-            parser_check(parser, TOKEN_DECREMENT)) {
-            parser_advance(parser);
+    for (;;) {
+        parser_advance(parser);
+        Token *piece = parser->prev_token;
+        bool substitution = piece->value && piece->value[piece->length - 1] == '{';
+        uint32_t quasi = build_node_at(parser, AST_TEMPLATE_ELEMENT, 0,
+                                       (size_t)piece->start.offset + 1,
+                                       (size_t)piece->end.offset - (substitution ? 2 : 1),
+                                       AST_NONE);
+        push_node(parser, &children, quasi);
+        if (!substitution) {
+            set_node_flags(parser, quasi, AST_FLAG_TAIL);
+            break;
+        }
+    
+        if (template_continues(parser->current_token)) {
+            set_error(parser->error, ERROR_PARSER_UNEXPECTED_TOKEN,
+                     parser->current_token->start, "Empty template substitution");
+            return false;
+        }
+    
+        /* ${} 中总是允许in */
+        int no_in = parser->no_in;
+        parser->no_in = 0;
+        bool result = parse_expression(parser);
+        parser->no_in = no_in;
+        if (!result) {
+            return false;
+        }
+        push_node(parser, &children, parser->node);
+    
+        if (!template_continues(parser->current_token)) {
+            set_error(parser->error, ERROR_PARSER_EXPECTED_TOKEN,
+                     parser->current_token->start, "Expected '}' after template substitution");
+            return false;
         }
     }
     
+    parser->node = build_node(parser, AST_TEMPLATE_LITERAL, 0, start, children.first);
+    parser->cover = 0;
     return true;
 }
 
-/* 解析左侧表达式 */
-bool parse_left_hand_side_expression(Parser *parser) {
-    /* new表达式 */
-    if (parser_match(parser, TOKEN_NEW)) {
-        if (!parse_member_expression(parser)) {
+/* 解析 import(source[, options]) 和 import.meta */
+static bool parse_import_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    AstList children = {AST_NONE, AST_NONE};
+    
+    /* import */
+    parser_advance(parser);
+    parser->cover = 0;
+    
+    if (parser_match(parser, TOKEN_DOT)) {
+        push_node(parser, &children,
+                  build_node_at(parser, AST_IDENTIFIER, 0, start, start + 6, AST_NONE));
+        if (!parser->module) {
+            set_error(parser->error, ERROR_PARSER_UNEXPECTED_TOKEN, parser->current_token->start,
+                     "import.meta is only allowed in modules");
             return false;
         }
-        
-        /* new后面可以有参数列表 */
-        if (parser_check(parser, TOKEN_LPAREN)) {
-            parser_advance(parser);
-            
-            /* 参数列表 */
-            if (!parser_check(parser, TOKEN_RPAREN)) {
-                if (!parse_assignment_expression(parser)) {
-                    return false;
-                }
-                
-                while (parser_match(parser, TOKEN_COMMA)) {
-                    if (!parse_assignment_expression(parser)) {
-                        return false;
-                    }
-                }
-            }
-            
-            if (!parser_expect(parser, TOKEN_RPAREN)) {
-                return false;
-            }
+        if (!expect_word(parser, "meta")) {
+            return false;
         }
-        
+        push_node(parser, &children, build_token(parser, AST_IDENTIFIER, 0));
+        parser->node = build_node(parser, AST_META_PROPERTY, 0, start, children.first);
         return true;
     }
     
-    return parse_call_expression(parser);
-}
-
-/* 解析调用表达式 */
-bool parse_call_expression(Parser *parser) {
-    if (!parse_member_expression(parser)) {
+    if (!parser_expect(parser, TOKEN_LPAREN) || !parse_assignment_expression(parser)) {
         return false;
     }
-    
-    /* 函数调用 */
-    while (parser_check(parser, TOKEN_LPAREN)) {
-        parser_advance(parser);
-        
-        /* 参数列表 */
-        if (!parser_check(parser, TOKEN_RPAREN)) {
-            if (!parse_assignment_expression(parser)) {
-                return false;
-            }
-            
-            while (parser_match(parser, TOKEN_COMMA)) {
-                if (!parse_assignment_expression(parser)) {
-                    return false;
-                }
-            }
-        }
-        
-        if (!parser_expect(parser, TOKEN_RPAREN)) {
+    push_node(parser, &children, parser->node);
+    if (parser_match(parser, TOKEN_COMMA) && !parser_check(parser, TOKEN_RPAREN)) {
+        if (!parse_assignment_expression(parser)) {
             return false;
         }
-        
-        /* 调用后可以继续访问成员 */
-        while (parser_check(parser, TOKEN_DOT) ||
-               parser_check(parser, TOKEN_LBRACKET) ||
-               parser_check(parser, TOKEN_OPTIONAL_CHAIN)) {
-            if (parser_match(parser, TOKEN_DOT) ||
-                parser_match(parser, TOKEN_OPTIONAL_CHAIN)) {
-                if (!parser_expect(parser, TOKEN_IDENTIFIER)) {
-                    return false;
-                }
-            } else if (parser_match(parser, TOKEN_LBRACKET)) {
-                if (!parse_expression(parser)) {
-                    return false;
-                }
-                if (!parser_expect(parser, TOKEN_RBRACKET)) {
-                    return false;
-                }
-            }
-        }
+        push_node(parser, &children, parser->node);
+        parser_match(parser, TOKEN_COMMA);
     }
-    
+    if (!parser_expect(parser, TOKEN_RPAREN)) {
+        return false;
+    }
+    parser->node = build_node(parser, AST_IMPORT_EXPRESSION, 0, start, children.first);
+    parser->cover = 0;
     return true;
 }
 
-/* 解析成员表达式 */
-bool parse_member_expression(Parser *parser) {
-    if (!parse_primary_expression(parser)) {
-        return false;
+/* 解析以async开始的主表达式：async function 表达式、async x => ... 或 async (...) => ...；
+   其后换行或不是这些形式时async是普通标识符（包括调用async(...)） */
+static bool parse_async_expression(Parser *parser) {
+    size_t start = token_offset(parser);
+    
+    if (peek_function(parser)) {
+        parser->cover = 0;
+        return parse_function(parser, AST_FUNCTION_EXPRESSION);
     }
     
-    /* 成员访问 */
-    while (parser_check(parser, TOKEN_DOT) ||
-           parser_check(parser, TOKEN_LBRACKET) ||
-           parser_check(parser, TOKEN_OPTIONAL_CHAIN)) {
-        if (parser_match(parser, TOKEN_DOT) ||
-            parser_match(parser, TOKEN_OPTIONAL_CHAIN)) {
-            if (!parser_expect(parser, TOKEN_IDENTIFIER)) {
-                return false;
-            }
-        } else if (parser_match(parser, TOKEN_LBRACKET)) {
-            if (!parse_expression(parser)) {
-                return false;
-            }
-            if (!parser_expect(parser, TOKEN_RBRACKET)) {
-                return false;
-            }
+    /* async */
+    parser_advance(parser);
+    Token *token = parser->current_token;
+    
+    if (token->preceded_by_newline ||
+        (token->type != TOKEN_IDENTIFIER && token->type != TOKEN_LPAREN)) {
+        parser->node = build_token(parser, AST_IDENTIFIER, 0);
+        parser->cover = COVER_SIMPLE_TARGET | COVER_IDENTIFIER;
+        return true;
+    }
+    
+    /* 单个参数：参数暂存为从async开始的序列节点，由parse_arrow_function取出 */
+    if (token->type == TOKEN_IDENTIFIER) {
+        parser_advance(parser);
+        uint32_t param = build_token(parser, AST_IDENTIFIER, 0);
+        if (!parser_check(parser, TOKEN_ARROW) || parser->current_token->preceded_by_newline) {
+            set_error(parser->error, ERROR_PARSER_EXPECTED_TOKEN,
+                     parser->current_token->start, "Expected '=>' after async arrow parameter");
+            return false;
         }
+        parser->node = build_node(parser, AST_SEQUENCE_EXPRESSION, 0, start, param);
+        parser->cover = COVER_ARROW_HEAD | COVER_ASYNC_ARROW;
+        return true;
     }
     
-    return true;
+    /* 括号中的参数列表，或调用async(...) */
+    return parse_parenthesized(parser, true);
 }
 
 /* 觨析主表达式 */
@@ -1180,44 +3139,74 @@ bool parse_primary_expression(Parser *parser) {
         return false;
     }
     
-    switch (parser->current_token->type) {
+    TokenType type = parser->current_token->type;
+    switch (type) {
         case TOKEN_IDENTIFIER:
+            parser_advance(parser);
+            parser->node = build_token(parser, AST_IDENTIFIER, 0);
+            parser->cover = COVER_SIMPLE_TARGET | COVER_IDENTIFIER;
+            return true;
+    
+        case TOKEN_UNDEFINED:
+            parser_advance(parser);
+            parser->node = build_token(parser, AST_IDENTIFIER, 0);
+            parser->cover = 0;
+            return true;
+    
         case TOKEN_THIS:
         case TOKEN_SUPER:
+            parser_advance(parser);
+            parser->node = build_token(parser, type == TOKEN_THIS ?
+                                       AST_THIS_EXPRESSION : AST_SUPER, 0);
+            parser->cover = 0;
+            return true;
+    
         case TOKEN_NUMBER:
         case TOKEN_STRING:
         case TOKEN_TRUE:
         case TOKEN_FALSE:
         case TOKEN_NULL:
-        case TOKEN_UNDEFINED:
         case TOKEN_REGEX:
-        case TOKEN_TEMPLATE:
             parser_advance(parser);
+            parser->node = build_token(parser, AST_LITERAL, type);
+            parser->cover = 0;
             return true;
-            
-        case TOKEN_LPAREN:
-            /* 分组表达式或箭头函数参数 */
-            parser_advance(parser);
-            if (!parse_expression(parser)) {
+    
+        case TOKEN_TEMPLATE:
+            if (template_continues(parser->current_token)) {
+                set_error(parser->error, ERROR_PARSER_UNEXPECTED_TOKEN,
+                         parser->current_token->start,
+                         "Unexpected end of template substitution");
                 return false;
             }
-            return parser_expect(parser, TOKEN_RPAREN);
-            
+            return parse_template_literal(parser);
+    
+        case TOKEN_LPAREN:
+            /* 分组表达式或箭头函数参数 */
+            return parse_parenthesized(parser, false);
+    
         case TOKEN_LBRACKET:
             return parse_array_literal(parser);
-            
+    
         case TOKEN_LBRACE:
             return parse_object_literal(parser);
-            
+    
         case TOKEN_FUNCTION:
-            return parse_function_declaration(parser);
-            
+            parser->cover = 0;
+            return parse_function(parser, AST_FUNCTION_EXPRESSION);
+    
+        case TOKEN_ASYNC:
+            return parse_async_expression(parser);
+    
+        case TOKEN_IMPORT:
+            return parse_import_expression(parser);
+    
         case TOKEN_EOF:
             set_error(parser->error, ERROR_PARSER_UNEXPECTED_EOF,
                      parser->current_token->start,
                      "Unexpected end of file in expression");
             return false;
-            
+    
         default:
             {
                 char msg[256];
@@ -1230,96 +3219,195 @@ bool parse_primary_expression(Parser *parser) {
     }
 }
 
-/* 解析数组字面量 */
+/* 解析数组字面量（同时判断能否转换为解构模式） */
 bool parse_array_literal(Parser *parser) {
+    bool assign_ok = true;
+    bool bind_ok = true;
+    size_t start = token_offset(parser);
+    AstList elements = {AST_NONE, AST_NONE};
+    
     if (!parser_expect(parser, TOKEN_LBRACKET)) {
         return false;
     }
     
     /* 元素 */
-    if (!parser_check(parser, TOKEN_RBRACKET)) {
+    while (!parser_check(parser, TOKEN_RBRACKET)) {
         /* 允许省略元素 */
-        if (!parser_check(parser, TOKEN_COMMA)) {
-            if (!parse_assignment_expression(parser)) {
-                return false;
-            }
+        if (parser_check(parser, TOKEN_COMMA)) {
+            push_node(parser, &elements, build_null(parser));
+            parser_advance(parser);
+            continue;
         }
-        
-        while (parser_match(parser, TOKEN_COMMA)) {
-            if (parser_check(parser, TOKEN_RBRACKET)) break;
-            
-            if (!parser_check(parser, TOKEN_COMMA)) {
-                if (!parse_assignment_expression(parser)) {
-                    return false;
-                }
-            }
+    
+        size_t element_start = token_offset(parser);
+        bool spread = parser_match(parser, TOKEN_SPREAD);
+        parser->cover_element = true;
+        if (!parse_assignment_expression(parser)) {
+            return false;
+        }
+        push_node(parser, &elements, spread ?
+                  build_node(parser, AST_SPREAD_ELEMENT, 0, element_start, parser->node) :
+                  parser->node);
+    
+        int cover = parser->cover;
+        if (spread && ((cover & COVER_INITIALIZED) ||
+                       !parser_check(parser, TOKEN_RBRACKET))) {
+            /* 剩余元素必须是最后一个，且不能有默认值 */
+            cover = 0;
+        }
+        if (!(cover & (COVER_SIMPLE_TARGET | COVER_ASSIGN_PATTERN))) {
+            assign_ok = false;
+        }
+        if (!(cover & (COVER_IDENTIFIER | COVER_BINDING_PATTERN))) {
+            bind_ok = false;
+        }
+    
+        if (!parser_match(parser, TOKEN_COMMA)) {
+            break;
         }
     }
     
-    return parser_expect(parser, TOKEN_RBRACKET);
+    if (!parser_expect(parser, TOKEN_RBRACKET)) {
+        return false;
+    }
+    
+    parser->node = build_node(parser, AST_ARRAY_EXPRESSION, 0, start, elements.first);
+    parser->cover = (assign_ok ? COVER_ASSIGN_PATTERN : 0) |
+                    (bind_ok ? COVER_BINDING_PATTERN : 0);
+    return true;
 }
 
-/* 解析对象字面量 */
+/* 解析对象字面量（同时判断能否转换为解构模式） */
 bool parse_object_literal(Parser *parser) {
+    bool assign_ok = true;
+    bool bind_ok = true;
+    size_t start = token_offset(parser);
+    AstList properties = {AST_NONE, AST_NONE};
+    
     if (!parser_expect(parser, TOKEN_LBRACE)) {
         return false;
     }
     
     /* 属性 */
-    while (!parser_check(parser, TOKEN_RBRACE) && 
+    while (!parser_check(parser, TOKEN_RBRACE) &&
            !parser_check(parser, TOKEN_EOF)) {
-        /* 属性名 */
-        if (parser_check(parser, TOKEN_IDENTIFIER) ||
-            parser_check(parser, TOKEN_STRING) ||
-            parser_check(parser, TOKEN_NUMBER)) {
+        size_t property_start = token_offset(parser);
+        bool shorthand = parser_check(parser, TOKEN_IDENTIFIER);
+        bool named = false;         /* async/get/set 本身就是属性名 */
+        bool computed = false;
+        int flags = 0;
+        int function_flags = 0;     /* 方法的async、*前缀 */
+        uint32_t key = AST_NONE;
+        uint32_t value;
+    
+        if (parser_check(parser, TOKEN_SPREAD)) {
+            /* 展开运算符；作为剩余属性时必须是最后一个简单目标 */
             parser_advance(parser);
-        } else if (parser_match(parser, TOKEN_LBRACKET)) {
-            /* 计算属性名 */
-            if (!parse_expression(parser)) {
+            if (!parse_assignment_expression(parser)) {
                 return false;
             }
-            if (!parser_expect(parser, TOKEN_RBRACKET)) {
-                return false;
+            push_node(parser, &properties,
+                      build_node(parser, AST_SPREAD_ELEMENT, 0, property_start, parser->node));
+            if (!(parser->cover & COVER_SIMPLE_TARGET) ||
+                !parser_check(parser, TOKEN_RBRACE)) {
+                assign_ok = false;
             }
-        } else if (parser_check(parser, TOKEN_SPREAD)) {
-            /* 展开运算符 */
-            parser_advance(parser);
-            if (!parse_assignment_expression(parser)) {
-                return false;
+            if (!(parser->cover & COVER_IDENTIFIER) ||
+                !parser_check(parser, TOKEN_RBRACE)) {
+                bind_ok = false;
             }
             if (parser_match(parser, TOKEN_COMMA)) {
                 continue;
             }
             break;
-        } else {
-            break;
         }
-        
+    
+        /* async、* 方法和get/set访问器；前缀之后不是属性名时它本身就是属性名 */
+        named = parse_method_prefix(parser, &flags, &function_flags, &key);
+    
+        /* 属性名 */
+        if (!named) {
+            if (!is_property_name_start(parser->current_token->type)) {
+                break;
+            }
+            if (!parse_property_name(parser, &computed)) {
+                return false;
+            }
+            key = parser->node;
+        }
+        if (computed) {
+            flags |= AST_FLAG_COMPUTED;
+        }
+    
         /* 方法或属性值 */
-        if (parser_match(parser, TOKEN_COLON)) {
-            if (!parse_assignment_expression(parser)) {
+        if (flags & (AST_FLAG_GETTER | AST_FLAG_SETTER)) {
+            /* 访问器 */
+            if (!parse_method_function(parser, 0)) {
                 return false;
             }
-        } else if (parser_match(parser, TOKEN_LPAREN)) {
+            value = parser->node;
+            assign_ok = false;
+            bind_ok = false;
+        } else if (parser_check(parser, TOKEN_LPAREN) || function_flags) {
             /* 方法 */
-            while (!parser_check(parser, TOKEN_RPAREN) && 
-                   !parser_check(parser, TOKEN_EOF)) {
-                parser_advance(parser);
+            if (!parse_method_function(parser, function_flags)) {
+                return false;
             }
-            if (!parser_expect(parser, TOKEN_RPAREN)) {
+            value = parser->node;
+            flags |= AST_FLAG_METHOD;
+            assign_ok = false;
+            bind_ok = false;
+        } else if (parser_match(parser, TOKEN_COLON)) {
+            parser->cover_element = true;
+            if (!parse_assignment_expression(parser)) {
                 return false;
             }
-            if (!parse_block_statement(parser)) {
+            value = parser->node;
+            if (!(parser->cover & (COVER_SIMPLE_TARGET | COVER_ASSIGN_PATTERN))) {
+                assign_ok = false;
+            }
+            if (!(parser->cover & (COVER_IDENTIFIER | COVER_BINDING_PATTERN))) {
+                bind_ok = false;
+            }
+        } else if (shorthand && parser_check(parser, TOKEN_ASSIGN)) {
+            /* 简写初始化 {a = 1}：只在转换为解构模式时合法 */
+            if (parser->cover_pending++ == 0) {
+                parser->cover_position = parser->current_token->start;
+            }
+            parser_advance(parser);
+            uint32_t target = build_copy(parser, key);
+            if (!parse_assignment_expression(parser)) {
                 return false;
             }
+            value = build_pair(parser, AST_ASSIGNMENT_PATTERN, TOKEN_ASSIGN, property_start,
+                               target, parser->node);
+            flags |= AST_FLAG_SHORTHAND;
+        } else if (shorthand) {
+            /* 简写属性 {a} */
+            value = build_copy(parser, key);
+            flags |= AST_FLAG_SHORTHAND;
+        } else {
+            /* 其他属性名后必须有值 */
+            return parser_expect(parser, TOKEN_COLON);
         }
-        
+    
+        uint32_t property = build_pair(parser, AST_PROPERTY, 0, property_start, key, value);
+        set_node_flags(parser, property, flags);
+        push_node(parser, &properties, property);
+    
         if (!parser_match(parser, TOKEN_COMMA)) {
             break;
         }
     }
     
-    return parser_expect(parser, TOKEN_RBRACE);
+    if (!parser_expect(parser, TOKEN_RBRACE)) {
+        return false;
+    }
+    
+    parser->node = build_node(parser, AST_OBJECT_EXPRESSION, 0, start, properties.first);
+    parser->cover = (assign_ok ? COVER_ASSIGN_PATTERN : 0) |
+                    (bind_ok ? COVER_BINDING_PATTERN : 0);
+    return true;
 }
 
 /* 主解析函数 */
@@ -2,8 +2,56 @@
 #define PARSER_H
 
 #include "lexer.h"
+#include "ast.h"
 #include "common.h"
 
+#define STATEMENT_NONE SIZE_MAX
+
+/* 语句范围（增量解析使用）：[start, end) 从语句的第一个token到其后的第一个token */
+typedef struct {
+    size_t start;           /* 第一个token的偏移 */
+    size_t end;             /* 其后第一个token的偏移 */
+    size_t parent;          /* 外层语句的下标，顶层为STATEMENT_NONE */
+    size_t subtree_end;     /* 内层语句之后的第一个下标 */
+    int depth;              /* 开始解析时的递归深度 */
+    bool in_async;          /* 开始解析时位于async函数中（await是运算符） */
+    bool in_generator;      /* 开始解析时位于生成器中（yield是运算符） */
+    bool in_template;       /* 位于模板替换 ${} 中（单独解析时无法得知其后的 } 属于模板） */
+    bool in_list;           /* 位于语句列表中（其后可以继续出现语句） */
+    TokenType first_type;   /* 第一个token */
+    size_t first_length;
+    bool first_newline;
+    bool first_regex;       /* 读入第一个token后 / 是否开始正则 */
+    TokenType last_type;    /* 最后一个token（决定其后的 / 是否开始正则） */
+    TokenType follow_type;  /* 其后的第一个token */
+    size_t follow_length;
+    bool follow_newline;
+    bool follow_regex;
+} StatementSpan;
+
+/* 语句范围表（按起始偏移排序，即先序） */
+typedef struct {
+    StatementSpan *spans;
+    size_t count;
+    size_t capacity;
+    size_t open;            /* 正在解析的最内层语句 */
+    size_t last;            /* 最近解析完成的语句 */
+    bool failed;            /* 记录过程中内存不足 */
+} StatementTable;
+
+/* 表达式的覆盖语法形式（Parser.cover）：表达式只解析一次，
+   之后根据紧随的token（=或=>）把它重新解释为赋值模式或箭头函数参数 */
+#define COVER_SIMPLE_TARGET   0x01  /* 标识符或成员访问，可作为任意赋值运算符的目标 */
+#define COVER_IDENTIFIER      0x02  /* 未加括号的单个标识符，可作为绑定标识符 */
+#define COVER_ASSIGN_PATTERN  0x04  /* 数组/对象字面量，可以转换为赋值模式 */
+#define COVER_BINDING_PATTERN 0x08  /* 数组/对象字面量，可以转换为绑定模式 */
+#define COVER_INITIALIZED     0x10  /* target = value 形式，只能作为模式中的元素 */
+#define COVER_ARROW_HEAD      0x20  /* 已确认的箭头函数参数列表，其后是 => */
+#define COVER_ASYNC_ARROW     0x40  /* async箭头函数的参数列表（与COVER_ARROW_HEAD同时出现） */
+
+/* token回调：每个token被越过时调用一次，asi表示在它之前自动插入了分号 */
+typedef void (*TokenCallback)(void *context, const Token *token, bool asi);
+
 /* 语法分析器状态 */
 typedef struct {
     Lexer *lexer;           /* 词法分析器 */
@@ -12,12 +60,30 @@ typedef struct {
     ErrorInfo *error;       /* 错误信息 */
     bool asi_allowed;       /* 是否允许ASI插入 */
     int depth;              /* 递归深度（防止栈溢出） */
+    StatementTable *statements; /* 非NULL时记录每条语句的范围 */
+    int cover;              /* 最近解析的表达式的覆盖形式（COVER_*） */
+    bool cover_element;     /* 下一个赋值表达式位于可转换为模式的元素位置 */
+    int cover_pending;      /* 尚未转换为模式的简写初始化 {a = 1} 个数 */
+    Position cover_position; /* 第一个未转换的简写初始化的位置 */
+    Ast *ast;               /* 非NULL时构建AST，NULL时只做语法验证 */
+    uint32_t node;          /* 最近解析的语句/表达式的节点 */
+    TokenCallback on_token; /* 非NULL时按顺序报告每个token */
+    void *token_context;
+    bool asi_before;        /* 当前token之前自动插入了分号 */
+    bool module;            /* 按模块解析：允许顶层的import/export声明和import.meta */
+    bool in_async;          /* 位于async函数（或模块顶层）中：await是一元运算符 */
+    bool in_generator;      /* 位于生成器函数中：yield是表达式 */
+    int nesting;            /* 已越过的未闭合 ( [ { 个数 */
+    int no_in;              /* for头部所在的nesting+1：同一层的in不是运算符（0为不限制） */
+    const StatementTable *reuse; /* 非NULL时，其中起点不小于reuse_from的语句文本未改动， */
+    size_t reuse_from;          /* 解析到这样一条语句的开头时直接越过（增量解析使用） */
 } Parser;
 
 /* 语法分析器函数声明 */
 Parser* parser_create(Lexer *lexer, ErrorInfo *error);
 void parser_destroy(Parser *parser);
 bool parser_parse(Parser *parser);
+void statement_table_free(StatementTable *table);
 
 /* ASI相关函数 */
 bool parser_check_asi(Parser *parser);
@@ -49,7 +115,11 @@ bool parse_break_statement(Parser *parser);
 bool parse_continue_statement(Parser *parser);
 bool parse_throw_statement(Parser *parser);
 bool parse_try_statement(Parser *parser);
+bool parse_with_statement(Parser *parser);
+bool parse_debugger_statement(Parser *parser);
 bool parse_block_statement(Parser *parser);
+bool parse_import_declaration(Parser *parser);
+bool parse_export_declaration(Parser *parser);
 
 /* 表达式解析函数 */
 bool parse_expression(Parser *parser);
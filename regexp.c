@@ -0,0 +1,1286 @@
+#include "regexp.h"
+
+/* 一个字面量的结果 */
+typedef struct {
+    RegexpProgram program;  /* 合法时有效 */
+    const char *message;    /* 不合法时的说明，合法时为NULL */
+    uint32_t offset;        /* 出错位置（相对字面量开头） */
+} RegexpEntry;
+
+/* 哈希表的一项（text为NULL表示空槽） */
+typedef struct {
+    const char *text;       /* 字面量的拷贝 */
+    uint32_t length;
+    uint32_t hash;
+    const RegexpEntry *entry;
+} RegexpSlot;
+
+/* 命名分组（预扫描时按分组顺序记录） */
+typedef struct {
+    uint32_t text;          /* 解码后的名字在name_text中的偏移 */
+    uint32_t length;
+    uint32_t group;         /* 组号 */
+    uint32_t path;          /* 所在选择分支的路径在paths中的偏移，正式分析到之前为UINT32_MAX */
+    uint32_t path_length;
+} RegexpName;
+
+/* 分析器状态（缓冲在各次编译之间复用） */
+typedef struct {
+    const char *source;     /* 模式（字面量中两个/之间的部分） */
+    size_t length;
+    size_t pos;
+    uint8_t flags;
+    bool unicode;           /* u或v */
+    bool sets;              /* v */
+    bool named;             /* 有命名分组：\k总是命名引用 */
+    uint32_t groups;        /* 捕获组总数（预扫描得到） */
+    uint32_t group_index;   /* 已经读过的捕获组数 */
+    uint32_t pending;       /* 没有u/v时字符类中拆开的星体字符剩下的低位代理，没有为0 */
+    int depth;
+    const char *message;    /* 第一个错误 */
+    size_t error_pos;       /* 相对模式开头 */
+    bool oom;
+    /* 字节码 */
+    uint32_t *code;
+    size_t count;
+    size_t capacity;
+    /* 各层选择中待回填的JUMP */
+    size_t *jumps;
+    size_t jump_count;
+    size_t jump_capacity;
+    /* 当前所在的选择分支：每层两个字（选择的编号、分支序号） */
+    uint32_t *path;
+    size_t path_length;
+    size_t path_capacity;
+    uint32_t disjunctions;
+    /* 命名分组 */
+    RegexpName *names;
+    size_t name_count;
+    size_t name_capacity;
+    char *name_text;
+    size_t name_length;
+    size_t name_text_capacity;
+    uint32_t *paths;
+    size_t paths_length;
+    size_t paths_capacity;
+} RegexpParser;
+
+struct RegexpCache {
+    Arena arena;            /* 结果、字面量的拷贝和字节码 */
+    RegexpSlot *slots;
+    size_t capacity;        /* 槽数（2的幂） */
+    size_t count;
+    size_t lookups;
+    size_t hits;
+    RegexpParser parser;
+};
+
+RegexpCache* regexp_cache_create(void) {
+    RegexpCache *cache = (RegexpCache*)calloc(1, sizeof(RegexpCache));
+    if (!cache) return NULL;
+    cache->slots = (RegexpSlot*)calloc(REGEXP_INITIAL_SLOTS, sizeof(RegexpSlot));
+    if (!cache->slots) {
+        free(cache);
+        return NULL;
+    }
+    cache->capacity = REGEXP_INITIAL_SLOTS;
+    arena_init(&cache->arena, REGEXP_BLOCK);
+    return cache;
+}
+
+void regexp_cache_destroy(RegexpCache *cache) {
+    if (!cache) return;
+    arena_free(&cache->arena);
+    free(cache->slots);
+    RegexpParser *p = &cache->parser;
+    free(p->code);
+    free(p->jumps);
+    free(p->path);
+    free(p->names);
+    free(p->name_text);
+    free(p->paths);
+    free(cache);
+}
+
+size_t regexp_cache_count(const RegexpCache *cache) {
+    return cache->count;
+}
+
+size_t regexp_cache_lookups(const RegexpCache *cache) {
+    return cache->lookups;
+}
+
+size_t regexp_cache_hits(const RegexpCache *cache) {
+    return cache->hits;
+}
+
+size_t regexp_cache_bytes(const RegexpCache *cache) {
+    return cache->arena.bytes;
+}
+
+/* ---------- 缓冲 ---------- */
+
+/* 把*buffer扩大到至少能放need个元素 */
+static bool grow_buffer(void **buffer, size_t *capacity, size_t need, size_t size) {
+    if (need <= *capacity) return true;
+    size_t next = *capacity ? *capacity * 2 : 64;
+    while (next < need) next *= 2;
+    void *grown = realloc(*buffer, next * size);
+    if (!grown) return false;
+    *buffer = grown;
+    *capacity = next;
+    return true;
+}
+
+static bool fail(RegexpParser *p, size_t pos, const char *message) {
+    if (!p->message) {
+        p->message = message;
+        p->error_pos = pos;
+    }
+    return false;
+}
+
+static bool out_of_memory(RegexpParser *p) {
+    p->oom = true;
+    return fail(p, p->pos, "Out of memory");
+}
+
+static bool emit(RegexpParser *p, uint32_t word) {
+    if (!grow_buffer((void**)&p->code, &p->capacity, p->count + 1, sizeof(uint32_t))) {
+        return out_of_memory(p);
+    }
+    p->code[p->count++] = word;
+    return true;
+}
+
+static bool emit_op(RegexpParser *p, RegexpOp op, uint32_t arg) {
+    return emit(p, (uint32_t)op | arg << 8);
+}
+
+/* 在at处插入n个字（之后的代码整体后移，相对跳转不受影响） */
+static bool insert(RegexpParser *p, size_t at, const uint32_t *words, size_t n) {
+    if (!grow_buffer((void**)&p->code, &p->capacity, p->count + n, sizeof(uint32_t))) {
+        return out_of_memory(p);
+    }
+    memmove(p->code + at + n, p->code + at, (p->count - at) * sizeof(uint32_t));
+    memcpy(p->code + at, words, n * sizeof(uint32_t));
+    p->count += n;
+    return true;
+}
+
+/* 设置at处指令的24位参数 */
+static bool set_arg(RegexpParser *p, size_t at, size_t value) {
+    if (value > 0xFFFFFF) return fail(p, p->pos, "Regular expression too large");
+    p->code[at] = (p->code[at] & 0xFF) | (uint32_t)value << 8;
+    return true;
+}
+
+/* 让at处的SPLIT或JUMP指向target */
+static bool set_jump(RegexpParser *p, size_t at, size_t target) {
+    int64_t offset = (int64_t)target - (int64_t)at;
+    if (offset > 0x7FFFFF || offset < -0x800000) return fail(p, p->pos, "Regular expression too large");
+    p->code[at] = (p->code[at] & 0xFF) | ((uint32_t)offset & 0xFFFFFF) << 8;
+    return true;
+}
+
+/* ---------- 字符 ---------- */
+
+/* 模式中pos处的一个字符；没有u/v时星体字符拆成两个UTF-16码元，*low为第二个（否则为0） */
+static uint32_t read_char(RegexpParser *p, uint32_t *low) {
+    size_t size;
+    uint32_t cp = utf8_decode(p->source + p->pos, p->length - p->pos, &size);
+    p->pos += size;
+    *low = 0;
+    if (cp > 0xFFFF && !p->unicode) {
+        *low = 0xDC00 + ((cp - 0x10000) & 0x3FF);
+        cp = 0xD800 + ((cp - 0x10000) >> 10);
+    }
+    return cp;
+}
+
+static char peek(const RegexpParser *p, size_t offset) {
+    size_t pos = p->pos + offset;
+    return pos < p->length ? p->source[pos] : '\0';
+}
+
+/* \u转义（text指向u）：u模式下\uXXXX\uXXXX的代理对合成一个码点。返回用掉的字节数，不合法时返回0 */
+static size_t read_unicode_escape(const char *text, size_t length, bool unicode, uint32_t *cp) {
+    size_t n = unicode_escape_value(text + 1, length - 1, unicode, cp);
+    if (!n) return 0;
+    n++;
+    if (unicode && *cp >= 0xD800 && *cp <= 0xDBFF && n + 6 <= length &&
+        text[n] == '\\' && text[n + 1] == 'u') {
+        uint32_t trail;
+        if (unicode_escape_value(text + n + 2, length - n - 2, false, &trail) == 4 &&
+            trail >= 0xDC00 && trail <= 0xDFFF) {
+            *cp = 0x10000 + ((*cp - 0xD800) << 10) + (trail - 0xDC00);
+            n += 6;
+        }
+    }
+    return n;
+}
+
+/* ---------- 分组名 ---------- */
+
+/* 分组名（*pos指向'<'之后）：解码后的UTF-8追加到name_text，读过'>'后返回true */
+static bool read_group_name(RegexpParser *p, size_t *pos, size_t *text) {
+    size_t i = *pos;
+    bool first = true;
+    *text = p->name_length;
+    for (;;) {
+        if (i >= p->length) return false;
+        if (p->source[i] == '>') {
+            if (first) return false;
+            *pos = i + 1;
+            return true;
+        }
+        uint32_t cp;
+        if (p->source[i] == '\\') {
+            if (i + 1 >= p->length || p->source[i + 1] != 'u') return false;
+            size_t n = read_unicode_escape(p->source + i + 1, p->length - i - 1, true, &cp);
+            if (!n) return false;
+            i += 1 + n;
+        } else {
+            size_t size;
+            cp = utf8_decode(p->source + i, p->length - i, &size);
+            i += size;
+        }
+        bool valid = cp > 0xFFFF ? cp <= 0x10FFFF
+                   : first ? is_unicode_id_start(cp) : is_unicode_id_continue(cp);
+        if (!valid) return false;
+        first = false;
+        if (!grow_buffer((void**)&p->name_text, &p->name_text_capacity, p->name_length + 4, 1)) {
+            p->oom = true;
+            return false;
+        }
+        p->name_length += utf8_encode(p->name_text + p->name_length, cp);
+    }
+}
+
+/* 预扫描：捕获组总数和命名分组（\1是否反向引用、\k是否命名引用取决于整个模式） */
+static bool prescan(RegexpParser *p) {
+    int class_depth = 0;
+    for (size_t i = 0; i < p->length; i++) {
+        char ch = p->source[i];
+        if (ch == '\\') {
+            i++;
+        } else if (class_depth > 0) {
+            if (ch == ']') {
+                class_depth--;
+            } else if (ch == '[' && p->sets) {
+                class_depth++;
+            }
+        } else if (ch == '[') {
+            class_depth = 1;
+        } else if (ch == '(') {
+            if (i + 1 < p->length && p->source[i + 1] == '?') {
+                if (i + 3 >= p->length || p->source[i + 2] != '<' ||
+                    p->source[i + 3] == '=' || p->source[i + 3] == '!') {
+                    continue;
+                }
+                p->groups++;
+                p->named = true;
+                size_t pos = i + 3;
+                size_t text;
+                if (!read_group_name(p, &pos, &text)) {
+                    if (p->oom) return out_of_memory(p);
+                    continue;
+                }
+                if (!grow_buffer((void**)&p->names, &p->name_capacity, p->name_count + 1, sizeof(RegexpName))) {
+                    return out_of_memory(p);
+                }
+                RegexpName *name = &p->names[p->name_count++];
+                name->text = (uint32_t)text;
+                name->length = (uint32_t)(p->name_length - text);
+                name->group = p->groups;
+                name->path = UINT32_MAX;
+                name->path_length = 0;
+            } else {
+                p->groups++;
+            }
+        }
+    }
+    return true;
+}
+
+/* 两个同名分组是否在同一个选择的不同分支中（否则名字重复） */
+static bool disjoint_paths(const uint32_t *a, size_t a_length, const uint32_t *b, size_t b_length) {
+    for (size_t i = 0; i + 1 < a_length && i + 1 < b_length; i += 2) {
+        if (a[i] != b[i]) return false;
+        if (a[i + 1] != b[i + 1]) return true;
+    }
+    return false;
+}
+
+/* 正式分析到第index组（名字的解码在name_text的text处）：检查重名并记下路径 */
+static bool declare_name(RegexpParser *p, uint32_t index, size_t text, size_t start) {
+    size_t length = p->name_length - text;
+    RegexpName *self = NULL;
+    for (size_t i = 0; i < p->name_count; i++) {
+        if (p->names[i].group == index) {
+            self = &p->names[i];
+            break;
+        }
+    }
+    if (!self) return fail(p, start, "Invalid capture group name");
+    for (size_t i = 0; i < p->name_count; i++) {
+        const RegexpName *other = &p->names[i];
+        if (other == self || other->path == UINT32_MAX || other->length != length ||
+            memcmp(p->name_text + other->text, p->name_text + text, length) != 0) {
+            continue;
+        }
+        if (!disjoint_paths(p->paths + other->path, other->path_length, p->path, p->path_length)) {
+            return fail(p, start, "Duplicate capture group name");
+        }
+    }
+    if (!grow_buffer((void**)&p->paths, &p->paths_capacity, p->paths_length + p->path_length,
+                     sizeof(uint32_t))) {
+        return out_of_memory(p);
+    }
+    memcpy(p->paths + p->paths_length, p->path, p->path_length * sizeof(uint32_t));
+    self->path = (uint32_t)p->paths_length;
+    self->path_length = (uint32_t)p->path_length;
+    p->paths_length += p->path_length;
+    return true;
+}
+
+/* ---------- 转义 ---------- */
+
+/* 字符转义（p->pos指向\之后，start为\的位置）：得到码点，没有u/v时星体字符另有*low。
+   in_class为字符类中（允许\cN、\c_） */
+static bool parse_character_escape(RegexpParser *p, size_t start, bool in_class,
+                                   uint32_t *cp, uint32_t *low) {
+    char ch = peek(p, 0);
+    *low = 0;
+    switch (ch) {
+        case 'f': *cp = 0x0C; p->pos++; return true;
+        case 'n': *cp = 0x0A; p->pos++; return true;
+        case 'r': *cp = 0x0D; p->pos++; return true;
+        case 't': *cp = 0x09; p->pos++; return true;
+        case 'v': *cp = 0x0B; p->pos++; return true;
+        case 'c': {
+            char next = peek(p, 1);
+            if (isalpha((unsigned char)next) ||
+                (!p->unicode && in_class && (isdigit((unsigned char)next) || next == '_'))) {
+                *cp = (uint32_t)next % 32;
+                p->pos += 2;
+                return true;
+            }
+            if (p->unicode) return fail(p, start, "Invalid unicode escape");
+            /* 附录B：\本身是普通字符，c留给下一个字符 */
+            *cp = '\\';
+            return true;
+        }
+        case 'x': {
+            int high = hex_digit_value(peek(p, 1));
+            int low_digit = hex_digit_value(peek(p, 2));
+            if (high >= 0 && low_digit >= 0) {
+                *cp = (uint32_t)(high * 16 + low_digit);
+                p->pos += 3;
+                return true;
+            }
+            if (p->unicode) return fail(p, start, "Invalid escape");
+            *cp = 'x';
+            p->pos++;
+            return true;
+        }
+        case 'u': {
+            size_t n = read_unicode_escape(p->source + p->pos, p->length - p->pos, p->unicode, cp);
+            if (n) {
+                p->pos += n;
+                return true;
+            }
+            if (p->unicode) return fail(p, start, "Invalid Unicode escape");
+            *cp = 'u';
+            p->pos++;
+            return true;
+        }
+        case '0':
+            if (!isdigit((unsigned char)peek(p, 1))) {
+                *cp = 0;
+                p->pos++;
+                return true;
+            }
+            if (p->unicode) return fail(p, start, in_class ? "Invalid class escape" : "Invalid decimal escape");
+            break;
+        case '1': case '2': case '3': case '4': case '5': case '6': case '7':
+            if (p->unicode) return fail(p, start, in_class ? "Invalid class escape" : "Invalid escape");
+            break;
+        case '\0':
+            if (p->pos >= p->length) return fail(p, start, "\\ at end of pattern");
+            break;
+        default:
+            break;
+    }
+
+    if (ch >= '0' && ch <= '7') {
+        /* 附录B的传统八进制转义，不超过\377 */
+        uint32_t value = (uint32_t)(ch - '0');
+        p->pos++;
+        int limit = ch <= '3' ? 2 : 1;
+        for (int i = 0; i < limit && peek(p, 0) >= '0' && peek(p, 0) <= '7'; i++) {
+            value = value * 8 + (uint32_t)(peek(p, 0) - '0');
+            p->pos++;
+        }
+        *cp = value;
+        return true;
+    }
+    if (p->unicode) {
+        if (ch != '\0' && (strchr("^$\\.*+?()[]{}|/", ch) || (in_class && ch == '-'))) {
+            *cp = (uint32_t)ch;
+            p->pos++;
+            return true;
+        }
+        return fail(p, start, in_class ? "Invalid class escape" : "Invalid escape");
+    }
+    if (ch == 'k' && p->named) return fail(p, start, "Invalid named reference");
+    *cp = read_char(p, low);
+    return true;
+}
+
+/* 二元属性（ECMA-262表67）和General_Category的值 */
+static const char *const binary_properties[] = {
+    "ASCII", "ASCII_Hex_Digit", "AHex", "Alphabetic", "Alpha", "Any", "Assigned",
+    "Bidi_Control", "Bidi_C", "Bidi_Mirrored", "Bidi_M", "Case_Ignorable", "CI", "Cased",
+    "Changes_When_Casefolded", "CWCF", "Changes_When_Casemapped", "CWCM",
+    "Changes_When_Lowercased", "CWL", "Changes_When_NFKC_Casefolded", "CWKCF",
+    "Changes_When_Titlecased", "CWT", "Changes_When_Uppercased", "CWU", "Dash",
+    "Default_Ignorable_Code_Point", "DI", "Deprecated", "Dep", "Diacritic", "Dia",
+    "Emoji", "Emoji_Component", "EComp", "Emoji_Modifier", "EMod", "Emoji_Modifier_Base",
+    "EBase", "Emoji_Presentation", "EPres", "Extended_Pictographic", "ExtPict", "Extender",
+    "Ext", "Grapheme_Base", "Gr_Base", "Grapheme_Extend", "Gr_Ext", "Hex_Digit", "Hex",
+    "IDS_Binary_Operator", "IDSB", "IDS_Trinary_Operator", "IDST", "ID_Continue", "IDC",
+    "ID_Start", "IDS", "Ideographic", "Ideo", "Join_Control", "Join_C",
+    "Logical_Order_Exception", "LOE", "Lowercase", "Lower", "Math",
+    "Noncharacter_Code_Point", "NChar", "Pattern_Syntax", "Pat_Syn", "Pattern_White_Space",
+    "Pat_WS", "Quotation_Mark", "QMark", "Radical", "Regional_Indicator", "RI",
+    "Sentence_Terminal", "STerm", "Soft_Dotted", "SD", "Terminal_Punctuation", "Term",
+    "Unified_Ideograph", "UIdeo", "Uppercase", "Upper", "Variation_Selector", "VS",
+    "White_Space", "space", "XID_Continue", "XIDC", "XID_Start", "XIDS", NULL
+};
+
+static const char *const general_categories[] = {
+    "Cased_Letter", "LC", "Close_Punctuation", "Pe", "Connector_Punctuation", "Pc",
+    "Control", "Cc", "cntrl", "Currency_Symbol", "Sc", "Dash_Punctuation", "Pd",
+    "Decimal_Number", "Nd", "digit", "Enclosing_Mark", "Me", "Final_Punctuation", "Pf",
+    "Format", "Cf", "Initial_Punctuation", "Pi", "Letter", "L", "Letter_Number", "Nl",
+    "Line_Separator", "Zl", "Lowercase_Letter", "Ll", "Mark", "M", "Combining_Mark",
+    "Math_Symbol", "Sm", "Modifier_Letter", "Lm", "Modifier_Symbol", "Sk",
+    "Nonspacing_Mark", "Mn", "Number", "N", "Open_Punctuation", "Ps", "Other", "C",
+    "Other_Letter", "Lo", "Other_Number", "No", "Other_Punctuation", "Po", "Other_Symbol",
+    "So", "Paragraph_Separator", "Zp", "Private_Use", "Co", "Punctuation", "P", "punct",
+    "Separator", "Z", "Space_Separator", "Zs", "Spacing_Mark", "Mc", "Surrogate", "Cs",
+    "Symbol", "S", "Titlecase_Letter", "Lt", "Unassigned", "Cn", "Uppercase_Letter", "Lu",
+    NULL
+};
+
+/* 字符串的属性（只用于v模式） */
+static const char *const string_properties[] = {
+    "Basic_Emoji", "Emoji_Keycap_Sequence", "RGI_Emoji_Modifier_Sequence",
+    "RGI_Emoji_Flag_Sequence", "RGI_Emoji_Tag_Sequence", "RGI_Emoji_ZWJ_Sequence",
+    "RGI_Emoji", NULL
+};
+
+static bool name_in(const char *const *names, const char *text, size_t length) {
+    for (size_t i = 0; names[i]; i++) {
+        if (strlen(names[i]) == length && memcmp(names[i], text, length) == 0) return true;
+    }
+    return false;
+}
+
+static bool is_name(const char *text, size_t length, const char *name) {
+    return strlen(name) == length && memcmp(text, name, length) == 0;
+}
+
+/* \p{...}或\P{...}（p->pos指向p或P）：item为三个字的REGEXP_CLASS_PROPERTY项。
+   Script和Script_Extensions的值只检查写法 */
+static bool parse_property(RegexpParser *p, size_t start, uint32_t *item, bool *strings) {
+    bool negated = peek(p, 0) == 'P';
+    *strings = false;
+    p->pos++;
+    if (peek(p, 0) != '{') return fail(p, start, "Invalid property name");
+    p->pos++;
+    size_t name = p->pos;
+    while (isalnum((unsigned char)peek(p, 0)) || peek(p, 0) == '_') p->pos++;
+    size_t name_length = p->pos - name;
+    size_t value = 0, value_length = 0;
+    if (peek(p, 0) == '=') {
+        p->pos++;
+        value = p->pos;
+        while (isalnum((unsigned char)peek(p, 0)) || peek(p, 0) == '_') p->pos++;
+        value_length = p->pos - value;
+        if (value_length == 0) return fail(p, start, "Invalid property name");
+    }
+    if (peek(p, 0) != '}' || name_length == 0) return fail(p, start, "Invalid property name");
+    p->pos++;
+
+    const char *text = p->source + name;
+    bool valid;
+    if (value_length > 0) {
+        if (is_name(text, name_length, "General_Category") || is_name(text, name_length, "gc")) {
+            valid = name_in(general_categories, p->source + value, value_length);
+        } else {
+            valid = is_name(text, name_length, "Script") || is_name(text, name_length, "sc") ||
+                    is_name(text, name_length, "Script_Extensions") || is_name(text, name_length, "scx");
+        }
+    } else if (name_in(general_categories, text, name_length) ||
+               name_in(binary_properties, text, name_length)) {
+        valid = true;
+    } else {
+        valid = p->sets && !negated && name_in(string_properties, text, name_length);
+        *strings = valid;
+    }
+    if (!valid) return fail(p, start, "Invalid property name");
+
+    item[0] = REGEXP_CLASS_PROPERTY | (negated ? 1u : 0u) << 8;
+    item[1] = (uint32_t)name;
+    item[2] = (uint32_t)(p->pos - 1 - name);
+    return true;
+}
+
+static bool is_class_escape(char ch) {
+    return ch == 'd' || ch == 'D' || ch == 's' || ch == 'S' || ch == 'w' || ch == 'W';
+}
+
+/* 只有一项的字符类（\d、\p{...}等） */
+static bool emit_class_item(RegexpParser *p, const uint32_t *item, size_t n) {
+    if (!grow_buffer((void**)&p->code, &p->capacity, p->count + n + 3, sizeof(uint32_t))) {
+        return out_of_memory(p);
+    }
+    p->code[p->count++] = REGEXP_OP_CLASS | (uint32_t)(n + 2) << 8;
+    p->code[p->count++] = REGEXP_CLASS_SET | REGEXP_SET_UNION << 8;
+    p->code[p->count++] = (uint32_t)n;
+    memcpy(p->code + p->count, item, n * sizeof(uint32_t));
+    p->count += n;
+    return true;
+}
+
+/* 写一个字符；拆开的星体字符分两条CHAR，*atom指向后一条（量词只作用于它） */
+static bool emit_char(RegexpParser *p, uint32_t cp, uint32_t low, size_t *atom) {
+    if (!emit_op(p, REGEXP_OP_CHAR, cp)) return false;
+    if (low) {
+        *atom = p->count;
+        return emit_op(p, REGEXP_OP_CHAR, low);
+    }
+    return true;
+}
+
+/* 字符类以外的转义（p->pos指向\，\b和\B已经处理过） */
+static bool parse_atom_escape(RegexpParser *p, size_t *atom) {
+    size_t start = p->pos;
+    p->pos++;
+    char ch = peek(p, 0);
+
+    if (ch >= '1' && ch <= '9') {
+        /* 反向引用；没有u/v时超出分组数的按八进制或普通字符 */
+        size_t digits = p->pos;
+        uint64_t n = 0;
+        while (isdigit((unsigned char)peek(p, 0))) {
+            if (n < UINT32_MAX) n = n * 10 + (uint64_t)(peek(p, 0) - '0');
+            p->pos++;
+        }
+        if (n <= p->groups) return emit_op(p, REGEXP_OP_BACKREF, (uint32_t)n);
+        p->pos = digits;
+    } else if (ch == 'k' && (p->unicode || p->named)) {
+        p->pos++;
+        if (peek(p, 0) != '<') return fail(p, start, "Invalid named reference");
+        size_t pos = p->pos + 1;
+        size_t text;
+        if (!read_group_name(p, &pos, &text)) {
+            if (p->oom) return out_of_memory(p);
+            return fail(p, start, "Invalid named reference");
+        }
+        p->pos = pos;
+        size_t length = p->name_length - text;
+        bool found = false;
+        /* 同名的分组在不同分支中，最多一个参与匹配：依次引用每一个 */
+        for (size_t i = 0; i < p->name_count; i++) {
+            const RegexpName *name = &p->names[i];
+            if (name->length == length && memcmp(p->name_text + name->text, p->name_text + text, length) == 0) {
+                if (!emit_op(p, REGEXP_OP_BACKREF, name->group)) return false;
+                found = true;
+            }
+        }
+        p->name_length = text;
+        if (!found) return fail(p, start, "Invalid named capture referenced");
+        return true;
+    } else if (is_class_escape(ch)) {
+        uint32_t item = REGEXP_CLASS_ESCAPE | (uint32_t)(unsigned char)ch << 8;
+        p->pos++;
+        return emit_class_item(p, &item, 1);
+    } else if ((ch == 'p' || ch == 'P') && p->unicode) {
+        uint32_t item[3];
+        bool strings;
+        if (!parse_property(p, start, item, &strings)) return false;
+        return emit_class_item(p, item, 3);
+    }
+
+    uint32_t cp, low;
+    if (!parse_character_escape(p, start, false, &cp, &low)) return false;
+    return emit_char(p, cp, low, atom);
+}
+
+/* ---------- 字符类 ---------- */
+
+/* 传统字符类的一个原子 */
+typedef struct {
+    uint32_t item[3];
+    size_t words;
+    bool is_char;
+    uint32_t cp;
+} ClassAtom;
+
+static bool parse_class_atom(RegexpParser *p, ClassAtom *atom) {
+    uint32_t low = 0;
+    atom->is_char = true;
+    if (p->pending) {
+        atom->cp = p->pending;
+        p->pending = 0;
+    } else if (peek(p, 0) == '\\') {
+        size_t start = p->pos;
+        p->pos++;
+        char ch = peek(p, 0);
+        if (ch == 'b') {
+            atom->cp = 0x08;
+            p->pos++;
+        } else if (ch == '-' && p->unicode) {
+            atom->cp = '-';
+            p->pos++;
+        } else if (is_class_escape(ch)) {
+            atom->item[0] = REGEXP_CLASS_ESCAPE | (uint32_t)(unsigned char)ch << 8;
+            atom->words = 1;
+            atom->is_char = false;
+            p->pos++;
+            return true;
+        } else if ((ch == 'p' || ch == 'P') && p->unicode) {
+            bool strings;
+            if (!parse_property(p, start, atom->item, &strings)) return false;
+            atom->words = 3;
+            atom->is_char = false;
+            return true;
+        } else if (!parse_character_escape(p, start, true, &atom->cp, &low)) {
+            return false;
+        }
+    } else {
+        atom->cp = read_char(p, &low);
+    }
+    p->pending = low;
+    atom->item[0] = REGEXP_CLASS_RANGE | atom->cp << 8;
+    atom->item[1] = atom->cp;
+    atom->words = 2;
+    return true;
+}
+
+static bool emit_words(RegexpParser *p, const uint32_t *words, size_t n) {
+    if (!grow_buffer((void**)&p->code, &p->capacity, p->count + n, sizeof(uint32_t))) {
+        return out_of_memory(p);
+    }
+    memcpy(p->code + p->count, words, n * sizeof(uint32_t));
+    p->count += n;
+    return true;
+}
+
+/* 没有v标志的字符类（p->pos指向'['之后，SET的头已经写好） */
+static bool parse_class_ranges(RegexpParser *p, size_t start) {
+    for (;;) {
+        if (!p->pending) {
+            if (p->pos >= p->length) return fail(p, start, "Unterminated character class");
+            if (peek(p, 0) == ']') {
+                p->pos++;
+                return true;
+            }
+        }
+        ClassAtom first;
+        if (!parse_class_atom(p, &first)) return false;
+        if (p->pending || peek(p, 0) != '-' || peek(p, 1) == ']' || p->pos + 1 >= p->length) {
+            if (!emit_words(p, first.item, first.words)) return false;
+            continue;
+        }
+        size_t dash = p->pos;
+        p->pos++;
+        ClassAtom last;
+        if (!parse_class_atom(p, &last)) return false;
+        if (!first.is_char || !last.is_char) {
+            /* 附录B：\d-x这样的"范围"就是三个原子 */
+            if (p->unicode) return fail(p, dash, "Invalid character class");
+            uint32_t minus[2] = { REGEXP_CLASS_RANGE | (uint32_t)'-' << 8, '-' };
+            if (!emit_words(p, first.item, first.words) || !emit_words(p, minus, 2) ||
+                !emit_words(p, last.item, last.words)) {
+                return false;
+            }
+            continue;
+        }
+        if (first.cp > last.cp) return fail(p, dash, "Range out of order in character class");
+        first.item[1] = last.cp;
+        if (!emit_words(p, first.item, 2)) return false;
+    }
+}
+
+/* 两个相同字符组成的保留运算符（v模式的字符类中不能直接出现） */
+static bool reserved_double_punctuator(const RegexpParser *p) {
+    char ch = peek(p, 0);
+    return ch != '\0' && ch == peek(p, 1) && strchr("&!#$%*+,.:;<=>?@^`~", ch) != NULL;
+}
+
+/* v模式字符类中的一个字符（ClassSetCharacter） */
+static bool parse_class_set_character(RegexpParser *p, size_t start, uint32_t *cp) {
+    size_t at = p->pos;
+    if (at >= p->length) return fail(p, start, "Unterminated character class");
+    char ch = peek(p, 0);
+    if (ch == '\\') {
+        char next = peek(p, 1);
+        if (next == 'b') {
+            *cp = 0x08;
+            p->pos += 2;
+            return true;
+        }
+        if (next != '\0' && strchr("&-!#%,:;<=>@`~", next)) {
+            *cp = (uint32_t)next;
+            p->pos += 2;
+            return true;
+        }
+        uint32_t low;
+        p->pos++;
+        return parse_character_escape(p, at, true, cp, &low);
+    }
+    if (reserved_double_punctuator(p)) return fail(p, at, "Invalid set operation in character class");
+    if (strchr("()[]{}/-|", ch)) return fail(p, at, "Invalid character in character class");
+    uint32_t low;
+    *cp = read_char(p, &low);
+    return true;
+}
+
+/* \q{...}（p->pos指向\）：每个分支一个REGEXP_CLASS_STRING项 */
+static bool parse_class_strings(RegexpParser *p, size_t start, bool *strings) {
+    p->pos += 3;
+    for (;;) {
+        size_t header = p->count;
+        if (!emit(p, REGEXP_CLASS_STRING)) return false;
+        size_t n = 0;
+        while (peek(p, 0) != '|' && peek(p, 0) != '}') {
+            uint32_t cp;
+            if (p->pos >= p->length) return fail(p, start, "Unterminated character class");
+            if (!parse_class_set_character(p, start, &cp) || !emit(p, cp)) return false;
+            n++;
+        }
+        if (!set_arg(p, header, n)) return false;
+        if (n != 1) *strings = true;
+        if (p->source[p->pos++] == '}') return true;
+    }
+}
+
+static bool parse_class_set(RegexpParser *p, size_t start, bool *strings);
+
+/* v模式字符类的一个操作数：嵌套的类、\q{...}、类转义或单个字符（*is_char，码点为*cp） */
+static bool parse_class_set_operand(RegexpParser *p, size_t start, bool *strings,
+                                    bool *is_char, uint32_t *cp) {
+    size_t at = p->pos;
+    char ch = peek(p, 0);
+    *strings = false;
+    *is_char = false;
+    if (at >= p->length) return fail(p, start, "Unterminated character class");
+    if (ch == '[') {
+        p->pos++;
+        return parse_class_set(p, at, strings);
+    }
+    if (ch == ']') return fail(p, at, "Invalid set operation in character class");
+    if (ch == '\\') {
+        char next = peek(p, 1);
+        if (next == 'q' && peek(p, 2) == '{') return parse_class_strings(p, start, strings);
+        if (is_class_escape(next)) {
+            p->pos += 2;
+            return emit(p, REGEXP_CLASS_ESCAPE | (uint32_t)(unsigned char)next << 8);
+        }
+        if (next == 'p' || next == 'P') {
+            uint32_t item[3];
+            p->pos++;
+            return parse_property(p, at, item, strings) && emit_words(p, item, 3);
+        }
+    }
+    if (!parse_class_set_character(p, start, cp)) return false;
+    *is_char = true;
+    uint32_t item[2] = { REGEXP_CLASS_RANGE | *cp << 8, *cp };
+    return emit_words(p, item, 2);
+}
+
+/* v模式的字符类（p->pos指向'['之后，start为'['的位置）：写一个REGEXP_CLASS_SET项。
+   并集、交集（&&）和差集（--）不能混用；*strings为是否可能匹配多个字符的字符串 */
+static bool parse_class_set(RegexpParser *p, size_t start, bool *strings) {
+    if (++p->depth > REGEXP_MAX_DEPTH) return fail(p, start, "Regular expression too deeply nested");
+    bool negated = false;
+    if (peek(p, 0) == '^') {
+        negated = true;
+        p->pos++;
+    }
+    size_t header = p->count;
+    if (!emit(p, REGEXP_CLASS_SET) || !emit(p, 0)) return false;
+
+    RegexpSetOp op = REGEXP_SET_UNION;
+    size_t operands = 0;
+    bool ranges = false;
+    bool may_contain_strings = false;
+    for (;;) {
+        size_t at = p->pos;
+        if (at >= p->length) return fail(p, start, "Unterminated character class");
+        if (peek(p, 0) == ']') {
+            p->pos++;
+            break;
+        }
+        RegexpSetOp next = REGEXP_SET_UNION;
+        if (peek(p, 0) == '&' && peek(p, 1) == '&') {
+            next = REGEXP_SET_INTERSECTION;
+        } else if (peek(p, 0) == '-' && peek(p, 1) == '-') {
+            next = REGEXP_SET_SUBTRACTION;
+        }
+
+        bool operand_strings, is_char;
+        uint32_t cp;
+        if (next != REGEXP_SET_UNION) {
+            if (operands == 0 || ranges || (op == REGEXP_SET_UNION && operands > 1) ||
+                (op != REGEXP_SET_UNION && op != next)) {
+                return fail(p, at, "Invalid set operation in character class");
+            }
+            op = next;
+            p->pos += 2;
+            if (op == REGEXP_SET_INTERSECTION && peek(p, 0) == '&') {
+                return fail(p, p->pos, "Invalid character in character class");
+            }
+            if (!parse_class_set_operand(p, start, &operand_strings, &is_char, &cp)) return false;
+            if (op == REGEXP_SET_INTERSECTION) may_contain_strings = may_contain_strings && operand_strings;
+            operands++;
+            continue;
+        }
+
+        if (op != REGEXP_SET_UNION) return fail(p, at, "Invalid set operation in character class");
+        if (!parse_class_set_operand(p, start, &operand_strings, &is_char, &cp)) return false;
+        if (is_char && peek(p, 0) == '-' && peek(p, 1) != '-') {
+            size_t dash = p->pos;
+            uint32_t last;
+            p->pos++;
+            if (!parse_class_set_character(p, start, &last)) return false;
+            if (cp > last) return fail(p, dash, "Range out of order in character class");
+            p->code[p->count - 1] = last;
+            ranges = true;
+        }
+        may_contain_strings = may_contain_strings || operand_strings;
+        operands++;
+    }
+
+    if (negated && may_contain_strings) {
+        return fail(p, start, "Negated character class may contain strings");
+    }
+    p->code[header] = REGEXP_CLASS_SET | ((uint32_t)op | (negated ? 1u : 0u) << 4) << 8;
+    p->code[header + 1] = (uint32_t)(p->count - header - 2);
+    *strings = may_contain_strings;
+    p->depth--;
+    return true;
+}
+
+/* 字符类（p->pos指向'['） */
+static bool parse_class(RegexpParser *p) {
+    size_t start = p->pos;
+    size_t header = p->count;
+    p->pos++;
+    if (!emit_op(p, REGEXP_OP_CLASS, 0)) return false;
+    if (p->sets) {
+        bool strings;
+        if (!parse_class_set(p, start, &strings)) return false;
+    } else {
+        bool negated = false;
+        if (peek(p, 0) == '^') {
+            negated = true;
+            p->pos++;
+        }
+        size_t set = p->count;
+        if (!emit(p, REGEXP_CLASS_SET | (negated ? 1u : 0u) << 12) || !emit(p, 0)) return false;
+        if (!parse_class_ranges(p, start)) return false;
+        p->code[set + 1] = (uint32_t)(p->count - set - 2);
+    }
+    return set_arg(p, header, p->count - header - 1);
+}
+
+/* ---------- 模式 ---------- */
+
+static bool parse_disjunction(RegexpParser *p);
+
+static bool close_group(RegexpParser *p, size_t start) {
+    if (peek(p, 0) != ')' || p->pos >= p->length) return fail(p, start, "Unterminated group");
+    p->pos++;
+    return true;
+}
+
+/* (?ims-ims:...)（p->pos指向?之后） */
+static bool parse_modifiers(RegexpParser *p, size_t start) {
+    uint32_t on = 0, off = 0;
+    bool minus = false;
+    for (;;) {
+        char ch = peek(p, 0);
+        uint32_t flag = ch == 'i' ? REGEXP_FLAG_IGNORE_CASE
+                      : ch == 'm' ? REGEXP_FLAG_MULTILINE
+                      : ch == 's' ? REGEXP_FLAG_DOT_ALL : 0;
+        if (flag) {
+            if ((on | off) & flag) return fail(p, p->pos, "Repeated flag in modifiers group");
+            if (minus) off |= flag;
+            else on |= flag;
+        } else if (ch == '-' && !minus) {
+            minus = true;
+        } else if (ch == ':') {
+            break;
+        } else {
+            return fail(p, start, "Invalid group");
+        }
+        p->pos++;
+    }
+    if (minus && on == 0 && off == 0) return fail(p, start, "Invalid group");
+    p->pos++;
+
+    size_t header = p->count;
+    if (!emit_op(p, REGEXP_OP_MODIFIERS, on | off << 8) || !emit(p, 0)) return false;
+    if (!parse_disjunction(p) || !close_group(p, start)) return false;
+    p->code[header + 1] = (uint32_t)(p->count - header - 2);
+    return true;
+}
+
+/* 分组（p->pos指向'('）：*quantifiable为之后能否跟量词 */
+static bool parse_group(RegexpParser *p, bool *quantifiable) {
+    size_t start = p->pos;
+    p->pos++;
+    if (peek(p, 0) != '?') {
+        uint32_t index = ++p->group_index;
+        if (!emit_op(p, REGEXP_OP_SAVE, index * 2) || !parse_disjunction(p) || !close_group(p, start)) {
+            return false;
+        }
+        return emit_op(p, REGEXP_OP_SAVE, index * 2 + 1);
+    }
+
+    char ch = peek(p, 1);
+    if (ch == ':') {
+        p->pos += 2;
+        return parse_disjunction(p) && close_group(p, start);
+    }
+
+    RegexpLook look;
+    if (ch == '=' || ch == '!') {
+        look = ch == '=' ? REGEXP_LOOK_AHEAD : REGEXP_LOOK_AHEAD_NOT;
+        p->pos += 2;
+        *quantifiable = !p->unicode;
+    } else if (ch == '<' && (peek(p, 2) == '=' || peek(p, 2) == '!')) {
+        look = peek(p, 2) == '=' ? REGEXP_LOOK_BEHIND : REGEXP_LOOK_BEHIND_NOT;
+        p->pos += 3;
+        *quantifiable = false;
+    } else if (ch == '<') {
+        size_t name = p->pos + 2;
+        size_t pos = name;
+        size_t text;
+        if (!read_group_name(p, &pos, &text)) {
+            if (p->oom) return out_of_memory(p);
+            return fail(p, name, "Invalid capture group name");
+        }
+        p->pos = pos;
+        uint32_t index = ++p->group_index;
+        bool declared = declare_name(p, index, text, name);
+        p->name_length = text;
+        if (!declared || !emit_op(p, REGEXP_OP_SAVE, index * 2) || !parse_disjunction(p) ||
+            !close_group(p, start)) {
+            return false;
+        }
+        return emit_op(p, REGEXP_OP_SAVE, index * 2 + 1);
+    } else {
+        p->pos++;
+        return parse_modifiers(p, start);
+    }
+
+    size_t header = p->count;
+    if (!emit_op(p, REGEXP_OP_LOOK, look) || !emit(p, 0)) return false;
+    if (!parse_disjunction(p) || !close_group(p, start) || !emit_op(p, REGEXP_OP_MATCH, 0)) return false;
+    p->code[header + 1] = (uint32_t)(p->count - header - 2);
+    return true;
+}
+
+/* at处是否是{n}、{n,}或{n,m}：是则返回其后的位置，否则返回0 */
+static size_t braced_quantifier(const RegexpParser *p, size_t at, uint32_t *min, uint32_t *max) {
+    const char *s = p->source;
+    size_t i = at + 1;
+    uint64_t values[2] = { 0, 0 };
+    for (int k = 0; k < 2; k++) {
+        size_t digits = i;
+        while (i < p->length && isdigit((unsigned char)s[i])) {
+            /* 超过2^48的次数都一样（只用于比较大小） */
+            if (values[k] < (1ULL << 48)) values[k] = values[k] * 10 + (uint64_t)(s[i] - '0');
+            i++;
+        }
+        if (i >= p->length) return 0;
+        if (i == digits) {
+            if (k == 0 || s[i] != '}') return 0;
+            values[1] = UINT64_MAX;
+        }
+        if (s[i] == '}') {
+            if (k == 0) values[1] = values[0];
+            break;
+        }
+        if (k == 1 || s[i] != ',') return 0;
+        i++;
+    }
+    if (values[0] > values[1]) {
+        *min = 1;
+        *max = 0;
+    } else {
+        *min = values[0] > UINT32_MAX ? UINT32_MAX : (uint32_t)values[0];
+        *max = values[1] >= UINT32_MAX ? UINT32_MAX : (uint32_t)values[1];
+    }
+    return i + 1;
+}
+
+/* 原子（代码从atom开始）之后的量词：在原子前插入REPEAT */
+static bool parse_quantifier(RegexpParser *p, size_t atom, bool quantifiable) {
+    size_t at = p->pos;
+    uint32_t min, max;
+    switch (peek(p, 0)) {
+        case '*': min = 0; max = UINT32_MAX; p->pos++; break;
+        case '+': min = 1; max = UINT32_MAX; p->pos++; break;
+        case '?': min = 0; max = 1; p->pos++; break;
+        case '{': {
+            size_t end = braced_quantifier(p, at, &min, &max);
+            /* 附录B：不成量词的{是普通字符（u模式下由下一项报错） */
+            if (!end) return true;
+            p->pos = end;
+            if (min > max) return fail(p, at, "numbers out of order in {} quantifier");
+            break;
+        }
+        default:
+            return true;
+    }
+    if (!quantifiable) return fail(p, at, "Nothing to repeat");
+    bool lazy = false;
+    if (peek(p, 0) == '?' && p->pos < p->length) {
+        lazy = true;
+        p->pos++;
+    }
+    uint32_t header[4] = {
+        REGEXP_OP_REPEAT | (lazy ? 1u : 0u) << 8, min, max, (uint32_t)(p->count - atom)
+    };
+    return insert(p, atom, header, 4);
+}
+
+static bool parse_term(RegexpParser *p) {
+    size_t start = p->pos;
+    size_t atom = p->count;
+    bool quantifiable = true;
+    uint32_t min, max;
+    char ch = peek(p, 0);
+    switch (ch) {
+        case '^':
+        case '$':
+            p->pos++;
+            quantifiable = false;
+            if (!emit_op(p, REGEXP_OP_ASSERT, ch == '^' ? REGEXP_ASSERT_BEGIN : REGEXP_ASSERT_END)) return false;
+            break;
+        case '\\':
+            if (peek(p, 1) == 'b' || peek(p, 1) == 'B') {
+                p->pos += 2;
+                quantifiable = false;
+                if (!emit_op(p, REGEXP_OP_ASSERT,
+                             p->source[p->pos - 1] == 'b' ? REGEXP_ASSERT_WORD : REGEXP_ASSERT_NOT_WORD)) {
+                    return false;
+                }
+            } else if (!parse_atom_escape(p, &atom)) {
+                return false;
+            }
+            break;
+        case '(':
+            if (!parse_group(p, &quantifiable)) return false;
+            break;
+        case '.':
+            p->pos++;
+            if (!emit_op(p, REGEXP_OP_ANY, 0)) return false;
+            break;
+        case '[':
+            if (!parse_class(p)) return false;
+            break;
+        case '*':
+        case '+':
+        case '?':
+            return fail(p, start, "Nothing to repeat");
+        case '{':
+            if (braced_quantifier(p, start, &min, &max)) return fail(p, start, "Nothing to repeat");
+            /* fall through */
+        case '}':
+        case ']':
+            if (p->unicode) return fail(p, start, "Lone quantifier brackets");
+            p->pos++;
+            if (!emit_op(p, REGEXP_OP_CHAR, (uint32_t)ch)) return false;
+            break;
+        default: {
+            uint32_t low;
+            uint32_t cp = read_char(p, &low);
+            if (!emit_char(p, cp, low, &atom)) return false;
+            break;
+        }
+    }
+    return parse_quantifier(p, atom, quantifiable);
+}
+
+/* 选择：每个分支前插入SPLIT（指向下一个分支），分支末尾的JUMP跳到选择之后 */
+static bool parse_disjunction(RegexpParser *p) {
+    if (++p->depth > REGEXP_MAX_DEPTH) return fail(p, p->pos, "Regular expression too deeply nested");
+    if (!grow_buffer((void**)&p->path, &p->path_capacity, p->path_length + 2, sizeof(uint32_t))) {
+        return out_of_memory(p);
+    }
+    p->path[p->path_length++] = ++p->disjunctions;
+    p->path[p->path_length++] = 0;
+    size_t jumps = p->jump_count;
+    size_t alternative = p->count;
+
+    for (;;) {
+        while (p->pos < p->length && peek(p, 0) != '|' && peek(p, 0) != ')') {
+            if (!parse_term(p)) return false;
+        }
+        if (p->pos >= p->length || peek(p, 0) != '|') break;
+        p->pos++;
+        uint32_t split = REGEXP_OP_SPLIT;
+        if (!insert(p, alternative, &split, 1)) return false;
+        if (!grow_buffer((void**)&p->jumps, &p->jump_capacity, p->jump_count + 1, sizeof(size_t))) {
+            return out_of_memory(p);
+        }
+        p->jumps[p->jump_count++] = p->count;
+        if (!emit_op(p, REGEXP_OP_JUMP, 0) || !set_jump(p, alternative, p->count)) return false;
+        p->path[p->path_length - 1]++;
+        alternative = p->count;
+    }
+
+    for (size_t i = jumps; i < p->jump_count; i++) {
+        if (!set_jump(p, p->jumps[i], p->count)) return false;
+    }
+    p->jump_count = jumps;
+    p->path_length -= 2;
+    p->depth--;
+    return true;
+}
+
+/* 标志（offset为第一个标志相对模式开头的位置） */
+static bool parse_flags(RegexpParser *p, const char *flags, size_t length, size_t offset) {
+    static const char letters[] = "dgimsuvy";
+    for (size_t i = 0; i < length; i++) {
+        const char *letter = flags[i] ? strchr(letters, flags[i]) : NULL;
+        if (!letter) return fail(p, offset + i, "Invalid regular expression flags");
+        uint8_t bit = (uint8_t)(1u << (letter - letters));
+        if (p->flags & bit) return fail(p, offset + i, "Duplicate regular expression flag");
+        p->flags |= bit;
+    }
+    if ((p->flags & REGEXP_FLAG_UNICODE) && (p->flags & REGEXP_FLAG_UNICODE_SETS)) {
+        return fail(p, offset, "Flags u and v cannot be combined");
+    }
+    p->unicode = (p->flags & (REGEXP_FLAG_UNICODE | REGEXP_FLAG_UNICODE_SETS)) != 0;
+    p->sets = (p->flags & REGEXP_FLAG_UNICODE_SETS) != 0;
+    return true;
+}
+
+/* 分析pattern，结果在p->code（p->count个字） */
+static bool parse_pattern(RegexpParser *p, const char *pattern, size_t length,
+                          const char *flags, size_t flags_length) {
+    p->source = pattern;
+    p->length = length;
+    p->pos = 0;
+    p->flags = 0;
+    p->unicode = p->sets = p->named = false;
+    p->groups = p->group_index = p->pending = 0;
+    p->depth = 0;
+    p->message = NULL;
+    p->error_pos = 0;
+    p->oom = false;
+    p->count = p->jump_count = p->path_length = 0;
+    p->disjunctions = 0;
+    p->name_count = p->name_length = p->paths_length = 0;
+
+    if (!parse_flags(p, flags, flags_length, length + 1) || !prescan(p)) return false;
+    if (p->groups > 0x7FFFFE) return fail(p, 0, "Too many capture groups");
+    if (!parse_disjunction(p)) return false;
+    if (p->pos < p->length) return fail(p, p->pos, "Unmatched ')'");
+    return emit_op(p, REGEXP_OP_MATCH, 0);
+}
+
+/* ---------- 缓存 ---------- */
+
+static uint32_t slot_hash(const void *slot, const void *context) {
+    (void)context;
+    return ((const RegexpSlot*)slot)->hash;
+}
+
+static bool result(const RegexpEntry *entry, const RegexpProgram **program, RegexpError *error) {
+    if (entry->message) {
+        error->message = entry->message;
+        error->offset = entry->offset;
+        error->out_of_memory = false;
+        return false;
+    }
+    *program = &entry->program;
+    return true;
+}
+
+bool regexp_compile(RegexpCache *cache, const char *literal, size_t length,
+                    const RegexpProgram **program, RegexpError *error) {
+    error->message = "Out of memory";
+    error->offset = 0;
+    error->out_of_memory = true;
+    if (length > UINT32_MAX) return false;
+
+    cache->lookups++;
+    uint32_t hash = hash_text(literal, length);
+    size_t i = hash & (cache->capacity - 1);
+    while (cache->slots[i].text) {
+        const RegexpSlot *slot = &cache->slots[i];
+        if (slot->hash == hash && slot->length == length && memcmp(slot->text, literal, length) == 0) {
+            cache->hits++;
+            return result(slot->entry, program, error);
+        }
+        i = (i + 1) & (cache->capacity - 1);
+    }
+
+    /* 模式是两个/之间的部分，最后一个/之后是标志 */
+    const char *close = literal + length;
+    while (close > literal + 1 && close[-1] != '/') close--;
+    if (length < 2 || literal[0] != '/' || close == literal + 1) {
+        error->message = "Unterminated regular expression";
+        error->out_of_memory = false;
+        return false;
+    }
+    RegexpParser *p = &cache->parser;
+    size_t pattern_length = (size_t)(close - literal) - 2;
+    bool valid = parse_pattern(p, literal + 1, pattern_length, close, (size_t)(literal + length - close));
+    if (p->oom) return false;
+
+    size_t capacity = cache->capacity;
+    if (!hash_table_reserve((void**)&cache->slots, &cache->capacity, cache->count, sizeof(RegexpSlot),
+                            REGEXP_INITIAL_SLOTS, slot_hash, NULL)) {
+        return false;
+    }
+    if (cache->capacity != capacity) {
+        i = hash & (cache->capacity - 1);
+        while (cache->slots[i].text) i = (i + 1) & (cache->capacity - 1);
+    }
+    RegexpEntry *entry = (RegexpEntry*)arena_alloc(&cache->arena, sizeof(RegexpEntry));
+    char *text = entry ? (char*)arena_alloc(&cache->arena, length + 1) : NULL;
+    uint32_t *code = text && valid ? (uint32_t*)arena_alloc(&cache->arena, p->count * sizeof(uint32_t)) : NULL;
+    if (!text || (valid && !code)) return false;
+    memcpy(text, literal, length);
+    text[length] = '\0';
+    memset(entry, 0, sizeof(RegexpEntry));
+    if (valid) {
+        memcpy(code, p->code, p->count * sizeof(uint32_t));
+        entry->program.code = code;
+        entry->program.length = (uint32_t)p->count;
+        entry->program.groups = p->groups;
+        entry->program.flags = p->flags;
+        entry->program.pattern = text + 1;
+        entry->program.pattern_length = (uint32_t)pattern_length;
+    } else {
+        entry->message = p->message;
+        entry->offset = (uint32_t)(p->error_pos + 1);
+    }
+    cache->slots[i].text = text;
+    cache->slots[i].length = (uint32_t)length;
+    cache->slots[i].hash = hash;
+    cache->slots[i].entry = entry;
+    cache->count++;
+    return result(entry, program, error);
+}
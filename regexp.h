@@ -0,0 +1,114 @@
+#ifndef REGEXP_H
+#define REGEXP_H
+
+#include "common.h"
+
+#define REGEXP_BLOCK (64u << 10)        /* 缓存arena的每块大小 */
+#define REGEXP_INITIAL_SLOTS 256        /* 缓存哈希表的初始槽数（2的幂） */
+#define REGEXP_MAX_DEPTH 256            /* 分组和字符类的最大嵌套层数 */
+
+/*
+ * 正则表达式字面量的检查和编译。
+ *
+ * 按ECMAScript的文法分析模式和标志：没有u/v标志时按附录B的Web兼容文法（允许单独的]、{、}，
+ * 超出分组数的\1按八进制转义等），有u标志时按严格的Unicode文法，v标志另有集合运算的字符类
+ * （嵌套类、&&、--、\q{...}）。合法的模式编译为紧凑的字节码（回溯式NFA），不合法的给出
+ * 出错位置和说明。
+ *
+ * 结果按字面量文本的哈希缓存：同一个正则在大bundle中反复出现时只分析一次。
+ * 一个缓存不加锁，只给一个线程使用。
+ *
+ * 字节码：每条指令一个32位字，低8位是操作码，高24位是参数（跳转是相对本条指令的有符号偏移）；
+ * 部分指令后面跟若干个参数字。程序以REGEXP_OP_MATCH结束。
+ */
+
+/* 标志 */
+#define REGEXP_FLAG_HAS_INDICES 0x01    /* d */
+#define REGEXP_FLAG_GLOBAL      0x02    /* g */
+#define REGEXP_FLAG_IGNORE_CASE 0x04    /* i */
+#define REGEXP_FLAG_MULTILINE   0x08    /* m */
+#define REGEXP_FLAG_DOT_ALL     0x10    /* s */
+#define REGEXP_FLAG_UNICODE     0x20    /* u */
+#define REGEXP_FLAG_UNICODE_SETS 0x40   /* v */
+#define REGEXP_FLAG_STICKY      0x80    /* y */
+
+/* 操作码 */
+typedef enum {
+    REGEXP_OP_MATCH,        /* 匹配成功 */
+    REGEXP_OP_CHAR,         /* 参数：码点（没有u/v时为UTF-16码元） */
+    REGEXP_OP_ANY,          /* . */
+    REGEXP_OP_CLASS,        /* 参数：后面字符类的字数（一个REGEXP_CLASS_SET） */
+    REGEXP_OP_SPLIT,        /* 先试下一条，失败后从参数处继续 */
+    REGEXP_OP_JUMP,         /* 跳到参数处 */
+    REGEXP_OP_SAVE,         /* 参数：捕获位置的槽（组号*2为开始，组号*2+1为结束） */
+    REGEXP_OP_ASSERT,       /* 参数：REGEXP_ASSERT_* */
+    REGEXP_OP_BACKREF,      /* 参数：组号 */
+    REGEXP_OP_LOOK,         /* 参数：REGEXP_LOOK_*；下一字为子程序的字数，子程序以MATCH结束 */
+    REGEXP_OP_REPEAT,       /* 参数：1为非贪婪；后面三字：最少次数、最多次数（UINT32_MAX为不限）、循环体字数 */
+    REGEXP_OP_MODIFIERS     /* 参数：低8位打开、高8位关闭的标志；下一字为组内程序的字数 */
+} RegexpOp;
+
+typedef enum {
+    REGEXP_ASSERT_BEGIN,    /* ^ */
+    REGEXP_ASSERT_END,      /* $ */
+    REGEXP_ASSERT_WORD,     /* \b */
+    REGEXP_ASSERT_NOT_WORD  /* \B */
+} RegexpAssert;
+
+typedef enum {
+    REGEXP_LOOK_AHEAD,      /* (?= */
+    REGEXP_LOOK_AHEAD_NOT,  /* (?! */
+    REGEXP_LOOK_BEHIND,     /* (?<= */
+    REGEXP_LOOK_BEHIND_NOT  /* (?<! */
+} RegexpLook;
+
+/* 字符类的项：低8位是种类，高24位是参数 */
+typedef enum {
+    REGEXP_CLASS_SET,       /* 参数：运算（REGEXP_SET_*）| 取反<<4；下一字为各项的字数，之后是各项 */
+    REGEXP_CLASS_RANGE,     /* 参数：起始码点；下一字为结束码点 */
+    REGEXP_CLASS_ESCAPE,    /* 参数：'d' 'D' 's' 'S' 'w' 'W' */
+    REGEXP_CLASS_PROPERTY,  /* 参数：1为\P；后面两字：名字（name或name=value）在模式中的偏移和长度 */
+    REGEXP_CLASS_STRING     /* 参数：码点数；之后每字一个码点（v模式的\q{...}） */
+} RegexpClassItem;
+
+typedef enum {
+    REGEXP_SET_UNION,
+    REGEXP_SET_INTERSECTION,
+    REGEXP_SET_SUBTRACTION
+} RegexpSetOp;
+
+/* 编译结果 */
+typedef struct {
+    const uint32_t *code;
+    uint32_t length;        /* 字数 */
+    uint32_t groups;        /* 捕获组数 */
+    uint8_t flags;          /* REGEXP_FLAG_* */
+    const char *pattern;    /* 模式文本（REGEXP_CLASS_PROPERTY的偏移相对于此） */
+    uint32_t pattern_length;
+} RegexpProgram;
+
+/* 出错信息 */
+typedef struct {
+    const char *message;
+    size_t offset;          /* 相对字面量开头的字节偏移 */
+    bool out_of_memory;
+} RegexpError;
+
+typedef struct RegexpCache RegexpCache;
+
+/* 缓存函数 */
+RegexpCache* regexp_cache_create(void);
+void regexp_cache_destroy(RegexpCache *cache);
+
+/* 检查并编译正则字面量 /pattern/flags。合法时返回true，*program指向缓存中的结果（缓存销毁前有效）；
+   不合法或内存不足时返回false，错误见*error */
+bool regexp_compile(RegexpCache *cache, const char *literal, size_t length,
+                    const RegexpProgram **program, RegexpError *error);
+
+/* 统计：不同的字面量数、查询次数、命中次数、占用的字节数 */
+size_t regexp_cache_count(const RegexpCache *cache);
+size_t regexp_cache_lookups(const RegexpCache *cache);
+size_t regexp_cache_hits(const RegexpCache *cache);
+size_t regexp_cache_bytes(const RegexpCache *cache);
+
+#endif /* REGEXP_H */
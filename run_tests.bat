@@ -30,7 +30,7 @@ echo [92m测试合法脚本 (tests/valid/)[0m
 echo ----------------------------------------
 
 if exist "tests\valid\*.js" (
-    for %%f in (tests\valid\*.js) do (
+    for %%f in (tests\valid\*.js tests\valid\*.mjs) do (
         set /a total+=1
         echo   测试: %%~nxf
         
@@ -54,7 +54,7 @@ echo [95m测试错误脚本 (tests/invalid/)[0m
 echo ----------------------------------------
 
 if exist "tests\invalid\*.js" (
-    for %%f in (tests\invalid\*.js) do (
+    for %%f in (tests\invalid\*.js tests\invalid\*.mjs) do (
         set /a total+=1
         echo   测试: %%~nxf
         
@@ -71,6 +71,91 @@ if exist "tests\invalid\*.js" (
     echo   [93m未找到测试文件[0m
 )
 
+echo.
+
+REM 测试lint诊断（输出与同名.expected文件比较）
+echo [94m测试lint诊断 (tests/lint/)[0m
+echo ----------------------------------------
+
+if exist "tests\lint\*.js" (
+    for %%f in (tests\lint\*.js) do (
+        set /a total+=1
+        echo   测试: %%~nxf
+        
+        js_parser.exe --lint "tests/lint/%%~nxf" > "%TEMP%\js_lint_actual.txt" 2>&1
+        fc "%TEMP%\js_lint_actual.txt" "tests\lint\%%~nf.expected" >nul 2>&1
+        if !errorlevel! equ 0 (
+            echo     [92m✓ 诊断一致[0m
+            set /a passed+=1
+        ) else (
+            echo     [91m✗ 诊断不一致[0m
+            set /a failed+=1
+        )
+    )
+    del "%TEMP%\js_lint_actual.txt" >nul 2>&1
+) else (
+    echo   [93m未找到测试文件[0m
+)
+
+echo.
+
+REM 各输出方式同样必须拒绝错误脚本
+echo [96m测试各输出方式拒绝错误脚本 (tests/invalid/)[0m
+echo ----------------------------------------
+
+if exist "tests\invalid\*.js" (
+    for %%f in (tests\invalid\*.js tests\invalid\*.mjs) do (
+        set /a total+=1
+        echo   测试: %%~nxf
+        
+        set accepted=
+        REM 带引号，否则for会在=处把--emit=estree拆开
+        for %%m in ("--minify" "--format" "--fold" "--emit=estree" "--lint") do (
+            js_parser.exe %%~m "%%f" >nul 2>&1
+            if !errorlevel! equ 0 set accepted=!accepted! %%~m
+        )
+        if "!accepted!"=="" (
+            echo     [92m✓ 各方式均检测到错误[0m
+            set /a passed+=1
+        ) else (
+            echo     [91m✗ 未报错:!accepted![0m
+            set /a failed+=1
+        )
+    )
+) else (
+    echo   [93m未找到测试文件[0m
+)
+
+REM 输出测试：每个.expected对应同名的输入（.js/.mjs/.lsp文件，或同名目录中的main.js），
+REM 按目录用:run_output中的参数运行，输出与.expected比较
+REM graph和tree-shake的输出含有绝对路径，批处理无法去掉当前目录前缀，不运行
+echo [93m测试各输出方式的输出 (tests/^<方式^>/)[0m
+echo ----------------------------------------
+
+for %%d in (estree minify sourcemap scan-imports bundle format highlight lsp fold) do (
+    for %%e in (tests\%%d\*.expected) do (
+        set /a total+=1
+        set "stem=tests\%%d\%%~ne"
+        set "input=!stem!.js"
+        if exist "!stem!.mjs" set "input=!stem!.mjs"
+        if exist "!stem!.lsp" set "input=!stem!.lsp"
+        if exist "!stem!\main.js" set "input=!stem!\main.js"
+        echo   测试: !input!
+        
+        call :run_output %%d "!input!" > "%TEMP%\js_output_actual.txt" 2>nul
+        fc "%TEMP%\js_output_actual.txt" "%%e" >nul 2>&1
+        if !errorlevel! equ 0 (
+            echo     [92m✓ 输出一致[0m
+            set /a passed+=1
+        ) else (
+            echo     [91m✗ 输出不一致[0m
+            set /a failed+=1
+        )
+    )
+)
+del "%TEMP%\js_output_actual.txt" >nul 2>&1
+del "tests\sourcemap\.actual.map" >nul 2>&1
+
 echo.
 echo ========================================
 echo   测试总结
@@ -88,3 +173,16 @@ if !failed! equ 0 (
     echo [93m⚠️  有 !failed! 个测试失败[0m
     exit /b 1
 )
+
+REM 按测试目录运行一个输入（%1为目录名，%2为输入文件）
+:run_output
+if "%~1"=="estree" js_parser.exe --emit=estree %2
+if "%~1"=="minify" js_parser.exe --minify %2
+if "%~1"=="sourcemap" js_parser.exe --minify --source-map tests\sourcemap\.actual.map %2 && type tests\sourcemap\.actual.map
+if "%~1"=="scan-imports" js_parser.exe --scan-imports %2
+if "%~1"=="bundle" js_parser.exe --bundle %2
+if "%~1"=="format" js_parser.exe --format %2
+if "%~1"=="highlight" js_parser.exe --highlight %2
+if "%~1"=="lsp" js_parser.exe --lsp < %2
+if "%~1"=="fold" js_parser.exe --fold %2
+exit /b 0
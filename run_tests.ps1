@@ -28,12 +28,47 @@ $validPassed = 0
 $validFailed = 0
 $invalidPassed = 0
 $invalidFailed = 0
+$lintPassed = 0
+$lintFailed = 0
+$modesPassed = 0
+$modesFailed = 0
+$errorModes = @("--minify", "--format", "--fold", "--emit=estree", "--lint")
+$outputPassed = 0
+$outputFailed = 0
+$outputCount = 0
+
+# Output tests: how each directory under tests/ runs its input (stdout is compared with the .expected file)
+$outputCommands = [ordered]@{
+    "estree" = { param($file) & .\js_parser.exe --emit=estree $file 2>$null }
+    "minify" = { param($file) & .\js_parser.exe --minify $file 2>$null }
+    "sourcemap" = { param($file) & .\js_parser.exe --minify --source-map tests\sourcemap\.actual.map $file 2>$null; Get-Content tests\sourcemap\.actual.map }
+    "scan-imports" = { param($file) & .\js_parser.exe --scan-imports $file 2>$null }
+    "graph" = { param($file) & .\js_parser.exe --graph $file 2>$null }
+    "tree-shake" = { param($file) & .\js_parser.exe --tree-shake $file 2>$null }
+    "bundle" = { param($file) & .\js_parser.exe --bundle $file 2>$null }
+    "format" = { param($file) & .\js_parser.exe --format $file 2>$null }
+    "highlight" = { param($file) & .\js_parser.exe --highlight $file 2>$null }
+    "lsp" = { param($file) cmd /c "js_parser.exe --lsp < $file 2>nul" }
+    "fold" = { param($file) & .\js_parser.exe --fold $file 2>$null }
+}
+
+# Strip the current directory so absolute paths in the output do not depend on the checkout location
+function Remove-CurrentDirectory($lines) {
+    $cwd = (Get-Location).Path
+    $prefixes = @(($cwd.Replace('\', '\\') + '\\'), ($cwd.Replace('\', '/') + '/'))
+    foreach ($line in @($lines)) {
+        foreach ($prefix in $prefixes) {
+            $line = $line.Replace($prefix, '')
+        }
+        $line
+    }
+}
 
 # Test valid JavaScript files (should pass)
 Write-Host "[VALID] Testing valid scripts (tests/valid/)" -ForegroundColor Green
 Write-Host "----------------------------------------" -ForegroundColor Gray
 
-$validFiles = Get-ChildItem -Path ".\tests\valid\*.js" -ErrorAction SilentlyContinue
+$validFiles = Get-ChildItem -Path ".\tests\valid\*" -Include *.js,*.mjs -ErrorAction SilentlyContinue
 
 if ($validFiles) {
     foreach ($file in $validFiles) {
@@ -64,7 +99,7 @@ Write-Host ""
 Write-Host "[INVALID] Testing invalid scripts (tests/invalid/)" -ForegroundColor Magenta
 Write-Host "----------------------------------------" -ForegroundColor Gray
 
-$invalidFiles = Get-ChildItem -Path ".\tests\invalid\*.js" -ErrorAction SilentlyContinue
+$invalidFiles = Get-ChildItem -Path ".\tests\invalid\*" -Include *.js,*.mjs -ErrorAction SilentlyContinue
 
 if ($invalidFiles) {
     foreach ($file in $invalidFiles) {
@@ -92,6 +127,105 @@ if ($invalidFiles) {
 Write-Host ""
 
 # Summary
+# Test lint diagnostics (output should match the .expected file)
+Write-Host "[LINT] Testing lint diagnostics (tests/lint/)" -ForegroundColor Blue
+Write-Host "----------------------------------------" -ForegroundColor Gray
+
+$lintFiles = Get-ChildItem -Path ".\tests\lint\*.js" -ErrorAction SilentlyContinue
+
+if ($lintFiles) {
+    foreach ($file in $lintFiles) {
+        $totalTests++
+        Write-Host "  Test: $($file.Name)" -NoNewline
+        
+        $output = & .\js_parser.exe --lint "tests/lint/$($file.Name)" 2>&1
+        $expectedFile = [System.IO.Path]::ChangeExtension($file.FullName, ".expected")
+        $expected = Get-Content $expectedFile -ErrorAction SilentlyContinue
+        
+        if ((@($output) -join "`n") -eq (@($expected) -join "`n")) {
+            Write-Host " [PASS]" -ForegroundColor Green
+            $passedTests++
+            $lintPassed++
+        } else {
+            Write-Host " [FAIL] Diagnostics differ" -ForegroundColor Red
+            $failedTests++
+            $lintFailed++
+            $output | ForEach-Object { Write-Host "      $_" -ForegroundColor DarkGray }
+        }
+    }
+} else {
+    Write-Host "  [WARNING] No test files found" -ForegroundColor Yellow
+}
+
+Write-Host ""
+
+# Every output mode must reject the invalid scripts too
+Write-Host "[MODES] Testing output modes on invalid scripts (tests/invalid/)" -ForegroundColor DarkCyan
+Write-Host "----------------------------------------" -ForegroundColor Gray
+
+if ($invalidFiles) {
+    foreach ($file in $invalidFiles) {
+        $totalTests++
+        Write-Host "  Test: $($file.Name)" -NoNewline
+        
+        $accepted = @()
+        foreach ($mode in $errorModes) {
+            & .\js_parser.exe $mode $file.FullName *> $null
+            if ($LASTEXITCODE -eq 0) {
+                $accepted += $mode
+            }
+        }
+        
+        if ($accepted.Count -eq 0) {
+            Write-Host " [PASS] Error detected" -ForegroundColor Green
+            $passedTests++
+            $modesPassed++
+        } else {
+            Write-Host " [FAIL] Not reported by $($accepted -join ', ')" -ForegroundColor Red
+            $failedTests++
+            $modesFailed++
+        }
+    }
+} else {
+    Write-Host "  [WARNING] No test files found" -ForegroundColor Yellow
+}
+
+Write-Host ""
+
+# Output tests (each .expected file names its input: .js/.mjs/.lsp with the same name, or main.js in a directory)
+Write-Host "[OUTPUT] Testing output modes (tests/<mode>/)" -ForegroundColor DarkYellow
+Write-Host "----------------------------------------" -ForegroundColor Gray
+
+foreach ($dir in $outputCommands.Keys) {
+    $expectedFiles = Get-ChildItem -Path ".\tests\$dir\*.expected" -ErrorAction SilentlyContinue
+    foreach ($expectedFile in $expectedFiles) {
+        $totalTests++
+        $outputCount++
+        $stem = "tests/$dir/$($expectedFile.BaseName)"
+        $inputPath = "$stem.js"
+        if (Test-Path "$stem.mjs") { $inputPath = "$stem.mjs" }
+        if (Test-Path "$stem.lsp") { $inputPath = "$stem.lsp" }
+        if (Test-Path "$stem" -PathType Container) { $inputPath = "$stem/main.js" }
+        Write-Host "  Test: $inputPath" -NoNewline
+        
+        $output = Remove-CurrentDirectory (& $outputCommands[$dir] $inputPath)
+        $expected = Get-Content $expectedFile.FullName -ErrorAction SilentlyContinue
+        
+        if ((@($output) -join "`n") -eq (@($expected) -join "`n")) {
+            Write-Host " [PASS]" -ForegroundColor Green
+            $passedTests++
+            $outputPassed++
+        } else {
+            Write-Host " [FAIL] Output differs" -ForegroundColor Red
+            $failedTests++
+            $outputFailed++
+        }
+    }
+}
+Remove-Item ".\tests\sourcemap\.actual.map" -ErrorAction SilentlyContinue
+
+Write-Host ""
+
 Write-Host "========================================" -ForegroundColor Cyan
 Write-Host "  Test Summary" -ForegroundColor Cyan
 Write-Host "========================================" -ForegroundColor Cyan
@@ -102,6 +236,9 @@ Write-Host "Failed: $failedTests" -ForegroundColor $(if ($failedTests -eq 0) { "
 Write-Host ""
 Write-Host "Valid scripts: $validPassed/$($validFiles.Count) passed" -ForegroundColor $(if ($validFailed -eq 0) { "Green" } else { "Yellow" })
 Write-Host "Invalid scripts: $invalidPassed/$($invalidFiles.Count) passed" -ForegroundColor $(if ($invalidFailed -eq 0) { "Green" } else { "Yellow" })
+Write-Host "Lint diagnostics: $lintPassed/$($lintFiles.Count) passed" -ForegroundColor $(if ($lintFailed -eq 0) { "Green" } else { "Yellow" })
+Write-Host "Output modes: $modesPassed/$($invalidFiles.Count) passed" -ForegroundColor $(if ($modesFailed -eq 0) { "Green" } else { "Yellow" })
+Write-Host "Output tests: $outputPassed/$outputCount passed" -ForegroundColor $(if ($outputFailed -eq 0) { "Green" } else { "Yellow" })
 Write-Host ""
 
 if ($failedTests -eq 0) {
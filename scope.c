@@ -0,0 +1,762 @@
+#include "scope.h"
+#include "parser.h"
+#include "line_index.h"
+#include "cooked.h"
+
+/*
+ * 作用域分析
+ *
+ * 1. 遍历AST：函数、语句块、catch、类、for (let ...) 和switch体各建立一个作用域。
+ *    声明按出现顺序记录——var（以及函数顶层的函数声明）记到最近的函数作用域，同时记下声明所在的作用域；
+ *    不是绑定也不是属性名的标识符记为引用。名字在一个开放寻址表中去重为编号，之后只比较整数。
+ * 2. 绑定按作用域做一次计数排序，连续存放；每个作用域在共享的slots数组中占一段开放寻址表。
+ *    插入时检查重复声明，var还要检查从声明处到函数作用域之间的块中有没有同名的词法声明。
+ * 3. 引用从所在作用域向外逐层查表，得到(depth, slot)。
+ *
+ * 除了这几个按倍数增长的数组，分析过程中没有其他内存分配。
+ */
+
+/* 遍历时记录的绑定 */
+typedef struct {
+    uint32_t name;
+    uint32_t node;
+    uint32_t scope;         /* 绑定所属的作用域 */
+    uint32_t origin;        /* 声明所在的作用域（var可以在内层块中） */
+    uint8_t kind;           /* ScopeBindingKind */
+} PendingBinding;
+
+typedef struct {
+    ScopeTree *tree;
+    const Ast *ast;
+    const char *source;
+    size_t scope_capacity;
+    size_t reference_capacity;
+    size_t name_list_capacity;
+    PendingBinding *pending;
+    size_t pending_count;
+    size_t pending_capacity;
+    bool failed;            /* 内存不足 */
+    size_t error_offset;    /* 已发现的最靠前的错误，SIZE_MAX表示没有 */
+    char message[160];
+} ScopeBuilder;
+
+/* 保证数组还能追加一个元素 */
+static bool reserve(void **items, size_t *capacity, size_t count, size_t size) {
+    if (count < *capacity) return true;
+
+    size_t new_capacity = *capacity ? *capacity * 2 : 64;
+    void *grown = realloc(*items, new_capacity * size);
+    if (!grown) return false;
+    *items = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+static inline const AstNode* node_at(const ScopeBuilder *b, uint32_t node) {
+    return &b->ast->nodes[node];
+}
+
+static inline bool is_null(const ScopeBuilder *b, uint32_t node) {
+    return node == AST_NONE || b->ast->nodes[node].kind == AST_NULL;
+}
+
+static inline uint32_t next_of(const ScopeBuilder *b, uint32_t node) {
+    return b->ast->nodes[node].next_sibling;
+}
+
+/* 记录错误，只保留源码中最靠前的一处（name为SCOPE_NONE时format不含名字） */
+static void report_at(ScopeBuilder *b, size_t offset, const char *format, uint32_t name) {
+    if (offset >= b->error_offset) return;
+
+    b->error_offset = offset;
+    if (name == SCOPE_NONE) {
+        snprintf(b->message, sizeof(b->message), "%s", format);
+        return;
+    }
+    const ScopeName *n = &b->tree->names[name];
+    snprintf(b->message, sizeof(b->message), format, (int)n->length, b->source + n->offset);
+}
+
+static void report(ScopeBuilder *b, uint32_t node, const char *format, uint32_t name) {
+    report_at(b, node_at(b, node)->start, format, name);
+}
+
+/* ---------- 名字去重 ---------- */
+
+/* 按文本查找名字编号，找不到返回SCOPE_NONE */
+static uint32_t find_name(const ScopeTree *tree, const char *text, size_t length, size_t *slot) {
+    size_t mask = tree->name_capacity - 1;
+    size_t i = fnv1a_hash(text, length) & mask;
+    for (; tree->name_table[i]; i = (i + 1) & mask) {
+        const ScopeName *n = &tree->names[tree->name_table[i] - 1];
+        if (n->length == length && memcmp(tree->source + n->offset, text, length) == 0) {
+            break;
+        }
+    }
+    if (slot) *slot = i;
+    return tree->name_table[i] ? tree->name_table[i] - 1 : SCOPE_NONE;
+}
+
+/* 名字编号（第一次出现时分配） */
+static uint32_t intern_name(ScopeBuilder *b, uint32_t offset, uint32_t length) {
+    ScopeTree *tree = b->tree;
+    if ((tree->name_count + 1) * 2 > tree->name_capacity) {
+        size_t capacity = tree->name_capacity ? tree->name_capacity * 2 : 256;
+        uint32_t *table = (uint32_t*)calloc(capacity, sizeof(uint32_t));
+        if (!table) {
+            b->failed = true;
+            return 0;
+        }
+        for (size_t id = 0; id < tree->name_count; id++) {
+            const ScopeName *n = &tree->names[id];
+            size_t i = fnv1a_hash(b->source + n->offset, n->length) & (capacity - 1);
+            while (table[i]) i = (i + 1) & (capacity - 1);
+            table[i] = (uint32_t)id + 1;
+        }
+        free(tree->name_table);
+        tree->name_table = table;
+        tree->name_capacity = capacity;
+    }
+
+    size_t slot;
+    uint32_t id = find_name(tree, b->source + offset, length, &slot);
+    if (id != SCOPE_NONE) return id;
+
+    if (!reserve((void**)&tree->names, &b->name_list_capacity, tree->name_count, sizeof(ScopeName))) {
+        b->failed = true;
+        return 0;
+    }
+    tree->names[tree->name_count].offset = offset;
+    tree->names[tree->name_count].length = length;
+    tree->name_table[slot] = (uint32_t)++tree->name_count;
+    return (uint32_t)tree->name_count - 1;
+}
+
+/* ---------- 遍历 ---------- */
+
+static uint32_t open_scope(ScopeBuilder *b, ScopeKind kind, uint32_t parent, uint32_t node, bool strict) {
+    ScopeTree *tree = b->tree;
+    if (!reserve((void**)&tree->scopes, &b->scope_capacity, tree->scope_count, sizeof(Scope))) {
+        b->failed = true;
+        return parent;
+    }
+    Scope *scope = &tree->scopes[tree->scope_count];
+    memset(scope, 0, sizeof(*scope));
+    scope->parent = parent;
+    scope->node = node;
+    scope->kind = (uint8_t)kind;
+    scope->strict = strict;
+    return (uint32_t)tree->scope_count++;
+}
+
+/* var声明所属的作用域：最近的函数或顶层作用域 */
+static uint32_t var_scope(const ScopeBuilder *b, uint32_t scope) {
+    const Scope *scopes = b->tree->scopes;
+    while (scopes[scope].kind != SCOPE_FUNCTION && scopes[scope].kind != SCOPE_SCRIPT &&
+           scopes[scope].kind != SCOPE_MODULE) {
+        scope = scopes[scope].parent;
+    }
+    return scope;
+}
+
+static void declare(ScopeBuilder *b, uint32_t node, ScopeBindingKind kind, uint32_t scope) {
+    if (is_null(b, node) || node_at(b, node)->kind != AST_IDENTIFIER) return;
+    if (!reserve((void**)&b->pending, &b->pending_capacity, b->pending_count, sizeof(PendingBinding))) {
+        b->failed = true;
+        return;
+    }
+
+    const AstNode *n = node_at(b, node);
+    PendingBinding *p = &b->pending[b->pending_count];
+    p->name = intern_name(b, n->start, n->end - n->start);
+    p->node = node;
+    p->scope = kind == SCOPE_BINDING_VAR ? var_scope(b, scope) : scope;
+    p->origin = scope;
+    p->kind = (uint8_t)kind;
+    if (!b->failed) b->pending_count++;
+}
+
+static void add_reference(ScopeBuilder *b, uint32_t node, uint32_t scope) {
+    ScopeTree *tree = b->tree;
+    if (!reserve((void**)&tree->references, &b->reference_capacity, tree->reference_count,
+                 sizeof(ScopeReference))) {
+        b->failed = true;
+        return;
+    }
+
+    const AstNode *n = node_at(b, node);
+    ScopeReference *r = &tree->references[tree->reference_count];
+    r->node = node;
+    r->name = intern_name(b, n->start, n->end - n->start);
+    r->scope = scope;
+    r->depth = SCOPE_NONE;
+    r->slot = SCOPE_NONE;
+    if (!b->failed) tree->reference_count++;
+}
+
+static void visit(ScopeBuilder *b, uint32_t node, uint32_t scope);
+
+static void visit_children(ScopeBuilder *b, uint32_t first, uint32_t scope) {
+    for (uint32_t c = first; c != AST_NONE && !b->failed; c = next_of(b, c)) {
+        visit(b, c, scope);
+    }
+}
+
+/* 声明模式中的全部绑定；默认值和计算属性名按表达式处理 */
+static void declare_pattern(ScopeBuilder *b, uint32_t node, ScopeBindingKind kind, uint32_t scope) {
+    if (is_null(b, node)) return;
+
+    const AstNode *n = node_at(b, node);
+    switch (n->kind) {
+        case AST_IDENTIFIER:
+            declare(b, node, kind, scope);
+            break;
+
+        case AST_PROPERTY:
+            if (n->flags & AST_FLAG_COMPUTED) visit(b, n->first_child, scope);
+            declare_pattern(b, next_of(b, n->first_child), kind, scope);
+            break;
+
+        case AST_ASSIGNMENT_PATTERN:
+            declare_pattern(b, n->first_child, kind, scope);
+            visit(b, next_of(b, n->first_child), scope);
+            break;
+
+        case AST_ARRAY_PATTERN:
+        case AST_OBJECT_PATTERN:
+        case AST_REST_ELEMENT:
+            for (uint32_t c = n->first_child; c != AST_NONE; c = next_of(b, c)) {
+                declare_pattern(b, c, kind, scope);
+            }
+            break;
+
+        default:
+            visit(b, node, scope);
+            break;
+    }
+}
+
+/* 语句列表开头是否有 "use strict" 指令 */
+static bool has_use_strict(const ScopeBuilder *b, uint32_t first) {
+    for (uint32_t c = first; c != AST_NONE; c = next_of(b, c)) {
+        const AstNode *n = node_at(b, c);
+        if (n->kind != AST_EXPRESSION_STATEMENT) return false;
+        const AstNode *e = node_at(b, n->first_child);
+        if (e->kind != AST_LITERAL || (b->source[e->start] != '"' && b->source[e->start] != '\'')) {
+            return false;
+        }
+        if (e->end - e->start == 12 && memcmp(b->source + e->start + 1, "use strict", 10) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* 严格模式中的字面量不能是传统八进制数（010、08）或含传统八进制转义（\01、\8）。
+   指令序言中 "use strict" 之前的字符串也算，函数的严格性在进入函数体前已经确定 */
+static void check_legacy_octal(ScopeBuilder *b, uint32_t node, uint32_t scope) {
+    const AstNode *n = node_at(b, node);
+    if (!b->tree->scopes[scope].strict || n->kind != AST_LITERAL) return;
+
+    const char *text = b->source + n->start;
+    size_t length = n->end - n->start;
+    if (text[0] == '0' && length > 1 && text[1] >= '0' && text[1] <= '9') {
+        bool octal = true;
+        for (size_t i = 1; i < length && text[i] >= '0' && text[i] <= '9'; i++) {
+            octal = octal && text[i] <= '7';
+        }
+        report_at(b, n->start, octal ? "Octal literals are not allowed in strict mode"
+                                     : "Decimals with leading zeros are not allowed in strict mode",
+                  SCOPE_NONE);
+        return;
+    }
+    if (text[0] != '"' && text[0] != '\'') return;
+
+    for (size_t i = 1; i + 1 < length; i++) {
+        if (text[i] != '\\') continue;
+        if (cooked_legacy_escape(text + i + 1, length - i - 2)) {
+            report_at(b, n->start + i, text[i + 1] >= '8' ? "\\8 and \\9 are not allowed in strict mode"
+                                                          : "Octal escape sequences are not allowed in strict mode",
+                      SCOPE_NONE);
+            return;
+        }
+        i++;
+    }
+}
+
+/* 函数：参数和函数体顶层共用一个作用域 */
+static void visit_function(ScopeBuilder *b, uint32_t node, uint32_t scope, bool method) {
+    const AstNode *n = node_at(b, node);
+    bool arrow = n->kind == AST_ARROW_FUNCTION_EXPRESSION;
+    uint32_t first_param = n->first_child;
+    uint32_t id = AST_NONE;
+    if (!arrow) {
+        id = first_param;
+        first_param = next_of(b, first_param);
+    }
+
+    uint32_t body = AST_NONE;
+    bool simple = true;
+    for (uint32_t c = first_param; c != AST_NONE; c = next_of(b, c)) {
+        if (next_of(b, c) == AST_NONE) {
+            body = c;
+        } else if (node_at(b, c)->kind != AST_IDENTIFIER) {
+            simple = false;
+        }
+    }
+    if (body == AST_NONE) return;
+
+    const AstNode *body_node = node_at(b, body);
+    bool block = body_node->kind == AST_BLOCK_STATEMENT;
+    bool strict = b->tree->scopes[scope].strict || (block && has_use_strict(b, body_node->first_child));
+    uint32_t inner = open_scope(b, SCOPE_FUNCTION, scope, node, strict);
+    if (b->failed) return;
+    b->tree->scopes[inner].unique_params = strict || arrow || method || !simple;
+
+    if (n->kind == AST_FUNCTION_EXPRESSION) {
+        declare(b, id, SCOPE_BINDING_SELF, inner);
+    }
+    for (uint32_t c = first_param; c != body; c = next_of(b, c)) {
+        declare_pattern(b, c, SCOPE_BINDING_PARAM, inner);
+    }
+    if (block) {
+        visit_children(b, body_node->first_child, inner);
+    } else {
+        visit(b, body, inner);
+    }
+}
+
+/* 属性值：方法按方法处理（参数不允许重名） */
+static void visit_member_value(ScopeBuilder *b, uint32_t value, uint32_t scope, bool method) {
+    if (is_null(b, value)) return;
+    AstKind kind = (AstKind)node_at(b, value)->kind;
+    if (method && kind == AST_FUNCTION_EXPRESSION) {
+        visit_function(b, value, scope, true);
+    } else {
+        visit(b, value, scope);
+    }
+}
+
+static void visit(ScopeBuilder *b, uint32_t node, uint32_t scope) {
+    if (b->failed || is_null(b, node)) return;
+
+    const AstNode *n = node_at(b, node);
+    switch (n->kind) {
+        case AST_IDENTIFIER:
+            add_reference(b, node, scope);
+            break;
+
+        case AST_LITERAL:
+            check_legacy_octal(b, node, scope);
+            break;
+
+        case AST_VARIABLE_DECLARATION: {
+            ScopeBindingKind kind = n->op == TOKEN_LET ? SCOPE_BINDING_LET
+                                  : n->op == TOKEN_CONST ? SCOPE_BINDING_CONST : SCOPE_BINDING_VAR;
+            for (uint32_t c = n->first_child; c != AST_NONE; c = next_of(b, c)) {
+                uint32_t id = node_at(b, c)->first_child;
+                declare_pattern(b, id, kind, scope);
+                visit(b, next_of(b, id), scope);
+            }
+            break;
+        }
+
+        case AST_FUNCTION_DECLARATION:
+            declare(b, n->first_child, SCOPE_BINDING_FUNCTION, scope);
+            visit_function(b, node, scope, false);
+            break;
+
+        case AST_FUNCTION_EXPRESSION:
+        case AST_ARROW_FUNCTION_EXPRESSION:
+            visit_function(b, node, scope, false);
+            break;
+
+        case AST_CLASS_DECLARATION: {
+            declare(b, n->first_child, SCOPE_BINDING_CLASS, scope);
+            uint32_t inner = open_scope(b, SCOPE_CLASS, scope, node, true);
+            visit_children(b, next_of(b, n->first_child), inner);
+            break;
+        }
+
+        case AST_BLOCK_STATEMENT:
+            visit_children(b, n->first_child, open_scope(b, SCOPE_BLOCK, scope, node,
+                                                         b->tree->scopes[scope].strict));
+            break;
+
+        case AST_STATIC_BLOCK:
+            /* 静态初始化块像函数体一样容纳其中的var */
+            visit_children(b, n->first_child, open_scope(b, SCOPE_FUNCTION, scope, node, true));
+            break;
+
+        case AST_FOR_STATEMENT:
+        case AST_FOR_IN_STATEMENT:
+        case AST_FOR_OF_STATEMENT: {
+            /* for (let ...) 的头部单独一个作用域 */
+            const AstNode *init = node_at(b, n->first_child);
+            if (init->kind == AST_VARIABLE_DECLARATION && init->op != TOKEN_VAR) {
+                scope = open_scope(b, SCOPE_BLOCK, scope, node, b->tree->scopes[scope].strict);
+            }
+            visit_children(b, n->first_child, scope);
+            break;
+        }
+
+        case AST_SWITCH_STATEMENT:
+            visit(b, n->first_child, scope);
+            visit_children(b, next_of(b, n->first_child),
+                           open_scope(b, SCOPE_BLOCK, scope, node, b->tree->scopes[scope].strict));
+            break;
+
+        case AST_CATCH_CLAUSE: {
+            /* catch参数与catch块顶层的声明在同一个作用域 */
+            uint32_t inner = open_scope(b, SCOPE_CATCH, scope, node, b->tree->scopes[scope].strict);
+            uint32_t body = next_of(b, n->first_child);
+            declare_pattern(b, n->first_child, SCOPE_BINDING_CATCH, inner);
+            visit_children(b, node_at(b, body)->first_child, inner);
+            break;
+        }
+
+        case AST_WITH_STATEMENT:
+            if (b->tree->scopes[scope].strict) {
+                report(b, node, "Strict mode code may not include a with statement", SCOPE_NONE);
+            }
+            visit_children(b, n->first_child, scope);
+            break;
+
+        case AST_MEMBER_EXPRESSION:
+            /* a.b 的b不是引用 */
+            visit(b, n->first_child, scope);
+            if (n->flags & AST_FLAG_COMPUTED) visit(b, next_of(b, n->first_child), scope);
+            break;
+
+        case AST_PROPERTY:
+        case AST_METHOD_DEFINITION:
+        case AST_PROPERTY_DEFINITION: {
+            /* 非计算的属性名不是引用 */
+            bool method = n->kind == AST_METHOD_DEFINITION ||
+                          (n->flags & (AST_FLAG_METHOD | AST_FLAG_GETTER | AST_FLAG_SETTER));
+            if (n->flags & AST_FLAG_COMPUTED) {
+                visit(b, n->first_child, scope);
+            } else {
+                check_legacy_octal(b, n->first_child, scope);
+            }
+            visit_member_value(b, next_of(b, n->first_child), scope, method);
+            break;
+        }
+
+        case AST_IMPORT_DECLARATION:
+            check_legacy_octal(b, n->first_child, scope);
+            for (uint32_t c = next_of(b, n->first_child); c != AST_NONE; c = next_of(b, c)) {
+                const AstNode *spec = node_at(b, c);
+                uint32_t local = spec->kind == AST_IMPORT_SPECIFIER ? next_of(b, spec->first_child)
+                                                                     : spec->first_child;
+                declare(b, local, SCOPE_BINDING_IMPORT, scope);
+            }
+            break;
+
+        case AST_EXPORT_NAMED_DECLARATION: {
+            /* export {a as b} 中a是引用，b和 export ... from 中的名字都不是 */
+            uint32_t source = next_of(b, n->first_child);
+            visit(b, n->first_child, scope);
+            if (!is_null(b, source)) {
+                check_legacy_octal(b, source, scope);
+                break;
+            }
+            for (uint32_t c = next_of(b, source); c != AST_NONE; c = next_of(b, c)) {
+                if (node_at(b, node_at(b, c)->first_child)->kind == AST_IDENTIFIER) {
+                    add_reference(b, node_at(b, c)->first_child, scope);
+                }
+            }
+            break;
+        }
+
+        case AST_EXPORT_ALL_DECLARATION:
+            check_legacy_octal(b, next_of(b, n->first_child), scope);
+            break;
+
+        case AST_META_PROPERTY:
+        case AST_BREAK_STATEMENT:
+        case AST_CONTINUE_STATEMENT:
+            break;
+
+        default:
+            visit_children(b, n->first_child, scope);
+            break;
+    }
+}
+
+/* ---------- 建表与解析 ---------- */
+
+/* 名字编号在作用域查找表中的起始位置 */
+static inline size_t slot_hash(uint32_t name, uint32_t mask) {
+    return (name * 2654435761u) & mask;
+}
+
+/* 在作用域中查找名字编号对应的绑定 */
+static uint32_t lookup_id(const ScopeTree *tree, uint32_t scope, uint32_t name) {
+    const Scope *s = &tree->scopes[scope];
+    if (s->count == 0) return SCOPE_NONE;
+
+    const uint32_t *table = tree->slots + s->table;
+    for (size_t i = slot_hash(name, s->mask); table[i] != SCOPE_NONE; i = (i + 1) & s->mask) {
+        if (tree->bindings[table[i]].name == name) return table[i];
+    }
+    return SCOPE_NONE;
+}
+
+/* 词法声明：同一作用域中不能再有同名声明 */
+static bool is_lexical(const Scope *scope, uint8_t kind) {
+    switch (kind) {
+        case SCOPE_BINDING_LET:
+        case SCOPE_BINDING_CONST:
+        case SCOPE_BINDING_CLASS:
+        case SCOPE_BINDING_IMPORT:
+            return true;
+        case SCOPE_BINDING_FUNCTION:
+            return scope->kind != SCOPE_FUNCTION && scope->kind != SCOPE_SCRIPT;
+        default:
+            return false;
+    }
+}
+
+/* 把绑定插入所属作用域的查找表，同时检查重复声明 */
+static void insert_binding(ScopeBuilder *b, uint32_t index) {
+    ScopeTree *tree = b->tree;
+    const ScopeBinding *binding = &tree->bindings[index];
+    const Scope *scope = &tree->scopes[b->pending[index].scope];
+    uint32_t *table = tree->slots + scope->table;
+
+    size_t i = slot_hash(binding->name, scope->mask);
+    for (; table[i] != SCOPE_NONE; i = (i + 1) & scope->mask) {
+        const ScopeBinding *existing = &tree->bindings[table[i]];
+        if (existing->name != binding->name) continue;
+
+        if (existing->kind == SCOPE_BINDING_SELF) {
+            table[i] = index;
+        } else if (binding->kind == SCOPE_BINDING_SELF) {
+            /* 已有同名绑定 */
+        } else if (existing->kind == SCOPE_BINDING_PARAM && binding->kind == SCOPE_BINDING_PARAM) {
+            if (scope->unique_params) {
+                report(b, binding->node, "Duplicate parameter name '%.*s' not allowed in this context",
+                       binding->name);
+            }
+        } else if (is_lexical(scope, existing->kind) || is_lexical(scope, binding->kind)) {
+            /* 非严格模式下块中的同名函数声明是允许的（Annex B） */
+            bool annex_b = existing->kind == SCOPE_BINDING_FUNCTION &&
+                           binding->kind == SCOPE_BINDING_FUNCTION &&
+                           !scope->strict && scope->kind == SCOPE_BLOCK;
+            if (!annex_b) {
+                report(b, binding->node, "Identifier '%.*s' has already been declared", binding->name);
+            }
+        }
+        return;
+    }
+    table[i] = index;
+}
+
+/* 绑定按作用域排序并建立查找表 */
+static bool build_tables(ScopeBuilder *b) {
+    ScopeTree *tree = b->tree;
+    size_t count = b->pending_count;
+
+    tree->bindings = (ScopeBinding*)malloc((count ? count : 1) * sizeof(ScopeBinding));
+    PendingBinding *sorted = (PendingBinding*)malloc((count ? count : 1) * sizeof(PendingBinding));
+    if (!tree->bindings || !sorted) {
+        free(sorted);
+        return false;
+    }
+
+    /* 计数排序（稳定，同一作用域内保持出现顺序） */
+    for (size_t i = 0; i < count; i++) {
+        tree->scopes[b->pending[i].scope].count++;
+    }
+    size_t position = 0;
+    size_t slot_count = 0;
+    for (size_t s = 0; s < tree->scope_count; s++) {
+        Scope *scope = &tree->scopes[s];
+        scope->first = (uint32_t)position;
+        scope->table = (uint32_t)slot_count;
+        position += scope->count;
+        if (scope->count > 0) {
+            size_t size = 4;
+            while (size < (size_t)scope->count * 2) size *= 2;
+            scope->mask = (uint32_t)(size - 1);
+            slot_count += size;
+        }
+        scope->count = 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        Scope *scope = &tree->scopes[b->pending[i].scope];
+        sorted[scope->first + scope->count++] = b->pending[i];
+    }
+    free(b->pending);
+    b->pending = sorted;
+    tree->binding_count = count;
+
+    tree->slots = (uint32_t*)malloc((slot_count ? slot_count : 1) * sizeof(uint32_t));
+    if (!tree->slots) return false;
+    memset(tree->slots, 0xFF, slot_count * sizeof(uint32_t));
+    tree->slot_count = slot_count;
+
+    for (size_t i = 0; i < count; i++) {
+        tree->bindings[i].name = sorted[i].name;
+        tree->bindings[i].node = sorted[i].node;
+        tree->bindings[i].kind = sorted[i].kind;
+        insert_binding(b, (uint32_t)i);
+    }
+
+    /* 块中的var：经过的块作用域中不能有同名的词法声明，也不能与解构的catch参数同名
+       （只有 catch (e) 这种简单参数允许被var重新声明，Annex B） */
+    for (size_t i = 0; i < count; i++) {
+        const PendingBinding *p = &sorted[i];
+        if (p->kind != SCOPE_BINDING_VAR) continue;
+        for (uint32_t s = p->origin; s != p->scope; s = tree->scopes[s].parent) {
+            uint32_t found = lookup_id(tree, s, p->name);
+            if (found == SCOPE_NONE) continue;
+            uint8_t kind = tree->bindings[found].kind;
+            bool pattern = kind == SCOPE_BINDING_CATCH &&
+                           node_at(b, node_at(b, tree->scopes[s].node)->first_child)->kind != AST_IDENTIFIER;
+            if (pattern || is_lexical(&tree->scopes[s], kind)) {
+                report(b, p->node, "Identifier '%.*s' has already been declared", p->name);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+/* 引用从所在作用域向外逐层查找 */
+static void resolve_references(ScopeTree *tree) {
+    for (size_t i = 0; i < tree->reference_count; i++) {
+        ScopeReference *r = &tree->references[i];
+        uint32_t depth = 0;
+        for (uint32_t s = r->scope; s != SCOPE_NONE; s = tree->scopes[s].parent, depth++) {
+            uint32_t found = lookup_id(tree, s, r->name);
+            if (found != SCOPE_NONE) {
+                r->depth = depth;
+                r->slot = found - tree->scopes[s].first;
+                break;
+            }
+        }
+    }
+}
+
+bool scope_analyze(ScopeTree *tree, const Ast *ast, const char *source, ErrorInfo *error) {
+    memset(tree, 0, sizeof(*tree));
+    tree->source = source;
+
+    ScopeBuilder b;
+    memset(&b, 0, sizeof(b));
+    b.tree = tree;
+    b.ast = ast;
+    b.source = source;
+    b.error_offset = SIZE_MAX;
+
+    const AstNode *program = &ast->nodes[ast->root];
+    bool module = (program->flags & AST_FLAG_MODULE) != 0;
+    uint32_t root = open_scope(&b, module ? SCOPE_MODULE : SCOPE_SCRIPT, SCOPE_NONE, ast->root,
+                               module || has_use_strict(&b, program->first_child));
+    if (!b.failed) {
+        visit_children(&b, program->first_child, root);
+    }
+    if (!b.failed && !build_tables(&b)) {
+        b.failed = true;
+    }
+    free(b.pending);
+
+    if (b.failed) {
+        set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+        scope_tree_free(tree);
+        return false;
+    }
+    resolve_references(tree);
+
+    if (b.error_offset != SIZE_MAX) {
+        Position position = {1, 1, (int)b.error_offset};
+        for (size_t i = 0; i < b.error_offset; i++) {
+            if (source[i] == '\n') {
+                position.line++;
+                position.column = 1;
+            } else if (((unsigned char)source[i] & 0xC0) != 0x80) {
+                position.column++;
+            }
+        }
+        set_error(error, ERROR_SCOPE_REDECLARATION, position, b.message);
+        return false;
+    }
+    return true;
+}
+
+void scope_tree_free(ScopeTree *tree) {
+    free(tree->scopes);
+    free(tree->bindings);
+    free(tree->references);
+    free(tree->names);
+    free(tree->name_table);
+    free(tree->slots);
+    memset(tree, 0, sizeof(*tree));
+}
+
+uint32_t scope_lookup(const ScopeTree *tree, uint32_t scope, const char *name, size_t length) {
+    if (tree->name_count == 0) return SCOPE_NONE;
+    uint32_t id = find_name(tree, name, length, NULL);
+    return id == SCOPE_NONE ? SCOPE_NONE : lookup_id(tree, scope, id);
+}
+
+bool scope_check(const Ast *ast, const char *source, ErrorInfo *error) {
+    ScopeTree tree;
+    bool success = scope_analyze(&tree, ast, source, error);
+    scope_tree_free(&tree);
+    return success;
+}
+
+bool scope_parse(Parser *parser) {
+    if (!parser_parse(parser) || parser->error->code != ERROR_NONE) {
+        return false;
+    }
+    return parser->ast->failed || scope_check(parser->ast, parser->lexer->source, parser->error);
+}
+
+static const char *const scope_kind_names[] = {
+    "script", "module", "function", "block", "catch", "class"
+};
+
+void scope_tree_write(const ScopeTree *tree, const Ast *ast, size_t length, Writer *writer) {
+    uint32_t *depths = (uint32_t*)malloc((tree->scope_count ? tree->scope_count : 1) * sizeof(uint32_t));
+    LineIndex lines;
+    if (!depths || !line_index_build(&lines, tree->source, length)) {
+        free(depths);
+        writer->failed = true;
+        return;
+    }
+
+    for (size_t s = 0; s < tree->scope_count; s++) {
+        const Scope *scope = &tree->scopes[s];
+        depths[s] = scope->parent == SCOPE_NONE ? 0 : depths[scope->parent] + 1;
+        for (uint32_t i = 0; i < depths[s]; i++) {
+            writer_cstr(writer, "  ");
+        }
+        writer_cstr(writer, scope_kind_names[scope->kind]);
+        writer_byte(writer, ' ');
+        writer_uint(writer, line_index_line(&lines, ast->nodes[scope->node].start) + 1);
+        writer_byte(writer, ':');
+        for (uint32_t i = 0; i < scope->count; i++) {
+            const ScopeName *name = &tree->names[tree->bindings[scope->first + i].name];
+            writer_byte(writer, ' ');
+            writer_write(writer, tree->source + name->offset, name->length);
+        }
+        writer_byte(writer, '\n');
+    }
+
+    size_t global = 0;
+    for (size_t i = 0; i < tree->reference_count; i++) {
+        if (tree->references[i].depth == SCOPE_NONE) global++;
+    }
+    writer_cstr(writer, "references: ");
+    writer_uint(writer, tree->reference_count - global);
+    writer_cstr(writer, " local, ");
+    writer_uint(writer, global);
+    writer_cstr(writer, " global\n");
+
+    line_index_free(&lines);
+    free(depths);
+}
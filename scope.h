@@ -0,0 +1,105 @@
+#ifndef SCOPE_H
+#define SCOPE_H
+
+#include "ast.h"
+#include "parser.h"
+#include "writer.h"
+#include "common.h"
+
+#define SCOPE_NONE UINT32_MAX      /* 没有外层作用域、引用未解析到任何绑定 */
+
+/* 作用域类型 */
+typedef enum {
+    SCOPE_SCRIPT,           /* 脚本顶层 */
+    SCOPE_MODULE,           /* 模块顶层 */
+    SCOPE_FUNCTION,         /* 函数：参数和函数体顶层的声明 */
+    SCOPE_BLOCK,            /* 语句块、switch体、for (let ...) 的头部 */
+    SCOPE_CATCH,            /* catch参数和catch块顶层的声明 */
+    SCOPE_CLASS             /* 类体（严格模式） */
+} ScopeKind;
+
+/* 绑定类型 */
+typedef enum {
+    SCOPE_BINDING_VAR,
+    SCOPE_BINDING_FUNCTION, /* 函数声明：函数顶层按var处理，块中和模块顶层按let处理 */
+    SCOPE_BINDING_PARAM,
+    SCOPE_BINDING_LET,
+    SCOPE_BINDING_CONST,
+    SCOPE_BINDING_CLASS,
+    SCOPE_BINDING_IMPORT,
+    SCOPE_BINDING_CATCH,
+    SCOPE_BINDING_SELF      /* 函数表达式自身的名字，可被同名的参数和声明遮蔽 */
+} ScopeBindingKind;
+
+/* 去重后的名字（指向源码，不拷贝） */
+typedef struct {
+    uint32_t offset;
+    uint32_t length;
+} ScopeName;
+
+/* 一个作用域：绑定在bindings中连续存放，slots中的开放寻址表按名字编号查找 */
+typedef struct {
+    uint32_t parent;        /* 外层作用域，SCOPE_NONE为最外层 */
+    uint32_t node;          /* 创建作用域的AST节点 */
+    uint32_t first;         /* 第一个绑定在bindings中的下标 */
+    uint32_t count;         /* 绑定个数（slot为0..count-1） */
+    uint32_t table;         /* 查找表在slots中的起始下标 */
+    uint32_t mask;          /* 查找表长度-1（长度为2的幂） */
+    uint8_t kind;           /* ScopeKind */
+    bool strict;            /* 严格模式 */
+    bool unique_params;     /* 参数不允许重名（严格模式、箭头函数、方法、非简单参数列表） */
+} Scope;
+
+/* 一个绑定 */
+typedef struct {
+    uint32_t name;          /* 名字编号 */
+    uint32_t node;          /* 声明处的标识符节点 */
+    uint8_t kind;           /* ScopeBindingKind */
+} ScopeBinding;
+
+/* 一个标识符引用：从所在作用域向外depth层的作用域中的第slot个绑定；
+   未声明（全局变量）时depth和slot都是SCOPE_NONE */
+typedef struct {
+    uint32_t node;
+    uint32_t name;
+    uint32_t scope;
+    uint32_t depth;
+    uint32_t slot;
+} ScopeReference;
+
+/* 作用域分析结果 */
+typedef struct {
+    const char *source;
+    Scope *scopes;          /* 0为顶层作用域，外层总在内层之前 */
+    size_t scope_count;
+    ScopeBinding *bindings;
+    size_t binding_count;
+    ScopeReference *references; /* 按出现顺序 */
+    size_t reference_count;
+    ScopeName *names;
+    size_t name_count;
+    uint32_t *name_table;   /* 名字去重表（开放寻址，名字编号+1，0为空位） */
+    size_t name_capacity;
+    uint32_t *slots;        /* 所有作用域的查找表，空位为SCOPE_NONE，否则为binding下标 */
+    size_t slot_count;
+} ScopeTree;
+
+/* 作用域分析：建立作用域树，检查重复声明和重复参数，解析每个标识符引用。
+   出错时error记录源码中最靠前的一处错误 */
+bool scope_analyze(ScopeTree *tree, const Ast *ast, const char *source, ErrorInfo *error);
+void scope_tree_free(ScopeTree *tree);
+
+/* 在作用域（不含外层）中按名字查找绑定，找不到返回SCOPE_NONE */
+uint32_t scope_lookup(const ScopeTree *tree, uint32_t scope, const char *name, size_t length);
+
+/* 在语法验证建好的AST上做作用域检查（重复声明等），不保留作用域树 */
+bool scope_check(const Ast *ast, const char *source, ErrorInfo *error);
+
+/* 语法分析后接着做作用域检查，压缩、格式化、折叠、ESTree和lint共用这一解析入口。
+   parser->ast须非NULL；AST构建失败（ast->failed）时不检查，由调用者按内存不足处理 */
+bool scope_parse(Parser *parser);
+
+/* 输出作用域树：每个作用域一行（缩进表示嵌套，类型、起始行号、绑定），最后一行统计引用 */
+void scope_tree_write(const ScopeTree *tree, const Ast *ast, size_t length, Writer *writer);
+
+#endif /* SCOPE_H */
@@ -0,0 +1,135 @@
+#include "sourcemap.h"
+
+static const char base64_digits[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* 一个片段最多4个字段，每个字段最多13个base64字符，加上分隔符 */
+#define SEGMENT_MAX 56
+
+/* 初始化：建立原始源码的行索引 */
+bool source_map_init(SourceMap *map, const char *source, size_t length) {
+    memset(map, 0, sizeof(*map));
+    if (!line_index_build(&map->index, source, length)) {
+        return false;
+    }
+    line_cursor_init(&map->cursor, &map->index);
+
+    /* 压缩输出时mappings通常与源码大小相当 */
+    map->capacity = 4096 + length + length / 2;
+    map->mappings = (char*)malloc(map->capacity);
+    if (!map->mappings) {
+        line_index_free(&map->index);
+        return false;
+    }
+    return true;
+}
+
+/* 释放source map */
+void source_map_free(SourceMap *map) {
+    line_index_free(&map->index);
+    free(map->mappings);
+    map->mappings = NULL;
+    map->length = 0;
+    map->capacity = 0;
+}
+
+/* 保证mappings缓冲还能写入extra个字节 */
+static bool reserve(SourceMap *map, size_t extra) {
+    if (map->length + extra <= map->capacity) return true;
+
+    size_t capacity = map->capacity * 2;
+    while (capacity < map->length + extra) capacity *= 2;
+    char *mappings = (char*)realloc(map->mappings, capacity);
+    if (!mappings) {
+        map->failed = true;
+        return false;
+    }
+    map->mappings = mappings;
+    map->capacity = capacity;
+    return true;
+}
+
+/* 写入一个base64 VLQ：最低位为符号位，每5位一组，低位在前，第6位表示后面还有 */
+static char* write_vlq(char *out, long long value) {
+    unsigned long long vlq = value < 0 ? ((unsigned long long)-value << 1) | 1
+                                       : (unsigned long long)value << 1;
+    do {
+        unsigned digit = vlq & 31;
+        vlq >>= 5;
+        if (vlq) digit |= 32;
+        *out++ = base64_digits[digit];
+    } while (vlq);
+    return out;
+}
+
+/* 在当前输出位置记录一个映射到原始偏移的片段 */
+void source_map_add(SourceMap *map, size_t original_offset) {
+    if (map->failed) return;
+
+    /* 换到新的输出行：每行一个; */
+    if (map->generated_line > map->segment_line) {
+        size_t lines = map->generated_line - map->segment_line;
+        if (!reserve(map, lines)) return;
+        memset(map->mappings + map->length, ';', lines);
+        map->length += lines;
+        map->segment_line = map->generated_line;
+        map->segment_count = 0;
+        map->prev_generated_column = 0;
+    }
+    if (!reserve(map, SEGMENT_MAX)) return;
+
+    LinePosition original = line_cursor_find(&map->cursor, original_offset);
+    char *out = map->mappings + map->length;
+    if (map->segment_count > 0) {
+        *out++ = ',';
+    }
+    out = write_vlq(out, (long long)map->generated_column - map->prev_generated_column);
+    *out++ = 'A';       /* 源文件下标，只有一个源文件，增量总是0 */
+    out = write_vlq(out, (long long)original.line - map->prev_original_line);
+    out = write_vlq(out, (long long)original.column - map->prev_original_column);
+    map->length = (size_t)(out - map->mappings);
+
+    map->segment_count++;
+    map->prev_generated_column = (long long)map->generated_column;
+    map->prev_original_line = (long long)original.line;
+    map->prev_original_column = (long long)original.column;
+}
+
+/* 跟踪输出位置：text为刚写出的文本 */
+void source_map_advance(SourceMap *map, const char *text, size_t length) {
+    size_t column = map->generated_column;
+
+    for (size_t i = 0; i < length; i++) {
+        unsigned char ch = (unsigned char)text[i];
+        if (ch == '\n' || ch == '\r') {
+            if (ch == '\r' && i + 1 < length && text[i + 1] == '\n') {
+                i++;
+            }
+            map->generated_line++;
+            column = 0;
+        } else {
+            column += (ch & 0xC0) != 0x80;
+            column += ch >= 0xF0;
+        }
+    }
+
+    map->generated_column = column;
+}
+
+/* 输出source map的JSON */
+bool source_map_write(const SourceMap *map, const char *file, const char *source_name,
+                      Writer *writer) {
+    if (map->failed) return false;
+
+    writer_cstr(writer, "{\"version\":3");
+    if (file) {
+        writer_cstr(writer, ",\"file\":");
+        writer_json_string(writer, file, strlen(file));
+    }
+    writer_cstr(writer, ",\"sources\":[");
+    writer_json_string(writer, source_name, strlen(source_name));
+    writer_cstr(writer, "],\"names\":[],\"mappings\":\"");
+    writer_write(writer, map->mappings, map->length);
+    writer_cstr(writer, "\"}\n");
+    return !writer->failed;
+}
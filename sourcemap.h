@@ -0,0 +1,35 @@
+#ifndef SOURCEMAP_H
+#define SOURCEMAP_H
+
+#include "line_index.h"
+#include "writer.h"
+#include "common.h"
+
+/* Source map v3生成器：转换过程中按输出顺序记录映射，mappings字段边记录边编码为base64 VLQ。
+   原始位置由源码偏移经行索引换算；输出位置由source_map_advance跟踪写出的文本得到 */
+typedef struct {
+    LineIndex index;        /* 原始源码的行索引 */
+    LineCursor cursor;
+    char *mappings;         /* 已编码的mappings字段 */
+    size_t length;
+    size_t capacity;
+    bool failed;            /* 内存不足 */
+    size_t generated_line;  /* 当前输出位置（从0开始，列按UTF-16码元） */
+    size_t generated_column;
+    size_t segment_line;    /* 最近一个片段的输出行，用于决定写;还是, */
+    size_t segment_count;
+    /* VLQ增量编码的基准：上一个片段的各字段 */
+    long long prev_generated_column;
+    long long prev_original_line;
+    long long prev_original_column;
+} SourceMap;
+
+/* Source map函数声明 */
+bool source_map_init(SourceMap *map, const char *source, size_t length);
+void source_map_free(SourceMap *map);
+void source_map_add(SourceMap *map, size_t original_offset);
+void source_map_advance(SourceMap *map, const char *text, size_t length);
+bool source_map_write(const SourceMap *map, const char *file, const char *source_name,
+                      Writer *writer);
+
+#endif /* SOURCEMAP_H */
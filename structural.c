@@ -0,0 +1,649 @@
+#include "structural.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define STRUCTURAL_USE_SSE2 1
+#endif
+
+/*
+ * 结构索引（stage 1）
+ *
+ * 仿照simdjson的两阶段做法：
+ *   1. 以64字节为一块，用SIMD比较得到各类字符的位掩码（引号、反引号、斜杠、星号、
+ *      换行、括号、反斜杠），再用位运算求出被奇数个反斜杠转义的字符；
+ *   2. 标量状态机只遍历置位的结构字符，按词法分析器的规则跟踪字符串、模板、
+ *      注释、正则的边界，记录代码区中的括号并检查配对。模板替换的 ${ 与括号一起
+ *      入栈（不记入索引），与之配对的 } 回到模板。
+ * 正则/除法的判定依赖上一个token；这里从斜杠向前回看源码来判定，无法确定时
+ * （例如前面是多字符运算符序列中无法还原的情况）索引标记为不精确并停止，
+ * 此时不做提前拒绝，交给完整的解析器处理。
+ */
+
+/* 扫描模式 */
+typedef enum {
+    SCAN_CODE,
+    SCAN_DOUBLE_QUOTE,
+    SCAN_SINGLE_QUOTE,
+    SCAN_TEMPLATE,
+    SCAN_LINE_COMMENT,
+    SCAN_BLOCK_COMMENT,
+    SCAN_REGEX,
+    SCAN_REGEX_CLASS
+} ScanMode;
+
+/* 斜杠的判定结果 */
+typedef enum {
+    SLASH_DIVIDE,
+    SLASH_REGEX,
+    SLASH_UNKNOWN
+} SlashKind;
+
+/* 一个64字节块的字符位掩码（第i位对应块内第i个字节） */
+typedef struct {
+    uint64_t backslash;
+    uint64_t quote;         /* " */
+    uint64_t apostrophe;    /* ' */
+    uint64_t backtick;      /* ` */
+    uint64_t slash;
+    uint64_t star;
+    uint64_t newline;       /* \n 或 \r */
+    uint64_t open;          /* ( [ { */
+    uint64_t close;         /* ) ] } */
+    uint64_t lbracket;      /* [ */
+    uint64_t rbracket;      /* ] */
+} BlockMasks;
+
+/* 括号栈元素 */
+typedef struct {
+    uint32_t offset;
+    uint32_t entry;         /* 在索引中的下标（不记录索引时未使用） */
+    bool substitution;      /* 模板替换的 ${ */
+} BracketFrame;
+
+/* 扫描状态 */
+typedef struct {
+    const char *src;
+    size_t length;
+    ScanMode mode;
+    StructuralIndex *index;
+    bool record;            /* 是否记录括号位置 */
+    bool done;
+    BracketFrame *stack;
+    size_t depth;
+    size_t stack_capacity;
+    size_t comment_start;   /* 最近一段注释（仅以空白相隔的注释合并为一段）的范围 */
+    size_t comment_end;
+} StructuralScan;
+
+#ifdef STRUCTURAL_USE_SSE2
+static uint64_t block_eq(const __m128i lanes[4], char ch) {
+    __m128i needle = _mm_set1_epi8(ch);
+    uint64_t m0 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(lanes[0], needle));
+    uint64_t m1 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(lanes[1], needle));
+    uint64_t m2 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(lanes[2], needle));
+    uint64_t m3 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(lanes[3], needle));
+    return m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+}
+
+/* 计算一块的字符位掩码（SSE2） */
+static void classify_block(const unsigned char *block, BlockMasks *m) {
+    __m128i lanes[4];
+    for (int i = 0; i < 4; i++) {
+        lanes[i] = _mm_loadu_si128((const __m128i*)(block + 16 * i));
+    }
+
+    m->backslash = block_eq(lanes, '\\');
+    m->quote = block_eq(lanes, '"');
+    m->apostrophe = block_eq(lanes, '\'');
+    m->backtick = block_eq(lanes, '`');
+    m->slash = block_eq(lanes, '/');
+    m->star = block_eq(lanes, '*');
+    m->newline = block_eq(lanes, '\n') | block_eq(lanes, '\r');
+    m->lbracket = block_eq(lanes, '[');
+    m->rbracket = block_eq(lanes, ']');
+    m->open = block_eq(lanes, '(') | block_eq(lanes, '{') | m->lbracket;
+    m->close = block_eq(lanes, ')') | block_eq(lanes, '}') | m->rbracket;
+}
+#else
+/* 计算一块的字符位掩码（可移植实现） */
+static void classify_block(const unsigned char *block, BlockMasks *m) {
+    memset(m, 0, sizeof(*m));
+    for (int i = 0; i < 64; i++) {
+        uint64_t bit = 1ULL << i;
+        switch (block[i]) {
+            case '\\': m->backslash |= bit; break;
+            case '"':  m->quote |= bit; break;
+            case '\'': m->apostrophe |= bit; break;
+            case '`':  m->backtick |= bit; break;
+            case '/':  m->slash |= bit; break;
+            case '*':  m->star |= bit; break;
+            case '\n':
+            case '\r': m->newline |= bit; break;
+            case '[':  m->lbracket |= bit; m->open |= bit; break;
+            case ']':  m->rbracket |= bit; m->close |= bit; break;
+            case '(':
+            case '{':  m->open |= bit; break;
+            case ')':
+            case '}':  m->close |= bit; break;
+            default: break;
+        }
+    }
+}
+#endif
+
+/* 求被转义的字符：紧跟在奇数长度反斜杠序列之后的位置。
+   carry记录上一块末尾的反斜杠是否转义了本块第一个字符（simdjson的无分支算法） */
+static uint64_t find_escaped(uint64_t backslash, uint64_t *carry) {
+    const uint64_t even_bits = 0x5555555555555555ULL;
+
+    backslash &= ~*carry;
+    uint64_t follows_escape = (backslash << 1) | *carry;
+    uint64_t odd_sequence_starts = backslash & ~even_bits & ~follows_escape;
+    uint64_t sequences_starting_on_even_bits;
+    *carry = __builtin_add_overflow(odd_sequence_starts, backslash,
+                                    &sequences_starting_on_even_bits) ? 1 : 0;
+    uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+    return (even_bits ^ invert_mask) & follows_escape;
+}
+
+/* 当前模式下需要关注的结构字符 */
+static uint64_t mode_mask(const BlockMasks *m, ScanMode mode) {
+    switch (mode) {
+        case SCAN_CODE:
+            return m->quote | m->apostrophe | m->backtick | m->slash | m->open | m->close;
+        case SCAN_DOUBLE_QUOTE:  return m->quote | m->newline;
+        case SCAN_SINGLE_QUOTE:  return m->apostrophe | m->newline;
+        case SCAN_TEMPLATE:      return m->backtick | m->open;
+        case SCAN_LINE_COMMENT:  return m->newline;
+        case SCAN_BLOCK_COMMENT: return m->star;
+        case SCAN_REGEX:         return m->slash | m->lbracket | m->newline;
+        case SCAN_REGEX_CLASS:   return m->rbracket;
+    }
+    return 0;
+}
+
+static bool is_space_byte(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\v' || ch == '\f' || ch == '\n' || ch == '\r';
+}
+
+static bool is_word_byte(char ch) {
+    unsigned char c = (unsigned char)ch;
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '$' || c == '_' || c >= 0x80;
+}
+
+static bool is_operator_byte(char ch) {
+    return ch != '\0' && strchr("=!<>+-*%&|^?~", ch) != NULL;
+}
+
+/* 位置pos处的字符是否被转义（仅在少见的路径上使用） */
+static bool escaped_at(const char *src, size_t pos) {
+    size_t count = 0;
+    while (pos > count && src[pos - count - 1] == '\\') count++;
+    return count % 2 == 1;
+}
+
+/* 从end（不含）向前跳过空白，返回上一个非空白字节的下标，没有则返回SIZE_MAX */
+static size_t skip_space_back(const char *src, size_t end, bool *crossed_newline) {
+    while (end > 0) {
+        char ch = src[end - 1];
+        if (!is_space_byte(ch)) return end - 1;
+        if (ch == '\n' || ch == '\r') *crossed_newline = true;
+        end--;
+    }
+    return SIZE_MAX;
+}
+
+/* 从end（不含）向前找上一个有意义的字节（跳过空白和最近一段注释）。
+   若可能落在更早的注释中则返回false */
+static bool previous_significant(const StructuralScan *scan, size_t end, size_t *result) {
+    bool crossed_newline = false;
+    size_t p = skip_space_back(scan->src, end, &crossed_newline);
+
+    if (p != SIZE_MAX && p >= scan->comment_start && p < scan->comment_end) {
+        /* 注释段合并保证跳过后落在代码上 */
+        p = skip_space_back(scan->src, scan->comment_start, &crossed_newline);
+    } else if (p != SIZE_MAX && scan->comment_end > p) {
+        /* 最近的注释在p之后，p附近可能还有更早的注释 */
+        if (crossed_newline) return false;
+        if (scan->src[p] == '/' && p > 0 && scan->src[p - 1] == '*') return false;
+    }
+
+    *result = p;
+    return true;
+}
+
+/* 多字符运算符的长度（与词法分析器一致），不是多字符运算符返回0 */
+static size_t operator_length(const char *s, size_t n) {
+    char c0 = s[0];
+    char c1 = n > 1 ? s[1] : '\0';
+    char c2 = n > 2 ? s[2] : '\0';
+
+    if (c0 == '>' && c1 == '>' && c2 == '>') {
+        return (n > 3 && s[3] == '=') ? 4 : 3;
+    }
+    if ((c0 == '=' && c1 == '=' && c2 == '=') ||
+        (c0 == '!' && c1 == '=' && c2 == '=') ||
+        (c0 == '*' && c1 == '*' && c2 == '=') ||
+        (c0 == '&' && c1 == '&' && c2 == '=') ||
+        (c0 == '|' && c1 == '|' && c2 == '=') ||
+        (c0 == '?' && c1 == '?' && c2 == '=')) {
+        return 3;
+    }
+    if ((c0 == '<' && c1 == '<') || (c0 == '>' && c1 == '>')) {
+        return c2 == '=' ? 3 : 2;
+    }
+    if (c1 == '=' && strchr("=!<>+-*%&|^", c0)) return 2;
+    if ((c0 == '&' && c1 == '&') || (c0 == '|' && c1 == '|') ||
+        (c0 == '?' && c1 == '?') || (c0 == '+' && c1 == '+') ||
+        (c0 == '-' && c1 == '-') || (c0 == '*' && c1 == '*') ||
+        (c0 == '=' && c1 == '>')) {
+        return 2;
+    }
+    return 0;
+}
+
+/* 判定代码区中pos处的 / 是正则开头还是除号：
+   与词法分析器一样只看上一个单字符标点、标识符/关键字、字面量；
+   多字符运算符不更新上一个token，因此需要越过它们继续向前看 */
+static SlashKind classify_slash(const StructuralScan *scan, size_t pos) {
+    const char *src = scan->src;
+    size_t end = pos;
+
+    /* /= 总是除法赋值 */
+    if (pos + 1 < scan->length && src[pos + 1] == '=') return SLASH_DIVIDE;
+
+    for (int hops = 0; hops < 4; hops++) {
+        size_t p;
+        if (!previous_significant(scan, end, &p)) return SLASH_UNKNOWN;
+        if (p == SIZE_MAX) return SLASH_DIVIDE;
+
+        char ch = src[p];
+        if (is_word_byte(ch)) {
+            size_t start = p;
+            while (start > 0 && is_word_byte(src[start - 1])) start--;
+            if (start > 0 && src[start - 1] == '\\') return SLASH_UNKNOWN;
+            if (src[start] >= '0' && src[start] <= '9') {
+                /* 数字后紧跟标识符时按词法规则切分，这里不还原 */
+                for (size_t i = start; i <= p; i++) {
+                    if (isalpha((unsigned char)src[i])) return SLASH_UNKNOWN;
+                }
+                return SLASH_DIVIDE;
+            }
+            size_t len = p + 1 - start;
+            if ((len == 6 && memcmp(src + start, "return", 6) == 0) ||
+                (len == 5 && memcmp(src + start, "throw", 5) == 0)) {
+                return SLASH_REGEX;
+            }
+            return SLASH_DIVIDE;
+        }
+
+        switch (ch) {
+            case '(': case '[': case '{': case ',': case ';': case ':':
+                return SLASH_REGEX;
+            case ')': case ']': case '}': case '"': case '\'': case '`': case '/':
+                return SLASH_DIVIDE;
+            case '.':
+                return (p > 0 && src[p - 1] == '.') ? SLASH_UNKNOWN : SLASH_DIVIDE;
+            default:
+                break;
+        }
+        if (!is_operator_byte(ch)) return SLASH_UNKNOWN;
+
+        /* 运算符序列：从序列起点按词法规则重新切分，找最后一个单字符运算符 */
+        size_t run = p;
+        while (run > 0 && is_operator_byte(src[run - 1])) run--;
+        if (run > 0 && (src[run - 1] == '/' || src[run - 1] == '.')) return SLASH_UNKNOWN;
+
+        char last_single = '\0';
+        size_t i = run;
+        while (i <= p) {
+            size_t len = operator_length(src + i, p + 1 - i);
+            if (len == 0) {
+                last_single = src[i];
+                len = 1;
+            }
+            i += len;
+        }
+        if (i != p + 1) return SLASH_UNKNOWN;
+
+        if (last_single != '\0') {
+            return strchr("=!?<>~", last_single) ? SLASH_REGEX : SLASH_DIVIDE;
+        }
+        end = run;
+    }
+    return SLASH_UNKNOWN;
+}
+
+/* 记录一个括号 */
+static bool record_bracket(StructuralScan *scan, size_t pos, uint32_t *entry) {
+    StructuralIndex *index = scan->index;
+    if (!scan->record) return true;
+
+    if (index->count == index->capacity) {
+        size_t capacity = index->capacity ? index->capacity * 2 : 1024;
+        StructuralEntry *entries = (StructuralEntry*)realloc(index->entries,
+                                                             capacity * sizeof(StructuralEntry));
+        if (!entries) return false;
+        index->entries = entries;
+        index->capacity = capacity;
+    }
+
+    *entry = (uint32_t)index->count;
+    index->entries[index->count].offset = (uint32_t)pos;
+    index->entries[index->count].partner = STRUCTURAL_NO_PARTNER;
+    index->count++;
+    return true;
+}
+
+static char closing_for(char open) {
+    return open == '(' ? ')' : open == '[' ? ']' : '}';
+}
+
+/* 处理代码区中的括号（substitution表示模板中的 ${ ）；遇到不配对的闭括号时停止扫描 */
+static bool scan_bracket(StructuralScan *scan, size_t pos, bool substitution) {
+    char ch = scan->src[pos];
+    uint32_t entry = 0;
+
+    if (ch == '(' || ch == '[' || ch == '{') {
+        if (scan->depth == scan->stack_capacity) {
+            size_t capacity = scan->stack_capacity ? scan->stack_capacity * 2 : 256;
+            BracketFrame *stack = (BracketFrame*)realloc(scan->stack,
+                                                         capacity * sizeof(BracketFrame));
+            if (!stack) return false;
+            scan->stack = stack;
+            scan->stack_capacity = capacity;
+        }
+        if (!substitution && !record_bracket(scan, pos, &entry)) return false;
+        scan->stack[scan->depth].offset = (uint32_t)pos;
+        scan->stack[scan->depth].entry = entry;
+        scan->stack[scan->depth].substitution = substitution;
+        scan->depth++;
+        return true;
+    }
+
+    if (scan->depth == 0 ||
+        closing_for(scan->src[scan->stack[scan->depth - 1].offset]) != ch) {
+        scan->index->balanced = false;
+        scan->index->error_offset = pos;
+        scan->done = true;
+        return true;
+    }
+
+    if (scan->stack[scan->depth - 1].substitution) {
+        scan->depth--;
+        scan->mode = SCAN_TEMPLATE;
+        return true;
+    }
+
+    if (!record_bracket(scan, pos, &entry)) return false;
+    scan->depth--;
+    if (scan->record) {
+        uint32_t open = scan->stack[scan->depth].entry;
+        scan->index->entries[open].partner = entry;
+        scan->index->entries[entry].partner = open;
+    }
+    return true;
+}
+
+/* 进入注释：若与上一段注释之间只有空白则合并为一段 */
+static void begin_comment(StructuralScan *scan, size_t pos) {
+    bool crossed_newline = false;
+    size_t p = skip_space_back(scan->src, pos, &crossed_newline);
+    if (!(p != SIZE_MAX && p >= scan->comment_start && p < scan->comment_end)) {
+        scan->comment_start = pos;
+    }
+    scan->comment_end = scan->length;
+}
+
+/* 放弃提前判定（索引与词法分析器可能不一致） */
+static void scan_give_up(StructuralScan *scan) {
+    scan->index->exact = false;
+    scan->done = true;
+}
+
+/* 处理一个结构字符，返回下一个需要处理的偏移 */
+static size_t scan_structural(StructuralScan *scan, size_t pos, bool escaped, bool *ok) {
+    const char *src = scan->src;
+    char ch = src[pos];
+    char next = pos + 1 < scan->length ? src[pos + 1] : '\0';
+
+    switch (scan->mode) {
+        case SCAN_CODE:
+            if (escaped) {
+                /* 代码区中的反斜杠是词法错误，交给词法分析器报告 */
+                scan_give_up(scan);
+            } else if (ch == '"') {
+                scan->mode = SCAN_DOUBLE_QUOTE;
+            } else if (ch == '\'') {
+                scan->mode = SCAN_SINGLE_QUOTE;
+            } else if (ch == '`') {
+                scan->mode = SCAN_TEMPLATE;
+            } else if (ch == '/') {
+                if (next == '/' || next == '*') {
+                    begin_comment(scan, pos);
+                    scan->mode = next == '/' ? SCAN_LINE_COMMENT : SCAN_BLOCK_COMMENT;
+                    return pos + 2;
+                }
+                SlashKind kind = classify_slash(scan, pos);
+                if (kind == SLASH_UNKNOWN) {
+                    scan_give_up(scan);
+                } else if (kind == SLASH_REGEX) {
+                    scan->mode = SCAN_REGEX;
+                }
+            } else {
+                *ok = scan_bracket(scan, pos, false);
+            }
+            break;
+
+        case SCAN_DOUBLE_QUOTE:
+        case SCAN_SINGLE_QUOTE:
+            if (escaped) break;
+            if (ch == '\n' && pos > 0 && src[pos - 1] == '\r' && escaped_at(src, pos - 1)) {
+                break;      /* 转义的\r\n整体被跳过 */
+            }
+            if (ch == '\n' || ch == '\r') {
+                scan_give_up(scan);     /* 未闭合的字符串 */
+            } else {
+                scan->mode = SCAN_CODE;
+            }
+            break;
+
+        case SCAN_TEMPLATE:
+            if (escaped) break;
+            if (ch == '`') {
+                scan->mode = SCAN_CODE;
+            } else if (ch == '{' && pos > 0 && src[pos - 1] == '$' && !escaped_at(src, pos - 1)) {
+                scan->mode = SCAN_CODE;
+                *ok = scan_bracket(scan, pos, true);
+            }
+            break;
+
+        case SCAN_LINE_COMMENT:
+            scan->comment_end = pos;
+            scan->mode = SCAN_CODE;
+            break;
+
+        case SCAN_BLOCK_COMMENT:
+            if (next == '/') {
+                scan->comment_end = pos + 2;
+                scan->mode = SCAN_CODE;
+                return pos + 2;
+            }
+            break;
+
+        case SCAN_REGEX:
+            if (escaped) break;
+            if (ch == '/') {
+                scan->mode = SCAN_CODE;
+            } else if (ch == '[') {
+                scan->mode = SCAN_REGEX_CLASS;
+            } else if (ch == '\n' && pos > 0 && src[pos - 1] == '\r' &&
+                       escaped_at(src, pos - 1)) {
+                break;
+            } else {
+                scan_give_up(scan);     /* 未闭合的正则 */
+            }
+            break;
+
+        case SCAN_REGEX_CLASS:
+            if (!escaped) scan->mode = SCAN_REGEX;
+            break;
+    }
+    return pos + 1;
+}
+
+/* 扫描整个源码 */
+static bool structural_scan(StructuralScan *scan) {
+    const unsigned char *src = (const unsigned char*)scan->src;
+    size_t length = scan->length;
+    uint64_t carry = 0;
+    size_t resume = 0;
+    bool ok = true;
+
+    for (size_t base = 0; base < length && !scan->done && ok; base += 64) {
+        unsigned char padded[64];
+        const unsigned char *block = src + base;
+        uint64_t valid = ~0ULL;
+
+        if (length - base < 64) {
+            memset(padded, 0, sizeof(padded));
+            memcpy(padded, block, length - base);
+            block = padded;
+            valid = (1ULL << (length - base)) - 1;
+        }
+
+        BlockMasks masks;
+        classify_block(block, &masks);
+        uint64_t escaped = find_escaped(masks.backslash, &carry);
+        uint64_t remaining = valid;
+
+        while (!scan->done && ok) {
+            if (resume > base) {
+                remaining &= resume - base >= 64 ? 0 : ~((1ULL << (resume - base)) - 1);
+            }
+            uint64_t candidates = remaining & mode_mask(&masks, scan->mode);
+            if (!candidates) break;
+
+            int bit = __builtin_ctzll(candidates);
+            remaining &= ~((2ULL << bit) - 1);
+            resume = scan_structural(scan, base + (size_t)bit,
+                                     (escaped >> bit) & 1, &ok);
+        }
+    }
+
+    if (!ok) return false;
+    if (scan->done) return true;
+
+    if (scan->mode == SCAN_BLOCK_COMMENT || scan->mode == SCAN_TEMPLATE) {
+        scan_give_up(scan);     /* 未闭合的块注释或模板 */
+    } else if (scan->depth > 0) {
+        scan->index->balanced = false;
+        scan->index->error_offset = scan->stack[scan->depth - 1].offset;
+    }
+    return true;
+}
+
+static bool structural_run(StructuralIndex *index, const char *source, size_t length,
+                           bool record) {
+    StructuralScan scan = {0};
+
+    memset(index, 0, sizeof(*index));
+    index->exact = true;
+    index->balanced = true;
+
+    /* 偏移使用32位存储 */
+    if (length >= UINT32_MAX) {
+        index->exact = false;
+        return true;
+    }
+
+    scan.src = source;
+    scan.length = length;
+    scan.mode = SCAN_CODE;
+    scan.index = index;
+    scan.record = record;
+
+    bool ok = structural_scan(&scan);
+    free(scan.stack);
+    return ok;
+}
+
+/* 构建结构索引；仅在内存不足时返回false */
+bool structural_index_build(StructuralIndex *index, const char *source, size_t length) {
+    if (!structural_run(index, source, length, true)) {
+        structural_index_free(index);
+        return false;
+    }
+    return true;
+}
+
+/* 释放结构索引 */
+void structural_index_free(StructuralIndex *index) {
+    if (!index) return;
+    free(index->entries);
+    index->entries = NULL;
+    index->count = 0;
+    index->capacity = 0;
+}
+
+/* 查找offset处括号的配对括号偏移；索引不精确、不是括号或未配对时返回-1 */
+long structural_match(const StructuralIndex *index, size_t offset) {
+    if (!index->exact || index->count == 0) return -1;
+
+    size_t lo = 0;
+    size_t hi = index->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index->entries[mid].offset < offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo == index->count || index->entries[lo].offset != offset) return -1;
+    uint32_t partner = index->entries[lo].partner;
+    if (partner == STRUCTURAL_NO_PARTNER) return -1;
+    return (long)index->entries[partner].offset;
+}
+
+/* 计算偏移对应的行列（与词法分析器一致，\r\n算一次换行） */
+static Position offset_position(const char *source, size_t offset) {
+    Position pos = {1, 1, (int)offset};
+    for (size_t i = 0; i < offset; i++) {
+        char ch = source[i];
+        if (ch == '\n' || (ch == '\r' && source[i + 1] != '\n')) {
+            pos.line++;
+            pos.column = 1;
+        } else if (ch != '\r') {
+            pos.column++;
+        }
+    }
+    return pos;
+}
+
+/* 快速括号检查：只有在确定括号不配对时才返回false并设置错误，
+   其余情况（包括无法精确判定）返回true，由解析器给出最终结论 */
+bool structural_check(const char *source, size_t length, ErrorInfo *error) {
+    StructuralIndex index;
+    if (!structural_run(&index, source, length, false)) {
+        return true;
+    }
+    if (!index.exact || index.balanced) {
+        return true;
+    }
+
+    char ch = source[index.error_offset];
+    char msg[64];
+    Position pos = offset_position(source, index.error_offset);
+
+    if (ch == '(' || ch == '[' || ch == '{') {
+        snprintf(msg, sizeof(msg), "Unclosed '%c'", ch);
+        set_error(error, ERROR_PARSER_UNEXPECTED_EOF, pos, msg);
+    } else {
+        snprintf(msg, sizeof(msg), "Unmatched '%c'", ch);
+        set_error(error, ERROR_PARSER_UNEXPECTED_TOKEN, pos, msg);
+    }
+    return false;
+}
@@ -0,0 +1,32 @@
+#ifndef STRUCTURAL_H
+#define STRUCTURAL_H
+
+#include "common.h"
+
+#define STRUCTURAL_NO_PARTNER UINT32_MAX
+
+/* 结构索引中的一个括号 */
+typedef struct {
+    uint32_t offset;        /* 括号在源码中的偏移 */
+    uint32_t partner;       /* 匹配括号在entries中的下标，未匹配为STRUCTURAL_NO_PARTNER */
+} StructuralEntry;
+
+/* 结构索引：代码区（字符串、模板、注释、正则之外）中所有括号的位置及配对关系 */
+typedef struct {
+    StructuralEntry *entries;
+    size_t count;
+    size_t capacity;
+    bool exact;             /* 所有正则/除法判定都确定，结果与词法分析器一致 */
+    bool balanced;          /* 括号完全配对 */
+    size_t error_offset;    /* 第一个不配对括号的偏移 */
+} StructuralIndex;
+
+/* 结构索引函数声明 */
+bool structural_index_build(StructuralIndex *index, const char *source, size_t length);
+void structural_index_free(StructuralIndex *index);
+long structural_match(const StructuralIndex *index, size_t offset);
+
+/* 在解析之前快速拒绝括号确定不配对的文件 */
+bool structural_check(const char *source, size_t length, ErrorInfo *error);
+
+#endif /* STRUCTURAL_H */
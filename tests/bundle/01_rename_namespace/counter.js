@@ -0,0 +1,4 @@
+export let count = 0
+const count2 = 10
+export function increment() { count += count2 }
+export function unused() {}
@@ -0,0 +1,6 @@
+import { count, increment } from "./counter.js"
+import * as strings from "./strings.js"
+import data from "./data.json"
+const count2 = count
+increment()
+console.log(count, count2, strings.upper("x"), data.name)
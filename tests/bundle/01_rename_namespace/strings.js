@@ -0,0 +1,2 @@
+export const upper = s => s.toUpperCase()
+export default function lower(s) { return s.toLowerCase() }
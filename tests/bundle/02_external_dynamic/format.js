@@ -0,0 +1,2 @@
+import { join } from "path"
+export default function (value) { return join("out", String(value)) }
@@ -0,0 +1,2 @@
+import { readFile } from "fs"
+export function load(path) { return readFile(path) }
@@ -0,0 +1,4 @@
+import { readFile } from "fs"
+import format from "./format.js"
+export { format }
+export const load = path => import("./loader.js").then(m => m.load(path))
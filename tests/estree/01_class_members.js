@@ -0,0 +1,7 @@
+class Queue extends Base {
+    static count = 0;
+    static { Queue.count = 1; }
+    async *drain() { yield* this.items; }
+    static async load(url) { return await fetch(url); }
+    get size() { return this.items.length; }
+}
@@ -0,0 +1,3 @@
+const name = "world";
+const greeting = `hello ${name}, ${`nested ${1 + 2}`}!`;
+const empty = ``;
@@ -0,0 +1,5 @@
+import { readFile } from "fs";
+export default async function main(path) {
+    const [first, ...rest] = await readFile(path);
+    return { first, rest };
+}
@@ -0,0 +1,5 @@
+const a = 1 + 2 * 3, b = "con" + "cat", c = 0.1 + 0.2
+const d = 2 ** 53 + 1, e = 1 / 0, f = -0 === 0, g = typeof null
+const h = "5" * "2", i = [] + {}, j = !"", k = 7 >>> 1 | 0x10
+const l = void 0, m = (1, 2), n = null ?? "default", o = 0 || "x"
+const big = 2n ** 64n
@@ -0,0 +1,11 @@
+if (true) { live() } else { dead() }
+if (0) { var hoisted = 1 } else other()
+while (false) { never() }
+const x = false ? a() : b()
+function f() {
+    return helper()
+    unreachable()
+    var later = 2
+    function helper() { return later }
+}
+debugFlag && "production" === "development" && log()
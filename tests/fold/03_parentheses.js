@@ -0,0 +1,3 @@
+"use" + "strict"
+const obj = { method() { return this } }
+const r = (1 ? obj.method : null)()
@@ -0,0 +1,7 @@
+// 头部注释
+const config = {name: "demo", retries: 3, nested: {deep: [1, 2, 3]}} // 行尾注释
+
+
+/* 块注释 */
+function   handle(request,response){if(request.ok){return response.send(request.body)}else throw new Error("bad")}
+const longCall = someFunction(firstArgumentWithLongName, secondArgumentWithLongName, thirdArgument)
@@ -0,0 +1,9 @@
+class Point {
+static origin = new Point(0, 0)
+constructor(x, y) { this.x = x; this.y = y }
+get length() { return Math.hypot(this.x, this.y) }
+}
+for (let i = 0; i < 3; i++) if (i % 2) continue
+switch (x) { case 1: case 2: f(); break; default: g() }
+const arrow = async (a, {b, c = 1}, ...rest) => ({a, b})
+const t = `x ${a + b} y`
@@ -0,0 +1,2 @@
+import { main } from "./main.js"
+export const a = 1
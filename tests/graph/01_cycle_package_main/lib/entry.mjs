@@ -0,0 +1,2 @@
+const b = require("./b")
+import("fs")
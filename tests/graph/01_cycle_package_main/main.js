@@ -0,0 +1,3 @@
+import { a } from "./a.js"
+import "./lib"
+export const main = a
@@ -0,0 +1,4 @@
+import config from "./config"
+import { helper } from "./util"
+import React from "react"
+import "./missing.js"
@@ -0,0 +1 @@
+export { helper } from "./helper.mjs"
@@ -0,0 +1,6 @@
+/* 多行
+   注释 */
+class A { static #x = 1n; get y() { return `a
+${this.y}b` } }
+const re = /a+/gu, s = "字符串" // 结尾
+let n = 0x1F + .5e3
@@ -0,0 +1,4 @@
+function f(a, b) { return a.map(x => x + b) }
+const { p, q } = f(1), async = 2
+let s = "未结束
+let after = 1
@@ -0,0 +1,3 @@
+// 错误: 模板字符串 ${} 中的表达式不完整
+const name = "world";
+const greeting = `hello ${name +}`;
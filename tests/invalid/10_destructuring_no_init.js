@@ -0,0 +1,2 @@
+// 错误: 解构声明缺少初始值
+let [first, second];
@@ -0,0 +1,2 @@
+// 错误: 普通脚本中的import声明
+import {readFile} from "fs";
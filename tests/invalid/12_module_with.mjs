@@ -0,0 +1,4 @@
+// 错误: 模块代码是严格模式，不允许with语句
+with (Math) {
+    console.log(PI);
+}
@@ -0,0 +1,3 @@
+// 错误: let重复声明同一个标识符
+let total = 0;
+let total = 1;
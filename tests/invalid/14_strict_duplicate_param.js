@@ -0,0 +1,5 @@
+// 错误: 严格模式的函数不允许重复参数
+"use strict";
+function sum(a, b, a) {
+    return a + b;
+}
@@ -0,0 +1,7 @@
+// 错误: 严格模式不允许with语句
+function area(r) {
+    "use strict";
+    with (Math) {
+        return PI * r * r;
+    }
+}
@@ -0,0 +1,6 @@
+// 错误: var与解构的catch参数同名
+try {
+    load();
+} catch ([error]) {
+    var error;
+}
@@ -0,0 +1,2 @@
+// 错误: \x后面不足两位十六进制数字
+const letter = "\x4G";
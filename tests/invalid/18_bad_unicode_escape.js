@@ -0,0 +1,2 @@
+// 错误: \u后面不足四位十六进制数字
+const letter = "\u00G1";
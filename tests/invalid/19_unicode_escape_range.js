@@ -0,0 +1,2 @@
+// 错误: \u{...}的码点超过0x10FFFF
+const letter = "\u{110000}";
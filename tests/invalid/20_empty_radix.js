@@ -0,0 +1,2 @@
+// 错误: 0x后面没有数字
+const mask = 0x;
@@ -0,0 +1,2 @@
+// 错误: 连续的数字分隔符
+const count = 1__000;
@@ -0,0 +1,2 @@
+// 错误: 带小数的BigInt
+const big = 1.5n;
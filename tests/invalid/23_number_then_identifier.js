@@ -0,0 +1,2 @@
+// 错误: 数字后面紧跟标识符（3in应写作3 in）
+const found = 3in [1, 2, 3];
@@ -0,0 +1,2 @@
+// 错误: 正则表达式未闭合的分组
+const pattern = /(/;
@@ -0,0 +1,2 @@
+// 错误: 正则表达式量词前没有可重复的内容
+const pattern = /a**/;
@@ -0,0 +1,2 @@
+// 错误: 正则表达式{}量词的上下界颠倒
+const pattern = /a{2,1}/;
@@ -0,0 +1,2 @@
+// 错误: 正则表达式u标志下单独的]
+const pattern = /]/u;
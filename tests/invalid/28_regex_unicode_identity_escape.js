@@ -0,0 +1,2 @@
+// 错误: 正则表达式u标志下不存在的转义\8
+const pattern = /\8/u;
@@ -0,0 +1,2 @@
+// 错误: 正则表达式字符类的范围颠倒
+const pattern = /[z-a]/;
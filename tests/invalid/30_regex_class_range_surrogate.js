@@ -0,0 +1,2 @@
+// 错误: 正则表达式没有u标志时emoji按UTF-16码元，范围颠倒
+const pattern = /[😀-😂]/;
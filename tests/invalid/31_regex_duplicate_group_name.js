@@ -0,0 +1,2 @@
+// 错误: 正则表达式同一分支中重复的分组名
+const pattern = /(?<a>x)(?<a>y)/;
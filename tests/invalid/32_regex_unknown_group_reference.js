@@ -0,0 +1,2 @@
+// 错误: 正则表达式\k引用不存在的分组名
+const pattern = /\k<b>(?<a>.)/;
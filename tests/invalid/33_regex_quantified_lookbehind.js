@@ -0,0 +1,2 @@
+// 错误: 正则表达式后行断言后面不能跟量词
+const pattern = /(?<=a)*/;
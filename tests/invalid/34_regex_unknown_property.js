@@ -0,0 +1,2 @@
+// 错误: 正则表达式不存在的Unicode属性
+const pattern = /\p{Foo}/u;
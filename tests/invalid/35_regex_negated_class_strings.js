@@ -0,0 +1,2 @@
+// 错误: 正则表达式v标志下取反的字符类包含字符串
+const pattern = /[^\q{ab}]/v;
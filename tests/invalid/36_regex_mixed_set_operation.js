@@ -0,0 +1,2 @@
+// 错误: 正则表达式v标志下范围与&&混用
+const pattern = /[a-z&&b]/v;
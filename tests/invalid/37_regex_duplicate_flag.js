@@ -0,0 +1,2 @@
+// 错误: 正则表达式重复的标志
+const pattern = /a/gg;
@@ -0,0 +1,2 @@
+// 错误: 正则表达式u和v标志不能同时使用
+const pattern = /a/uv;
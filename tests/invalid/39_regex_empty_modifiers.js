@@ -0,0 +1,2 @@
+// 错误: 正则表达式修饰符组没有任何修饰符
+const pattern = /(?-:a)/;
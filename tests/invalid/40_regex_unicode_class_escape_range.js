@@ -0,0 +1,2 @@
+// 错误: 正则表达式u标志下以\d作为范围端点
+const pattern = /[\d-z]/u;
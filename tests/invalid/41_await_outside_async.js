@@ -0,0 +1,5 @@
+// 错误: await只能出现在async函数中
+function load(url) {
+    const response = await fetch(url);
+    return response;
+}
@@ -0,0 +1,4 @@
+// 错误: yield只能出现在生成器函数中
+function values() {
+    yield 1;
+}
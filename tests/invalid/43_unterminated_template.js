@@ -0,0 +1,3 @@
+// 错误: ${} 中的模板字符串没有闭合
+const name = "world";
+const greeting = `hello ${`dear ${name}!`;
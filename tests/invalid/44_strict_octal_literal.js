@@ -0,0 +1,4 @@
+// 错误: 严格模式不允许传统八进制数字
+"use strict";
+
+const mode = 0644;
@@ -0,0 +1,6 @@
+// 错误: 严格模式不允许传统八进制转义（指令序言中"use strict"之前的字符串也算）
+function banner() {
+    "\101";
+    "use strict";
+    return "A";
+}
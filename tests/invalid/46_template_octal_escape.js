@@ -0,0 +1,3 @@
+// 错误: 模板字符串不允许八进制转义
+const name = "world";
+const message = `hello ${name}\01`;
@@ -0,0 +1,9 @@
+// lint: 对象字面量中重复的键（no-dupe-keys，error）
+const config = {
+    name: "app",
+    "name": "other",
+    get size() { return 1; },
+    set size(value) {},
+    [key]: 1,
+    [key]: 2
+};
@@ -0,0 +1,5 @@
+// lint: debugger语句（no-debugger，warning，不影响退出码）
+function check(value) {
+    debugger;
+    return value > 0;
+}
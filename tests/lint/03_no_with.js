@@ -0,0 +1,4 @@
+// lint: with语句（no-with，error）
+with (Math) {
+    console.log(PI);
+}
@@ -0,0 +1,8 @@
+// lint: 没有诊断的代码
+const point = {
+    x: 1,
+    y: 2,
+    get length() { return Math.hypot(this.x, this.y); },
+    set length(value) {}
+};
+console.log(point.length);
@@ -0,0 +1,19 @@
+Content-Length: 58
+
+{"jsonrpc":"2.0","id":1,"method":"initialize","params":{}}Content-Length: 215
+
+{"jsonrpc":"2.0","method":"textDocument/didOpen","params":{"textDocument":{"uri":"file:///project/app.js","languageId":"javascript","version":1,"text":"function greet(name) {\n    return \"你好, \" + name\n}\n"}}}Content-Length: 231
+
+{"jsonrpc":"2.0","method":"textDocument/didChange","params":{"textDocument":{"uri":"file:///project/app.js","version":2},"contentChanges":[{"range":{"start":{"line":1,"character":24},"end":{"line":1,"character":24}},"text":" +"}]}}Content-Length: 235
+
+{"jsonrpc":"2.0","method":"textDocument/didChange","params":{"textDocument":{"uri":"file:///project/app.js","version":3},"contentChanges":[{"range":{"start":{"line":1,"character":26},"end":{"line":1,"character":26}},"text":" \"!\""}]}}Content-Length: 227
+
+{"jsonrpc":"2.0","method":"textDocument/didChange","params":{"textDocument":{"uri":"file:///project/app.js","version":4},"contentChanges":[{"range":{"start":{"line":2,"character":0},"end":{"line":2,"character":1}},"text":""}]}}Content-Length: 167
+
+{"jsonrpc":"2.0","method":"textDocument/didChange","params":{"textDocument":{"uri":"file:///project/app.js","version":5},"contentChanges":[{"text":"greet(\"x\")\n"}]}}Content-Length: 109
+
+{"jsonrpc":"2.0","method":"textDocument/didClose","params":{"textDocument":{"uri":"file:///project/app.js"}}}Content-Length: 44
+
+{"jsonrpc":"2.0","id":2,"method":"shutdown"}Content-Length: 33
+
+{"jsonrpc":"2.0","method":"exit"}
\ No newline at end of file
@@ -0,0 +1,10 @@
+let a = 1
+let b = a
+++b
+function f() {
+    return
+    a + b
+}
+const c = a
+/2/b
+var d = b - -a, e = b + +a, g = a+ ++b
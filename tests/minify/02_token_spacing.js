@@ -0,0 +1,8 @@
+var a = 1, b = 2, c
+c = a - -b
+c = a + ++b
+c = a< !b
+c = /re/ * 2
+c = 1 .toString()
+c = typeof a in b
+for (let i of [1, 2]) c += i
@@ -0,0 +1,5 @@
+/* 块注释 */
+// 行注释
+const re = /[/]\/+/g; // 正则
+const s = "  空白  保留 ", t = `a  ${ s }  b`;
+if (re.test(s)) { x = s instanceof Object ? 1 : 2 }
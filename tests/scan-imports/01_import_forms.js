@@ -0,0 +1,8 @@
+import a from "./a.js";
+import { b, c } from './b.mjs'
+import "./side-effect.js"
+export * from "./reexport.js"
+export { d } from "./d.js"
+const e = require("./e.cjs")
+const f = await import(`./f.js`)
+const url = import.meta.url
@@ -0,0 +1,7 @@
+// import "./comment.js"
+const s = "require(\"./string.js\")"
+const t = `${ require("./in-template.js") } import "./template-text.js"`
+const r = /import "x"/, q = a++ / 2 / require("./after-division.js")
+obj.require("./member.js")
+require(`./${name}.js`)
+function g() { return /export "y"/ }
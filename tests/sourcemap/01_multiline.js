@@ -0,0 +1,5 @@
+function add(a, b) {
+    return a + b
+}
+const total = add(1,
+    2)
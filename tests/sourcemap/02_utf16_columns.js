@@ -0,0 +1,3 @@
+const 名字 = "é😀"; let x = 名字
+// 注释
+x++
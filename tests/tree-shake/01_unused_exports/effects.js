@@ -0,0 +1,2 @@
+globalThis.ready = true
+export const flag = 1
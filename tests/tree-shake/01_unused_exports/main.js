@@ -0,0 +1,4 @@
+import { used, alsoUsed } from "./math.js"
+import { helper } from "./pure.js"
+import "./effects.js"
+console.log(used(1), alsoUsed)
@@ -0,0 +1,7 @@
+// 用到的函数
+export function used(x) { return twice(x) }
+function twice(x) { return x * 2 }
+/* 没用到 */
+export function unused() { return 0 }
+export const alsoUsed = 1, dead = 2
+const table = { a: 1 }
@@ -0,0 +1,2 @@
+export * from "./index.js"
+export function z() {}
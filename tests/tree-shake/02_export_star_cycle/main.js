@@ -0,0 +1,3 @@
+import { x } from "./index.js"
+export const result = x + 1
+const later = () => import("./lazy.js")
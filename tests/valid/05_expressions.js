@@ -66,7 +66,7 @@ function test(a, b, c) {
 }
 const sum = test(1, 2, 3);
 
-// 展开运算符 - 简化版本
+// 展开运算符
 const arr1 = [1, 2, 3];
 const arr2 = [4, 5];
-// const arr3 = [...arr1, ...arr2];  // 暂不支持完整的展开语法
+const arr3 = [...arr1, ...arr2];
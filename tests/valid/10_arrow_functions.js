@@ -0,0 +1,65 @@
+// 箭头函数与解构测试
+
+// 单个参数与参数列表
+const double = x => x * 2;
+const add = (a, b) => a + b;
+const noop = () => {};
+
+// 默认值、剩余参数、解构参数
+const greet = (name = "world", ...rest) => {
+    return "hello " + name + rest.length;
+};
+const area = ({width, height = 1}) => width * height;
+const first = ([head, ...tail]) => head;
+const trailing = (a, b,) => a;
+
+// 参数中的简写初始化
+const config = ({debug = false, level = 1} = {}) => level;
+
+// 嵌套箭头函数与回调
+const compose = (f, g) => x => f(g(x));
+const result = [1, 2, 3]
+    .map(n => n + 1)
+    .filter((n, i) => i > 0)
+    .reduce((sum, n) => sum + n, 0);
+
+// 箭头函数作为条件表达式分支
+const pick = flag ? (a) => a : (b) => b;
+
+// 解构声明
+const {x, y: [y1, y2], z = 3} = point;
+let [p, , q = 2, ...others] = values;
+
+// 解构赋值
+[p, q] = [q, p];
+({x: obj.x, y: arr[0]} = source);
+[{a = 1}] = [{}];
+
+// 展开运算符
+const merged = [...first, ...others];
+const copy = {...point, x: 1};
+add(...values);
+
+// 函数和方法的参数
+function options({name, size = 10}, [w, h] = [0, 0], ...extra) {
+    return name;
+}
+const handler = {
+    on(event, ...args) {
+        return args.length;
+    }
+};
+class Point {
+    move({dx = 0, dy = 0}) {
+        return dx + dy;
+    }
+}
+
+// for-of中的解构
+for (const [key, value] of entries) {
+    total += value;
+}
+
+// 分组表达式仍然正常工作
+const grouped = (a + b) * (c - d);
+(obj).value = 1;
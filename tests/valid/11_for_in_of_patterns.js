@@ -0,0 +1,22 @@
+// for-in/of 头部与解构声明测试
+
+// 声明作为左侧
+for (const [key, value] of Object.entries({a: 1})) {}
+for (let {length} of ["ab", "c"]) {}
+for (var index in [1, 2]) {}
+
+// 表达式作为左侧：数组/对象字面量重新解释为赋值模式
+let a, b, rest, target = {};
+for ([a, b] of [[1, 2]]) {}
+for ({a, b = 2} of [{a: 1}]) {}
+for ([a, ...rest] of [[1, 2, 3]]) {}
+for (target.name in {x: 1}) {}
+for ((a) of [1]) {}
+
+// 括号内和条件表达式中的 in 仍是运算符
+for (let i = ("x" in target) ? 0 : 1; i < 2; i++) {}
+for (a = b ? "x" in target : false; a; a = false) {}
+
+// 解构声明带初始值
+let [first, second] = [1, 2];
+const {name = "js"} = {};
@@ -0,0 +1,16 @@
+// ES模块语法测试（.mjs按模块解析）
+
+// 导入
+import def, {a as b, c} from "./x.js";
+import * as ns from "./y.js";
+import "./side.js";
+
+// 导出
+export const x = 1;
+export default function () {}
+export {b as d, c};
+export * from "./z.js";
+export * as all from "./w.js";
+
+// import.meta
+console.log(import.meta.url);
@@ -0,0 +1,30 @@
+// 作用域与重复声明测试
+
+// var和函数声明可以重复
+var count = 1;
+var count = 2;
+function helper() { return 1; }
+function helper() { return 2; }
+
+// 块作用域中的同名let遮蔽外层
+let value = 1;
+{
+    let value = 2;
+}
+
+// 简单catch参数可以被var重复声明（附录B）
+try {
+    helper();
+} catch (error) {
+    var error = null;
+}
+
+// 非严格模式的普通函数允许重复参数
+function legacy(a, a) {
+    return a;
+}
+
+// with语句在非严格模式中合法
+with (Math) {
+    count = max(count, 3);
+}
@@ -0,0 +1,27 @@
+// 字符串转义序列测试
+
+// 单字符转义和十六进制转义
+const simple = "tab\there\nnewline \"quoted\" 'single' \\ backslash";
+const hex = "\x41\x62\x7A\xff";
+
+// Unicode转义：四位、花括号和代理对
+const bmp = "\u4E2D\u6587";
+const braced = "\u{41}\u{1F600}\u{10FFFF}";
+const surrogate = "\uD83D\uDE00";
+const lone = "\uD800";
+
+// 续行和非转义字符
+const continued = "first line \
+second line";
+const identity = "\q\w\e";
+const nul = "\0";
+
+// 单引号字符串
+const single = '\x27\u0027\'';
+
+// 非严格模式允许传统八进制转义和\8、\9；严格模式中\0后面不跟数字时仍然允许
+const legacy = "\101\0101\8\9";
+function strictNul() {
+    "use strict";
+    return "\0" + `\0` + "\\101";
+}
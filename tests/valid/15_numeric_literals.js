@@ -0,0 +1,21 @@
+// 数字字面量测试
+
+// 各种进制和数字分隔符
+const decimal = 1_000_000;
+const hex = 0xFF_FF;
+const binary = 0b1010_0101;
+const octal = 0o7_7;
+const exponent = 1e1_0 + 1.5e-3 + 2E+8;
+
+// 小数点的位置
+const fraction = .5 + 5. + 0.25;
+const method = 1..toString() + 2 .toFixed(1);
+
+// BigInt
+const big = 123n + 0x1Fn + 0b1n + 0o7n + 0n + 9_007_199_254_740_993n;
+
+// 旧式八进制和以0开头的十进制（非严格模式）
+const legacy = 017 + 089 + 08.5;
+
+// 数字后面的运算符和in
+const inside = 3 in [1, 2, 3, 4];
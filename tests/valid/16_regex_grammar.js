@@ -0,0 +1,26 @@
+// 正则表达式文法测试（附录B、u、v标志、命名分组、修饰符组）
+
+// 附录B的Web兼容文法（没有u/v标志）
+const braces = /a{,5}/;
+const bracket = /]/;
+const forward = /\1(a)/;
+const digit = /\8/;
+const control = /\c/;
+const classEscape = /[\d-z]/;
+const lookahead = /(?=a)*/;
+const named = /\k/;
+
+// 不同分支中的同名分组
+const alternative = /(?<year>\d{4})|(?<year>\d{2})/;
+
+// u标志：Unicode属性、按码点的范围和代理对
+const greek = /\p{Script=Greek}/u;
+const emoji = /[😀-😂]/u;
+const pair = /😀/u;
+
+// v标志：集合运算和字符串
+const intersection = /[[a-z]&&\p{L}]/v;
+const subtraction = /[\q{abc|d}--a]/v;
+
+// 修饰符组
+const modifiers = /(?i-m:a)/;
@@ -0,0 +1,74 @@
+// 类成员：async方法、生成器方法、static async、static *、静态初始化块
+
+// async方法
+class Loader {
+    async load(url) {
+        const response = await fetch(url);
+        return await response.json();
+    }
+    async [Symbol.iterator]() {}
+    async "quoted"() {}
+}
+
+// 生成器方法（包括async生成器）
+class Range {
+    *values() {
+        yield 1;
+        yield* [2, 3];
+        yield
+    }
+    async *chunks(stream) {
+        for await (const chunk of stream) {
+            yield chunk;
+        }
+    }
+    *[Symbol.iterator]() {}
+}
+
+// static async 与 static *
+class Command {
+    static description = 'Get a value from the npm configuration';
+    static params = ['long'];
+    static async completion(opts) {
+        const config = await Command.load('config');
+        return config.completion(opts);
+    }
+    static *names() {
+        yield 'get';
+    }
+    static async *stream() {}
+}
+
+// 静态初始化块
+class Registry {
+    static entries = [];
+    static {
+        var count = 0;
+        for (const name of ['a', 'b']) {
+            Registry.entries.push(name);
+            count++;
+        }
+    }
+    static {}
+}
+
+// async、get、set、static 本身作为成员名
+class Names {
+    async() {}
+    static() {}
+    get() {}
+    set() {}
+    async = 1;
+    static = 2;
+    async
+    method() {}
+}
+
+// 对象字面量中的同样形式
+const handlers = {
+    async open() { await Promise.resolve(); },
+    *walk() { yield this; },
+    async *drain() {},
+    async: true,
+    get: 1
+};
@@ -0,0 +1,52 @@
+// async函数、生成器函数、await与yield
+
+async function main() {
+    const data = await load();
+    for await (const line of data) {
+        console.log(await line);
+    }
+    return await Promise.all([a(), b()]);
+}
+
+function* counter(limit) {
+    let i = 0;
+    while (i < limit) {
+        const reset = yield i++;
+        if (reset) i = 0;
+    }
+    yield* [limit];
+}
+
+async function* pages(url) {
+    let next = url;
+    while (next) {
+        const page = await fetch(next);
+        next = page.next;
+        yield page;
+    }
+}
+
+// 函数表达式与箭头函数
+const run = async function () { await main(); };
+const gen = function* named() { yield; };
+const single = async x => await x;
+const list = async (a, b = 1, ...rest) => { await a; };
+const none = async () => 1;
+const callbacks = [1, 2].map(async (n) => n * 2);
+
+// async后换行或其后不是参数时是普通标识符
+const value = async
+(async);
+const ref = [async, async.name];
+
+// yield和await的优先级
+async function precedence() {
+    const sum = await a + await b;
+    const neg = -await c;
+    return typeof await d;
+}
+function* nested() {
+    const x = yield yield 1;
+    const y = [yield, yield];
+    f(yield a, yield);
+}
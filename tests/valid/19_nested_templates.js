@@ -0,0 +1,28 @@
+// 模板字符串：${} 中嵌套模板、对象字面量、函数体和正则
+
+const name = "world";
+const x = `${`y`}`;
+const greeting = `hello ${`dear ${name}`}!`;
+const list = `<ul>${items.map(item => `<li>${item.label}</li>`).join("")}</ul>`;
+const config = `${{ a: 1, b: { c: 2 } }.b.c}`;
+const block = `${(() => {
+    const inner = `inner ${name}`;
+    return inner;
+})()}`;
+const pattern = `${/[`}]/.source}`;
+const divided = `${10 / 2 / 1}`;
+const literal = `\${not a substitution} $ {also not} $${"dollar"}`;
+const multiline = `first line
+second ${name}
+third`;
+const braces = `${"}"}${'{'}${`}`}`;
+
+async function render(data) {
+    return `${await data} ${typeof data}`;
+}
+
+function* pieces() {
+    yield `${yield "head"} tail`;
+}
+
+for (const key = `${"a" in data}`; ; ) break;
@@ -0,0 +1,149 @@
+#define _POSIX_C_SOURCE 200809L
+#include "threadpool.h"
+#include <pthread.h>
+#include <unistd.h>
+
+/* 任务队列节点 */
+typedef struct TaskNode {
+    ThreadTask task;
+    void *arg;
+    struct TaskNode *next;
+} TaskNode;
+
+struct ThreadPool {
+    pthread_t *threads;         /* 工作线程 */
+    int thread_count;           /* 线程数量 */
+    TaskNode *head;             /* 队首 */
+    TaskNode *tail;             /* 队尾 */
+    size_t pending;             /* 已提交但尚未完成的任务数 */
+    bool shutdown;              /* 是否正在关闭 */
+    pthread_mutex_t lock;
+    pthread_cond_t has_task;    /* 队列非空 */
+    pthread_cond_t all_done;    /* pending归零 */
+};
+
+/* 工作线程主循环 */
+static void* worker_main(void *arg) {
+    ThreadPool *pool = (ThreadPool*)arg;
+    
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->head && !pool->shutdown) {
+            pthread_cond_wait(&pool->has_task, &pool->lock);
+        }
+        if (!pool->head && pool->shutdown) {
+            break;
+        }
+        
+        TaskNode *node = pool->head;
+        pool->head = node->next;
+        if (!pool->head) pool->tail = NULL;
+        pthread_mutex_unlock(&pool->lock);
+        
+        node->task(node->arg);
+        free(node);
+        
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_broadcast(&pool->all_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    
+    return NULL;
+}
+
+/* 获取在线CPU核数 */
+int threadpool_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+/* 创建线程池，thread_count <= 0 时使用CPU核数 */
+ThreadPool* threadpool_create(int thread_count) {
+    if (thread_count <= 0) thread_count = threadpool_cpu_count();
+    
+    ThreadPool *pool = (ThreadPool*)calloc(1, sizeof(ThreadPool));
+    if (!pool) return NULL;
+    
+    pool->threads = (pthread_t*)malloc(sizeof(pthread_t) * thread_count);
+    if (!pool->threads) {
+        free(pool);
+        return NULL;
+    }
+    
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->has_task, NULL);
+    pthread_cond_init(&pool->all_done, NULL);
+    
+    for (int i = 0; i < thread_count; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) {
+            break;
+        }
+        pool->thread_count++;
+    }
+    
+    if (pool->thread_count == 0) {
+        threadpool_destroy(pool);
+        return NULL;
+    }
+    
+    return pool;
+}
+
+/* 销毁线程池（先执行完队列中剩余的任务） */
+void threadpool_destroy(ThreadPool *pool) {
+    if (!pool) return;
+    
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->has_task);
+    pthread_mutex_unlock(&pool->lock);
+    
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->has_task);
+    pthread_cond_destroy(&pool->all_done);
+    free(pool->threads);
+    free(pool);
+}
+
+/* 提交任务（任务内部也可以继续提交新任务） */
+bool threadpool_submit(ThreadPool *pool, ThreadTask task, void *arg) {
+    TaskNode *node = (TaskNode*)malloc(sizeof(TaskNode));
+    if (!node) return false;
+    
+    node->task = task;
+    node->arg = arg;
+    node->next = NULL;
+    
+    pthread_mutex_lock(&pool->lock);
+    if (pool->tail) {
+        pool->tail->next = node;
+    } else {
+        pool->head = node;
+    }
+    pool->tail = node;
+    pool->pending++;
+    pthread_cond_signal(&pool->has_task);
+    pthread_mutex_unlock(&pool->lock);
+    
+    return true;
+}
+
+/* 等待所有已提交的任务（包括任务中派生的任务）完成 */
+void threadpool_wait(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->all_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/* 线程数量 */
+int threadpool_size(const ThreadPool *pool) {
+    return pool ? pool->thread_count : 0;
+}
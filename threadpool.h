@@ -0,0 +1,22 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include "common.h"
+
+/* 线程池任务函数 */
+typedef void (*ThreadTask)(void *arg);
+
+/* 线程池（固定数量的工作线程 + FIFO任务队列） */
+typedef struct ThreadPool ThreadPool;
+
+/* 线程池函数声明 */
+ThreadPool* threadpool_create(int thread_count);
+void threadpool_destroy(ThreadPool *pool);
+bool threadpool_submit(ThreadPool *pool, ThreadTask task, void *arg);
+void threadpool_wait(ThreadPool *pool);
+int threadpool_size(const ThreadPool *pool);
+
+/* 辅助函数 */
+int threadpool_cpu_count(void);
+
+#endif /* THREADPOOL_H */
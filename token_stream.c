@@ -0,0 +1,155 @@
+#include "token_stream.h"
+#include "cooked.h"
+#include "numeric.h"
+
+/* 输出一个token的JSON行（bigint为BigInt字面量十进制值的缓冲） */
+static void write_json_token(Writer *writer, const Token *token, const char *source,
+                             NumericBigInt *bigint) {
+    size_t start = (size_t)token->start.offset;
+    size_t end = (size_t)token->end.offset;
+
+    writer_cstr(writer, "{\"type\":\"");
+    writer_cstr(writer, token_type_to_string(token->type));
+    writer_cstr(writer, "\",\"start\":");
+    writer_uint(writer, start);
+    writer_cstr(writer, ",\"end\":");
+    writer_uint(writer, end);
+    writer_cstr(writer, ",\"line\":");
+    writer_uint(writer, (uint64_t)token->start.line);
+    writer_cstr(writer, ",\"column\":");
+    writer_uint(writer, (uint64_t)token->start.column);
+    writer_cstr(writer, token->preceded_by_newline ? ",\"newline\":true" : ",\"newline\":false");
+    writer_cstr(writer, ",\"text\":");
+    writer_json_string(writer, source + start, end - start);
+    if (token->cooked) {
+        writer_cstr(writer, ",\"value\":");
+        cooked_write_json(writer, token->cooked, token->cooked_length);
+    } else if (token->type == TOKEN_NUMBER && source[end - 1] == 'n') {
+        /* BigInt的值超出JSON数字的精度，按ESTree的写法给出十进制文本 */
+        size_t length;
+        const char *text = numeric_bigint_parse(bigint, source + start, end - start)
+                         ? numeric_bigint_decimal(bigint, &length) : NULL;
+        if (text) {
+            writer_cstr(writer, ",\"bigint\":\"");
+            writer_write(writer, text, length);
+            writer_byte(writer, '"');
+        } else {
+            writer->failed = true;
+        }
+    } else if (token->type == TOKEN_NUMBER) {
+        char buffer[32];
+        writer_cstr(writer, ",\"value\":");
+        writer_write(writer, buffer, numeric_format_json(token->number, buffer));
+    }
+    writer_cstr(writer, "}\n");
+}
+
+/* 对源码做词法分析并逐个输出token（不保存token序列）；词法错误时返回false，已输出的部分保留 */
+bool token_stream_write(const char *source, size_t length, TokenStreamFormat format,
+                        Writer *writer, ErrorInfo *error) {
+    Lexer *lexer = lexer_create(source, length, error);
+    if (!lexer) return false;
+
+    /* JSONL附带字符串和数字字面量的值 */
+    CookedStrings *strings = NULL;
+    NumericBigInt bigint;
+    numeric_bigint_init(&bigint);
+    if (format == TOKEN_STREAM_JSONL) {
+        strings = cooked_strings_create();
+        if (!strings) {
+            lexer_destroy(lexer);
+            return false;
+        }
+        lexer->strings = strings;
+    }
+
+    if (format == TOKEN_STREAM_BINARY) {
+        writer_write(writer, TOKEN_STREAM_MAGIC, 4);
+        writer_varint(writer, TOKEN_STREAM_VERSION);
+    }
+
+    bool success = true;
+    size_t previous_end = 0;
+    for (;;) {
+        Token *token = lexer_next_token(lexer);
+        if (!token) {
+            success = false;
+            break;
+        }
+
+        if (format == TOKEN_STREAM_BINARY) {
+            size_t start = (size_t)token->start.offset;
+            size_t end = (size_t)token->end.offset;
+            writer_varint(writer, (uint64_t)token->type << 1 | token->preceded_by_newline);
+            writer_varint(writer, start - previous_end);
+            writer_varint(writer, end - start);
+            previous_end = end;
+        } else {
+            write_json_token(writer, token, source, &bigint);
+        }
+
+        bool done = token->type == TOKEN_EOF;
+        token_destroy(token);
+        if (done) break;
+    }
+
+    lexer_destroy(lexer);
+    cooked_strings_destroy(strings);
+    numeric_bigint_free(&bigint);
+    return success && !writer->failed;
+}
+
+/* 读取一个varint，数据不完整或超过64位时返回false */
+static bool read_varint(TokenStreamReader *reader, uint64_t *value) {
+    uint64_t result = 0;
+
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (reader->position >= reader->size) {
+            return false;
+        }
+        uint8_t byte = reader->data[reader->position++];
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* 初始化读取器并检查流的开头和版本 */
+bool token_stream_reader_init(TokenStreamReader *reader, const void *data, size_t size) {
+    reader->data = (const uint8_t*)data;
+    reader->size = size;
+    reader->position = 0;
+    reader->offset = 0;
+    reader->done = false;
+
+    if (size < 4 || memcmp(data, TOKEN_STREAM_MAGIC, 4) != 0) {
+        return false;
+    }
+    reader->position = 4;
+
+    uint64_t version;
+    return read_varint(reader, &version) && version == TOKEN_STREAM_VERSION;
+}
+
+/* 读取下一个token；读完TOKEN_EOF之后或数据损坏时返回false */
+bool token_stream_read(TokenStreamReader *reader, TokenRecord *record) {
+    if (reader->done) return false;
+
+    uint64_t type, gap, length;
+    if (!read_varint(reader, &type) || !read_varint(reader, &gap) ||
+        !read_varint(reader, &length) || (type >> 1) > TOKEN_AUTO_SEMICOLON ||
+        gap > SIZE_MAX - reader->offset || length > SIZE_MAX - reader->offset - gap) {
+        return false;
+    }
+
+    record->type = (TokenType)(type >> 1);
+    record->preceded_by_newline = type & 1;
+    record->start = reader->offset + (size_t)gap;
+    record->end = record->start + (size_t)length;
+    reader->offset = record->end;
+    reader->done = record->type == TOKEN_EOF;
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include "lexer.h"
+#include "writer.h"
+#include "common.h"
+
+#define TOKEN_STREAM_MAGIC "JSTK"
+#define TOKEN_STREAM_VERSION 2
+
+/*
+ * 二进制token流格式：
+ *   "JSTK" varint(version)
+ *   每个token：varint(type << 1 | newline) varint(gap) varint(length)
+ * type为TokenType的值（修改TokenType的顺序时必须增加版本号），newline表示token前有换行，
+ * gap为token起点与上一个token终点（第一个token为0）之间的字节数，length为token的字节长度。
+ * 流以TOKEN_EOF结束，缺少TOKEN_EOF说明流被截断。
+ */
+
+/* 输出格式 */
+typedef enum {
+    TOKEN_STREAM_BINARY,    /* 上面的二进制格式 */
+    TOKEN_STREAM_JSONL      /* 每行一个JSON对象（调试用） */
+} TokenStreamFormat;
+
+/* 从二进制流中读出的token */
+typedef struct {
+    TokenType type;
+    bool preceded_by_newline;
+    size_t start;           /* 字节偏移 */
+    size_t end;
+} TokenRecord;
+
+/* 二进制流读取器 */
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t position;
+    size_t offset;          /* 上一个token的终点 */
+    bool done;              /* 已读到TOKEN_EOF */
+} TokenStreamReader;
+
+/* token流函数声明 */
+bool token_stream_write(const char *source, size_t length, TokenStreamFormat format,
+                        Writer *writer, ErrorInfo *error);
+bool token_stream_reader_init(TokenStreamReader *reader, const void *data, size_t size);
+bool token_stream_read(TokenStreamReader *reader, TokenRecord *record);
+
+#endif /* TOKEN_STREAM_H */
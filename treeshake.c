@@ -0,0 +1,1287 @@
+#include "treeshake.h"
+#include "parser.h"
+#include "lexer.h"
+#include "threadpool.h"
+#include <sys/stat.h>
+#include <errno.h>
+
+/*
+ * 摇树（删除未使用的导出）
+ *
+ * 分析阶段在线程池上按模块并行：解析为模块AST，收集顶层绑定、导出表、
+ * 每条顶层语句引用的顶层绑定，并判断语句是否有副作用。
+ * 不动点阶段在单线程上用工作表增量传播存活性：有副作用的语句、入口的全部导出和
+ * 被动态导入/require的模块是种子；存活语句使它引用的绑定存活，存活绑定使声明它的
+ * 语句存活，存活的import绑定请求目标模块的导出。每个语句、绑定和导出名只入表一次，
+ * 所以总工作量与引用数成正比，export * 组成的环也能终止。
+ * 输出阶段删除死语句，重建import/export说明符列表，只为有副作用的模块保留 import 'x'。
+ */
+
+static const ShakeName default_name = {"default", 7};
+static const ShakeName anonymous_default = {"*default*", 9};
+
+/* ---------- 名字表 ---------- */
+
+static bool name_equal(ShakeName a, ShakeName b) {
+    return a.length == b.length && memcmp(a.text, b.text, a.length) == 0;
+}
+
+/* 查找名字，找不到返回NAME_NONE */
+uint32_t name_table_get(const NameTable *table, ShakeName name) {
+    if (table->count == 0) return NAME_NONE;
+
+    size_t mask = table->capacity - 1;
+    for (size_t i = fnv1a_hash(name.text, name.length) & mask; table->names[i].text; i = (i + 1) & mask) {
+        if (name_equal(table->names[i], name)) {
+            return table->values[i];
+        }
+    }
+    return NAME_NONE;
+}
+
+/* 插入名字（已存在时不覆盖） */
+bool name_table_put(NameTable *table, ShakeName name, uint32_t value) {
+    if ((table->count + 1) * 2 > table->capacity) {
+        size_t capacity = table->capacity ? table->capacity * 2 : 16;
+        ShakeName *names = (ShakeName*)calloc(capacity, sizeof(ShakeName));
+        uint32_t *values = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+        if (!names || !values) {
+            free(names);
+            free(values);
+            return false;
+        }
+        for (size_t i = 0; i < table->capacity; i++) {
+            if (!table->names[i].text) continue;
+            size_t j = fnv1a_hash(table->names[i].text, table->names[i].length) & (capacity - 1);
+            while (names[j].text) j = (j + 1) & (capacity - 1);
+            names[j] = table->names[i];
+            values[j] = table->values[i];
+        }
+        free(table->names);
+        free(table->values);
+        table->names = names;
+        table->values = values;
+        table->capacity = capacity;
+    }
+
+    size_t mask = table->capacity - 1;
+    size_t i = fnv1a_hash(name.text, name.length) & mask;
+    for (; table->names[i].text; i = (i + 1) & mask) {
+        if (name_equal(table->names[i], name)) {
+            return true;
+        }
+    }
+    table->names[i] = name;
+    table->values[i] = value;
+    table->count++;
+    return true;
+}
+
+void name_table_free(NameTable *table) {
+    free(table->names);
+    free(table->values);
+    memset(table, 0, sizeof(*table));
+}
+
+/* ---------- 分析阶段 ---------- */
+
+/* 分析任务 */
+typedef struct {
+    const ModuleGraph *graph;
+    ShakeModule *module;
+    uint32_t index;
+    bool failed;            /* 内存不足 */
+} AnalyzeTask;
+
+/* 保证数组还能追加一个元素 */
+static bool reserve(void **items, size_t *capacity, size_t count, size_t size) {
+    if (count < *capacity) return true;
+
+    size_t new_capacity = *capacity ? *capacity * 2 : 16;
+    void *grown = realloc(*items, new_capacity * size);
+    if (!grown) return false;
+    *items = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+static inline const AstNode* node_at(const ShakeModule *m, uint32_t node) {
+    return &m->ast.nodes[node];
+}
+
+static inline uint32_t child_at(const ShakeModule *m, uint32_t node, int index) {
+    uint32_t child = m->ast.nodes[node].first_child;
+    while (index-- > 0 && child != AST_NONE) {
+        child = m->ast.nodes[child].next_sibling;
+    }
+    return child;
+}
+
+static inline bool is_null(const ShakeModule *m, uint32_t node) {
+    return node == AST_NONE || m->ast.nodes[node].kind == AST_NULL;
+}
+
+/* 标识符或字符串字面量（import/export中的名字）表示的名字 */
+static ShakeName node_name(const ShakeModule *m, const char *source, uint32_t node) {
+    const AstNode *n = node_at(m, node);
+    ShakeName name = {source + n->start, n->end - n->start};
+    if (n->kind == AST_LITERAL && name.length >= 2) {
+        name.text++;
+        name.length -= 2;
+    }
+    return name;
+}
+
+/* import/export语句的源字符串对应的依赖图模块（源字符串已由module_scan扫描过） */
+static uint32_t source_target(const GraphModule *gm, const AstNode *literal) {
+    return module_import_target(gm, (size_t)literal->start + 1);
+}
+
+/* 查找或新建绑定（重复声明返回已有的绑定） */
+static uint32_t add_binding(ShakeModule *m, ShakeName name, BindingKind kind, uint32_t node) {
+    uint32_t index = name_table_get(&m->binding_names, name);
+    if (index != NAME_NONE) return index;
+
+    if (!reserve((void**)&m->bindings, &m->binding_capacity, m->binding_count, sizeof(ShakeBinding))) {
+        return NAME_NONE;
+    }
+    index = (uint32_t)m->binding_count;
+    if (!name_table_put(&m->binding_names, name, index)) return NAME_NONE;
+
+    ShakeBinding *b = &m->bindings[m->binding_count++];
+    memset(b, 0, sizeof(*b));
+    b->name = name;
+    b->kind = kind;
+    b->node = node;
+    b->target = MODULE_NONE;
+    b->first_decl = NAME_NONE;
+    return index;
+}
+
+/* 记录语句声明了绑定 */
+static bool add_decl(ShakeModule *m, uint32_t binding, uint32_t statement) {
+    if (binding == NAME_NONE ||
+        !reserve((void**)&m->decls, &m->decl_capacity, m->decl_count, sizeof(ShakeDecl))) {
+        return false;
+    }
+    ShakeDecl *d = &m->decls[m->decl_count];
+    d->statement = statement;
+    d->next = m->bindings[binding].first_decl;
+    m->bindings[binding].first_decl = (uint32_t)m->decl_count++;
+    return true;
+}
+
+/* 添加导出名 */
+static bool add_export(ShakeModule *m, ShakeName name, ExportKind kind, uint32_t statement) {
+    if (!reserve((void**)&m->exports, &m->export_capacity, m->export_count, sizeof(ShakeExport)) ||
+        !name_table_put(&m->export_names, name, (uint32_t)m->export_count)) {
+        return false;
+    }
+    ShakeExport *e = &m->exports[m->export_count++];
+    memset(e, 0, sizeof(*e));
+    e->name = name;
+    e->kind = kind;
+    e->binding = NAME_NONE;
+    e->target = MODULE_NONE;
+    e->statement = statement;
+    return true;
+}
+
+/* 声明模式中的全部绑定；exported为真时同时按原名导出 */
+static bool declare_pattern(ShakeModule *m, const char *source, uint32_t node,
+                            uint32_t statement, bool exported) {
+    if (is_null(m, node)) return true;
+
+    const AstNode *n = node_at(m, node);
+    switch (n->kind) {
+        case AST_IDENTIFIER: {
+            ShakeName name = node_name(m, source, node);
+            uint32_t binding = add_binding(m, name, BINDING_LOCAL, node);
+            if (!add_decl(m, binding, statement)) return false;
+            if (exported) {
+                if (!add_export(m, name, EXPORT_LOCAL, statement)) return false;
+                m->exports[m->export_count - 1].binding = binding;
+            }
+            return true;
+        }
+
+        case AST_PROPERTY:
+            /* 属性名不是绑定 */
+            return declare_pattern(m, source, child_at(m, node, 1), statement, exported);
+
+        case AST_ASSIGNMENT_PATTERN:
+            /* 默认值不是绑定 */
+            return declare_pattern(m, source, n->first_child, statement, exported);
+
+        case AST_ARRAY_PATTERN:
+        case AST_OBJECT_PATTERN:
+        case AST_REST_ELEMENT:
+            for (uint32_t c = n->first_child; c != AST_NONE; c = node_at(m, c)->next_sibling) {
+                if (!declare_pattern(m, source, c, statement, exported)) return false;
+            }
+            return true;
+
+        default:
+            return true;
+    }
+}
+
+/* 声明语句 */
+static bool declare_declaration(ShakeModule *m, const char *source, uint32_t node,
+                                uint32_t statement, bool exported) {
+    const AstNode *n = node_at(m, node);
+    switch (n->kind) {
+        case AST_VARIABLE_DECLARATION:
+            for (uint32_t c = n->first_child; c != AST_NONE; c = node_at(m, c)->next_sibling) {
+                if (!declare_pattern(m, source, node_at(m, c)->first_child, statement, exported)) {
+                    return false;
+                }
+            }
+            return true;
+
+        case AST_FUNCTION_DECLARATION:
+        case AST_CLASS_DECLARATION:
+            return declare_pattern(m, source, n->first_child, statement, exported);
+
+        default:
+            return true;
+    }
+}
+
+/* import声明：每个说明符是一个绑定 */
+static bool declare_import(ShakeModule *m, const char *source, uint32_t node, uint32_t target) {
+    uint32_t spec = node_at(m, node_at(m, node)->first_child)->next_sibling;
+    for (; spec != AST_NONE; spec = node_at(m, spec)->next_sibling) {
+        const AstNode *s = node_at(m, spec);
+        uint32_t local = s->kind == AST_IMPORT_SPECIFIER ? child_at(m, spec, 1) : s->first_child;
+        BindingKind kind = s->kind == AST_IMPORT_NAMESPACE_SPECIFIER ? BINDING_NAMESPACE : BINDING_IMPORT;
+        uint32_t binding = add_binding(m, node_name(m, source, local), kind, local);
+        if (binding == NAME_NONE) return false;
+
+        ShakeBinding *b = &m->bindings[binding];
+        b->kind = kind;
+        b->node = local;
+        b->target = target;
+        b->imported = s->kind == AST_IMPORT_SPECIFIER ? node_name(m, source, s->first_child)
+                                                       : default_name;
+    }
+    return true;
+}
+
+/* 导出语句 */
+static bool declare_export(ShakeModule *m, const char *source, uint32_t statement) {
+    ShakeStatement *st = &m->statements[statement];
+    const AstNode *n = node_at(m, st->node);
+
+    if (n->kind == AST_EXPORT_DEFAULT_DECLARATION) {
+        uint32_t declaration = n->first_child;
+        const AstNode *d = node_at(m, declaration);
+        uint32_t binding;
+        if ((d->kind == AST_FUNCTION_DECLARATION || d->kind == AST_CLASS_DECLARATION) &&
+            !is_null(m, d->first_child)) {
+            binding = add_binding(m, node_name(m, source, d->first_child), BINDING_LOCAL, d->first_child);
+        } else {
+            binding = add_binding(m, anonymous_default, BINDING_DEFAULT, st->node);
+        }
+        if (!add_decl(m, binding, statement) || !add_export(m, default_name, EXPORT_LOCAL, statement)) {
+            return false;
+        }
+        m->exports[m->export_count - 1].binding = binding;
+        return true;
+    }
+
+    if (n->kind == AST_EXPORT_ALL_DECLARATION) {
+        uint32_t exported = n->first_child;
+        if (is_null(m, exported)) {
+            if (!reserve((void**)&m->stars, &m->star_capacity, m->star_count, sizeof(ShakeStar))) {
+                return false;
+            }
+            ShakeStar *star = &m->stars[m->star_count++];
+            star->target = st->target;
+            star->statement = statement;
+            star->used = false;
+            return true;
+        }
+        if (!add_export(m, node_name(m, source, exported), EXPORT_NAMESPACE, statement)) return false;
+        m->exports[m->export_count - 1].target = st->target;
+        return true;
+    }
+
+    /* ExportNamedDeclaration */
+    uint32_t declaration = n->first_child;
+    if (!is_null(m, declaration)) {
+        return declare_declaration(m, source, declaration, statement, true);
+    }
+    uint32_t from = node_at(m, declaration)->next_sibling;
+    for (uint32_t spec = node_at(m, from)->next_sibling; spec != AST_NONE;
+         spec = node_at(m, spec)->next_sibling) {
+        uint32_t local = node_at(m, spec)->first_child;
+        uint32_t exported = node_at(m, local)->next_sibling;
+        if (!add_export(m, node_name(m, source, exported),
+                        is_null(m, from) ? EXPORT_LOCAL : EXPORT_REEXPORT, statement)) {
+            return false;
+        }
+        /* 本地导出的绑定在所有声明收集完后再查找（export {a} 可以在声明之前） */
+        ShakeExport *e = &m->exports[m->export_count - 1];
+        e->imported = node_name(m, source, local);
+        e->target = st->target;
+    }
+    return true;
+}
+
+/* 收集子树中对顶层绑定的引用（不区分内层作用域的同名绑定，结果偏保守） */
+static bool collect_refs(ShakeModule *m, const char *source, uint32_t node) {
+    const AstNode *n = node_at(m, node);
+    switch (n->kind) {
+        case AST_IDENTIFIER: {
+            uint32_t binding = name_table_get(&m->binding_names, node_name(m, source, node));
+            if (binding == NAME_NONE) return true;
+            if (!reserve((void**)&m->refs, &m->ref_capacity, m->ref_count, sizeof(ShakeRef))) {
+                return false;
+            }
+            m->refs[m->ref_count].node = node;
+            m->refs[m->ref_count].binding = binding;
+            m->ref_count++;
+            return true;
+        }
+
+        case AST_MEMBER_EXPRESSION:
+            /* a.b 的b不是引用 */
+            if (!collect_refs(m, source, n->first_child)) return false;
+            if (n->flags & AST_FLAG_COMPUTED) {
+                return collect_refs(m, source, node_at(m, n->first_child)->next_sibling);
+            }
+            return true;
+
+        case AST_PROPERTY:
+        case AST_METHOD_DEFINITION:
+        case AST_PROPERTY_DEFINITION: {
+            /* 非计算的属性名不是引用 */
+            uint32_t c = n->first_child;
+            if (!(n->flags & AST_FLAG_COMPUTED)) c = node_at(m, c)->next_sibling;
+            for (; c != AST_NONE; c = node_at(m, c)->next_sibling) {
+                if (!collect_refs(m, source, c)) return false;
+            }
+            return true;
+        }
+
+        case AST_META_PROPERTY:
+        case AST_BREAK_STATEMENT:
+        case AST_CONTINUE_STATEMENT:
+            return true;
+
+        default:
+            for (uint32_t c = n->first_child; c != AST_NONE; c = node_at(m, c)->next_sibling) {
+                if (!collect_refs(m, source, c)) return false;
+            }
+            return true;
+    }
+}
+
+static bool is_pure_expression(const ShakeModule *m, const char *source, uint32_t node);
+
+/* 子节点是否全部没有副作用 */
+static bool children_pure(const ShakeModule *m, const char *source, uint32_t node) {
+    for (uint32_t c = node_at(m, node)->first_child; c != AST_NONE; c = node_at(m, c)->next_sibling) {
+        if (!is_pure_expression(m, source, c)) return false;
+    }
+    return true;
+}
+
+/* 类定义求值时是否没有副作用：父类、计算属性名和静态字段初始值都要无副作用，且没有静态块 */
+static bool is_pure_class(const ShakeModule *m, const char *source, uint32_t node) {
+    uint32_t super_class = child_at(m, node, 1);
+    if (!is_pure_expression(m, source, super_class)) return false;
+
+    uint32_t body = node_at(m, super_class)->next_sibling;
+    for (uint32_t c = node_at(m, body)->first_child; c != AST_NONE; c = node_at(m, c)->next_sibling) {
+        const AstNode *member = node_at(m, c);
+        if (member->kind == AST_STATIC_BLOCK) return false;
+        if ((member->flags & AST_FLAG_COMPUTED) && !is_pure_expression(m, source, member->first_child)) {
+            return false;
+        }
+        if (member->kind == AST_PROPERTY_DEFINITION && (member->flags & AST_FLAG_STATIC) &&
+            !is_pure_expression(m, source, node_at(m, member->first_child)->next_sibling)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* 表达式求值是否没有可观察的副作用（调用、成员访问、赋值和delete都视为有副作用） */
+static bool is_pure_expression(const ShakeModule *m, const char *source, uint32_t node) {
+    if (node == AST_NONE) return true;
+
+    const AstNode *n = node_at(m, node);
+    switch (n->kind) {
+        case AST_NULL:
+        case AST_IDENTIFIER:
+        case AST_LITERAL:
+        case AST_THIS_EXPRESSION:
+        case AST_TEMPLATE_ELEMENT:
+        case AST_FUNCTION_EXPRESSION:
+        case AST_ARROW_FUNCTION_EXPRESSION:
+        case AST_FUNCTION_DECLARATION:
+            return true;
+
+        case AST_CLASS_DECLARATION:
+            return is_pure_class(m, source, node);
+
+        case AST_UNARY_EXPRESSION:
+            if (n->op == TOKEN_DELETE) return false;
+            return children_pure(m, source, node);
+
+        case AST_TEMPLATE_LITERAL:
+        case AST_ARRAY_EXPRESSION:
+        case AST_OBJECT_EXPRESSION:
+        case AST_PROPERTY:
+        case AST_BINARY_EXPRESSION:
+        case AST_LOGICAL_EXPRESSION:
+        case AST_CONDITIONAL_EXPRESSION:
+        case AST_SEQUENCE_EXPRESSION:
+            return children_pure(m, source, node);
+
+        default:
+            return false;
+    }
+}
+
+/* 顶层语句执行时是否没有副作用 */
+static bool is_pure_statement(const ShakeModule *m, const char *source, uint32_t node) {
+    const AstNode *n = node_at(m, node);
+    switch (n->kind) {
+        case AST_EMPTY_STATEMENT:
+        case AST_FUNCTION_DECLARATION:
+        case AST_IMPORT_DECLARATION:
+        case AST_EXPORT_ALL_DECLARATION:
+            return true;
+
+        case AST_CLASS_DECLARATION:
+            return is_pure_class(m, source, node);
+
+        case AST_VARIABLE_DECLARATION:
+            /* 解构可能调用getter或迭代器 */
+            for (uint32_t c = n->first_child; c != AST_NONE; c = node_at(m, c)->next_sibling) {
+                const AstNode *declarator = node_at(m, c);
+                if (node_at(m, declarator->first_child)->kind != AST_IDENTIFIER ||
+                    !is_pure_expression(m, source, node_at(m, declarator->first_child)->next_sibling)) {
+                    return false;
+                }
+            }
+            return true;
+
+        case AST_EXPRESSION_STATEMENT:
+            /* 字符串表达式语句可能是指令（"use strict"） */
+            if (node_at(m, n->first_child)->kind == AST_LITERAL &&
+                (source[node_at(m, n->first_child)->start] == '"' ||
+                 source[node_at(m, n->first_child)->start] == '\'')) {
+                return false;
+            }
+            return is_pure_expression(m, source, n->first_child);
+
+        case AST_EXPORT_NAMED_DECLARATION:
+            return is_null(m, n->first_child) || is_pure_statement(m, source, n->first_child);
+
+        case AST_EXPORT_DEFAULT_DECLARATION:
+            return is_pure_expression(m, source, n->first_child);
+
+        default:
+            return false;
+    }
+}
+
+/* 语句中会被执行的部分（import/export列表语句没有） */
+static uint32_t statement_body(const ShakeModule *m, uint32_t node) {
+    const AstNode *n = node_at(m, node);
+    switch (n->kind) {
+        case AST_IMPORT_DECLARATION:
+        case AST_EXPORT_ALL_DECLARATION:
+            return AST_NONE;
+        case AST_EXPORT_NAMED_DECLARATION:
+            return is_null(m, n->first_child) ? AST_NONE : n->first_child;
+        case AST_EXPORT_DEFAULT_DECLARATION:
+            return n->first_child;
+        default:
+            return node;
+    }
+}
+
+/* 解析一个模块 */
+static bool parse_module(ShakeModule *m, const GraphModule *gm) {
+    if (!ast_init(&m->ast, gm->length)) {
+        set_error(&m->error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+        return false;
+    }
+
+    Lexer *lexer = lexer_create(gm->source, gm->length, &m->error);
+    Parser *parser = lexer ? parser_create(lexer, &m->error) : NULL;
+    if (!parser) {
+        lexer_destroy(lexer);
+        set_error(&m->error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+        return false;
+    }
+    parser->ast = &m->ast;
+    parser->module = true;
+
+    bool success = parser_parse(parser) && m->error.code == ERROR_NONE;
+    parser_destroy(parser);
+    lexer_destroy(lexer);
+
+    if (success && m->ast.failed) {
+        set_error(&m->error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+        success = false;
+    }
+    return success;
+}
+
+/* 分析一个模块（线程池任务） */
+static void analyze_module(void *arg) {
+    AnalyzeTask *task = (AnalyzeTask*)arg;
+    ShakeModule *m = task->module;
+    const GraphModule *gm = &task->graph->modules[task->index];
+    const char *source = gm->source;
+
+    size_t path_length = strlen(gm->path);
+    if (path_length > 5 && strcmp(gm->path + path_length - 5, ".json") == 0) {
+        m->opaque = true;
+        return;
+    }
+    if (!parse_module(m, gm)) {
+        return;
+    }
+
+    /* 顶层语句 */
+    uint32_t root = m->ast.root;
+    for (uint32_t c = node_at(m, root)->first_child; c != AST_NONE; c = node_at(m, c)->next_sibling) {
+        m->statement_count++;
+    }
+    m->statements = (ShakeStatement*)calloc(m->statement_count ? m->statement_count : 1,
+                                            sizeof(ShakeStatement));
+    if (!m->statements) {
+        task->failed = true;
+        return;
+    }
+
+    /* 第一遍：声明、import和export（之后才能判断标识符是否引用顶层绑定） */
+    uint32_t index = 0;
+    for (uint32_t c = node_at(m, root)->first_child; c != AST_NONE; c = node_at(m, c)->next_sibling) {
+        ShakeStatement *st = &m->statements[index];
+        const AstNode *n = node_at(m, c);
+        st->node = c;
+        st->target = MODULE_NONE;
+        st->action = SHAKE_KEEP;
+
+        bool ok = true;
+        switch (n->kind) {
+            case AST_IMPORT_DECLARATION:
+                st->target = source_target(gm, node_at(m, n->first_child));
+                ok = declare_import(m, source, c, st->target);
+                break;
+            case AST_EXPORT_NAMED_DECLARATION: {
+                uint32_t from = child_at(m, c, 1);
+                if (!is_null(m, from)) st->target = source_target(gm, node_at(m, from));
+                ok = declare_export(m, source, index);
+                break;
+            }
+            case AST_EXPORT_ALL_DECLARATION:
+                st->target = source_target(gm, node_at(m, child_at(m, c, 1)));
+                ok = declare_export(m, source, index);
+                break;
+            case AST_EXPORT_DEFAULT_DECLARATION:
+                ok = declare_export(m, source, index);
+                break;
+            default:
+                ok = declare_declaration(m, source, c, index, false);
+                break;
+        }
+        if (!ok) {
+            task->failed = true;
+            return;
+        }
+        index++;
+    }
+
+    /* 本地导出指向的绑定 */
+    for (size_t i = 0; i < m->export_count; i++) {
+        ShakeExport *e = &m->exports[i];
+        if (e->kind == EXPORT_LOCAL && e->binding == NAME_NONE) {
+            e->binding = name_table_get(&m->binding_names, e->imported);
+        }
+    }
+
+    /* 第二遍：引用和副作用 */
+    for (size_t s = 0; s < m->statement_count; s++) {
+        ShakeStatement *st = &m->statements[s];
+        uint32_t body = statement_body(m, st->node);
+        st->ref_start = (uint32_t)m->ref_count;
+        if (body != AST_NONE && !collect_refs(m, source, body)) {
+            task->failed = true;
+            return;
+        }
+        st->ref_end = (uint32_t)m->ref_count;
+        st->pure = is_pure_statement(m, source, st->node);
+    }
+}
+
+/* ---------- 不动点阶段 ---------- */
+
+typedef enum {
+    WORK_STATEMENT,
+    WORK_BINDING,
+    WORK_EXPORT,
+    WORK_ALL
+} WorkKind;
+
+/* 工作表中的一项 */
+typedef struct {
+    WorkKind kind;
+    uint32_t module;
+    uint32_t index;         /* 语句或绑定下标 */
+    ShakeName name;         /* WORK_EXPORT：导出名 */
+} WorkItem;
+
+typedef struct {
+    TreeShake *shake;
+    WorkItem *items;
+    size_t count;
+    size_t capacity;
+    bool failed;
+} Worklist;
+
+static void push_work(Worklist *w, WorkKind kind, uint32_t module, uint32_t index, ShakeName name) {
+    if (!reserve((void**)&w->items, &w->capacity, w->count, sizeof(WorkItem))) {
+        w->failed = true;
+        return;
+    }
+    WorkItem *item = &w->items[w->count++];
+    item->kind = kind;
+    item->module = module;
+    item->index = index;
+    item->name = name;
+}
+
+static void mark_statement(Worklist *w, uint32_t module, uint32_t statement) {
+    ShakeStatement *st = &w->shake->modules[module].statements[statement];
+    if (!st->live) {
+        st->live = true;
+        push_work(w, WORK_STATEMENT, module, statement, default_name);
+    }
+}
+
+static void mark_binding(Worklist *w, uint32_t module, uint32_t binding) {
+    ShakeBinding *b = &w->shake->modules[module].bindings[binding];
+    if (!b->live) {
+        b->live = true;
+        push_work(w, WORK_BINDING, module, binding, default_name);
+    }
+}
+
+static void mark_all(Worklist *w, uint32_t module) {
+    ShakeModule *m = &w->shake->modules[module];
+    if (!m->all) {
+        m->all = true;
+        push_work(w, WORK_ALL, module, 0, default_name);
+    }
+}
+
+static void mark_export(Worklist *w, uint32_t module, ShakeName name) {
+    ShakeModule *m = &w->shake->modules[module];
+    if (m->all) return;
+    if (m->opaque) {
+        mark_all(w, module);
+        return;
+    }
+    if (name_table_get(&m->requested, name) != NAME_NONE) return;
+    if (!name_table_put(&m->requested, name, 0)) {
+        w->failed = true;
+        return;
+    }
+    push_work(w, WORK_EXPORT, module, 0, name);
+}
+
+/* 导出被使用：本地导出使绑定存活，转发导出请求目标模块 */
+static void use_export(Worklist *w, uint32_t module, const ShakeExport *e) {
+    switch (e->kind) {
+        case EXPORT_LOCAL:
+            if (e->binding != NAME_NONE) mark_binding(w, module, e->binding);
+            break;
+        case EXPORT_REEXPORT:
+            if (e->target != MODULE_NONE) mark_export(w, e->target, e->imported);
+            break;
+        case EXPORT_NAMESPACE:
+            if (e->target != MODULE_NONE) mark_all(w, e->target);
+            break;
+    }
+}
+
+static void process_work(Worklist *w, WorkItem item) {
+    ShakeModule *m = &w->shake->modules[item.module];
+
+    switch (item.kind) {
+        case WORK_STATEMENT: {
+            const ShakeStatement *st = &m->statements[item.index];
+            for (uint32_t r = st->ref_start; r < st->ref_end; r++) {
+                mark_binding(w, item.module, m->refs[r].binding);
+            }
+            break;
+        }
+
+        case WORK_BINDING: {
+            const ShakeBinding *b = &m->bindings[item.index];
+            for (uint32_t d = b->first_decl; d != NAME_NONE; d = m->decls[d].next) {
+                mark_statement(w, item.module, m->decls[d].statement);
+            }
+            if (b->target != MODULE_NONE) {
+                if (b->kind == BINDING_NAMESPACE) {
+                    mark_all(w, b->target);
+                } else if (b->kind == BINDING_IMPORT) {
+                    mark_export(w, b->target, b->imported);
+                }
+            }
+            break;
+        }
+
+        case WORK_EXPORT: {
+            uint32_t e = name_table_get(&m->export_names, item.name);
+            if (e != NAME_NONE) {
+                use_export(w, item.module, &m->exports[e]);
+            } else if (!name_equal(item.name, default_name)) {
+                /* export * 不转发default */
+                for (size_t s = 0; s < m->star_count; s++) {
+                    m->stars[s].used = true;
+                    if (m->stars[s].target != MODULE_NONE) {
+                        mark_export(w, m->stars[s].target, item.name);
+                    }
+                }
+            }
+            break;
+        }
+
+        case WORK_ALL:
+            for (size_t e = 0; e < m->export_count; e++) {
+                use_export(w, item.module, &m->exports[e]);
+            }
+            for (size_t s = 0; s < m->star_count; s++) {
+                m->stars[s].used = true;
+                if (m->stars[s].target != MODULE_NONE) {
+                    mark_all(w, m->stars[s].target);
+                }
+            }
+            break;
+    }
+}
+
+/* 从种子开始传播存活性直到不动点 */
+static bool propagate(TreeShake *shake) {
+    const ModuleGraph *graph = shake->graph;
+    Worklist w = {shake, NULL, 0, 0, false};
+
+    for (uint32_t m = 0; m < graph->count; m++) {
+        ShakeModule *module = &shake->modules[m];
+        for (uint32_t s = 0; s < module->statement_count; s++) {
+            if (!module->statements[s].pure) mark_statement(&w, m, s);
+        }
+        /* 动态导入和require的模块无法知道用到哪些导出 */
+        const GraphModule *gm = &graph->modules[m];
+        for (size_t i = 0; i < gm->imports.count; i++) {
+            ImportKind kind = gm->imports.items[i].kind;
+            if ((kind == IMPORT_DYNAMIC || kind == IMPORT_REQUIRE) && gm->targets[i] != MODULE_NONE) {
+                mark_all(&w, gm->targets[i]);
+            }
+        }
+    }
+    for (uint32_t m = 0; m < graph->entry_count; m++) {
+        mark_all(&w, m);
+    }
+
+    while (w.count > 0 && !w.failed) {
+        WorkItem item = w.items[--w.count];
+        process_work(&w, item);
+    }
+
+    free(w.items);
+    return !w.failed;
+}
+
+/* 模块的副作用：自身有存活的有副作用语句，或静态导入的模块有副作用（环中反复直到不变） */
+static void compute_side_effects(TreeShake *shake) {
+    const ModuleGraph *graph = shake->graph;
+    for (size_t m = 0; m < graph->count; m++) {
+        ShakeModule *module = &shake->modules[m];
+        for (size_t s = 0; s < module->statement_count && !module->side_effects; s++) {
+            module->side_effects = !module->statements[s].pure;
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < graph->count; i++) {
+            uint32_t m = graph->order[i];
+            ShakeModule *module = &shake->modules[m];
+            if (module->side_effects) continue;
+
+            const GraphModule *gm = &graph->modules[m];
+            for (size_t j = 0; j < gm->imports.count; j++) {
+                ImportKind kind = gm->imports.items[j].kind;
+                uint32_t target = gm->targets[j];
+                if ((kind == IMPORT_STATIC || kind == IMPORT_REEXPORT) && target != MODULE_NONE &&
+                    shake->modules[target].side_effects) {
+                    module->side_effects = true;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/* ---------- 输出计划 ---------- */
+
+static bool export_used(const ShakeModule *m, ShakeName name) {
+    return m->all || name_table_get(&m->requested, name) != NAME_NONE;
+}
+
+/* 说明符是否存活：import看本地绑定，export看导出名 */
+static bool specifier_live(const ShakeModule *m, const char *source, uint32_t spec) {
+    const AstNode *s = node_at(m, spec);
+    if (s->kind == AST_EXPORT_SPECIFIER) {
+        return export_used(m, node_name(m, source, child_at(m, spec, 1)));
+    }
+    uint32_t local = s->kind == AST_IMPORT_SPECIFIER ? child_at(m, spec, 1) : s->first_child;
+    uint32_t binding = name_table_get(&m->binding_names, node_name(m, source, local));
+    return binding != NAME_NONE && m->bindings[binding].live;
+}
+
+/* 说明符全部未使用时：目标模块有副作用（或未解析）就保留 import 'x'; */
+static ShakeAction side_effect_action(const TreeShake *shake, const ShakeStatement *st) {
+    if (st->target == MODULE_NONE || shake->modules[st->target].side_effects) {
+        return SHAKE_SIDE_EFFECT;
+    }
+    return SHAKE_DROP;
+}
+
+/* 决定每条语句的输出方式 */
+static void plan_module(TreeShake *shake, uint32_t module) {
+    ShakeModule *m = &shake->modules[module];
+    const char *source = shake->graph->modules[module].source;
+
+    for (size_t s = 0; s < m->statement_count; s++) {
+        ShakeStatement *st = &m->statements[s];
+        const AstNode *n = node_at(m, st->node);
+
+        switch (n->kind) {
+            case AST_IMPORT_DECLARATION:
+            case AST_EXPORT_NAMED_DECLARATION: {
+                uint32_t first = n->kind == AST_IMPORT_DECLARATION ? node_at(m, n->first_child)->next_sibling
+                                                                   : child_at(m, st->node, 2);
+                if (n->kind == AST_EXPORT_NAMED_DECLARATION && !is_null(m, n->first_child)) {
+                    /* export var/function/class */
+                    bool exported = false;
+                    for (size_t e = 0; e < m->export_count && !exported; e++) {
+                        exported = m->exports[e].statement == s && export_used(m, m->exports[e].name);
+                    }
+                    st->action = !st->live ? SHAKE_DROP : exported ? SHAKE_KEEP : SHAKE_UNEXPORT;
+                    break;
+                }
+
+                size_t total = 0;
+                size_t live = 0;
+                for (uint32_t spec = first; spec != AST_NONE; spec = node_at(m, spec)->next_sibling) {
+                    total++;
+                    live += specifier_live(m, source, spec);
+                }
+                bool has_source = n->kind == AST_IMPORT_DECLARATION || !is_null(m, child_at(m, st->node, 1));
+                if (live == total && total > 0) {
+                    st->action = SHAKE_KEEP;
+                } else if (live > 0) {
+                    st->action = SHAKE_SPECIFIERS;
+                } else if (!has_source) {
+                    st->action = SHAKE_DROP;
+                } else {
+                    st->action = side_effect_action(shake, st);
+                    if (st->action == SHAKE_SIDE_EFFECT && total == 0 && n->kind == AST_IMPORT_DECLARATION) {
+                        st->action = SHAKE_KEEP;
+                    }
+                }
+                break;
+            }
+
+            case AST_EXPORT_ALL_DECLARATION: {
+                bool used = false;
+                if (is_null(m, n->first_child)) {
+                    for (size_t i = 0; i < m->star_count; i++) {
+                        used |= m->stars[i].statement == s && m->stars[i].used;
+                    }
+                } else {
+                    used = export_used(m, node_name(m, source, n->first_child));
+                }
+                st->action = used ? SHAKE_KEEP : side_effect_action(shake, st);
+                break;
+            }
+
+            case AST_EXPORT_DEFAULT_DECLARATION: {
+                const AstNode *d = node_at(m, n->first_child);
+                if (!st->live) {
+                    st->action = SHAKE_DROP;
+                } else if (export_used(m, default_name)) {
+                    st->action = SHAKE_KEEP;
+                } else if ((d->kind == AST_FUNCTION_DECLARATION || d->kind == AST_CLASS_DECLARATION) &&
+                           !is_null(m, d->first_child)) {
+                    st->action = SHAKE_UNEXPORT;
+                } else {
+                    st->action = SHAKE_EXPRESSION;
+                }
+                break;
+            }
+
+            default:
+                st->action = st->live ? SHAKE_KEEP : SHAKE_DROP;
+                break;
+        }
+    }
+}
+
+/* 模块仍被需要：入口，或被保留的import/export语句、动态导入和require引用 */
+static bool mark_live_modules(TreeShake *shake) {
+    const ModuleGraph *graph = shake->graph;
+    uint32_t *queue = (uint32_t*)malloc((graph->count ? graph->count : 1) * sizeof(uint32_t));
+    if (!queue) return false;
+
+    size_t count = 0;
+    for (uint32_t m = 0; m < graph->entry_count; m++) {
+        shake->modules[m].live = true;
+        queue[count++] = m;
+    }
+    for (size_t head = 0; head < count; head++) {
+        uint32_t m = queue[head];
+        ShakeModule *module = &shake->modules[m];
+        const GraphModule *gm = &graph->modules[m];
+
+        for (size_t s = 0; s < module->statement_count; s++) {
+            const ShakeStatement *st = &module->statements[s];
+            if (st->action != SHAKE_DROP) {
+                module->kept++;
+                uint32_t t = st->target;
+                if (t != MODULE_NONE && !shake->modules[t].live) {
+                    shake->modules[t].live = true;
+                    queue[count++] = t;
+                }
+            }
+        }
+        for (size_t i = 0; i < gm->imports.count; i++) {
+            ImportKind kind = gm->imports.items[i].kind;
+            uint32_t t = gm->targets[i];
+            if ((kind == IMPORT_DYNAMIC || kind == IMPORT_REQUIRE) && t != MODULE_NONE &&
+                !shake->modules[t].live) {
+                shake->modules[t].live = true;
+                queue[count++] = t;
+            }
+        }
+    }
+
+    free(queue);
+    return true;
+}
+
+/* 摇树：并行分析全部模块，传播存活性并决定每条语句的输出方式 */
+bool tree_shake(TreeShake *shake, const ModuleGraph *graph, int thread_count, ErrorInfo *error) {
+    memset(shake, 0, sizeof(*shake));
+    shake->graph = graph;
+    shake->modules = (ShakeModule*)calloc(graph->count ? graph->count : 1, sizeof(ShakeModule));
+    AnalyzeTask *tasks = (AnalyzeTask*)calloc(graph->count ? graph->count : 1, sizeof(AnalyzeTask));
+    ThreadPool *pool = shake->modules && tasks ? threadpool_create(thread_count) : NULL;
+    if (!pool) {
+        set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Cannot create thread pool");
+        free(tasks);
+        tree_shake_free(shake);
+        return false;
+    }
+
+    bool success = true;
+    for (uint32_t m = 0; m < graph->count; m++) {
+        tasks[m].graph = graph;
+        tasks[m].module = &shake->modules[m];
+        tasks[m].index = m;
+        if (!threadpool_submit(pool, analyze_module, &tasks[m])) {
+            analyze_module(&tasks[m]);
+        }
+    }
+    threadpool_wait(pool);
+    threadpool_destroy(pool);
+
+    /* 按模块编号报告第一个错误（与线程调度无关） */
+    for (uint32_t m = 0; m < graph->count && success; m++) {
+        if (tasks[m].failed) {
+            set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+            success = false;
+        } else if (shake->modules[m].error.code != ERROR_NONE) {
+            char message[sizeof(error->message)];
+            const ErrorInfo *cause = &shake->modules[m].error;
+            snprintf(message, sizeof(message), "%.*s: %.*s",
+                     (int)strlen(graph->modules[m].path), graph->modules[m].path,
+                     (int)strlen(cause->message), cause->message);
+            set_error(error, cause->code, cause->position, message);
+            success = false;
+        }
+    }
+    free(tasks);
+
+    if (success) {
+        success = propagate(shake);
+        if (success) {
+            compute_side_effects(shake);
+            for (uint32_t m = 0; m < graph->count; m++) {
+                plan_module(shake, m);
+            }
+            success = mark_live_modules(shake);
+        }
+        if (!success) {
+            set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+        }
+    }
+
+    if (!success) tree_shake_free(shake);
+    return success;
+}
+
+/* 释放摇树结果（不释放依赖图） */
+void tree_shake_free(TreeShake *shake) {
+    if (shake->modules) {
+        for (size_t m = 0; m < shake->graph->count; m++) {
+            ShakeModule *module = &shake->modules[m];
+            if (module->ast.nodes) ast_free(&module->ast);
+            free(module->statements);
+            free(module->bindings);
+            name_table_free(&module->binding_names);
+            free(module->decls);
+            free(module->exports);
+            name_table_free(&module->export_names);
+            free(module->stars);
+            free(module->refs);
+            name_table_free(&module->requested);
+        }
+        free(shake->modules);
+    }
+    memset(shake, 0, sizeof(*shake));
+}
+
+/* ---------- 输出 ---------- */
+
+static inline void write_node(Writer *writer, const char *source, const AstNode *n) {
+    writer_write(writer, source + n->start, n->end - n->start);
+}
+
+/* 只写出存活的说明符 */
+static void write_specifiers(Writer *writer, const ShakeModule *m, const char *source,
+                             const ShakeStatement *st) {
+    const AstNode *n = node_at(m, st->node);
+    bool import = n->kind == AST_IMPORT_DECLARATION;
+    uint32_t first = import ? node_at(m, n->first_child)->next_sibling : child_at(m, st->node, 2);
+    uint32_t from = import ? n->first_child : child_at(m, st->node, 1);
+
+    writer_cstr(writer, import ? "import " : "export ");
+    bool braces = false;
+    bool any = false;
+    for (uint32_t spec = first; spec != AST_NONE; spec = node_at(m, spec)->next_sibling) {
+        if (!specifier_live(m, source, spec)) continue;
+
+        const AstNode *s = node_at(m, spec);
+        bool named = s->kind == AST_IMPORT_SPECIFIER || s->kind == AST_EXPORT_SPECIFIER;
+        if (any) writer_cstr(writer, ", ");
+        if (named && !braces) {
+            writer_cstr(writer, "{ ");
+            braces = true;
+        }
+        write_node(writer, source, s);
+        any = true;
+    }
+    if (braces) writer_cstr(writer, " }");
+    if (!is_null(m, from)) {
+        writer_cstr(writer, " from ");
+        write_node(writer, source, node_at(m, from));
+    }
+    writer_byte(writer, ';');
+}
+
+/* 写出精简后的模块源码：死语句连同它前面的空白和注释一起删除 */
+bool tree_shake_emit(const TreeShake *shake, uint32_t module, Writer *writer) {
+    const ShakeModule *m = &shake->modules[module];
+    const GraphModule *gm = &shake->graph->modules[module];
+    const char *source = gm->source;
+
+    if (m->opaque) {
+        writer_write(writer, source, gm->length);
+        return !writer->failed;
+    }
+
+    size_t cursor = 0;
+    char last = ';';            /* 上一条写出的语句的最后一个字符 */
+    bool dropped = false;
+    for (size_t s = 0; s < m->statement_count; s++) {
+        const ShakeStatement *st = &m->statements[s];
+        const AstNode *n = node_at(m, st->node);
+        if (st->action == SHAKE_DROP) {
+            cursor = n->end;
+            dropped = true;
+            continue;
+        }
+
+        /* 删除语句后，上一条依赖ASI结束的语句可能与下一条连在一起 */
+        if (dropped && last != ';' && last != '}') {
+            writer_byte(writer, ';');
+        }
+        if (dropped) {
+            while (cursor < n->start && (source[cursor] == ' ' || source[cursor] == '\t')) cursor++;
+        }
+        dropped = false;
+        writer_write(writer, source + cursor, n->start - cursor);
+
+        switch (st->action) {
+            case SHAKE_UNEXPORT: {
+                const AstNode *d = node_at(m, n->first_child);
+                writer_write(writer, source + d->start, n->end - d->start);
+                break;
+            }
+            case SHAKE_EXPRESSION:
+                writer_byte(writer, '(');
+                write_node(writer, source, node_at(m, n->first_child));
+                writer_cstr(writer, ");");
+                break;
+            case SHAKE_SPECIFIERS:
+                write_specifiers(writer, m, source, st);
+                break;
+            case SHAKE_SIDE_EFFECT: {
+                uint32_t from = n->kind == AST_IMPORT_DECLARATION ? n->first_child
+                                                                  : child_at(m, st->node, 1);
+                writer_cstr(writer, "import ");
+                write_node(writer, source, node_at(m, from));
+                writer_byte(writer, ';');
+                break;
+            }
+            default:
+                write_node(writer, source, n);
+                break;
+        }
+        last = st->action == SHAKE_KEEP || st->action == SHAKE_UNEXPORT ? source[n->end - 1] : ';';
+        cursor = n->end;
+    }
+    writer_write(writer, source + cursor, gm->length - cursor);
+    return !writer->failed;
+}
+
+/* 输出摇树报告：每个模块一行JSON */
+bool tree_shake_write_report(const TreeShake *shake, Writer *writer) {
+    const ModuleGraph *graph = shake->graph;
+    for (size_t m = 0; m < graph->count; m++) {
+        const ShakeModule *module = &shake->modules[m];
+        writer_cstr(writer, "{\"path\":");
+        writer_json_string(writer, graph->modules[m].path, strlen(graph->modules[m].path));
+        writer_cstr(writer, module->live ? ",\"live\":true" : ",\"live\":false");
+        writer_cstr(writer, ",\"kept\":");
+        writer_uint(writer, module->kept);
+        writer_cstr(writer, ",\"removed\":");
+        writer_uint(writer, module->statement_count - module->kept);
+        writer_cstr(writer, ",\"unused_exports\":[");
+        bool first = true;
+        for (size_t e = 0; e < module->export_count; e++) {
+            const ShakeExport *exp = &module->exports[e];
+            if (export_used(module, exp->name)) continue;
+            if (!first) writer_byte(writer, ',');
+            writer_json_string(writer, exp->name.text, exp->name.length);
+            first = false;
+        }
+        writer_cstr(writer, "]}\n");
+    }
+    return !writer->failed;
+}
+
+/* 输出到目录的任务 */
+typedef struct {
+    const TreeShake *shake;
+    uint32_t module;
+    char *path;
+    bool success;
+} WriteTask;
+
+/* 逐级创建文件所在的目录 */
+static bool make_parent_dirs(char *path) {
+    for (char *p = path + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        bool ok = mkdir(path, 0777) == 0 || errno == EEXIST;
+        *p = '/';
+        if (!ok) return false;
+    }
+    return true;
+}
+
+static void write_module_file(void *arg) {
+    WriteTask *task = (WriteTask*)arg;
+    Writer writer;
+    task->success = make_parent_dirs(task->path) && writer_open(&writer, task->path);
+    if (task->success) {
+        task->success = tree_shake_emit(task->shake, task->module, &writer);
+        task->success = writer_close(&writer) && task->success;
+    }
+}
+
+/* 把存活的模块写入目录，保持它们相对于公共父目录的路径 */
+bool tree_shake_write_dir(const TreeShake *shake, const char *dir, int thread_count,
+                          ErrorInfo *error) {
+    const ModuleGraph *graph = shake->graph;
+
+    /* 所有存活模块路径的公共目录前缀（以 / 结尾） */
+    const char *root = graph->modules[0].path;
+    size_t root_length = strrchr(root, '/') - root + 1;
+    for (size_t m = 1; m < graph->count; m++) {
+        if (!shake->modules[m].live) continue;
+        const char *path = graph->modules[m].path;
+        size_t i = 0;
+        while (i < root_length && path[i] == root[i]) i++;
+        while (i > 0 && root[i - 1] != '/') i--;
+        root_length = i;
+    }
+
+    WriteTask *tasks = (WriteTask*)calloc(graph->count, sizeof(WriteTask));
+    ThreadPool *pool = tasks ? threadpool_create(thread_count) : NULL;
+    if (!pool) {
+        set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Cannot create thread pool");
+        free(tasks);
+        return false;
+    }
+
+    bool success = true;
+    size_t dir_length = strlen(dir);
+    for (uint32_t m = 0; m < graph->count && success; m++) {
+        if (!shake->modules[m].live) continue;
+        const char *relative = graph->modules[m].path + root_length;
+        size_t length = dir_length + 1 + strlen(relative);
+        tasks[m].shake = shake;
+        tasks[m].module = m;
+        tasks[m].path = (char*)malloc(length + 1);
+        if (!tasks[m].path) {
+            set_error(error, ERROR_OUT_OF_MEMORY, (Position){0, 0, 0}, "Out of memory");
+            success = false;
+            break;
+        }
+        snprintf(tasks[m].path, length + 1, "%s/%s", dir, relative);
+        if (!threadpool_submit(pool, write_module_file, &tasks[m])) {
+            write_module_file(&tasks[m]);
+        }
+    }
+    threadpool_wait(pool);
+    threadpool_destroy(pool);
+
+    for (uint32_t m = 0; m < graph->count; m++) {
+        if (success && tasks[m].path && !tasks[m].success) {
+            char message[256];
+            snprintf(message, sizeof(message), "Cannot write '%s'", tasks[m].path);
+            set_error(error, ERROR_FILE_READ, (Position){0, 0, 0}, message);
+            success = false;
+        }
+        free(tasks[m].path);
+    }
+    free(tasks);
+    return success;
+}
@@ -0,0 +1,151 @@
+#ifndef TREESHAKE_H
+#define TREESHAKE_H
+
+#include "module_graph.h"
+#include "ast.h"
+#include "writer.h"
+#include "common.h"
+
+#define NAME_NONE UINT32_MAX       /* 名字表中没有、绑定或导出不存在 */
+
+/* 源码中的一个名字（指向模块源码，不拷贝） */
+typedef struct {
+    const char *text;
+    uint32_t length;
+} ShakeName;
+
+/* 名字到下标的哈希表（开放寻址） */
+typedef struct {
+    ShakeName *names;
+    uint32_t *values;
+    size_t count;
+    size_t capacity;
+} NameTable;
+
+/* 顶层绑定的来源 */
+typedef enum {
+    BINDING_LOCAL,          /* var/let/const、函数和类声明 */
+    BINDING_IMPORT,         /* import {a as b} / import d */
+    BINDING_NAMESPACE,      /* import * as ns */
+    BINDING_DEFAULT         /* 匿名的export default，不能按名字引用 */
+} BindingKind;
+
+/* 一个顶层绑定 */
+typedef struct {
+    ShakeName name;
+    BindingKind kind;
+    uint32_t node;          /* 声明处的标识符节点（匿名默认导出为ExportDefault节点） */
+    uint32_t target;        /* import：目标模块，MODULE_NONE为未解析 */
+    ShakeName imported;     /* import：目标模块中的导出名 */
+    uint32_t first_decl;    /* 声明它的语句链表（ShakeDecl下标），NAME_NONE结束 */
+    bool live;
+} ShakeBinding;
+
+/* 声明绑定的语句（同一绑定可以被多条语句声明，如重复的var） */
+typedef struct {
+    uint32_t statement;
+    uint32_t next;
+} ShakeDecl;
+
+/* 导出的来源 */
+typedef enum {
+    EXPORT_LOCAL,           /* 导出本模块的绑定 */
+    EXPORT_REEXPORT,        /* export {a as b} from 'x' */
+    EXPORT_NAMESPACE        /* export * as ns from 'x' */
+} ExportKind;
+
+/* 一个导出名 */
+typedef struct {
+    ShakeName name;
+    ExportKind kind;
+    uint32_t binding;       /* EXPORT_LOCAL */
+    uint32_t target;        /* 转发导出的目标模块 */
+    ShakeName imported;     /* EXPORT_REEXPORT：目标模块中的导出名 */
+    uint32_t statement;
+} ShakeExport;
+
+/* export * from 'x' */
+typedef struct {
+    uint32_t target;
+    uint32_t statement;
+    bool used;              /* 有导出名经它转发 */
+} ShakeStar;
+
+/* 标识符出现处：用于传播存活性，也用于改名 */
+typedef struct {
+    uint32_t node;
+    uint32_t binding;
+} ShakeRef;
+
+/* 顶层语句的输出方式 */
+typedef enum {
+    SHAKE_KEEP,             /* 原样保留 */
+    SHAKE_DROP,             /* 删除 */
+    SHAKE_UNEXPORT,         /* 去掉export，只保留声明 */
+    SHAKE_EXPRESSION,       /* 未使用的export default表达式，保留求值 (expr); */
+    SHAKE_SPECIFIERS,       /* 只保留存活的import/export说明符 */
+    SHAKE_SIDE_EFFECT       /* 说明符全部未使用，只保留 import 'x'; */
+} ShakeAction;
+
+/* 一条顶层语句 */
+typedef struct {
+    uint32_t node;
+    uint32_t target;        /* import/export ... from：目标模块 */
+    uint32_t ref_start;     /* 引用为 refs[ref_start] .. refs[ref_end - 1] */
+    uint32_t ref_end;
+    bool pure;              /* 执行没有可观察的副作用 */
+    bool live;
+    ShakeAction action;
+} ShakeStatement;
+
+/* 一个模块的分析结果 */
+typedef struct {
+    Ast ast;
+    bool opaque;            /* 无法分析（JSON）：原样输出，被导入时视为全部使用 */
+    ShakeStatement *statements;
+    size_t statement_count;
+    ShakeBinding *bindings;
+    size_t binding_count;
+    size_t binding_capacity;
+    NameTable binding_names;
+    ShakeDecl *decls;
+    size_t decl_count;
+    size_t decl_capacity;
+    ShakeExport *exports;
+    size_t export_count;
+    size_t export_capacity;
+    NameTable export_names;
+    ShakeStar *stars;
+    size_t star_count;
+    size_t star_capacity;
+    ShakeRef *refs;
+    size_t ref_count;
+    size_t ref_capacity;
+
+    /* 不动点阶段 */
+    bool all;               /* 全部导出都被使用（入口、动态导入或命名空间导入） */
+    NameTable requested;    /* 被使用的导出名 */
+    bool side_effects;      /* 自身或其依赖有副作用 */
+    bool live;              /* 输出中仍需要这个模块 */
+    size_t kept;
+    ErrorInfo error;
+} ShakeModule;
+
+/* 整个依赖图的摇树结果 */
+typedef struct {
+    const ModuleGraph *graph;
+    ShakeModule *modules;   /* 与graph->modules一一对应 */
+} TreeShake;
+
+/* 摇树函数声明 */
+bool tree_shake(TreeShake *shake, const ModuleGraph *graph, int thread_count, ErrorInfo *error);
+void tree_shake_free(TreeShake *shake);
+bool tree_shake_emit(const TreeShake *shake, uint32_t module, Writer *writer);
+bool tree_shake_write_report(const TreeShake *shake, Writer *writer);
+bool tree_shake_write_dir(const TreeShake *shake, const char *dir, int thread_count,
+                          ErrorInfo *error);
+bool name_table_put(NameTable *table, ShakeName name, uint32_t value);
+uint32_t name_table_get(const NameTable *table, ShakeName name);
+void name_table_free(NameTable *table);
+
+#endif /* TREESHAKE_H */
@@ -0,0 +1,166 @@
+#include "writer.h"
+
+/* 两位数字查表，整数格式化每次输出两位 */
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/* JSON转义表：0表示原样输出，'u'表示\u00XX，其余为\后的转义字符 */
+static const char json_escape[256] = {
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+    0, 0, '"', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '\\', 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 'u',
+};
+
+/* 初始化输出（file为NULL时丢弃输出）；失败时writer不可使用 */
+bool writer_init(Writer *writer, FILE *file) {
+    writer->file = file;
+    writer->owns_file = false;
+    writer->length = 0;
+    writer->total = 0;
+    writer->failed = false;
+    writer->buffer = (char*)malloc(WRITER_BUFFER_SIZE);
+    return writer->buffer != NULL;
+}
+
+/* 打开输出文件（path为NULL或"-"时写到标准输出） */
+bool writer_open(Writer *writer, const char *path) {
+    if (!path || strcmp(path, "-") == 0) {
+        return writer_init(writer, stdout);
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot open output file '%s'\n", path);
+        return false;
+    }
+    if (!writer_init(writer, file)) {
+        fclose(file);
+        return false;
+    }
+    writer->owns_file = true;
+    return true;
+}
+
+/* 把缓冲写入文件 */
+void writer_flush(Writer *writer) {
+    if (writer->length == 0) return;
+
+    if (writer->file && !writer->failed &&
+        fwrite(writer->buffer, 1, writer->length, writer->file) != writer->length) {
+        writer->failed = true;
+    }
+    writer->total += writer->length;
+    writer->length = 0;
+}
+
+/* 写入超出缓冲剩余空间的数据 */
+void writer_write_slow(Writer *writer, const char *data, size_t length) {
+    while (length > 0) {
+        if (writer->length == WRITER_BUFFER_SIZE) {
+            writer_flush(writer);
+        }
+        size_t chunk = WRITER_BUFFER_SIZE - writer->length;
+        if (chunk > length) chunk = length;
+        memcpy(writer->buffer + writer->length, data, chunk);
+        writer->length += chunk;
+        data += chunk;
+        length -= chunk;
+    }
+}
+
+/* 关闭输出，返回是否全部写入成功 */
+bool writer_close(Writer *writer) {
+    writer_flush(writer);
+    if (writer->file && fflush(writer->file) != 0) {
+        writer->failed = true;
+    }
+    if (writer->owns_file && fclose(writer->file) != 0) {
+        writer->failed = true;
+    }
+    free(writer->buffer);
+    writer->buffer = NULL;
+    writer->file = NULL;
+    return !writer->failed;
+}
+
+/* 输出十进制无符号整数 */
+void writer_uint(Writer *writer, uint64_t value) {
+    char digits[20];
+    char *p = digits + sizeof(digits);
+
+    while (value >= 100) {
+        unsigned pair = (unsigned)(value % 100) * 2;
+        value /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    if (value >= 10) {
+        unsigned pair = (unsigned)value * 2;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    } else {
+        *--p = (char)('0' + value);
+    }
+
+    writer_write(writer, p, (size_t)(digits + sizeof(digits) - p));
+}
+
+/* 输出LEB128变长无符号整数（每字节7位，低位在前，最高位表示后面还有字节） */
+void writer_varint(Writer *writer, uint64_t value) {
+    char bytes[10];
+    size_t count = 0;
+
+    while (value >= 0x80) {
+        bytes[count++] = (char)(value | 0x80);
+        value >>= 7;
+    }
+    bytes[count++] = (char)value;
+
+    writer_write(writer, bytes, count);
+}
+
+/* 输出JSON字符串内容（不含引号）：不需要转义的连续字节整段复制 */
+void writer_json_escaped(Writer *writer, const char *text, size_t length) {
+    static const char hex[] = "0123456789abcdef";
+    size_t run = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        char escape = json_escape[(unsigned char)text[i]];
+        if (!escape) continue;
+
+        writer_write(writer, text + run, i - run);
+        run = i + 1;
+
+        if (escape == 'u') {
+            char seq[6] = {'\\', 'u', '0', '0',
+                           hex[(unsigned char)text[i] >> 4], hex[text[i] & 0xF]};
+            writer_write(writer, seq, sizeof(seq));
+        } else {
+            char seq[2] = {'\\', escape};
+            writer_write(writer, seq, sizeof(seq));
+        }
+    }
+
+    writer_write(writer, text + run, length - run);
+}
+
+/* 输出带引号的JSON字符串 */
+void writer_json_string(Writer *writer, const char *text, size_t length) {
+    writer_byte(writer, '"');
+    writer_json_escaped(writer, text, length);
+    writer_byte(writer, '"');
+}
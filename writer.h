@@ -0,0 +1,52 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include "common.h"
+
+#define WRITER_BUFFER_SIZE (1 << 20)
+
+/* 带大缓冲的输出：所有输出先写入缓冲，满了才整体写入文件 */
+typedef struct {
+    FILE *file;             /* 目标文件，NULL时丢弃输出（用于基准测试） */
+    bool owns_file;         /* 关闭时是否fclose */
+    char *buffer;
+    size_t length;
+    size_t total;           /* 已输出的总字节数 */
+    bool failed;            /* 内存不足或写入失败 */
+} Writer;
+
+/* 输出函数声明 */
+bool writer_init(Writer *writer, FILE *file);
+bool writer_open(Writer *writer, const char *path);
+bool writer_close(Writer *writer);
+void writer_flush(Writer *writer);
+void writer_write_slow(Writer *writer, const char *data, size_t length);
+void writer_uint(Writer *writer, uint64_t value);
+void writer_varint(Writer *writer, uint64_t value);
+void writer_json_escaped(Writer *writer, const char *text, size_t length);
+void writer_json_string(Writer *writer, const char *text, size_t length);
+
+/* 写入一段字节（热路径内联） */
+static inline void writer_write(Writer *writer, const char *data, size_t length) {
+    if (writer->length + length <= WRITER_BUFFER_SIZE) {
+        memcpy(writer->buffer + writer->length, data, length);
+        writer->length += length;
+    } else {
+        writer_write_slow(writer, data, length);
+    }
+}
+
+/* 写入单个字节 */
+static inline void writer_byte(Writer *writer, char ch) {
+    if (writer->length == WRITER_BUFFER_SIZE) {
+        writer_flush(writer);
+    }
+    writer->buffer[writer->length++] = ch;
+}
+
+/* 写入以'\0'结尾的字符串常量 */
+static inline void writer_cstr(Writer *writer, const char *text) {
+    writer_write(writer, text, strlen(text));
+}
+
+#endif /* WRITER_H */